@@ -36,5 +36,143 @@
 #define JMSG_UDP_APP_PLATFORM_REV   0
 #define JMSG_UDP_APP_INI_FILENAME   "/cf/jmsg_udp_ini.json"
 
+/*
+** Maximum number of structural characters recorded for one JSON payload.
+** Payloads exceeding this limit are rejected before topic conversion.
+*/
+#define JMSG_UDP_PLATFORM_SCAN_INDEX_MAX  2048
+
+/*
+** Rx topic pattern matcher capacity. The node count must be a power of 2
+** and bounds the total number of distinct levels across all patterns.
+*/
+#define JMSG_UDP_PLATFORM_MATCH_NODE_MAX      1024
+#define JMSG_UDP_PLATFORM_MATCH_STR_POOL_LEN  16384
+
+/*
+** Route table limits. The route count must be a power of 2 and greater
+** than the number of JMSG_LIB topic plugins. The matcher limits above must
+** accommodate the Rx route names.
+*/
+#define JMSG_UDP_PLATFORM_ROUTE_MAX                1024
+#define JMSG_UDP_PLATFORM_ROUTE_TBL_JSON_MAX_CHAR  131072
+
+/*
+** JSON template limits. Each route table bank holds TMPL_MAX templates
+** and the text limit bounds a template's keys and punctuation. Rx
+** templates build SB messages with payloads of up to TMPL_PAYLOAD_MAX
+** bytes.
+*/
+#define JMSG_UDP_PLATFORM_TMPL_MAX          32
+#define JMSG_UDP_PLATFORM_TMPL_FIELD_MAX    32
+#define JMSG_UDP_PLATFORM_TMPL_TEXT_MAX     1024
+#define JMSG_UDP_PLATFORM_TMPL_PAYLOAD_MAX  1024
+
+/*
+** Tx route filter limits. Each route table bank holds FILTER_MAX filters
+** of up to FILTER_TERM_MAX terms and FILTER_EXPR_MAX-1 expression
+** characters.
+*/
+#define JMSG_UDP_PLATFORM_FILTER_MAX        32
+#define JMSG_UDP_PLATFORM_FILTER_TERM_MAX   4
+#define JMSG_UDP_PLATFORM_FILTER_EXPR_MAX   128
+
+/*
+** Rx payload shape cache limits. SHAPE_MAX topics are cached, each with up
+** to SLOT_MAX numeric values and TEXT_MAX bytes of payload text around them.
+*/
+#define JMSG_UDP_PLATFORM_SHAPE_MAX       16
+#define JMSG_UDP_PLATFORM_SHAPE_SLOT_MAX  64
+#define JMSG_UDP_PLATFORM_SHAPE_TEXT_MAX  1024
+
+/*
+** Sequence number tracking limits. The stream count must be a power of 2 and
+** bounds the Rx peer/topic pairs and the Tx topics. The peer count must
+** match the PeerStats array length in the EDS.
+*/
+#define JMSG_UDP_PLATFORM_SEQ_STREAM_MAX  256
+#define JMSG_UDP_PLATFORM_SEQ_PEER_MAX    8
+
+/*
+** Reliable delivery limits. Each slot holds one unacknowledged Tx message
+** of up to DATAGRAM_LEN bytes. REL_SLOT_CNT in the INI file selects the
+** number of slots up to the maximum.
+*/
+#define JMSG_UDP_PLATFORM_REL_SLOT_MAX   16
+#define JMSG_UDP_PLATFORM_REL_TOPIC_MAX  32
+
+/*
+** Fragmentation limits for the INI FRAG_CNT and FRAG_POOL_CNT values. Each
+** pool slot and the Tx message buffer use FRAG_CNT*DATAGRAM_LEN bytes,
+** which must be less than 64KiB. FRAG_CNT_MAX can't exceed 32.
+*/
+#define JMSG_UDP_PLATFORM_FRAG_CNT_MAX   15
+#define JMSG_UDP_PLATFORM_FRAG_POOL_MAX  4
+
+/*
+** Compression statistics are kept for this many topics. It must match the
+** LzTopicStats array length in the EDS.
+*/
+#define JMSG_UDP_PLATFORM_LZ_TOPIC_MAX  8
+
+/*
+** SB queue statistics are kept for this many Tx message IDs. It must match
+** the SbTopicStats array length in the EDS.
+*/
+#define JMSG_UDP_PLATFORM_SBQ_TOPIC_MAX  16
+
+/*
+** Most topics the last value cache can hold. LVC_TOPIC_CNT slots of
+** LVC_VALUE_LEN bytes are allocated from the memory arena.
+*/
+#define JMSG_UDP_PLATFORM_LVC_TOPIC_MAX  128
+
+/*
+** Rx and Tx message lengths are counted in this many size bins. It must
+** match the SizeBin array length in the EDS.
+*/
+#define JMSG_UDP_PLATFORM_RATE_SIZE_BIN_CNT  8
+
+/*
+** Largest traffic capture file. The file is memory mapped so its length is
+** reserved in the app's address space while capturing.
+*/
+#define JMSG_UDP_PLATFORM_CAP_FILE_MAX  (64*1024*1024)
+
+/*
+** Largest io_uring depth. The Rx and Tx rings each map IO_URING_DEPTH
+** buffers of DATAGRAM_LEN bytes outside the memory arena.
+*/
+#define JMSG_UDP_PLATFORM_IO_URING_DEPTH_MAX  1024
+
+/*
+** Largest local transport shared memory ring
+*/
+#define JMSG_UDP_PLATFORM_LOCAL_SHM_MAX  (16*1024*1024)
+
+/*
+** Self-test limits. A test sends up to SELFTEST_MSG_MAX messages with SB
+** payloads of up to SELFTEST_PAYLOAD_MAX bytes.
+*/
+#define JMSG_UDP_PLATFORM_SELFTEST_MSG_MAX      1024
+#define JMSG_UDP_PLATFORM_SELFTEST_PAYLOAD_MAX  1024
+
+/*
+** Most JSON decode worker tasks. It must match the DecodeWorker array length
+** in the EDS and the app framework's child task limit must allow for the
+** workers plus the Rx and Tx child tasks. Each worker allocates a decoder
+** context and a DECODE_QUEUE_LEN byte queue from the memory arena.
+*/
+#define JMSG_UDP_PLATFORM_DECODE_WORKER_MAX  4
+
+/*
+** Size of the arena the message buffers are allocated from. The buffers
+** sized by the default INI file need about 508KiB. The startup memory
+** event reports the bytes used so the arena can be trimmed to the INI
+** configuration of a memory constrained target. It must be enlarged to
+** run decode workers.
+*/
+#define JMSG_UDP_PLATFORM_MEM_POOL_LEN  (576*1024)
+
 
 #endif /* _jmsg_udp_platform_cfg_ */
@@ -72,6 +72,12 @@
 
 #define CFG_JMSG_UDP_CMD_TOPICID                  JMSG_UDP_CMD_TOPICID
 #define CFG_JMSG_UDP_STATUS_TLM_TOPICID           JMSG_UDP_STATUS_TLM_TOPICID
+#define CFG_JMSG_UDP_EXT_STATUS_TLM_TOPICID       JMSG_UDP_EXT_STATUS_TLM_TOPICID
+#define CFG_JMSG_UDP_PEER_STATS_TLM_TOPICID       JMSG_UDP_PEER_STATS_TLM_TOPICID
+#define CFG_JMSG_UDP_LZ_STATS_TLM_TOPICID         JMSG_UDP_LZ_STATS_TLM_TOPICID
+#define CFG_JMSG_UDP_SB_STATS_TLM_TOPICID         JMSG_UDP_SB_STATS_TLM_TOPICID
+#define CFG_JMSG_UDP_SELF_TEST_TLM_TOPICID        JMSG_UDP_SELF_TEST_TLM_TOPICID
+#define CFG_JMSG_UDP_DECODE_STATS_TLM_TOPICID     JMSG_UDP_DECODE_STATS_TLM_TOPICID
 #define CFG_SEND_STATUS_TLM_TOPICID               BC_SCH_2_SEC_TOPICID
 #define CFG_JMSG_LIB_TOPIC_SUBSCRIBE_TLM_TOPICID  JMSG_LIB_TOPIC_SUBSCRIBE_TLM_TOPICID
 
@@ -81,15 +87,76 @@
 
 #define CFG_JMSG_PIPE_NAME  JMSG_PIPE_NAME
 #define CFG_JMSG_PIPE_DEPTH JMSG_PIPE_DEPTH
+#define CFG_JMSG_PIPE_ALT_NAME  JMSG_PIPE_ALT_NAME
+#define CFG_JMSG_PIPE_MSG_LIM   JMSG_PIPE_MSG_LIM
+
+#define CFG_JSON_MAX_DEPTH  JSON_MAX_DEPTH
+
+#define CFG_SOCK_RECV_PERF_ID     SOCK_RECV_PERF_ID
+#define CFG_ROUTE_LOOKUP_PERF_ID  ROUTE_LOOKUP_PERF_ID
+#define CFG_JSON_TO_SB_PERF_ID    JSON_TO_SB_PERF_ID
+#define CFG_SB_SEND_PERF_ID       SB_SEND_PERF_ID
+#define CFG_SB_RECV_PERF_ID       SB_RECV_PERF_ID
+#define CFG_SB_TO_JSON_PERF_ID    SB_TO_JSON_PERF_ID
+#define CFG_SOCK_SEND_PERF_ID     SOCK_SEND_PERF_ID
+
+#define CFG_ROUTE_TBL_FILE  ROUTE_TBL_FILE
+
+#define CFG_SINGLE_TASK_MODE     SINGLE_TASK_MODE
+#define CFG_SINGLE_TASK_WAIT_MS  SINGLE_TASK_WAIT_MS
+#define CFG_SINGLE_TASK_MSG_LIM  SINGLE_TASK_MSG_LIM
+
+#define CFG_IO_ENGINE            IO_ENGINE
+#define CFG_IO_URING_DEPTH       IO_URING_DEPTH
 
 #define CFG_RX_UDP_PORT          RX_UDP_PORT
+#define CFG_RX_KERNEL_TIME       RX_KERNEL_TIME
 #define CFG_RX_CHILD_NAME        RX_CHILD_NAME
 #define CFG_RX_CHILD_STACK_SIZE  RX_CHILD_STACK_SIZE
 #define CFG_RX_CHILD_PRIORITY    RX_CHILD_PRIORITY
 #define CFG_RX_CHILD_PERF_ID     RX_CHILD_PERF_ID
+#define CFG_RX_PROC_TIME_LIM_US  RX_PROC_TIME_LIM_US
 
 #define CFG_TX_UDP_ADDR          TX_UDP_ADDR
 #define CFG_TX_UDP_PORT          TX_UDP_PORT
+#define CFG_TX_TIME_FIELD        TX_TIME_FIELD
+#define CFG_TX_SEQ               TX_SEQ
+
+#define CFG_DATAGRAM_LEN         DATAGRAM_LEN
+
+#define CFG_REL_WINDOW           REL_WINDOW
+#define CFG_REL_SLOT_CNT         REL_SLOT_CNT
+#define CFG_REL_RTO_MS           REL_RTO_MS
+#define CFG_REL_RETRY_LIM        REL_RETRY_LIM
+#define CFG_REL_ACK_TO_TX_ADDR   REL_ACK_TO_TX_ADDR
+
+#define CFG_FRAG_CNT             FRAG_CNT
+#define CFG_FRAG_POOL_CNT        FRAG_POOL_CNT
+#define CFG_FRAG_TIMEOUT_MS      FRAG_TIMEOUT_MS
+
+#define CFG_LZ_MIN_LEN           LZ_MIN_LEN
+#define CFG_LZ_DICT_FILE         LZ_DICT_FILE
+
+#define CFG_CAP_FILE             CAP_FILE
+#define CFG_CAP_FILE_LEN         CAP_FILE_LEN
+
+#define CFG_LOCAL_RX_PATH        LOCAL_RX_PATH
+#define CFG_LOCAL_TX_PATH        LOCAL_TX_PATH
+#define CFG_LOCAL_SHM_NAME       LOCAL_SHM_NAME
+#define CFG_LOCAL_SHM_LEN        LOCAL_SHM_LEN
+
+#define CFG_LVC_TOPIC_CNT        LVC_TOPIC_CNT
+#define CFG_LVC_VALUE_LEN        LVC_VALUE_LEN
+#define CFG_LVC_QUERY_ADDR       LVC_QUERY_ADDR
+#define CFG_LVC_ALL_REPLY_LIM    LVC_ALL_REPLY_LIM
+
+#define CFG_DECODE_WORKER_CNT        DECODE_WORKER_CNT
+#define CFG_DECODE_QUEUE_DEPTH       DECODE_QUEUE_DEPTH
+#define CFG_DECODE_QUEUE_LEN         DECODE_QUEUE_LEN
+#define CFG_DECODE_CHILD_STACK_SIZE  DECODE_CHILD_STACK_SIZE
+#define CFG_DECODE_CHILD_PRIORITY    DECODE_CHILD_PRIORITY
+#define CFG_DECODE_CHILD_PERF_ID     DECODE_CHILD_PERF_ID
+
 #define CFG_TX_CHILD_NAME        TX_CHILD_NAME
 #define CFG_TX_CHILD_STACK_SIZE  TX_CHILD_STACK_SIZE
 #define CFG_TX_CHILD_PRIORITY    TX_CHILD_PRIORITY
@@ -103,19 +170,72 @@
    XX(APP_MAIN_PERF_ID,uint32) \
    XX(JMSG_UDP_CMD_TOPICID,uint32) \
    XX(JMSG_UDP_STATUS_TLM_TOPICID,uint32) \
+   XX(JMSG_UDP_EXT_STATUS_TLM_TOPICID,uint32) \
+   XX(JMSG_UDP_PEER_STATS_TLM_TOPICID,uint32) \
+   XX(JMSG_UDP_LZ_STATS_TLM_TOPICID,uint32) \
+   XX(JMSG_UDP_SB_STATS_TLM_TOPICID,uint32) \
+   XX(JMSG_UDP_SELF_TEST_TLM_TOPICID,uint32) \
+   XX(JMSG_UDP_DECODE_STATS_TLM_TOPICID,uint32) \
    XX(BC_SCH_2_SEC_TOPICID,uint32) \
    XX(JMSG_LIB_TOPIC_SUBSCRIBE_TLM_TOPICID,uint32) \
    XX(CMD_PIPE_NAME,char*) \
    XX(CMD_PIPE_DEPTH,uint32) \
    XX(JMSG_PIPE_NAME,char*) \
    XX(JMSG_PIPE_DEPTH,uint32) \
+   XX(JMSG_PIPE_ALT_NAME,char*) \
+   XX(JMSG_PIPE_MSG_LIM,uint32) \
+   XX(JSON_MAX_DEPTH,uint32) \
+   XX(SOCK_RECV_PERF_ID,uint32) \
+   XX(ROUTE_LOOKUP_PERF_ID,uint32) \
+   XX(JSON_TO_SB_PERF_ID,uint32) \
+   XX(SB_SEND_PERF_ID,uint32) \
+   XX(SB_RECV_PERF_ID,uint32) \
+   XX(SB_TO_JSON_PERF_ID,uint32) \
+   XX(SOCK_SEND_PERF_ID,uint32) \
+   XX(ROUTE_TBL_FILE,char*) \
+   XX(SINGLE_TASK_MODE,uint32) \
+   XX(SINGLE_TASK_WAIT_MS,uint32) \
+   XX(SINGLE_TASK_MSG_LIM,uint32) \
+   XX(IO_ENGINE,char*) \
+   XX(IO_URING_DEPTH,uint32) \
    XX(RX_UDP_PORT,uint32) \
+   XX(RX_KERNEL_TIME,uint32) \
    XX(RX_CHILD_NAME,char*) \
    XX(RX_CHILD_STACK_SIZE,uint32) \
    XX(RX_CHILD_PRIORITY,uint32) \
    XX(RX_CHILD_PERF_ID,uint32) \
+   XX(RX_PROC_TIME_LIM_US,uint32) \
    XX(TX_UDP_ADDR,char*) \
    XX(TX_UDP_PORT,uint32) \
+   XX(TX_TIME_FIELD,char*) \
+   XX(TX_SEQ,uint32) \
+   XX(DATAGRAM_LEN,uint32) \
+   XX(REL_WINDOW,uint32) \
+   XX(REL_SLOT_CNT,uint32) \
+   XX(REL_RTO_MS,uint32) \
+   XX(REL_RETRY_LIM,uint32) \
+   XX(REL_ACK_TO_TX_ADDR,uint32) \
+   XX(FRAG_CNT,uint32) \
+   XX(FRAG_POOL_CNT,uint32) \
+   XX(FRAG_TIMEOUT_MS,uint32) \
+   XX(LZ_MIN_LEN,uint32) \
+   XX(LZ_DICT_FILE,char*) \
+   XX(CAP_FILE,char*) \
+   XX(CAP_FILE_LEN,uint32) \
+   XX(LOCAL_RX_PATH,char*) \
+   XX(LOCAL_TX_PATH,char*) \
+   XX(LOCAL_SHM_NAME,char*) \
+   XX(LOCAL_SHM_LEN,uint32) \
+   XX(LVC_TOPIC_CNT,uint32) \
+   XX(LVC_VALUE_LEN,uint32) \
+   XX(LVC_QUERY_ADDR,char*) \
+   XX(LVC_ALL_REPLY_LIM,uint32) \
+   XX(DECODE_WORKER_CNT,uint32) \
+   XX(DECODE_QUEUE_DEPTH,uint32) \
+   XX(DECODE_QUEUE_LEN,uint32) \
+   XX(DECODE_CHILD_STACK_SIZE,uint32) \
+   XX(DECODE_CHILD_PRIORITY,uint32) \
+   XX(DECODE_CHILD_PERF_ID,uint32) \
    XX(TX_CHILD_NAME,char*) \
    XX(TX_CHILD_STACK_SIZE,uint32) \
    XX(TX_CHILD_PRIORITY,uint32) \
@@ -137,6 +257,17 @@ DECLARE_ENUM(Config,APP_CONFIG)
 #define JMSG_UDP_APP_BASE_EID  (APP_C_FW_APP_BASE_EID +  0)
 #define JMSG_UDP_BASE_EID      (APP_C_FW_APP_BASE_EID + 20)
 #define JMSG_TRANS_BASE_EID    (APP_C_FW_APP_BASE_EID + 30)
+#define JMSG_ROUTE_TBL_BASE_EID (APP_C_FW_APP_BASE_EID + 40)
+#define JMSG_SEQ_BASE_EID       (APP_C_FW_APP_BASE_EID + 50)
+#define JMSG_REL_BASE_EID       (APP_C_FW_APP_BASE_EID + 60)
+#define JMSG_FRAG_BASE_EID      (APP_C_FW_APP_BASE_EID + 70)
+#define JMSG_MEM_BASE_EID       (APP_C_FW_APP_BASE_EID + 80)
+#define JMSG_LZ_BASE_EID        (APP_C_FW_APP_BASE_EID + 90)
+#define JMSG_CAP_BASE_EID       (APP_C_FW_APP_BASE_EID + 100)
+#define JMSG_LOCAL_BASE_EID     (APP_C_FW_APP_BASE_EID + 110)
+#define JMSG_LVC_BASE_EID       (APP_C_FW_APP_BASE_EID + 120)
+#define JMSG_SELFTEST_BASE_EID  (APP_C_FW_APP_BASE_EID + 130)
+#define JMSG_DECODE_BASE_EID    (APP_C_FW_APP_BASE_EID + 140)
 
 // Topic plugin macros are defined in jmsg_lib/eds/jmsg_usr.xml
 
@@ -146,7 +277,9 @@ DECLARE_ENUM(Config,APP_CONFIG)
 **
 */
 
-#define JMSG_UDP_BUF_LEN   4096  /* Must accomodate Rx and Tx maximum message length */
+#define JMSG_UDP_BUF_LEN   4096  /* Upper bound for DATAGRAM_LEN, longer JMSGs are fragmented */
+
+#define JMSG_UDP_RECONFIG_POLL_MS  500  /* Maximum time for child tasks to detect a reconfiguration */
 
 
 
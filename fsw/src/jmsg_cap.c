@@ -0,0 +1,465 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Capture Rx datagrams and Tx messages to a memory mapped ring file
+**
+** Notes:
+**   1. See jmsg_cap.h
+**   2. Writers check the active flag before taking their stream's mutex
+**      so capture costs nothing while it's stopped. The mutex is only
+**      contended by the capture and reconfigure commands so taking it
+**      doesn't normally enter the kernel.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_cap.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define JMSG_CAP_MMAP
+#endif
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define ALIGN(Len)        (((Len) + JMSG_CAP_REC_ALIGN - 1) & ~(JMSG_CAP_REC_ALIGN - 1))
+#define REC_LEN(DataLen)  ALIGN(sizeof(JMSG_CAP_Rec_t) + (DataLen))
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static void FreeRecs(JMSG_CAP_Dir_t Dir, uint32 Limit);
+static bool Start(const char *File);
+static void Stop(void);
+static void WriteRec(JMSG_CAP_Dir_t Dir, const CFE_TIME_SysTime_t *Time, const JMSG_SOCK_RxInfo_t *Peer,
+                     uint32 MsgId, const char *Data, uint16 DataLen);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_CAP_Class_t *JMsgCap = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_CAP_Constructor
+**
+*/
+void JMSG_CAP_Constructor(JMSG_CAP_Class_t *CapPtr, const INITBL_Class_t *IniTbl)
+{
+
+   uint16 Dir;
+
+   JMsgCap = CapPtr;
+
+   memset(JMsgCap, 0, sizeof(JMSG_CAP_Class_t));
+   JMsgCap->Fd = -1;
+
+   strncpy(JMsgCap->DefFile, INITBL_GetStrConfig(IniTbl, CFG_CAP_FILE), OS_MAX_PATH_LEN - 1);
+   JMsgCap->FileLen = INITBL_GetIntConfig(IniTbl, CFG_CAP_FILE_LEN) & ~(JMSG_CAP_REC_ALIGN - 1);
+
+   if (JMsgCap->FileLen < JMSG_CAP_FILE_MIN || JMsgCap->FileLen > JMSG_UDP_PLATFORM_CAP_FILE_MAX)
+   {
+      CFE_EVS_SendEvent(JMSG_CAP_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "CAP_FILE_LEN %u must be %u to %u bytes, using %u",
+                        (unsigned int)JMsgCap->FileLen, (unsigned int)JMSG_CAP_FILE_MIN,
+                        (unsigned int)JMSG_UDP_PLATFORM_CAP_FILE_MAX, (unsigned int)JMSG_CAP_FILE_MIN);
+      JMsgCap->FileLen = JMSG_CAP_FILE_MIN;
+   }
+
+   for (Dir=0; Dir < JMSG_CAP_DIR_CNT; Dir++)
+   {
+      OS_MutSemCreate(&JMsgCap->Stream[Dir].Mutex, (Dir == JMSG_CAP_DIR_RX ? "JMSG_CAP_RX" : "JMSG_CAP_TX"), 0);
+   }
+
+} /* End JMSG_CAP_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_CAP_CaptureCmd
+**
+*/
+bool JMSG_CAP_CaptureCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   const JMSG_UDP_Capture_CmdPayload_t *Cmd = CMDMGR_PAYLOAD_PTR(MsgPtr, JMSG_UDP_Capture_t);
+   char File[OS_MAX_PATH_LEN];
+
+   if (Cmd->Enable)
+   {
+      strncpy(File, (Cmd->File[0] != '\0' ? Cmd->File : JMsgCap->DefFile), OS_MAX_PATH_LEN - 1);
+      File[OS_MAX_PATH_LEN - 1] = '\0';
+      if (JMsgCap->Active)
+      {
+         Stop();
+      }
+      return Start(File);
+   }
+
+   if (JMsgCap->Active)
+   {
+      Stop();
+   }
+   else
+   {
+      CFE_EVS_SendEvent(JMSG_CAP_CAPTURE_CMD_EID, CFE_EVS_EventType_INFORMATION,
+                        "Capture is already stopped");
+   }
+
+   return true;
+
+} /* End JMSG_CAP_CaptureCmd() */
+
+
+/******************************************************************************
+** Function: JMSG_CAP_IsActive
+**
+*/
+bool JMSG_CAP_IsActive(void)
+{
+
+   return JMsgCap->Active;
+
+} /* End JMSG_CAP_IsActive() */
+
+
+/******************************************************************************
+** Function: JMSG_CAP_Rx
+**
+*/
+void JMSG_CAP_Rx(const char *Data, uint16 DataLen, const JMSG_SOCK_RxInfo_t *RxInfo,
+                 uint32 MsgId)
+{
+
+   if (JMsgCap->Active)
+   {
+      WriteRec(JMSG_CAP_DIR_RX, &RxInfo->Time, RxInfo, MsgId, Data, DataLen);
+   }
+
+} /* End JMSG_CAP_Rx() */
+
+
+/******************************************************************************
+** Function: JMSG_CAP_SetTxPeer
+**
+*/
+void JMSG_CAP_SetTxPeer(const OS_SockAddr_t *SockAddr)
+{
+
+   JMSG_CAP_Stream_t *Stream = &JMsgCap->Stream[JMSG_CAP_DIR_TX];
+   JMSG_SOCK_RxInfo_t Peer;
+
+   JMSG_SOCK_GetPeer(SockAddr, &Peer);
+
+   OS_MutSemTake(Stream->Mutex);
+   Stream->Peer = Peer;
+   OS_MutSemGive(Stream->Mutex);
+
+} /* End JMSG_CAP_SetTxPeer() */
+
+
+/******************************************************************************
+** Function: JMSG_CAP_Tx
+**
+*/
+void JMSG_CAP_Tx(const char *Data, uint16 DataLen, uint32 MsgId)
+{
+
+   CFE_TIME_SysTime_t Time;
+
+   if (JMsgCap->Active)
+   {
+      Time = CFE_TIME_GetTime();
+      WriteRec(JMSG_CAP_DIR_TX, &Time, NULL, MsgId, Data, DataLen);
+   }
+
+} /* End JMSG_CAP_Tx() */
+
+
+/******************************************************************************
+** Function: FreeRecs
+**
+** Advance a region's tail past the records that start before Limit and are
+** about to be overwritten.
+**
+** Notes:
+**   1. Only records at or after the head can be in the way. Records before
+**      the head are newer and Limit never reaches back to them.
+**
+*/
+static void FreeRecs(JMSG_CAP_Dir_t Dir, uint32 Limit)
+{
+
+   JMSG_CAP_Region_t *Region = &JMsgCap->Hdr->Region[Dir];
+   const JMSG_CAP_Rec_t *Rec;
+   uint32 End = Region->Start + Region->Len;
+
+   while (Region->RecCnt > 0 && Region->Tail >= Region->Head && Region->Tail < Limit)
+   {
+      Rec = (const JMSG_CAP_Rec_t *)&JMsgCap->Map[Region->Tail];
+      Region->Tail += REC_LEN(Rec->DataLen);
+      Region->RecCnt--;
+      JMsgCap->Stream[Dir].LostCnt++;
+
+      if (Region->RecCnt == 0)
+      {
+         Region->Tail = Region->Head;
+      }
+      else if (End - Region->Tail < sizeof(JMSG_CAP_Rec_t) ||
+               ((const JMSG_CAP_Rec_t *)&JMsgCap->Map[Region->Tail])->Dir == JMSG_CAP_DIR_WRAP)
+      {
+         Region->Tail = Region->Start;
+      }
+   }
+
+} /* End FreeRecs() */
+
+
+/******************************************************************************
+** Function: Start
+**
+** Create and map a capture file and start recording.
+**
+*/
+static bool Start(const char *File)
+{
+
+#ifdef JMSG_CAP_MMAP
+
+   char   LocalPath[OS_MAX_LOCAL_PATH_LEN];
+   uint32 RegionLen;
+   uint16 Dir;
+   void   *Map;
+   int    Fd;
+   CFE_TIME_SysTime_t Time;
+
+   if (strlen(File) >= sizeof(JMsgCap->File))
+   {
+      CFE_EVS_SendEvent(JMSG_CAP_CAPTURE_CMD_EID, CFE_EVS_EventType_ERROR,
+                        "Capture file name exceeds %d characters", (int)sizeof(JMsgCap->File) - 1);
+      return false;
+   }
+
+   if (OS_TranslatePath(File, LocalPath) != OS_SUCCESS)
+   {
+      CFE_EVS_SendEvent(JMSG_CAP_CAPTURE_CMD_EID, CFE_EVS_EventType_ERROR,
+                        "Capture file %s is not a valid path", File);
+      return false;
+   }
+
+   Fd = open(LocalPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (Fd < 0)
+   {
+      CFE_EVS_SendEvent(JMSG_CAP_CAPTURE_CMD_EID, CFE_EVS_EventType_ERROR,
+                        "Error creating capture file %s", File);
+      return false;
+   }
+
+   Map = MAP_FAILED;
+   if (ftruncate(Fd, JMsgCap->FileLen) == 0)
+   {
+      Map = mmap(NULL, JMsgCap->FileLen, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+   }
+   if (Map == MAP_FAILED)
+   {
+      close(Fd);
+      CFE_EVS_SendEvent(JMSG_CAP_CAPTURE_CMD_EID, CFE_EVS_EventType_ERROR,
+                        "Error mapping %u bytes of capture file %s",
+                        (unsigned int)JMsgCap->FileLen, File);
+      return false;
+   }
+
+   JMsgCap->Fd  = Fd;
+   JMsgCap->Map = Map;
+   JMsgCap->Hdr = Map;
+   memcpy(JMsgCap->File, File, strlen(File) + 1);
+
+   /* The file is zero filled so only the header's non-zero fields are set */
+   Time = CFE_TIME_GetTime();
+   JMsgCap->Hdr->Magic   = JMSG_CAP_MAGIC;
+   JMsgCap->Hdr->Version = JMSG_CAP_VERSION;
+   JMsgCap->Hdr->HdrLen  = sizeof(JMSG_CAP_FileHdr_t);
+   JMsgCap->Hdr->FileLen = JMsgCap->FileLen;
+   JMsgCap->Hdr->StartSeconds    = Time.Seconds;
+   JMsgCap->Hdr->StartSubseconds = Time.Subseconds;
+
+   RegionLen = ((JMsgCap->FileLen - ALIGN(sizeof(JMSG_CAP_FileHdr_t))) / JMSG_CAP_DIR_CNT) & ~(JMSG_CAP_REC_ALIGN - 1);
+   for (Dir=0; Dir < JMSG_CAP_DIR_CNT; Dir++)
+   {
+      JMsgCap->Hdr->Region[Dir].Start = ALIGN(sizeof(JMSG_CAP_FileHdr_t)) + Dir*RegionLen;
+      JMsgCap->Hdr->Region[Dir].Len  = RegionLen;
+      JMsgCap->Hdr->Region[Dir].Head = JMsgCap->Hdr->Region[Dir].Start;
+      JMsgCap->Hdr->Region[Dir].Tail = JMsgCap->Hdr->Region[Dir].Start;
+
+      OS_MutSemTake(JMsgCap->Stream[Dir].Mutex);
+      JMsgCap->Stream[Dir].RecCnt  = 0;
+      JMsgCap->Stream[Dir].LostCnt = 0;
+      JMsgCap->Stream[Dir].DropCnt = 0;
+      OS_MutSemGive(JMsgCap->Stream[Dir].Mutex);
+   }
+
+   JMsgCap->Active = true;
+
+   CFE_EVS_SendEvent(JMSG_CAP_CAPTURE_CMD_EID, CFE_EVS_EventType_INFORMATION,
+                     "Started capture to %s, %u byte Rx and Tx regions", File, (unsigned int)RegionLen);
+
+   return true;
+
+#else
+
+   CFE_EVS_SendEvent(JMSG_CAP_CAPTURE_CMD_EID, CFE_EVS_EventType_ERROR,
+                     "Capture to %s rejected, memory mapped files are not supported on this platform", File);
+   return false;
+
+#endif
+
+} /* End Start() */
+
+
+/******************************************************************************
+** Function: Stop
+**
+** Stop recording, write the file and unmap it.
+**
+** Notes:
+**   1. Clearing the active flag with both stream mutexes held guarantees
+**      no writer is still using the mapping.
+**
+*/
+static void Stop(void)
+{
+
+   uint16 Dir;
+
+   for (Dir=0; Dir < JMSG_CAP_DIR_CNT; Dir++)
+   {
+      OS_MutSemTake(JMsgCap->Stream[Dir].Mutex);
+   }
+   JMsgCap->Active = false;
+   for (Dir=0; Dir < JMSG_CAP_DIR_CNT; Dir++)
+   {
+      OS_MutSemGive(JMsgCap->Stream[Dir].Mutex);
+   }
+
+#ifdef JMSG_CAP_MMAP
+   msync(JMsgCap->Map, JMsgCap->FileLen, MS_SYNC);
+   munmap(JMsgCap->Map, JMsgCap->FileLen);
+   close(JMsgCap->Fd);
+#endif
+
+   JMsgCap->Fd  = -1;
+   JMsgCap->Map = NULL;
+   JMsgCap->Hdr = NULL;
+
+   CFE_EVS_SendEvent(JMSG_CAP_CAPTURE_CMD_EID, CFE_EVS_EventType_INFORMATION,
+                     "Stopped capture to %s, recorded %u Rx and %u Tx messages, %u overwritten, %u dropped",
+                     JMsgCap->File,
+                     (unsigned int)JMsgCap->Stream[JMSG_CAP_DIR_RX].RecCnt,
+                     (unsigned int)JMsgCap->Stream[JMSG_CAP_DIR_TX].RecCnt,
+                     (unsigned int)(JMsgCap->Stream[JMSG_CAP_DIR_RX].LostCnt + JMsgCap->Stream[JMSG_CAP_DIR_TX].LostCnt),
+                     (unsigned int)(JMsgCap->Stream[JMSG_CAP_DIR_RX].DropCnt + JMsgCap->Stream[JMSG_CAP_DIR_TX].DropCnt));
+
+} /* End Stop() */
+
+
+/******************************************************************************
+** Function: WriteRec
+**
+** Append a record to a direction's region, overwriting the oldest records
+** if the region is full.
+**
+** Notes:
+**   1. A NULL Peer records the stream's Tx destination.
+**   2. A record that doesn't fit before the end of the region is written
+**      at the start. A wrap record marks the unused end if there's room.
+**
+*/
+static void WriteRec(JMSG_CAP_Dir_t Dir, const CFE_TIME_SysTime_t *Time, const JMSG_SOCK_RxInfo_t *Peer,
+                     uint32 MsgId, const char *Data, uint16 DataLen)
+{
+
+   JMSG_CAP_Stream_t *Stream = &JMsgCap->Stream[Dir];
+   JMSG_CAP_Region_t *Region;
+   JMSG_CAP_Rec_t    *Rec;
+   uint32 RecLen = REC_LEN(DataLen);
+   uint32 End;
+
+   OS_MutSemTake(Stream->Mutex);
+
+   if (JMsgCap->Active)
+   {
+      Region = &JMsgCap->Hdr->Region[Dir];
+      End    = Region->Start + Region->Len;
+
+      if (RecLen > Region->Len)
+      {
+         Stream->DropCnt++;
+      }
+      else
+      {
+         if (Region->Head + RecLen > End)
+         {
+            FreeRecs(Dir, End);
+            if (End - Region->Head >= sizeof(JMSG_CAP_Rec_t))
+            {
+               Rec = (JMSG_CAP_Rec_t *)&JMsgCap->Map[Region->Head];
+               memset(Rec, 0, sizeof(JMSG_CAP_Rec_t));
+               Rec->Dir = JMSG_CAP_DIR_WRAP;
+            }
+            Region->Head = Region->Start;
+            if (Region->RecCnt == 0)
+            {
+               Region->Tail = Region->Start;
+            }
+         }
+         FreeRecs(Dir, Region->Head + RecLen);
+
+         if (Peer == NULL)
+         {
+            Peer = &Stream->Peer;
+         }
+         Rec = (JMSG_CAP_Rec_t *)&JMsgCap->Map[Region->Head];
+         Rec->Seconds    = Time->Seconds;
+         Rec->Subseconds = Time->Subseconds;
+         Rec->PeerAddr   = Peer->PeerAddr;
+         Rec->MsgId      = MsgId;
+         Rec->PeerPort   = Peer->PeerPort;
+         Rec->DataLen    = DataLen;
+         Rec->Dir        = Dir;
+         memset(Rec->Spare, 0, sizeof(Rec->Spare));
+         memcpy(&Rec[1], Data, DataLen);
+
+         Region->Head += RecLen;
+         Region->RecCnt++;
+         Stream->RecCnt++;
+      }
+   }
+
+   OS_MutSemGive(Stream->Mutex);
+
+} /* End WriteRec() */
@@ -0,0 +1,240 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Capture Rx datagrams and Tx messages to a memory mapped ring file
+**
+** Notes:
+**   1. The capture command maps a file of CAP_FILE_LEN bytes and every Rx
+**      datagram and Tx JMSG is copied into it until capture is stopped.
+**      Recording a message is a copy into the mapping. The kernel writes
+**      the pages to the file system so there are no per message system
+**      calls.
+**   2. The file starts with a JMSG_CAP_FileHdr_t followed by an Rx and a
+**      Tx region. Each region is a ring of records with its own mutex so
+**      the Rx and Tx tasks don't contend. When a region is full its oldest
+**      records are overwritten. A datagram whose payload is queued to a
+**      decode worker is recorded by the worker once its SB message ID is
+**      known, so Rx records of different topics may not be in arrival
+**      order. Each record has its receive time.
+**   3. A record is a JMSG_CAP_Rec_t followed by DataLen message bytes and
+**      padded to a multiple of JMSG_CAP_REC_ALIGN. The region header gives
+**      the oldest record (Tail), the next write position (Head) and the
+**      number of records. A reader starts at Tail and reads RecCnt records,
+**      continuing at the region start after a JMSG_CAP_DIR_WRAP record or
+**      when fewer than sizeof(JMSG_CAP_Rec_t) bytes are left.
+**   4. The headers are in the processor's byte order, which a reader can
+**      determine from the magic number. Rx records are the datagrams as
+**      received, including fragments and compressed payloads, so they can
+**      be replayed to a gateway's Rx port. Tx records are whole JMSGs
+**      before fragmentation. Retransmissions and acks aren't recorded.
+**   5. The header is kept current while capturing so the file can be
+**      copied and read at any time. Stopping capture synchronizes the file.
+**   6. Memory mapped files require Linux. On other targets the capture
+**      command is rejected.
+**
+*/
+#ifndef _jmsg_cap_
+#define _jmsg_cap_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_sock.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_CAP_MAGIC      0x5041434A   /* "JCAP" in a little endian file */
+#define JMSG_CAP_VERSION    1
+#define JMSG_CAP_REC_ALIGN  4
+#define JMSG_CAP_FILE_MIN   (64*1024)
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_CAP_CONSTRUCTOR_EID  (JMSG_CAP_BASE_EID + 0)
+#define JMSG_CAP_CAPTURE_CMD_EID  (JMSG_CAP_BASE_EID + 1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef enum
+{
+
+   JMSG_CAP_DIR_RX   = 0,
+   JMSG_CAP_DIR_TX   = 1,
+   JMSG_CAP_DIR_CNT  = 2,
+   JMSG_CAP_DIR_WRAP = 0xFF   /* Record marking the end of a region's data */
+
+} JMSG_CAP_Dir_t;
+
+
+/*
+** File layout
+*/
+
+typedef struct
+{
+
+   uint32  Seconds;      /* Rx arrival or Tx send cFE time */
+   uint32  Subseconds;
+   uint32  PeerAddr;     /* Rx sender or Tx destination, see jmsg_sock.h */
+   uint32  MsgId;        /* Topic's SB message ID, zero if Rx wasn't routed */
+   uint16  PeerPort;
+   uint16  DataLen;
+   uint8   Dir;          /* JMSG_CAP_Dir_t */
+   uint8   Spare[3];
+
+} JMSG_CAP_Rec_t;
+
+
+typedef struct
+{
+
+   uint32  Start;    /* File offsets */
+   uint32  Len;
+   uint32  Head;
+   uint32  Tail;
+   uint32  RecCnt;   /* Records between Tail and Head */
+
+} JMSG_CAP_Region_t;
+
+
+typedef struct
+{
+
+   uint32  Magic;
+   uint16  Version;
+   uint16  HdrLen;
+   uint32  FileLen;
+   uint32  StartSeconds;
+   uint32  StartSubseconds;
+
+   JMSG_CAP_Region_t  Region[JMSG_CAP_DIR_CNT];
+
+} JMSG_CAP_FileHdr_t;
+
+
+/*
+** Class Definition
+*/
+
+typedef struct
+{
+
+   osal_id_t           Mutex;     /* Serializes the writer and the capture command */
+   JMSG_SOCK_RxInfo_t  Peer;      /* Tx destination */
+   uint32              RecCnt;    /* Records written since capture started */
+   uint32              LostCnt;   /* Records overwritten */
+   uint32              DropCnt;   /* Messages longer than the region */
+
+} JMSG_CAP_Stream_t;
+
+
+typedef struct
+{
+
+   char    DefFile[OS_MAX_PATH_LEN];
+   uint32  FileLen;
+
+   volatile bool  Active;
+   char           File[OS_MAX_PATH_LEN];
+   int            Fd;
+   uint8          *Map;
+   JMSG_CAP_FileHdr_t *Hdr;
+
+   JMSG_CAP_Stream_t  Stream[JMSG_CAP_DIR_CNT];
+
+} JMSG_CAP_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_CAP_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**
+*/
+void JMSG_CAP_Constructor(JMSG_CAP_Class_t *CapPtr, const INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: JMSG_CAP_CaptureCmd
+**
+** Start capturing to a new file or stop capturing.
+**
+** Notes:
+**   1. An empty file name uses CAP_FILE. Starting a capture while one is
+**      active stops the active capture first. An existing file is
+**      replaced.
+**
+*/
+bool JMSG_CAP_CaptureCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr);
+
+
+/******************************************************************************
+** Function: JMSG_CAP_IsActive
+**
+** Return true if messages are being captured.
+**
+*/
+bool JMSG_CAP_IsActive(void);
+
+
+/******************************************************************************
+** Function: JMSG_CAP_Rx
+**
+** Record an Rx datagram.
+**
+** Notes:
+**   1. MsgId is the SB message ID the datagram was translated to or zero.
+**
+*/
+void JMSG_CAP_Rx(const char *Data, uint16 DataLen, const JMSG_SOCK_RxInfo_t *RxInfo,
+                 uint32 MsgId);
+
+
+/******************************************************************************
+** Function: JMSG_CAP_SetTxPeer
+**
+** Set the destination recorded with Tx messages.
+**
+*/
+void JMSG_CAP_SetTxPeer(const OS_SockAddr_t *SockAddr);
+
+
+/******************************************************************************
+** Function: JMSG_CAP_Tx
+**
+** Record a Tx JMSG sent to the Tx address.
+**
+*/
+void JMSG_CAP_Tx(const char *Data, uint16 DataLen, uint32 MsgId);
+
+
+#endif /* _jmsg_cap_ */
@@ -0,0 +1,584 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Decode Rx JMSG payloads on a pool of worker tasks sharded by topic
+**
+** Notes:
+**   1. See jmsg_decode.h
+**   2. Each queue has one producer, the Rx task, and one consumer, its
+**      worker. An entry is reserved under the mutex and filled without it,
+**      and the semaphore is given once the entry is complete so the worker
+**      never reads a partial entry. The worker decodes the entry at Tail in
+**      place and frees it under the mutex.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "jmsg_cap.h"
+#include "jmsg_decode.h"
+#include "jmsg_mem.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define ALIGN_LEN(Len)  (((Len) + sizeof(uint64) - 1) & ~(uint32)(sizeof(uint64) - 1))
+
+#define FNV_OFFSET  2166136261u
+#define FNV_PRIME   16777619u
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static JMSG_DECODE_Entry_t *AllocEntry(JMSG_DECODE_Worker_t *Worker, uint32 EntryLen);
+static void FreeEntry(JMSG_DECODE_Worker_t *Worker, uint32 EntryLen);
+static int64 GetTimeUs(void);
+static uint32 HashTopic(const char *Topic, uint16 TopicLen);
+static void SendDropEvent(JMSG_DECODE_Worker_t *Worker, uint16 WorkerIdx, const char *Topic, uint16 TopicLen);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_DECODE_Class_t *Decode = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_Constructor
+**
+** Notes:
+**   1. The ring is at least one longest message and datagram long so any
+**      message can be queued to an empty queue while capturing.
+**   2. If a worker's memory can't be allocated the workers that were
+**      allocated are used.
+**
+*/
+void JMSG_DECODE_Constructor(JMSG_DECODE_Class_t *DecodePtr, const INITBL_Class_t *IniTbl)
+{
+
+   JMSG_DECODE_Worker_t *Worker;
+   char   Name[OS_MAX_API_NAME];
+   uint32 WorkerCnt = INITBL_GetIntConfig(IniTbl, CFG_DECODE_WORKER_CNT);
+   uint32 EntryMaxLen;
+   uint16 i;
+
+   Decode = DecodePtr;
+
+   CFE_PSP_MemSet((void*)Decode, 0, sizeof(JMSG_DECODE_Class_t));
+
+   if (WorkerCnt > JMSG_UDP_PLATFORM_DECODE_WORKER_MAX)
+   {
+      WorkerCnt = JMSG_UDP_PLATFORM_DECODE_WORKER_MAX;
+   }
+
+   Decode->QueueDepth = INITBL_GetIntConfig(IniTbl, CFG_DECODE_QUEUE_DEPTH);
+   if (Decode->QueueDepth < 1)
+   {
+      Decode->QueueDepth = 1;
+   }
+
+   EntryMaxLen = ALIGN_LEN(sizeof(JMSG_DECODE_Entry_t) + JMSG_PLATFORM_TOPIC_NAME_MAX_LEN +
+                           JMSG_MEM_GetMsgMaxLen() + JMSG_MEM_GetDatagramLen());
+   Decode->QueueLen = ALIGN_LEN(INITBL_GetIntConfig(IniTbl, CFG_DECODE_QUEUE_LEN));
+   if (Decode->QueueLen < EntryMaxLen)
+   {
+      Decode->QueueLen = EntryMaxLen;
+   }
+
+   for (i=0; i < WorkerCnt; i++)
+   {
+      Worker = &Decode->Worker[i];
+      Worker->RxCtx = JMSG_MEM_Alloc(JMSG_MEM_USER_DECODE, sizeof(JMSG_TRANS_RxCtx_t));
+      if (Worker->RxCtx == NULL)
+      {
+         break;
+      }
+      Worker->Ring = JMSG_MEM_Alloc(JMSG_MEM_USER_DECODE, Decode->QueueLen);
+      if (Worker->Ring == NULL)
+      {
+         break;
+      }
+
+      JMSG_TRANS_InitRxCtx(Worker->RxCtx);
+      Worker->WrapAt = Decode->QueueLen;
+
+      snprintf(Name, sizeof(Name), "JMSG_UDP_DECQ%u", (unsigned int)i);
+      OS_MutSemCreate(&Worker->Mutex, Name, 0);
+      snprintf(Name, sizeof(Name), "JMSG_UDP_DECS%u", (unsigned int)i);
+      OS_CountSemCreate(&Worker->Sem, Name, 0, 0);
+   }
+   Decode->WorkerCnt = i;
+
+   if (Decode->WorkerCnt < WorkerCnt)
+   {
+      CFE_EVS_SendEvent(JMSG_DECODE_INIT_EID, CFE_EVS_EventType_ERROR,
+                        "Memory for %u of %u decode workers with %u byte queues was allocated",
+                        (unsigned int)Decode->WorkerCnt, (unsigned int)WorkerCnt, (unsigned int)Decode->QueueLen);
+   }
+
+   Decode->PrevTimeUs = GetTimeUs();
+
+} /* End JMSG_DECODE_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_AddRxCnt
+**
+*/
+void JMSG_DECODE_AddRxCnt(uint32 *ValidCnt, uint32 *InvalidCnt,
+                          uint32 *ShapeHitCnt, uint32 *ShapeMissCnt)
+{
+
+   const JMSG_TRANS_RxCtx_t *RxCtx;
+   uint16 i;
+
+   for (i=0; i < Decode->WorkerCnt; i++)
+   {
+      RxCtx = Decode->Worker[i].RxCtx;
+      *ValidCnt     += RxCtx->ValidJMsgCnt;
+      *InvalidCnt   += RxCtx->InvalidJMsgCnt;
+      *ShapeHitCnt  += RxCtx->Shape.HitCnt;
+      *ShapeMissCnt += RxCtx->Shape.MissCnt;
+   }
+
+} /* End JMSG_DECODE_AddRxCnt() */
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_ResetStatus
+**
+** Notes:
+**   1. Queue depths are current state and aren't reset.
+**
+*/
+void JMSG_DECODE_ResetStatus(void)
+{
+
+   JMSG_DECODE_Worker_t *Worker;
+   uint16 i;
+
+   for (i=0; i < Decode->WorkerCnt; i++)
+   {
+      Worker = &Decode->Worker[i];
+      Worker->MsgCnt       = 0;
+      Worker->DropCnt      = 0;
+      Worker->DropEvsCnt   = 0;
+      Worker->HighWater    = Worker->Queued;
+      Worker->PrevBusyUs   = Worker->BusyUs;
+      Worker->BusyPerMille = 0;
+      JMSG_TRANS_ResetRxCtx(Worker->RxCtx);
+      if (Decode->Started)
+      {
+         CHILDMGR_ResetStatus(&Worker->ChildMgr);
+      }
+   }
+
+} /* End JMSG_DECODE_ResetStatus() */
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_StartWorkers
+**
+** Notes:
+**   1. The converter lock is created before the first worker starts.
+**   2. Payloads are only queued once every worker is running so a topic is
+**      never decoded by two tasks.
+**   3. If a worker fails to start the workers already started are deleted.
+**      Nothing has been queued so they're idle waiting for their semaphore.
+**
+*/
+bool JMSG_DECODE_StartWorkers(const INITBL_Class_t *IniTbl)
+{
+
+   CHILDMGR_TaskInit_t ChildTaskInit;
+   char   TaskName[OS_MAX_API_NAME];
+   uint32 PerfId = INITBL_GetIntConfig(IniTbl, CFG_DECODE_CHILD_PERF_ID);
+   uint16 i;
+
+   if (Decode->WorkerCnt == 0)
+   {
+      return true;
+   }
+
+   JMSG_TRANS_CreateConvLock();
+
+   ChildTaskInit.TaskName  = TaskName;
+   ChildTaskInit.StackSize = INITBL_GetIntConfig(IniTbl, CFG_DECODE_CHILD_STACK_SIZE);
+   ChildTaskInit.Priority  = INITBL_GetIntConfig(IniTbl, CFG_DECODE_CHILD_PRIORITY);
+
+   for (i=0; i < Decode->WorkerCnt; i++)
+   {
+      snprintf(TaskName, sizeof(TaskName), "JMSG_UDP_DEC%u", (unsigned int)i);
+      ChildTaskInit.PerfId = PerfId + i;
+
+      /* Child Manager constructor sends error events */
+      if (CHILDMGR_Constructor(&Decode->Worker[i].ChildMgr, ChildMgr_TaskMainCallback,
+                               JMSG_DECODE_WorkerTask, &ChildTaskInit) != CFE_SUCCESS)
+      {
+         CFE_EVS_SendEvent(JMSG_DECODE_START_EID, CFE_EVS_EventType_ERROR,
+                           "Decode worker %u failed to start, payloads are decoded on the Rx task",
+                           (unsigned int)i);
+         while (i > 0)
+         {
+            i--;
+            CFE_ES_DeleteChildTask(Decode->Worker[i].ChildMgr.TaskId);
+         }
+         return false;
+      }
+   }
+
+   Decode->Started = true;
+
+   CFE_EVS_SendEvent(JMSG_DECODE_START_EID, CFE_EVS_EventType_INFORMATION,
+                     "Started %u decode workers with %u entry, %u byte queues",
+                     (unsigned int)Decode->WorkerCnt, (unsigned int)Decode->QueueDepth,
+                     (unsigned int)Decode->QueueLen);
+
+   return true;
+
+} /* End JMSG_DECODE_StartWorkers() */
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_Submit
+**
+*/
+JMSG_DECODE_Submit_t JMSG_DECODE_Submit(const JMSG_SOCK_RxInfo_t *RxInfo, const JMSG_HDR_Attr_t *HdrAttr,
+                                        const char *Topic, const char *Payload, uint16 PayloadLen,
+                                        const char *CapData, uint16 CapLen)
+{
+
+   JMSG_DECODE_Worker_t *Worker;
+   JMSG_DECODE_Entry_t  *Entry;
+   char   *EntryData;
+   uint32  EntryLen;
+   uint16  WorkerIdx;
+
+   if (!Decode->Started)
+   {
+      return JMSG_DECODE_INLINE;
+   }
+
+   WorkerIdx = HashTopic(Topic, HdrAttr->TopicLen) % Decode->WorkerCnt;
+   Worker    = &Decode->Worker[WorkerIdx];
+   EntryLen  = ALIGN_LEN(sizeof(JMSG_DECODE_Entry_t) + HdrAttr->TopicLen + PayloadLen + CapLen);
+
+   OS_MutSemTake(Worker->Mutex);
+   Entry = AllocEntry(Worker, EntryLen);
+   OS_MutSemGive(Worker->Mutex);
+
+   if (Entry == NULL)
+   {
+      Worker->DropCnt++;
+      SendDropEvent(Worker, WorkerIdx, Topic, HdrAttr->TopicLen);
+      return JMSG_DECODE_FULL;
+   }
+
+   Entry->RxInfo     = *RxInfo;
+   Entry->HdrAttr    = *HdrAttr;
+   Entry->EntryLen   = EntryLen;
+   Entry->PayloadLen = PayloadLen;
+   Entry->CapLen     = CapLen;
+
+   EntryData = (char *)(Entry + 1);
+   memcpy(EntryData, Topic, HdrAttr->TopicLen);
+   memcpy(&EntryData[HdrAttr->TopicLen], Payload, PayloadLen);
+   if (CapLen > 0)
+   {
+      memcpy(&EntryData[HdrAttr->TopicLen + PayloadLen], CapData, CapLen);
+   }
+
+   OS_CountSemGive(Worker->Sem);
+
+   return JMSG_DECODE_QUEUED;
+
+} /* End JMSG_DECODE_Submit() */
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_Update
+**
+** Notes:
+**   1. An update less than a millisecond after the previous one keeps the
+**      current utilization.
+**
+*/
+void JMSG_DECODE_Update(void)
+{
+
+   JMSG_DECODE_Worker_t *Worker;
+   int64  NowUs = GetTimeUs();
+   int64  IntervalUs = NowUs - Decode->PrevTimeUs;
+   uint32 BusyUs;
+   uint64 PerMille;
+   uint16 i;
+
+   if (IntervalUs < 1000)
+   {
+      return;
+   }
+
+   for (i=0; i < Decode->WorkerCnt; i++)
+   {
+      Worker   = &Decode->Worker[i];
+      BusyUs   = Worker->BusyUs;
+      PerMille = ((uint64)(BusyUs - Worker->PrevBusyUs) * 1000) / (uint64)IntervalUs;
+      Worker->BusyPerMille = (PerMille > 1000) ? 1000 : (uint16)PerMille;
+      Worker->PrevBusyUs   = BusyUs;
+   }
+
+   Decode->PrevTimeUs = NowUs;
+
+} /* End JMSG_DECODE_Update() */
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_WorkerTask
+**
+** Notes:
+**   1. Busy time wraps after about 71 minutes, utilization is computed from
+**      its change so a wrap during a status period doesn't disturb it.
+**   2. A captured datagram is recorded with the SB message ID its payload
+**      was decoded to. Capture time is part of the busy time.
+**
+*/
+bool JMSG_DECODE_WorkerTask(CHILDMGR_Class_t *ChildMgr)
+{
+
+   JMSG_DECODE_Worker_t *Worker = NULL;
+   JMSG_DECODE_Entry_t  *Entry;
+   const char *EntryData;
+   int64  StartUs;
+   uint16 i;
+
+   for (i=0; i < Decode->WorkerCnt; i++)
+   {
+      if (ChildMgr == &Decode->Worker[i].ChildMgr)
+      {
+         Worker = &Decode->Worker[i];
+         break;
+      }
+   }
+
+   if (Worker == NULL)
+   {
+      return false;
+   }
+
+   if (OS_CountSemTake(Worker->Sem) == OS_SUCCESS)
+   {
+
+      OS_MutSemTake(Worker->Mutex);
+      Entry = (JMSG_DECODE_Entry_t *)&Worker->Ring[Worker->Tail];
+      OS_MutSemGive(Worker->Mutex);
+
+      StartUs   = GetTimeUs();
+      EntryData = (const char *)(Entry + 1);
+      JMSG_TRANS_DecodeJMsg(Worker->RxCtx, &Entry->RxInfo, &Entry->HdrAttr, EntryData,
+                            &EntryData[Entry->HdrAttr.TopicLen], Entry->PayloadLen);
+      if (Entry->CapLen > 0)
+      {
+         JMSG_CAP_Rx(&EntryData[Entry->HdrAttr.TopicLen + Entry->PayloadLen], Entry->CapLen,
+                     &Entry->RxInfo, Worker->RxCtx->RxMsgId);
+      }
+      Worker->BusyUs += (uint32)(GetTimeUs() - StartUs);
+      Worker->MsgCnt++;
+
+      OS_MutSemTake(Worker->Mutex);
+      FreeEntry(Worker, Entry->EntryLen);
+      OS_MutSemGive(Worker->Mutex);
+
+   }
+   else
+   {
+      OS_TaskDelay(JMSG_UDP_RECONFIG_POLL_MS);
+   }
+
+   return true;
+
+} /* End JMSG_DECODE_WorkerTask() */
+
+
+/******************************************************************************
+** Function: AllocEntry
+**
+** Reserve an entry at the queue's head or return NULL if the queue is full.
+**
+** Notes:
+**   1. The caller must hold the queue's mutex.
+**   2. Entries before the head are unwrapped when the head is at or after
+**      the tail. A wrapped head stays strictly before the tail so a full
+**      ring is never mistaken for an empty one.
+**
+*/
+static JMSG_DECODE_Entry_t *AllocEntry(JMSG_DECODE_Worker_t *Worker, uint32 EntryLen)
+{
+
+   uint32 Pos;
+
+   if (Worker->Queued >= Decode->QueueDepth)
+   {
+      return NULL;
+   }
+
+   if (Worker->Head >= Worker->Tail)
+   {
+      if (Decode->QueueLen - Worker->Head >= EntryLen)
+      {
+         Pos = Worker->Head;
+      }
+      else if (EntryLen < Worker->Tail)
+      {
+         Worker->WrapAt = Worker->Head;
+         Pos = 0;
+      }
+      else
+      {
+         return NULL;
+      }
+   }
+   else if (Worker->Tail - Worker->Head > EntryLen)
+   {
+      Pos = Worker->Head;
+   }
+   else
+   {
+      return NULL;
+   }
+
+   Worker->Head = Pos + EntryLen;
+   Worker->Queued++;
+   if (Worker->Queued > Worker->HighWater)
+   {
+      Worker->HighWater = Worker->Queued;
+   }
+
+   return (JMSG_DECODE_Entry_t *)&Worker->Ring[Pos];
+
+} /* End AllocEntry() */
+
+
+/******************************************************************************
+** Function: FreeEntry
+**
+** Free the entry at the queue's tail.
+**
+** Notes:
+**   1. The caller must hold the queue's mutex.
+**   2. An empty queue restarts at the ring's start so long entries don't
+**      wrap needlessly.
+**
+*/
+static void FreeEntry(JMSG_DECODE_Worker_t *Worker, uint32 EntryLen)
+{
+
+   Worker->Queued--;
+   Worker->Tail += EntryLen;
+
+   if (Worker->Queued == 0)
+   {
+      Worker->Head   = 0;
+      Worker->Tail   = 0;
+      Worker->WrapAt = Decode->QueueLen;
+   }
+   else if (Worker->Tail >= Worker->WrapAt)
+   {
+      Worker->Tail   = 0;
+      Worker->WrapAt = Decode->QueueLen;
+   }
+
+} /* End FreeEntry() */
+
+
+/******************************************************************************
+** Function: GetTimeUs
+**
+*/
+static int64 GetTimeUs(void)
+{
+
+   OS_time_t LocalTime;
+
+   OS_GetLocalTime(&LocalTime);
+
+   return OS_TimeGetTotalMicroseconds(LocalTime);
+
+} /* End GetTimeUs() */
+
+
+/******************************************************************************
+** Function: HashTopic
+**
+** FNV-1a hash of a topic name.
+**
+*/
+static uint32 HashTopic(const char *Topic, uint16 TopicLen)
+{
+
+   uint32 Hash = FNV_OFFSET;
+   uint16 i;
+
+   for (i=0; i < TopicLen; i++)
+   {
+      Hash ^= (uint8)Topic[i];
+      Hash *= FNV_PRIME;
+   }
+
+   return Hash;
+
+} /* End HashTopic() */
+
+
+/******************************************************************************
+** Function: SendDropEvent
+**
+** Report a payload dropped because its worker's queue is full.
+**
+** Notes:
+**   1. The first drop is reported. Later drops are counted and reported
+**      with the topic of the latest drop once JMSG_DECODE_DROP_EVS_MS has
+**      passed so a full queue can't flood events. A clock that steps back
+**      restarts the interval.
+**
+*/
+static void SendDropEvent(JMSG_DECODE_Worker_t *Worker, uint16 WorkerIdx, const char *Topic, uint16 TopicLen)
+{
+
+   int64 NowUs = GetTimeUs();
+   int64 ElapsedUs = NowUs - Worker->DropEvsTimeUs;
+
+   Worker->DropEvsCnt++;
+
+   if (Worker->DropEvsTimeUs == 0 || ElapsedUs < 0 || ElapsedUs >= JMSG_DECODE_DROP_EVS_MS*1000)
+   {
+      CFE_EVS_SendEvent(JMSG_DECODE_DROP_EID, CFE_EVS_EventType_ERROR,
+                        "Dropped %u payloads, last topic %.*s, decode worker %u queue is full with %u entries",
+                        (unsigned int)Worker->DropEvsCnt, TopicLen, Topic, (unsigned int)WorkerIdx,
+                        (unsigned int)Worker->Queued);
+      Worker->DropEvsCnt    = 0;
+      Worker->DropEvsTimeUs = NowUs;
+   }
+
+} /* End SendDropEvent() */
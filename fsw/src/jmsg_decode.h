@@ -0,0 +1,250 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Decode Rx JMSG payloads on a pool of worker tasks sharded by topic
+**
+** Notes:
+**   1. The Rx task parses headers, reassembles fragments, acknowledges
+**      reliable messages, drops duplicates and decompresses payloads in
+**      arrival order. DECODE_WORKER_CNT worker tasks then route, scan and
+**      convert payloads and send the SB messages.
+**   2. A payload is queued to the worker selected by a hash of its topic
+**      name. A worker decodes its queue in order so messages of one topic
+**      reach the SB in arrival order while different topics are decoded in
+**      parallel.
+**   3. Each worker has a queue of DECODE_QUEUE_DEPTH entries in a ring of
+**      DECODE_QUEUE_LEN bytes. An entry holds a copy of the topic and
+**      payload so the Rx buffers can be reused as soon as it's queued. A
+**      payload that doesn't fit in its worker's queue is dropped and
+**      counted; the Rx task never waits for a worker. A drop event is sent
+**      at most once every JMSG_DECODE_DROP_EVS_MS with the number of
+**      payloads dropped since the previous event.
+**   4. Each worker has its own decoder context so scan indices, template
+**      messages and cached shapes aren't shared. Topic plugin conversions
+**      are serialized by the translator's converter lock because plugins
+**      may share buffers and state.
+**   5. A worker's utilization is the time it spent decoding over the
+**      status telemetry period.
+**   6. With zero workers, in single task mode or if the worker memory
+**      can't be allocated, payloads are decoded on the Rx task.
+**   7. Queue indices are protected by a queue's mutex. Counters are
+**      written by one task and read by the main task without a mutex like
+**      the other status counters.
+**   8. The SB message ID of a queued payload is only known once it's
+**      decoded so while capturing the entry also holds a copy of the Rx
+**      datagram and the worker records it after decoding the payload.
+**
+*/
+#ifndef _jmsg_decode_
+#define _jmsg_decode_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_hdr.h"
+#include "jmsg_trans.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_DECODE_INIT_EID   (JMSG_DECODE_BASE_EID + 0)
+#define JMSG_DECODE_START_EID  (JMSG_DECODE_BASE_EID + 1)
+#define JMSG_DECODE_DROP_EID   (JMSG_DECODE_BASE_EID + 2)
+
+#define JMSG_DECODE_DROP_EVS_MS  1000   /* Minimum time between drop events */
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef enum
+{
+
+   JMSG_DECODE_INLINE = 0,   /* No workers, the caller decodes the payload */
+   JMSG_DECODE_QUEUED,
+   JMSG_DECODE_FULL          /* The worker's queue is full, the payload was dropped */
+
+} JMSG_DECODE_Submit_t;
+
+
+/*
+** Queue entry header. The topic, payload and captured datagram follow it
+** and the entry is padded to an 8 byte boundary.
+*/
+typedef struct
+{
+
+   JMSG_SOCK_RxInfo_t  RxInfo;
+   JMSG_HDR_Attr_t     HdrAttr;
+   uint32              EntryLen;
+   uint16              PayloadLen;
+   uint16              CapLen;      /* Zero if the datagram isn't captured */
+
+} JMSG_DECODE_Entry_t;
+
+
+typedef struct
+{
+
+   CHILDMGR_Class_t  ChildMgr;
+
+   osal_id_t  Mutex;
+   osal_id_t  Sem;           /* Counts queued entries */
+
+   /*
+   ** Queue ring. Entries are written at Head and decoded from Tail. When
+   ** an entry doesn't fit at the end it's written at the start and WrapAt
+   ** marks where the entries before the wrap end.
+   */
+
+   char    *Ring;
+   uint32   Head;
+   uint32   Tail;
+   uint32   WrapAt;
+   uint16   Queued;
+   uint16   HighWater;
+
+   JMSG_TRANS_RxCtx_t  *RxCtx;
+
+   /*
+   ** Status
+   */
+
+   uint32   MsgCnt;
+   uint32   DropCnt;         /* Written by the Rx task */
+   uint32   DropEvsCnt;      /* Drops since the last drop event */
+   int64    DropEvsTimeUs;   /* Time of the last drop event, zero if none */
+   uint32   BusyUs;
+   uint32   PrevBusyUs;
+   uint16   BusyPerMille;    /* Computed by the main task */
+
+} JMSG_DECODE_Worker_t;
+
+
+typedef struct
+{
+
+   uint16   WorkerCnt;
+   uint16   QueueDepth;
+   uint32   QueueLen;
+   bool     Started;
+
+   int64    PrevTimeUs;
+
+   JMSG_DECODE_Worker_t  Worker[JMSG_UDP_PLATFORM_DECODE_WORKER_MAX];
+
+} JMSG_DECODE_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**    2. Worker memory is allocated here but the workers aren't started
+**       until JMSG_DECODE_StartWorkers() is called.
+**
+*/
+void JMSG_DECODE_Constructor(JMSG_DECODE_Class_t *DecodePtr, const INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_AddRxCnt
+**
+** Add the workers' decoder counters to the Rx task's counters.
+**
+*/
+void JMSG_DECODE_AddRxCnt(uint32 *ValidCnt, uint32 *InvalidCnt,
+                          uint32 *ShapeHitCnt, uint32 *ShapeMissCnt);
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_ResetStatus
+**
+** Reset counters and status flags to a known reset state.
+**
+*/
+void JMSG_DECODE_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_StartWorkers
+**
+** Create the worker child tasks.
+**
+** Notes:
+**   1. Returns false if a worker couldn't be created. Payloads of a worker
+**      that isn't running are decoded on the Rx task.
+**
+*/
+bool JMSG_DECODE_StartWorkers(const INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_Submit
+**
+** Queue a payload to its topic's worker.
+**
+** Notes:
+**   1. Topic is the message header, only HdrAttr->TopicLen bytes are read.
+**   2. Only called by the Rx task.
+**   3. CapData is the Rx datagram the payload came from. If the payload
+**      is queued the datagram is copied to the entry and captured by the
+**      worker after it decodes the payload. CapLen is zero if the datagram
+**      isn't captured.
+**
+*/
+JMSG_DECODE_Submit_t JMSG_DECODE_Submit(const JMSG_SOCK_RxInfo_t *RxInfo, const JMSG_HDR_Attr_t *HdrAttr,
+                                        const char *Topic, const char *Payload, uint16 PayloadLen,
+                                        const char *CapData, uint16 CapLen);
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_Update
+**
+** Compute the workers' utilization since the previous update.
+**
+*/
+void JMSG_DECODE_Update(void);
+
+
+/******************************************************************************
+** Function: JMSG_DECODE_WorkerTask
+**
+** Decode queued payloads.
+**
+** Notes:
+**   1. Child task callback, the worker is identified by its child manager.
+**
+*/
+bool JMSG_DECODE_WorkerTask(CHILDMGR_Class_t *ChildMgr);
+
+
+#endif /* _jmsg_decode_ */
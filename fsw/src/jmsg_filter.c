@@ -0,0 +1,508 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Predicate filters evaluated on binary SB message payloads
+**
+** Notes:
+**   1. See jmsg_filter.h
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jmsg_filter.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define OFFSET_STR_MAX  8
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static bool Compare(const JMSG_FILTER_Term_t *Term, const JMSG_FILTER_Value_t *Lhs,
+                    const JMSG_FILTER_Value_t *Rhs);
+static bool IsDelim(char Char);
+static bool ParseTerm(JMSG_FILTER_Term_t *Term, const char *Expr, uint16 ExprLen, uint16 *Pos,
+                      const JMSG_TMPL_Tmpl_t *Tmpl, const char **ErrStr);
+static void ReadField(const JMSG_FILTER_Term_t *Term, const uint8 *Payload, JMSG_FILTER_Value_t *Value);
+static bool ResolveField(JMSG_FILTER_Term_t *Term, const char *Name, uint16 NameLen,
+                         const JMSG_TMPL_Tmpl_t *Tmpl);
+static void SetOperand(JMSG_FILTER_Term_t *Term, const JMSG_TMPL_Number_t *Number);
+static void SkipWs(const char *Expr, uint16 ExprLen, uint16 *Pos);
+
+
+/******************************************************************************
+** Function: JMSG_FILTER_Compile
+**
+*/
+bool JMSG_FILTER_Compile(JMSG_FILTER_Filter_t *Filter, const char *Expr, uint16 ExprLen,
+                         const JMSG_TMPL_Tmpl_t *Tmpl, uint32 MsgId, const char **ErrStr)
+{
+
+   JMSG_FILTER_Term_t *Term;
+   const uint8 *Byte;
+   uint16 Pos = 0;
+   uint16 End;
+   char   Join = '\0';
+   uint32 i;
+
+   memset(Filter, 0, sizeof(JMSG_FILTER_Filter_t));
+   *ErrStr = NULL;
+
+   if (ExprLen == 0 || ExprLen >= JMSG_UDP_PLATFORM_FILTER_EXPR_MAX)
+   {
+      *ErrStr = "filter is empty or too long";
+      return false;
+   }
+
+   while (*ErrStr == NULL)
+   {
+      if (Filter->TermCnt >= JMSG_UDP_PLATFORM_FILTER_TERM_MAX)
+      {
+         *ErrStr = "filter has too many terms";
+         break;
+      }
+      Term = &Filter->Term[Filter->TermCnt++];
+      if (!ParseTerm(Term, Expr, ExprLen, &Pos, Tmpl, ErrStr))
+      {
+         break;
+      }
+
+      End = Term->Offset + JMSG_TMPL_TypeSize(Term->Type);
+      if (End > Filter->MinPayloadLen)
+      {
+         Filter->MinPayloadLen = End;
+      }
+
+      SkipWs(Expr, ExprLen, &Pos);
+      if (Pos >= ExprLen)
+      {
+         break;
+      }
+      if (Pos + 1 < ExprLen && Expr[Pos] == Expr[Pos+1] && (Expr[Pos] == '&' || Expr[Pos] == '|'))
+      {
+         if (Join != '\0' && Join != Expr[Pos])
+         {
+            *ErrStr = "filter mixes && and ||";
+         }
+         Join = Expr[Pos];
+         Pos += 2;
+      }
+      else
+      {
+         *ErrStr = "invalid filter join";
+      }
+   }
+
+   if (*ErrStr != NULL)
+   {
+      return false;
+   }
+
+   Filter->Any = (Join == '|');
+   memcpy(Filter->Expr, Expr, ExprLen);
+
+   Filter->Id = 2166136261u ^ MsgId;
+   Byte = (const uint8 *)Filter->Term;
+   for (i=0; i < Filter->TermCnt*sizeof(JMSG_FILTER_Term_t); i++)
+   {
+      Filter->Id = (Filter->Id ^ Byte[i]) * 16777619u;
+   }
+   Filter->Id ^= Filter->Any;
+
+   return true;
+
+} /* End JMSG_FILTER_Compile() */
+
+
+/******************************************************************************
+** Function: JMSG_FILTER_Eval
+**
+** Notes:
+**   1. Every term is evaluated, rather than stopping when the result is
+**      known, so each "prev" value is saved.
+**
+*/
+bool JMSG_FILTER_Eval(const JMSG_FILTER_Filter_t *Filter, JMSG_FILTER_Prev_t *Prev,
+                      const uint8 *Payload, size_t PayloadLen)
+{
+
+   const JMSG_FILTER_Term_t *Term;
+   JMSG_FILTER_Value_t Value[JMSG_UDP_PLATFORM_FILTER_TERM_MAX];
+   bool PrevValid = (Prev->Valid && Prev->Id == Filter->Id);
+   bool Pass = !Filter->Any;
+   bool TermPass;
+   uint8 i;
+
+   if (PayloadLen < Filter->MinPayloadLen)
+   {
+      return true;
+   }
+
+   for (i=0; i < Filter->TermCnt; i++)
+   {
+      Term = &Filter->Term[i];
+      ReadField(Term, Payload, &Value[i]);
+      if (Term->Prev)
+      {
+         TermPass = !PrevValid || Compare(Term, &Value[i], &Prev->Value[i]);
+      }
+      else
+      {
+         TermPass = Compare(Term, &Value[i], &Term->Value);
+      }
+      Pass = Filter->Any ? (Pass || TermPass) : (Pass && TermPass);
+   }
+
+   memcpy(Prev->Value, Value, Filter->TermCnt*sizeof(JMSG_FILTER_Value_t));
+   Prev->Id    = Filter->Id;
+   Prev->Valid = true;
+
+   return Pass;
+
+} /* End JMSG_FILTER_Eval() */
+
+
+/******************************************************************************
+** Function: Compare
+**
+** Notes:
+**   1. A NaN compares unequal to everything.
+**
+*/
+static bool Compare(const JMSG_FILTER_Term_t *Term, const JMSG_FILTER_Value_t *Lhs,
+                    const JMSG_FILTER_Value_t *Rhs)
+{
+
+   bool Lt;
+   bool Gt;
+   bool Eq;
+
+   switch (Term->Class)
+   {
+      case JMSG_FILTER_CLASS_INT:
+         Lt = Lhs->Int < Rhs->Int;
+         Gt = Lhs->Int > Rhs->Int;
+         Eq = Lhs->Int == Rhs->Int;
+         break;
+      case JMSG_FILTER_CLASS_UINT:
+         Lt = Lhs->Uint < Rhs->Uint;
+         Gt = Lhs->Uint > Rhs->Uint;
+         Eq = Lhs->Uint == Rhs->Uint;
+         break;
+      default:
+         Lt = Lhs->Real < Rhs->Real;
+         Gt = Lhs->Real > Rhs->Real;
+         Eq = Lhs->Real == Rhs->Real;
+         break;
+   }
+
+   switch (Term->Op)
+   {
+      case JMSG_FILTER_OP_EQ: return Eq;
+      case JMSG_FILTER_OP_NE: return !Eq;
+      case JMSG_FILTER_OP_LT: return Lt;
+      case JMSG_FILTER_OP_LE: return Lt || Eq;
+      case JMSG_FILTER_OP_GT: return Gt;
+      default:                return Gt || Eq;
+   }
+
+} /* End Compare() */
+
+
+/******************************************************************************
+** Function: IsDelim
+**
+** Return true if a character ends a field name or operand.
+**
+*/
+static bool IsDelim(char Char)
+{
+
+   return (Char == ' ' || Char == '\t' || Char == '=' || Char == '!' || Char == '<' ||
+           Char == '>' || Char == '&' || Char == '|');
+
+} /* End IsDelim() */
+
+
+/******************************************************************************
+** Function: ParseTerm
+**
+** Compile the "field op operand" term at Pos and advance Pos past it.
+**
+*/
+static bool ParseTerm(JMSG_FILTER_Term_t *Term, const char *Expr, uint16 ExprLen, uint16 *Pos,
+                      const JMSG_TMPL_Tmpl_t *Tmpl, const char **ErrStr)
+{
+
+   static const struct
+   {
+      const char *Str;
+      uint8       Op;
+   } OpDef[] =
+   {
+      /* Two character operators first so "<=" isn't read as "<" */
+      { "==", JMSG_FILTER_OP_EQ },
+      { "!=", JMSG_FILTER_OP_NE },
+      { "<=", JMSG_FILTER_OP_LE },
+      { ">=", JMSG_FILTER_OP_GE },
+      { "<",  JMSG_FILTER_OP_LT },
+      { ">",  JMSG_FILTER_OP_GT }
+   };
+   JMSG_TMPL_Number_t Number;
+   uint16 Start;
+   uint16 OpLen;
+   uint16 i;
+
+   SkipWs(Expr, ExprLen, Pos);
+   Start = *Pos;
+   while (*Pos < ExprLen && !IsDelim(Expr[*Pos]))
+   {
+      (*Pos)++;
+   }
+   if (!ResolveField(Term, &Expr[Start], *Pos - Start, Tmpl))
+   {
+      *ErrStr = "unknown filter field";
+      return false;
+   }
+
+   SkipWs(Expr, ExprLen, Pos);
+   for (i=0; i < sizeof(OpDef)/sizeof(OpDef[0]); i++)
+   {
+      OpLen = strlen(OpDef[i].Str);
+      if (*Pos + OpLen <= ExprLen && memcmp(&Expr[*Pos], OpDef[i].Str, OpLen) == 0)
+      {
+         Term->Op = OpDef[i].Op;
+         *Pos += OpLen;
+         break;
+      }
+   }
+   if (i == sizeof(OpDef)/sizeof(OpDef[0]))
+   {
+      *ErrStr = "invalid filter operator";
+      return false;
+   }
+
+   SkipWs(Expr, ExprLen, Pos);
+   Start = *Pos;
+   while (*Pos < ExprLen && !IsDelim(Expr[*Pos]))
+   {
+      (*Pos)++;
+   }
+   if ((*Pos - Start) == strlen(JMSG_FILTER_PREV_STR) &&
+       memcmp(&Expr[Start], JMSG_FILTER_PREV_STR, *Pos - Start) == 0)
+   {
+      Term->Prev = true;
+   }
+   else if (*Pos > Start && JMSG_TMPL_ParseNumber(&Expr[Start], *Pos - Start, &Number) == (*Pos - Start))
+   {
+      SetOperand(Term, &Number);
+   }
+   else
+   {
+      *ErrStr = "invalid filter operand";
+      return false;
+   }
+
+   return true;
+
+} /* End ParseTerm() */
+
+
+/******************************************************************************
+** Function: ReadField
+**
+** Read a term's field from a payload as the term's comparison class.
+**
+*/
+static void ReadField(const JMSG_FILTER_Term_t *Term, const uint8 *Payload, JMSG_FILTER_Value_t *Value)
+{
+
+   int64  Int = 0;
+   uint64 Uint = 0;
+   double Real = 0.0;
+   union
+   {
+      int8   I8;
+      uint8  U8;
+      int16  I16;
+      uint16 U16;
+      int32  I32;
+      uint32 U32;
+      int64  I64;
+      uint64 U64;
+      float  F32;
+      double F64;
+   } Field;
+
+   memcpy(&Field, &Payload[Term->Offset], JMSG_TMPL_TypeSize(Term->Type));
+
+   switch (Term->Type)
+   {
+      case JMSG_TMPL_TYPE_INT8:   Int  = Field.I8;  Real = Int;  break;
+      case JMSG_TMPL_TYPE_INT16:  Int  = Field.I16; Real = Int;  break;
+      case JMSG_TMPL_TYPE_INT32:  Int  = Field.I32; Real = Int;  break;
+      case JMSG_TMPL_TYPE_INT64:  Int  = Field.I64; Real = Int;  break;
+      case JMSG_TMPL_TYPE_UINT8:  Uint = Field.U8;  Real = Uint; break;
+      case JMSG_TMPL_TYPE_UINT16: Uint = Field.U16; Real = Uint; break;
+      case JMSG_TMPL_TYPE_UINT32: Uint = Field.U32; Real = Uint; break;
+      case JMSG_TMPL_TYPE_UINT64: Uint = Field.U64; Real = Uint; break;
+      case JMSG_TMPL_TYPE_FLOAT:  Real = Field.F32; break;
+      default:                    Real = Field.F64; break;
+   }
+
+   switch (Term->Class)
+   {
+      case JMSG_FILTER_CLASS_INT:  Value->Int  = Int;  break;
+      case JMSG_FILTER_CLASS_UINT: Value->Uint = Uint; break;
+      default:                     Value->Real = Real; break;
+   }
+
+} /* End ReadField() */
+
+
+/******************************************************************************
+** Function: ResolveField
+**
+** Set a term's field from a template key or a "type@offset" name and
+** default its comparison class to the field type's class.
+**
+*/
+static bool ResolveField(JMSG_FILTER_Term_t *Term, const char *Name, uint16 NameLen,
+                         const JMSG_TMPL_Tmpl_t *Tmpl)
+{
+
+   const char *At = memchr(Name, '@', NameLen);
+   const JMSG_TMPL_Field_t *Field;
+   char   OffsetStr[OFFSET_STR_MAX];
+   char   *End;
+   uint16 OffsetLen;
+   uint32 Offset;
+   uint16 i;
+
+   Term->Type = JMSG_TMPL_TYPE_UNDEF;
+
+   if (At != NULL)
+   {
+      OffsetLen = NameLen - (At - Name) - 1;
+      if (OffsetLen > 0 && OffsetLen < OFFSET_STR_MAX)
+      {
+         memcpy(OffsetStr, At + 1, OffsetLen);
+         OffsetStr[OffsetLen] = '\0';
+         Offset = strtoul(OffsetStr, &End, 0);
+         Term->Type = JMSG_TMPL_ParseType(Name, At - Name);
+         if (*End != '\0' || Term->Type == JMSG_TMPL_TYPE_UNDEF ||
+             Offset > (uint32)(0xFFFF - JMSG_TMPL_TypeSize(Term->Type)))
+         {
+            Term->Type = JMSG_TMPL_TYPE_UNDEF;
+         }
+         Term->Offset = (uint16)Offset;
+      }
+   }
+   else if (Tmpl != NULL)
+   {
+      for (i=0; i < Tmpl->FieldCnt; i++)
+      {
+         Field = &Tmpl->Field[i];
+         if (Field->KeyLen == NameLen && memcmp(&Tmpl->Text[Field->KeyPos], Name, NameLen) == 0)
+         {
+            Term->Type   = Field->Type;
+            Term->Offset = Field->Offset;
+            break;
+         }
+      }
+   }
+
+   switch (Term->Type)
+   {
+      case JMSG_TMPL_TYPE_INT8:
+      case JMSG_TMPL_TYPE_INT16:
+      case JMSG_TMPL_TYPE_INT32:
+      case JMSG_TMPL_TYPE_INT64:
+         Term->Class = JMSG_FILTER_CLASS_INT;
+         break;
+      case JMSG_TMPL_TYPE_UINT8:
+      case JMSG_TMPL_TYPE_UINT16:
+      case JMSG_TMPL_TYPE_UINT32:
+      case JMSG_TMPL_TYPE_UINT64:
+         Term->Class = JMSG_FILTER_CLASS_UINT;
+         break;
+      default:
+         Term->Class = JMSG_FILTER_CLASS_REAL;
+         break;
+   }
+
+   return (Term->Type != JMSG_TMPL_TYPE_UNDEF);
+
+} /* End ResolveField() */
+
+
+/******************************************************************************
+** Function: SetOperand
+**
+** Store a number operand in the term's comparison class.
+**
+** Notes:
+**   1. An integer field is compared as a double if the operand isn't an
+**      integer in the range of the field's class, e.g. "lux > 400.5" or
+**      "count > -1" for an unsigned count.
+**
+*/
+static void SetOperand(JMSG_FILTER_Term_t *Term, const JMSG_TMPL_Number_t *Number)
+{
+
+   if (Term->Class == JMSG_FILTER_CLASS_INT && Number->IsInt &&
+       Number->Mag <= ((uint64)1 << 63) - (Number->Neg ? 0 : 1))
+   {
+      Term->Value.Int = Number->Neg ? (int64)((uint64)0 - Number->Mag) : (int64)Number->Mag;
+   }
+   else if (Term->Class == JMSG_FILTER_CLASS_UINT && Number->IsInt &&
+            (!Number->Neg || Number->Mag == 0))
+   {
+      Term->Value.Uint = Number->Mag;
+   }
+   else
+   {
+      Term->Class      = JMSG_FILTER_CLASS_REAL;
+      Term->Value.Real = Number->Real;
+   }
+
+} /* End SetOperand() */
+
+
+/******************************************************************************
+** Function: SkipWs
+**
+*/
+static void SkipWs(const char *Expr, uint16 ExprLen, uint16 *Pos)
+{
+
+   while (*Pos < ExprLen && (Expr[*Pos] == ' ' || Expr[*Pos] == '\t'))
+   {
+      (*Pos)++;
+   }
+
+} /* End SkipWs() */
@@ -0,0 +1,170 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Predicate filters evaluated on binary SB message payloads
+**
+** Notes:
+**   1. A filter is a route table expression of up to
+**      JMSG_UDP_PLATFORM_FILTER_TERM_MAX terms joined by "&&" or "||",
+**      e.g. "lux > 400 && mode != prev". Both joins can't be used in one
+**      filter.
+**   2. A term is "field op operand". The field is a key of the route's
+**      template or "type@offset", e.g. "uint16@12", with the template
+**      types and payload offsets. The op is ==, !=, <, <=, > or >=. The
+**      operand is a JSON number or "prev", the field's value in the
+**      previous message of the route.
+**   3. Filters are compiled with the route table so a Tx message is
+**      accepted or rejected from its payload before it's converted to
+**      JSON. Integer fields are compared as integers with integer
+**      operands and as doubles otherwise.
+**   4. A "prev" term is true for a route's first message, so the first
+**      value is always sent, and after the filter changes. Each message's
+**      values are kept for the next comparison whether or not it passed.
+**   5. A payload that is too short for a filter's fields passes so the
+**      converter reports it.
+**
+*/
+#ifndef _jmsg_filter_
+#define _jmsg_filter_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_tmpl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_FILTER_PREV_STR  "prev"
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef enum
+{
+
+   JMSG_FILTER_OP_EQ = 0,
+   JMSG_FILTER_OP_NE,
+   JMSG_FILTER_OP_LT,
+   JMSG_FILTER_OP_LE,
+   JMSG_FILTER_OP_GT,
+   JMSG_FILTER_OP_GE
+
+} JMSG_FILTER_Op_t;
+
+
+typedef enum
+{
+
+   JMSG_FILTER_CLASS_INT = 0,
+   JMSG_FILTER_CLASS_UINT,
+   JMSG_FILTER_CLASS_REAL
+
+} JMSG_FILTER_Class_t;
+
+
+typedef union
+{
+
+   int64   Int;
+   uint64  Uint;
+   double  Real;
+
+} JMSG_FILTER_Value_t;
+
+
+typedef struct
+{
+
+   uint16  Offset;   /* Payload byte offset of the field */
+   uint8   Type;     /* JMSG_TMPL_Type_t */
+   uint8   Class;    /* JMSG_FILTER_Class_t the field is compared as */
+   uint8   Op;       /* JMSG_FILTER_Op_t */
+   bool    Prev;     /* Compared with the previous message's value */
+
+   JMSG_FILTER_Value_t  Value;
+
+} JMSG_FILTER_Term_t;
+
+
+typedef struct
+{
+
+   uint8   TermCnt;
+   bool    Any;             /* Terms joined by || */
+   uint16  MinPayloadLen;   /* Shortest payload holding every field */
+   uint32  Id;              /* Hash identifying the filter and its route */
+
+   JMSG_FILTER_Term_t  Term[JMSG_UDP_PLATFORM_FILTER_TERM_MAX];
+
+   char    Expr[JMSG_UDP_PLATFORM_FILTER_EXPR_MAX];
+
+} JMSG_FILTER_Filter_t;
+
+
+/*
+** Field values of a route's previous message
+*/
+typedef struct
+{
+
+   uint32  Id;      /* Filter the values were read for */
+   bool    Valid;
+
+   JMSG_FILTER_Value_t  Value[JMSG_UDP_PLATFORM_FILTER_TERM_MAX];
+
+} JMSG_FILTER_Prev_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_FILTER_Compile
+**
+** Compile a filter expression for a route with an optional template.
+**
+** Notes:
+**   1. Tmpl is NULL if the route doesn't have a template.
+**   2. MsgId is hashed into the filter's ID so routes with the same
+**      expression don't share previous values.
+**   3. Returns false and sets ErrStr if the expression is invalid.
+**
+*/
+bool JMSG_FILTER_Compile(JMSG_FILTER_Filter_t *Filter, const char *Expr, uint16 ExprLen,
+                         const JMSG_TMPL_Tmpl_t *Tmpl, uint32 MsgId, const char **ErrStr);
+
+
+/******************************************************************************
+** Function: JMSG_FILTER_Eval
+**
+** Return true if a SB message payload passes a filter and save its field
+** values in Prev.
+**
+*/
+bool JMSG_FILTER_Eval(const JMSG_FILTER_Filter_t *Filter, JMSG_FILTER_Prev_t *Prev,
+                      const uint8 *Payload, size_t PayloadLen);
+
+
+#endif /* _jmsg_filter_ */
@@ -0,0 +1,380 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Fragment and reassemble JMSGs larger than one datagram
+**
+** Notes:
+**   1. See jmsg_frag.h
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "jmsg_frag.h"
+#include "jmsg_mem.h"
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static void ExpireRx(int64 NowMs);
+static uint16 FindRx(const JMSG_SOCK_RxInfo_t *RxInfo, uint32 Id, uint16 FragCnt, int64 NowMs);
+static int64 GetTimeMs(void);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_FRAG_Class_t *Frag = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_FRAG_Constructor
+**
+*/
+void JMSG_FRAG_Constructor(JMSG_FRAG_Class_t *FragPtr, const INITBL_Class_t *IniTbl,
+                           JMSG_FRAG_SendMsg_t SendMsg)
+{
+
+   uint16 i;
+   uint32 PoolCnt = INITBL_GetIntConfig(IniTbl, CFG_FRAG_POOL_CNT);
+
+   Frag = FragPtr;
+
+   CFE_PSP_MemSet((void*)Frag, 0, sizeof(JMSG_FRAG_Class_t));
+
+   Frag->SendMsg     = SendMsg;
+   Frag->TimeoutMs   = INITBL_GetIntConfig(IniTbl, CFG_FRAG_TIMEOUT_MS);
+   Frag->DatagramLen = JMSG_MEM_GetDatagramLen();
+
+   if (JMSG_MEM_GetFragCnt() < 2)
+   {
+      return;
+   }
+   Frag->FragCntMax = JMSG_MEM_GetFragCnt();
+   if (PoolCnt > JMSG_UDP_PLATFORM_FRAG_POOL_MAX)
+   {
+      PoolCnt = JMSG_UDP_PLATFORM_FRAG_POOL_MAX;
+   }
+
+   Frag->TxFrag = JMSG_MEM_Alloc(JMSG_MEM_USER_FRAG, Frag->DatagramLen);
+   if (Frag->TxFrag == NULL)
+   {
+      Frag->FragCntMax = 0;
+      return;
+   }
+
+   for (i=0; i < PoolCnt; i++)
+   {
+      Frag->RxMsg[i].Buf = JMSG_MEM_Alloc(JMSG_MEM_USER_FRAG, Frag->FragCntMax * Frag->DatagramLen);
+      if (Frag->RxMsg[i].Buf == NULL)
+      {
+         break;
+      }
+   }
+   Frag->PoolCnt = i;
+
+} /* End JMSG_FRAG_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_FRAG_AddRx
+**
+** Notes:
+**   1. A duplicate fragment is ignored. A fragment whose count doesn't match
+**      the message it belongs to is dropped.
+**
+*/
+const char *JMSG_FRAG_AddRx(const JMSG_SOCK_RxInfo_t *RxInfo, const JMSG_HDR_Attr_t *Attr,
+                            const char *Slice, uint16 SliceLen, uint16 *MsgLen, uint16 *RxMsgIdx)
+{
+
+   JMSG_FRAG_RxMsg_t *RxMsg;
+   int64  NowMs = GetTimeMs();
+   uint16 Idx;
+   uint16 i;
+   uint32 Len;
+
+   *MsgLen   = 0;
+   *RxMsgIdx = JMSG_FRAG_UNDEF_IDX;
+
+   Frag->RxFragCnt++;
+   ExpireRx(NowMs);
+
+   if (Attr->FragCnt > Frag->FragCntMax || SliceLen > Frag->DatagramLen)
+   {
+      Frag->RxDropCnt++;
+      CFE_EVS_SendEvent(JMSG_FRAG_RX_EID, CFE_EVS_EventType_ERROR,
+                        "Dropped fragment %u of message %u with %u fragments, limit is %d",
+                        (unsigned int)Attr->FragIdx, (unsigned int)Attr->FragId,
+                        (unsigned int)Attr->FragCnt, Frag->FragCntMax);
+      return NULL;
+   }
+
+   Idx = FindRx(RxInfo, Attr->FragId, Attr->FragCnt, NowMs);
+   if (Idx == JMSG_FRAG_UNDEF_IDX)
+   {
+      Frag->RxDropCnt++;
+      CFE_EVS_SendEvent(JMSG_FRAG_RX_EID, CFE_EVS_EventType_ERROR,
+                        "Dropped fragment %u of message %u, reassembly pool full or count mismatch",
+                        (unsigned int)Attr->FragIdx, (unsigned int)Attr->FragId);
+      return NULL;
+   }
+
+   RxMsg = &Frag->RxMsg[Idx];
+   if ((RxMsg->RcvdMask & (1u << Attr->FragIdx)) == 0)
+   {
+      memcpy(&RxMsg->Buf[Attr->FragIdx * Frag->DatagramLen], Slice, SliceLen);
+      RxMsg->FragLen[Attr->FragIdx] = SliceLen;
+      RxMsg->RcvdMask |= (1u << Attr->FragIdx);
+      RxMsg->RcvdCnt++;
+   }
+
+   if (RxMsg->RcvdCnt < RxMsg->FragCnt)
+   {
+      return NULL;
+   }
+
+   /* Close the gaps between fragments, fragment 0 is already in place */
+   Len = RxMsg->FragLen[0];
+   for (i=1; i < RxMsg->FragCnt; i++)
+   {
+      memmove(&RxMsg->Buf[Len], &RxMsg->Buf[i * Frag->DatagramLen], RxMsg->FragLen[i]);
+      Len += RxMsg->FragLen[i];
+   }
+
+   if (Len > 0xFFFF)
+   {
+      Frag->RxDropCnt++;
+      JMSG_FRAG_ReleaseRx(Idx);
+      return NULL;
+   }
+
+   Frag->RxMsgCnt++;
+   *MsgLen   = (uint16)Len;
+   *RxMsgIdx = Idx;
+
+   return RxMsg->Buf;
+
+} /* End JMSG_FRAG_AddRx() */
+
+
+/******************************************************************************
+** Function: JMSG_FRAG_ReleaseRx
+**
+*/
+void JMSG_FRAG_ReleaseRx(uint16 RxMsgIdx)
+{
+
+   if (RxMsgIdx < Frag->PoolCnt && Frag->RxMsg[RxMsgIdx].InUse)
+   {
+      Frag->RxMsg[RxMsgIdx].InUse = false;
+      Frag->RxPendingCnt--;
+   }
+
+} /* End JMSG_FRAG_ReleaseRx() */
+
+
+/******************************************************************************
+** Function: JMSG_FRAG_ResetStatus
+**
+*/
+void JMSG_FRAG_ResetStatus(void)
+{
+
+   Frag->TxMsgCnt     = 0;
+   Frag->TxFragCnt    = 0;
+   Frag->TxErrCnt     = 0;
+   Frag->RxMsgCnt     = 0;
+   Frag->RxFragCnt    = 0;
+   Frag->RxTimeoutCnt = 0;
+   Frag->RxDropCnt    = 0;
+
+} /* End JMSG_FRAG_ResetStatus() */
+
+
+/******************************************************************************
+** Function: JMSG_FRAG_Send
+**
+** Notes:
+**   1. Every slice except the last has the same length. It's sized for the
+**      longest fragment header the message can have.
+**
+*/
+bool JMSG_FRAG_Send(const char *Topic, const char *Msg, uint32 MsgLen)
+{
+
+   bool   RetStatus = true;
+   int    HdrLen;
+   uint32 SliceLen;
+   uint32 FragCnt;
+   uint32 FragIdx;
+   uint32 Offset;
+   uint32 Len;
+   uint32 Id = ++Frag->TxId;
+
+   if (Frag->FragCntMax < 2)
+   {
+      Frag->TxErrCnt++;
+      CFE_EVS_SendEvent(JMSG_FRAG_TX_EID, CFE_EVS_EventType_ERROR,
+                        "Tx message for topic %s exceeds the %u byte datagram length and fragmentation is disabled",
+                        Topic, (unsigned int)Frag->DatagramLen);
+      return false;
+   }
+
+   HdrLen = snprintf(Frag->TxFrag, Frag->DatagramLen, "%s%cf=%u.%u.%u:", Topic, JMSG_HDR_ATTR_SEP,
+                     (unsigned int)Id, Frag->FragCntMax - 1, Frag->FragCntMax);
+   SliceLen = (HdrLen < (int)Frag->DatagramLen) ? (Frag->DatagramLen - HdrLen) : 1;
+   FragCnt  = (MsgLen + SliceLen - 1) / SliceLen;
+
+   if (FragCnt > Frag->FragCntMax)
+   {
+      Frag->TxErrCnt++;
+      CFE_EVS_SendEvent(JMSG_FRAG_TX_EID, CFE_EVS_EventType_ERROR,
+                        "Tx message for topic %s needs %u fragments, limit is %d",
+                        Topic, (unsigned int)FragCnt, Frag->FragCntMax);
+      return false;
+   }
+
+   for (FragIdx=0, Offset=0; FragIdx < FragCnt; FragIdx++, Offset += SliceLen)
+   {
+      Len = (MsgLen - Offset < SliceLen) ? (MsgLen - Offset) : SliceLen;
+      HdrLen = snprintf(Frag->TxFrag, Frag->DatagramLen, "%s%cf=%u.%u.%u:", Topic, JMSG_HDR_ATTR_SEP,
+                        (unsigned int)Id, (unsigned int)FragIdx, (unsigned int)FragCnt);
+      memcpy(&Frag->TxFrag[HdrLen], &Msg[Offset], Len);
+      if (Frag->SendMsg(Frag->TxFrag, HdrLen + Len, NULL))
+      {
+         Frag->TxFragCnt++;
+      }
+      else
+      {
+         RetStatus = false;
+      }
+   }
+
+   if (RetStatus)
+   {
+      Frag->TxMsgCnt++;
+   }
+   else
+   {
+      Frag->TxErrCnt++;
+   }
+
+   return RetStatus;
+
+} /* End JMSG_FRAG_Send() */
+
+
+/******************************************************************************
+** Function: ExpireRx
+**
+** Discard messages that haven't completed within the timeout.
+**
+*/
+static void ExpireRx(int64 NowMs)
+{
+
+   uint16 i;
+   JMSG_FRAG_RxMsg_t *RxMsg;
+
+   for (i=0; i < Frag->PoolCnt && Frag->RxPendingCnt > 0; i++)
+   {
+      RxMsg = &Frag->RxMsg[i];
+      if (RxMsg->InUse && (NowMs - RxMsg->StartMs) > Frag->TimeoutMs)
+      {
+         CFE_EVS_SendEvent(JMSG_FRAG_RX_EID, CFE_EVS_EventType_ERROR,
+                           "Discarded message %u from 0x%08X:%d, received %d of %d fragments",
+                           (unsigned int)RxMsg->Id, (unsigned int)RxMsg->PeerAddr, RxMsg->PeerPort,
+                           RxMsg->RcvdCnt, RxMsg->FragCnt);
+         Frag->RxTimeoutCnt++;
+         JMSG_FRAG_ReleaseRx(i);
+      }
+   }
+
+} /* End ExpireRx() */
+
+
+/******************************************************************************
+** Function: FindRx
+**
+** Return the pool index of a message, starting a new one if needed.
+** Returns JMSG_FRAG_UNDEF_IDX if the pool is full or the fragment count
+** doesn't match.
+**
+*/
+static uint16 FindRx(const JMSG_SOCK_RxInfo_t *RxInfo, uint32 Id, uint16 FragCnt, int64 NowMs)
+{
+
+   uint16 i;
+   uint16 FreeIdx = JMSG_FRAG_UNDEF_IDX;
+   JMSG_FRAG_RxMsg_t *RxMsg;
+
+   for (i=0; i < Frag->PoolCnt; i++)
+   {
+      RxMsg = &Frag->RxMsg[i];
+      if (RxMsg->InUse)
+      {
+         if (RxMsg->Id == Id && RxMsg->PeerAddr == RxInfo->PeerAddr && RxMsg->PeerPort == RxInfo->PeerPort)
+         {
+            return (RxMsg->FragCnt == FragCnt) ? i : JMSG_FRAG_UNDEF_IDX;
+         }
+      }
+      else if (FreeIdx == JMSG_FRAG_UNDEF_IDX)
+      {
+         FreeIdx = i;
+      }
+   }
+
+   if (FreeIdx != JMSG_FRAG_UNDEF_IDX)
+   {
+      RxMsg = &Frag->RxMsg[FreeIdx];
+      RxMsg->InUse    = true;
+      RxMsg->PeerAddr = RxInfo->PeerAddr;
+      RxMsg->PeerPort = RxInfo->PeerPort;
+      RxMsg->Id       = Id;
+      RxMsg->FragCnt  = FragCnt;
+      RxMsg->RcvdCnt  = 0;
+      RxMsg->RcvdMask = 0;
+      RxMsg->StartMs  = NowMs;
+      Frag->RxPendingCnt++;
+   }
+
+   return FreeIdx;
+
+} /* End FindRx() */
+
+
+/******************************************************************************
+** Function: GetTimeMs
+**
+*/
+static int64 GetTimeMs(void)
+{
+
+   OS_time_t LocalTime;
+
+   OS_GetLocalTime(&LocalTime);
+
+   return OS_TimeGetTotalMilliseconds(LocalTime);
+
+} /* End GetTimeMs() */
@@ -0,0 +1,189 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Fragment and reassemble JMSGs larger than one datagram
+**
+** Notes:
+**   1. A JMSG longer than DATAGRAM_LEN is split into datagrams of the
+**      form "topic;f=id.index.count:slice". The slices concatenated in index
+**      order are the original JMSG, header included. Fragment IDs are
+**      assigned per gateway and identify a message per sender.
+**   2. Rx fragments are reassembled in a pool of FRAG_POOL_CNT messages. Each
+**      slot holds up to FRAG_CNT fragments. The pool is allocated from the
+**      memory arena at startup so its size follows the INI table, the
+**      platform limits only bound it. A message that isn't complete
+**      within FRAG_TIMEOUT_MS is discarded. Fragments of a new message are
+**      dropped while the pool is full so messages already in progress can
+**      complete.
+**   3. The Tx functions are only called by the Tx task and the Rx functions
+**      by the Rx task.
+**
+*/
+#ifndef _jmsg_frag_
+#define _jmsg_frag_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_hdr.h"
+#include "jmsg_sock.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_FRAG_UNDEF_IDX  0xFFFF
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_FRAG_TX_EID  (JMSG_FRAG_BASE_EID + 0)
+#define JMSG_FRAG_RX_EID  (JMSG_FRAG_BASE_EID + 1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Callback that sends one fragment to the Tx destination
+*/
+typedef bool (*JMSG_FRAG_SendMsg_t)(const char *Msg, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *Peer);
+
+
+typedef struct
+{
+
+   bool    InUse;
+   uint32  PeerAddr;
+   uint16  PeerPort;
+   uint32  Id;
+   uint16  FragCnt;
+   uint16  RcvdCnt;
+   uint32  RcvdMask;
+   int64   StartMs;
+   uint16  FragLen[JMSG_UDP_PLATFORM_FRAG_CNT_MAX];
+   char    *Buf;  /* Fragment n is stored at n*DatagramLen */
+
+} JMSG_FRAG_RxMsg_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Framework References
+   */
+
+   JMSG_FRAG_SendMsg_t  SendMsg;
+
+   /*
+   ** Configuration
+   */
+
+   uint32  TimeoutMs;
+   uint32  DatagramLen;
+   uint16  FragCntMax;
+   uint16  PoolCnt;       /* Reassembly slots that were allocated */
+
+   /*
+   ** State
+   */
+
+   uint32  TxId;
+   uint32  TxMsgCnt;
+   uint32  TxFragCnt;
+   uint32  TxErrCnt;
+
+   uint32  RxMsgCnt;
+   uint32  RxFragCnt;
+   uint32  RxTimeoutCnt;
+   uint32  RxDropCnt;     /* Pool full or inconsistent fragment */
+   uint16  RxPendingCnt;
+
+   char    *TxFrag;
+
+   JMSG_FRAG_RxMsg_t  RxMsg[JMSG_UDP_PLATFORM_FRAG_POOL_MAX];
+
+} JMSG_FRAG_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_FRAG_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**    2. The buffers are allocated from the memory arena which must be
+**       constructed first. Fragmentation is disabled when FRAG_CNT is less
+**       than 2 and the pool is reduced if the arena is exhausted.
+**
+*/
+void JMSG_FRAG_Constructor(JMSG_FRAG_Class_t *FragPtr, const INITBL_Class_t *IniTbl,
+                           JMSG_FRAG_SendMsg_t SendMsg);
+
+
+/******************************************************************************
+** Function: JMSG_FRAG_AddRx
+**
+** Add a received fragment to its message.
+**
+** Notes:
+**   1. Returns the reassembled JMSG when the fragment completes it and NULL
+**      otherwise. The caller must pass RxMsgIdx to JMSG_FRAG_ReleaseRx()
+**      when it's done with the message.
+**
+*/
+const char *JMSG_FRAG_AddRx(const JMSG_SOCK_RxInfo_t *RxInfo, const JMSG_HDR_Attr_t *Attr,
+                            const char *Slice, uint16 SliceLen, uint16 *MsgLen, uint16 *RxMsgIdx);
+
+
+/******************************************************************************
+** Function: JMSG_FRAG_ReleaseRx
+**
+*/
+void JMSG_FRAG_ReleaseRx(uint16 RxMsgIdx);
+
+
+/******************************************************************************
+** Function: JMSG_FRAG_ResetStatus
+**
+*/
+void JMSG_FRAG_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: JMSG_FRAG_Send
+**
+** Split a JMSG into fragments and send them.
+**
+** Notes:
+**   1. Returns false if the message needs more than FRAG_CNT fragments or
+**      a send fails.
+**
+*/
+bool JMSG_FRAG_Send(const char *Topic, const char *Msg, uint32 MsgLen);
+
+
+#endif /* _jmsg_frag_ */
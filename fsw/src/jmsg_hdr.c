@@ -0,0 +1,166 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Parse JMSG header attributes
+**
+** Notes:
+**   1. See jmsg_hdr.h
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_hdr.h"
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static bool ParseFrag(JMSG_HDR_Attr_t *Attr, const char *Str, uint16 Len);
+static bool ParseUint32(const char *Str, uint16 Len, uint32 *Value);
+
+
+/******************************************************************************
+** Function: JMSG_HDR_Parse
+**
+*/
+bool JMSG_HDR_Parse(JMSG_HDR_Attr_t *Attr, const char *Hdr, uint16 HdrLen)
+{
+
+   bool  RetStatus = true;
+   const char *Sep;
+   const char *AttrStr;
+   const char *AttrEnd;
+   const char *HdrEnd = Hdr + HdrLen;
+   uint16 AttrLen;
+
+   memset(Attr, 0, sizeof(JMSG_HDR_Attr_t));
+
+   Sep = memchr(Hdr, JMSG_HDR_ATTR_SEP, HdrLen);
+   Attr->TopicLen = (Sep == NULL) ? HdrLen : (uint16)(Sep - Hdr);
+
+   while (Sep != NULL && RetStatus)
+   {
+
+      AttrStr = Sep + 1;
+      Sep     = memchr(AttrStr, JMSG_HDR_ATTR_SEP, HdrEnd - AttrStr);
+      AttrEnd = (Sep == NULL) ? HdrEnd : Sep;
+      AttrLen = AttrEnd - AttrStr;
+
+      if (AttrLen >= 2 && AttrStr[1] == '=')
+      {
+         switch (AttrStr[0])
+         {
+            case 'r':
+               Attr->Reliable = true;
+               /* Fall through */
+            case 's':
+               Attr->SeqValid = ParseUint32(&AttrStr[2], AttrLen - 2, &Attr->Seq);
+               RetStatus = Attr->SeqValid;
+               break;
+            case 'a':
+               Attr->AckValid = ParseUint32(&AttrStr[2], AttrLen - 2, &Attr->Ack);
+               RetStatus = Attr->AckValid;
+               break;
+            case 'f':
+               Attr->FragValid = ParseFrag(Attr, &AttrStr[2], AttrLen - 2);
+               RetStatus = Attr->FragValid;
+               break;
+            case 'z':
+               Attr->ZipValid = ParseUint32(&AttrStr[2], AttrLen - 2, &Attr->ZipLen);
+               RetStatus = Attr->ZipValid;
+               break;
+            case 't':
+               Attr->TestValid = ParseUint32(&AttrStr[2], AttrLen - 2, &Attr->Test);
+               RetStatus = Attr->TestValid;
+               break;
+            default:
+               break;
+         }
+      }
+
+   } /* End attribute loop */
+
+   return RetStatus;
+
+} /* End JMSG_HDR_Parse() */
+
+
+/******************************************************************************
+** Function: ParseFrag
+**
+** Parse a fragment's "id.index.count" value.
+**
+*/
+static bool ParseFrag(JMSG_HDR_Attr_t *Attr, const char *Str, uint16 Len)
+{
+
+   const char *Dot1 = memchr(Str, '.', Len);
+   const char *Dot2;
+   const char *End = Str + Len;
+
+   if (Dot1 == NULL)
+   {
+      return false;
+   }
+
+   Dot2 = memchr(Dot1 + 1, '.', End - (Dot1 + 1));
+   if (Dot2 == NULL)
+   {
+      return false;
+   }
+
+   return (ParseUint32(Str, Dot1 - Str, &Attr->FragId) &&
+           ParseUint32(Dot1 + 1, Dot2 - (Dot1 + 1), &Attr->FragIdx) &&
+           ParseUint32(Dot2 + 1, End - (Dot2 + 1), &Attr->FragCnt) &&
+           Attr->FragIdx < Attr->FragCnt);
+
+} /* End ParseFrag() */
+
+
+/******************************************************************************
+** Function: ParseUint32
+**
+*/
+static bool ParseUint32(const char *Str, uint16 Len, uint32 *Value)
+{
+
+   uint64 Number = 0;
+   uint16 i;
+
+   if (Len == 0 || Len > 10)
+   {
+      return false;
+   }
+
+   for (i=0; i < Len; i++)
+   {
+      if (Str[i] < '0' || Str[i] > '9')
+      {
+         return false;
+      }
+      Number = Number*10 + (Str[i] - '0');
+   }
+
+   *Value = (uint32)Number;
+
+   return (Number <= 0xFFFFFFFFULL);
+
+} /* End ParseUint32() */
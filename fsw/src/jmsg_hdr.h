@@ -0,0 +1,110 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Parse JMSG header attributes
+**
+** Notes:
+**   1. A JMSG is "header:payload" where the header is a topic name
+**      optionally followed by ';' separated key=value attributes, for
+**      example "basecamp/demo;s=42:{...}". Messages without attributes are
+**      unchanged from the original "topic:payload" format.
+**   2. Attribute keys:
+**        s  Per-topic sequence number, decimal uint32
+**        r  Reliable per-topic sequence number. The receiver acknowledges
+**           it and otherwise treats it like "s".
+**        a  Acknowledges the reliable sequence number of a topic. An ack
+**           has an empty payload, for example "basecamp/cmd;a=42:".
+**        f  Fragment "id.index.count" of a message too large for one
+**           datagram. The fragment payloads are concatenated in index order
+**           to rebuild the original message, including its header.
+**        z  Decimal length of the payload before it was compressed. The
+**           payload is an LZ4 block, see jmsg_lz.h.
+**        c  Age in milliseconds of a cached value returned by a query, see
+**           jmsg_lvc.h. Receivers treat it as informational.
+**        t  Self-test message index, decimal uint32. A running test's
+**           message is translated but not sent on the SB, the attribute
+**           is ignored on other messages, see jmsg_selftest.h.
+**   3. Unknown keys are ignored so newer senders interoperate with older
+**      gateways.
+**
+*/
+#ifndef _jmsg_hdr_
+#define _jmsg_hdr_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_HDR_ATTR_SEP  ';'
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   uint16  TopicLen;
+
+   bool    SeqValid;
+   bool    Reliable;   /* Seq came from "r" */
+   uint32  Seq;
+
+   bool    AckValid;
+   uint32  Ack;
+
+   bool    FragValid;
+   uint32  FragId;
+   uint32  FragIdx;
+   uint32  FragCnt;
+
+   bool    ZipValid;
+   uint32  ZipLen;
+
+   bool    TestValid;
+   uint32  Test;
+
+} JMSG_HDR_Attr_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_HDR_Parse
+**
+** Split a header into its topic name length and attributes.
+**
+** Notes:
+**   1. Hdr is the text preceding the payload separator and does not need to
+**      be null terminated.
+**   2. Returns false if a known attribute has an invalid value.
+**
+*/
+bool JMSG_HDR_Parse(JMSG_HDR_Attr_t *Attr, const char *Hdr, uint16 HdrLen);
+
+
+#endif /* _jmsg_hdr_ */
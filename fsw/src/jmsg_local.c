@@ -0,0 +1,303 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Send Tx JMSGs to processes on the same host without the IP stack
+**
+** Notes:
+**   1. See jmsg_local.h
+**   2. The ring's head is stored with release ordering after the record is
+**      written so a consumer that loads it with acquire ordering sees the
+**      whole record.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_local.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define JMSG_LOCAL_NATIVE
+#endif
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define SHM_REC_LEN(Len)  ((sizeof(JMSG_LOCAL_ShmRec_t) + (Len) + JMSG_LOCAL_SHM_ALIGN - 1) & ~(JMSG_LOCAL_SHM_ALIGN - 1))
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+#ifdef JMSG_LOCAL_NATIVE
+static void OpenShm(uint32 ShmLen);
+static void OpenUnix(void);
+static void PublishShm(const char *Msg, uint32 MsgLen);
+#endif
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_LOCAL_Class_t *JMsgLocal = NULL;
+
+#ifdef JMSG_LOCAL_NATIVE
+static struct sockaddr_un TxAddr;
+#endif
+
+
+/******************************************************************************
+** Function: JMSG_LOCAL_Constructor
+**
+*/
+void JMSG_LOCAL_Constructor(JMSG_LOCAL_Class_t *LocalPtr, const INITBL_Class_t *IniTbl)
+{
+
+   JMsgLocal = LocalPtr;
+
+   memset(JMsgLocal, 0, sizeof(JMSG_LOCAL_Class_t));
+   JMsgLocal->TxFd = -1;
+
+   strncpy(JMsgLocal->TxPath, INITBL_GetStrConfig(IniTbl, CFG_LOCAL_TX_PATH), JMSG_SOCK_LOCAL_PATH_LEN - 1);
+   strncpy(JMsgLocal->ShmName, INITBL_GetStrConfig(IniTbl, CFG_LOCAL_SHM_NAME), JMSG_LOCAL_SHM_NAME_LEN - 1);
+
+#ifdef JMSG_LOCAL_NATIVE
+   if (JMsgLocal->TxPath[0] != '\0')
+   {
+      OpenUnix();
+   }
+   if (JMsgLocal->ShmName[0] != '\0')
+   {
+      OpenShm(INITBL_GetIntConfig(IniTbl, CFG_LOCAL_SHM_LEN));
+   }
+#else
+   if (JMsgLocal->TxPath[0] != '\0' || JMsgLocal->ShmName[0] != '\0')
+   {
+      CFE_EVS_SendEvent(JMSG_LOCAL_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Local transports are only supported on Linux, LOCAL_TX_PATH and LOCAL_SHM_NAME ignored");
+   }
+#endif
+
+} /* End JMSG_LOCAL_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_LOCAL_ResetStatus
+**
+*/
+void JMSG_LOCAL_ResetStatus(void)
+{
+
+   JMsgLocal->UnixTxCnt = 0;
+   JMsgLocal->ShmTxCnt  = 0;
+   JMsgLocal->DropCnt   = 0;
+
+} /* End JMSG_LOCAL_ResetStatus() */
+
+
+/******************************************************************************
+** Function: JMSG_LOCAL_Send
+**
+*/
+void JMSG_LOCAL_Send(const char *Msg, uint32 MsgLen)
+{
+
+#ifdef JMSG_LOCAL_NATIVE
+
+   if (JMsgLocal->TxFd >= 0)
+   {
+      if (sendto(JMsgLocal->TxFd, Msg, MsgLen, MSG_DONTWAIT,
+                 (const struct sockaddr *)&TxAddr, sizeof(TxAddr)) == (ssize_t)MsgLen)
+      {
+         JMsgLocal->UnixTxCnt++;
+      }
+      else
+      {
+         JMsgLocal->DropCnt++;
+      }
+   }
+
+   if (JMsgLocal->ShmHdr != NULL)
+   {
+      PublishShm(Msg, MsgLen);
+   }
+
+#endif
+
+} /* End JMSG_LOCAL_Send() */
+
+
+#ifdef JMSG_LOCAL_NATIVE
+/******************************************************************************
+** Function: OpenShm
+**
+** Create and map the shared memory ring.
+**
+*/
+static void OpenShm(uint32 ShmLen)
+{
+
+   int  Fd;
+   void *Shm = MAP_FAILED;
+
+   ShmLen &= ~(JMSG_LOCAL_SHM_ALIGN - 1);
+   if (ShmLen < JMSG_LOCAL_SHM_MIN || ShmLen > JMSG_UDP_PLATFORM_LOCAL_SHM_MAX)
+   {
+      CFE_EVS_SendEvent(JMSG_LOCAL_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "LOCAL_SHM_LEN %u must be %u to %u bytes, shared memory ring disabled",
+                        (unsigned int)ShmLen, (unsigned int)JMSG_LOCAL_SHM_MIN,
+                        (unsigned int)JMSG_UDP_PLATFORM_LOCAL_SHM_MAX);
+      return;
+   }
+
+   Fd = shm_open(JMsgLocal->ShmName, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (Fd >= 0)
+   {
+      if (ftruncate(Fd, ShmLen) == 0)
+      {
+         Shm = mmap(NULL, ShmLen, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+      }
+      /* The mapping keeps the object open */
+      close(Fd);
+   }
+   if (Shm == MAP_FAILED)
+   {
+      CFE_EVS_SendEvent(JMSG_LOCAL_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Error creating %u byte shared memory ring %s, errno %d",
+                        (unsigned int)ShmLen, JMsgLocal->ShmName, errno);
+      return;
+   }
+
+   JMsgLocal->Shm    = Shm;
+   JMsgLocal->ShmLen = ShmLen;
+   JMsgLocal->ShmHdr = Shm;
+   JMsgLocal->ShmHdr->Magic   = JMSG_LOCAL_SHM_MAGIC;
+   JMsgLocal->ShmHdr->Version = JMSG_LOCAL_SHM_VERSION;
+   JMsgLocal->ShmHdr->HdrLen  = sizeof(JMSG_LOCAL_ShmHdr_t);
+   JMsgLocal->ShmHdr->DataLen = ShmLen - sizeof(JMSG_LOCAL_ShmHdr_t);
+
+   CFE_EVS_SendEvent(JMSG_LOCAL_CONSTRUCTOR_EID, CFE_EVS_EventType_INFORMATION,
+                     "Publishing Tx JMSGs to %u byte shared memory ring %s",
+                     (unsigned int)ShmLen, JMsgLocal->ShmName);
+
+} /* End OpenShm() */
+
+
+/******************************************************************************
+** Function: OpenUnix
+**
+** Open the unbound Unix domain socket Tx JMSGs are sent from.
+**
+*/
+static void OpenUnix(void)
+{
+
+   if (strlen(JMsgLocal->TxPath) >= sizeof(TxAddr.sun_path))
+   {
+      CFE_EVS_SendEvent(JMSG_LOCAL_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "LOCAL_TX_PATH %s exceeds %d characters", JMsgLocal->TxPath,
+                        (int)sizeof(TxAddr.sun_path) - 1);
+      return;
+   }
+
+   memset(&TxAddr, 0, sizeof(TxAddr));
+   TxAddr.sun_family = AF_UNIX;
+   memcpy(TxAddr.sun_path, JMsgLocal->TxPath, strlen(JMsgLocal->TxPath) + 1);
+
+   JMsgLocal->TxFd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+   if (JMsgLocal->TxFd < 0)
+   {
+      CFE_EVS_SendEvent(JMSG_LOCAL_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Error creating Unix domain Tx socket, errno %d", errno);
+      return;
+   }
+
+   CFE_EVS_SendEvent(JMSG_LOCAL_CONSTRUCTOR_EID, CFE_EVS_EventType_INFORMATION,
+                     "Sending Tx JMSGs to Unix domain socket %s", JMsgLocal->TxPath);
+
+} /* End OpenUnix() */
+
+
+/******************************************************************************
+** Function: PublishShm
+**
+** Append a JMSG to the shared memory ring and wake waiting consumers.
+**
+** Notes:
+**   1. A message longer than half the ring is dropped so a consumer always
+**      has time to copy the previous message.
+**
+*/
+static void PublishShm(const char *Msg, uint32 MsgLen)
+{
+
+   JMSG_LOCAL_ShmHdr_t *Hdr = JMsgLocal->ShmHdr;
+   JMSG_LOCAL_ShmRec_t *Rec;
+   uint8  *Data    = &JMsgLocal->Shm[Hdr->HdrLen];
+   uint32 RecLen   = SHM_REC_LEN(MsgLen);
+   uint64 Head     = Hdr->Head;
+   uint32 Offset   = (uint32)(Head % Hdr->DataLen);
+   uint32 Seq      = Hdr->Seq;
+
+   if (RecLen > Hdr->DataLen / 2)
+   {
+      JMsgLocal->DropCnt++;
+      return;
+   }
+
+   if (Offset + RecLen > Hdr->DataLen)
+   {
+      if (Hdr->DataLen - Offset >= sizeof(JMSG_LOCAL_ShmRec_t))
+      {
+         Rec = (JMSG_LOCAL_ShmRec_t *)&Data[Offset];
+         Rec->Len = JMSG_LOCAL_SHM_PAD;
+         Rec->Seq = Seq;
+      }
+      Head  += Hdr->DataLen - Offset;
+      Offset = 0;
+   }
+
+   Rec = (JMSG_LOCAL_ShmRec_t *)&Data[Offset];
+   Rec->Len = MsgLen;
+   Rec->Seq = Seq;
+   memcpy(&Rec[1], Msg, MsgLen);
+
+   __atomic_store_n(&Hdr->Head, Head + RecLen, __ATOMIC_RELEASE);
+   __atomic_store_n(&Hdr->Seq, Seq + 1, __ATOMIC_SEQ_CST);
+   if (__atomic_load_n(&Hdr->Waiters, __ATOMIC_SEQ_CST) > 0)
+   {
+      syscall(SYS_futex, &Hdr->Seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+   }
+
+   JMsgLocal->ShmTxCnt++;
+
+} /* End PublishShm() */
+#endif /* JMSG_LOCAL_NATIVE */
@@ -0,0 +1,170 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Send Tx JMSGs to processes on the same host without the IP stack
+**
+** Notes:
+**   1. Two local transports are provided on Linux, each enabled by its INI
+**      name. LOCAL_TX_PATH sends each Tx JMSG as a Unix domain datagram to
+**      the socket a local consumer binds to that path. LOCAL_SHM_NAME
+**      publishes each Tx JMSG in a POSIX shared memory ring any number of
+**      consumers can read. Both carry the same "topic:payload" JMSGs as the
+**      UDP Tx socket.
+**   2. Local processes send JMSGs to the gateway with the Unix domain Rx
+**      socket bound to LOCAL_RX_PATH, see jmsg_sock.h.
+**   3. A Unix datagram that can't be sent, because no consumer is bound or
+**      its socket buffer is full, is counted and dropped so a slow
+**      consumer can't stall the Tx task.
+**   4. The shared memory ring is a JMSG_LOCAL_ShmHdr_t followed by DataLen
+**      bytes of records. A record is a JMSG_LOCAL_ShmRec_t followed by Len
+**      bytes padded to JMSG_LOCAL_SHM_ALIGN. A record that doesn't fit
+**      before the end of the ring is preceded by a JMSG_LOCAL_SHM_PAD
+**      record, or by less than a record header, and starts at the ring's
+**      beginning.
+**   5. Head is the total number of bytes published and a record's ring
+**      offset is its stream position modulo DataLen. A consumer keeps its
+**      own position, starting at Head, and reads while its position is
+**      behind Head. After copying a record it rereads Head. Records are at
+**      most half the ring so if Head is now more than DataLen/2 bytes ahead
+**      of the record's position the copy may have been overwritten and the
+**      consumer skips to Head. Record sequence numbers show the messages a
+**      slow consumer lost.
+**   6. Publishing a message doesn't enter the kernel unless a consumer is
+**      waiting. A consumer that wants to block increments Waiters, waits
+**      with FUTEX_WAIT on Seq while Seq is unchanged, and decrements
+**      Waiters. The writer increments Seq after each message and wakes the
+**      waiters with FUTEX_WAKE. The futex is shared, not process private.
+**   7. The headers are in the processor's byte order. Only the Tx task
+**      calls JMSG_LOCAL_Send().
+**
+*/
+#ifndef _jmsg_local_
+#define _jmsg_local_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_sock.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_LOCAL_SHM_MAGIC    0x4D48534A   /* "JSHM" in a little endian ring */
+#define JMSG_LOCAL_SHM_VERSION  1
+#define JMSG_LOCAL_SHM_ALIGN    8
+#define JMSG_LOCAL_SHM_PAD      0xFFFFFFFF   /* Record length of the ring's unused end */
+#define JMSG_LOCAL_SHM_NAME_LEN 64
+#define JMSG_LOCAL_SHM_MIN      (64*1024)
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_LOCAL_CONSTRUCTOR_EID  (JMSG_LOCAL_BASE_EID + 0)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Shared memory layout
+*/
+
+typedef struct
+{
+
+   uint32  Len;   /* JMSG bytes or JMSG_LOCAL_SHM_PAD */
+   uint32  Seq;   /* Message number, increments by one */
+
+} JMSG_LOCAL_ShmRec_t;
+
+
+typedef struct
+{
+
+   uint32  Magic;
+   uint16  Version;
+   uint16  HdrLen;     /* Records start at this offset */
+   uint32  DataLen;
+   uint32  Spare;
+   volatile uint64  Head;
+   volatile uint32  Seq;       /* Futex word, messages published */
+   volatile uint32  Waiters;   /* Consumers blocked on Seq */
+
+} JMSG_LOCAL_ShmHdr_t;
+
+
+/*
+** Class Definition
+*/
+
+typedef struct
+{
+
+   char    TxPath[JMSG_SOCK_LOCAL_PATH_LEN];
+   char    ShmName[JMSG_LOCAL_SHM_NAME_LEN];
+   int     TxFd;       /* Unix domain Tx socket or -1 */
+   uint8   *Shm;       /* Mapped ring or NULL */
+   uint32  ShmLen;
+   JMSG_LOCAL_ShmHdr_t *ShmHdr;
+
+   uint32  UnixTxCnt;
+   uint32  ShmTxCnt;
+   uint32  DropCnt;    /* Datagrams not sent and messages too long for the ring */
+
+} JMSG_LOCAL_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_LOCAL_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**    2. An existing shared memory object with the ring's name is replaced.
+**
+*/
+void JMSG_LOCAL_Constructor(JMSG_LOCAL_Class_t *LocalPtr, const INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: JMSG_LOCAL_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+*/
+void JMSG_LOCAL_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: JMSG_LOCAL_Send
+**
+** Send a Tx JMSG to the enabled local transports.
+**
+*/
+void JMSG_LOCAL_Send(const char *Msg, uint32 MsgLen);
+
+
+#endif /* _jmsg_local_ */
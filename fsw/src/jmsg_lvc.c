@@ -0,0 +1,459 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Cache the last Tx JMSG of each topic and answer UDP queries for them
+**
+** Notes:
+**   1. See jmsg_lvc.h
+**   2. A slot's topic name stays in its buffer when its value is cleared
+**      so the slot is still found by name.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "jmsg_hdr.h"
+#include "jmsg_lvc.h"
+#include "jmsg_mem.h"
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static JMSG_LVC_Slot_t *FindSlot(const char *Topic, uint16 TopicLen, bool Create);
+static int64 GetTimeMs(void);
+static uint32 HashTopic(const char *Topic, uint16 TopicLen);
+static bool IsAllowed(const JMSG_SOCK_RxInfo_t *Peer);
+static void LoadQueryAddr(const char *AddrList);
+static bool SendSlot(uint16 SlotIdx, const JMSG_SOCK_RxInfo_t *Peer);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_LVC_Class_t *Lvc = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_LVC_Constructor
+**
+** Notes:
+**   1. LVC_VALUE_LEN is limited so a reply with its age attribute fits in
+**      a datagram and a slot can hold any topic name.
+**
+*/
+void JMSG_LVC_Constructor(JMSG_LVC_Class_t *LvcPtr, const INITBL_Class_t *IniTbl,
+                          JMSG_LVC_SendMsg_t SendMsg)
+{
+
+   uint32 SlotCnt  = INITBL_GetIntConfig(IniTbl, CFG_LVC_TOPIC_CNT);
+   uint32 ValueLen = INITBL_GetIntConfig(IniTbl, CFG_LVC_VALUE_LEN);
+   uint32 ValueMax = JMSG_MEM_GetDatagramLen() - JMSG_LVC_ATTR_LEN;
+   uint16 i;
+
+   Lvc = LvcPtr;
+
+   CFE_PSP_MemSet((void*)Lvc, 0, sizeof(JMSG_LVC_Class_t));
+
+   Lvc->SendMsg = SendMsg;
+
+   if (SlotCnt > JMSG_UDP_PLATFORM_LVC_TOPIC_MAX)
+   {
+      SlotCnt = JMSG_UDP_PLATFORM_LVC_TOPIC_MAX;
+   }
+   if (SlotCnt > 0 && (ValueLen < JMSG_PLATFORM_TOPIC_NAME_MAX_LEN || ValueLen > ValueMax))
+   {
+      CFE_EVS_SendEvent(JMSG_LVC_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "LVC_VALUE_LEN %u must be %u to %u bytes, last value cache disabled",
+                        (unsigned int)ValueLen, (unsigned int)JMSG_PLATFORM_TOPIC_NAME_MAX_LEN,
+                        (unsigned int)ValueMax);
+      SlotCnt = 0;
+   }
+   Lvc->ValueLen    = ValueLen;
+   Lvc->AllReplyLim = INITBL_GetIntConfig(IniTbl, CFG_LVC_ALL_REPLY_LIM);
+   LoadQueryAddr(INITBL_GetStrConfig(IniTbl, CFG_LVC_QUERY_ADDR));
+
+   if (SlotCnt > 0)
+   {
+      Lvc->ReplyBuf = JMSG_MEM_Alloc(JMSG_MEM_USER_LVC, ValueLen + JMSG_LVC_ATTR_LEN);
+   }
+   for (i=0; Lvc->ReplyBuf != NULL && i < SlotCnt; i++)
+   {
+      Lvc->Slot[i].Msg = JMSG_MEM_Alloc(JMSG_MEM_USER_LVC, ValueLen);
+      if (Lvc->Slot[i].Msg == NULL)
+      {
+         break;
+      }
+   }
+   Lvc->SlotMax = i;
+
+   OS_MutSemCreate(&Lvc->Mutex, "JMSG_UDP_LVC", 0);
+
+} /* End JMSG_LVC_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_LVC_Query
+**
+*/
+void JMSG_LVC_Query(const char *Query, uint16 QueryLen, const JMSG_SOCK_RxInfo_t *Peer)
+{
+
+   JMSG_LVC_Slot_t *Slot = NULL;
+   int64  NowMs;
+   uint16 SlotCnt;
+   uint16 i;
+
+   while (QueryLen > 0 && (Query[QueryLen-1] == ' '  || Query[QueryLen-1] == '\t' ||
+                           Query[QueryLen-1] == '\r' || Query[QueryLen-1] == '\n'))
+   {
+      QueryLen--;
+   }
+
+   Lvc->QueryCnt++;
+
+   if (!IsAllowed(Peer))
+   {
+      Lvc->RejectCnt++;
+   }
+   else if (QueryLen == strlen(JMSG_LVC_QUERY_ALL) && strncmp(Query, JMSG_LVC_QUERY_ALL, QueryLen) == 0)
+   {
+      OS_MutSemTake(Lvc->Mutex);
+      SlotCnt = Lvc->SlotCnt;
+      OS_MutSemGive(Lvc->Mutex);
+
+      NowMs = GetTimeMs();
+      if (NowMs - Lvc->AllWindowMs >= JMSG_LVC_ALL_WINDOW_MS || NowMs < Lvc->AllWindowMs)
+      {
+         Lvc->AllWindowMs = NowMs;
+         Lvc->AllReplyCnt = 0;
+      }
+      for (i=0; i < SlotCnt; i++)
+      {
+         if (Lvc->AllReplyCnt >= Lvc->AllReplyLim)
+         {
+            Lvc->RejectCnt++;
+            break;
+         }
+         if (SendSlot(i, Peer))
+         {
+            Lvc->AllReplyCnt++;
+         }
+      }
+   }
+   else
+   {
+      if (QueryLen > 0 && QueryLen < JMSG_PLATFORM_TOPIC_NAME_MAX_LEN)
+      {
+         OS_MutSemTake(Lvc->Mutex);
+         Slot = FindSlot(Query, QueryLen, false);
+         OS_MutSemGive(Lvc->Mutex);
+      }
+      if (Slot == NULL || !SendSlot(Slot - Lvc->Slot, Peer))
+      {
+         Lvc->MissCnt++;
+      }
+   }
+
+} /* End JMSG_LVC_Query() */
+
+
+/******************************************************************************
+** Function: JMSG_LVC_ResetStatus
+**
+*/
+void JMSG_LVC_ResetStatus(void)
+{
+
+   Lvc->TooLongCnt = 0;
+   Lvc->FullCnt    = 0;
+   Lvc->QueryCnt   = 0;
+   Lvc->ReplyCnt   = 0;
+   Lvc->MissCnt    = 0;
+   Lvc->RejectCnt  = 0;
+
+} /* End JMSG_LVC_ResetStatus() */
+
+
+/******************************************************************************
+** Function: JMSG_LVC_SetTxPeer
+**
+*/
+void JMSG_LVC_SetTxPeer(const JMSG_SOCK_RxInfo_t *Peer)
+{
+
+   __atomic_store_n(&Lvc->TxPeerAddr, Peer->PeerAddr, __ATOMIC_RELAXED);
+
+} /* End JMSG_LVC_SetTxPeer() */
+
+
+/******************************************************************************
+** Function: JMSG_LVC_Update
+**
+*/
+void JMSG_LVC_Update(const char *Topic, const char *Payload, uint32 PayloadLen)
+{
+
+   JMSG_LVC_Slot_t *Slot;
+   uint16 TopicLen;
+   uint32 MsgLen;
+
+   if (Lvc->SlotMax == 0)
+   {
+      return;
+   }
+
+   TopicLen = strlen(Topic);
+   MsgLen   = TopicLen + 1 + PayloadLen;
+
+   OS_MutSemTake(Lvc->Mutex);
+
+   Slot = FindSlot(Topic, TopicLen, true);
+   if (Slot == NULL)
+   {
+      Lvc->FullCnt++;
+   }
+   else if (MsgLen > Lvc->ValueLen)
+   {
+      Slot->MsgLen = 0;
+      Lvc->TooLongCnt++;
+   }
+   else
+   {
+      Slot->Msg[TopicLen] = ':';
+      memcpy(&Slot->Msg[TopicLen + 1], Payload, PayloadLen);
+      Slot->MsgLen = MsgLen;
+      Slot->TimeMs = GetTimeMs();
+   }
+
+   OS_MutSemGive(Lvc->Mutex);
+
+} /* End JMSG_LVC_Update() */
+
+
+/******************************************************************************
+** Function: FindSlot
+**
+** Return a topic's slot, creating it if requested and a slot is free, or
+** NULL.
+**
+** Notes:
+**   1. The caller must hold the mutex.
+**
+*/
+static JMSG_LVC_Slot_t *FindSlot(const char *Topic, uint16 TopicLen, bool Create)
+{
+
+   JMSG_LVC_Slot_t *Slot;
+   uint32 TopicHash = HashTopic(Topic, TopicLen);
+   uint16 i;
+
+   for (i=0; i < Lvc->SlotCnt; i++)
+   {
+      Slot = &Lvc->Slot[i];
+      if (Slot->TopicHash == TopicHash && Slot->TopicLen == TopicLen &&
+          memcmp(Slot->Msg, Topic, TopicLen) == 0)
+      {
+         return Slot;
+      }
+   }
+
+   if (!Create || Lvc->SlotCnt >= Lvc->SlotMax || TopicLen >= JMSG_PLATFORM_TOPIC_NAME_MAX_LEN)
+   {
+      return NULL;
+   }
+
+   Slot = &Lvc->Slot[Lvc->SlotCnt++];
+   Slot->TopicHash = TopicHash;
+   Slot->TopicLen  = TopicLen;
+   Slot->MsgLen    = 0;
+   memcpy(Slot->Msg, Topic, TopicLen);
+
+   return Slot;
+
+} /* End FindSlot() */
+
+
+/******************************************************************************
+** Function: GetTimeMs
+**
+** Notes:
+**   1. Local time is used rather than cFE time so ages aren't disturbed by
+**      a cFE time correlation change.
+**
+*/
+static int64 GetTimeMs(void)
+{
+
+   OS_time_t LocalTime;
+
+   OS_GetLocalTime(&LocalTime);
+
+   return OS_TimeGetTotalMilliseconds(LocalTime);
+
+} /* End GetTimeMs() */
+
+
+/******************************************************************************
+** Function: HashTopic
+**
+** FNV-1a hash of a topic name.
+*/
+static uint32 HashTopic(const char *Topic, uint16 TopicLen)
+{
+
+   uint32 Hash = 2166136261u;
+   uint16 i;
+
+   for (i=0; i < TopicLen; i++)
+   {
+      Hash = (Hash ^ (uint8)Topic[i]) * 16777619u;
+   }
+
+   return Hash;
+
+} /* End HashTopic() */
+
+
+/******************************************************************************
+** Function: IsAllowed
+**
+** Return true if a peer may query the cache, see the file prologue.
+**
+** Notes:
+**   1. Local Rx socket datagrams have a zero peer port and their replies
+**      are sent to the Tx peer.
+**
+*/
+static bool IsAllowed(const JMSG_SOCK_RxInfo_t *Peer)
+{
+
+   uint16 i;
+
+   if (Peer->PeerPort == 0 || Peer->PeerAddr == __atomic_load_n(&Lvc->TxPeerAddr, __ATOMIC_RELAXED))
+   {
+      return true;
+   }
+   for (i=0; i < Lvc->QueryAddrCnt; i++)
+   {
+      if (Peer->PeerAddr == Lvc->QueryAddr[i])
+      {
+         return true;
+      }
+   }
+
+   return false;
+
+} /* End IsAllowed() */
+
+
+/******************************************************************************
+** Function: LoadQueryAddr
+**
+** Load the comma separated dotted IPv4 addresses allowed to query.
+**
+*/
+static void LoadQueryAddr(const char *AddrList)
+{
+
+   const char *Addr = AddrList;
+   unsigned int Octet[4];
+   char   End;
+   int    Cnt;
+
+   while (*Addr != '\0')
+   {
+      while (*Addr == ' ' || *Addr == ',')
+      {
+         Addr++;
+      }
+      if (*Addr == '\0')
+      {
+         break;
+      }
+
+      Cnt = sscanf(Addr, "%3u.%3u.%3u.%3u%c", &Octet[0], &Octet[1], &Octet[2], &Octet[3], &End);
+      if ((Cnt == 4 || (Cnt == 5 && (End == ',' || End == ' '))) &&
+          Octet[0] <= 255 && Octet[1] <= 255 && Octet[2] <= 255 && Octet[3] <= 255 &&
+          Lvc->QueryAddrCnt < JMSG_LVC_QUERY_ADDR_MAX)
+      {
+         Lvc->QueryAddr[Lvc->QueryAddrCnt++] = (Octet[0] << 24) | (Octet[1] << 16) | (Octet[2] << 8) | Octet[3];
+      }
+      else
+      {
+         CFE_EVS_SendEvent(JMSG_LVC_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                           "LVC_QUERY_ADDR entry %.*s ignored, must be one of at most %d IPv4 addresses",
+                           (int)strcspn(Addr, ","), Addr, JMSG_LVC_QUERY_ADDR_MAX);
+      }
+
+      while (*Addr != '\0' && *Addr != ',')
+      {
+         Addr++;
+      }
+   }
+
+} /* End LoadQueryAddr() */
+
+
+/******************************************************************************
+** Function: SendSlot
+**
+** Send a slot's cached JMSG with its age attribute and return false if the
+** slot has no value.
+**
+** Notes:
+**   1. The reply is built while holding the mutex and sent after it's
+**      released so the Tx task isn't blocked by the send.
+**
+*/
+static bool SendSlot(uint16 SlotIdx, const JMSG_SOCK_RxInfo_t *Peer)
+{
+
+   const JMSG_LVC_Slot_t *Slot = &Lvc->Slot[SlotIdx];
+   int    ReplyLen = 0;
+   int64  AgeMs;
+
+   OS_MutSemTake(Lvc->Mutex);
+
+   if (Slot->MsgLen > 0)
+   {
+      AgeMs = GetTimeMs() - Slot->TimeMs;
+      ReplyLen = snprintf(Lvc->ReplyBuf, JMSG_LVC_ATTR_LEN + Slot->TopicLen, "%.*s%cc=%u",
+                          (int)Slot->TopicLen, Slot->Msg, JMSG_HDR_ATTR_SEP,
+                          (unsigned int)(AgeMs < 0 ? 0 : (AgeMs > 0xFFFFFFFF ? 0xFFFFFFFF : AgeMs)));
+      memcpy(&Lvc->ReplyBuf[ReplyLen], &Slot->Msg[Slot->TopicLen], Slot->MsgLen - Slot->TopicLen);
+      ReplyLen += Slot->MsgLen - Slot->TopicLen;
+   }
+
+   OS_MutSemGive(Lvc->Mutex);
+
+   if (ReplyLen > 0)
+   {
+      if (Lvc->SendMsg(Lvc->ReplyBuf, (uint16)ReplyLen, Peer))
+      {
+         Lvc->ReplyCnt++;
+      }
+   }
+
+   return (ReplyLen > 0);
+
+} /* End SendSlot() */
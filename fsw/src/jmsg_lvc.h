@@ -0,0 +1,197 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Cache the last Tx JMSG of each topic and answer UDP queries for them
+**
+** Notes:
+**   1. The Tx task caches each JMSG it sends as "topic:payload" after the
+**      payload is serialized and before it's compressed. Sequence
+**      attributes aren't cached.
+**   2. A datagram received on the Rx socket that starts with '?' is a
+**      query. "?topic" requests one topic and "?*" every cached topic.
+**      Trailing whitespace is ignored so a query can be typed into a
+**      terminal tool. Each cached JMSG is returned to the sender in its own
+**      datagram from memory, without a SB round trip. The "c" header
+**      attribute gives the value's age in milliseconds, for example
+**      "basecamp/demo;c=1520:{...}". A topic that isn't cached isn't
+**      answered.
+**   3. LVC_TOPIC_CNT slots of LVC_VALUE_LEN bytes are allocated from the
+**      memory arena. LVC_TOPIC_CNT 0 disables the cache. Topics are cached
+**      in the order they're first sent until the slots are used. A JMSG
+**      longer than a slot clears its topic's cached value so a query never
+**      returns a stale value.
+**   4. The Tx task updates the cache and the Rx task answers queries. The
+**      mutex protects the slots.
+**   5. Only queries from the Tx peer's address, the local Rx socket and the
+**      IPv4 addresses listed in LVC_QUERY_ADDR are answered so the cache
+**      can't be used to reflect traffic at other hosts. At most
+**      LVC_ALL_REPLY_LIM replies to "?*" queries are sent per second. A
+**      query that isn't answered, or a "?*" query cut short by the limit,
+**      is counted as rejected.
+**
+*/
+#ifndef _jmsg_lvc_
+#define _jmsg_lvc_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_sock.h"
+#include "jmsg_topic_tbl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_LVC_QUERY_CHAR  '?'
+#define JMSG_LVC_QUERY_ALL   "*"
+#define JMSG_LVC_ATTR_LEN    16    /* Room for the reply's age attribute */
+#define JMSG_LVC_QUERY_ADDR_MAX   8
+#define JMSG_LVC_ALL_WINDOW_MS    1000  /* LVC_ALL_REPLY_LIM interval */
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_LVC_CONSTRUCTOR_EID  (JMSG_LVC_BASE_EID + 0)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Callback that sends a datagram to a peer
+*/
+typedef bool (*JMSG_LVC_SendMsg_t)(const char *Msg, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *Peer);
+
+
+typedef struct
+{
+
+   uint32  TopicHash;
+   uint16  TopicLen;
+   uint16  MsgLen;     /* Cached "topic:payload" bytes, zero if not valid */
+   int64   TimeMs;     /* When the value was cached */
+   char    *Msg;
+
+} JMSG_LVC_Slot_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Framework References
+   */
+
+   JMSG_LVC_SendMsg_t  SendMsg;
+
+   /*
+   ** Configuration
+   */
+
+   uint16  SlotMax;    /* Slots that were allocated */
+   uint16  ValueLen;
+   uint16  AllReplyLim;
+   uint16  QueryAddrCnt;
+   uint32  QueryAddr[JMSG_LVC_QUERY_ADDR_MAX];
+
+   /*
+   ** State
+   */
+
+   osal_id_t  Mutex;
+
+   uint32  TxPeerAddr;   /* Accessed atomically, set by the app task */
+   int64   AllWindowMs;  /* Start of the current "?*" reply interval */
+   uint16  AllReplyCnt;  /* "?*" replies sent in the interval */
+
+   uint16  SlotCnt;
+   uint32  TooLongCnt;   /* JMSGs longer than a slot */
+   uint32  FullCnt;      /* JMSGs of topics not cached because the slots are used */
+   uint32  QueryCnt;
+   uint32  ReplyCnt;
+   uint32  MissCnt;      /* Topic queries without a cached value */
+   uint32  RejectCnt;    /* Queries refused or cut short, see prologue */
+
+   char    *ReplyBuf;
+
+   JMSG_LVC_Slot_t  Slot[JMSG_UDP_PLATFORM_LVC_TOPIC_MAX];
+
+} JMSG_LVC_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_LVC_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**
+*/
+void JMSG_LVC_Constructor(JMSG_LVC_Class_t *LvcPtr, const INITBL_Class_t *IniTbl,
+                          JMSG_LVC_SendMsg_t SendMsg);
+
+
+/******************************************************************************
+** Function: JMSG_LVC_Query
+**
+** Answer a query datagram. Query is the text following JMSG_LVC_QUERY_CHAR
+** and doesn't need to be null terminated.
+**
+*/
+void JMSG_LVC_Query(const char *Query, uint16 QueryLen, const JMSG_SOCK_RxInfo_t *Peer);
+
+
+/******************************************************************************
+** Function: JMSG_LVC_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+** Notes:
+**   1. Cached values are kept.
+**
+*/
+void JMSG_LVC_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: JMSG_LVC_SetTxPeer
+**
+** Set the Tx peer whose address is allowed to query.
+**
+*/
+void JMSG_LVC_SetTxPeer(const JMSG_SOCK_RxInfo_t *Peer);
+
+
+/******************************************************************************
+** Function: JMSG_LVC_Update
+**
+** Cache a topic's serialized payload.
+**
+*/
+void JMSG_LVC_Update(const char *Topic, const char *Payload, uint32 PayloadLen);
+
+
+#endif /* _jmsg_lvc_ */
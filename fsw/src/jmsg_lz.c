@@ -0,0 +1,597 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Compress JMSG payloads of selected topics
+**
+** Notes:
+**   1. See jmsg_lz.h
+**   2. The codec is a greedy single hash LZ4 block encoder. A block is a
+**      sequence of a token, literals and a match offset and length. The
+**      last match starts at least MFLIMIT bytes before the end and the last
+**      LAST_LITERALS bytes are always literals so the blocks are valid for
+**      any LZ4 decoder given the same dictionary.
+**   3. Match positions are indices into the dictionary followed by the
+**      payload so a match may start in the dictionary and continue into
+**      the payload.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_lz.h"
+#include "jmsg_mem.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define MIN_MATCH      4
+#define MFLIMIT        12
+#define LAST_LITERALS  5
+#define MAX_OFFSET     65535
+#define SKIP_TRIGGER   6     /* Search step grows every 2^SKIP_TRIGGER misses */
+
+#define HASH(Seq)  (((Seq) * 2654435761U) >> (32 - JMSG_LZ_HASH_LOG))
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static uint32 Encode(const uint8 *In, uint32 InLen, uint32 OutMax);
+static uint32 ExtendMatch(uint32 RefPos, const uint8 *In, uint32 InPos, uint32 InLimit);
+static JMSG_LZ_Stats_t *FindTopic(const char *Topic);
+static void LoadDict(const char *Filename);
+static uint32 PutLen(uint8 *Out, uint32 Op, uint32 Len);
+static uint32 Read32(const uint8 *Ptr);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_LZ_Class_t *Lz = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_LZ_Constructor
+**
+*/
+void JMSG_LZ_Constructor(JMSG_LZ_Class_t *LzPtr, const INITBL_Class_t *IniTbl)
+{
+
+   const char *DictFile = INITBL_GetStrConfig(IniTbl, CFG_LZ_DICT_FILE);
+
+   Lz = LzPtr;
+
+   CFE_PSP_MemSet((void*)Lz, 0, sizeof(JMSG_LZ_Class_t));
+
+   Lz->MinLen = INITBL_GetIntConfig(IniTbl, CFG_LZ_MIN_LEN);
+   if (Lz->MinLen == 0)
+   {
+      return;
+   }
+
+   Lz->MsgMaxLen = JMSG_MEM_GetMsgMaxLen();
+   Lz->TxBuf = JMSG_MEM_Alloc(JMSG_MEM_USER_LZ, Lz->MsgMaxLen);
+   Lz->RxBuf = JMSG_MEM_Alloc(JMSG_MEM_USER_LZ, Lz->MsgMaxLen + 1);
+   if (Lz->TxBuf == NULL || Lz->RxBuf == NULL)
+   {
+      Lz->MinLen = 0;
+      return;
+   }
+
+   if (DictFile[0] != '\0')
+   {
+      LoadDict(DictFile);
+   }
+
+} /* End JMSG_LZ_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_LZ_Compress
+**
+*/
+const uint8 *JMSG_LZ_Compress(const char *Topic, const char *Payload, uint32 PayloadLen,
+                              uint32 Reserve, uint32 *ZipLen)
+{
+
+   JMSG_LZ_Stats_t *Stats = FindTopic(Topic);
+   uint32 OutMax;
+
+   *ZipLen = 0;
+
+   if (Lz->MinLen == 0)
+   {
+      return NULL;
+   }
+
+   if (PayloadLen >= Lz->MinLen && PayloadLen > Reserve + 1)
+   {
+      OutMax  = PayloadLen - Reserve - 1;
+      *ZipLen = Encode((const uint8 *)Payload, PayloadLen, (OutMax < Lz->MsgMaxLen ? OutMax : Lz->MsgMaxLen));
+   }
+
+   if (*ZipLen == 0)
+   {
+      Lz->Total.SkipCnt++;
+      if (Stats != NULL)
+      {
+         Stats->SkipCnt++;
+      }
+      return NULL;
+   }
+
+   Lz->Total.MsgCnt++;
+   Lz->Total.RawBytes += PayloadLen;
+   Lz->Total.ZipBytes += *ZipLen;
+   if (Stats != NULL)
+   {
+      Stats->MsgCnt++;
+      Stats->RawBytes += PayloadLen;
+      Stats->ZipBytes += *ZipLen;
+   }
+
+   return Lz->TxBuf;
+
+} /* End JMSG_LZ_Compress() */
+
+
+/******************************************************************************
+** Function: JMSG_LZ_Decompress
+**
+** Notes:
+**   1. Every length and offset is checked against the input, the output and
+**      the dictionary so a corrupt block can't overrun a buffer.
+**
+*/
+const char *JMSG_LZ_Decompress(const char *Zip, uint32 ZipLen, uint32 RawLen)
+{
+
+   const uint8 *In  = (const uint8 *)Zip;
+   uint8       *Out = (uint8 *)Lz->RxBuf;
+   uint32 Ip = 0;
+   uint32 Op = 0;
+   uint32 Token;
+   uint32 Len;
+   uint32 Offset;
+   uint32 Back;
+   uint8  Byte;
+   bool   Valid = true;
+
+   if (Lz->MinLen == 0 || RawLen > Lz->MsgMaxLen)
+   {
+      Lz->RxErrCnt++;
+      CFE_EVS_SendEvent(JMSG_LZ_RX_EID, CFE_EVS_EventType_ERROR,
+                        "Can't decompress a %u byte payload, %s", (unsigned int)RawLen,
+                        (Lz->MinLen == 0 ? "compression is disabled" : "it exceeds the message length"));
+      return NULL;
+   }
+
+   while (Valid && Ip < ZipLen)
+   {
+
+      Token = In[Ip++];
+
+      /* Literals */
+      Len = Token >> 4;
+      if (Len == 15)
+      {
+         do
+         {
+            Valid = (Ip < ZipLen);
+            Byte  = Valid ? In[Ip++] : 0;
+            Len  += Byte;
+         } while (Valid && Byte == 255);
+      }
+      if (!Valid || Len > ZipLen - Ip || Len > RawLen - Op)
+      {
+         Valid = false;
+         break;
+      }
+      memcpy(&Out[Op], &In[Ip], Len);
+      Ip += Len;
+      Op += Len;
+
+      if (Ip == ZipLen)
+      {
+         break;
+      }
+
+      /* Match */
+      if (ZipLen - Ip < 2)
+      {
+         Valid = false;
+         break;
+      }
+      Offset = In[Ip] | (In[Ip+1] << 8);
+      Ip += 2;
+
+      Len = Token & 0x0F;
+      if (Len == 15)
+      {
+         do
+         {
+            Valid = (Ip < ZipLen);
+            Byte  = Valid ? In[Ip++] : 0;
+            Len  += Byte;
+         } while (Valid && Byte == 255);
+      }
+      Len += MIN_MATCH;
+      if (!Valid || Offset == 0 || Len > RawLen - Op)
+      {
+         Valid = false;
+         break;
+      }
+
+      if (Offset > Op)
+      {
+         Back = Offset - Op;
+         if (Back > Lz->DictLen)
+         {
+            Valid = false;
+            break;
+         }
+         Back = (Back < Len) ? Back : Len;
+         memcpy(&Out[Op], &Lz->Dict[Lz->DictLen - (Offset - Op)], Back);
+         Op  += Back;
+         Len -= Back;
+      }
+
+      if (Offset >= Len)
+      {
+         memcpy(&Out[Op], &Out[Op - Offset], Len);
+         Op += Len;
+      }
+      else
+      {
+         /* Overlapping copy repeats the last Offset bytes */
+         for (; Len > 0; Len--, Op++)
+         {
+            Out[Op] = Out[Op - Offset];
+         }
+      }
+
+   } /* End sequence loop */
+
+   if (!Valid || Op != RawLen)
+   {
+      Lz->RxErrCnt++;
+      CFE_EVS_SendEvent(JMSG_LZ_RX_EID, CFE_EVS_EventType_ERROR,
+                        "Corrupt compressed payload, %u bytes decoded of %u",
+                        (unsigned int)Op, (unsigned int)RawLen);
+      return NULL;
+   }
+
+   Out[Op] = '\0';
+   Lz->RxMsgCnt++;
+
+   return Lz->RxBuf;
+
+} /* End JMSG_LZ_Decompress() */
+
+
+/******************************************************************************
+** Function: JMSG_LZ_RatioPerMille
+**
+*/
+uint16 JMSG_LZ_RatioPerMille(const JMSG_LZ_Stats_t *Stats)
+{
+
+   if (Stats->RawBytes == 0)
+   {
+      return 0;
+   }
+
+   return (uint16)(((uint64)Stats->ZipBytes * 1000) / Stats->RawBytes);
+
+} /* End JMSG_LZ_RatioPerMille() */
+
+
+/******************************************************************************
+** Function: JMSG_LZ_ResetStatus
+**
+*/
+void JMSG_LZ_ResetStatus(void)
+{
+
+   uint16 i;
+
+   memset(&Lz->Total, 0, sizeof(JMSG_LZ_Stats_t));
+   for (i=0; i < Lz->TopicCnt; i++)
+   {
+      memset(&Lz->Topic[i].Stats, 0, sizeof(JMSG_LZ_Stats_t));
+   }
+   Lz->RxMsgCnt = 0;
+   Lz->RxErrCnt = 0;
+
+} /* End JMSG_LZ_ResetStatus() */
+
+
+/******************************************************************************
+** Function: Encode
+**
+** Compress In into the Tx buffer and return the block length, or 0 if the
+** block would be OutMax bytes or longer.
+**
+*/
+static uint32 Encode(const uint8 *In, uint32 InLen, uint32 OutMax)
+{
+
+   uint8  *Out = Lz->TxBuf;
+   uint32 Ip = 0;
+   uint32 Op = 0;
+   uint32 Anchor = 0;
+   uint32 Step = 1 << SKIP_TRIGGER;
+   uint32 Seq;
+   uint32 Hash;
+   uint32 Ref;
+   uint32 Cur;
+   uint32 LitLen;
+   uint32 MatchLen;
+   uint32 Need;
+
+   if (Lz->DictLen > 0)
+   {
+      memcpy(Lz->Hash, Lz->DictHash, sizeof(Lz->Hash));
+   }
+   else
+   {
+      memset(Lz->Hash, 0, sizeof(Lz->Hash));
+   }
+
+   while (Ip + MFLIMIT <= InLen)
+   {
+
+      Seq  = Read32(&In[Ip]);
+      Hash = HASH(Seq);
+      Ref  = Lz->Hash[Hash];
+      Cur  = Lz->DictLen + Ip;
+      Lz->Hash[Hash] = Cur + 1;
+
+      /* Table entries are positions plus one so zero is empty */
+      if (Ref == 0 || Cur - (Ref - 1) > MAX_OFFSET ||
+          Read32(Ref - 1 < Lz->DictLen ? &Lz->Dict[Ref - 1] : &In[Ref - 1 - Lz->DictLen]) != Seq)
+      {
+         Ip += Step++ >> SKIP_TRIGGER;
+         continue;
+      }
+      Ref--;
+
+      LitLen   = Ip - Anchor;
+      MatchLen = MIN_MATCH + ExtendMatch(Ref + MIN_MATCH, In, Ip + MIN_MATCH, InLen - LAST_LITERALS);
+
+      Need = 1 + LitLen + 2 + (LitLen >= 15 ? (LitLen - 15)/255 + 1 : 0) +
+             (MatchLen - MIN_MATCH >= 15 ? (MatchLen - MIN_MATCH - 15)/255 + 1 : 0);
+      if (Op + Need >= OutMax)
+      {
+         return 0;
+      }
+
+      Out[Op] = (uint8)(((LitLen >= 15) ? 15 : LitLen) << 4);
+      Out[Op] |= (uint8)((MatchLen - MIN_MATCH >= 15) ? 15 : (MatchLen - MIN_MATCH));
+      Op = PutLen(Out, Op + 1, LitLen);
+      memcpy(&Out[Op], &In[Anchor], LitLen);
+      Op += LitLen;
+      Out[Op++] = (uint8)((Cur - Ref) & 0xFF);
+      Out[Op++] = (uint8)((Cur - Ref) >> 8);
+      Op = PutLen(Out, Op, MatchLen - MIN_MATCH);
+
+      Ip    += MatchLen;
+      Anchor = Ip;
+      Step   = 1 << SKIP_TRIGGER;
+
+   } /* End search loop */
+
+   LitLen = InLen - Anchor;
+   Need   = 1 + LitLen + (LitLen >= 15 ? (LitLen - 15)/255 + 1 : 0);
+   if (Op + Need >= OutMax)
+   {
+      return 0;
+   }
+   Out[Op] = (uint8)(((LitLen >= 15) ? 15 : LitLen) << 4);
+   Op = PutLen(Out, Op + 1, LitLen);
+   memcpy(&Out[Op], &In[Anchor], LitLen);
+
+   return Op + LitLen;
+
+} /* End Encode() */
+
+
+/******************************************************************************
+** Function: ExtendMatch
+**
+** Return the number of matching bytes between the dictionary and payload
+** position RefPos and payload index InPos, stopping at InLimit.
+**
+*/
+static uint32 ExtendMatch(uint32 RefPos, const uint8 *In, uint32 InPos, uint32 InLimit)
+{
+
+   uint32 Start = InPos;
+   const uint8 *Ref;
+
+   while (RefPos < Lz->DictLen && InPos < InLimit)
+   {
+      if (Lz->Dict[RefPos] != In[InPos])
+      {
+         return InPos - Start;
+      }
+      RefPos++;
+      InPos++;
+   }
+
+   Ref = &In[RefPos - Lz->DictLen];
+   while (InPos < InLimit && *Ref == In[InPos])
+   {
+      Ref++;
+      InPos++;
+   }
+
+   return InPos - Start;
+
+} /* End ExtendMatch() */
+
+
+/******************************************************************************
+** Function: FindTopic
+**
+** Return a topic's statistics, adding the topic if there's room. Returns
+** NULL if the topic table is full.
+**
+** Notes:
+**   1. The topic count is small and topics are only added by compressed Tx
+**      routes so a linear search is sufficient.
+**
+*/
+static JMSG_LZ_Stats_t *FindTopic(const char *Topic)
+{
+
+   uint16 i;
+   JMSG_LZ_Topic_t *LzTopic;
+
+   for (i=0; i < Lz->TopicCnt; i++)
+   {
+      if (strcmp(Lz->Topic[i].Name, Topic) == 0)
+      {
+         return &Lz->Topic[i].Stats;
+      }
+   }
+
+   if (Lz->TopicCnt < JMSG_UDP_PLATFORM_LZ_TOPIC_MAX && strlen(Topic) < JMSG_PLATFORM_TOPIC_NAME_MAX_LEN)
+   {
+      LzTopic = &Lz->Topic[Lz->TopicCnt++];
+      strcpy(LzTopic->Name, Topic);
+      return &LzTopic->Stats;
+   }
+
+   return NULL;
+
+} /* End FindTopic() */
+
+
+/******************************************************************************
+** Function: LoadDict
+**
+** Read the dictionary file and prime its hash table.
+**
+** Notes:
+**   1. The file is read into the Rx buffer, which isn't in use yet, so
+**      only the dictionary's length is allocated from the arena.
+**
+*/
+static void LoadDict(const char *Filename)
+{
+
+   osal_id_t FileHandle;
+   int32     Status;
+   uint32    Len = 0;
+   uint32    Skip;
+   uint32    i;
+   uint8     *Dict;
+
+   Status = OS_OpenCreate(&FileHandle, Filename, OS_FILE_FLAG_NONE, OS_READ_ONLY);
+   if (Status != OS_SUCCESS)
+   {
+      CFE_EVS_SendEvent(JMSG_LZ_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Error opening compression dictionary %s, status = %d", Filename, (int)Status);
+      return;
+   }
+
+   do
+   {
+      Status = OS_read(FileHandle, &Lz->RxBuf[Len], Lz->MsgMaxLen + 1 - Len);
+      if (Status > 0)
+      {
+         Len += Status;
+      }
+   } while (Status > 0 && Len <= Lz->MsgMaxLen);
+
+   OS_close(FileHandle);
+
+   if (Status < 0 || Len > Lz->MsgMaxLen || Len < MIN_MATCH)
+   {
+      CFE_EVS_SendEvent(JMSG_LZ_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Compression dictionary %s not loaded, status = %d, length must be %d to %u bytes",
+                        Filename, (int)Status, MIN_MATCH, (unsigned int)Lz->MsgMaxLen);
+      return;
+   }
+
+   /* Matches can't reach further back than the maximum offset */
+   Skip = (Len > MAX_OFFSET) ? (Len - MAX_OFFSET) : 0;
+   Dict = JMSG_MEM_Alloc(JMSG_MEM_USER_LZ, Len - Skip);
+   if (Dict == NULL)
+   {
+      return;
+   }
+   memcpy(Dict, &Lz->RxBuf[Skip], Len - Skip);
+   Lz->Dict    = Dict;
+   Lz->DictLen = Len - Skip;
+
+   for (i=0; i + MIN_MATCH <= Lz->DictLen; i++)
+   {
+      Lz->DictHash[HASH(Read32(&Dict[i]))] = i + 1;
+   }
+
+   CFE_EVS_SendEvent(JMSG_LZ_CONSTRUCTOR_EID, CFE_EVS_EventType_INFORMATION,
+                     "Loaded %u byte compression dictionary %s", (unsigned int)Lz->DictLen, Filename);
+
+} /* End LoadDict() */
+
+
+/******************************************************************************
+** Function: PutLen
+**
+** Write the extension bytes of a token length field and return the next
+** output index.
+**
+*/
+static uint32 PutLen(uint8 *Out, uint32 Op, uint32 Len)
+{
+
+   if (Len >= 15)
+   {
+      for (Len -= 15; Len >= 255; Len -= 255)
+      {
+         Out[Op++] = 255;
+      }
+      Out[Op++] = (uint8)Len;
+   }
+
+   return Op;
+
+} /* End PutLen() */
+
+
+/******************************************************************************
+** Function: Read32
+**
+*/
+static uint32 Read32(const uint8 *Ptr)
+{
+
+   uint32 Value;
+
+   memcpy(&Value, Ptr, sizeof(Value));
+
+   return Value;
+
+} /* End Read32() */
@@ -0,0 +1,185 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Compress JMSG payloads of selected topics
+**
+** Notes:
+**   1. Tx routes with the "compress" option have their serialized payload
+**      replaced by an LZ4 block and the "z" header attribute gives the
+**      original payload length. Rx payloads with a "z" attribute are
+**      decompressed before they're scanned and routed.
+**   2. Payloads shorter than LZ_MIN_LEN, and payloads that don't get
+**      shorter, are sent uncompressed. LZ_MIN_LEN 0 disables compression
+**      and decompression and no buffers are allocated.
+**   3. LZ_DICT_FILE optionally names a pre-shared dictionary. It's a raw
+**      file of sample payload text, typically representative messages of
+**      the compressed topics concatenated with the most common strings
+**      last. The dictionary precedes every payload so matches can refer to
+**      it, the same as LZ4's "using dictionary" functions. Both gateways
+**      must load the same file. Only the last 64KiB can be referenced.
+**   4. Compression statistics are kept for the first
+**      JMSG_UDP_PLATFORM_LZ_TOPIC_MAX compressed topics and in total.
+**   5. The Tx functions are only called by the Tx task and the Rx
+**      functions by the Rx task.
+**
+*/
+#ifndef _jmsg_lz_
+#define _jmsg_lz_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_topic_tbl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_LZ_HASH_LOG   12
+#define JMSG_LZ_HASH_SIZE  (1 << JMSG_LZ_HASH_LOG)
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_LZ_CONSTRUCTOR_EID  (JMSG_LZ_BASE_EID + 0)
+#define JMSG_LZ_RX_EID           (JMSG_LZ_BASE_EID + 1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   uint32  MsgCnt;      /* Payloads sent compressed */
+   uint32  SkipCnt;     /* Payloads too short or not compressible */
+   uint32  RawBytes;    /* Payload bytes before compression */
+   uint32  ZipBytes;    /* Payload bytes after compression */
+
+} JMSG_LZ_Stats_t;
+
+
+typedef struct
+{
+
+   char    Name[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN];
+   JMSG_LZ_Stats_t  Stats;
+
+} JMSG_LZ_Topic_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Configuration
+   */
+
+   uint32  MinLen;
+   uint32  MsgMaxLen;
+   uint32  DictLen;
+   const uint8 *Dict;
+
+   /*
+   ** State
+   */
+
+   JMSG_LZ_Stats_t  Total;
+   uint16  TopicCnt;
+   uint32  RxMsgCnt;
+   uint32  RxErrCnt;
+
+   uint8   *TxBuf;     /* Compressed Tx payload */
+   char    *RxBuf;     /* Decompressed Rx payload */
+
+   uint32  DictHash[JMSG_LZ_HASH_SIZE];  /* Hash table primed with the dictionary */
+   uint32  Hash[JMSG_LZ_HASH_SIZE];
+
+   JMSG_LZ_Topic_t  Topic[JMSG_UDP_PLATFORM_LZ_TOPIC_MAX];
+
+} JMSG_LZ_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_LZ_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**    2. The buffers and dictionary are allocated from the memory arena
+**       which must be constructed first.
+**
+*/
+void JMSG_LZ_Constructor(JMSG_LZ_Class_t *LzPtr, const INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: JMSG_LZ_Compress
+**
+** Compress a Tx payload.
+**
+** Notes:
+**   1. Returns the compressed payload and its length in ZipLen, or NULL if
+**      the payload is sent uncompressed. Reserve is the number of bytes the
+**      caller adds to the header so the result must be shorter than
+**      PayloadLen minus Reserve.
+**   2. The returned buffer is valid until the next call.
+**
+*/
+const uint8 *JMSG_LZ_Compress(const char *Topic, const char *Payload, uint32 PayloadLen,
+                              uint32 Reserve, uint32 *ZipLen);
+
+
+/******************************************************************************
+** Function: JMSG_LZ_Decompress
+**
+** Decompress a Rx payload whose original length is RawLen.
+**
+** Notes:
+**   1. Returns the null terminated payload or NULL if it's corrupt, too
+**      long or decompression is disabled.
+**   2. The returned buffer is valid until the next call.
+**
+*/
+const char *JMSG_LZ_Decompress(const char *Zip, uint32 ZipLen, uint32 RawLen);
+
+
+/******************************************************************************
+** Function: JMSG_LZ_RatioPerMille
+**
+** Return the compressed size in units of 0.1% of the original size.
+**
+*/
+uint16 JMSG_LZ_RatioPerMille(const JMSG_LZ_Stats_t *Stats);
+
+
+/******************************************************************************
+** Function: JMSG_LZ_ResetStatus
+**
+*/
+void JMSG_LZ_ResetStatus(void);
+
+
+#endif /* _jmsg_lz_ */
@@ -0,0 +1,423 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Compile MQTT style topic patterns into a level trie
+**
+** Notes:
+**   1. Each trie node is reached by exactly one pattern prefix so a lookup
+**      visits a node at most once even when it backtracks from a literal
+**      level to a wildcard level. The lookup's work is bounded by the
+**      number of nodes and its stack by JMSG_MATCH_LEVEL_MAX.
+**   2. Following MQTT, wildcards at the first level do not match topics
+**      that start with '$'.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_match.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define ROOT_NODE  0
+
+#define CONSUMED   (-1)   /* Remaining length once every level is matched */
+
+/* Lookup stack frame stages, the alternatives tried at a level in order */
+#define STAGE_LITERAL  0
+#define STAGE_PLUS     1
+#define STAGE_HASH     2
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+/*
+** Lookup stack frame matching the topic level at Pos against node NodeIdx
+*/
+typedef struct
+{
+
+   uint16  NodeIdx;
+   uint16  Stage;
+   uint32  Pos;
+   int32   Remaining;       /* CONSUMED after the last level */
+   uint16  LevelLen;
+   int32   NextRemaining;
+
+} MatchFrame_t;
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static uint32 HashLevel(uint16 Parent, const char *Label, uint16 LabelLen);
+static uint16 FindChild(const JMSG_MATCH_Class_t *Match, uint16 Parent, 
+                        const char *Label, uint16 LabelLen);
+static uint16 AddChild(JMSG_MATCH_Class_t *Match, uint16 Parent,
+                       const char *Label, uint16 LabelLen);
+static uint16 NewNode(JMSG_MATCH_Class_t *Match);
+
+
+/******************************************************************************
+** Function: JMSG_MATCH_Clear
+**
+*/
+void JMSG_MATCH_Clear(JMSG_MATCH_Class_t *Match)
+{
+
+   uint32 i;
+
+   Match->NodeCnt    = 0;
+   Match->PatternCnt = 0;
+   Match->StrPoolLen = 0;
+   
+   for (i=0; i < JMSG_MATCH_HASH_SIZE; i++)
+   {
+      Match->Hash[i].Child = JMSG_MATCH_NONE;
+   }
+
+   NewNode(Match);  /* Root */
+
+} /* End JMSG_MATCH_Clear() */
+
+
+/******************************************************************************
+** Function: JMSG_MATCH_AddPattern
+**
+*/
+bool JMSG_MATCH_AddPattern(JMSG_MATCH_Class_t *Match, const char *Pattern,
+                           uint16 PatternLen, uint16 Value)
+{
+
+   uint16 NodeIdx = ROOT_NODE;
+   uint16 Child;
+   const char *Level = Pattern;
+   const char *LevelEnd;
+   const char *PatternEnd = Pattern + PatternLen;
+   uint16 LevelLen;
+   uint16 LevelCnt = 1;
+   uint16 i;
+
+   for (i=0; i < PatternLen; i++)
+   {
+      if (Pattern[i] == '/')
+      {
+         LevelCnt++;
+      }
+   }
+
+   if (PatternLen == 0 || Value == JMSG_MATCH_NONE || LevelCnt > JMSG_MATCH_LEVEL_MAX)
+   {
+      return false;
+   }
+
+   while (true)
+   {
+   
+      LevelEnd = memchr(Level, '/', PatternEnd - Level);
+      if (LevelEnd == NULL)
+      {
+         LevelEnd = PatternEnd;
+      }
+      LevelLen = LevelEnd - Level;
+
+      if (LevelLen == 1 && Level[0] == '#')
+      {
+         if (LevelEnd != PatternEnd || Match->Node[NodeIdx].HashValue != JMSG_MATCH_NONE)
+         {
+            return false;
+         }
+         Match->Node[NodeIdx].HashValue = Value;
+         break;
+      }
+      
+      if (LevelLen == 1 && Level[0] == '+')
+      {
+         Child = Match->Node[NodeIdx].PlusChild;
+         if (Child == JMSG_MATCH_NONE)
+         {
+            Child = NewNode(Match);
+            Match->Node[NodeIdx].PlusChild = Child;
+         }
+      }
+      else
+      {
+         /* Wildcard characters must occupy an entire level */
+         if (memchr(Level, '+', LevelLen) != NULL || memchr(Level, '#', LevelLen) != NULL)
+         {
+            return false;
+         }
+         Child = FindChild(Match, NodeIdx, Level, LevelLen);
+         if (Child == JMSG_MATCH_NONE)
+         {
+            Child = AddChild(Match, NodeIdx, Level, LevelLen);
+         }
+      }
+      
+      if (Child == JMSG_MATCH_NONE)
+      {
+         return false;   /* Capacity exhausted */
+      }
+      NodeIdx = Child;
+
+      if (LevelEnd == PatternEnd)
+      {
+         if (Match->Node[NodeIdx].Value != JMSG_MATCH_NONE)
+         {
+            return false;
+         }
+         Match->Node[NodeIdx].Value = Value;
+         break;
+      }
+      
+      Level = LevelEnd + 1;
+   
+   } /* End level loop */
+   
+   Match->PatternCnt++;
+   
+   return true;
+
+} /* End JMSG_MATCH_AddPattern() */
+
+
+/******************************************************************************
+** Function: JMSG_MATCH_Lookup
+**
+** Notes:
+**   1. A frame tries the level's literal child, then its "+" child and
+**      then the node's "#" pattern. A frame is pushed for each child and
+**      the first pattern found is the best match because the alternatives
+**      are tried in order of preference, so the search stops there.
+**   2. A topic with more levels than the trie ends the descent at a leaf
+**      so the stack never holds more than JMSG_MATCH_LEVEL_MAX + 1 frames.
+**
+*/
+uint16 JMSG_MATCH_Lookup(const JMSG_MATCH_Class_t *Match, const char *Topic, uint16 TopicLen)
+{
+
+   MatchFrame_t Stack[JMSG_MATCH_LEVEL_MAX + 1];
+   MatchFrame_t *Frame;
+   const JMSG_MATCH_Node_t *Node;
+   const char *LevelEnd;
+   uint16 Top = 0;
+   uint16 Child;
+   uint16 Value = JMSG_MATCH_NONE;
+   bool   WildcardOk;
+   
+   if (Match->PatternCnt > 0 && TopicLen > 0)
+   {
+      Stack[0].NodeIdx   = ROOT_NODE;
+      Stack[0].Stage     = STAGE_LITERAL;
+      Stack[0].Pos       = 0;
+      Stack[0].Remaining = TopicLen;
+      Top = 1;
+   }
+   
+   while (Top > 0 && Value == JMSG_MATCH_NONE)
+   {
+   
+      Frame = &Stack[Top-1];
+      Node  = &Match->Node[Frame->NodeIdx];
+      
+      if (Frame->Remaining == CONSUMED)
+      {
+         /* "a/#" also matches "a" */
+         Value = (Node->Value != JMSG_MATCH_NONE) ? Node->Value : Node->HashValue;
+         Top--;
+         continue;
+      }
+      
+      if (Frame->Stage == STAGE_LITERAL)
+      {
+         LevelEnd = memchr(&Topic[Frame->Pos], '/', Frame->Remaining);
+         if (LevelEnd == NULL)
+         {
+            Frame->LevelLen      = Frame->Remaining;
+            Frame->NextRemaining = CONSUMED;
+         }
+         else
+         {
+            Frame->LevelLen      = LevelEnd - &Topic[Frame->Pos];
+            Frame->NextRemaining = Frame->Remaining - Frame->LevelLen - 1;
+         }
+      }
+      
+      WildcardOk = !(Top == 1 && Frame->LevelLen > 0 && Topic[Frame->Pos] == '$');
+      
+      Child = JMSG_MATCH_NONE;
+      if (Frame->Stage == STAGE_LITERAL)
+      {
+         Frame->Stage = STAGE_PLUS;
+         Child = FindChild(Match, Frame->NodeIdx, &Topic[Frame->Pos], Frame->LevelLen);
+      }
+      else if (Frame->Stage == STAGE_PLUS)
+      {
+         Frame->Stage = STAGE_HASH;
+         Child = WildcardOk ? Node->PlusChild : JMSG_MATCH_NONE;
+      }
+      else
+      {
+         Value = WildcardOk ? Node->HashValue : JMSG_MATCH_NONE;
+         Top--;
+      }
+      
+      if (Child != JMSG_MATCH_NONE && Top <= JMSG_MATCH_LEVEL_MAX)
+      {
+         Stack[Top].NodeIdx   = Child;
+         Stack[Top].Stage     = STAGE_LITERAL;
+         Stack[Top].Pos       = Frame->Pos + Frame->LevelLen + 1;
+         Stack[Top].Remaining = Frame->NextRemaining;
+         Top++;
+      }
+   
+   } /* End stack loop */
+   
+   return Value;
+   
+} /* End JMSG_MATCH_Lookup() */
+
+
+/******************************************************************************
+** Function: HashLevel
+**
+** FNV-1a hash of the level text seeded with the parent node.
+**
+*/
+static uint32 HashLevel(uint16 Parent, const char *Label, uint16 LabelLen)
+{
+
+   uint32 Hash = 2166136261u ^ ((uint32)Parent * 2654435761u);
+   uint16 i;
+   
+   for (i=0; i < LabelLen; i++)
+   {
+      Hash ^= (uint8)Label[i];
+      Hash *= 16777619u;
+   }
+   
+   return Hash;
+
+} /* End HashLevel() */
+
+
+/******************************************************************************
+** Function: FindChild
+**
+*/
+static uint16 FindChild(const JMSG_MATCH_Class_t *Match, uint16 Parent, 
+                        const char *Label, uint16 LabelLen)
+{
+
+   uint32 Hash = HashLevel(Parent, Label, LabelLen);
+   uint32 Slot = Hash & (JMSG_MATCH_HASH_SIZE - 1);
+   const JMSG_MATCH_HashEntry_t *Entry;
+   const JMSG_MATCH_Node_t *Node;
+   
+   while ((Entry = &Match->Hash[Slot])->Child != JMSG_MATCH_NONE)
+   {
+      if (Entry->Hash == Hash && Entry->Parent == Parent)
+      {
+         Node = &Match->Node[Entry->Child];
+         if (Node->LabelLen == LabelLen && memcmp(&Match->StrPool[Node->LabelOffset], Label, LabelLen) == 0)
+         {
+            return Entry->Child;
+         }
+      }
+      Slot = (Slot + 1) & (JMSG_MATCH_HASH_SIZE - 1);
+   }
+   
+   return JMSG_MATCH_NONE;
+
+} /* End FindChild() */
+
+
+/******************************************************************************
+** Function: AddChild
+**
+** Notes:
+**   1. The hash table never fills because it has twice as many slots as
+**      there are nodes.
+**
+*/
+static uint16 AddChild(JMSG_MATCH_Class_t *Match, uint16 Parent,
+                       const char *Label, uint16 LabelLen)
+{
+
+   uint32 Hash = HashLevel(Parent, Label, LabelLen);
+   uint32 Slot = Hash & (JMSG_MATCH_HASH_SIZE - 1);
+   uint16 Child;
+   
+   if (Match->StrPoolLen + LabelLen > JMSG_UDP_PLATFORM_MATCH_STR_POOL_LEN)
+   {
+      return JMSG_MATCH_NONE;
+   }
+   
+   Child = NewNode(Match);
+   if (Child != JMSG_MATCH_NONE)
+   {
+      memcpy(&Match->StrPool[Match->StrPoolLen], Label, LabelLen);
+      Match->Node[Child].LabelOffset = Match->StrPoolLen;
+      Match->Node[Child].LabelLen    = LabelLen;
+      Match->StrPoolLen += LabelLen;
+      
+      while (Match->Hash[Slot].Child != JMSG_MATCH_NONE)
+      {
+         Slot = (Slot + 1) & (JMSG_MATCH_HASH_SIZE - 1);
+      }
+      Match->Hash[Slot].Hash   = Hash;
+      Match->Hash[Slot].Parent = Parent;
+      Match->Hash[Slot].Child  = Child;
+   }
+   
+   return Child;
+
+} /* End AddChild() */
+
+
+/******************************************************************************
+** Function: NewNode
+**
+*/
+static uint16 NewNode(JMSG_MATCH_Class_t *Match)
+{
+
+   uint16 NodeIdx = JMSG_MATCH_NONE;
+   JMSG_MATCH_Node_t *Node;
+   
+   if (Match->NodeCnt < JMSG_UDP_PLATFORM_MATCH_NODE_MAX)
+   {
+      NodeIdx = Match->NodeCnt++;
+      Node = &Match->Node[NodeIdx];
+      Node->LabelOffset = 0;
+      Node->LabelLen    = 0;
+      Node->PlusChild   = JMSG_MATCH_NONE;
+      Node->Value       = JMSG_MATCH_NONE;
+      Node->HashValue   = JMSG_MATCH_NONE;
+   }
+   
+   return NodeIdx;
+
+} /* End NewNode() */
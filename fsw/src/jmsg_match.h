@@ -0,0 +1,138 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Compile MQTT style topic patterns into a level trie
+**
+** Notes:
+**   1. Topic patterns are '/' separated levels. A "+" level matches exactly
+**      one level and a "#" level, which must be last, matches the parent
+**      level and any number of following levels.
+**   2. Literal children are located with a hash of (parent node, level text)
+**      so a lookup costs one probe per topic level regardless of how many
+**      patterns are compiled.
+**   3. When more than one pattern matches, a literal level is preferred over
+**      "+" which is preferred over "#".
+**   4. A matcher is not thread safe. Owners that rebuild a matcher while
+**      another task performs lookups must double buffer it.
+**   5. A lookup backtracks from a literal level to "+" and then to "#" with
+**      an explicit stack instead of recursion. The stack only grows when a
+**      trie node is entered so its depth is bounded by the number of levels
+**      in a pattern, JMSG_MATCH_LEVEL_MAX, not by the topic being matched.
+**
+*/
+#ifndef _jmsg_match_
+#define _jmsg_match_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_MATCH_NONE   0xFFFF
+
+/* Most levels in a pattern, sizes the lookup stack */
+#define JMSG_MATCH_LEVEL_MAX  64
+
+/* Hash table has at least two slots per node */
+#define JMSG_MATCH_HASH_SIZE  (2*JMSG_UDP_PLATFORM_MATCH_NODE_MAX)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   uint32  LabelOffset;   /* Level text in StrPool */
+   uint16  LabelLen;
+   uint16  PlusChild;     /* Node for a "+" level */
+   uint16  Value;         /* Pattern ending at this node */
+   uint16  HashValue;     /* Pattern ending with "#" below this node */
+
+} JMSG_MATCH_Node_t;
+
+
+typedef struct
+{
+
+   uint32  Hash;
+   uint16  Parent;
+   uint16  Child;
+
+} JMSG_MATCH_HashEntry_t;
+
+
+typedef struct
+{
+
+   uint16  NodeCnt;
+   uint16  PatternCnt;
+   uint32  StrPoolLen;
+
+   JMSG_MATCH_Node_t       Node[JMSG_UDP_PLATFORM_MATCH_NODE_MAX];
+   JMSG_MATCH_HashEntry_t  Hash[JMSG_MATCH_HASH_SIZE];
+   char                    StrPool[JMSG_UDP_PLATFORM_MATCH_STR_POOL_LEN];
+
+} JMSG_MATCH_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_MATCH_Clear
+**
+** Remove all patterns from a matcher.
+**
+*/
+void JMSG_MATCH_Clear(JMSG_MATCH_Class_t *Match);
+
+
+/******************************************************************************
+** Function: JMSG_MATCH_AddPattern
+**
+** Compile a topic pattern into the matcher with the value returned by
+** JMSG_MATCH_Lookup().
+**
+** Notes:
+**   1. Returns false if the pattern is malformed, has more than
+**      JMSG_MATCH_LEVEL_MAX levels, is a duplicate or the matcher's
+**      capacity is exhausted.
+**
+*/
+bool JMSG_MATCH_AddPattern(JMSG_MATCH_Class_t *Match, const char *Pattern,
+                           uint16 PatternLen, uint16 Value);
+
+
+/******************************************************************************
+** Function: JMSG_MATCH_Lookup
+**
+** Return the value of the best pattern matching a topic or JMSG_MATCH_NONE.
+**
+*/
+uint16 JMSG_MATCH_Lookup(const JMSG_MATCH_Class_t *Match, const char *Topic, uint16 TopicLen);
+
+
+#endif /* _jmsg_match_ */
@@ -0,0 +1,135 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Size the gateway's message buffers and allocate them from a fixed arena
+**
+** Notes:
+**   1. See jmsg_mem.h
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include "jmsg_mem.h"
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_MEM_Class_t *Mem = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_MEM_Constructor
+**
+** Notes:
+**   1. The arena isn't cleared here, each allocation is cleared instead.
+**
+*/
+void JMSG_MEM_Constructor(JMSG_MEM_Class_t *MemPtr, const INITBL_Class_t *IniTbl)
+{
+
+   uint32 FragCnt = INITBL_GetIntConfig(IniTbl, CFG_FRAG_CNT);
+
+   Mem = MemPtr;
+
+   CFE_PSP_MemSet((void*)Mem, 0, offsetof(JMSG_MEM_Class_t, Arena));
+
+   Mem->DatagramLen = INITBL_GetIntConfig(IniTbl, CFG_DATAGRAM_LEN);
+   if (Mem->DatagramLen == 0 || Mem->DatagramLen > JMSG_UDP_BUF_LEN)
+   {
+      Mem->DatagramLen = JMSG_UDP_BUF_LEN;
+   }
+
+   if (FragCnt < 1)
+   {
+      FragCnt = 1;
+   }
+   else if (FragCnt > JMSG_UDP_PLATFORM_FRAG_CNT_MAX)
+   {
+      FragCnt = JMSG_UDP_PLATFORM_FRAG_CNT_MAX;
+   }
+   Mem->FragCnt = FragCnt;
+
+} /* End JMSG_MEM_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_MEM_Alloc
+**
+*/
+void *JMSG_MEM_Alloc(JMSG_MEM_User_t User, uint32 Len)
+{
+
+   void  *Buf = NULL;
+   uint32 AlignedLen = (Len + sizeof(uint64) - 1) & ~(uint32)(sizeof(uint64) - 1);
+
+   if (AlignedLen <= sizeof(Mem->Arena) - Mem->Used)
+   {
+      Buf = (char *)Mem->Arena + Mem->Used;
+      CFE_PSP_MemSet(Buf, 0, AlignedLen);
+      Mem->Used += AlignedLen;
+      Mem->UserLen[User] += AlignedLen;
+   }
+   else
+   {
+      Mem->FailCnt++;
+      CFE_EVS_SendEvent(JMSG_MEM_ALLOC_EID, CFE_EVS_EventType_ERROR,
+                        "Memory arena exhausted allocating %u bytes for user %d, %u of %u bytes used",
+                        (unsigned int)Len, User, (unsigned int)Mem->Used, (unsigned int)sizeof(Mem->Arena));
+   }
+
+   return Buf;
+
+} /* End JMSG_MEM_Alloc() */
+
+
+/******************************************************************************
+** Function: JMSG_MEM_GetDatagramLen
+**
+*/
+uint32 JMSG_MEM_GetDatagramLen(void)
+{
+
+   return Mem->DatagramLen;
+
+} /* End JMSG_MEM_GetDatagramLen() */
+
+
+/******************************************************************************
+** Function: JMSG_MEM_GetFragCnt
+**
+*/
+uint16 JMSG_MEM_GetFragCnt(void)
+{
+
+   return Mem->FragCnt;
+
+} /* End JMSG_MEM_GetFragCnt() */
+
+
+/******************************************************************************
+** Function: JMSG_MEM_GetMsgMaxLen
+**
+*/
+uint32 JMSG_MEM_GetMsgMaxLen(void)
+{
+
+   return Mem->FragCnt * Mem->DatagramLen;
+
+} /* End JMSG_MEM_GetMsgMaxLen() */
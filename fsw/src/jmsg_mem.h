@@ -0,0 +1,142 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Size the gateway's message buffers and allocate them from a fixed arena
+**
+** Notes:
+**   1. DATAGRAM_LEN and FRAG_CNT from the INI table, bounded by the
+**      compile-time limits, set the datagram and whole JMSG lengths that
+**      the Rx, Tx, fragmentation and reliable buffers are sized for.
+**   2. Buffers whose sizes come from the INI table are carved from one
+**      static arena of JMSG_UDP_PLATFORM_MEM_POOL_LEN bytes during
+**      initialization. Nothing is freed so there is no fragmentation and no
+**      allocation after startup.
+**   3. Allocations are accounted per user so the memory report shows which
+**      subsystem uses the arena. The arena can be reduced to the reported
+**      used size on memory constrained targets.
+**
+*/
+#ifndef _jmsg_mem_
+#define _jmsg_mem_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_MEM_ALLOC_EID  (JMSG_MEM_BASE_EID + 0)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef enum
+{
+
+   JMSG_MEM_USER_RX = 0,
+   JMSG_MEM_USER_TX,
+   JMSG_MEM_USER_FRAG,
+   JMSG_MEM_USER_REL,
+   JMSG_MEM_USER_LZ,
+   JMSG_MEM_USER_LVC,
+   JMSG_MEM_USER_DECODE,
+   JMSG_MEM_USER_CNT
+
+} JMSG_MEM_User_t;
+
+
+typedef struct
+{
+
+   uint32  DatagramLen;
+   uint16  FragCnt;     /* 1 if fragmentation is disabled */
+
+   uint32  Used;
+   uint32  UserLen[JMSG_MEM_USER_CNT];
+   uint32  FailCnt;
+
+   uint64  Arena[JMSG_UDP_PLATFORM_MEM_POOL_LEN / sizeof(uint64)];
+
+} JMSG_MEM_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_MEM_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**
+*/
+void JMSG_MEM_Constructor(JMSG_MEM_Class_t *MemPtr, const INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: JMSG_MEM_Alloc
+**
+** Allocate a zeroed, 8 byte aligned buffer.
+**
+** Notes:
+**   1. Returns NULL and sends an error event if the arena is exhausted.
+**
+*/
+void *JMSG_MEM_Alloc(JMSG_MEM_User_t User, uint32 Len);
+
+
+/******************************************************************************
+** Function: JMSG_MEM_GetDatagramLen
+**
+** Return the longest datagram that can be sent or received.
+**
+*/
+uint32 JMSG_MEM_GetDatagramLen(void);
+
+
+/******************************************************************************
+** Function: JMSG_MEM_GetFragCnt
+**
+** Return the number of fragments a JMSG may span, 1 if fragmentation is
+** disabled.
+**
+*/
+uint16 JMSG_MEM_GetFragCnt(void);
+
+
+/******************************************************************************
+** Function: JMSG_MEM_GetMsgMaxLen
+**
+** Return the longest JMSG that can be sent or received, fragmented or not.
+**
+*/
+uint32 JMSG_MEM_GetMsgMaxLen(void);
+
+
+#endif /* _jmsg_mem_ */
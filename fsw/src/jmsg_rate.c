@@ -0,0 +1,180 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Measure the message and byte rates and message sizes of one direction
+**
+** Notes:
+**   1. See jmsg_rate.h
+**   2. Counters are written by one task and read by another without a
+**      mutex like the other status counters. A rate may be off by a
+**      message if it's counted while the rate is computed.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_rate.h"
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static int64 GetTimeMs(void);
+static uint32 PerSec(uint32 Delta, int64 IntervalMs);
+
+
+/******************************************************************************
+** Function: JMSG_RATE_Constructor
+**
+*/
+void JMSG_RATE_Constructor(JMSG_RATE_Class_t *Rate)
+{
+
+   memset(Rate, 0, sizeof(JMSG_RATE_Class_t));
+
+   Rate->PrevTimeMs = GetTimeMs();
+
+} /* End JMSG_RATE_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_RATE_Count
+**
+*/
+void JMSG_RATE_Count(JMSG_RATE_Class_t *Rate, uint32 MsgLen)
+{
+
+   uint16 Bin = 0;
+
+   while (Bin < (JMSG_UDP_PLATFORM_RATE_SIZE_BIN_CNT - 1) && MsgLen > ((uint32)JMSG_RATE_SIZE_BIN_MIN << Bin))
+   {
+      Bin++;
+   }
+
+   Rate->MsgCnt++;
+   Rate->ByteCnt += MsgLen;
+   Rate->SizeBin[Bin]++;
+   if (MsgLen > Rate->MaxLen)
+   {
+      Rate->MaxLen = MsgLen;
+   }
+
+} /* End JMSG_RATE_Count() */
+
+
+/******************************************************************************
+** Function: JMSG_RATE_ResetStatus
+**
+** Notes:
+**   1. The current rates are kept and the next rates are computed from
+**      the reset.
+**
+*/
+void JMSG_RATE_ResetStatus(JMSG_RATE_Class_t *Rate)
+{
+
+   Rate->MsgCnt  = 0;
+   Rate->ByteCnt = 0;
+   Rate->MaxLen  = 0;
+   memset(Rate->SizeBin, 0, sizeof(Rate->SizeBin));
+
+   Rate->PrevTimeMs     = GetTimeMs();
+   Rate->PrevMsgCnt     = 0;
+   Rate->PrevByteCnt    = 0;
+   Rate->PeakMsgPerSec  = 0;
+   Rate->PeakBytePerSec = 0;
+
+} /* End JMSG_RATE_ResetStatus() */
+
+
+/******************************************************************************
+** Function: JMSG_RATE_Update
+**
+** Notes:
+**   1. An update less than a millisecond after the previous one keeps the
+**      current rates.
+**
+*/
+void JMSG_RATE_Update(JMSG_RATE_Class_t *Rate)
+{
+
+   int64  NowMs      = GetTimeMs();
+   int64  IntervalMs = NowMs - Rate->PrevTimeMs;
+   uint32 MsgCnt     = Rate->MsgCnt;
+   uint32 ByteCnt    = Rate->ByteCnt;
+
+   if (IntervalMs <= 0)
+   {
+      return;
+   }
+
+   Rate->IntervalMs = (IntervalMs > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32)IntervalMs;
+   Rate->MsgPerSec  = PerSec(MsgCnt - Rate->PrevMsgCnt, IntervalMs);
+   Rate->BytePerSec = PerSec(ByteCnt - Rate->PrevByteCnt, IntervalMs);
+
+   if (Rate->MsgPerSec > Rate->PeakMsgPerSec)
+   {
+      Rate->PeakMsgPerSec = Rate->MsgPerSec;
+   }
+   if (Rate->BytePerSec > Rate->PeakBytePerSec)
+   {
+      Rate->PeakBytePerSec = Rate->BytePerSec;
+   }
+
+   Rate->PrevTimeMs  = NowMs;
+   Rate->PrevMsgCnt  = MsgCnt;
+   Rate->PrevByteCnt = ByteCnt;
+
+} /* End JMSG_RATE_Update() */
+
+
+/******************************************************************************
+** Function: GetTimeMs
+**
+** Notes:
+**   1. Local time is used rather than cFE time so rates aren't disturbed by
+**      a cFE time correlation change.
+**
+*/
+static int64 GetTimeMs(void)
+{
+
+   OS_time_t LocalTime;
+
+   OS_GetLocalTime(&LocalTime);
+
+   return OS_TimeGetTotalMilliseconds(LocalTime);
+
+} /* End GetTimeMs() */
+
+
+/******************************************************************************
+** Function: PerSec
+**
+** Rounded per second rate of a count's change over an interval.
+*/
+static uint32 PerSec(uint32 Delta, int64 IntervalMs)
+{
+
+   uint64 Rate = ((uint64)Delta * 1000 + (uint64)IntervalMs / 2) / (uint64)IntervalMs;
+
+   return (Rate > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32)Rate;
+
+} /* End PerSec() */
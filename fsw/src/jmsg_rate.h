@@ -0,0 +1,126 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Measure the message and byte rates and message sizes of one direction
+**
+** Notes:
+**   1. The Rx and Tx sockets each own a rate object. The task that
+**      services a socket counts its messages and the main task computes
+**      the rates when it sends status telemetry, so a rate is the average
+**      over the time since the previous status packet.
+**   2. Peak rates are the highest status period averages since the last
+**      reset, not instantaneous bursts.
+**   3. Message lengths are counted in JMSG_UDP_PLATFORM_RATE_SIZE_BIN_CNT
+**      power of 2 bins starting at JMSG_RATE_SIZE_BIN_MIN bytes. Bin n
+**      counts lengths up to JMSG_RATE_SIZE_BIN_MIN << n bytes and the last
+**      bin counts all longer messages.
+**   4. Byte counts wrap at 4GiB. A rate is computed from the count's
+**      change so a wrap during a status period doesn't disturb it.
+**
+*/
+#ifndef _jmsg_rate_
+#define _jmsg_rate_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_RATE_SIZE_BIN_MIN  64
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   /*
+   ** Counted by the servicing task
+   */
+
+   uint32  MsgCnt;
+   uint32  ByteCnt;
+   uint32  MaxLen;     /* Longest message since reset */
+   uint32  SizeBin[JMSG_UDP_PLATFORM_RATE_SIZE_BIN_CNT];
+
+   /*
+   ** Computed by the main task
+   */
+
+   int64   PrevTimeMs;
+   uint32  PrevMsgCnt;
+   uint32  PrevByteCnt;
+
+   uint32  IntervalMs;     /* Period the rates were averaged over */
+   uint32  MsgPerSec;
+   uint32  BytePerSec;
+   uint32  PeakMsgPerSec;
+   uint32  PeakBytePerSec;
+
+} JMSG_RATE_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_RATE_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**
+*/
+void JMSG_RATE_Constructor(JMSG_RATE_Class_t *Rate);
+
+
+/******************************************************************************
+** Function: JMSG_RATE_Count
+**
+** Count a message of MsgLen bytes.
+**
+*/
+void JMSG_RATE_Count(JMSG_RATE_Class_t *Rate, uint32 MsgLen);
+
+
+/******************************************************************************
+** Function: JMSG_RATE_ResetStatus
+**
+** Reset counters, peaks and the size distribution to a known reset state.
+**
+*/
+void JMSG_RATE_ResetStatus(JMSG_RATE_Class_t *Rate);
+
+
+/******************************************************************************
+** Function: JMSG_RATE_Update
+**
+** Compute the rates since the previous update and update the peaks.
+**
+*/
+void JMSG_RATE_Update(JMSG_RATE_Class_t *Rate);
+
+
+#endif /* _jmsg_rate_ */
@@ -0,0 +1,471 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Provide at-least-once delivery for selected JMSG topics over UDP
+**
+** Notes:
+**   1. See jmsg_rel.h
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "jmsg_hdr.h"
+#include "jmsg_mem.h"
+#include "jmsg_rel.h"
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static uint16 FindTopic(const char *Topic, uint16 TopicLen, bool Add);
+static void FreeSlot(JMSG_REL_Slot_t *Slot);
+static int64 GetTimeMs(void);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_REL_Class_t *Rel = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_REL_Constructor
+**
+*/
+void JMSG_REL_Constructor(JMSG_REL_Class_t *RelPtr, const INITBL_Class_t *IniTbl,
+                          JMSG_REL_SendMsg_t SendMsg)
+{
+
+   uint16 i;
+   uint32 SlotCnt = INITBL_GetIntConfig(IniTbl, CFG_REL_SLOT_CNT);
+
+   Rel = RelPtr;
+
+   CFE_PSP_MemSet((void*)Rel, 0, sizeof(JMSG_REL_Class_t));
+
+   Rel->SendMsg     = SendMsg;
+   Rel->Window      = INITBL_GetIntConfig(IniTbl, CFG_REL_WINDOW);
+   Rel->RtoMs       = INITBL_GetIntConfig(IniTbl, CFG_REL_RTO_MS);
+   Rel->RetryLim    = INITBL_GetIntConfig(IniTbl, CFG_REL_RETRY_LIM);
+   Rel->AckToTxAddr = (INITBL_GetIntConfig(IniTbl, CFG_REL_ACK_TO_TX_ADDR) != 0);
+   Rel->MsgMaxLen   = JMSG_MEM_GetDatagramLen();
+
+   if (SlotCnt > JMSG_UDP_PLATFORM_REL_SLOT_MAX)
+   {
+      SlotCnt = JMSG_UDP_PLATFORM_REL_SLOT_MAX;
+   }
+   for (i=0; i < SlotCnt; i++)
+   {
+      Rel->Slot[i].Msg = JMSG_MEM_Alloc(JMSG_MEM_USER_REL, Rel->MsgMaxLen);
+      if (Rel->Slot[i].Msg == NULL)
+      {
+         break;
+      }
+   }
+   Rel->SlotCnt = i;
+
+   if (Rel->Window == 0 || Rel->Window > Rel->SlotCnt)
+   {
+      Rel->Window = Rel->SlotCnt;
+   }
+
+   OS_MutSemCreate(&Rel->Mutex, "JMSG_UDP_REL", 0);
+
+} /* End JMSG_REL_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_REL_Cancel
+**
+** Notes:
+**   1. The sequence number is returned when it's the topic's most recent so
+**      the receiver doesn't count a gap.
+**
+*/
+void JMSG_REL_Cancel(uint16 SlotIdx)
+{
+
+   JMSG_REL_Slot_t  *Slot = &Rel->Slot[SlotIdx];
+   JMSG_REL_Topic_t *Topic;
+
+   OS_MutSemTake(Rel->Mutex);
+
+   Topic = &Rel->Topic[Slot->TopicIdx];
+   if (Topic->NextSeq == Slot->Seq + 1)
+   {
+      Topic->NextSeq--;
+   }
+   FreeSlot(Slot);
+
+   OS_MutSemGive(Rel->Mutex);
+
+} /* End JMSG_REL_Cancel() */
+
+
+/******************************************************************************
+** Function: JMSG_REL_RecvAck
+**
+*/
+void JMSG_REL_RecvAck(const char *Topic, uint16 TopicLen, uint32 Seq)
+{
+
+   uint16 TopicIdx;
+   uint16 i;
+   bool   Found = false;
+
+   OS_MutSemTake(Rel->Mutex);
+
+   TopicIdx = FindTopic(Topic, TopicLen, false);
+   if (TopicIdx != JMSG_REL_UNDEF_SLOT)
+   {
+      for (i=0; i < Rel->SlotCnt; i++)
+      {
+         if (Rel->Slot[i].Sent && Rel->Slot[i].TopicIdx == TopicIdx && Rel->Slot[i].Seq == Seq)
+         {
+            FreeSlot(&Rel->Slot[i]);
+            Found = true;
+            break;
+         }
+      }
+   }
+
+   /* Late acks for retransmitted messages are expected */
+   if (Found)
+   {
+      Rel->AckRxCnt++;
+   }
+   else
+   {
+      Rel->UnknownAckCnt++;
+   }
+
+   OS_MutSemGive(Rel->Mutex);
+
+   CFE_EVS_SendEvent(JMSG_REL_ACK_EID, CFE_EVS_EventType_DEBUG,
+                     "Received ack for topic %.*s sequence %u, %s",
+                     TopicLen, Topic, (unsigned int)Seq, (Found ? "released" : "not pending"));
+
+} /* End JMSG_REL_RecvAck() */
+
+
+/******************************************************************************
+** Function: JMSG_REL_Reserve
+**
+*/
+bool JMSG_REL_Reserve(const char *Topic, uint32 *Seq, uint16 *SlotIdx)
+{
+
+   bool   RetStatus = false;
+   uint16 TopicIdx;
+   uint16 i;
+   JMSG_REL_Topic_t *RelTopic;
+
+   *SlotIdx = JMSG_REL_UNDEF_SLOT;
+
+   OS_MutSemTake(Rel->Mutex);
+
+   TopicIdx = FindTopic(Topic, strlen(Topic), true);
+   if (TopicIdx != JMSG_REL_UNDEF_SLOT)
+   {
+      RelTopic = &Rel->Topic[TopicIdx];
+      if (RelTopic->PendingCnt < Rel->Window)
+      {
+         for (i=0; i < Rel->SlotCnt; i++)
+         {
+            if (!Rel->Slot[i].InUse)
+            {
+               Rel->Slot[i].InUse    = true;
+               Rel->Slot[i].Sent     = false;
+               Rel->Slot[i].TopicIdx = TopicIdx;
+               Rel->Slot[i].Seq      = RelTopic->NextSeq++;
+               Rel->Slot[i].RetryCnt = 0;
+               Rel->Slot[i].RtoMs    = Rel->RtoMs;
+               RelTopic->PendingCnt++;
+               Rel->PendingCnt++;
+               *Seq      = Rel->Slot[i].Seq;
+               *SlotIdx  = i;
+               RetStatus = true;
+               break;
+            }
+         }
+      }
+   }
+
+   if (!RetStatus)
+   {
+      Rel->WindowFullCnt++;
+   }
+
+   OS_MutSemGive(Rel->Mutex);
+
+   if (!RetStatus)
+   {
+      CFE_EVS_SendEvent(JMSG_REL_TX_EID, CFE_EVS_EventType_ERROR,
+                        "Rejected reliable topic %s message, %d messages are waiting for acks",
+                        Topic, Rel->PendingCnt);
+   }
+
+   return RetStatus;
+
+} /* End JMSG_REL_Reserve() */
+
+
+/******************************************************************************
+** Function: JMSG_REL_ResetStatus
+**
+*/
+void JMSG_REL_ResetStatus(void)
+{
+
+   Rel->TxCnt         = 0;
+   Rel->RetryCnt      = 0;
+   Rel->FailCnt       = 0;
+   Rel->WindowFullCnt = 0;
+   Rel->AckRxCnt      = 0;
+   Rel->AckTxCnt      = 0;
+   Rel->UnknownAckCnt = 0;
+
+} /* End JMSG_REL_ResetStatus() */
+
+
+/******************************************************************************
+** Function: JMSG_REL_Send
+**
+** Notes:
+**   1. A failed first send is left to the retransmit timer.
+**   2. A message longer than the slot is rejected and the caller must cancel
+**      the slot.
+**
+*/
+bool JMSG_REL_Send(uint16 SlotIdx, const char *Msg, uint16 MsgLen)
+{
+
+   bool RetStatus;
+   JMSG_REL_Slot_t *Slot = &Rel->Slot[SlotIdx];
+
+   if (MsgLen > Rel->MsgMaxLen)
+   {
+      CFE_EVS_SendEvent(JMSG_REL_TX_EID, CFE_EVS_EventType_ERROR,
+                        "Reliable Tx message length %u exceeds the %u byte datagram length",
+                        MsgLen, (unsigned int)Rel->MsgMaxLen);
+      return false;
+   }
+
+   OS_MutSemTake(Rel->Mutex);
+
+   memcpy(Slot->Msg, Msg, MsgLen);
+   Slot->MsgLen     = MsgLen;
+   Slot->Sent       = true;
+   Slot->DeadlineMs = GetTimeMs() + Slot->RtoMs;
+   Rel->TxCnt++;
+
+   RetStatus = Rel->SendMsg(Slot->Msg, Slot->MsgLen, NULL);
+
+   OS_MutSemGive(Rel->Mutex);
+
+   return RetStatus;
+
+} /* End JMSG_REL_Send() */
+
+
+/******************************************************************************
+** Function: JMSG_REL_SendAck
+**
+*/
+bool JMSG_REL_SendAck(const JMSG_SOCK_RxInfo_t *RxInfo, const char *Topic,
+                      uint16 TopicLen, uint32 Seq)
+{
+
+   char AckMsg[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN + 16];
+   int  AckLen;
+   bool RetStatus = false;
+
+   AckLen = snprintf(AckMsg, sizeof(AckMsg), "%.*s%ca=%u:", TopicLen, Topic,
+                     JMSG_HDR_ATTR_SEP, (unsigned int)Seq);
+
+   if (AckLen > 0 && AckLen < (int)sizeof(AckMsg))
+   {
+      RetStatus = Rel->SendMsg(AckMsg, AckLen, (Rel->AckToTxAddr ? NULL : RxInfo));
+   }
+
+   if (RetStatus)
+   {
+      Rel->AckTxCnt++;
+   }
+   else
+   {
+      CFE_EVS_SendEvent(JMSG_REL_ACK_EID, CFE_EVS_EventType_ERROR,
+                        "Error sending ack for topic %.*s sequence %u",
+                        TopicLen, Topic, (unsigned int)Seq);
+   }
+
+   return RetStatus;
+
+} /* End JMSG_REL_SendAck() */
+
+
+/******************************************************************************
+** Function: JMSG_REL_ServiceTx
+**
+*/
+int32 JMSG_REL_ServiceTx(void)
+{
+
+   int32  NextMs = OS_PEND;
+   int64  NowMs;
+   int64  WaitMs;
+   uint16 i;
+   JMSG_REL_Slot_t *Slot;
+
+   if (Rel->PendingCnt == 0)
+   {
+      return OS_PEND;
+   }
+
+   NowMs = GetTimeMs();
+
+   OS_MutSemTake(Rel->Mutex);
+
+   for (i=0; i < Rel->SlotCnt; i++)
+   {
+      Slot = &Rel->Slot[i];
+      if (!Slot->Sent)
+      {
+         continue;
+      }
+
+      if (NowMs >= Slot->DeadlineMs)
+      {
+         if (Slot->RetryCnt < Rel->RetryLim)
+         {
+            Slot->RetryCnt++;
+            Slot->RtoMs     *= 2;
+            Slot->DeadlineMs = NowMs + Slot->RtoMs;
+            Rel->RetryCnt++;
+            Rel->SendMsg(Slot->Msg, Slot->MsgLen, NULL);
+         }
+         else
+         {
+            CFE_EVS_SendEvent(JMSG_REL_TX_EID, CFE_EVS_EventType_ERROR,
+                              "Abandoned reliable topic %s sequence %u after %d retries",
+                              Rel->Topic[Slot->TopicIdx].Name, (unsigned int)Slot->Seq, Slot->RetryCnt);
+            Rel->FailCnt++;
+            FreeSlot(Slot);
+            continue;
+         }
+      }
+
+      WaitMs = Slot->DeadlineMs - NowMs;
+      if (NextMs == OS_PEND || WaitMs < NextMs)
+      {
+         NextMs = (int32)WaitMs;
+      }
+   }
+
+   OS_MutSemGive(Rel->Mutex);
+
+   return NextMs;
+
+} /* End JMSG_REL_ServiceTx() */
+
+
+/******************************************************************************
+** Function: FindTopic
+**
+** Return a topic's index, optionally adding it. Returns JMSG_REL_UNDEF_SLOT
+** if the topic isn't found or can't be added.
+**
+** Notes:
+**   1. The topic count is small and topics are only added by reliable Tx
+**      routes so a linear search is sufficient.
+**
+*/
+static uint16 FindTopic(const char *Topic, uint16 TopicLen, bool Add)
+{
+
+   uint16 i;
+   JMSG_REL_Topic_t *RelTopic;
+
+   for (i=0; i < JMSG_UDP_PLATFORM_REL_TOPIC_MAX; i++)
+   {
+      RelTopic = &Rel->Topic[i];
+      if (!RelTopic->InUse)
+      {
+         if (!Add || TopicLen >= JMSG_PLATFORM_TOPIC_NAME_MAX_LEN)
+         {
+            break;
+         }
+         RelTopic->InUse   = true;
+         RelTopic->NameLen = TopicLen;
+         memcpy(RelTopic->Name, Topic, TopicLen);
+         RelTopic->Name[TopicLen] = '\0';
+         RelTopic->NextSeq = 1;
+         return i;
+      }
+      if (RelTopic->NameLen == TopicLen && memcmp(RelTopic->Name, Topic, TopicLen) == 0)
+      {
+         return i;
+      }
+   }
+
+   return JMSG_REL_UNDEF_SLOT;
+
+} /* End FindTopic() */
+
+
+/******************************************************************************
+** Function: FreeSlot
+**
+** Notes:
+**   1. Caller must hold the mutex
+**
+*/
+static void FreeSlot(JMSG_REL_Slot_t *Slot)
+{
+
+   Rel->Topic[Slot->TopicIdx].PendingCnt--;
+   Rel->PendingCnt--;
+   Slot->InUse = false;
+   Slot->Sent  = false;
+
+} /* End FreeSlot() */
+
+
+/******************************************************************************
+** Function: GetTimeMs
+**
+** Notes:
+**   1. Local time is used rather than cFE time so timers aren't disturbed by
+**      a cFE time correlation change.
+**
+*/
+static int64 GetTimeMs(void)
+{
+
+   OS_time_t LocalTime;
+
+   OS_GetLocalTime(&LocalTime);
+
+   return OS_TimeGetTotalMilliseconds(LocalTime);
+
+} /* End GetTimeMs() */
@@ -0,0 +1,238 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Provide at-least-once delivery for selected JMSG topics over UDP
+**
+** Notes:
+**   1. A reliable JMSG carries its per-topic sequence number in the "r"
+**      header attribute and the receiver returns "topic;a=N:". Rx reliable
+**      messages are acknowledged as soon as their header is valid, including
+**      duplicates, so a lost ack is repaired by the sender's retransmission.
+**      Duplicates are suppressed by the JMSG_SEQ Rx window.
+**   2. Tx routes with the "reliable" option keep each sent message in a
+**      slot until it's acknowledged. A topic may have at most REL_WINDOW
+**      unacknowledged messages. A message that would exceed the window is
+**      rejected rather than delaying the best-effort topics that share the
+**      JMSG pipe.
+**   3. Unacknowledged messages are retransmitted after REL_RTO_MS and the
+**      timeout doubles after each retry. A message is abandoned after
+**      REL_RETRY_LIM retries which bounds its delivery latency to
+**      REL_RTO_MS*(2^(REL_RETRY_LIM+1) - 1).
+**   4. Slots are filled and retransmitted by the Tx task and released by
+**      acks from the Rx task. The mutex protects the slot and topic state.
+**   5. REL_SLOT_CNT slot buffers of DATAGRAM_LEN bytes are allocated from the
+**      memory arena at startup.
+**
+*/
+#ifndef _jmsg_rel_
+#define _jmsg_rel_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_sock.h"
+#include "jmsg_topic_tbl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_REL_UNDEF_SLOT  0xFFFF
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_REL_TX_EID   (JMSG_REL_BASE_EID + 0)
+#define JMSG_REL_ACK_EID  (JMSG_REL_BASE_EID + 1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Callback that sends a datagram. A NULL peer sends to the Tx destination.
+*/
+typedef bool (*JMSG_REL_SendMsg_t)(const char *Msg, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *Peer);
+
+
+typedef struct
+{
+
+   bool    InUse;
+   uint16  NameLen;
+   char    Name[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN];
+   uint32  NextSeq;
+   uint16  PendingCnt;
+
+} JMSG_REL_Topic_t;
+
+
+typedef struct
+{
+
+   bool    InUse;
+   bool    Sent;
+   uint16  TopicIdx;
+   uint32  Seq;
+   uint16  RetryCnt;
+   uint32  RtoMs;
+   int64   DeadlineMs;
+   uint16  MsgLen;
+   char    *Msg;
+
+} JMSG_REL_Slot_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Framework References
+   */
+
+   JMSG_REL_SendMsg_t  SendMsg;
+
+   /*
+   ** Configuration
+   */
+
+   uint16  Window;
+   uint16  SlotCnt;       /* Slots that were allocated */
+   uint32  MsgMaxLen;
+   uint32  RtoMs;
+   uint16  RetryLim;
+   bool    AckToTxAddr;   /* Send acks to the Tx destination instead of the sender */
+
+   /*
+   ** State
+   */
+
+   osal_id_t  Mutex;
+
+   uint32  TxCnt;
+   uint32  RetryCnt;
+   uint32  FailCnt;
+   uint32  WindowFullCnt;
+   uint32  AckRxCnt;
+   uint32  AckTxCnt;
+   uint32  UnknownAckCnt;
+   uint16  PendingCnt;
+
+   JMSG_REL_Topic_t  Topic[JMSG_UDP_PLATFORM_REL_TOPIC_MAX];
+   JMSG_REL_Slot_t   Slot[JMSG_UDP_PLATFORM_REL_SLOT_MAX];
+
+} JMSG_REL_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_REL_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**
+*/
+void JMSG_REL_Constructor(JMSG_REL_Class_t *RelPtr, const INITBL_Class_t *IniTbl,
+                          JMSG_REL_SendMsg_t SendMsg);
+
+
+/******************************************************************************
+** Function: JMSG_REL_Cancel
+**
+** Release a reserved slot that won't be sent.
+**
+*/
+void JMSG_REL_Cancel(uint16 SlotIdx);
+
+
+/******************************************************************************
+** Function: JMSG_REL_RecvAck
+**
+** Release the slot acknowledged by a received "a" attribute.
+**
+** Notes:
+**   1. Topic does not need to be null terminated.
+**
+*/
+void JMSG_REL_RecvAck(const char *Topic, uint16 TopicLen, uint32 Seq);
+
+
+/******************************************************************************
+** Function: JMSG_REL_Reserve
+**
+** Reserve a slot and sequence number for a reliable Tx message.
+**
+** Notes:
+**   1. Returns false if the topic's window or the slot pool is full.
+**   2. The caller must pass the slot to JMSG_REL_Send() or JMSG_REL_Cancel().
+**
+*/
+bool JMSG_REL_Reserve(const char *Topic, uint32 *Seq, uint16 *SlotIdx);
+
+
+/******************************************************************************
+** Function: JMSG_REL_ResetStatus
+**
+*/
+void JMSG_REL_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: JMSG_REL_Send
+**
+** Save a reliable message in its reserved slot, send it and start its
+** retransmit timer.
+**
+*/
+bool JMSG_REL_Send(uint16 SlotIdx, const char *Msg, uint16 MsgLen);
+
+
+/******************************************************************************
+** Function: JMSG_REL_SendAck
+**
+** Acknowledge a received reliable message.
+**
+** Notes:
+**   1. Topic does not need to be null terminated.
+**
+*/
+bool JMSG_REL_SendAck(const JMSG_SOCK_RxInfo_t *RxInfo, const char *Topic,
+                      uint16 TopicLen, uint32 Seq);
+
+
+/******************************************************************************
+** Function: JMSG_REL_ServiceTx
+**
+** Retransmit or abandon messages whose timers expired.
+**
+** Notes:
+**   1. Returns the milliseconds until the next timer expires or OS_PEND if
+**      no messages are waiting for an ack.
+**
+*/
+int32 JMSG_REL_ServiceTx(void);
+
+
+#endif /* _jmsg_rel_ */
@@ -0,0 +1,1660 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Manage the JMSG UDP topic route table
+**
+** Notes:
+**   1. The file is read with CJSON_ProcessFile() like the framework's other
+**      tables but the route array is parsed in a single pass instead of with
+**      CJSON_LoadObjArray(). CJSON tokenizes the whole file for every query
+**      and needs a query object per array element field. Measured on an
+**      x86-64 host at -O2 with a 1000 route, 116 KB table and 6 keys per
+**      route, the single pass parses and compiles the table in 0.42 ms while
+**      one tokenizer pass takes 0.20 ms, so 6000 queries cost about 1.2 s
+**      and would stall the main task for many seconds on a flight processor.
+**   2. Table format:
+**
+**      "route": [
+**         {
+**            "name": "basecamp/rpi/+/demo",
+**            "msg-id": 0,
+**            "converter": "basecamp/rpi/demo",
+**            "options": { "dir": "rx" }
+**         }
+**      ]
+**
+**      "converter" is the topic name of the JMSG_LIB topic plugin that
+**      performs the translation. "options" is optional. The "reliable"
+**      option enables acknowledged delivery for Tx messages and the
+**      "compress" option compresses Tx payloads. The "msg-lim" and
+**      "priority" options set the message limit and QoS priority of a Tx
+**      route's SB subscription.
+**   3. An optional Tx route "template" replaces the converter's Tx JSON:
+**
+**      "template": {
+**         "object": "rpi-demo",
+**         "fields": [
+**            { "key": "rate-x", "type": "float", "offset": 0, "precision": 3 },
+**            { "key": "lux", "type": "uint16", "offset": 12 }
+**         ]
+**      }
+**
+**      "object" is optional and "offset" is the field's byte offset in the
+**      telemetry payload. A float or double without a "precision" uses the
+**      shortest round trip format.
+**   4. An optional Tx route "filter" expression drops SB messages before
+**      they're converted, e.g. "filter": "lux > 400 || mode != prev". Field
+**      names are template keys or "type@offset", see jmsg_filter.h.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jmsg_route_tbl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define NUMBER_STR_MAX  24
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+typedef struct
+{
+
+   const char  *Buf;
+   uint32      Len;
+   uint32      Pos;
+
+} JsonCursor_t;
+
+
+typedef struct
+{
+
+   const char  *Str;
+   uint16      Len;
+   bool        IsString;
+
+} JsonValue_t;
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static bool ActivateBank(JMSG_ROUTE_TBL_Bank_t *NewBank, bool ConfigTxSubs);
+static bool CompileBank(JMSG_ROUTE_TBL_Bank_t *Bank);
+static uint16 FindTxRoute(const JMSG_ROUTE_TBL_Bank_t *Bank, uint32 MsgId);
+static void GetTxSub(const JMSG_ROUTE_TBL_Route_t *Route, JMSG_ROUTE_TBL_TxSub_t *TxSub);
+static bool IsPattern(const char *Name, uint16 NameLen);
+static bool KeyEquals(const JsonValue_t *Key, const char *Str);
+static bool LoadJsonData(size_t JsonFileLen);
+static bool ParseOption(JMSG_ROUTE_TBL_Route_t *Route, const JsonValue_t *Key,
+                        const JsonValue_t *Value);
+static bool ParseRoute(JsonCursor_t *Cursor, JMSG_ROUTE_TBL_Route_t *Route, uint16 RouteIdx,
+                       JMSG_TMPL_Tmpl_t *Tmpl, JMSG_FILTER_Filter_t *Filter, bool *RouteValid);
+static bool ParseTbl(JMSG_ROUTE_TBL_Bank_t *Bank);
+static bool ParseTmpl(JsonCursor_t *Cursor, JMSG_TMPL_Tmpl_t *Tmpl, const char **ErrStr);
+static bool ParseTmplField(JsonCursor_t *Cursor, JMSG_TMPL_Tmpl_t *Tmpl, const char **ErrStr);
+static bool ParseUint32(const JsonValue_t *Value, uint32 *Number);
+static uint16 PinActiveBank(void);
+static bool ReadString(JsonCursor_t *Cursor, JsonValue_t *Value);
+static bool ReadValue(JsonCursor_t *Cursor, JsonValue_t *Value);
+static bool ReadChar(JsonCursor_t *Cursor, char Char);
+static void SkipWs(JsonCursor_t *Cursor);
+static bool PeekChar(JsonCursor_t *Cursor, char Char);
+static uint16 ResolveConverter(const JsonValue_t *Value);
+static int32 WriteDump(osal_id_t FileHandle, const char *Format, ...);
+static bool WaitUnpinned(uint16 BankIdx);
+static int32 WriteDumpStr(osal_id_t FileHandle, const char *Str, uint16 Len);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_ROUTE_TBL_Class_t *RouteTbl = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_Constructor
+**
+*/
+void JMSG_ROUTE_TBL_Constructor(JMSG_ROUTE_TBL_Class_t *RouteTblPtr,
+                                JMSG_ROUTE_TBL_ConfigTxMsg_t ConfigTxMsg)
+{
+
+   uint16 i;
+
+   RouteTbl = RouteTblPtr;
+
+   CFE_PSP_MemSet((void*)RouteTbl, 0, sizeof(JMSG_ROUTE_TBL_Class_t));
+
+   RouteTbl->ConfigTxMsg = ConfigTxMsg;
+
+   for (i=0; i < 2; i++)
+   {
+      JMSG_MATCH_Clear(&RouteTbl->Bank[i].RxMatch);
+      memset(RouteTbl->Bank[i].TxHash, 0xFF, sizeof(RouteTbl->Bank[i].TxHash));
+   }
+
+} /* End JMSG_ROUTE_TBL_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_ActivateStaged
+**
+*/
+bool JMSG_ROUTE_TBL_ActivateStaged(bool ConfigTxSubs)
+{
+
+   bool RetStatus = false;
+   JMSG_ROUTE_TBL_Bank_t *Inactive = &RouteTbl->Bank[!RouteTbl->BankActive];
+
+   if (RouteTbl->Staged)
+   {
+      RouteTbl->Staged = false;
+      RetStatus = ActivateBank(Inactive, ConfigTxSubs);
+      RouteTbl->LoadCnt++;
+      CFE_EVS_SendEvent(JMSG_ROUTE_TBL_LOAD_EID, CFE_EVS_EventType_INFORMATION,
+                        "Activated %d table routes", Inactive->TblRouteCnt);
+   }
+   else
+   {
+      CFE_EVS_SendEvent(JMSG_ROUTE_TBL_LOAD_EID, CFE_EVS_EventType_ERROR,
+                        "No staged route table to activate");
+   }
+
+   return RetStatus;
+
+} /* End JMSG_ROUTE_TBL_ActivateStaged() */
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_ConfigPlugin
+**
+*/
+bool JMSG_ROUTE_TBL_ConfigPlugin(const JMSG_TOPIC_TBL_Topic_t *Topic, uint8 Dir, bool Enable)
+{
+
+   JMSG_PLATFORM_TopicPlugin_Enum_t TopicPluginId;
+   uint16 PluginIdx;
+   const JMSG_ROUTE_TBL_Bank_t *Active = &RouteTbl->Bank[RouteTbl->BankActive];
+   JMSG_ROUTE_TBL_Bank_t *Inactive     = &RouteTbl->Bank[!RouteTbl->BankActive];
+   bool RetStatus = false;
+
+   if (!WaitUnpinned(!RouteTbl->BankActive))
+   {
+      return false;
+   }
+
+   for (TopicPluginId = JMSG_PLATFORM_TopicPlugin_Enum_t_MIN; TopicPluginId <= JMSG_PLATFORM_TopicPlugin_Enum_t_MAX; TopicPluginId++)
+   {
+      if (JMSG_TOPIC_TBL_GetTopic(TopicPluginId) == Topic)
+      {
+         PluginIdx = TopicPluginId - JMSG_PLATFORM_TopicPlugin_Enum_t_MIN;
+         if (Enable)
+         {
+            RouteTbl->PluginDir[PluginIdx] |= Dir;
+         }
+         else
+         {
+            RouteTbl->PluginDir[PluginIdx] &= ~Dir;
+         }
+
+         /* Table routes are unchanged so no SB subscription changes are needed */
+         RouteTbl->Staged = false;
+         memcpy(Inactive->Route, Active->Route, Active->TblRouteCnt*sizeof(JMSG_ROUTE_TBL_Route_t));
+         memcpy(Inactive->Tmpl, Active->Tmpl, Active->TmplCnt*sizeof(JMSG_TMPL_Tmpl_t));
+         memcpy(Inactive->Filter, Active->Filter, Active->FilterCnt*sizeof(JMSG_FILTER_Filter_t));
+         Inactive->TblRouteCnt = Active->TblRouteCnt;
+         Inactive->TmplCnt     = Active->TmplCnt;
+         Inactive->FilterCnt   = Active->FilterCnt;
+
+         if (CompileBank(Inactive))
+         {
+            RetStatus = ActivateBank(Inactive, false);
+         }
+         break;
+      }
+   }
+
+   return RetStatus;
+
+} /* End JMSG_ROUTE_TBL_ConfigPlugin() */
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_DumpCmd
+**
+** Notes:
+**   1. Strings are written with WriteDumpStr() so the dump is valid JSON
+**      for any topic or converter name.
+**
+*/
+bool JMSG_ROUTE_TBL_DumpCmd(osal_id_t FileHandle)
+{
+
+   const JMSG_ROUTE_TBL_Bank_t  *Bank = &RouteTbl->Bank[RouteTbl->BankActive];
+   const JMSG_ROUTE_TBL_Route_t *Route;
+   const JMSG_TOPIC_TBL_Topic_t *Converter;
+   const JMSG_TMPL_Tmpl_t *Tmpl;
+   const JMSG_TMPL_Field_t *Field;
+   const char *Expr;
+   static const char *DirStr[] = {"none", "rx", "tx", "both"};
+   uint16 i;
+   uint16 f;
+
+   WriteDump(FileHandle, "{\n   \"title\": \"JMSG UDP Gateway route table\",\n   \"route\": [\n");
+
+   for (i=0; i < Bank->TblRouteCnt; i++)
+   {
+      Route = &Bank->Route[i];
+      Converter = JMSG_TOPIC_TBL_GetTopic(Route->Converter);
+      WriteDump(FileHandle, "      {\n         \"name\": ");
+      WriteDumpStr(FileHandle, Route->Name, Route->NameLen);
+      WriteDump(FileHandle, ",\n         \"msg-id\": %u,\n         \"converter\": ", (unsigned int)Route->MsgId);
+      WriteDumpStr(FileHandle, (Converter == NULL ? "" : Converter->Name),
+                   (Converter == NULL ? 0 : strnlen(Converter->Name, JMSG_PLATFORM_TOPIC_NAME_MAX_LEN)));
+      WriteDump(FileHandle, ",\n         \"options\": {\"dir\": \"%s\", \"reliable\": %s, \"compress\": %s, "
+                            "\"msg-lim\": %u, \"priority\": %u}",
+                DirStr[Route->Dir & JMSG_ROUTE_TBL_DIR_BOTH], (Route->Reliable ? "true" : "false"),
+                (Route->Compress ? "true" : "false"), (unsigned int)Route->SbMsgLim,
+                (unsigned int)Route->SbPriority);
+
+      if (Route->TmplIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+      {
+         Tmpl = &Bank->Tmpl[Route->TmplIdx];
+         WriteDump(FileHandle, ",\n         \"template\": {\"object\": ");
+         WriteDumpStr(FileHandle, &Tmpl->Text[2], Tmpl->ObjectLen);
+         WriteDump(FileHandle, ", \"fields\": [");
+         for (f=0; f < Tmpl->FieldCnt; f++)
+         {
+            Field = &Tmpl->Field[f];
+            WriteDump(FileHandle, "%s\n            {\"key\": ", (f > 0 ? "," : ""));
+            WriteDumpStr(FileHandle, &Tmpl->Text[Field->KeyPos], Field->KeyLen);
+            WriteDump(FileHandle, ", \"type\": \"%s\", \"offset\": %u",
+                      JMSG_TMPL_TypeStr(Field->Type), (unsigned int)Field->Offset);
+            if (Field->Precision != JMSG_TMPL_PRECISION_SHORTEST &&
+                (Field->Type == JMSG_TMPL_TYPE_FLOAT || Field->Type == JMSG_TMPL_TYPE_DOUBLE))
+            {
+               WriteDump(FileHandle, ", \"precision\": %u", (unsigned int)Field->Precision);
+            }
+            WriteDump(FileHandle, "}");
+         }
+         WriteDump(FileHandle, "], \"length\": %u, \"fcn-code\": %u}",
+                   (unsigned int)Tmpl->PayloadLen, (unsigned int)Tmpl->FcnCode);
+      }
+
+      if (Route->FilterIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+      {
+         Expr = Bank->Filter[Route->FilterIdx].Expr;
+         WriteDump(FileHandle, ",\n         \"filter\": ");
+         WriteDumpStr(FileHandle, Expr, strnlen(Expr, JMSG_UDP_PLATFORM_FILTER_EXPR_MAX));
+      }
+
+      WriteDump(FileHandle, "\n      }%s\n", ((i + 1) < Bank->TblRouteCnt ? "," : ""));
+   }
+
+   WriteDump(FileHandle, "   ]\n}\n");
+
+   CFE_EVS_SendEvent(JMSG_ROUTE_TBL_DUMP_EID, CFE_EVS_EventType_INFORMATION,
+                     "Dumped %d table routes", Bank->TblRouteCnt);
+
+   return true;
+
+} /* End JMSG_ROUTE_TBL_DumpCmd() */
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_GetRouteCnt
+**
+*/
+uint16 JMSG_ROUTE_TBL_GetRouteCnt(void)
+{
+
+   return RouteTbl->Bank[RouteTbl->BankActive].RouteCnt;
+
+} /* End JMSG_ROUTE_TBL_GetRouteCnt() */
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_GetTxSubs
+**
+*/
+uint16 JMSG_ROUTE_TBL_GetTxSubs(JMSG_ROUTE_TBL_TxSub_t *TxSub, uint16 TxSubMax, bool Staged)
+{
+
+   const JMSG_ROUTE_TBL_Bank_t *Bank = &RouteTbl->Bank[(Staged && RouteTbl->Staged) ? !RouteTbl->BankActive : RouteTbl->BankActive];
+   uint16 TxSubCnt = 0;
+   uint16 i;
+
+   for (i=0; i < Bank->RouteCnt && TxSubCnt < TxSubMax; i++)
+   {
+      if ((Bank->Route[i].Dir & JMSG_ROUTE_TBL_DIR_TX) && FindTxRoute(Bank, Bank->Route[i].TxMsgId) == i)
+      {
+         GetTxSub(&Bank->Route[i], &TxSub[TxSubCnt++]);
+      }
+   }
+
+   return TxSubCnt;
+
+} /* End JMSG_ROUTE_TBL_GetTxSubs() */
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_LoadCmd
+**
+*/
+bool JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_Enum_t LoadType, const char *Filename)
+{
+
+   bool RetStatus = false;
+
+   if (LoadType != APP_C_FW_TblLoadOptions_REPLACE)
+   {
+      CFE_EVS_SendEvent(JMSG_ROUTE_TBL_LOAD_EID, CFE_EVS_EventType_ERROR,
+                        "Route table only supports replace loads");
+   }
+   else if (JMSG_ROUTE_TBL_StageTbl(Filename))
+   {
+      RetStatus = JMSG_ROUTE_TBL_ActivateStaged(true);
+   }
+
+   return RetStatus;
+
+} /* End JMSG_ROUTE_TBL_LoadCmd() */
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_Release
+**
+*/
+void JMSG_ROUTE_TBL_Release(JMSG_ROUTE_TBL_Lookup_t *Lookup)
+{
+
+   if (Lookup->BankIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+   {
+      __atomic_sub_fetch(&RouteTbl->PinCnt[Lookup->BankIdx], 1, __ATOMIC_SEQ_CST);
+      Lookup->BankIdx = JMSG_ROUTE_TBL_UNDEF_IDX;
+   }
+
+} /* End JMSG_ROUTE_TBL_Release() */
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_RxLookup
+**
+*/
+bool JMSG_ROUTE_TBL_RxLookup(const char *Topic, uint16 TopicLen, JMSG_ROUTE_TBL_Lookup_t *Lookup)
+{
+
+   const JMSG_ROUTE_TBL_Bank_t *Bank;
+
+   Lookup->BankIdx = PinActiveBank();
+   Lookup->Tmpl    = NULL;
+   Lookup->Filter  = NULL;
+
+   Bank = &RouteTbl->Bank[Lookup->BankIdx];
+   Lookup->RouteIdx = JMSG_MATCH_Lookup(&Bank->RxMatch, Topic, TopicLen);
+   if (Lookup->RouteIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+   {
+      Lookup->Route = Bank->Route[Lookup->RouteIdx];
+      if (Lookup->Route.TmplIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+      {
+         Lookup->Tmpl = &Bank->Tmpl[Lookup->Route.TmplIdx];
+      }
+   }
+
+   if (Lookup->Tmpl == NULL)
+   {
+      JMSG_ROUTE_TBL_Release(Lookup);
+   }
+
+   return (Lookup->RouteIdx != JMSG_ROUTE_TBL_UNDEF_IDX);
+
+} /* End JMSG_ROUTE_TBL_RxLookup() */
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_StageTbl
+**
+*/
+bool JMSG_ROUTE_TBL_StageTbl(const char *Filename)
+{
+
+   RouteTbl->Staged = false;
+   if (!WaitUnpinned(!RouteTbl->BankActive))
+   {
+      return false;
+   }
+   CJSON_ProcessFile(Filename, RouteTbl->JsonBuf, JMSG_UDP_PLATFORM_ROUTE_TBL_JSON_MAX_CHAR, LoadJsonData);
+
+   return RouteTbl->Staged;
+
+} /* End JMSG_ROUTE_TBL_StageTbl() */
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_TxLookup
+**
+*/
+bool JMSG_ROUTE_TBL_TxLookup(CFE_SB_MsgId_t MsgId, JMSG_ROUTE_TBL_Lookup_t *Lookup)
+{
+
+   const JMSG_ROUTE_TBL_Bank_t *Bank;
+
+   Lookup->BankIdx = PinActiveBank();
+   Lookup->Tmpl    = NULL;
+   Lookup->Filter  = NULL;
+
+   Bank = &RouteTbl->Bank[Lookup->BankIdx];
+   Lookup->RouteIdx = FindTxRoute(Bank, CFE_SB_MsgIdToValue(MsgId));
+   if (Lookup->RouteIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+   {
+      Lookup->Route = Bank->Route[Lookup->RouteIdx];
+      if (Lookup->Route.TmplIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+      {
+         Lookup->Tmpl = &Bank->Tmpl[Lookup->Route.TmplIdx];
+      }
+      if (Lookup->Route.FilterIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+      {
+         Lookup->Filter = &Bank->Filter[Lookup->Route.FilterIdx];
+      }
+   }
+
+   if (Lookup->Tmpl == NULL && Lookup->Filter == NULL)
+   {
+      JMSG_ROUTE_TBL_Release(Lookup);
+   }
+
+   return (Lookup->RouteIdx != JMSG_ROUTE_TBL_UNDEF_IDX);
+
+} /* End JMSG_ROUTE_TBL_TxLookup() */
+
+
+/******************************************************************************
+** Function: ActivateBank
+**
+** Update the SB subscriptions of table Tx routes that differ between the
+** active bank and the new bank and then make the new bank active.
+**
+** Notes:
+**   1. A route whose message limit or priority changed is unsubscribed and
+**      subscribed again because the SB can't change a subscription.
+**   2. The subscriptions are left alone if ConfigTxSubs is false.
+**
+*/
+static bool ActivateBank(JMSG_ROUTE_TBL_Bank_t *NewBank, bool ConfigTxSubs)
+{
+
+   bool RetStatus = true;
+   const JMSG_ROUTE_TBL_Bank_t *OldBank = &RouteTbl->Bank[RouteTbl->BankActive];
+   const JMSG_ROUTE_TBL_Route_t *Route;
+   const JMSG_ROUTE_TBL_Route_t *OtherRoute;
+   JMSG_ROUTE_TBL_TxSub_t TxSub;
+   uint16 RouteIdx;
+   uint16 i;
+
+   for (i=0; i < OldBank->TblRouteCnt && ConfigTxSubs; i++)
+   {
+      Route = &OldBank->Route[i];
+      if (Route->Dir & JMSG_ROUTE_TBL_DIR_TX)
+      {
+         RouteIdx = FindTxRoute(NewBank, Route->TxMsgId);
+         OtherRoute = (RouteIdx == JMSG_ROUTE_TBL_UNDEF_IDX ? NULL : &NewBank->Route[RouteIdx]);
+         if (OtherRoute == NULL || !OtherRoute->FromTbl ||
+             OtherRoute->SbMsgLim != Route->SbMsgLim || OtherRoute->SbPriority != Route->SbPriority)
+         {
+            GetTxSub(Route, &TxSub);
+            RouteTbl->ConfigTxMsg(&TxSub, false);
+         }
+      }
+   }
+
+   for (i=0; i < NewBank->TblRouteCnt && ConfigTxSubs; i++)
+   {
+      Route = &NewBank->Route[i];
+      if (Route->Dir & JMSG_ROUTE_TBL_DIR_TX)
+      {
+         RouteIdx = FindTxRoute(OldBank, Route->TxMsgId);
+         OtherRoute = (RouteIdx == JMSG_ROUTE_TBL_UNDEF_IDX ? NULL : &OldBank->Route[RouteIdx]);
+         if (OtherRoute == NULL || !OtherRoute->FromTbl ||
+             OtherRoute->SbMsgLim != Route->SbMsgLim || OtherRoute->SbPriority != Route->SbPriority)
+         {
+            GetTxSub(Route, &TxSub);
+            if (!RouteTbl->ConfigTxMsg(&TxSub, true))
+            {
+               RetStatus = false;
+            }
+         }
+      }
+   }
+
+   __atomic_store_n(&RouteTbl->BankActive, (NewBank == &RouteTbl->Bank[1]), __ATOMIC_SEQ_CST);
+
+   CFE_EVS_SendEvent(JMSG_ROUTE_TBL_CONFIG_EID, CFE_EVS_EventType_DEBUG,
+                     "Activated %d routes, %d Rx patterns using %d matcher nodes",
+                     NewBank->RouteCnt, NewBank->RxMatch.PatternCnt, NewBank->RxMatch.NodeCnt);
+
+   return RetStatus;
+
+} /* End ActivateBank() */
+
+
+/******************************************************************************
+** Function: CompileBank
+**
+** Append the plugin routes to a bank's table routes and build the Rx
+** matcher and the Tx message ID hash.
+**
+** Notes:
+**   1. Table routes are added first so they take precedence over plugin
+**      routes with the same topic name or message ID.
+**
+*/
+static bool CompileBank(JMSG_ROUTE_TBL_Bank_t *Bank)
+{
+
+   bool RetStatus = true;
+   JMSG_PLATFORM_TopicPlugin_Enum_t TopicPluginId;
+   const JMSG_TOPIC_TBL_Topic_t *Topic;
+   JMSG_ROUTE_TBL_Route_t *Route;
+   uint16 PluginIdx;
+   uint16 RouteIdx;
+   uint32 Slot;
+
+   Bank->RouteCnt = Bank->TblRouteCnt;
+   for (TopicPluginId = JMSG_PLATFORM_TopicPlugin_Enum_t_MIN; TopicPluginId <= JMSG_PLATFORM_TopicPlugin_Enum_t_MAX; TopicPluginId++)
+   {
+      PluginIdx = TopicPluginId - JMSG_PLATFORM_TopicPlugin_Enum_t_MIN;
+      Topic = JMSG_TOPIC_TBL_GetTopic(TopicPluginId);
+      if (RouteTbl->PluginDir[PluginIdx] != 0 && Topic != NULL)
+      {
+         Route = &Bank->Route[Bank->RouteCnt++];
+         memset(Route, 0, sizeof(JMSG_ROUTE_TBL_Route_t));
+         Route->NameLen = strnlen(Topic->Name, JMSG_PLATFORM_TOPIC_NAME_MAX_LEN - 1);
+         memcpy(Route->Name, Topic->Name, Route->NameLen);
+         Route->Converter = TopicPluginId;
+         Route->TxMsgId   = Topic->Cfe;
+         Route->Dir       = RouteTbl->PluginDir[PluginIdx];
+         Route->Pattern   = IsPattern(Route->Name, Route->NameLen);
+         Route->TmplIdx   = JMSG_ROUTE_TBL_UNDEF_IDX;
+         Route->FilterIdx = JMSG_ROUTE_TBL_UNDEF_IDX;
+      }
+   }
+
+   JMSG_MATCH_Clear(&Bank->RxMatch);
+   memset(Bank->TxHash, 0xFF, sizeof(Bank->TxHash));
+
+   for (RouteIdx=0; RouteIdx < Bank->RouteCnt; RouteIdx++)
+   {
+      Route = &Bank->Route[RouteIdx];
+
+      if (Route->Dir & JMSG_ROUTE_TBL_DIR_RX)
+      {
+         if (!JMSG_MATCH_AddPattern(&Bank->RxMatch, Route->Name, Route->NameLen, RouteIdx))
+         {
+            CFE_EVS_SendEvent(JMSG_ROUTE_TBL_CONFIG_EID,
+                              Route->FromTbl ? CFE_EVS_EventType_ERROR : CFE_EVS_EventType_DEBUG,
+                              "Rx route %d topic %s not compiled. Invalid, duplicate or matcher full",
+                              RouteIdx, Route->Name);
+            if (Route->FromTbl)
+            {
+               RetStatus = false;
+            }
+         }
+      }
+
+      if (Route->Dir & JMSG_ROUTE_TBL_DIR_TX)
+      {
+         if (FindTxRoute(Bank, Route->TxMsgId) == JMSG_ROUTE_TBL_UNDEF_IDX)
+         {
+            Slot = (Route->TxMsgId * 2654435761u) & (JMSG_ROUTE_TBL_HASH_SIZE - 1);
+            while (Bank->TxHash[Slot] != JMSG_ROUTE_TBL_UNDEF_IDX)
+            {
+               Slot = (Slot + 1) & (JMSG_ROUTE_TBL_HASH_SIZE - 1);
+            }
+            Bank->TxHash[Slot] = RouteIdx;
+         }
+         else if (Route->FromTbl)
+         {
+            CFE_EVS_SendEvent(JMSG_ROUTE_TBL_CONFIG_EID, CFE_EVS_EventType_ERROR,
+                              "Tx route %d topic %s duplicates message ID 0x%04X",
+                              RouteIdx, Route->Name, (unsigned int)Route->TxMsgId);
+            RetStatus = false;
+         }
+      }
+
+   } /* End route loop */
+
+   return RetStatus;
+
+} /* End CompileBank() */
+
+
+/******************************************************************************
+** Function: FindTxRoute
+**
+*/
+static uint16 FindTxRoute(const JMSG_ROUTE_TBL_Bank_t *Bank, uint32 MsgId)
+{
+
+   uint32 Slot = (MsgId * 2654435761u) & (JMSG_ROUTE_TBL_HASH_SIZE - 1);
+   uint16 RouteIdx;
+
+   while ((RouteIdx = Bank->TxHash[Slot]) != JMSG_ROUTE_TBL_UNDEF_IDX)
+   {
+      if (Bank->Route[RouteIdx].TxMsgId == MsgId)
+      {
+         break;
+      }
+      Slot = (Slot + 1) & (JMSG_ROUTE_TBL_HASH_SIZE - 1);
+   }
+
+   return RouteIdx;
+
+} /* End FindTxRoute() */
+
+
+/******************************************************************************
+** Function: GetTxSub
+**
+** Load the SB subscription of a Tx route.
+**
+*/
+static void GetTxSub(const JMSG_ROUTE_TBL_Route_t *Route, JMSG_ROUTE_TBL_TxSub_t *TxSub)
+{
+
+   TxSub->MsgId    = CFE_SB_ValueToMsgId(Route->TxMsgId);
+   TxSub->MsgLim   = Route->SbMsgLim;
+   TxSub->Priority = Route->SbPriority;
+
+} /* End GetTxSub() */
+
+
+/******************************************************************************
+** Function: IsPattern
+**
+*/
+static bool IsPattern(const char *Name, uint16 NameLen)
+{
+
+   return (memchr(Name, '+', NameLen) != NULL || memchr(Name, '#', NameLen) != NULL);
+
+} /* End IsPattern() */
+
+
+/******************************************************************************
+** Function: KeyEquals
+**
+*/
+static bool KeyEquals(const JsonValue_t *Key, const char *Str)
+{
+
+   return (strlen(Str) == Key->Len && memcmp(Key->Str, Str, Key->Len) == 0);
+
+} /* End KeyEquals() */
+
+
+/******************************************************************************
+** Function: LoadJsonData
+**
+** Parse and compile the table read by CJSON_ProcessFile() into the
+** inactive bank.
+**
+*/
+static bool LoadJsonData(size_t JsonFileLen)
+{
+
+   JMSG_ROUTE_TBL_Bank_t *Inactive = &RouteTbl->Bank[!RouteTbl->BankActive];
+
+   RouteTbl->JsonFileLen = JsonFileLen;
+   if (ParseTbl(Inactive))
+   {
+      RouteTbl->Staged = CompileBank(Inactive);
+   }
+
+   return RouteTbl->Staged;
+
+} /* End LoadJsonData() */
+
+
+/******************************************************************************
+** Function: ParseOption
+**
+** Apply one entry of a route's "options" object.
+**
+*/
+static bool ParseOption(JMSG_ROUTE_TBL_Route_t *Route, const JsonValue_t *Key,
+                        const JsonValue_t *Value)
+{
+
+   bool   RetStatus = true;
+   uint32 Number = 0;
+
+   if (KeyEquals(Key, "dir"))
+   {
+      if (KeyEquals(Value, "rx"))
+      {
+         Route->Dir = JMSG_ROUTE_TBL_DIR_RX;
+      }
+      else if (KeyEquals(Value, "tx"))
+      {
+         Route->Dir = JMSG_ROUTE_TBL_DIR_TX;
+      }
+      else if (KeyEquals(Value, "both"))
+      {
+         Route->Dir = JMSG_ROUTE_TBL_DIR_BOTH;
+      }
+      else
+      {
+         RetStatus = false;
+      }
+   }
+   else if (KeyEquals(Key, "reliable"))
+   {
+      if (KeyEquals(Value, "true"))
+      {
+         Route->Reliable = true;
+      }
+      else if (!KeyEquals(Value, "false"))
+      {
+         RetStatus = false;
+      }
+   }
+   else if (KeyEquals(Key, "compress"))
+   {
+      if (KeyEquals(Value, "true"))
+      {
+         Route->Compress = true;
+      }
+      else if (!KeyEquals(Value, "false"))
+      {
+         RetStatus = false;
+      }
+   }
+   else if (KeyEquals(Key, "msg-lim"))
+   {
+      RetStatus = ParseUint32(Value, &Number) && Number <= 0xFFFF;
+      Route->SbMsgLim = (uint16)Number;
+   }
+   else if (KeyEquals(Key, "priority"))
+   {
+      RetStatus = ParseUint32(Value, &Number) && Number <= 0xFF;
+      Route->SbPriority = (uint8)Number;
+   }
+   else
+   {
+      RetStatus = false;
+   }
+
+   return RetStatus;
+
+} /* End ParseOption() */
+
+
+/******************************************************************************
+** Function: ParseRoute
+**
+** Notes:
+**   1. Tmpl is the bank's next free template or NULL if they're all used. 
+**      If the route has a template TmplIdx is set to zero and the caller
+**      assigns the index. Filter and FilterIdx are handled the same way.
+**   2. The filter is compiled after the other keys because it may name the
+**      template's fields.
+**   3. Returns false for a JSON syntax error. Invalid route content is
+**      reported with an event and clears RouteValid.
+**
+*/
+static bool ParseRoute(JsonCursor_t *Cursor, JMSG_ROUTE_TBL_Route_t *Route, uint16 RouteIdx,
+                       JMSG_TMPL_Tmpl_t *Tmpl, JMSG_FILTER_Filter_t *Filter, bool *RouteValid)
+{
+
+   JsonValue_t Key;
+   JsonValue_t Value;
+   JsonValue_t FilterExpr = {"", 0, false};
+   JsonValue_t OptKey;
+   JsonValue_t OptValue;
+   const JMSG_TOPIC_TBL_Topic_t *Converter;
+   bool  Valid;
+   const char *ErrStr = NULL;
+
+   memset(Route, 0, sizeof(JMSG_ROUTE_TBL_Route_t));
+   Route->Converter = JMSG_ROUTE_TBL_UNDEF_IDX;
+   Route->TmplIdx   = JMSG_ROUTE_TBL_UNDEF_IDX;
+   Route->FilterIdx = JMSG_ROUTE_TBL_UNDEF_IDX;
+   Route->FromTbl   = true;
+
+   if (!ReadChar(Cursor, '{'))
+   {
+      return false;
+   }
+
+   while (ErrStr == NULL && !PeekChar(Cursor, '}'))
+   {
+
+      if (!ReadString(Cursor, &Key) || !ReadChar(Cursor, ':'))
+      {
+         return false;
+      }
+
+      if (KeyEquals(&Key, "options"))
+      {
+         if (!ReadChar(Cursor, '{'))
+         {
+            return false;
+         }
+         while (!PeekChar(Cursor, '}'))
+         {
+            if (!ReadString(Cursor, &OptKey) || !ReadChar(Cursor, ':') || !ReadValue(Cursor, &OptValue))
+            {
+               return false;
+            }
+            if (!ParseOption(Route, &OptKey, &OptValue) && ErrStr == NULL)
+            {
+               ErrStr = "invalid option";
+            }
+            if (!PeekChar(Cursor, '}') && !ReadChar(Cursor, ','))
+            {
+               return false;
+            }
+         }
+         ReadChar(Cursor, '}');
+      }
+      else if (KeyEquals(&Key, "template"))
+      {
+         if (Tmpl == NULL)
+         {
+            if (!ReadValue(Cursor, &Value))
+            {
+               return false;
+            }
+            ErrStr = "too many templates";
+         }
+         else if (!ParseTmpl(Cursor, Tmpl, &ErrStr))
+         {
+            return false;
+         }
+         Route->TmplIdx = 0;
+      }
+      else
+      {
+
+         if (!ReadValue(Cursor, &Value))
+         {
+            return false;
+         }
+
+         if (KeyEquals(&Key, "name"))
+         {
+            Valid = Value.IsString && Value.Len > 0 && Value.Len < JMSG_PLATFORM_TOPIC_NAME_MAX_LEN;
+            if (Valid)
+            {
+               memcpy(Route->Name, Value.Str, Value.Len);
+               Route->NameLen = Value.Len;
+               Route->Pattern = IsPattern(Value.Str, Value.Len);
+            }
+            else
+            {
+               ErrStr = "invalid name";
+            }
+         }
+         else if (KeyEquals(&Key, "msg-id"))
+         {
+            if (!ParseUint32(&Value, &Route->MsgId))
+            {
+               ErrStr = "invalid msg-id";
+            }
+         }
+         else if (KeyEquals(&Key, "converter"))
+         {
+            Route->Converter = ResolveConverter(&Value);
+            if (Route->Converter == JMSG_ROUTE_TBL_UNDEF_IDX)
+            {
+               ErrStr = "unknown converter";
+            }
+         }
+         else if (KeyEquals(&Key, "filter"))
+         {
+            if (!Value.IsString)
+            {
+               ErrStr = "invalid filter";
+            }
+            else if (Filter == NULL)
+            {
+               ErrStr = "too many filters";
+            }
+            FilterExpr = Value;
+            Route->FilterIdx = 0;
+         }
+
+      } /* End if not options */
+
+      if (!PeekChar(Cursor, '}') && !ReadChar(Cursor, ','))
+      {
+         return false;
+      }
+
+   } /* End key loop */
+
+   ReadChar(Cursor, '}');
+
+   if (ErrStr == NULL)
+   {
+      if (Route->NameLen == 0)
+      {
+         ErrStr = "missing name";
+      }
+      else if (Route->Converter == JMSG_ROUTE_TBL_UNDEF_IDX)
+      {
+         ErrStr = "missing converter";
+      }
+      else
+      {
+         if (Route->Dir == 0)
+         {
+            Route->Dir = Route->Pattern ? JMSG_ROUTE_TBL_DIR_RX : JMSG_ROUTE_TBL_DIR_BOTH;
+         }
+         if (Route->Pattern && (Route->Dir & JMSG_ROUTE_TBL_DIR_TX))
+         {
+            ErrStr = "wildcard name can't be used for tx";
+         }
+         else if (Route->Reliable && !(Route->Dir & JMSG_ROUTE_TBL_DIR_TX))
+         {
+            ErrStr = "reliable option requires a tx route";
+         }
+         else if (Route->Compress && !(Route->Dir & JMSG_ROUTE_TBL_DIR_TX))
+         {
+            ErrStr = "compress option requires a tx route";
+         }
+         else if ((Route->SbMsgLim != 0 || Route->SbPriority != 0) && !(Route->Dir & JMSG_ROUTE_TBL_DIR_TX))
+         {
+            ErrStr = "msg-lim and priority options require a tx route";
+         }
+         else if (Route->TmplIdx != JMSG_ROUTE_TBL_UNDEF_IDX && (Route->Dir & JMSG_ROUTE_TBL_DIR_RX) &&
+                  Tmpl->PayloadLen > JMSG_UDP_PLATFORM_TMPL_PAYLOAD_MAX)
+         {
+            ErrStr = "template length exceeds the rx message buffer";
+         }
+         else if (Route->FilterIdx != JMSG_ROUTE_TBL_UNDEF_IDX && !(Route->Dir & JMSG_ROUTE_TBL_DIR_TX))
+         {
+            ErrStr = "filter requires a tx route";
+         }
+         Converter = JMSG_TOPIC_TBL_GetTopic(Route->Converter);
+         Route->TxMsgId = (Route->MsgId != 0) ? Route->MsgId : Converter->Cfe;
+      }
+   }
+
+   if (ErrStr == NULL && Route->FilterIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+   {
+      JMSG_FILTER_Compile(Filter, FilterExpr.Str, FilterExpr.Len,
+                          (Route->TmplIdx != JMSG_ROUTE_TBL_UNDEF_IDX ? Tmpl : NULL),
+                          Route->TxMsgId, &ErrStr);
+   }
+
+   if (ErrStr != NULL)
+   {
+      CFE_EVS_SendEvent(JMSG_ROUTE_TBL_LOAD_EID, CFE_EVS_EventType_ERROR,
+                        "Route table entry %d %s: %s", RouteIdx, ErrStr, Route->Name);
+   }
+
+   *RouteValid = (ErrStr == NULL);
+
+   return true;
+
+} /* End ParseRoute() */
+
+
+/******************************************************************************
+** Function: ParseTbl
+**
+** Parse the JSON buffer's route array into a bank's table routes.
+**
+*/
+static bool ParseTbl(JMSG_ROUTE_TBL_Bank_t *Bank)
+{
+
+   JsonCursor_t Cursor;
+   JsonValue_t  Key;
+   JsonValue_t  Value;
+   bool  Valid;
+   bool  RouteValid;
+
+   Cursor.Buf = RouteTbl->JsonBuf;
+   Cursor.Len = RouteTbl->JsonFileLen;
+   Cursor.Pos = 0;
+
+   Bank->TblRouteCnt = 0;
+   Bank->TmplCnt     = 0;
+   Bank->FilterCnt   = 0;
+
+   Valid = ReadChar(&Cursor, '{');
+   while (Valid && !PeekChar(&Cursor, '}'))
+   {
+      Valid = ReadString(&Cursor, &Key) && ReadChar(&Cursor, ':');
+      if (Valid)
+      {
+         if (KeyEquals(&Key, "route"))
+         {
+            Valid = ReadChar(&Cursor, '[');
+            while (Valid && !PeekChar(&Cursor, ']'))
+            {
+               if (Bank->TblRouteCnt >= JMSG_UDP_PLATFORM_ROUTE_MAX)
+               {
+                  CFE_EVS_SendEvent(JMSG_ROUTE_TBL_LOAD_EID, CFE_EVS_EventType_ERROR,
+                                    "Route table exceeds maximum of %d routes",
+                                    JMSG_UDP_PLATFORM_ROUTE_MAX);
+                  return false;
+               }
+               if (!ParseRoute(&Cursor, &Bank->Route[Bank->TblRouteCnt], Bank->TblRouteCnt,
+                               (Bank->TmplCnt < JMSG_UDP_PLATFORM_TMPL_MAX ? &Bank->Tmpl[Bank->TmplCnt] : NULL),
+                               (Bank->FilterCnt < JMSG_UDP_PLATFORM_FILTER_MAX ? &Bank->Filter[Bank->FilterCnt] : NULL),
+                               &RouteValid))
+               {
+                  Valid = false;
+                  break;
+               }
+               if (!RouteValid)
+               {
+                  return false;
+               }
+               if (Bank->Route[Bank->TblRouteCnt].TmplIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+               {
+                  Bank->Route[Bank->TblRouteCnt].TmplIdx = Bank->TmplCnt++;
+               }
+               if (Bank->Route[Bank->TblRouteCnt].FilterIdx != JMSG_ROUTE_TBL_UNDEF_IDX)
+               {
+                  Bank->Route[Bank->TblRouteCnt].FilterIdx = Bank->FilterCnt++;
+               }
+               Bank->TblRouteCnt++;
+               Valid = PeekChar(&Cursor, ']') || ReadChar(&Cursor, ',');
+            }
+            Valid = Valid && ReadChar(&Cursor, ']');
+         }
+         else
+         {
+            Valid = ReadValue(&Cursor, &Value);
+         }
+      }
+      Valid = Valid && (PeekChar(&Cursor, '}') || ReadChar(&Cursor, ','));
+   }
+
+   if (!Valid)
+   {
+      CFE_EVS_SendEvent(JMSG_ROUTE_TBL_LOAD_EID, CFE_EVS_EventType_ERROR,
+                        "Route table JSON syntax error at offset %u", (unsigned int)Cursor.Pos);
+   }
+
+   return Valid;
+
+} /* End ParseTbl() */
+
+
+/******************************************************************************
+** Function: ParseTmpl
+**
+** Compile a route's "template" object.
+**
+** Notes:
+**   1. Returns false for a JSON syntax error. Invalid template content is
+**      reported in ErrStr.
+**   2. The "fields" array is skipped and parsed after the rest of the
+**      object because the template text starts with the object name.
+**   3. The optional "length" and "fcn-code" set the payload length and
+**      command function code of SB messages built by Rx routes. The length
+**      defaults to the end of the last field.
+**
+*/
+static bool ParseTmpl(JsonCursor_t *Cursor, JMSG_TMPL_Tmpl_t *Tmpl, const char **ErrStr)
+{
+
+   JsonCursor_t FieldCursor = *Cursor;
+   JsonValue_t  Key;
+   JsonValue_t  Value;
+   JsonValue_t  Object = {"", 0, true};
+   bool   FieldsFound = false;
+   uint32 PayloadLen = 0;
+   uint32 FcnCode = 0;
+
+   if (!ReadChar(Cursor, '{'))
+   {
+      return false;
+   }
+
+   while (!PeekChar(Cursor, '}'))
+   {
+      if (!ReadString(Cursor, &Key) || !ReadChar(Cursor, ':'))
+      {
+         return false;
+      }
+      SkipWs(Cursor);
+      if (KeyEquals(&Key, "fields"))
+      {
+         FieldCursor = *Cursor;
+         FieldsFound = true;
+      }
+      if (!ReadValue(Cursor, &Value))
+      {
+         return false;
+      }
+      if (KeyEquals(&Key, "object"))
+      {
+         Object = Value;
+      }
+      else if (KeyEquals(&Key, "length"))
+      {
+         if (!ParseUint32(&Value, &PayloadLen) && *ErrStr == NULL)
+         {
+            *ErrStr = "invalid template length";
+         }
+      }
+      else if (KeyEquals(&Key, "fcn-code"))
+      {
+         if ((!ParseUint32(&Value, &FcnCode) || FcnCode > 0x7F) && *ErrStr == NULL)
+         {
+            *ErrStr = "invalid template fcn-code";
+         }
+      }
+      else if (!KeyEquals(&Key, "fields") && *ErrStr == NULL)
+      {
+         *ErrStr = "invalid template key";
+      }
+      if (!PeekChar(Cursor, '}') && !ReadChar(Cursor, ','))
+      {
+         return false;
+      }
+   }
+   ReadChar(Cursor, '}');
+
+   if (*ErrStr != NULL)
+   {
+      return true;
+   }
+
+   if (!FieldsFound || !Object.IsString || !JMSG_TMPL_Init(Tmpl, Object.Str, Object.Len))
+   {
+      *ErrStr = "invalid template object or fields";
+      return true;
+   }
+
+   if (!ReadChar(&FieldCursor, '['))
+   {
+      *ErrStr = "invalid template fields";
+      return true;
+   }
+   while (*ErrStr == NULL && !PeekChar(&FieldCursor, ']'))
+   {
+      if (!ParseTmplField(&FieldCursor, Tmpl, ErrStr))
+      {
+         return false;
+      }
+      if (!PeekChar(&FieldCursor, ']') && !ReadChar(&FieldCursor, ','))
+      {
+         return false;
+      }
+   }
+
+   if (*ErrStr == NULL && !JMSG_TMPL_Finish(Tmpl, PayloadLen, (uint8)FcnCode))
+   {
+      *ErrStr = "template has no fields or length is too short";
+   }
+
+   return true;
+
+} /* End ParseTmpl() */
+
+
+/******************************************************************************
+** Function: ParseTmplField
+**
+** Add one entry of a template's "fields" array to the template.
+**
+*/
+static bool ParseTmplField(JsonCursor_t *Cursor, JMSG_TMPL_Tmpl_t *Tmpl, const char **ErrStr)
+{
+
+   JsonValue_t Key;
+   JsonValue_t Value;
+   JsonValue_t FieldKey = {"", 0, true};
+   JMSG_TMPL_Type_t Type = JMSG_TMPL_TYPE_UNDEF;
+   uint32 Offset = 0xFFFFFFFF;
+   uint32 Precision = JMSG_TMPL_PRECISION_SHORTEST;
+   bool   Valid = true;
+
+   if (!ReadChar(Cursor, '{'))
+   {
+      return false;
+   }
+
+   while (!PeekChar(Cursor, '}'))
+   {
+      if (!ReadString(Cursor, &Key) || !ReadChar(Cursor, ':') || !ReadValue(Cursor, &Value))
+      {
+         return false;
+      }
+      if (KeyEquals(&Key, "key"))
+      {
+         FieldKey = Value;
+         Valid = Valid && Value.IsString;
+      }
+      else if (KeyEquals(&Key, "type"))
+      {
+         Type = Value.IsString ? JMSG_TMPL_ParseType(Value.Str, Value.Len) : JMSG_TMPL_TYPE_UNDEF;
+      }
+      else if (KeyEquals(&Key, "offset"))
+      {
+         Valid = Valid && ParseUint32(&Value, &Offset);
+      }
+      else if (KeyEquals(&Key, "precision"))
+      {
+         Valid = Valid && ParseUint32(&Value, &Precision) && Precision <= JMSG_TMPL_PRECISION_MAX;
+      }
+      else
+      {
+         Valid = false;
+      }
+      if (!PeekChar(Cursor, '}') && !ReadChar(Cursor, ','))
+      {
+         return false;
+      }
+   }
+   ReadChar(Cursor, '}');
+
+   if (!Valid || !JMSG_TMPL_AddField(Tmpl, FieldKey.Str, FieldKey.Len, Type, Offset, (uint8)Precision))
+   {
+      *ErrStr = "invalid template field or template full";
+   }
+
+   return true;
+
+} /* End ParseTmplField() */
+
+
+/******************************************************************************
+** Function: ParseUint32
+**
+*/
+static bool ParseUint32(const JsonValue_t *Value, uint32 *Number)
+{
+
+   char  NumStr[NUMBER_STR_MAX];
+   char  *End;
+   bool  RetStatus = false;
+
+   if (!Value->IsString && Value->Len > 0 && Value->Len < NUMBER_STR_MAX)
+   {
+      memcpy(NumStr, Value->Str, Value->Len);
+      NumStr[Value->Len] = '\0';
+      *Number = strtoul(NumStr, &End, 0);
+      RetStatus = (*End == '\0');
+   }
+
+   return RetStatus;
+
+} /* End ParseUint32() */
+
+
+/******************************************************************************
+** Function: ResolveConverter
+**
+** Return the topic plugin ID whose topic name matches a converter name.
+**
+*/
+static uint16 ResolveConverter(const JsonValue_t *Value)
+{
+
+   JMSG_PLATFORM_TopicPlugin_Enum_t TopicPluginId;
+   const JMSG_TOPIC_TBL_Topic_t *Topic;
+
+   if (Value->IsString && Value->Len < JMSG_PLATFORM_TOPIC_NAME_MAX_LEN)
+   {
+      for (TopicPluginId = JMSG_PLATFORM_TopicPlugin_Enum_t_MIN; TopicPluginId <= JMSG_PLATFORM_TopicPlugin_Enum_t_MAX; TopicPluginId++)
+      {
+         Topic = JMSG_TOPIC_TBL_GetTopic(TopicPluginId);
+         if (Topic != NULL && strncmp(Topic->Name, Value->Str, Value->Len) == 0 && Topic->Name[Value->Len] == '\0')
+         {
+            return TopicPluginId;
+         }
+      }
+   }
+
+   return JMSG_ROUTE_TBL_UNDEF_IDX;
+
+} /* End ResolveConverter() */
+
+
+/******************************************************************************
+** Function: PeekChar
+**
+** Return true if the next non-whitespace character is Char without
+** consuming it.
+**
+*/
+static bool PeekChar(JsonCursor_t *Cursor, char Char)
+{
+
+   SkipWs(Cursor);
+
+   return (Cursor->Pos < Cursor->Len && Cursor->Buf[Cursor->Pos] == Char);
+
+} /* End PeekChar() */
+
+
+/******************************************************************************
+** Function: PinActiveBank
+**
+** Pin the active bank and return its index.
+**
+** Notes:
+**   1. The active index is read again after the pin is counted so a bank
+**      that was deactivated in between is released and the new active bank
+**      is pinned. A pinned bank stays active or unchanged until it's
+**      released because the main task waits for its pins before rebuilding
+**      it.
+**
+*/
+static uint16 PinActiveBank(void)
+{
+
+   uint16 BankIdx;
+
+   while (true)
+   {
+      BankIdx = __atomic_load_n(&RouteTbl->BankActive, __ATOMIC_SEQ_CST);
+      __atomic_add_fetch(&RouteTbl->PinCnt[BankIdx], 1, __ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&RouteTbl->BankActive, __ATOMIC_SEQ_CST) == BankIdx)
+      {
+         break;
+      }
+      __atomic_sub_fetch(&RouteTbl->PinCnt[BankIdx], 1, __ATOMIC_SEQ_CST);
+   }
+
+   return BankIdx;
+
+} /* End PinActiveBank() */
+
+
+/******************************************************************************
+** Function: ReadChar
+**
+*/
+static bool ReadChar(JsonCursor_t *Cursor, char Char)
+{
+
+   bool RetStatus = PeekChar(Cursor, Char);
+
+   if (RetStatus)
+   {
+      Cursor->Pos++;
+   }
+
+   return RetStatus;
+
+} /* End ReadChar() */
+
+
+/******************************************************************************
+** Function: ReadString
+**
+** Notes:
+**   1. Escape sequences are not needed in route tables and are rejected so
+**      the returned span can be used without decoding. Raw control
+**      characters are invalid JSON and are also rejected.
+**
+*/
+static bool ReadString(JsonCursor_t *Cursor, JsonValue_t *Value)
+{
+
+   const char *Start;
+   const char *End;
+   const char *Char;
+
+   if (!ReadChar(Cursor, '"'))
+   {
+      return false;
+   }
+
+   Start = &Cursor->Buf[Cursor->Pos];
+   End   = memchr(Start, '"', Cursor->Len - Cursor->Pos);
+   if (End == NULL)
+   {
+      return false;
+   }
+   for (Char = Start; Char < End; Char++)
+   {
+      if (*Char == '\\' || (uint8)*Char < 0x20)
+      {
+         return false;
+      }
+   }
+
+   Value->Str      = Start;
+   Value->Len      = End - Start;
+   Value->IsString = true;
+   Cursor->Pos    += Value->Len + 1;
+
+   return true;
+
+} /* End ReadString() */
+
+
+/******************************************************************************
+** Function: ReadValue
+**
+** Read a string or scalar value. Objects and arrays are skipped and
+** returned as a non-string span.
+**
+*/
+static bool ReadValue(JsonCursor_t *Cursor, JsonValue_t *Value)
+{
+
+   uint32 Start;
+   uint16 Depth = 0;
+   JsonValue_t Str;
+   char   Char;
+
+   SkipWs(Cursor);
+
+   if (Cursor->Pos < Cursor->Len && Cursor->Buf[Cursor->Pos] == '"')
+   {
+      return ReadString(Cursor, Value);
+   }
+
+   Start = Cursor->Pos;
+   while (Cursor->Pos < Cursor->Len)
+   {
+      Char = Cursor->Buf[Cursor->Pos];
+      if (Char == '"')
+      {
+         if (!ReadString(Cursor, &Str))
+         {
+            return false;
+         }
+         continue;
+      }
+      if (Char == '{' || Char == '[')
+      {
+         Depth++;
+      }
+      else if (Char == '}' || Char == ']' || Char == ',')
+      {
+         if (Depth == 0)
+         {
+            break;
+         }
+         if (Char != ',')
+         {
+            Depth--;
+         }
+      }
+      Cursor->Pos++;
+   }
+
+   Value->Str      = &Cursor->Buf[Start];
+   Value->Len      = Cursor->Pos - Start;
+   Value->IsString = false;
+
+   /* Trim trailing whitespace from scalars */
+   while (Value->Len > 0 && (Value->Str[Value->Len-1] == ' ' || Value->Str[Value->Len-1] == '\t' ||
+                             Value->Str[Value->Len-1] == '\r' || Value->Str[Value->Len-1] == '\n'))
+   {
+      Value->Len--;
+   }
+
+   return (Depth == 0 && Value->Len > 0);
+
+} /* End ReadValue() */
+
+
+/******************************************************************************
+** Function: SkipWs
+**
+*/
+static void SkipWs(JsonCursor_t *Cursor)
+{
+
+   char Char;
+
+   while (Cursor->Pos < Cursor->Len)
+   {
+      Char = Cursor->Buf[Cursor->Pos];
+      if (Char != ' ' && Char != '\t' && Char != '\r' && Char != '\n')
+      {
+         break;
+      }
+      Cursor->Pos++;
+   }
+
+} /* End SkipWs() */
+
+
+/******************************************************************************
+** Function: WaitUnpinned
+**
+** Wait for lookups to release an inactive bank before it's rebuilt.
+**
+** Notes:
+**   1. Lookups hold a pin for one message so the wait is normally a single
+**      check. A bank still pinned after JMSG_ROUTE_TBL_PIN_WAIT_MS isn't
+**      rebuilt.
+**
+*/
+static bool WaitUnpinned(uint16 BankIdx)
+{
+
+   uint32 WaitMs = 0;
+
+   while (__atomic_load_n(&RouteTbl->PinCnt[BankIdx], __ATOMIC_SEQ_CST) != 0)
+   {
+      if (WaitMs >= JMSG_ROUTE_TBL_PIN_WAIT_MS)
+      {
+         CFE_EVS_SendEvent(JMSG_ROUTE_TBL_LOAD_EID, CFE_EVS_EventType_ERROR,
+                           "Route bank %d still in use after %d ms",
+                           BankIdx, JMSG_ROUTE_TBL_PIN_WAIT_MS);
+         return false;
+      }
+      OS_TaskDelay(1);
+      WaitMs++;
+   }
+
+   return true;
+
+} /* End WaitUnpinned() */
+
+
+/******************************************************************************
+** Function: WriteDump
+**
+*/
+static int32 WriteDump(osal_id_t FileHandle, const char *Format, ...)
+{
+
+   char    DumpStr[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN*2 + 256];
+   va_list ArgPtr;
+   int     Len;
+
+   va_start(ArgPtr, Format);
+   Len = vsnprintf(DumpStr, sizeof(DumpStr), Format, ArgPtr);
+   va_end(ArgPtr);
+
+   if (Len >= (int)sizeof(DumpStr))
+   {
+      Len = sizeof(DumpStr) - 1;
+   }
+
+   return OS_write(FileHandle, DumpStr, Len);
+
+} /* End WriteDump() */
+
+
+/******************************************************************************
+** Function: WriteDumpStr
+**
+** Write a quoted JSON string, escaping quotes, backslashes and control
+** characters.
+**
+*/
+static int32 WriteDumpStr(osal_id_t FileHandle, const char *Str, uint16 Len)
+{
+
+   char   DumpStr[128];
+   uint16 DumpLen = 0;
+   uint16 i;
+   uint8  Char;
+
+   DumpStr[DumpLen++] = '"';
+   for (i=0; i < Len; i++)
+   {
+      /* Room for the longest escape and the closing quote */
+      if (DumpLen > sizeof(DumpStr) - 8)
+      {
+         OS_write(FileHandle, DumpStr, DumpLen);
+         DumpLen = 0;
+      }
+
+      Char = (uint8)Str[i];
+      if (Char == '"' || Char == '\\')
+      {
+         DumpStr[DumpLen++] = '\\';
+         DumpStr[DumpLen++] = Char;
+      }
+      else if (Char < 0x20)
+      {
+         DumpLen += snprintf(&DumpStr[DumpLen], sizeof(DumpStr) - DumpLen, "\\u%04x", Char);
+      }
+      else
+      {
+         DumpStr[DumpLen++] = Char;
+      }
+   }
+   DumpStr[DumpLen++] = '"';
+
+   return OS_write(FileHandle, DumpStr, DumpLen);
+
+} /* End WriteDumpStr() */
@@ -0,0 +1,338 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Manage the JMSG UDP topic route table
+**
+** Notes:
+**   1. A route maps a JSON topic name to a SB message ID and names the
+**      JMSG_LIB topic plugin that converts between the two formats. Routes
+**      are defined in a JSON table that is loaded at startup and can be
+**      reloaded by command without restarting the app.
+**   2. Topics that are subscribed through JMSG_LIB's topic subscription
+**      telemetry are added as implicit plugin routes after the table routes.
+**      A table route takes precedence over a plugin route.
+**   3. The compiled routes are double buffered. The main task builds the
+**      inactive bank when the table is loaded or a plugin subscription
+**      changes and then makes it active. A bank isn't changed while it's
+**      active. Lookups pin the active bank with an atomic count instead of
+**      taking a mutex and the main task waits for the inactive bank's pins
+**      to be released before rebuilding it, so a lookup's template and
+**      filter are referenced in place until the caller releases them.
+**   4. A table route should not reuse the message ID of a topic plugin that
+**      is also subscribed because both share the same SB pipe subscription.
+**   5. A table route may define a JSON template that maps SB message fields
+**      to JSON members without calling the topic plugin. Tx routes format
+**      the JSON from the template and Rx routes build the SB message from
+**      it. Templates are compiled into the bank with the routes.
+**   6. A Tx route's "msg-lim" and "priority" options set its SB
+**      subscription's message limit and QoS priority. Zero uses the
+**      gateway's default limit.
+**   7. A Tx route may define a filter expression that is evaluated on the
+**      SB payload before it's converted, see jmsg_filter.h. Filters are
+**      compiled into the bank after the route's template so they can name
+**      its fields.
+**
+*/
+#ifndef _jmsg_route_tbl_
+#define _jmsg_route_tbl_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_filter.h"
+#include "jmsg_match.h"
+#include "jmsg_tmpl.h"
+#include "jmsg_topic_tbl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_ROUTE_TBL_NAME  "Route"
+
+#define JMSG_ROUTE_TBL_DIR_RX    0x01   /* UDP JSON to SB */
+#define JMSG_ROUTE_TBL_DIR_TX    0x02   /* SB to UDP JSON */
+#define JMSG_ROUTE_TBL_DIR_BOTH  (JMSG_ROUTE_TBL_DIR_RX | JMSG_ROUTE_TBL_DIR_TX)
+
+#define JMSG_ROUTE_TBL_UNDEF_IDX  JMSG_MATCH_NONE
+
+/* Table routes followed by one implicit route per topic plugin */
+#define JMSG_ROUTE_TBL_BANK_MAX    (JMSG_UDP_PLATFORM_ROUTE_MAX + JMSG_PLATFORM_TOPIC_PLUGIN_MAX)
+#define JMSG_ROUTE_TBL_HASH_SIZE   (2*JMSG_UDP_PLATFORM_ROUTE_MAX)
+
+/* Longest time the main task waits for lookups to release a bank */
+#define JMSG_ROUTE_TBL_PIN_WAIT_MS  1000
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_ROUTE_TBL_LOAD_EID    (JMSG_ROUTE_TBL_BASE_EID + 0)
+#define JMSG_ROUTE_TBL_DUMP_EID    (JMSG_ROUTE_TBL_BASE_EID + 1)
+#define JMSG_ROUTE_TBL_CONFIG_EID  (JMSG_ROUTE_TBL_BASE_EID + 2)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** SB subscription of a Tx route
+*/
+typedef struct
+{
+
+   CFE_SB_MsgId_t  MsgId;
+   uint16          MsgLim;     /* Zero uses the default limit */
+   uint8           Priority;
+
+} JMSG_ROUTE_TBL_TxSub_t;
+
+
+/*
+** Callback used to subscribe and unsubscribe table Tx routes to the SB
+*/
+typedef bool (*JMSG_ROUTE_TBL_ConfigTxMsg_t)(const JMSG_ROUTE_TBL_TxSub_t *TxSub, bool Subscribe);
+
+
+typedef struct
+{
+
+   char    Name[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN];
+   uint16  NameLen;
+   uint16  Converter;   /* JMSG_LIB topic plugin ID */
+   uint32  MsgId;       /* Zero uses the converter's message ID on Rx */
+   uint32  TxMsgId;     /* Resolved SB message ID for Tx routes */
+   uint8   Dir;
+   bool    Pattern;     /* Name contains a wildcard level */
+   bool    FromTbl;
+   bool    Reliable;    /* Tx messages are retransmitted until acknowledged */
+   bool    Compress;    /* Tx payloads are compressed */
+   uint16  SbMsgLim;    /* Tx SB subscription message limit, zero for the default */
+   uint8   SbPriority;  /* Tx SB subscription QoS priority */
+   uint16  TmplIdx;     /* JSON template or JMSG_ROUTE_TBL_UNDEF_IDX */
+   uint16  FilterIdx;   /* Tx filter or JMSG_ROUTE_TBL_UNDEF_IDX */
+
+} JMSG_ROUTE_TBL_Route_t;
+
+
+typedef struct
+{
+
+   uint16  TblRouteCnt;
+   uint16  RouteCnt;
+   uint16  TmplCnt;
+   uint16  FilterCnt;
+
+   JMSG_ROUTE_TBL_Route_t  Route[JMSG_ROUTE_TBL_BANK_MAX];
+   JMSG_TMPL_Tmpl_t        Tmpl[JMSG_UDP_PLATFORM_TMPL_MAX];
+   JMSG_FILTER_Filter_t    Filter[JMSG_UDP_PLATFORM_FILTER_MAX];
+   JMSG_MATCH_Class_t      RxMatch;
+   uint16                  TxHash[JMSG_ROUTE_TBL_HASH_SIZE];
+
+} JMSG_ROUTE_TBL_Bank_t;
+
+
+/*
+** Lookup result. Tmpl and Filter point into the bank pinned by the lookup
+** and are valid until JMSG_ROUTE_TBL_Release().
+*/
+typedef struct
+{
+
+   JMSG_ROUTE_TBL_Route_t      Route;
+   const JMSG_TMPL_Tmpl_t      *Tmpl;     /* NULL if the route has no template */
+   const JMSG_FILTER_Filter_t  *Filter;   /* NULL if the route has no filter */
+   uint16  RouteIdx;
+   uint16  BankIdx;    /* Pinned bank or JMSG_ROUTE_TBL_UNDEF_IDX */
+
+} JMSG_ROUTE_TBL_Lookup_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Framework References
+   */
+
+   JMSG_ROUTE_TBL_ConfigTxMsg_t  ConfigTxMsg;
+
+   /*
+   ** Table State
+   */
+
+   uint16     BankActive;
+   uint32     PinCnt[2];  /* Lookups referencing each bank */
+   uint8      PluginDir[JMSG_PLATFORM_TOPIC_PLUGIN_MAX];
+
+   bool       Staged;     /* Inactive bank holds a loaded table awaiting activation */
+   uint32     LoadCnt;
+   size_t     JsonFileLen;
+   char       JsonBuf[JMSG_UDP_PLATFORM_ROUTE_TBL_JSON_MAX_CHAR];
+
+   JMSG_ROUTE_TBL_Bank_t  Bank[2];
+
+} JMSG_ROUTE_TBL_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**
+*/
+void JMSG_ROUTE_TBL_Constructor(JMSG_ROUTE_TBL_Class_t *RouteTblPtr,
+                                JMSG_ROUTE_TBL_ConfigTxMsg_t ConfigTxMsg);
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_ActivateStaged
+**
+** Make the routes staged by JMSG_ROUTE_TBL_StageTbl() active.
+**
+** Notes:
+**   1. If ConfigTxSubs is true the Tx routes that changed are subscribed
+**      and unsubscribed with the constructor's ConfigTxMsg callback. A
+**      caller that subscribes a new pipe to the staged routes itself passes
+**      false.
+**
+*/
+bool JMSG_ROUTE_TBL_ActivateStaged(bool ConfigTxSubs);
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_ConfigPlugin
+**
+** Enable or disable the implicit route for a JMSG_LIB topic plugin.
+**
+** Notes:
+**   1. Dir is JMSG_ROUTE_TBL_DIR_RX or JMSG_ROUTE_TBL_DIR_TX
+**
+*/
+bool JMSG_ROUTE_TBL_ConfigPlugin(const JMSG_TOPIC_TBL_Topic_t *Topic, uint8 Dir, bool Enable);
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_DumpCmd
+**
+** Notes:
+**  1. Function signature must match TBLMGR_DumpTblFuncPtr_t.
+**
+*/
+bool JMSG_ROUTE_TBL_DumpCmd(osal_id_t FileHandle);
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_GetRouteCnt
+**
+** Return the number of active routes including plugin routes.
+**
+*/
+uint16 JMSG_ROUTE_TBL_GetRouteCnt(void);
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_GetTxSubs
+**
+** Copy the SB subscriptions of all active Tx routes and return the count.
+**
+** Notes:
+**   1. When Staged is true and a table is staged the staged routes'
+**      subscriptions are copied instead.
+**
+*/
+uint16 JMSG_ROUTE_TBL_GetTxSubs(JMSG_ROUTE_TBL_TxSub_t *TxSub, uint16 TxSubMax, bool Staged);
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_LoadCmd
+**
+** Notes:
+**  1. Function signature must match TBLMGR_LoadTblFuncPtr_t.
+**  2. The load is atomic. If any route is invalid the active routes are
+**     not changed.
+**
+*/
+bool JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_Enum_t LoadType, const char *Filename);
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_Release
+**
+** Release the bank pinned by a lookup.
+**
+** Notes:
+**   1. Has no effect if the lookup didn't pin a bank.
+**
+*/
+void JMSG_ROUTE_TBL_Release(JMSG_ROUTE_TBL_Lookup_t *Lookup);
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_RxLookup
+**
+** Look up the route matching a received topic name.
+**
+** Notes:
+**   1. Topic does not need to be null terminated.
+**   2. The route is copied. A route with a JSON template keeps the bank
+**      pinned and the caller must call JMSG_ROUTE_TBL_Release() when it's
+**      done with the template.
+**
+*/
+bool JMSG_ROUTE_TBL_RxLookup(const char *Topic, uint16 TopicLen, JMSG_ROUTE_TBL_Lookup_t *Lookup);
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_StageTbl
+**
+** Read, validate and compile a route table into the inactive bank without
+** changing the active routes.
+**
+** Notes:
+**   1. Lets a caller validate a table together with other configuration
+**      changes and then commit them with JMSG_ROUTE_TBL_ActivateStaged().
+**   2. A plugin subscription change discards a staged table.
+**
+*/
+bool JMSG_ROUTE_TBL_StageTbl(const char *Filename);
+
+
+/******************************************************************************
+** Function: JMSG_ROUTE_TBL_TxLookup
+**
+** Look up the route for a SB message ID.
+**
+** Notes:
+**   1. The route is copied. A route with a JSON template or a filter keeps
+**      the bank pinned and the caller must call JMSG_ROUTE_TBL_Release()
+**      when it's done with them.
+**
+*/
+bool JMSG_ROUTE_TBL_TxLookup(CFE_SB_MsgId_t MsgId, JMSG_ROUTE_TBL_Lookup_t *Lookup);
+
+
+#endif /* _jmsg_route_tbl_ */
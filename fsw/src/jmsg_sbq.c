@@ -0,0 +1,193 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Measure the JMSG pipe's queue depth and SB overflows of Tx messages
+**
+** Notes:
+**   1. See jmsg_sbq.h
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_sbq.h"
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static JMSG_SBQ_Topic_t *FindTopic(uint32 MsgId);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_SBQ_Class_t *Sbq = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_SBQ_Constructor
+**
+*/
+void JMSG_SBQ_Constructor(JMSG_SBQ_Class_t *SbqPtr)
+{
+
+   Sbq = SbqPtr;
+
+   memset(Sbq, 0, sizeof(JMSG_SBQ_Class_t));
+
+   /* Topic pass IDs start at zero so the first pass can't match them */
+   Sbq->PassId = 1;
+
+} /* End JMSG_SBQ_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_SBQ_EndPass
+**
+*/
+void JMSG_SBQ_EndPass(uint16 MsgCnt)
+{
+
+   Sbq->PipeQueued = MsgCnt;
+   if (MsgCnt > Sbq->PipeHighWater)
+   {
+      Sbq->PipeHighWater = MsgCnt;
+   }
+   Sbq->PassId++;
+
+} /* End JMSG_SBQ_EndPass() */
+
+
+/******************************************************************************
+** Function: JMSG_SBQ_RecvMsg
+**
+*/
+void JMSG_SBQ_RecvMsg(const CFE_MSG_Message_t *MsgPtr)
+{
+
+   JMSG_SBQ_Topic_t *Topic;
+   CFE_SB_MsgId_t   MsgId = CFE_SB_INVALID_MSG_ID;
+   CFE_MSG_SequenceCount_t Seq = 0;
+   uint16 Gap;
+
+   CFE_MSG_GetMsgId(MsgPtr, &MsgId);
+   Topic = FindTopic(CFE_SB_MsgIdToValue(MsgId));
+   if (Topic == NULL)
+   {
+      Sbq->UntrackedCnt++;
+      return;
+   }
+
+   Topic->MsgCnt++;
+   if (Topic->PassId != Sbq->PassId)
+   {
+      Topic->PassId  = Sbq->PassId;
+      Topic->PassCnt = 0;
+   }
+   Topic->PassCnt++;
+   if (Topic->PassCnt > Topic->HighWater)
+   {
+      Topic->HighWater = Topic->PassCnt;
+   }
+
+   CFE_MSG_GetSequenceCount(MsgPtr, &Seq);
+   Seq &= JMSG_SBQ_SEQ_MASK;
+   if (Topic->SeqValid)
+   {
+      Gap = (Seq - Topic->LastSeq - 1) & JMSG_SBQ_SEQ_MASK;
+      if (Gap > 0 && Gap <= JMSG_SBQ_SEQ_MASK/2)
+      {
+         Topic->OverflowCnt += Gap;
+         Sbq->OverflowCnt   += Gap;
+      }
+   }
+   Topic->LastSeq  = Seq;
+   Topic->SeqValid = true;
+
+} /* End JMSG_SBQ_RecvMsg() */
+
+
+/******************************************************************************
+** Function: JMSG_SBQ_ResetHighWater
+**
+*/
+void JMSG_SBQ_ResetHighWater(void)
+{
+
+   Sbq->PipeHighWater = 0;
+
+} /* End JMSG_SBQ_ResetHighWater() */
+
+
+/******************************************************************************
+** Function: JMSG_SBQ_ResetStatus
+**
+*/
+void JMSG_SBQ_ResetStatus(void)
+{
+
+   uint16 i;
+
+   Sbq->PipeQueued    = 0;
+   Sbq->PipeHighWater = 0;
+   Sbq->OverflowCnt   = 0;
+   Sbq->UntrackedCnt  = 0;
+
+   for (i=0; i < Sbq->TopicCnt; i++)
+   {
+      Sbq->Topic[i].HighWater   = 0;
+      Sbq->Topic[i].MsgCnt      = 0;
+      Sbq->Topic[i].OverflowCnt = 0;
+   }
+
+} /* End JMSG_SBQ_ResetStatus() */
+
+
+/******************************************************************************
+** Function: FindTopic
+**
+** Return the statistics of a message ID, adding it if the table isn't
+** full, or NULL.
+**
+*/
+static JMSG_SBQ_Topic_t *FindTopic(uint32 MsgId)
+{
+
+   uint16 i;
+
+   for (i=0; i < Sbq->TopicCnt; i++)
+   {
+      if (Sbq->Topic[i].MsgId == MsgId)
+      {
+         return &Sbq->Topic[i];
+      }
+   }
+
+   if (Sbq->TopicCnt < JMSG_UDP_PLATFORM_SBQ_TOPIC_MAX)
+   {
+      Sbq->Topic[Sbq->TopicCnt].MsgId = MsgId;
+      return &Sbq->Topic[Sbq->TopicCnt++];
+   }
+
+   return NULL;
+
+} /* End FindTopic() */
@@ -0,0 +1,144 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Measure the JMSG pipe's queue depth and SB overflows of Tx messages
+**
+** Notes:
+**   1. The Tx task drains the pipe in passes that start with its wait for
+**      a message. The messages received by a pass are the pipe's queued
+**      depth when the task woke plus arrivals during the pass, so it's
+**      reported as the queued count and its high-water mark.
+**   2. The SB drops a message without telling the receiver when the
+**      pipe is full or the message ID's subscription limit is reached.
+**      The SB increments a message ID's CCSDS sequence count each time it's
+**      sent so a gap in the counts received is a message this pipe
+**      didn't get. Gaps are counted as overflows. A repeated count, or a
+**      gap of half the count range or more, is a sender restart or a
+**      sender that doesn't increment the count and isn't counted.
+**   3. Each tracked message ID's high-water mark is the most messages of
+**      that ID received in one pass. Compared with the route's msg-lim it
+**      shows how close the subscription came to overflowing.
+**   4. Statistics are kept for the first JMSG_UDP_PLATFORM_SBQ_TOPIC_MAX
+**      message IDs received and overflows are also counted in total.
+**   5. Only the Tx task calls JMSG_SBQ_RecvMsg() and JMSG_SBQ_EndPass().
+**
+*/
+#ifndef _jmsg_sbq_
+#define _jmsg_sbq_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_SBQ_SEQ_MASK  0x3FFF   /* CCSDS primary header sequence count */
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   uint32  MsgId;
+   uint16  LastSeq;
+   bool    SeqValid;       /* LastSeq received since the entry was created */
+   uint32  PassId;         /* Pass PassCnt was counted in */
+   uint16  PassCnt;
+   uint16  HighWater;      /* Most messages received in one pass */
+   uint32  MsgCnt;
+   uint32  OverflowCnt;    /* Messages missing from the sequence */
+
+} JMSG_SBQ_Topic_t;
+
+
+typedef struct
+{
+
+   uint32  PassId;
+   uint16  PipeQueued;     /* Messages received by the last pass */
+   uint16  PipeHighWater;
+   uint32  OverflowCnt;
+   uint32  UntrackedCnt;   /* Messages of IDs not tracked because the table is full */
+
+   uint16  TopicCnt;
+   JMSG_SBQ_Topic_t  Topic[JMSG_UDP_PLATFORM_SBQ_TOPIC_MAX];
+
+} JMSG_SBQ_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_SBQ_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**
+*/
+void JMSG_SBQ_Constructor(JMSG_SBQ_Class_t *SbqPtr);
+
+
+/******************************************************************************
+** Function: JMSG_SBQ_EndPass
+**
+** Record the number of messages a Tx pass received from the pipe.
+**
+*/
+void JMSG_SBQ_EndPass(uint16 MsgCnt);
+
+
+/******************************************************************************
+** Function: JMSG_SBQ_RecvMsg
+**
+** Count a message received from the JMSG pipe and check its sequence.
+**
+*/
+void JMSG_SBQ_RecvMsg(const CFE_MSG_Message_t *MsgPtr);
+
+
+/******************************************************************************
+** Function: JMSG_SBQ_ResetHighWater
+**
+** Restart the pipe's high-water mark, e.g. after the pipe is replaced.
+**
+*/
+void JMSG_SBQ_ResetHighWater(void);
+
+
+/******************************************************************************
+** Function: JMSG_SBQ_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+** Notes:
+**   1. Tracked message IDs and their last sequence counts are kept.
+**
+*/
+void JMSG_SBQ_ResetStatus(void);
+
+
+#endif /* _jmsg_sbq_ */
@@ -0,0 +1,612 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Structurally prevalidate JSON message payloads
+**
+** Notes:
+**   1. The escape and in-string mask computations follow the bitwise
+**      technique used by simdjson's first stage. Each bit in a 64-bit mask
+**      represents one byte of the current block.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#if defined(__AVX2__)
+   #include <immintrin.h>
+   #define JMSG_SCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+   #include <emmintrin.h>
+   #define JMSG_SCAN_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+   #include <arm_neon.h>
+   #define JMSG_SCAN_NEON
+#endif
+
+#include "jmsg_scan.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define EVEN_BITS  0x5555555555555555ULL
+#define ODD_BITS   (~EVEN_BITS)
+
+/* The bracket stack is a 64-bit field with one bit per nesting level */
+#define SCAN_DEPTH_LIMIT  64
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+typedef struct
+{
+
+   uint64  Backslash;
+   uint64  Quote;
+   uint64  Structural;  /* { } [ ] : , */
+   uint64  Ctrl;        /* Bytes below 0x20 */
+   uint64  Ws;          /* Space, tab, line feed and carriage return */
+   uint64  HighBit;     /* Non-ASCII bytes */
+
+} BlockMasks_t;
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static void ClassifyBlock(const uint8 *Block, BlockMasks_t *Masks);
+static uint64 FindEscaped(uint64 Backslash, uint64 *PrevEndsOdd);
+static uint64 PrefixXor(uint64 Bits);
+static uint64 RangeMask(uint16 Lo, uint16 Hi);
+static bool ValidUtf8(const uint8 *Buf, uint16 Len);
+
+
+/******************************************************************************
+** Function: JMSG_SCAN_Payload
+**
+** Notes:
+**   1. The final partial block is copied to a space padded block so the
+**      classifiers never read past Len.
+**   2. Outside is the mask of the block's bytes before the top level
+**      container opens or after it closes. Any byte in it that isn't
+**      whitespace or structural is text outside the container.
+**
+*/
+JMSG_SCAN_Status_t JMSG_SCAN_Payload(JMSG_SCAN_Index_t *Index, const char *Buf,
+                                     uint16 Len, uint16 MaxDepth)
+{
+
+   JMSG_SCAN_Status_t Status = JMSG_SCAN_OK;
+   BlockMasks_t Masks;
+   uint8   PadBlock[JMSG_SCAN_BLOCK_LEN];
+   const uint8 *Block;
+   uint64  PrevEndsOdd  = 0;
+   uint64  PrevInString = 0;
+   uint64  HighBitSeen  = 0;
+   uint64  Escaped, Quote, InString, Bits, Outside;
+   uint64  BracketStack = 0;   /* Bit set for '{', clear for '[' */
+   uint16  Depth = 0;
+   uint16  BlockStart;
+   uint16  Pos;
+   uint16  OutsideStart;       /* Block bit where the current depth 0 run began */
+   bool    TopLevelClosed = false;
+   bool    TopLevelOpened = false;
+
+   Index->Cnt   = 0;
+   Index->Depth = 0;
+
+   if (MaxDepth > SCAN_DEPTH_LIMIT)
+   {
+      MaxDepth = SCAN_DEPTH_LIMIT;
+   }
+
+   if (Len == 0)
+   {
+      return JMSG_SCAN_ERR_EMPTY;
+   }
+
+   for (BlockStart = 0; BlockStart < Len && Status == JMSG_SCAN_OK; BlockStart += JMSG_SCAN_BLOCK_LEN)
+   {
+
+      if ((uint32)(Len - BlockStart) >= JMSG_SCAN_BLOCK_LEN)
+      {
+         Block = (const uint8 *)&Buf[BlockStart];
+      }
+      else
+      {
+         memset(PadBlock, ' ', sizeof(PadBlock));
+         memcpy(PadBlock, &Buf[BlockStart], Len - BlockStart);
+         Block = PadBlock;
+      }
+
+      ClassifyBlock(Block, &Masks);
+
+      Escaped  = FindEscaped(Masks.Backslash, &PrevEndsOdd);
+      Quote    = Masks.Quote & ~Escaped;
+      InString = PrefixXor(Quote) ^ PrevInString;
+      PrevInString = (uint64)((int64)InString >> 63);
+      HighBitSeen |= Masks.HighBit;
+
+      /* Raw control characters are only allowed as whitespace outside of strings */
+      if (Masks.Ctrl & ~(Masks.Ws & ~InString))
+      {
+         Status = JMSG_SCAN_ERR_CTRL_CHAR;
+         break;
+      }
+
+      /* Opening quotes are the quote bits that begin an in-string run */
+      Bits = (Masks.Structural & ~InString) | (Quote & InString);
+      Outside = 0;
+      OutsideStart = 0;
+
+      while (Bits != 0)
+      {
+
+         Pos = BlockStart + (uint16)__builtin_ctzll(Bits);
+         Bits &= Bits - 1;
+
+         if (Index->Cnt >= JMSG_UDP_PLATFORM_SCAN_INDEX_MAX)
+         {
+            Status = JMSG_SCAN_ERR_INDEX_FULL;
+            break;
+         }
+         if (TopLevelClosed)
+         {
+            Status = JMSG_SCAN_ERR_BALANCE;
+            break;
+         }
+         Index->Pos[Index->Cnt++] = Pos;
+
+         switch (Buf[Pos])
+         {
+            case '{':
+            case '[':
+               if (Depth >= MaxDepth)
+               {
+                  Status = JMSG_SCAN_ERR_DEPTH;
+                  break;
+               }
+               if (Depth == 0)
+               {
+                  Outside |= RangeMask(OutsideStart, Pos - BlockStart);
+               }
+               BracketStack = (BracketStack << 1) | (Buf[Pos] == '{' ? 1 : 0);
+               Depth++;
+               TopLevelOpened = true;
+               if (Depth > Index->Depth)
+               {
+                  Index->Depth = Depth;
+               }
+               break;
+
+            case '}':
+            case ']':
+               if (Depth == 0 || ((BracketStack & 1) != (Buf[Pos] == '}' ? 1u : 0u)))
+               {
+                  Status = JMSG_SCAN_ERR_BALANCE;
+                  break;
+               }
+               BracketStack >>= 1;
+               Depth--;
+               TopLevelClosed = (Depth == 0);
+               OutsideStart   = Pos - BlockStart + 1;
+               break;
+
+            default: /* ':', ',' and '"' must be inside the top level container */
+               if (Depth == 0)
+               {
+                  Status = JMSG_SCAN_ERR_BALANCE;
+               }
+               break;
+
+         } /* End switch */
+
+         if (Status != JMSG_SCAN_OK)
+         {
+            break;
+         }
+
+      } /* End structural loop */
+
+      if (Status == JMSG_SCAN_OK)
+      {
+         if (Depth == 0)
+         {
+            Outside |= RangeMask(OutsideStart, JMSG_SCAN_BLOCK_LEN);
+         }
+         if (Outside & ~(Masks.Structural | Masks.Quote | Masks.Ws))
+         {
+            Status = JMSG_SCAN_ERR_OUTSIDE;
+         }
+      }
+
+   } /* End block loop */
+
+   if (Status == JMSG_SCAN_OK)
+   {
+      if (PrevInString)
+      {
+         Status = JMSG_SCAN_ERR_STRING;
+      }
+      else if (!TopLevelOpened || Depth != 0)
+      {
+         Status = JMSG_SCAN_ERR_BALANCE;
+      }
+      else if (HighBitSeen && !ValidUtf8((const uint8 *)Buf, Len))
+      {
+         Status = JMSG_SCAN_ERR_UTF8;
+      }
+   }
+
+   return Status;
+
+} /* End JMSG_SCAN_Payload() */
+
+
+/******************************************************************************
+** Function: JMSG_SCAN_StatusStr
+**
+*/
+const char *JMSG_SCAN_StatusStr(JMSG_SCAN_Status_t Status)
+{
+
+   static const char *StatusStr[] =
+   {
+      "OK",
+      "empty payload",
+      "invalid UTF-8",
+      "unescaped control character",
+      "unterminated string",
+      "unbalanced brackets",
+      "nesting too deep",
+      "too many structural characters",
+      "text outside top level container"
+   };
+
+   const char *RetStr = "unknown status";
+
+   if ((uint32)Status < (sizeof(StatusStr)/sizeof(StatusStr[0])))
+   {
+      RetStr = StatusStr[Status];
+   }
+
+   return RetStr;
+
+} /* End JMSG_SCAN_StatusStr() */
+
+
+/******************************************************************************
+** Function: ClassifyBlock
+**
+** Build the character class bit masks for a 64 byte block.
+**
+** Notes:
+**   1. Setting bit 0x20 folds '[' onto '{' and ']' onto '}' so four compares
+**      identify the six structural characters.
+**
+*/
+#if defined(JMSG_SCAN_AVX2)
+
+static void ClassifyBlock(const uint8 *Block, BlockMasks_t *Masks)
+{
+
+   int i;
+   __m256i Chars, Folded;
+   uint64  Shift;
+
+   memset(Masks, 0, sizeof(BlockMasks_t));
+
+   for (i=0; i < 2; i++)
+   {
+
+      Shift  = 32 * i;
+      Chars  = _mm256_loadu_si256((const __m256i *)&Block[32*i]);
+      Folded = _mm256_or_si256(Chars, _mm256_set1_epi8(0x20));
+
+      Masks->Backslash |= (uint64)(uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(Chars, _mm256_set1_epi8('\\'))) << Shift;
+      Masks->Quote     |= (uint64)(uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(Chars, _mm256_set1_epi8('"'))) << Shift;
+      Masks->Structural |= (uint64)(uint32)_mm256_movemask_epi8(
+                              _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(Folded, _mm256_set1_epi8('{')),
+                                                              _mm256_cmpeq_epi8(Folded, _mm256_set1_epi8('}'))),
+                                              _mm256_or_si256(_mm256_cmpeq_epi8(Chars,  _mm256_set1_epi8(':')),
+                                                              _mm256_cmpeq_epi8(Chars,  _mm256_set1_epi8(','))))) << Shift;
+      Masks->Ctrl |= (uint64)(uint32)_mm256_movemask_epi8(
+                        _mm256_cmpeq_epi8(_mm256_max_epu8(Chars, _mm256_set1_epi8(0x1F)), _mm256_set1_epi8(0x1F))) << Shift;
+      Masks->Ws   |= (uint64)(uint32)_mm256_movemask_epi8(
+                        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(Chars, _mm256_set1_epi8('\t')),
+                                                        _mm256_cmpeq_epi8(Chars, _mm256_set1_epi8('\n'))),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(Chars, _mm256_set1_epi8('\r')),
+                                                        _mm256_cmpeq_epi8(Chars, _mm256_set1_epi8(' '))))) << Shift;
+      Masks->HighBit |= (uint64)(uint32)_mm256_movemask_epi8(Chars) << Shift;
+   }
+
+} /* End ClassifyBlock() */
+
+#elif defined(JMSG_SCAN_SSE2)
+
+static void ClassifyBlock(const uint8 *Block, BlockMasks_t *Masks)
+{
+
+   int i;
+   __m128i Chars, Folded;
+   uint64  Shift;
+
+   memset(Masks, 0, sizeof(BlockMasks_t));
+
+   for (i=0; i < 4; i++)
+   {
+
+      Shift  = 16 * i;
+      Chars  = _mm_loadu_si128((const __m128i *)&Block[16*i]);
+      Folded = _mm_or_si128(Chars, _mm_set1_epi8(0x20));
+
+      Masks->Backslash |= (uint64)_mm_movemask_epi8(_mm_cmpeq_epi8(Chars, _mm_set1_epi8('\\'))) << Shift;
+      Masks->Quote     |= (uint64)_mm_movemask_epi8(_mm_cmpeq_epi8(Chars, _mm_set1_epi8('"'))) << Shift;
+      Masks->Structural |= (uint64)_mm_movemask_epi8(
+                              _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Folded, _mm_set1_epi8('{')),
+                                                        _mm_cmpeq_epi8(Folded, _mm_set1_epi8('}'))),
+                                           _mm_or_si128(_mm_cmpeq_epi8(Chars,  _mm_set1_epi8(':')),
+                                                        _mm_cmpeq_epi8(Chars,  _mm_set1_epi8(','))))) << Shift;
+      Masks->Ctrl |= (uint64)_mm_movemask_epi8(
+                        _mm_cmpeq_epi8(_mm_max_epu8(Chars, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F))) << Shift;
+      Masks->Ws   |= (uint64)_mm_movemask_epi8(
+                        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Chars, _mm_set1_epi8('\t')),
+                                                  _mm_cmpeq_epi8(Chars, _mm_set1_epi8('\n'))),
+                                     _mm_or_si128(_mm_cmpeq_epi8(Chars, _mm_set1_epi8('\r')),
+                                                  _mm_cmpeq_epi8(Chars, _mm_set1_epi8(' '))))) << Shift;
+      Masks->HighBit |= (uint64)_mm_movemask_epi8(Chars) << Shift;
+   }
+
+} /* End ClassifyBlock() */
+
+#elif defined(JMSG_SCAN_NEON)
+
+static inline uint64 NeonMoveMask(uint8x16_t Cmp)
+{
+   static const uint8 BitWeight[16] = {1,2,4,8,16,32,64,128,1,2,4,8,16,32,64,128};
+   uint8x16_t Weighted = vandq_u8(Cmp, vld1q_u8(BitWeight));
+
+   return (uint64)vaddv_u8(vget_low_u8(Weighted)) | ((uint64)vaddv_u8(vget_high_u8(Weighted)) << 8);
+}
+
+static void ClassifyBlock(const uint8 *Block, BlockMasks_t *Masks)
+{
+
+   int i;
+   uint8x16_t Chars, Folded;
+   uint64  Shift;
+
+   memset(Masks, 0, sizeof(BlockMasks_t));
+
+   for (i=0; i < 4; i++)
+   {
+
+      Shift  = 16 * i;
+      Chars  = vld1q_u8(&Block[16*i]);
+      Folded = vorrq_u8(Chars, vdupq_n_u8(0x20));
+
+      Masks->Backslash  |= NeonMoveMask(vceqq_u8(Chars, vdupq_n_u8('\\'))) << Shift;
+      Masks->Quote      |= NeonMoveMask(vceqq_u8(Chars, vdupq_n_u8('"'))) << Shift;
+      Masks->Structural |= NeonMoveMask(vorrq_u8(vorrq_u8(vceqq_u8(Folded, vdupq_n_u8('{')),
+                                                          vceqq_u8(Folded, vdupq_n_u8('}'))),
+                                                 vorrq_u8(vceqq_u8(Chars,  vdupq_n_u8(':')),
+                                                          vceqq_u8(Chars,  vdupq_n_u8(','))))) << Shift;
+      Masks->Ctrl    |= NeonMoveMask(vcleq_u8(Chars, vdupq_n_u8(0x1F))) << Shift;
+      Masks->Ws      |= NeonMoveMask(vorrq_u8(vorrq_u8(vceqq_u8(Chars, vdupq_n_u8('\t')),
+                                                       vceqq_u8(Chars, vdupq_n_u8('\n'))),
+                                              vorrq_u8(vceqq_u8(Chars, vdupq_n_u8('\r')),
+                                                       vceqq_u8(Chars, vdupq_n_u8(' '))))) << Shift;
+      Masks->HighBit |= NeonMoveMask(vcgeq_u8(Chars, vdupq_n_u8(0x80))) << Shift;
+   }
+
+} /* End ClassifyBlock() */
+
+#else
+
+static void ClassifyBlock(const uint8 *Block, BlockMasks_t *Masks)
+{
+
+   int    i;
+   uint8  Char;
+   uint64 Bit;
+
+   memset(Masks, 0, sizeof(BlockMasks_t));
+
+   for (i=0; i < JMSG_SCAN_BLOCK_LEN; i++)
+   {
+
+      Char = Block[i];
+      Bit  = 1ULL << i;
+
+      if (Char == '\\')
+      {
+         Masks->Backslash |= Bit;
+      }
+      else if (Char == '"')
+      {
+         Masks->Quote |= Bit;
+      }
+      else if (Char == '{' || Char == '}' || Char == '[' || Char == ']' || Char == ':' || Char == ',')
+      {
+         Masks->Structural |= Bit;
+      }
+      else if (Char == ' ')
+      {
+         Masks->Ws |= Bit;
+      }
+      else if (Char < 0x20)
+      {
+         Masks->Ctrl |= Bit;
+         if (Char == '\t' || Char == '\n' || Char == '\r')
+         {
+            Masks->Ws |= Bit;
+         }
+      }
+      else if (Char >= 0x80)
+      {
+         Masks->HighBit |= Bit;
+      }
+   }
+
+} /* End ClassifyBlock() */
+
+#endif
+
+
+/******************************************************************************
+** Function: FindEscaped
+**
+** Return a mask of the characters escaped by an odd length run of
+** backslashes. PrevEndsOdd carries a run that crosses a block boundary.
+**
+*/
+static uint64 FindEscaped(uint64 Backslash, uint64 *PrevEndsOdd)
+{
+
+   uint64 StartEdges    = Backslash & ~(Backslash << 1);
+   uint64 EvenStartMask = EVEN_BITS ^ *PrevEndsOdd;
+   uint64 EvenStarts    = StartEdges & EvenStartMask;
+   uint64 OddStarts     = StartEdges & ~EvenStartMask;
+   uint64 EvenCarries   = Backslash + EvenStarts;
+   uint64 OddCarries    = Backslash + OddStarts;
+   bool   EndsOdd       = (OddCarries < Backslash);
+
+   OddCarries |= *PrevEndsOdd;
+   *PrevEndsOdd = EndsOdd ? 1 : 0;
+
+   return ((EvenCarries & ~Backslash) & ODD_BITS) | ((OddCarries & ~Backslash) & EVEN_BITS);
+
+} /* End FindEscaped() */
+
+
+/******************************************************************************
+** Function: PrefixXor
+**
+** Each output bit is the XOR of all input bits at or below its position,
+** which turns quote positions into an in-string mask.
+**
+*/
+static uint64 PrefixXor(uint64 Bits)
+{
+
+   Bits ^= Bits << 1;
+   Bits ^= Bits << 2;
+   Bits ^= Bits << 4;
+   Bits ^= Bits << 8;
+   Bits ^= Bits << 16;
+   Bits ^= Bits << 32;
+
+   return Bits;
+
+} /* End PrefixXor() */
+
+
+/******************************************************************************
+** Function: RangeMask
+**
+** Return a mask with bits Lo up to but not including Hi set.
+**
+*/
+static uint64 RangeMask(uint16 Lo, uint16 Hi)
+{
+
+   uint64 HiMask = (Hi >= JMSG_SCAN_BLOCK_LEN) ? ~0ULL : ((1ULL << Hi) - 1);
+   uint64 LoMask = (Lo >= JMSG_SCAN_BLOCK_LEN) ? ~0ULL : ((1ULL << Lo) - 1);
+
+   return HiMask & ~LoMask;
+
+} /* End RangeMask() */
+
+
+/******************************************************************************
+** Function: ValidUtf8
+**
+** Notes:
+**   1. Only called when a block contained a non-ASCII byte. Rejects overlong
+**      encodings, surrogates and code points above U+10FFFF.
+**
+*/
+static bool ValidUtf8(const uint8 *Buf, uint16 Len)
+{
+
+   uint16 i = 0;
+   uint16 SeqLen;
+   uint8  Char, Next;
+
+   while (i < Len)
+   {
+
+      Char = Buf[i];
+
+      if (Char < 0x80)
+      {
+         i++;
+         continue;
+      }
+
+      if (Char >= 0xC2 && Char <= 0xDF)
+      {
+         SeqLen = 2;
+      }
+      else if (Char >= 0xE0 && Char <= 0xEF)
+      {
+         SeqLen = 3;
+      }
+      else if (Char >= 0xF0 && Char <= 0xF4)
+      {
+         SeqLen = 4;
+      }
+      else
+      {
+         return false;
+      }
+
+      if ((uint32)i + SeqLen > Len)
+      {
+         return false;
+      }
+
+      /* Second byte range depends on the lead byte */
+      Next = Buf[i+1];
+      if ((Char == 0xE0 && Next < 0xA0) || (Char == 0xED && Next > 0x9F) ||
+          (Char == 0xF0 && Next < 0x90) || (Char == 0xF4 && Next > 0x8F) ||
+          (Next & 0xC0) != 0x80)
+      {
+         return false;
+      }
+      if (SeqLen > 2 && (Buf[i+2] & 0xC0) != 0x80)
+      {
+         return false;
+      }
+      if (SeqLen > 3 && (Buf[i+3] & 0xC0) != 0x80)
+      {
+         return false;
+      }
+
+      i += SeqLen;
+
+   } /* End while loop */
+
+   return true;
+
+} /* End ValidUtf8() */
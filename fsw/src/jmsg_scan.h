@@ -0,0 +1,111 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Structurally prevalidate JSON message payloads
+**
+** Notes:
+**   1. The scan classifies quotes, backslashes, structural characters and
+**      control characters 64 bytes at a time. AVX2, SSE2 and AArch64 NEON
+**      classifiers are selected at compile time from the target's predefined
+**      macros and a scalar classifier is used for all other targets.
+**   2. A payload passes the scan when it is a single balanced object or array
+**      with only whitespace around it, strings are terminated and contain no raw control characters, the text
+**      is valid UTF-8 and the nesting depth does not exceed the caller's limit.
+**      Number and literal syntax is left to the topic plugin's JSON parser.
+**   3. The structural index records the offset of every structural character
+**      and every opening string quote outside of strings so later stages can
+**      walk the payload without rescanning the bytes.
+**
+*/
+#ifndef _jmsg_scan_
+#define _jmsg_scan_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_SCAN_BLOCK_LEN  64
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef enum
+{
+
+   JMSG_SCAN_OK = 0,
+   JMSG_SCAN_ERR_EMPTY,
+   JMSG_SCAN_ERR_UTF8,
+   JMSG_SCAN_ERR_CTRL_CHAR,
+   JMSG_SCAN_ERR_STRING,
+   JMSG_SCAN_ERR_BALANCE,
+   JMSG_SCAN_ERR_DEPTH,
+   JMSG_SCAN_ERR_INDEX_FULL,
+   JMSG_SCAN_ERR_OUTSIDE
+
+} JMSG_SCAN_Status_t;
+
+
+/*
+** Structural index built by JMSG_SCAN_Payload()
+*/
+
+typedef struct
+{
+
+   uint16  Cnt;
+   uint16  Depth;     /* Maximum depth seen in the payload */
+   uint16  Pos[JMSG_UDP_PLATFORM_SCAN_INDEX_MAX];
+
+} JMSG_SCAN_Index_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_SCAN_Payload
+**
+** Validate a JSON payload's structure and build its structural index.
+**
+** Notes:
+**   1. Buf does not need to be null terminated, only Len bytes are read.
+**
+*/
+JMSG_SCAN_Status_t JMSG_SCAN_Payload(JMSG_SCAN_Index_t *Index, const char *Buf,
+                                     uint16 Len, uint16 MaxDepth);
+
+
+/******************************************************************************
+** Function: JMSG_SCAN_StatusStr
+**
+** Return a short text description of a scan status.
+**
+*/
+const char *JMSG_SCAN_StatusStr(JMSG_SCAN_Status_t Status);
+
+
+#endif /* _jmsg_scan_ */
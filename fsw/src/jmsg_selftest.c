@@ -0,0 +1,451 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Measure the gateway's loopback throughput and latency on the target
+**
+** Notes:
+**   1. See jmsg_selftest.h
+**   2. Times are microsecond offsets from the test start so they fit in
+**      a uint32 for a test of up to about 70 minutes.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jmsg_selftest.h"
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static int CompareUs(const void *A, const void *B);
+static int64 GetTimeUs(void);
+static void LoadResult(int64 NowUs);
+static uint32 Percentile(const uint32 *SortedUs, uint16 Cnt, uint16 Pct);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_SELFTEST_Class_t *SelfTest = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_Constructor
+**
+*/
+void JMSG_SELFTEST_Constructor(JMSG_SELFTEST_Class_t *SelfTestPtr, JMSG_SELFTEST_SendMsg_t SendMsg)
+{
+
+   SelfTest = SelfTestPtr;
+
+   CFE_PSP_MemSet((void*)SelfTest, 0, sizeof(JMSG_SELFTEST_Class_t));
+
+   SelfTest->SendMsg = SendMsg;
+   SelfTest->State   = JMSG_SELFTEST_IDLE;
+
+   OS_MutSemCreate(&SelfTest->Mutex, "JMSG_UDP_SELFTEST", 0);
+
+} /* End JMSG_SELFTEST_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_IsTestMsg
+**
+** Notes:
+**   1. The gateway sends test messages from an ephemeral port so only the
+**      peer's address is checked. Local transport peers have no address.
+**
+*/
+bool JMSG_SELFTEST_IsTestMsg(const JMSG_SOCK_RxInfo_t *RxInfo, uint32 Index)
+{
+
+   bool IsTestMsg;
+
+   if (RxInfo->PeerAddr != JMSG_SELFTEST_LOOPBACK || RxInfo->PeerPort == 0)
+   {
+      return false;
+   }
+
+   OS_MutSemTake(SelfTest->Mutex);
+
+   IsTestMsg = (SelfTest->State != JMSG_SELFTEST_IDLE && Index < SelfTest->NextIdx &&
+                SelfTest->SendUs[Index] != JMSG_SELFTEST_NO_TIME &&
+                SelfTest->LatencyUs[Index] == JMSG_SELFTEST_NO_TIME);
+
+   OS_MutSemGive(SelfTest->Mutex);
+
+   return IsTestMsg;
+
+} /* End JMSG_SELFTEST_IsTestMsg() */
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_NextTxMsg
+**
+*/
+const CFE_MSG_Message_t *JMSG_SELFTEST_NextTxMsg(uint16 *Index)
+{
+
+   const CFE_MSG_Message_t *Msg = NULL;
+
+   OS_MutSemTake(SelfTest->Mutex);
+
+   if (SelfTest->State == JMSG_SELFTEST_SENDING && SelfTest->NextIdx < SelfTest->Result.MsgCnt)
+   {
+      *Index = SelfTest->NextIdx++;
+      Msg    = (const CFE_MSG_Message_t *)SelfTest->Msg;
+   }
+
+   OS_MutSemGive(SelfTest->Mutex);
+
+   return Msg;
+
+} /* End JMSG_SELFTEST_NextTxMsg() */
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_Poll
+**
+** Notes:
+**   1. Messages still in flight when a test times out are counted as lost.
+**
+*/
+bool JMSG_SELFTEST_Poll(void)
+{
+
+   const JMSG_SELFTEST_Result_t *Result = &SelfTest->Result;
+   bool  Done = false;
+   int64 NowUs;
+
+   OS_MutSemTake(SelfTest->Mutex);
+
+   if (SelfTest->State == JMSG_SELFTEST_WAITING)
+   {
+      NowUs = GetTimeUs();
+      if ((Result->RecvCnt + Result->RxErrCnt) >= Result->SentCnt ||
+          (NowUs - SelfTest->LastSendUs) >= (JMSG_SELFTEST_TIMEOUT_MS * 1000))
+      {
+         LoadResult(NowUs);
+         SelfTest->State = JMSG_SELFTEST_IDLE;
+         Done = true;
+      }
+   }
+
+   OS_MutSemGive(SelfTest->Mutex);
+
+   if (Done)
+   {
+      CFE_EVS_SendEvent(JMSG_SELFTEST_RESULT_EID,
+                        (Result->RecvCnt == Result->MsgCnt) ? CFE_EVS_EventType_INFORMATION : CFE_EVS_EventType_ERROR,
+                        "Self-test received %u of %u messages, %u lost, %u Tx errors, %u Rx errors, "
+                        "%u msg/s, latency min %u p50 %u p99 %u max %u usec",
+                        Result->RecvCnt, Result->MsgCnt, Result->LostCnt, Result->TxErrCnt, Result->RxErrCnt,
+                        (unsigned int)Result->MsgPerSec, (unsigned int)Result->LatencyMinUs,
+                        (unsigned int)Result->LatencyP50Us, (unsigned int)Result->LatencyP99Us,
+                        (unsigned int)Result->LatencyMaxUs);
+   }
+
+   return Done;
+
+} /* End JMSG_SELFTEST_Poll() */
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_RecvRxMsg
+**
+*/
+void JMSG_SELFTEST_RecvRxMsg(uint32 Index, bool Valid)
+{
+
+   int64 NowUs = GetTimeUs();
+
+   OS_MutSemTake(SelfTest->Mutex);
+
+   if (SelfTest->State != JMSG_SELFTEST_IDLE && Index < SelfTest->NextIdx &&
+       SelfTest->SendUs[Index] != JMSG_SELFTEST_NO_TIME &&
+       SelfTest->LatencyUs[Index] == JMSG_SELFTEST_NO_TIME)
+   {
+      SelfTest->LastRecvUs = (uint32)(NowUs - SelfTest->StartUs);
+      if (Valid)
+      {
+         SelfTest->LatencyUs[Index] = SelfTest->LastRecvUs - SelfTest->SendUs[Index];
+         SelfTest->Result.RecvCnt++;
+      }
+      else
+      {
+         /* Ignore later copies of the message */
+         SelfTest->SendUs[Index] = JMSG_SELFTEST_NO_TIME;
+         SelfTest->Result.RxErrCnt++;
+      }
+   }
+
+   OS_MutSemGive(SelfTest->Mutex);
+
+} /* End JMSG_SELFTEST_RecvRxMsg() */
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_SendTxMsg
+**
+** Notes:
+**   1. The send time is stored before the send so the Rx task can't
+**      receive the message before its time is known.
+**
+*/
+void JMSG_SELFTEST_SendTxMsg(uint16 Index, const char *Msg, uint16 MsgLen)
+{
+
+   bool   Sent = false;
+   uint32 MsgId;
+
+   OS_MutSemTake(SelfTest->Mutex);
+
+   if (SelfTest->State != JMSG_SELFTEST_SENDING || Index >= SelfTest->Result.MsgCnt)
+   {
+      OS_MutSemGive(SelfTest->Mutex);
+      return;
+   }
+
+   if (Msg == NULL && Index == 0)
+   {
+      SelfTest->State = JMSG_SELFTEST_IDLE;
+      MsgId = SelfTest->Result.MsgId;
+      OS_MutSemGive(SelfTest->Mutex);
+
+      CFE_EVS_SendEvent(JMSG_SELFTEST_RESULT_EID, CFE_EVS_EventType_ERROR,
+                        "Self-test stopped, message ID 0x%04X couldn't be sent with its Tx route",
+                        (unsigned int)MsgId);
+      return;
+   }
+
+   if (Msg != NULL)
+   {
+      SelfTest->SendUs[Index] = (uint32)(GetTimeUs() - SelfTest->StartUs);
+      OS_MutSemGive(SelfTest->Mutex);
+
+      Sent = SelfTest->SendMsg(Msg, MsgLen, &SelfTest->Peer);
+
+      OS_MutSemTake(SelfTest->Mutex);
+   }
+
+   if (Sent)
+   {
+      SelfTest->Result.SentCnt++;
+   }
+   else
+   {
+      SelfTest->SendUs[Index] = JMSG_SELFTEST_NO_TIME;
+      SelfTest->Result.TxErrCnt++;
+   }
+
+   if (Index + 1 >= SelfTest->Result.MsgCnt)
+   {
+      SelfTest->LastSendUs = GetTimeUs();
+      SelfTest->State = JMSG_SELFTEST_WAITING;
+   }
+
+   OS_MutSemGive(SelfTest->Mutex);
+
+} /* End JMSG_SELFTEST_SendTxMsg() */
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_Start
+**
+** Notes:
+**   1. The synthetic SB message is built once and sent for every index.
+**      Its payload is zero filled and its header matches the message ID's
+**      type.
+**
+*/
+bool JMSG_SELFTEST_Start(uint32 MsgId, uint16 MsgCnt, uint16 PayloadLen, uint16 RxPort)
+{
+
+   CFE_MSG_Message_t *Msg = (CFE_MSG_Message_t *)SelfTest->Msg;
+   CFE_MSG_Type_t MsgType = CFE_MSG_Type_Tlm;
+   size_t HdrLen;
+   uint16 i;
+
+   if (MsgCnt == 0 || MsgCnt > JMSG_UDP_PLATFORM_SELFTEST_MSG_MAX ||
+       PayloadLen > JMSG_UDP_PLATFORM_SELFTEST_PAYLOAD_MAX)
+   {
+      CFE_EVS_SendEvent(JMSG_SELFTEST_START_EID, CFE_EVS_EventType_ERROR,
+                        "Self-test message count %u must be 1 to %u and payload length %u can't exceed %u",
+                        MsgCnt, JMSG_UDP_PLATFORM_SELFTEST_MSG_MAX,
+                        PayloadLen, JMSG_UDP_PLATFORM_SELFTEST_PAYLOAD_MAX);
+      return false;
+   }
+
+   OS_MutSemTake(SelfTest->Mutex);
+
+   if (SelfTest->State != JMSG_SELFTEST_IDLE)
+   {
+      OS_MutSemGive(SelfTest->Mutex);
+      CFE_EVS_SendEvent(JMSG_SELFTEST_START_EID, CFE_EVS_EventType_ERROR,
+                        "Self-test of message ID 0x%04X is already running",
+                        (unsigned int)SelfTest->Result.MsgId);
+      return false;
+   }
+
+   memset(SelfTest->Msg, 0, sizeof(SelfTest->Msg));
+   CFE_MSG_GetTypeFromMsgId(CFE_SB_ValueToMsgId(MsgId), &MsgType);
+   HdrLen = (MsgType == CFE_MSG_Type_Cmd) ? sizeof(CFE_MSG_CommandHeader_t) : sizeof(CFE_MSG_TelemetryHeader_t);
+   CFE_MSG_Init(Msg, CFE_SB_ValueToMsgId(MsgId), HdrLen + PayloadLen);
+
+   memset(&SelfTest->Result, 0, sizeof(JMSG_SELFTEST_Result_t));
+   SelfTest->Result.MsgId      = MsgId;
+   SelfTest->Result.MsgCnt     = MsgCnt;
+   SelfTest->Result.PayloadLen = PayloadLen;
+
+   for (i=0; i < MsgCnt; i++)
+   {
+      SelfTest->SendUs[i]    = JMSG_SELFTEST_NO_TIME;
+      SelfTest->LatencyUs[i] = JMSG_SELFTEST_NO_TIME;
+   }
+
+   SelfTest->Peer.PeerAddr = JMSG_SELFTEST_LOOPBACK;
+   SelfTest->Peer.PeerPort = RxPort;
+   SelfTest->NextIdx       = 0;
+   SelfTest->LastRecvUs    = 0;
+   SelfTest->StartUs       = GetTimeUs();
+   SelfTest->LastSendUs    = SelfTest->StartUs;
+   SelfTest->State         = JMSG_SELFTEST_SENDING;
+
+   OS_MutSemGive(SelfTest->Mutex);
+
+   CFE_EVS_SendEvent(JMSG_SELFTEST_START_EID, CFE_EVS_EventType_INFORMATION,
+                     "Self-test started sending %u messages of message ID 0x%04X with %u byte payloads to port %u",
+                     MsgCnt, (unsigned int)MsgId, PayloadLen, RxPort);
+
+   return true;
+
+} /* End JMSG_SELFTEST_Start() */
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_TxPending
+**
+*/
+bool JMSG_SELFTEST_TxPending(void)
+{
+
+   bool Pending;
+
+   OS_MutSemTake(SelfTest->Mutex);
+   Pending = (SelfTest->State == JMSG_SELFTEST_SENDING);
+   OS_MutSemGive(SelfTest->Mutex);
+
+   return Pending;
+
+} /* End JMSG_SELFTEST_TxPending() */
+
+
+/******************************************************************************
+** Function: CompareUs
+**
+** qsort() comparison of uint32 times.
+*/
+static int CompareUs(const void *A, const void *B)
+{
+
+   uint32 TimeA = *(const uint32 *)A;
+   uint32 TimeB = *(const uint32 *)B;
+
+   return (TimeA > TimeB) - (TimeA < TimeB);
+
+} /* End CompareUs() */
+
+
+/******************************************************************************
+** Function: GetTimeUs
+**
+** Notes:
+**   1. Local time is used rather than cFE time so a cFE time correlation
+**      change doesn't disturb the measurement.
+**
+*/
+static int64 GetTimeUs(void)
+{
+
+   OS_time_t LocalTime;
+
+   OS_GetLocalTime(&LocalTime);
+
+   return OS_TimeGetTotalMicroseconds(LocalTime);
+
+} /* End GetTimeUs() */
+
+
+/******************************************************************************
+** Function: LoadResult
+**
+** Notes:
+**   1. The caller must hold the mutex.
+**   2. The latencies are sorted in place. Messages that weren't received
+**      have the largest value so the received latencies are sorted first.
+**   3. The elapsed time runs from the test start to the last message
+**      received.
+**
+*/
+static void LoadResult(int64 NowUs)
+{
+
+   JMSG_SELFTEST_Result_t *Result = &SelfTest->Result;
+   uint16 RecvCnt = Result->RecvCnt;
+
+   Result->LostCnt = Result->SentCnt - RecvCnt - Result->RxErrCnt;
+
+   qsort(SelfTest->LatencyUs, Result->MsgCnt, sizeof(uint32), CompareUs);
+
+   if (RecvCnt > 0)
+   {
+      Result->ElapsedUs    = SelfTest->LastRecvUs;
+      Result->MsgPerSec    = (Result->ElapsedUs > 0) ?
+                             (uint32)(((uint64)RecvCnt * 1000000) / Result->ElapsedUs) : 0;
+      Result->LatencyMinUs = SelfTest->LatencyUs[0];
+      Result->LatencyP50Us = Percentile(SelfTest->LatencyUs, RecvCnt, 50);
+      Result->LatencyP90Us = Percentile(SelfTest->LatencyUs, RecvCnt, 90);
+      Result->LatencyP99Us = Percentile(SelfTest->LatencyUs, RecvCnt, 99);
+      Result->LatencyMaxUs = SelfTest->LatencyUs[RecvCnt - 1];
+   }
+   else
+   {
+      Result->ElapsedUs = (uint32)(NowUs - SelfTest->StartUs);
+   }
+
+} /* End LoadResult() */
+
+
+/******************************************************************************
+** Function: Percentile
+**
+** Nearest rank percentile of Cnt sorted times.
+*/
+static uint32 Percentile(const uint32 *SortedUs, uint16 Cnt, uint16 Pct)
+{
+
+   uint32 Rank = ((uint32)Cnt * Pct + 99) / 100;
+
+   return SortedUs[(Rank > 0) ? (Rank - 1) : 0];
+
+} /* End Percentile() */
@@ -0,0 +1,250 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Measure the gateway's loopback throughput and latency on the target
+**
+** Notes:
+**   1. The self-test command names a SB message ID with a Tx route, a
+**      message count and a payload length. The Tx task builds that many
+**      zero filled SB messages, converts each with the route like a SB
+**      message from the JMSG pipe and sends it to the gateway's own Rx port
+**      on 127.0.0.1 with a "t" header attribute holding its index. Messages
+**      are sent in bursts of JMSG_SELFTEST_BURST per Tx service call.
+**   2. The Rx task, or the topic's decode worker, translates a test
+**      message through JMSG_TRANS_ProcessJMsg() like any other JMSG but
+**      doesn't send the SB message, so synthetic data never reaches
+**      subscribers or loops back to the Tx route. The latency of a message
+**      is the time from just before its send until its translation
+**      completes.
+**   3. A "t" attribute is only honored while a test is running, from a
+**      127.0.0.1 UDP peer and for a message index that was sent and not
+**      yet received. Otherwise the attribute is ignored and the message is
+**      sent on the SB like any other JMSG, so a remote peer can't suppress
+**      real traffic or disturb a running test's figures.
+**   4. The test ends when every sent message is received or
+**      JMSG_SELFTEST_TIMEOUT_MS after the last send. The main task checks
+**      for the end when it sends status telemetry and then sends the result
+**      packet with the throughput, latency percentiles and lost messages.
+**   5. Only the JMSG translation and the datagram send are exercised on
+**      Tx. Sequence, reliable, compression and fragmentation attributes
+**      aren't added and test messages aren't cached, captured or sent to
+**      local transports. A message longer than a datagram or rejected by
+**      the route's filter is counted as a Tx error. Filter "prev" values
+**      are updated by the zero filled payloads.
+**   6. The mutex protects the state shared by the main, Tx, Rx and decode
+**      worker tasks.
+**
+*/
+#ifndef _jmsg_selftest_
+#define _jmsg_selftest_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_sock.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_SELFTEST_BURST       16      /* Messages sent per Tx service call */
+#define JMSG_SELFTEST_TIMEOUT_MS  2000    /* Wait for messages after the last send */
+#define JMSG_SELFTEST_LOOPBACK    0x7F000001
+
+#define JMSG_SELFTEST_NO_TIME  0xFFFFFFFF   /* Message not sent or received */
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_SELFTEST_START_EID   (JMSG_SELFTEST_BASE_EID + 0)
+#define JMSG_SELFTEST_RESULT_EID  (JMSG_SELFTEST_BASE_EID + 1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Callback that sends a datagram to a peer
+*/
+typedef bool (*JMSG_SELFTEST_SendMsg_t)(const char *Msg, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *Peer);
+
+
+typedef enum
+{
+
+   JMSG_SELFTEST_IDLE = 0,
+   JMSG_SELFTEST_SENDING,
+   JMSG_SELFTEST_WAITING    /* Every message was sent */
+
+} JMSG_SELFTEST_State_t;
+
+
+typedef struct
+{
+
+   uint32  MsgId;
+   uint16  MsgCnt;
+   uint16  PayloadLen;
+   uint16  SentCnt;
+   uint16  RecvCnt;
+   uint16  LostCnt;
+   uint16  TxErrCnt;       /* Messages that couldn't be converted or sent */
+   uint16  RxErrCnt;       /* Messages received but not translated */
+   uint32  ElapsedUs;      /* Test start to the last receive */
+   uint32  MsgPerSec;
+   uint32  LatencyMinUs;
+   uint32  LatencyP50Us;
+   uint32  LatencyP90Us;
+   uint32  LatencyP99Us;
+   uint32  LatencyMaxUs;
+
+} JMSG_SELFTEST_Result_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Framework References
+   */
+
+   JMSG_SELFTEST_SendMsg_t  SendMsg;
+
+   /*
+   ** State
+   */
+
+   osal_id_t  Mutex;
+
+   uint8   State;           /* JMSG_SELFTEST_State_t */
+   JMSG_SOCK_RxInfo_t  Peer;
+   uint16  NextIdx;
+   int64   StartUs;
+   int64   LastSendUs;
+   uint32  LastRecvUs;      /* Offset from StartUs */
+
+   JMSG_SELFTEST_Result_t  Result;
+
+   uint32  SendUs[JMSG_UDP_PLATFORM_SELFTEST_MSG_MAX];     /* Offsets from StartUs, NO_TIME until sent */
+   uint32  LatencyUs[JMSG_UDP_PLATFORM_SELFTEST_MSG_MAX];  /* NO_TIME until received */
+
+   uint64  Msg[(sizeof(CFE_MSG_CommandHeader_t) + sizeof(CFE_MSG_TelemetryHeader_t) +
+                JMSG_UDP_PLATFORM_SELFTEST_PAYLOAD_MAX + sizeof(uint64) - 1) / sizeof(uint64)];
+
+} JMSG_SELFTEST_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**
+*/
+void JMSG_SELFTEST_Constructor(JMSG_SELFTEST_Class_t *SelfTestPtr, JMSG_SELFTEST_SendMsg_t SendMsg);
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_IsTestMsg
+**
+** Return true if a message with a "t" attribute of Index received from
+** RxInfo's peer belongs to the running test.
+**
+*/
+bool JMSG_SELFTEST_IsTestMsg(const JMSG_SOCK_RxInfo_t *RxInfo, uint32 Index);
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_NextTxMsg
+**
+** Return the next synthetic SB message to convert and send, or NULL if
+** none is due.
+**
+** Notes:
+**   1. Only called by the task servicing Tx messages.
+**
+*/
+const CFE_MSG_Message_t *JMSG_SELFTEST_NextTxMsg(uint16 *Index);
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_Poll
+**
+** Return true, once, when a test has ended and its result is loaded.
+**
+*/
+bool JMSG_SELFTEST_Poll(void);
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_RecvRxMsg
+**
+** Record the arrival of a test message.
+**
+** Notes:
+**   1. Valid is false if the message wasn't translated.
+**   2. Messages that aren't part of the running test are ignored.
+**
+*/
+void JMSG_SELFTEST_RecvRxMsg(uint32 Index, bool Valid);
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_SendTxMsg
+**
+** Send a converted test message to the Rx port.
+**
+** Notes:
+**   1. Msg is NULL if the SB message couldn't be converted. The test is
+**      stopped if its first message can't be converted because the
+**      message ID's route is missing or can't convert it.
+**
+*/
+void JMSG_SELFTEST_SendTxMsg(uint16 Index, const char *Msg, uint16 MsgLen);
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_Start
+**
+** Start a test that sends MsgCnt messages to RxPort.
+**
+** Notes:
+**   1. Returns false if a test is running or a parameter is invalid.
+**
+*/
+bool JMSG_SELFTEST_Start(uint32 MsgId, uint16 MsgCnt, uint16 PayloadLen, uint16 RxPort);
+
+
+/******************************************************************************
+** Function: JMSG_SELFTEST_TxPending
+**
+** Return true if test messages are waiting to be sent.
+**
+*/
+bool JMSG_SELFTEST_TxPending(void);
+
+
+#endif /* _jmsg_selftest_ */
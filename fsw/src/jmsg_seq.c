@@ -0,0 +1,418 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Number Tx JMSGs and track Rx JMSG sequence numbers
+**
+** Notes:
+**   1. See jmsg_seq.h
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_seq.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define STREAM_MASK  (JMSG_UDP_PLATFORM_SEQ_STREAM_MAX - 1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+/*
+** Counter changes from one Rx message. Lost can decrease when a late
+** message fills a gap.
+*/
+
+typedef struct
+{
+
+   int32  Lost;
+   uint32 Reorder;
+   uint32 Dup;
+   uint32 Restart;
+
+} SeqDelta_t;
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static void ApplyDelta(JMSG_SEQ_Stats_t *Stats, const SeqDelta_t *Delta);
+static JMSG_SEQ_Peer_t *FindPeer(uint32 PeerAddr, uint16 PeerPort);
+static JMSG_SEQ_RxStream_t *FindRxStream(uint32 PeerAddr, uint16 PeerPort, const char *Topic,
+                                         uint16 TopicLen);
+static JMSG_SEQ_TxStream_t *FindTxStream(const char *Topic, uint16 TopicLen);
+static uint32 HashTopic(const char *Topic, uint16 TopicLen);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_SEQ_Class_t *Seq = NULL;
+
+
+/******************************************************************************
+** Function: JMSG_SEQ_Constructor
+**
+*/
+void JMSG_SEQ_Constructor(JMSG_SEQ_Class_t *SeqPtr, bool TxEnabled)
+{
+
+   Seq = SeqPtr;
+
+   CFE_PSP_MemSet((void*)Seq, 0, sizeof(JMSG_SEQ_Class_t));
+
+   Seq->TxEnabled = TxEnabled;
+
+} /* End JMSG_SEQ_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_SEQ_CheckRx
+**
+** Notes:
+**   1. The signed difference from the last sequence number makes the
+**      comparisons safe across uint32 wrap.
+**
+*/
+JMSG_SEQ_Result_t JMSG_SEQ_CheckRx(const JMSG_SOCK_RxInfo_t *RxInfo, const char *Topic,
+                                   uint16 TopicLen, uint32 SeqNum)
+{
+
+   JMSG_SEQ_Result_t Result = JMSG_SEQ_IN_ORDER;
+   JMSG_SEQ_RxStream_t *Stream;
+   JMSG_SEQ_Peer_t     *Peer;
+   SeqDelta_t Delta;
+   int32  Diff;
+   uint64 Bit;
+
+   Stream = FindRxStream(RxInfo->PeerAddr, RxInfo->PeerPort, Topic, TopicLen);
+   if (Stream == NULL)
+   {
+      if (Seq->UntrackedCnt++ == 0)
+      {
+         CFE_EVS_SendEvent(JMSG_SEQ_FULL_EID, CFE_EVS_EventType_ERROR,
+                           "Sequence stream table full, topic %.*s from 0x%08X:%d is not tracked",
+                           TopicLen, Topic, RxInfo->PeerAddr, RxInfo->PeerPort);
+      }
+      return JMSG_SEQ_UNTRACKED;
+   }
+
+   memset(&Delta, 0, sizeof(SeqDelta_t));
+
+   if (Stream->InUse)
+   {
+      Diff = (int32)(SeqNum - Stream->LastSeq);
+      if (Diff > 0 && Diff <= JMSG_SEQ_RESTART_GAP)
+      {
+         Stream->Window  = (Diff >= JMSG_SEQ_WINDOW_LEN) ? 1 : ((Stream->Window << Diff) | 1);
+         Stream->LastSeq = SeqNum;
+         Delta.Lost = Diff - 1;
+         Result = (Diff == 1) ? JMSG_SEQ_IN_ORDER : JMSG_SEQ_GAP;
+      }
+      else if (Diff <= 0 && -Diff < JMSG_SEQ_WINDOW_LEN)
+      {
+         Bit = 1ULL << (-Diff);
+         if (Stream->Window & Bit)
+         {
+            Delta.Dup = 1;
+            Result = JMSG_SEQ_DUPLICATE;
+         }
+         else
+         {
+            Stream->Window |= Bit;
+            Delta.Reorder = 1;
+            Delta.Lost    = -1;
+            Result = JMSG_SEQ_REORDERED;
+         }
+      }
+      else
+      {
+         Stream->LastSeq = SeqNum;
+         Stream->Window  = 1;
+         Delta.Restart = 1;
+         Result = JMSG_SEQ_RESTART;
+      }
+   }
+   else
+   {
+      Stream->InUse     = true;
+      Stream->PeerAddr  = RxInfo->PeerAddr;
+      Stream->PeerPort  = RxInfo->PeerPort;
+      Stream->TopicLen  = TopicLen;
+      Stream->TopicHash = HashTopic(Topic, TopicLen);
+      memcpy(Stream->Topic, Topic, TopicLen);
+      Stream->Topic[TopicLen] = '\0';
+      Stream->LastSeq = SeqNum;
+      Stream->Window  = 1;
+      Seq->RxStreamCnt++;
+   }
+
+   ApplyDelta(&Stream->Stats, &Delta);
+   ApplyDelta(&Seq->Total, &Delta);
+   Peer = FindPeer(RxInfo->PeerAddr, RxInfo->PeerPort);
+   if (Peer != NULL)
+   {
+      ApplyDelta(&Peer->Stats, &Delta);
+   }
+
+   return Result;
+
+} /* End JMSG_SEQ_CheckRx() */
+
+
+/******************************************************************************
+** Function: JMSG_SEQ_LossPerMille
+**
+*/
+uint16 JMSG_SEQ_LossPerMille(const JMSG_SEQ_Stats_t *Stats)
+{
+
+   uint64 Expected = (uint64)Stats->RxCnt + Stats->LostCnt;
+
+   return (Expected == 0) ? 0 : (uint16)(((uint64)Stats->LostCnt * 1000) / Expected);
+
+} /* End JMSG_SEQ_LossPerMille() */
+
+
+/******************************************************************************
+** Function: JMSG_SEQ_NextTx
+**
+*/
+bool JMSG_SEQ_NextTx(const char *Topic, uint32 *SeqNum)
+{
+
+   JMSG_SEQ_TxStream_t *Stream;
+
+   if (!Seq->TxEnabled)
+   {
+      return false;
+   }
+
+   Stream = FindTxStream(Topic, strlen(Topic));
+   if (Stream == NULL)
+   {
+      return false;
+   }
+
+   *SeqNum = Stream->NextSeq++;
+
+   return true;
+
+} /* End JMSG_SEQ_NextTx() */
+
+
+/******************************************************************************
+** Function: JMSG_SEQ_ResetStatus
+**
+*/
+void JMSG_SEQ_ResetStatus(void)
+{
+
+   uint16 i;
+
+   memset(&Seq->Total, 0, sizeof(JMSG_SEQ_Stats_t));
+   Seq->UntrackedCnt = 0;
+
+   for (i=0; i < JMSG_UDP_PLATFORM_SEQ_STREAM_MAX; i++)
+   {
+      memset(&Seq->RxStream[i].Stats, 0, sizeof(JMSG_SEQ_Stats_t));
+   }
+   for (i=0; i < JMSG_UDP_PLATFORM_SEQ_PEER_MAX; i++)
+   {
+      memset(&Seq->Peer[i].Stats, 0, sizeof(JMSG_SEQ_Stats_t));
+   }
+
+} /* End JMSG_SEQ_ResetStatus() */
+
+
+/******************************************************************************
+** Function: ApplyDelta
+**
+** Notes:
+**   1. A reset between a gap and its late message can leave nothing to
+**      recover so the lost count saturates at zero.
+**
+*/
+static void ApplyDelta(JMSG_SEQ_Stats_t *Stats, const SeqDelta_t *Delta)
+{
+
+   if (Delta->Dup == 0)
+   {
+      Stats->RxCnt++;
+   }
+
+   if (Delta->Lost >= 0)
+   {
+      Stats->LostCnt += Delta->Lost;
+   }
+   else if (Stats->LostCnt > 0)
+   {
+      Stats->LostCnt--;
+   }
+
+   Stats->ReorderCnt += Delta->Reorder;
+   Stats->DupCnt     += Delta->Dup;
+   Stats->RestartCnt += Delta->Restart;
+
+} /* End ApplyDelta() */
+
+
+/******************************************************************************
+** Function: FindPeer
+**
+** Return a peer's entry, adding it if needed. Returns NULL if the peer table
+** is full.
+*/
+static JMSG_SEQ_Peer_t *FindPeer(uint32 PeerAddr, uint16 PeerPort)
+{
+
+   uint16 i;
+   JMSG_SEQ_Peer_t *Peer;
+
+   for (i=0; i < JMSG_UDP_PLATFORM_SEQ_PEER_MAX; i++)
+   {
+      Peer = &Seq->Peer[i];
+      if (!Peer->InUse)
+      {
+         Peer->InUse    = true;
+         Peer->PeerAddr = PeerAddr;
+         Peer->PeerPort = PeerPort;
+         return Peer;
+      }
+      if (Peer->PeerAddr == PeerAddr && Peer->PeerPort == PeerPort)
+      {
+         return Peer;
+      }
+   }
+
+   return NULL;
+
+} /* End FindPeer() */
+
+
+/******************************************************************************
+** Function: FindRxStream
+**
+** Return a stream's slot using linear probing. The slot is unused if this is
+** the stream's first message. Returns NULL if the table is full.
+*/
+static JMSG_SEQ_RxStream_t *FindRxStream(uint32 PeerAddr, uint16 PeerPort, const char *Topic,
+                                         uint16 TopicLen)
+{
+
+   JMSG_SEQ_RxStream_t *Stream;
+   uint32 TopicHash = HashTopic(Topic, TopicLen);
+   uint32 Slot = (TopicHash ^ (PeerAddr * 2654435761u) ^ PeerPort) & STREAM_MASK;
+   uint16 Probe;
+
+   for (Probe=0; Probe < JMSG_UDP_PLATFORM_SEQ_STREAM_MAX; Probe++)
+   {
+      Stream = &Seq->RxStream[Slot];
+      if (!Stream->InUse)
+      {
+         return Stream;
+      }
+      if (Stream->TopicHash == TopicHash && Stream->PeerAddr == PeerAddr &&
+          Stream->PeerPort == PeerPort && Stream->TopicLen == TopicLen &&
+          memcmp(Stream->Topic, Topic, TopicLen) == 0)
+      {
+         return Stream;
+      }
+      Slot = (Slot + 1) & STREAM_MASK;
+   }
+
+   return NULL;
+
+} /* End FindRxStream() */
+
+
+/******************************************************************************
+** Function: FindTxStream
+**
+** Return a Tx topic's stream, adding it if needed. Returns NULL if the table
+** is full or the topic name is too long.
+*/
+static JMSG_SEQ_TxStream_t *FindTxStream(const char *Topic, uint16 TopicLen)
+{
+
+   JMSG_SEQ_TxStream_t *Stream;
+   uint32 TopicHash = HashTopic(Topic, TopicLen);
+   uint32 Slot = TopicHash & STREAM_MASK;
+   uint16 Probe;
+
+   if (TopicLen >= JMSG_PLATFORM_TOPIC_NAME_MAX_LEN)
+   {
+      return NULL;
+   }
+
+   for (Probe=0; Probe < JMSG_UDP_PLATFORM_SEQ_STREAM_MAX; Probe++)
+   {
+      Stream = &Seq->TxStream[Slot];
+      if (!Stream->InUse)
+      {
+         Stream->InUse     = true;
+         Stream->TopicLen  = TopicLen;
+         Stream->TopicHash = TopicHash;
+         memcpy(Stream->Topic, Topic, TopicLen);
+         Stream->Topic[TopicLen] = '\0';
+         Stream->NextSeq = 1;
+         Seq->TxStreamCnt++;
+         return Stream;
+      }
+      if (Stream->TopicHash == TopicHash && Stream->TopicLen == TopicLen &&
+          memcmp(Stream->Topic, Topic, TopicLen) == 0)
+      {
+         return Stream;
+      }
+      Slot = (Slot + 1) & STREAM_MASK;
+   }
+
+   return NULL;
+
+} /* End FindTxStream() */
+
+
+/******************************************************************************
+** Function: HashTopic
+**
+** FNV-1a hash of a topic name.
+*/
+static uint32 HashTopic(const char *Topic, uint16 TopicLen)
+{
+
+   uint32 Hash = 2166136261u;
+   uint16 i;
+
+   for (i=0; i < TopicLen; i++)
+   {
+      Hash = (Hash ^ (uint8)Topic[i]) * 16777619u;
+   }
+
+   return Hash;
+
+} /* End HashTopic() */
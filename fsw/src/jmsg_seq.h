@@ -0,0 +1,208 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Number Tx JMSGs and track Rx JMSG sequence numbers
+**
+** Notes:
+**   1. Sequence numbers are carried in the "s" header attribute and are
+**      counted per topic. Rx sequences are tracked per peer and topic so
+**      redundant senders and multiple ground stations don't interfere.
+**   2. Each Rx stream remembers the highest sequence number and a bit
+**      window of the JMSG_SEQ_WINDOW_LEN numbers below it. A gap is counted
+**      as lost until a late message fills it, which is then counted as
+**      reordered. A number already in the window is a duplicate.
+**   3. A number that falls behind the window, or jumps ahead by more than
+**      JMSG_SEQ_RESTART_GAP, is treated as a sender restart and resets the
+**      stream without counting loss.
+**   4. The Rx tables are only updated by the Rx task and the Tx table by
+**      the Tx task. Telemetry reads the counters without locking so a
+**      report may be one message out of date.
+**
+*/
+#ifndef _jmsg_seq_
+#define _jmsg_seq_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_sock.h"
+#include "jmsg_topic_tbl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_SEQ_WINDOW_LEN   64
+#define JMSG_SEQ_RESTART_GAP  4096
+
+/*
+** Event Message IDs
+*/
+
+#define JMSG_SEQ_FULL_EID  (JMSG_SEQ_BASE_EID + 0)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef enum
+{
+
+   JMSG_SEQ_IN_ORDER = 0,
+   JMSG_SEQ_GAP,          /* Accepted after one or more missing numbers */
+   JMSG_SEQ_REORDERED,
+   JMSG_SEQ_DUPLICATE,
+   JMSG_SEQ_RESTART,
+   JMSG_SEQ_UNTRACKED     /* Stream table full */
+
+} JMSG_SEQ_Result_t;
+
+
+typedef struct
+{
+
+   uint32  RxCnt;
+   uint32  LostCnt;
+   uint32  ReorderCnt;
+   uint32  DupCnt;
+   uint32  RestartCnt;
+
+} JMSG_SEQ_Stats_t;
+
+
+typedef struct
+{
+
+   bool     InUse;
+   uint32   PeerAddr;
+   uint16   PeerPort;
+   uint16   TopicLen;
+   uint32   TopicHash;
+   char     Topic[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN];
+   uint32   LastSeq;
+   uint64   Window;       /* Bit n set if LastSeq-n was received */
+
+   JMSG_SEQ_Stats_t  Stats;
+
+} JMSG_SEQ_RxStream_t;
+
+
+typedef struct
+{
+
+   bool     InUse;
+   uint32   PeerAddr;
+   uint16   PeerPort;
+
+   JMSG_SEQ_Stats_t  Stats;
+
+} JMSG_SEQ_Peer_t;
+
+
+typedef struct
+{
+
+   bool     InUse;
+   uint16   TopicLen;
+   uint32   TopicHash;
+   char     Topic[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN];
+   uint32   NextSeq;
+
+} JMSG_SEQ_TxStream_t;
+
+
+typedef struct
+{
+
+   bool    TxEnabled;
+
+   JMSG_SEQ_Stats_t  Total;
+   uint32            UntrackedCnt;
+
+   uint16  RxStreamCnt;
+   uint16  TxStreamCnt;
+
+   JMSG_SEQ_RxStream_t  RxStream[JMSG_UDP_PLATFORM_SEQ_STREAM_MAX];
+   JMSG_SEQ_Peer_t      Peer[JMSG_UDP_PLATFORM_SEQ_PEER_MAX];
+   JMSG_SEQ_TxStream_t  TxStream[JMSG_UDP_PLATFORM_SEQ_STREAM_MAX];
+
+} JMSG_SEQ_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_SEQ_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**
+*/
+void JMSG_SEQ_Constructor(JMSG_SEQ_Class_t *SeqPtr, bool TxEnabled);
+
+
+/******************************************************************************
+** Function: JMSG_SEQ_CheckRx
+**
+** Record a received sequence number and classify it.
+**
+** Notes:
+**   1. Topic does not need to be null terminated.
+**   2. The caller should drop JMSG_SEQ_DUPLICATE messages.
+**
+*/
+JMSG_SEQ_Result_t JMSG_SEQ_CheckRx(const JMSG_SOCK_RxInfo_t *RxInfo, const char *Topic,
+                                   uint16 TopicLen, uint32 SeqNum);
+
+
+/******************************************************************************
+** Function: JMSG_SEQ_LossPerMille
+**
+** Return the fraction of expected messages that were lost in units of 0.1%.
+**
+*/
+uint16 JMSG_SEQ_LossPerMille(const JMSG_SEQ_Stats_t *Stats);
+
+
+/******************************************************************************
+** Function: JMSG_SEQ_NextTx
+**
+** Return the next Tx sequence number for a topic.
+**
+** Notes:
+**   1. Returns false if Tx numbering is disabled or the stream table is full.
+**
+*/
+bool JMSG_SEQ_NextTx(const char *Topic, uint32 *SeqNum);
+
+
+/******************************************************************************
+** Function: JMSG_SEQ_ResetStatus
+**
+** Reset counters without forgetting the stream sequence state.
+**
+*/
+void JMSG_SEQ_ResetStatus(void);
+
+
+#endif /* _jmsg_seq_ */
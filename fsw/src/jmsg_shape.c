@@ -0,0 +1,418 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Implement the Rx payload shape cache
+**
+** Notes:
+**   1. See jmsg_shape.h for the shape definition.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_shape.h"
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+/*
+** Numeric member value found while learning a shape
+*/
+
+typedef struct
+{
+
+   uint16  Start;
+   uint16  Len;
+   uint8   Field;
+
+} ShapeValue_t;
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static JMSG_SHAPE_Entry_t *FindEntry(JMSG_SHAPE_Class_t *Shape, const char *Topic, uint16 TopicLen, bool Replace);
+static uint8 FindField(const JMSG_TMPL_Tmpl_t *Tmpl, const char *Key, uint16 KeyLen);
+static bool IsValueEnd(char Ch);
+
+
+/******************************************************************************
+** Function: JMSG_SHAPE_Constructor
+**
+*/
+void JMSG_SHAPE_Constructor(JMSG_SHAPE_Class_t *Shape)
+{
+
+   CFE_PSP_MemSet((void*)Shape, 0, sizeof(JMSG_SHAPE_Class_t));
+
+} /* End JMSG_SHAPE_Constructor() */
+
+
+/******************************************************************************
+** Function: JMSG_SHAPE_Learn
+**
+** Notes:
+**   1. The structural index is walked once. The target object is the root
+**      object, or the root's member named by the template object. A colon
+**      in the target object is preceded by its key's opening quote and a
+**      numeric value follows it.
+**   2. A number must be followed by whitespace or punctuation so text the
+**      scan doesn't check, e.g. 1.5x, is never cut into a slot.
+**
+*/
+JMSG_SHAPE_Status_t JMSG_SHAPE_Learn(JMSG_SHAPE_Class_t *Shape, const char *Topic, uint16 TopicLen,
+                                     const JMSG_TMPL_Tmpl_t *Tmpl, const char *Json,
+                                     uint16 JsonLen, const JMSG_SCAN_Index_t *Index,
+                                     uint8 *Payload)
+{
+
+   ShapeValue_t Value[JMSG_UDP_PLATFORM_SHAPE_SLOT_MAX];
+   bool   Found[JMSG_UDP_PLATFORM_TMPL_FIELD_MAX];
+   JMSG_TMPL_Number_t Number;
+   JMSG_SHAPE_Entry_t *Entry;
+   const char *Key;
+   const char *KeyEnd;
+   uint16 ValueCnt = 0;
+   uint16 ValueLen = 0;
+   bool   Cacheable = true;
+   uint16 Depth = 0;
+   uint16 TargetDepth = 0;
+   bool   TargetSeen = false;
+   bool   ObjMember = false;
+   bool   ObjValue;
+   uint16 Pos;
+   uint16 Start;
+   uint16 Len;
+   uint8  Field;
+   uint16 JsonPos;
+   uint16 i;
+
+   memset(Found, 0, sizeof(Found));
+
+   for (i=0; i < Index->Cnt; i++)
+   {
+
+      Pos = Index->Pos[i];
+      ObjValue  = ObjMember;
+      ObjMember = false;
+
+      switch (Json[Pos])
+      {
+         case '{':
+         case '[':
+            Depth++;
+            if (Json[Pos] == '{' && !TargetSeen &&
+                (Tmpl->ObjectLen == 0 ? (Depth == 1) : (Depth == 2 && ObjValue)))
+            {
+               TargetDepth = Depth;
+               TargetSeen  = true;
+            }
+            break;
+
+         case '}':
+         case ']':
+            if (Depth == TargetDepth)
+            {
+               TargetDepth = 0;
+            }
+            Depth--;
+            break;
+
+         case ':':
+            if (i == 0 || Json[Index->Pos[i-1]] != '"')
+            {
+               break;
+            }
+            Key    = &Json[Index->Pos[i-1] + 1];
+            KeyEnd = memchr(Key, '"', Pos - Index->Pos[i-1] - 1);
+            if (KeyEnd == NULL)
+            {
+               break;
+            }
+
+            if (Depth == 1 && Tmpl->ObjectLen > 0)
+            {
+               ObjMember = ((KeyEnd - Key) == Tmpl->ObjectLen &&
+                            memcmp(Key, &Tmpl->Text[2], Tmpl->ObjectLen) == 0);
+            }
+            else if (Depth == TargetDepth)
+            {
+               Start = Pos + 1;
+               while (Start < JsonLen && (Json[Start] == ' ' || Json[Start] == '\t' ||
+                                          Json[Start] == '\n' || Json[Start] == '\r'))
+               {
+                  Start++;
+               }
+               Len = JMSG_TMPL_ParseNumber(&Json[Start], JsonLen - Start, &Number);
+               if (Len == 0 || Start + Len >= JsonLen || !IsValueEnd(Json[Start + Len]))
+               {
+                  break;
+               }
+
+               Field = FindField(Tmpl, Key, KeyEnd - Key);
+               if (Field != JMSG_SHAPE_NO_FIELD)
+               {
+                  if (!JMSG_TMPL_StoreNumber(&Tmpl->Field[Field], &Number, Payload))
+                  {
+                     return JMSG_SHAPE_ERR_RANGE;
+                  }
+                  Found[Field] = true;
+               }
+
+               if (ValueCnt < JMSG_UDP_PLATFORM_SHAPE_SLOT_MAX)
+               {
+                  Value[ValueCnt].Start = Start;
+                  Value[ValueCnt].Len   = Len;
+                  Value[ValueCnt].Field = Field;
+                  ValueCnt++;
+                  ValueLen += Len;
+               }
+               else
+               {
+                  Cacheable = false;
+               }
+            }
+            break;
+
+         default:
+            break;
+
+      } /* End structural char switch */
+   } /* End index loop */
+
+   for (i=0; i < Tmpl->FieldCnt; i++)
+   {
+      if (!Found[i])
+      {
+         return JMSG_SHAPE_ERR_MISSING;
+      }
+   }
+
+   if (Cacheable && (JsonLen - ValueLen) <= JMSG_UDP_PLATFORM_SHAPE_TEXT_MAX &&
+       TopicLen < JMSG_PLATFORM_TOPIC_NAME_MAX_LEN)
+   {
+      Entry = FindEntry(Shape, Topic, TopicLen, true);
+
+      memcpy(Entry->Topic, Topic, TopicLen);
+      Entry->TopicLen = TopicLen;
+      Entry->TmplId   = Tmpl->Id;
+      Entry->SlotCnt  = ValueCnt;
+      Entry->SkelLen  = 0;
+      Entry->LastUse  = ++Shape->UseCnt;
+
+      JsonPos = 0;
+      for (i=0; i < ValueCnt; i++)
+      {
+         memcpy(&Entry->Skel[Entry->SkelLen], &Json[JsonPos], Value[i].Start - JsonPos);
+         Entry->SkelLen += Value[i].Start - JsonPos;
+         Entry->Slot[i].SkelEnd = Entry->SkelLen;
+         Entry->Slot[i].Field   = Value[i].Field;
+         JsonPos = Value[i].Start + Value[i].Len;
+      }
+      memcpy(&Entry->Skel[Entry->SkelLen], &Json[JsonPos], JsonLen - JsonPos);
+      Entry->SkelLen += JsonLen - JsonPos;
+   }
+
+   return JMSG_SHAPE_OK;
+
+} /* End JMSG_SHAPE_Learn() */
+
+
+/******************************************************************************
+** Function: JMSG_SHAPE_Match
+**
+*/
+JMSG_SHAPE_Status_t JMSG_SHAPE_Match(JMSG_SHAPE_Class_t *Shape, const char *Topic, uint16 TopicLen,
+                                     const JMSG_TMPL_Tmpl_t *Tmpl, const char *Json,
+                                     uint16 JsonLen, uint8 *Payload)
+{
+
+   JMSG_SHAPE_Entry_t *Entry = FindEntry(Shape, Topic, TopicLen, false);
+   const JMSG_SHAPE_Slot_t *Slot;
+   JMSG_TMPL_Number_t Number;
+   uint16 JsonPos = 0;
+   uint16 SkelPos = 0;
+   uint16 SegLen;
+   uint16 Len;
+   uint16 i;
+
+   if (Entry == NULL || Entry->TmplId != Tmpl->Id)
+   {
+      Shape->MissCnt++;
+      return JMSG_SHAPE_MISS;
+   }
+
+   for (i=0; i < Entry->SlotCnt; i++)
+   {
+
+      Slot   = &Entry->Slot[i];
+      SegLen = Slot->SkelEnd - SkelPos;
+      if (SegLen > JsonLen - JsonPos || memcmp(&Json[JsonPos], &Entry->Skel[SkelPos], SegLen) != 0)
+      {
+         Shape->MissCnt++;
+         return JMSG_SHAPE_MISS;
+      }
+      JsonPos += SegLen;
+      SkelPos  = Slot->SkelEnd;
+
+      Len = JMSG_TMPL_ParseNumber(&Json[JsonPos], JsonLen - JsonPos, &Number);
+      if (Len == 0)
+      {
+         Shape->MissCnt++;
+         return JMSG_SHAPE_MISS;
+      }
+      if (Slot->Field != JMSG_SHAPE_NO_FIELD &&
+          !JMSG_TMPL_StoreNumber(&Tmpl->Field[Slot->Field], &Number, Payload))
+      {
+         return JMSG_SHAPE_ERR_RANGE;
+      }
+      JsonPos += Len;
+
+   }
+
+   SegLen = Entry->SkelLen - SkelPos;
+   if (SegLen != JsonLen - JsonPos || memcmp(&Json[JsonPos], &Entry->Skel[SkelPos], SegLen) != 0)
+   {
+      Shape->MissCnt++;
+      return JMSG_SHAPE_MISS;
+   }
+
+   Entry->LastUse = ++Shape->UseCnt;
+   Shape->HitCnt++;
+
+   return JMSG_SHAPE_OK;
+
+} /* End JMSG_SHAPE_Match() */
+
+
+/******************************************************************************
+** Function: JMSG_SHAPE_ResetStatus
+**
+*/
+void JMSG_SHAPE_ResetStatus(JMSG_SHAPE_Class_t *Shape)
+{
+
+   Shape->HitCnt  = 0;
+   Shape->MissCnt = 0;
+
+} /* End JMSG_SHAPE_ResetStatus() */
+
+
+/******************************************************************************
+** Function: JMSG_SHAPE_StatusStr
+**
+*/
+const char *JMSG_SHAPE_StatusStr(JMSG_SHAPE_Status_t Status)
+{
+
+   static const char *StatusStr[] =
+   {
+      "OK",
+      "shape not cached",
+      "template field missing or not a number",
+      "value out of the field type's range"
+   };
+
+   const char *RetStr = "unknown status";
+
+   if ((uint32)Status < (sizeof(StatusStr)/sizeof(StatusStr[0])))
+   {
+      RetStr = StatusStr[Status];
+   }
+
+   return RetStr;
+
+} /* End JMSG_SHAPE_StatusStr() */
+
+
+/******************************************************************************
+** Function: FindEntry
+**
+** Return a topic's entry or NULL. If Replace is true an unused or the least
+** recently used entry is returned when the topic isn't cached.
+**
+*/
+static JMSG_SHAPE_Entry_t *FindEntry(JMSG_SHAPE_Class_t *Shape, const char *Topic, uint16 TopicLen, bool Replace)
+{
+
+   JMSG_SHAPE_Entry_t *Entry;
+   JMSG_SHAPE_Entry_t *Oldest = &Shape->Entry[0];
+   uint16 i;
+
+   for (i=0; i < JMSG_UDP_PLATFORM_SHAPE_MAX; i++)
+   {
+      Entry = &Shape->Entry[i];
+      if (Entry->TopicLen == TopicLen && memcmp(Entry->Topic, Topic, TopicLen) == 0)
+      {
+         return Entry;
+      }
+      /* Ages are compared so the order survives UseCnt wrapping */
+      if (Entry->TopicLen == 0 || (Oldest->TopicLen != 0 &&
+          (Shape->UseCnt - Entry->LastUse) > (Shape->UseCnt - Oldest->LastUse)))
+      {
+         Oldest = Entry;
+      }
+   }
+
+   return Replace ? Oldest : NULL;
+
+} /* End FindEntry() */
+
+
+/******************************************************************************
+** Function: FindField
+**
+** Return the index of the template field with a key or JMSG_SHAPE_NO_FIELD.
+**
+*/
+static uint8 FindField(const JMSG_TMPL_Tmpl_t *Tmpl, const char *Key, uint16 KeyLen)
+{
+
+   const JMSG_TMPL_Field_t *Field;
+   uint16 i;
+
+   for (i=0; i < Tmpl->FieldCnt; i++)
+   {
+      Field = &Tmpl->Field[i];
+      if (Field->KeyLen == KeyLen && memcmp(&Tmpl->Text[Field->KeyPos], Key, KeyLen) == 0)
+      {
+         return (uint8)i;
+      }
+   }
+
+   return JMSG_SHAPE_NO_FIELD;
+
+} /* End FindField() */
+
+
+/******************************************************************************
+** Function: IsValueEnd
+**
+*/
+static bool IsValueEnd(char Ch)
+{
+
+   return (Ch == ',' || Ch == '}' || Ch == ']' ||
+           Ch == ' ' || Ch == '\t' || Ch == '\n' || Ch == '\r');
+
+} /* End IsValueEnd() */
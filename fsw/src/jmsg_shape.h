@@ -0,0 +1,179 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Cache the shape of Rx JSON payloads converted with a route template
+**
+** Notes:
+**   1. Ground tools usually send a topic with the same keys in the same
+**      order every time. A shape is a payload's text with the numeric
+**      member values cut out, a skeleton, plus the template field each
+**      value is stored in.
+**   2. A payload matches a topic's shape when the text between its numbers
+**      is byte for byte the skeleton. The numbers are parsed as they're
+**      reached so a hit converts the payload in one pass without the
+**      structural scan.
+**   3. A miss is converted from the payload's structural index, which
+**      also learns the new shape. Every template field must be a numeric
+**      member of the template's object.
+**   4. Shapes are keyed by topic name and template ID so a route table
+**      reload that changes a template invalidates its shapes. The least
+**      recently used shape is replaced when the cache is full.
+**   5. Each JSON decoder context owns a cache and only the task running the
+**      context uses it, so a topic's shape is learned once per context.
+**
+*/
+#ifndef _jmsg_shape_
+#define _jmsg_shape_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_scan.h"
+#include "jmsg_tmpl.h"
+#include "jmsg_topic_tbl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_SHAPE_NO_FIELD  0xFF   /* Numeric member that isn't a template field */
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef enum
+{
+
+   JMSG_SHAPE_OK = 0,
+   JMSG_SHAPE_MISS,
+   JMSG_SHAPE_ERR_MISSING,   /* A template field isn't a numeric member */
+   JMSG_SHAPE_ERR_RANGE      /* A value doesn't fit its field */
+
+} JMSG_SHAPE_Status_t;
+
+
+typedef struct
+{
+
+   uint16  SkelEnd;   /* Skeleton text preceding the value ends here */
+   uint8   Field;     /* Template field index or JMSG_SHAPE_NO_FIELD */
+
+} JMSG_SHAPE_Slot_t;
+
+
+typedef struct
+{
+
+   char    Topic[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN];
+   uint16  TopicLen;         /* Zero if the entry is unused */
+   uint32  TmplId;
+   uint16  SlotCnt;
+   uint16  SkelLen;
+   uint32  LastUse;
+
+   JMSG_SHAPE_Slot_t  Slot[JMSG_UDP_PLATFORM_SHAPE_SLOT_MAX];
+   char               Skel[JMSG_UDP_PLATFORM_SHAPE_TEXT_MAX];
+
+} JMSG_SHAPE_Entry_t;
+
+
+typedef struct
+{
+
+   uint32  HitCnt;
+   uint32  MissCnt;
+   uint32  UseCnt;
+
+   JMSG_SHAPE_Entry_t  Entry[JMSG_UDP_PLATFORM_SHAPE_MAX];
+
+} JMSG_SHAPE_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_SHAPE_Constructor
+**
+** Notes:
+**    1. This function must be called prior to any other functions
+**
+*/
+void JMSG_SHAPE_Constructor(JMSG_SHAPE_Class_t *Shape);
+
+
+/******************************************************************************
+** Function: JMSG_SHAPE_Learn
+**
+** Store a payload's values in the template's fields using the payload's
+** structural index and cache the payload's shape.
+**
+** Notes:
+**   1. Index must be the JMSG_SCAN_Payload() index of Json.
+**   2. Payload is the SB message payload the fields are stored in.
+**   3. A shape that exceeds the cache entry limits isn't cached but the
+**      payload is still converted.
+**
+*/
+JMSG_SHAPE_Status_t JMSG_SHAPE_Learn(JMSG_SHAPE_Class_t *Shape, const char *Topic, uint16 TopicLen,
+                                     const JMSG_TMPL_Tmpl_t *Tmpl, const char *Json,
+                                     uint16 JsonLen, const JMSG_SCAN_Index_t *Index,
+                                     uint8 *Payload);
+
+
+/******************************************************************************
+** Function: JMSG_SHAPE_Match
+**
+** Store a payload's values in the template's fields if the payload matches
+** the topic's cached shape.
+**
+** Notes:
+**   1. Returns JMSG_SHAPE_MISS if there's no shape or the payload doesn't
+**      match it. Fields may have been partially stored.
+**   2. Topic and Json do not need to be null terminated.
+**
+*/
+JMSG_SHAPE_Status_t JMSG_SHAPE_Match(JMSG_SHAPE_Class_t *Shape, const char *Topic, uint16 TopicLen,
+                                     const JMSG_TMPL_Tmpl_t *Tmpl, const char *Json,
+                                     uint16 JsonLen, uint8 *Payload);
+
+
+/******************************************************************************
+** Function: JMSG_SHAPE_ResetStatus
+**
+** Reset counters without forgetting the cached shapes.
+**
+*/
+void JMSG_SHAPE_ResetStatus(JMSG_SHAPE_Class_t *Shape);
+
+
+/******************************************************************************
+** Function: JMSG_SHAPE_StatusStr
+**
+** Return a short text description of a shape status.
+**
+*/
+const char *JMSG_SHAPE_StatusStr(JMSG_SHAPE_Status_t Status);
+
+
+#endif /* _jmsg_shape_ */
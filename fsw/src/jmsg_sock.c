@@ -0,0 +1,594 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Provide a UDP receive socket that reports each datagram's arrival time
+**
+** Notes:
+**   1. See jmsg_sock.h
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_sock.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef SO_TIMESTAMPNS
+#define JMSG_SOCK_NATIVE
+#endif
+#endif
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+#ifdef JMSG_SOCK_NATIVE
+static void CloseLocal(JMSG_SOCK_Class_t *Sock);
+static void GetTmpPath(const JMSG_SOCK_Class_t *Sock, char *TmpPath);
+static int32 OpenLocal(JMSG_SOCK_Class_t *Sock, const JMSG_SOCK_Class_t *Current);
+static int32 OpenNative(JMSG_SOCK_Class_t *Sock, uint16 Port, bool KernelTime);
+static int32 RecvLocal(JMSG_SOCK_Class_t *Sock, void *Buf, size_t BufLen, JMSG_SOCK_RxInfo_t *RxInfo);
+static int32 RecvNative(JMSG_SOCK_Class_t *Sock, void *Buf, size_t BufLen, int32 Timeout,
+                        JMSG_SOCK_RxInfo_t *RxInfo);
+static int32 RecvUring(JMSG_SOCK_Class_t *Sock, void *Buf, size_t BufLen, int32 Timeout,
+                       JMSG_SOCK_RxInfo_t *RxInfo);
+static void SetArrivalTime(JMSG_SOCK_RxInfo_t *RxInfo, int64 KernelTimeNs);
+#endif
+
+
+/******************************************************************************
+** Function: JMSG_SOCK_Close
+**
+*/
+void JMSG_SOCK_Close(JMSG_SOCK_Class_t *Sock)
+{
+
+   if (Sock->Open)
+   {
+#ifdef JMSG_SOCK_NATIVE
+      if (Sock->Uring != NULL)
+      {
+         JMSG_URING_CloseRx(Sock->Uring);
+         Sock->Uring = NULL;
+      }
+      CloseLocal(Sock);
+      if (Sock->Native)
+      {
+         close(Sock->Fd);
+      }
+      else
+#endif
+      {
+         OS_close(Sock->OsalId);
+      }
+      Sock->Open = false;
+   }
+
+} /* End JMSG_SOCK_Close() */
+
+
+/******************************************************************************
+** Function: JMSG_SOCK_CommitRx
+**
+*/
+int32 JMSG_SOCK_CommitRx(JMSG_SOCK_Class_t *Sock, JMSG_SOCK_Class_t *Current)
+{
+
+   int32 Status = OS_SUCCESS;
+#ifdef JMSG_SOCK_NATIVE
+   char  TmpPath[JMSG_SOCK_LOCAL_PATH_LEN];
+
+   if (Sock->LocalShared)
+   {
+      Current->LocalFd  = -1;
+      Sock->LocalShared = false;
+   }
+   if (Sock->LocalTmp)
+   {
+      GetTmpPath(Sock, TmpPath);
+      if (rename(TmpPath, Sock->LocalPath) == 0)
+      {
+         Sock->LocalTmp = false;
+      }
+      else
+      {
+         Status = OS_ERROR;
+      }
+   }
+#endif
+
+   return Status;
+
+} /* End JMSG_SOCK_CommitRx() */
+
+
+/******************************************************************************
+** Function: JMSG_SOCK_GetPeer
+**
+*/
+void JMSG_SOCK_GetPeer(const OS_SockAddr_t *SockAddr, JMSG_SOCK_RxInfo_t *RxInfo)
+{
+
+   char   AddrStr[48];
+   const char *Char;
+   uint32 Octet  = 0;
+   uint16 Octets = 1;
+   uint32 Hash   = 2166136261u;
+   bool   Ipv4   = true;
+
+   RxInfo->PeerAddr = 0;
+   RxInfo->PeerPort = 0;
+   OS_SocketAddrGetPort(&RxInfo->PeerPort, SockAddr);
+
+   if (OS_SocketAddrToString(AddrStr, sizeof(AddrStr), SockAddr) == OS_SUCCESS)
+   {
+      for (Char = AddrStr; *Char != '\0'; Char++)
+      {
+         Hash = (Hash ^ (uint8)*Char) * 16777619u;
+         if (*Char >= '0' && *Char <= '9')
+         {
+            Octet = Octet*10 + (*Char - '0');
+            Ipv4  = Ipv4 && (Octet <= 255);
+         }
+         else if (*Char == '.')
+         {
+            RxInfo->PeerAddr = (RxInfo->PeerAddr << 8) | Octet;
+            Octet = 0;
+            Octets++;
+         }
+         else
+         {
+            Ipv4 = false;
+         }
+      }
+      RxInfo->PeerAddr = (Ipv4 && Octets == 4) ? ((RxInfo->PeerAddr << 8) | Octet) : Hash;
+   }
+
+} /* End JMSG_SOCK_GetPeer() */
+
+
+/******************************************************************************
+** Function: JMSG_SOCK_OpenRx
+**
+*/
+int32 JMSG_SOCK_OpenRx(JMSG_SOCK_Class_t *Sock, const JMSG_SOCK_Class_t *Current, uint16 Port,
+                       bool KernelTime, const char *LocalPath, uint16 UringDepth, uint32 DatagramLen)
+{
+
+   int32 Status;
+   OS_SockAddr_t SocketAddr;
+
+   memset(Sock, 0, sizeof(JMSG_SOCK_Class_t));
+   Sock->Fd      = -1;
+   Sock->LocalFd = -1;
+   strncpy(Sock->LocalPath, LocalPath, JMSG_SOCK_LOCAL_PATH_LEN - 1);
+
+#ifdef JMSG_SOCK_NATIVE
+   if (LocalPath[0] != '\0' || KernelTime || UringDepth > 0)
+   {
+      Status = OS_SUCCESS;
+      if (LocalPath[0] != '\0')
+      {
+         Status = OpenLocal(Sock, Current);
+      }
+      if (Status == OS_SUCCESS)
+      {
+         Status = OpenNative(Sock, Port, KernelTime);
+         if (Status != OS_SUCCESS)
+         {
+            CloseLocal(Sock);
+         }
+      }
+      if (Status == OS_SUCCESS && UringDepth > 0)
+      {
+         /* The native sockets are polled if the kernel lacks support */
+         Sock->Uring = JMSG_URING_OpenRx(Sock->Fd, Sock->LocalFd, UringDepth, DatagramLen, KernelTime);
+      }
+      return Status;
+   }
+#else
+   if (LocalPath[0] != '\0')
+   {
+      return OS_ERR_NOT_IMPLEMENTED;
+   }
+#endif
+
+   Status = OS_SocketOpen(&Sock->OsalId, OS_SocketDomain_INET, OS_SocketType_DATAGRAM);
+   if (Status == OS_SUCCESS)
+   {
+      OS_SocketAddrInit(&SocketAddr, OS_SocketDomain_INET);
+      OS_SocketAddrSetPort(&SocketAddr, Port);
+      Status = OS_SocketBind(Sock->OsalId, &SocketAddr);
+      if (Status == OS_SUCCESS)
+      {
+         Sock->Open = true;
+      }
+      else
+      {
+         OS_close(Sock->OsalId);
+      }
+   }
+
+   return Status;
+
+} /* End JMSG_SOCK_OpenRx() */
+
+
+/******************************************************************************
+** Function: JMSG_SOCK_Recv
+**
+*/
+int32 JMSG_SOCK_Recv(JMSG_SOCK_Class_t *Sock, void *Buf, size_t BufLen, int32 Timeout,
+                     JMSG_SOCK_RxInfo_t *RxInfo)
+{
+
+   int32 Status;
+
+#ifdef JMSG_SOCK_NATIVE
+   if (Sock->Uring != NULL)
+   {
+      return RecvUring(Sock, Buf, BufLen, Timeout, RxInfo);
+   }
+   if (Sock->Native)
+   {
+      return RecvNative(Sock, Buf, BufLen, Timeout, RxInfo);
+   }
+#endif
+
+   Status = OS_SocketRecvFrom(Sock->OsalId, Buf, BufLen, &Sock->SrcAddr, Timeout);
+   RxInfo->Time = CFE_TIME_GetTime();
+   if (Status >= 0)
+   {
+      JMSG_SOCK_GetPeer(&Sock->SrcAddr, RxInfo);
+   }
+
+   return Status;
+
+} /* End JMSG_SOCK_Recv() */
+
+
+#ifdef JMSG_SOCK_NATIVE
+/******************************************************************************
+** Function: CloseLocal
+**
+** Close the Unix domain socket unless it's shared and remove its temporary
+** name if it wasn't committed.
+**
+*/
+static void CloseLocal(JMSG_SOCK_Class_t *Sock)
+{
+
+   char TmpPath[JMSG_SOCK_LOCAL_PATH_LEN];
+
+   if (Sock->LocalFd >= 0 && !Sock->LocalShared)
+   {
+      close(Sock->LocalFd);
+   }
+   if (Sock->LocalTmp)
+   {
+      GetTmpPath(Sock, TmpPath);
+      unlink(TmpPath);
+      Sock->LocalTmp = false;
+   }
+   Sock->LocalFd = -1;
+
+} /* End CloseLocal() */
+
+
+/******************************************************************************
+** Function: GetTmpPath
+**
+** Load the temporary name of the socket's path. The path's length has been
+** checked by OpenLocal().
+**
+*/
+static void GetTmpPath(const JMSG_SOCK_Class_t *Sock, char *TmpPath)
+{
+
+   size_t PathLen = strlen(Sock->LocalPath);
+
+   memcpy(TmpPath, Sock->LocalPath, PathLen);
+   memcpy(&TmpPath[PathLen], JMSG_SOCK_LOCAL_TMP_EXT, sizeof(JMSG_SOCK_LOCAL_TMP_EXT));
+
+} /* End GetTmpPath() */
+
+
+/******************************************************************************
+** Function: OpenLocal
+**
+** Open a Unix domain datagram socket bound to the socket's host path.
+**
+** Notes:
+**   1. Current's socket is shared if it's bound to the same path. When
+**      replacing an open socket the new socket is bound to the temporary
+**      name, see the file prologue.
+**
+*/
+static int32 OpenLocal(JMSG_SOCK_Class_t *Sock, const JMSG_SOCK_Class_t *Current)
+{
+
+   struct sockaddr_un SocketAddr;
+
+   if (strlen(Sock->LocalPath) + strlen(JMSG_SOCK_LOCAL_TMP_EXT) >= sizeof(SocketAddr.sun_path))
+   {
+      return OS_FS_ERR_PATH_TOO_LONG;
+   }
+
+   if (Current != NULL && Current->Open && Current->LocalFd >= 0 &&
+       strcmp(Current->LocalPath, Sock->LocalPath) == 0)
+   {
+      Sock->LocalFd     = Current->LocalFd;
+      Sock->LocalShared = true;
+      return OS_SUCCESS;
+   }
+
+   Sock->LocalFd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+   if (Sock->LocalFd < 0)
+   {
+      return OS_ERROR;
+   }
+
+   memset(&SocketAddr, 0, sizeof(SocketAddr));
+   SocketAddr.sun_family = AF_UNIX;
+   if (Current != NULL && Current->Open)
+   {
+      GetTmpPath(Sock, SocketAddr.sun_path);
+      Sock->LocalTmp = true;
+   }
+   else
+   {
+      memcpy(SocketAddr.sun_path, Sock->LocalPath, strlen(Sock->LocalPath) + 1);
+   }
+
+   /* A path left by a previous run or a replaced socket can't be bound */
+   unlink(SocketAddr.sun_path);
+   if (bind(Sock->LocalFd, (struct sockaddr *)&SocketAddr, sizeof(SocketAddr)) != 0)
+   {
+      Sock->LocalTmp = false;
+      close(Sock->LocalFd);
+      Sock->LocalFd = -1;
+      return OS_ERROR;
+   }
+
+   return OS_SUCCESS;
+
+} /* End OpenLocal() */
+
+
+/******************************************************************************
+** Function: OpenNative
+**
+*/
+static int32 OpenNative(JMSG_SOCK_Class_t *Sock, uint16 Port, bool KernelTime)
+{
+
+   int32 Status = OS_ERROR;
+   int   Enable = 1;
+   struct sockaddr_in SocketAddr;
+
+   Sock->Fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+   if (Sock->Fd >= 0)
+   {
+      memset(&SocketAddr, 0, sizeof(SocketAddr));
+      SocketAddr.sin_family      = AF_INET;
+      SocketAddr.sin_port        = htons(Port);
+      SocketAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+      if ((!KernelTime || setsockopt(Sock->Fd, SOL_SOCKET, SO_TIMESTAMPNS, &Enable, sizeof(Enable)) == 0) &&
+          bind(Sock->Fd, (struct sockaddr *)&SocketAddr, sizeof(SocketAddr)) == 0)
+      {
+         Sock->Native     = true;
+         Sock->KernelTime = KernelTime;
+         Sock->Open       = true;
+         Status = OS_SUCCESS;
+      }
+      else
+      {
+         close(Sock->Fd);
+         Sock->Fd = -1;
+      }
+   }
+
+   return Status;
+
+} /* End OpenNative() */
+
+
+/******************************************************************************
+** Function: RecvLocal
+**
+** Receive a waiting Unix domain datagram.
+**
+*/
+static int32 RecvLocal(JMSG_SOCK_Class_t *Sock, void *Buf, size_t BufLen, JMSG_SOCK_RxInfo_t *RxInfo)
+{
+
+   ssize_t RecvLen;
+
+   RecvLen = recv(Sock->LocalFd, Buf, BufLen, MSG_DONTWAIT);
+   if (RecvLen < 0)
+   {
+      return ((errno == EAGAIN || errno == EWOULDBLOCK) ? OS_ERROR_TIMEOUT : OS_ERROR);
+   }
+
+   RxInfo->PeerAddr = 0;
+   RxInfo->PeerPort = 0;
+   SetArrivalTime(RxInfo, 0);
+
+   return (int32)RecvLen;
+
+} /* End RecvLocal() */
+
+
+/******************************************************************************
+** Function: RecvNative
+**
+** Notes:
+**   1. When both sockets have a datagram the one not received from last
+**      time is received.
+**
+*/
+static int32 RecvNative(JMSG_SOCK_Class_t *Sock, void *Buf, size_t BufLen, int32 Timeout,
+                        JMSG_SOCK_RxInfo_t *RxInfo)
+{
+
+   int32   Status;
+   ssize_t RecvLen;
+   struct pollfd   PollFd[2];
+   struct iovec    Iov;
+   struct msghdr   Msg;
+   struct cmsghdr *Cmsg;
+   struct timespec KernelTime;
+   struct sockaddr_in PeerAddr;
+   int64  KernelTimeNs = 0;
+   union
+   {
+      char           Buf[CMSG_SPACE(sizeof(struct timespec))];
+      struct cmsghdr Align;
+   } Control;
+
+   PollFd[0].fd      = Sock->Fd;
+   PollFd[0].events  = POLLIN;
+   PollFd[0].revents = 0;
+   PollFd[1].fd      = Sock->LocalFd;
+   PollFd[1].events  = POLLIN;
+   PollFd[1].revents = 0;
+
+   Status = poll(PollFd, (Sock->LocalFd >= 0 ? 2 : 1), (Timeout < 0 ? -1 : Timeout));
+   if (Status == 0)
+   {
+      return OS_ERROR_TIMEOUT;
+   }
+   else if (Status < 0)
+   {
+      return (errno == EINTR ? OS_ERROR_TIMEOUT : OS_ERROR);
+   }
+
+   if (PollFd[1].revents != 0 && (PollFd[0].revents == 0 || Sock->LocalFirst))
+   {
+      Sock->LocalFirst = false;
+      return RecvLocal(Sock, Buf, BufLen, RxInfo);
+   }
+   Sock->LocalFirst = true;
+
+   Iov.iov_base = Buf;
+   Iov.iov_len  = BufLen;
+   memset(&Msg, 0, sizeof(Msg));
+   Msg.msg_name       = &PeerAddr;
+   Msg.msg_namelen    = sizeof(PeerAddr);
+   Msg.msg_iov        = &Iov;
+   Msg.msg_iovlen     = 1;
+   Msg.msg_control    = Control.Buf;
+   Msg.msg_controllen = sizeof(Control.Buf);
+
+   RecvLen = recvmsg(Sock->Fd, &Msg, MSG_DONTWAIT);
+   if (RecvLen < 0)
+   {
+      return ((errno == EAGAIN || errno == EWOULDBLOCK) ? OS_ERROR_TIMEOUT : OS_ERROR);
+   }
+
+   RxInfo->PeerAddr = ntohl(PeerAddr.sin_addr.s_addr);
+   RxInfo->PeerPort = ntohs(PeerAddr.sin_port);
+
+   for (Cmsg = CMSG_FIRSTHDR(&Msg); Cmsg != NULL; Cmsg = CMSG_NXTHDR(&Msg, Cmsg))
+   {
+      if (Cmsg->cmsg_level == SOL_SOCKET && Cmsg->cmsg_type == SCM_TIMESTAMPNS)
+      {
+         memcpy(&KernelTime, CMSG_DATA(Cmsg), sizeof(KernelTime));
+         KernelTimeNs = (int64)KernelTime.tv_sec*1000000000LL + KernelTime.tv_nsec;
+         break;
+      }
+   }
+   SetArrivalTime(RxInfo, KernelTimeNs);
+
+   return (int32)RecvLen;
+
+} /* End RecvNative() */
+
+
+/******************************************************************************
+** Function: RecvUring
+**
+*/
+static int32 RecvUring(JMSG_SOCK_Class_t *Sock, void *Buf, size_t BufLen, int32 Timeout,
+                       JMSG_SOCK_RxInfo_t *RxInfo)
+{
+
+   int32 Status;
+   JMSG_URING_RxMeta_t Meta;
+
+   Status = JMSG_URING_Recv(Sock->Uring, Buf, BufLen, Timeout, &Meta);
+   if (Status >= 0)
+   {
+      RxInfo->PeerAddr = Meta.PeerAddr;
+      RxInfo->PeerPort = Meta.PeerPort;
+      SetArrivalTime(RxInfo, Meta.KernelTimeNs);
+   }
+
+   return Status;
+
+} /* End RecvUring() */
+
+
+/******************************************************************************
+** Function: SetArrivalTime
+**
+** Set a datagram's cFE arrival time from its kernel receive time or, if
+** KernelTimeNs is zero, to the current time.
+**
+** Notes:
+**   1. The kernel timestamp uses CLOCK_REALTIME so the kernel queueing delay
+**      is measured against the same clock.
+**
+*/
+static void SetArrivalTime(JMSG_SOCK_RxInfo_t *RxInfo, int64 KernelTimeNs)
+{
+
+   struct timespec Now;
+   int64  DelayNs;
+   CFE_TIME_SysTime_t Delay;
+
+   RxInfo->Time = CFE_TIME_GetTime();
+
+   if (KernelTimeNs != 0)
+   {
+      clock_gettime(CLOCK_REALTIME, &Now);
+      DelayNs = (int64)Now.tv_sec*1000000000LL + Now.tv_nsec - KernelTimeNs;
+
+      /* A realtime clock step can produce a negative delay, keep the receive time */
+      if (DelayNs > 0)
+      {
+         Delay.Seconds    = (uint32)(DelayNs / 1000000000LL);
+         Delay.Subseconds = CFE_TIME_Micro2SubSecs((uint32)((DelayNs % 1000000000LL) / 1000));
+         RxInfo->Time = CFE_TIME_Subtract(RxInfo->Time, Delay);
+      }
+   }
+
+} /* End SetArrivalTime() */
+#endif /* JMSG_SOCK_NATIVE */
+
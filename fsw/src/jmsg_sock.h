@@ -0,0 +1,189 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Provide a UDP receive socket that reports each datagram's arrival time
+**
+** Notes:
+**   1. OSAL sockets don't expose kernel receive timestamps. When kernel
+**      timestamps are requested on Linux the socket is created natively with
+**      SO_TIMESTAMPNS. All other sockets use OSAL.
+**   2. On Linux the receive socket can be paired with a Unix domain
+**      datagram socket bound to a local path so processes on the same host
+**      can send JMSGs without the IP stack. The pair is created natively
+**      and a receive returns a datagram from either socket. Local datagrams
+**      are reported with a zero peer address and port.
+**   3. Arrival times are reported in cFE time. A kernel timestamp is
+**      converted by subtracting the time the datagram waited in the kernel
+**      from the current cFE time so the cFE and kernel clocks don't need to
+**      share an epoch. Without a kernel timestamp the arrival time is the cFE
+**      time when the receive returned.
+**   4. Peers are identified by IPv4 address and port. An OSAL address that
+**      isn't IPv4 is identified by a hash of its text.
+**   5. With the io_uring engine the sockets are created natively and
+**      received from with an io_uring, see jmsg_uring.h. If the kernel
+**      doesn't support it the native sockets are polled.
+**   6. A replacement socket shares the Unix domain socket of the socket it
+**      replaces when the path is unchanged. A new path is bound to a
+**      temporary name that's renamed to the path by JMSG_SOCK_CommitRx() so
+**      a replacement that's never committed doesn't take the path.
+**
+*/
+#ifndef _jmsg_sock_
+#define _jmsg_sock_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_uring.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_SOCK_LOCAL_PATH_LEN  108   /* Unix domain socket path including the terminator */
+#define JMSG_SOCK_LOCAL_TMP_EXT   ".new"  /* Appended to a path until it's committed */
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Datagram arrival information
+*/
+
+typedef struct
+{
+
+   CFE_TIME_SysTime_t  Time;
+   uint32              PeerAddr;
+   uint16              PeerPort;
+
+} JMSG_SOCK_RxInfo_t;
+
+
+typedef struct
+{
+
+   bool           Open;
+   bool           Native;      /* Native Linux socket */
+   bool           KernelTime;  /* Native socket with kernel timestamps */
+   int            Fd;
+   int            LocalFd;     /* Unix domain socket or -1 */
+   bool           LocalShared; /* LocalFd is owned by the socket being replaced */
+   bool           LocalTmp;    /* LocalFd is bound to the temporary name */
+   char           LocalPath[JMSG_SOCK_LOCAL_PATH_LEN];
+   bool           LocalFirst;  /* Alternates the socket checked first */
+   JMSG_URING_Rx_t *Uring;     /* io_uring receive ring or NULL */
+   osal_id_t      OsalId;
+   OS_SockAddr_t  SrcAddr;
+
+} JMSG_SOCK_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_SOCK_Close
+**
+** Notes:
+**   1. A shared Unix domain socket isn't closed and an uncommitted
+**      replacement's temporary name is removed.
+**
+*/
+void JMSG_SOCK_Close(JMSG_SOCK_Class_t *Sock);
+
+
+/******************************************************************************
+** Function: JMSG_SOCK_CommitRx
+**
+** Make a replacement socket from JMSG_SOCK_OpenRx() the owner of its Unix
+** domain socket.
+**
+** Notes:
+**   1. A shared Unix domain socket is removed from Current so closing
+**      Current doesn't close it. A temporary name is renamed to the path,
+**      replacing Current's socket file.
+**   2. Returns OS_SUCCESS or OS_ERROR if the rename failed. The socket can
+**      still be used and receives on the temporary name.
+**
+*/
+int32 JMSG_SOCK_CommitRx(JMSG_SOCK_Class_t *Sock, JMSG_SOCK_Class_t *Current);
+
+
+/******************************************************************************
+** Function: JMSG_SOCK_GetPeer
+**
+** Load the peer address and port of an OSAL socket address.
+**
+** Notes:
+**   1. See the file prologue for how non-IPv4 addresses are identified.
+**
+*/
+void JMSG_SOCK_GetPeer(const OS_SockAddr_t *SockAddr, JMSG_SOCK_RxInfo_t *RxInfo);
+
+
+/******************************************************************************
+** Function: JMSG_SOCK_OpenRx
+**
+** Open a datagram socket bound to a port on all interfaces and optionally
+** a Unix domain datagram socket bound to LocalPath.
+**
+** Notes:
+**   1. KernelTime requests kernel receive timestamps. It's ignored on
+**      targets that don't support SO_TIMESTAMPNS.
+**   2. An empty LocalPath doesn't open a Unix domain socket. A file at
+**      LocalPath is replaced. The path is a host path, not a cFE path, and
+**      must leave room for JMSG_SOCK_LOCAL_TMP_EXT.
+**   3. A non-zero UringDepth receives with an io_uring with UringDepth
+**      buffers of DatagramLen bytes. It's ignored on targets other than
+**      Linux. The caller can check Uring to see whether it was created.
+**   4. Current is the open socket being replaced or NULL. A replacement
+**      must be committed with JMSG_SOCK_CommitRx() before Current is
+**      closed, see the file prologue.
+**   5. Returns OS_SUCCESS or an OSAL error status. OS_ERR_NOT_IMPLEMENTED
+**      is returned for a LocalPath on targets other than Linux.
+**
+*/
+int32 JMSG_SOCK_OpenRx(JMSG_SOCK_Class_t *Sock, const JMSG_SOCK_Class_t *Current, uint16 Port,
+                       bool KernelTime, const char *LocalPath, uint16 UringDepth, uint32 DatagramLen);
+
+
+/******************************************************************************
+** Function: JMSG_SOCK_Recv
+**
+** Receive one datagram with its arrival time and sender.
+**
+** Notes:
+**   1. Timeout follows OSAL conventions: OS_PEND, OS_CHECK or milliseconds.
+**      A UDP and a Unix domain datagram are received alternately when both
+**      are waiting so neither source can starve the other. With io_uring
+**      they're received in arrival order.
+**   2. Returns the datagram length, OS_ERROR_TIMEOUT if no datagram
+**      arrived or another negative OSAL status.
+**
+*/
+int32 JMSG_SOCK_Recv(JMSG_SOCK_Class_t *Sock, void *Buf, size_t BufLen, int32 Timeout,
+                     JMSG_SOCK_RxInfo_t *RxInfo);
+
+
+#endif /* _jmsg_sock_ */
@@ -0,0 +1,928 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Precompiled JSON output templates for Tx routes
+**
+** Notes:
+**   1. See jmsg_tmpl.h
+**   2. The shortest float formatter binary searches the number of
+**      significant digits for the fewest that read back as the original
+**      value. The read back multiplies or divides an integer below 2^53 by
+**      an exact power of ten, which IEEE arithmetic rounds correctly, so the
+**      check agrees with strtod(). Values whose exponent is outside that
+**      exact range and doubles needing 16 or 17 digits are formatted with
+**      snprintf().
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jmsg_tmpl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define POW10_EXACT_MAX    22   /* Largest exact double power of ten */
+#define EXACT_DIGITS_MAX   15   /* Digits below 2^53 */
+#define FLOAT_DIGITS_MAX   9    /* Digits that round trip any float */
+#define UINT64_TENTH       1844674407370955161ull   /* UINT64 max / 10 */
+#define NUMBER_STR_MAX     64   /* Longest number passed to strtod() */
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static bool AddDigit(uint64 *Mant, char Digit);
+static uint16 FormatFixed(char *Out, double Value, uint8 Precision);
+static uint16 FormatShortest(char *Out, double Value, bool IsFloat);
+static uint16 FormatUint(char *Out, uint64 Value);
+static uint16 FormatValue(char *Out, const JMSG_TMPL_Field_t *Field, const uint8 *Payload);
+static bool AppendText(JMSG_TMPL_Tmpl_t *Tmpl, const char *Text, uint16 TextLen);
+static bool RoundTrips(double Abs, int16 Exp, uint16 DigitCnt, bool IsFloat,
+                       uint64 *Digits, int16 *Scale);
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static const double Pow10[POW10_EXACT_MAX+1] =
+{
+   1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint32 Pow10Int[JMSG_TMPL_PRECISION_MAX+1] =
+{
+   1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static const char DigitPairs[] =
+   "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+   "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+   "8081828384858687888990919293949596979899";
+
+static const struct
+{
+
+   const char *Name;
+   uint8       Size;
+
+} TypeDef[JMSG_TMPL_TYPE_CNT] =
+{
+   { "undef",  0 },
+   { "int8",   1 },
+   { "uint8",  1 },
+   { "int16",  2 },
+   { "uint16", 2 },
+   { "int32",  4 },
+   { "uint32", 4 },
+   { "int64",  8 },
+   { "uint64", 8 },
+   { "float",  4 },
+   { "double", 8 }
+};
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_Init
+**
+*/
+bool JMSG_TMPL_Init(JMSG_TMPL_Tmpl_t *Tmpl, const char *Object, uint16 ObjectLen)
+{
+
+   bool RetStatus = true;
+
+   memset(Tmpl, 0, offsetof(JMSG_TMPL_Tmpl_t, Text));
+
+   if (ObjectLen > 0)
+   {
+      Tmpl->ObjectLen = ObjectLen;
+      RetStatus = AppendText(Tmpl, "{\"", 2) && AppendText(Tmpl, Object, ObjectLen) &&
+                  AppendText(Tmpl, "\":{", 3);
+   }
+   else
+   {
+      RetStatus = AppendText(Tmpl, "{", 1);
+   }
+
+   return RetStatus;
+
+} /* End JMSG_TMPL_Init() */
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_AddField
+**
+** Notes:
+**   1. Room for the closing braces is reserved so JMSG_TMPL_Finish() never
+**      fails for lack of text space.
+**
+*/
+bool JMSG_TMPL_AddField(JMSG_TMPL_Tmpl_t *Tmpl, const char *Key, uint16 KeyLen,
+                        JMSG_TMPL_Type_t Type, uint32 Offset, uint8 Precision)
+{
+
+   JMSG_TMPL_Field_t *Field = &Tmpl->Field[Tmpl->FieldCnt];
+   uint16 i;
+
+   if (Tmpl->FieldCnt >= JMSG_UDP_PLATFORM_TMPL_FIELD_MAX || KeyLen == 0 || KeyLen > 0xFF ||
+       Type <= JMSG_TMPL_TYPE_UNDEF || Type >= JMSG_TMPL_TYPE_CNT ||
+       Offset > (uint32)(0xFFFF - TypeDef[Type].Size) ||
+       (Precision > JMSG_TMPL_PRECISION_MAX && Precision != JMSG_TMPL_PRECISION_SHORTEST))
+   {
+      return false;
+   }
+
+   for (i=0; i < KeyLen; i++)
+   {
+      if (Key[i] == '"' || Key[i] == '\\' || (uint8)Key[i] < ' ')
+      {
+         return false;
+      }
+   }
+
+   if ((uint32)Tmpl->TextLen + KeyLen + 4 + 2 > JMSG_UDP_PLATFORM_TMPL_TEXT_MAX)
+   {
+      return false;
+   }
+
+   if (Tmpl->FieldCnt > 0)
+   {
+      AppendText(Tmpl, ",", 1);
+   }
+   AppendText(Tmpl, "\"", 1);
+   Field->KeyPos = Tmpl->TextLen;
+   AppendText(Tmpl, Key, KeyLen);
+   AppendText(Tmpl, "\":", 2);
+
+   Field->Offset    = Offset;
+   Field->TextEnd   = Tmpl->TextLen;
+   Field->KeyLen    = KeyLen;
+   Field->Type      = Type;
+   Field->Precision = Precision;
+
+   if (Offset + TypeDef[Type].Size > Tmpl->MinPayloadLen)
+   {
+      Tmpl->MinPayloadLen = Offset + TypeDef[Type].Size;
+   }
+
+   Tmpl->FieldCnt++;
+
+   return true;
+
+} /* End JMSG_TMPL_AddField() */
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_Finish
+**
+** Notes:
+**   1. The ID is a FNV-1a hash of the fields and text so caches derived
+**      from a template can tell when a reloaded template changed.
+**
+*/
+bool JMSG_TMPL_Finish(JMSG_TMPL_Tmpl_t *Tmpl, uint32 PayloadLen, uint8 FcnCode)
+{
+
+   const uint8 *Byte;
+   uint32 Len;
+   uint32 i;
+
+   if (PayloadLen == 0)
+   {
+      PayloadLen = Tmpl->MinPayloadLen;
+   }
+
+   if (Tmpl->FieldCnt == 0 || PayloadLen < Tmpl->MinPayloadLen || PayloadLen > 0xFFFF ||
+       !AppendText(Tmpl, "}}", (Tmpl->ObjectLen > 0 ? 2 : 1)))
+   {
+      return false;
+   }
+
+   Tmpl->PayloadLen = PayloadLen;
+   Tmpl->FcnCode    = FcnCode;
+
+   Tmpl->Id = 2166136261u;
+   Byte = (const uint8 *)Tmpl->Field;
+   Len  = Tmpl->FieldCnt * sizeof(JMSG_TMPL_Field_t);
+   for (i=0; i < Len; i++)
+   {
+      Tmpl->Id = (Tmpl->Id ^ Byte[i]) * 16777619u;
+   }
+   for (i=0; i < Tmpl->TextLen; i++)
+   {
+      Tmpl->Id = (Tmpl->Id ^ (uint8)Tmpl->Text[i]) * 16777619u;
+   }
+   Tmpl->Id ^= Tmpl->PayloadLen | ((uint32)FcnCode << 16);
+
+   return true;
+
+} /* End JMSG_TMPL_Finish() */
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_Fill
+**
+*/
+int32 JMSG_TMPL_Fill(const JMSG_TMPL_Tmpl_t *Tmpl, const uint8 *Payload,
+                     size_t PayloadLen, char *Json)
+{
+
+   const JMSG_TMPL_Field_t *Field;
+   uint16 TextPos = 0;
+   uint32 JsonLen = 0;
+   uint16 i;
+
+   if (PayloadLen < Tmpl->MinPayloadLen)
+   {
+      return -1;
+   }
+
+   for (i=0; i < Tmpl->FieldCnt; i++)
+   {
+      Field = &Tmpl->Field[i];
+      memcpy(&Json[JsonLen], &Tmpl->Text[TextPos], Field->TextEnd - TextPos);
+      JsonLen += Field->TextEnd - TextPos;
+      TextPos  = Field->TextEnd;
+      JsonLen += FormatValue(&Json[JsonLen], Field, Payload);
+   }
+
+   memcpy(&Json[JsonLen], &Tmpl->Text[TextPos], Tmpl->TextLen - TextPos);
+   JsonLen += Tmpl->TextLen - TextPos;
+   Json[JsonLen] = '\0';
+
+   return (int32)JsonLen;
+
+} /* End JMSG_TMPL_Fill() */
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_ParseNumber
+**
+** Notes:
+**   1. Digits that would overflow the uint64 mantissa are dropped and
+**      counted in the exponent. Such numbers aren't exact so they use
+**      strtod().
+**
+*/
+uint16 JMSG_TMPL_ParseNumber(const char *Str, uint16 Len, JMSG_TMPL_Number_t *Number)
+{
+
+   char   NumStr[NUMBER_STR_MAX];
+   uint64 Mant = 0;
+   int32  Exp10 = 0;
+   int32  ExpPart = 0;
+   bool   ExpNeg = false;
+   bool   Dropped = false;
+   bool   IsInt = true;
+   uint16 Pos = 0;
+   uint16 Start;
+
+   Number->Neg = (Len > 0 && Str[0] == '-');
+   if (Number->Neg)
+   {
+      Pos++;
+   }
+
+   /* Integer part, a leading zero can't be followed by digits */
+   if (Pos < Len && Str[Pos] == '0')
+   {
+      Pos++;
+   }
+   else if (Pos < Len && Str[Pos] >= '1' && Str[Pos] <= '9')
+   {
+      while (Pos < Len && Str[Pos] >= '0' && Str[Pos] <= '9')
+      {
+         if (Dropped || !AddDigit(&Mant, Str[Pos]))
+         {
+            Exp10++;
+            Dropped = true;
+         }
+         Pos++;
+      }
+   }
+   else
+   {
+      return 0;
+   }
+
+   if (Pos < Len && Str[Pos] == '.')
+   {
+      IsInt = false;
+      Start = ++Pos;
+      while (Pos < Len && Str[Pos] >= '0' && Str[Pos] <= '9')
+      {
+         if (!Dropped && AddDigit(&Mant, Str[Pos]))
+         {
+            Exp10--;
+         }
+         else
+         {
+            Dropped = true;
+         }
+         Pos++;
+      }
+      if (Pos == Start)
+      {
+         return 0;
+      }
+   }
+
+   if (Pos < Len && (Str[Pos] == 'e' || Str[Pos] == 'E'))
+   {
+      IsInt = false;
+      Pos++;
+      if (Pos < Len && (Str[Pos] == '+' || Str[Pos] == '-'))
+      {
+         ExpNeg = (Str[Pos] == '-');
+         Pos++;
+      }
+      Start = Pos;
+      while (Pos < Len && Str[Pos] >= '0' && Str[Pos] <= '9')
+      {
+         if (ExpPart < 10000)
+         {
+            ExpPart = ExpPart*10 + (Str[Pos] - '0');
+         }
+         Pos++;
+      }
+      if (Pos == Start)
+      {
+         return 0;
+      }
+      Exp10 += ExpNeg ? -ExpPart : ExpPart;
+   }
+
+   Number->IsInt = IsInt && !Dropped;
+   Number->Mag   = Mant;
+
+   if (!Dropped && Mant < ((uint64)1 << 53) && Exp10 >= -POW10_EXACT_MAX && Exp10 <= POW10_EXACT_MAX)
+   {
+      Number->Real = (Exp10 >= 0) ? (double)Mant * Pow10[Exp10] : (double)Mant / Pow10[-Exp10];
+   }
+   else if (Pos < NUMBER_STR_MAX)
+   {
+      memcpy(NumStr, Str, Pos);
+      NumStr[Pos] = '\0';
+      Number->Real = strtod(&NumStr[Number->Neg], NULL);
+   }
+   else
+   {
+      return 0;
+   }
+
+   if (Number->Neg)
+   {
+      Number->Real = -Number->Real;
+   }
+
+   return Pos;
+
+} /* End JMSG_TMPL_ParseNumber() */
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_StoreNumber
+**
+** Notes:
+**   1. A number with a fraction or exponent can be stored in an integer
+**      field if its value is an integer, e.g. 1.0 or 1e3.
+**
+*/
+bool JMSG_TMPL_StoreNumber(const JMSG_TMPL_Field_t *Field, const JMSG_TMPL_Number_t *Number,
+                           uint8 *Payload)
+{
+
+   uint8  Bits = TypeDef[Field->Type].Size * 8;
+   uint64 Mag  = Number->Mag;
+   double Abs  = Number->Neg ? -Number->Real : Number->Real;
+   union
+   {
+      uint64 U64;
+      int64  I64;
+      uint32 U32;
+      int32  I32;
+      uint16 U16;
+      int16  I16;
+      uint8  U8;
+      int8   I8;
+      float  F32;
+      double F64;
+   } Value;
+
+   if (Field->Type == JMSG_TMPL_TYPE_FLOAT)
+   {
+      Value.F32 = (float)Number->Real;
+   }
+   else if (Field->Type == JMSG_TMPL_TYPE_DOUBLE)
+   {
+      Value.F64 = Number->Real;
+   }
+   else
+   {
+      if (!Number->IsInt)
+      {
+         /* 2^64 is exact so the comparison doesn't round */
+         if (Abs >= 18446744073709551616.0 || Abs != (double)(uint64)Abs)
+         {
+            return false;
+         }
+         Mag = (uint64)Abs;
+      }
+
+      if (Field->Type == JMSG_TMPL_TYPE_INT8 || Field->Type == JMSG_TMPL_TYPE_INT16 ||
+          Field->Type == JMSG_TMPL_TYPE_INT32 || Field->Type == JMSG_TMPL_TYPE_INT64)
+      {
+         if (Mag > ((uint64)1 << (Bits-1)) - (Number->Neg ? 0 : 1))
+         {
+            return false;
+         }
+         Value.I64 = Number->Neg ? (int64)((uint64)0 - Mag) : (int64)Mag;
+         switch (Field->Type)
+         {
+            case JMSG_TMPL_TYPE_INT8:  Value.I8  = (int8)Value.I64;  break;
+            case JMSG_TMPL_TYPE_INT16: Value.I16 = (int16)Value.I64; break;
+            case JMSG_TMPL_TYPE_INT32: Value.I32 = (int32)Value.I64; break;
+            default: break;
+         }
+      }
+      else
+      {
+         if ((Number->Neg && Mag != 0) || (Bits < 64 && Mag > (((uint64)1 << Bits) - 1)))
+         {
+            return false;
+         }
+         switch (Field->Type)
+         {
+            case JMSG_TMPL_TYPE_UINT8:  Value.U8  = (uint8)Mag;  break;
+            case JMSG_TMPL_TYPE_UINT16: Value.U16 = (uint16)Mag; break;
+            case JMSG_TMPL_TYPE_UINT32: Value.U32 = (uint32)Mag; break;
+            default: Value.U64 = Mag; break;
+         }
+      }
+   }
+
+   memcpy(&Payload[Field->Offset], &Value, TypeDef[Field->Type].Size);
+
+   return true;
+
+} /* End JMSG_TMPL_StoreNumber() */
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_ParseType
+**
+*/
+JMSG_TMPL_Type_t JMSG_TMPL_ParseType(const char *Name, uint16 NameLen)
+{
+
+   JMSG_TMPL_Type_t Type;
+
+   for (Type = JMSG_TMPL_TYPE_UNDEF + 1; Type < JMSG_TMPL_TYPE_CNT; Type++)
+   {
+      if (strlen(TypeDef[Type].Name) == NameLen && memcmp(TypeDef[Type].Name, Name, NameLen) == 0)
+      {
+         return Type;
+      }
+   }
+
+   return JMSG_TMPL_TYPE_UNDEF;
+
+} /* End JMSG_TMPL_ParseType() */
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_TypeSize
+**
+*/
+uint8 JMSG_TMPL_TypeSize(JMSG_TMPL_Type_t Type)
+{
+
+   return TypeDef[(Type < JMSG_TMPL_TYPE_CNT) ? Type : JMSG_TMPL_TYPE_UNDEF].Size;
+
+} /* End JMSG_TMPL_TypeSize() */
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_TypeStr
+**
+*/
+const char *JMSG_TMPL_TypeStr(JMSG_TMPL_Type_t Type)
+{
+
+   return TypeDef[(Type < JMSG_TMPL_TYPE_CNT) ? Type : JMSG_TMPL_TYPE_UNDEF].Name;
+
+} /* End JMSG_TMPL_TypeStr() */
+
+
+/******************************************************************************
+** Function: AddDigit
+**
+** Append a decimal digit to a mantissa unless the mantissa would overflow.
+**
+*/
+static bool AddDigit(uint64 *Mant, char Digit)
+{
+
+   uint8 Value = Digit - '0';
+
+   if (*Mant > UINT64_TENTH || (*Mant == UINT64_TENTH && Value > 5))
+   {
+      return false;
+   }
+
+   *Mant = *Mant*10 + Value;
+
+   return true;
+
+} /* End AddDigit() */
+
+
+/******************************************************************************
+** Function: AppendText
+**
+*/
+static bool AppendText(JMSG_TMPL_Tmpl_t *Tmpl, const char *Text, uint16 TextLen)
+{
+
+   bool RetStatus = false;
+
+   if ((uint32)Tmpl->TextLen + TextLen <= JMSG_UDP_PLATFORM_TMPL_TEXT_MAX)
+   {
+      memcpy(&Tmpl->Text[Tmpl->TextLen], Text, TextLen);
+      Tmpl->TextLen += TextLen;
+      RetStatus = true;
+   }
+
+   return RetStatus;
+
+} /* End AppendText() */
+
+
+/******************************************************************************
+** Function: FormatFixed
+**
+** Write a value with Precision decimal places like "%.*f".
+**
+** Notes:
+**   1. The value is scaled before it's rounded so a value within rounding
+**      error of a half way point may round up where "%.*f" rounds down.
+**
+*/
+static uint16 FormatFixed(char *Out, double Value, uint8 Precision)
+{
+
+   double Scaled;
+   uint64 Rounded;
+   uint32 Frac;
+   uint16 Len = 0;
+   int16  i;
+
+   if ((Value - Value) != 0.0)
+   {
+      memcpy(Out, "null", 4);
+      return 4;
+   }
+
+   Scaled = (Value < 0.0 ? -Value : Value) * Pow10[Precision];
+   if (Scaled >= Pow10[EXACT_DIGITS_MAX])
+   {
+      return FormatShortest(Out, Value, false);
+   }
+
+   Rounded = (uint64)(Scaled + 0.5);
+   if (Value < 0.0 && Rounded != 0)
+   {
+      Out[Len++] = '-';
+   }
+   Len += FormatUint(&Out[Len], Rounded / Pow10Int[Precision]);
+
+   if (Precision > 0)
+   {
+      Out[Len++] = '.';
+      Frac = (uint32)(Rounded % Pow10Int[Precision]);
+      for (i=Precision-1; i >= 0; i--)
+      {
+         Out[Len + i] = '0' + (Frac % 10);
+         Frac /= 10;
+      }
+      Len += Precision;
+   }
+
+   return Len;
+
+} /* End FormatFixed() */
+
+
+/******************************************************************************
+** Function: FormatShortest
+**
+** Write the fewest significant digits that read back as Value, or as the
+** float Value was read from when IsFloat is true.
+**
+** Notes:
+**   1. Exp starts as an estimate of the decimal exponent of the first
+**      significant digit. An estimate that's off by one costs an iteration
+**      but the digits and the decimal point are derived from Digits itself.
+**
+*/
+static uint16 FormatShortest(char *Out, double Value, bool IsFloat)
+{
+
+   char   DigitStr[24];
+   double Abs;
+   uint64 Digits = 0;
+   uint64 MidDigits;
+   int16  Exp = 0;
+   int16  Scale = 0;
+   int16  MidScale;
+   int16  DigitCnt;
+   int16  PointPos;
+   uint16 MaxDigits = IsFloat ? FLOAT_DIGITS_MAX : EXACT_DIGITS_MAX;
+   uint16 Lo = 1;
+   uint16 Hi;
+   uint16 Mid;
+   uint16 Len = 0;
+   bool   Found = false;
+   int16  i;
+
+   if ((Value - Value) != 0.0)
+   {
+      memcpy(Out, "null", 4);
+      return 4;
+   }
+   if (Value == 0.0)
+   {
+      Out[0] = '0';
+      return 1;
+   }
+
+   Abs = (Value < 0.0) ? -Value : Value;
+   if (Abs >= 1.0)
+   {
+      while (Exp < POW10_EXACT_MAX && Abs >= Pow10[Exp+1])
+      {
+         Exp++;
+      }
+   }
+   else
+   {
+      while (Exp > -POW10_EXACT_MAX && Abs * Pow10[-Exp] < 1.0)
+      {
+         Exp--;
+      }
+   }
+
+   /* Every scale used below must be an exact power of ten */
+   if (Exp >= (int16)MaxDigits - 1 - POW10_EXACT_MAX && Exp < POW10_EXACT_MAX)
+   {
+      Found = RoundTrips(Abs, Exp, MaxDigits, IsFloat, &Digits, &Scale);
+      Hi = MaxDigits;
+      while (Found && Lo < Hi)
+      {
+         Mid = (Lo + Hi) / 2;
+         if (RoundTrips(Abs, Exp, Mid, IsFloat, &MidDigits, &MidScale))
+         {
+            Hi     = Mid;
+            Digits = MidDigits;
+            Scale  = MidScale;
+         }
+         else
+         {
+            Lo = Mid + 1;
+         }
+      }
+   }
+
+   if (!Found)
+   {
+      return snprintf(Out, JMSG_TMPL_VALUE_MAX_LEN, "%.*g", (IsFloat ? FLOAT_DIGITS_MAX : 17), Value);
+   }
+
+   /* Value is Digits * 10^-Scale, or 0.DigitStr * 10^PointPos */
+   DigitCnt = FormatUint(DigitStr, Digits);
+   PointPos = DigitCnt - Scale;
+   while (DigitCnt > 1 && DigitStr[DigitCnt-1] == '0')
+   {
+      DigitCnt--;
+   }
+
+   if (Value < 0.0)
+   {
+      Out[Len++] = '-';
+   }
+
+   if (PointPos <= 0 && PointPos > -6)
+   {
+      Out[Len++] = '0';
+      Out[Len++] = '.';
+      for (i=PointPos; i < 0; i++)
+      {
+         Out[Len++] = '0';
+      }
+      memcpy(&Out[Len], DigitStr, DigitCnt);
+      Len += DigitCnt;
+   }
+   else if (PointPos > 0 && PointPos <= 17)
+   {
+      if (DigitCnt <= PointPos)
+      {
+         memcpy(&Out[Len], DigitStr, DigitCnt);
+         Len += DigitCnt;
+         for (i=DigitCnt; i < PointPos; i++)
+         {
+            Out[Len++] = '0';
+         }
+      }
+      else
+      {
+         memcpy(&Out[Len], DigitStr, PointPos);
+         Len += PointPos;
+         Out[Len++] = '.';
+         memcpy(&Out[Len], &DigitStr[PointPos], DigitCnt - PointPos);
+         Len += DigitCnt - PointPos;
+      }
+   }
+   else
+   {
+      Out[Len++] = DigitStr[0];
+      if (DigitCnt > 1)
+      {
+         Out[Len++] = '.';
+         memcpy(&Out[Len], &DigitStr[1], DigitCnt - 1);
+         Len += DigitCnt - 1;
+      }
+      Out[Len++] = 'e';
+      if (PointPos - 1 < 0)
+      {
+         Out[Len++] = '-';
+         Len += FormatUint(&Out[Len], 1 - PointPos);
+      }
+      else
+      {
+         Len += FormatUint(&Out[Len], PointPos - 1);
+      }
+   }
+
+   return Len;
+
+} /* End FormatShortest() */
+
+
+/******************************************************************************
+** Function: RoundTrips
+**
+** Round Abs to DigitCnt significant digits and return true if they read
+** back as Abs. Abs is Digits * 10^-Scale.
+**
+*/
+static bool RoundTrips(double Abs, int16 Exp, uint16 DigitCnt, bool IsFloat,
+                       uint64 *Digits, int16 *Scale)
+{
+
+   double ReadBack;
+
+   *Scale = DigitCnt - 1 - Exp;
+   if (*Scale >= 0)
+   {
+      *Digits  = (uint64)(Abs * Pow10[*Scale] + 0.5);
+      ReadBack = (double)*Digits / Pow10[*Scale];
+   }
+   else
+   {
+      *Digits  = (uint64)(Abs / Pow10[-*Scale] + 0.5);
+      ReadBack = (double)*Digits * Pow10[-*Scale];
+   }
+
+   return IsFloat ? ((float)ReadBack == (float)Abs) : (ReadBack == Abs);
+
+} /* End RoundTrips() */
+
+
+/******************************************************************************
+** Function: FormatUint
+**
+** Write an unsigned integer two digits at a time and return its length.
+**
+*/
+static uint16 FormatUint(char *Out, uint64 Value)
+{
+
+   char   Rev[20];
+   uint16 Pos = sizeof(Rev);
+   uint16 Len;
+   uint32 Pair;
+
+   while (Value >= 100)
+   {
+      Pair  = (uint32)(Value % 100) * 2;
+      Value /= 100;
+      Rev[--Pos] = DigitPairs[Pair + 1];
+      Rev[--Pos] = DigitPairs[Pair];
+   }
+   if (Value >= 10)
+   {
+      Pair = (uint32)Value * 2;
+      Rev[--Pos] = DigitPairs[Pair + 1];
+      Rev[--Pos] = DigitPairs[Pair];
+   }
+   else
+   {
+      Rev[--Pos] = '0' + (char)Value;
+   }
+
+   Len = sizeof(Rev) - Pos;
+   memcpy(Out, &Rev[Pos], Len);
+
+   return Len;
+
+} /* End FormatUint() */
+
+
+/******************************************************************************
+** Function: FormatValue
+**
+*/
+static uint16 FormatValue(char *Out, const JMSG_TMPL_Field_t *Field, const uint8 *Payload)
+{
+
+   const uint8 *Src = &Payload[Field->Offset];
+   uint16 Len = 0;
+   int64  Int = 0;
+   uint64 Uint = 0;
+   bool   IsSigned = true;
+   union
+   {
+      int8   I8;
+      uint8  U8;
+      int16  I16;
+      uint16 U16;
+      int32  I32;
+      uint32 U32;
+      int64  I64;
+      uint64 U64;
+      float  F32;
+      double F64;
+   } Value;
+
+   memcpy(&Value, Src, TypeDef[Field->Type].Size);
+
+   switch (Field->Type)
+   {
+      case JMSG_TMPL_TYPE_INT8:   Int = Value.I8;  break;
+      case JMSG_TMPL_TYPE_INT16:  Int = Value.I16; break;
+      case JMSG_TMPL_TYPE_INT32:  Int = Value.I32; break;
+      case JMSG_TMPL_TYPE_INT64:  Int = Value.I64; break;
+      case JMSG_TMPL_TYPE_UINT8:  Uint = Value.U8;  IsSigned = false; break;
+      case JMSG_TMPL_TYPE_UINT16: Uint = Value.U16; IsSigned = false; break;
+      case JMSG_TMPL_TYPE_UINT32: Uint = Value.U32; IsSigned = false; break;
+      case JMSG_TMPL_TYPE_UINT64: Uint = Value.U64; IsSigned = false; break;
+      case JMSG_TMPL_TYPE_FLOAT:
+         return (Field->Precision == JMSG_TMPL_PRECISION_SHORTEST) ?
+                FormatShortest(Out, Value.F32, true) : FormatFixed(Out, Value.F32, Field->Precision);
+      case JMSG_TMPL_TYPE_DOUBLE:
+         return (Field->Precision == JMSG_TMPL_PRECISION_SHORTEST) ?
+                FormatShortest(Out, Value.F64, false) : FormatFixed(Out, Value.F64, Field->Precision);
+      default:
+         memcpy(Out, "null", 4);
+         return 4;
+   }
+
+   if (IsSigned)
+   {
+      if (Int < 0)
+      {
+         Out[Len++] = '-';
+         Uint = (uint64)0 - (uint64)Int;
+      }
+      else
+      {
+         Uint = (uint64)Int;
+      }
+   }
+
+   return Len + FormatUint(&Out[Len], Uint);
+
+} /* End FormatValue() */
@@ -0,0 +1,254 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Precompiled JSON templates that map SB message fields to JSON members
+**
+** Notes:
+**   1. A template is the JSON text of a flat object with the key and
+**      punctuation bytes compiled once, when the route is loaded, and a slot
+**      after each key for a value read from the SB message. Filling a
+**      template only formats the values.
+**   2. Field offsets are byte offsets from the start of the payload that
+**      follows the message's command or telemetry header. Values are read
+**      and written in the processor's byte order at unaligned addresses.
+**   3. Floating point values are written with the fewest significant
+**      digits that read back as the same float or double, or with a fixed
+**      number of decimal places when a field has a precision. Non-finite
+**      values are written as null because JSON can't represent them.
+**   4. An optional object name nests the fields in a single member, the
+**      layout JMSG_LIB topic plugins use, e.g. {"rpi-demo":{"rate-x":1.5}}.
+**   5. A template is not thread safe. Owners that rebuild a template while
+**      another task fills it must double buffer it.
+**   6. Rx messages are built from a template by parsing each field's JSON
+**      number and storing it in the field. The number parser converts up to
+**      15 significant digits with a decimal exponent of at most 22 exactly
+**      with one IEEE multiply or divide and uses strtod() otherwise.
+**
+*/
+#ifndef _jmsg_tmpl_
+#define _jmsg_tmpl_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_TMPL_PRECISION_SHORTEST  0xFF
+#define JMSG_TMPL_PRECISION_MAX       9
+
+/* Longest formatted value, a 17 digit double with sign, point and exponent */
+#define JMSG_TMPL_VALUE_MAX_LEN  32
+
+/* Buffer length that holds any filled template and its terminator */
+#define JMSG_TMPL_JSON_MAX_LEN   (JMSG_UDP_PLATFORM_TMPL_TEXT_MAX + \
+                                  JMSG_UDP_PLATFORM_TMPL_FIELD_MAX*JMSG_TMPL_VALUE_MAX_LEN + 1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef enum
+{
+
+   JMSG_TMPL_TYPE_UNDEF = 0,
+   JMSG_TMPL_TYPE_INT8,
+   JMSG_TMPL_TYPE_UINT8,
+   JMSG_TMPL_TYPE_INT16,
+   JMSG_TMPL_TYPE_UINT16,
+   JMSG_TMPL_TYPE_INT32,
+   JMSG_TMPL_TYPE_UINT32,
+   JMSG_TMPL_TYPE_INT64,
+   JMSG_TMPL_TYPE_UINT64,
+   JMSG_TMPL_TYPE_FLOAT,
+   JMSG_TMPL_TYPE_DOUBLE,
+   JMSG_TMPL_TYPE_CNT
+
+} JMSG_TMPL_Type_t;
+
+
+typedef struct
+{
+
+   uint16  Offset;      /* Payload byte offset of the value */
+   uint16  TextEnd;     /* Template text preceding the value ends here */
+   uint16  KeyPos;      /* Key name in the template text */
+   uint8   KeyLen;
+   uint8   Type;        /* JMSG_TMPL_Type_t */
+   uint8   Precision;   /* Decimal places or JMSG_TMPL_PRECISION_SHORTEST */
+
+} JMSG_TMPL_Field_t;
+
+
+/*
+** JSON number parsed by JMSG_TMPL_ParseNumber()
+*/
+typedef struct
+{
+
+   double  Real;
+   uint64  Mag;      /* Magnitude of an integer literal */
+   bool    Neg;
+   bool    IsInt;    /* Literal is an integer that fits in Mag */
+
+} JMSG_TMPL_Number_t;
+
+
+typedef struct
+{
+
+   uint16  FieldCnt;
+   uint16  ObjectLen;      /* Zero if the fields aren't nested */
+   uint16  TextLen;
+   uint16  MinPayloadLen;  /* Shortest payload holding every field */
+   uint16  PayloadLen;     /* Payload length of Rx messages */
+   uint8   FcnCode;        /* Function code of Rx command messages */
+   uint32  Id;             /* Hash identifying the template's content */
+
+   JMSG_TMPL_Field_t  Field[JMSG_UDP_PLATFORM_TMPL_FIELD_MAX];
+
+   char    Text[JMSG_UDP_PLATFORM_TMPL_TEXT_MAX];   /* Must be last, see JMSG_TMPL_Init() */
+
+} JMSG_TMPL_Tmpl_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_Init
+**
+** Start a template whose fields are nested in Object, or not nested if
+** ObjectLen is zero.
+**
+** Notes:
+**   1. Returns false if the object name doesn't fit.
+**
+*/
+bool JMSG_TMPL_Init(JMSG_TMPL_Tmpl_t *Tmpl, const char *Object, uint16 ObjectLen);
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_AddField
+**
+** Append a field to a template started with JMSG_TMPL_Init().
+**
+** Notes:
+**   1. Precision is the number of decimal places of a floating point
+**      value, up to JMSG_TMPL_PRECISION_MAX, or
+**      JMSG_TMPL_PRECISION_SHORTEST. It's ignored for integers.
+**   2. Returns false if a parameter is invalid or the template is full.
+**
+*/
+bool JMSG_TMPL_AddField(JMSG_TMPL_Tmpl_t *Tmpl, const char *Key, uint16 KeyLen,
+                        JMSG_TMPL_Type_t Type, uint32 Offset, uint8 Precision);
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_Finish
+**
+** Close the template's JSON text and set the Rx message payload length and
+** command function code.
+**
+** Notes:
+**   1. A PayloadLen of zero uses the end of the last field.
+**   2. Returns false if the template has no fields, the text doesn't fit or
+**      PayloadLen is shorter than the fields.
+**
+*/
+bool JMSG_TMPL_Finish(JMSG_TMPL_Tmpl_t *Tmpl, uint32 PayloadLen, uint8 FcnCode);
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_Fill
+**
+** Write a template's JSON text with the values of a SB message payload.
+**
+** Notes:
+**   1. Json must hold TextLen + FieldCnt*JMSG_TMPL_VALUE_MAX_LEN + 1
+**      characters, at most JMSG_TMPL_JSON_MAX_LEN. The JSON is null
+**      terminated.
+**   2. Returns the JSON length or -1 if the payload is shorter than the
+**      template's MinPayloadLen.
+**
+*/
+int32 JMSG_TMPL_Fill(const JMSG_TMPL_Tmpl_t *Tmpl, const uint8 *Payload,
+                     size_t PayloadLen, char *Json);
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_ParseNumber
+**
+** Parse the JSON number at the start of Str.
+**
+** Notes:
+**   1. Returns the number of characters parsed or zero if Str doesn't start
+**      with a valid JSON number. Numbers that need strtod() must be shorter
+**      than 64 characters.
+**
+*/
+uint16 JMSG_TMPL_ParseNumber(const char *Str, uint16 Len, JMSG_TMPL_Number_t *Number);
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_StoreNumber
+**
+** Store a parsed number in a field of a SB message payload.
+**
+** Notes:
+**   1. Returns false if the number is out of the field type's range or
+**      isn't an integer for an integer field.
+**
+*/
+bool JMSG_TMPL_StoreNumber(const JMSG_TMPL_Field_t *Field, const JMSG_TMPL_Number_t *Number,
+                           uint8 *Payload);
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_ParseType
+**
+** Return the type named by a JSON table string, e.g. "uint16", or
+** JMSG_TMPL_TYPE_UNDEF.
+**
+*/
+JMSG_TMPL_Type_t JMSG_TMPL_ParseType(const char *Name, uint16 NameLen);
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_TypeSize
+**
+** Return the number of payload bytes of a type, zero if it's undefined.
+**
+*/
+uint8 JMSG_TMPL_TypeSize(JMSG_TMPL_Type_t Type);
+
+
+/******************************************************************************
+** Function: JMSG_TMPL_TypeStr
+**
+*/
+const char *JMSG_TMPL_TypeStr(JMSG_TMPL_Type_t Type);
+
+
+#endif /* _jmsg_tmpl_ */
@@ -29,15 +29,33 @@
 ** Include Files:
 */
 
+#include <stdio.h>
 #include <string.h>
 
+#include "jmsg_cap.h"
+#include "jmsg_decode.h"
+#include "jmsg_frag.h"
+#include "jmsg_hdr.h"
+#include "jmsg_lz.h"
+#include "jmsg_rel.h"
+#include "jmsg_selftest.h"
 #include "jmsg_trans.h"
-#include "jmsg_topic_tbl.h"
 
 /********************************** **/
 /** Local File Function Prototypes **/
 /************************************/
 
+static bool ProcessFrag(const JMSG_SOCK_RxInfo_t *RxInfo, const JMSG_HDR_Attr_t *HdrAttr,
+                        const char *Slice, uint16 SliceLen);
+static bool ProcessMsg(const char *MsgData, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *RxInfo,
+                       bool Reassembled);
+static bool IsDuplicate(const JMSG_SOCK_RxInfo_t *RxInfo, const char *Topic,
+                        const JMSG_HDR_Attr_t *HdrAttr);
+static uint8 *InitTmplMsg(JMSG_TRANS_RxCtx_t *RxCtx, const JMSG_ROUTE_TBL_Route_t *Route,
+                          const JMSG_TMPL_Tmpl_t *Tmpl);
+static bool LockConverter(void);
+
+
 
 /**********************/
 /** Global File Data **/
@@ -50,41 +68,82 @@ static JMSG_TRANS_Class_t *JMsgTrans = NULL;
 ** Function: JMSG_TRANS_Constructor
 **
 */
-void JMSG_TRANS_Constructor(JMSG_TRANS_Class_t *JMsgTransPtr)
+void JMSG_TRANS_Constructor(JMSG_TRANS_Class_t *JMsgTransPtr, const INITBL_Class_t *IniTbl)
 {
  
    JMsgTrans = JMsgTransPtr;
 
    CFE_PSP_MemSet((void*)JMsgTransPtr, 0, sizeof(JMSG_TRANS_Class_t));
 
+   JMsgTrans->JsonMaxDepth = INITBL_GetIntConfig(IniTbl, CFG_JSON_MAX_DEPTH);
+
+   JMsgTrans->LookupPerfId   = INITBL_GetIntConfig(IniTbl, CFG_ROUTE_LOOKUP_PERF_ID);
+   JMsgTrans->JsonToSbPerfId = INITBL_GetIntConfig(IniTbl, CFG_JSON_TO_SB_PERF_ID);
+   JMsgTrans->SbSendPerfId   = INITBL_GetIntConfig(IniTbl, CFG_SB_SEND_PERF_ID);
+   JMsgTrans->SbToJsonPerfId = INITBL_GetIntConfig(IniTbl, CFG_SB_TO_JSON_PERF_ID);
+
+   JMSG_SEQ_Constructor(&JMsgTrans->Seq, (INITBL_GetIntConfig(IniTbl, CFG_TX_SEQ) != 0));
+   JMSG_TRANS_InitRxCtx(&JMsgTrans->RxCtx);
+   JMsgTrans->RxCtx.StagePerfLog = true;
 
 } /* End JMSG_TRANS_Constructor() */
 
 
 /******************************************************************************
-** Function: JMSG_TRANS_ProcessJMsg
+** Function: JMSG_TRANS_CreateConvLock
+**
+*/
+void JMSG_TRANS_CreateConvLock(void)
+{
+
+   if (!JMsgTrans->ConvLockCreated)
+   {
+      JMsgTrans->ConvLockCreated = (OS_MutSemCreate(&JMsgTrans->ConvMutex, "JMSG_UDP_CONV", 0) == OS_SUCCESS);
+   }
+
+} /* End JMSG_TRANS_CreateConvLock() */
+
+
+/******************************************************************************
+** Function: JMSG_TRANS_DecodeJMsg
 **
 ** Notes:
-**   1. Assumes caller has ensured a null terminated string
-**   2. Topic string uses MQTT path style topics with a colon appended to the end 
-**   3. Test strings that can be pasted in console:
-**      echo -n 'hello' >  /dev/udp/localhost/8888   # Error: Null message length since no colon
-**      echo -n 'hello:' >  /dev/udp/localhost/8888  # Error: Can't find topic in table
-**      echo -n 'basecamp/test:' >  /dev/udp/localhost/8888  # Error: JSON query error since no JSON text
-**      echo -n 'basecamp/test:{"int32": 1,"float": 2.3}' >  /dev/udp/localhost/8888  # Successfully send SB test message
-**      echo -n 'basecamp/rpi/demo:{"rpi-demo":{"rate-x": 1.0, "rate-y": 2.0, "rate-z": 3.0, "lux": 456}}' >  /dev/udp/localhost/8888
+**   1. The payload is structurally validated before it's converted so
+**      malformed JSON is rejected without calling a topic plugin. A template
+**      route's payload that matches its topic's cached shape is converted
+**      without the scan because its text outside the numbers is the text of
+**      a payload that passed the scan.
+**   2. The topic is routed with the compiled route table matcher so the 
+**      lookup time does not depend on the number of routes. A route with a
+**      message ID overrides the converter's message ID.
+**   3. Performance log markers bracket the route lookup, the payload scan
+**      and conversion, and the SB transmit. A performance ID can only be
+**      entered by one task at a time so decode workers don't log the stage
+**      markers and are measured by their child task performance IDs.
+**   4. A self-test message is translated but not sent on the SB and its
+**      arrival is reported to the self-test.
+**   5. The plugin converter lock is held until the message is sent because
+**      the message is in the plugin's buffer. Template messages are built
+**      in the decoder context and aren't locked.
+**   6. A template route's bank stays pinned while the SB message is built
+**      from the template and is released before the message is sent.
 */
-bool JMSG_TRANS_ProcessJMsg(const char *MsgData)
+bool JMSG_TRANS_DecodeJMsg(JMSG_TRANS_RxCtx_t *RxCtx, const JMSG_SOCK_RxInfo_t *RxInfo,
+                           const JMSG_HDR_Attr_t *HdrAttr, const char *Topic,
+                           const char *Payload, uint16 PayloadLen)
 {
-   char    *MsgPayload;
-   char    MsgTopicName[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN]; 
-   uint16  MsgTopicNameLen;
-   uint16  MsgPayloadLen;
-   uint16  TblTopicNameLen;
+   uint16  TopicLen = HdrAttr->TopicLen;
    bool    MsgFound = false;
-   const JMSG_TOPIC_TBL_Topic_t *TopicTblEntry;
-   JMSG_PLATFORM_TopicPlugin_Enum_t TopicPluginId = JMSG_PLATFORM_TopicPlugin_Enum_t_MIN;
+   bool    RouteFound = false;
+   bool    Converted = false;
+   bool    ConvLocked = false;
+   uint16  RouteIdx;
+   JMSG_ROUTE_TBL_Lookup_t Lookup;
+   const JMSG_ROUTE_TBL_Route_t *Route = &Lookup.Route;
 
+   JMSG_SCAN_Status_t  ScanStatus;
+   JMSG_SHAPE_Status_t ShapeStatus = JMSG_SHAPE_MISS;
+   uint8  *TmplPayload = NULL;
    JMSG_TOPIC_TBL_JsonToCfe_t JsonToCfe;
    CFE_MSG_Message_t *CfeMsg;
    CFE_SB_MsgId_t    MsgId = CFE_SB_INVALID_MSG_ID;
@@ -92,120 +151,229 @@ bool JMSG_TRANS_ProcessJMsg(const char *MsgData)
    CFE_MSG_Type_t    MsgType;
    
    
+   RxCtx->RxMsgId = 0;
    CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_DEBUG,
-                     "JMSG_TRANS_ProcessJMsg: Received JMSG %s", MsgData);
-                    
-   MsgPayload = strchr(MsgData, ':');
-                    
-   if(MsgPayload != NULL)
+                     "Message topic name len %d, text: %.*s", TopicLen, TopicLen, Topic);
+
+   if (RxCtx->StagePerfLog)
    {
-      MsgPayload++;  // Move past colon
-      MsgTopicNameLen = MsgPayload - MsgData;
-      strncpy(MsgTopicName, MsgData, MsgTopicNameLen);
-      MsgTopicName[MsgTopicNameLen] = '\0';
-      MsgPayloadLen = strlen(MsgData) - MsgTopicNameLen;
-      
+      CFE_ES_PerfLogEntry(JMsgTrans->LookupPerfId);
+   }
+   RouteFound = JMSG_ROUTE_TBL_RxLookup(Topic, TopicLen, &Lookup);
+   RouteIdx   = Lookup.RouteIdx;
+   if (RxCtx->StagePerfLog)
+   {
+      CFE_ES_PerfLogExit(JMsgTrans->LookupPerfId);
+      CFE_ES_PerfLogEntry(JMsgTrans->JsonToSbPerfId);
+   }
+   
+   if (Lookup.Tmpl != NULL)
+   {
+      TmplPayload = InitTmplMsg(RxCtx, Route, Lookup.Tmpl);
+      ShapeStatus = JMSG_SHAPE_Match(&RxCtx->Shape, Topic, TopicLen, Lookup.Tmpl,
+                                     Payload, PayloadLen, TmplPayload);
+   }
+   
+   ScanStatus = JMSG_SCAN_OK;
+   if (ShapeStatus == JMSG_SHAPE_MISS)
+   {
+      ScanStatus = JMSG_SCAN_Payload(&RxCtx->ScanIndex, Payload, PayloadLen, JMsgTrans->JsonMaxDepth);
+      if (ScanStatus != JMSG_SCAN_OK)
+      {
+         CFE_EVS_SendEvent(JMSG_TRANS_INVALID_JSON_EID, CFE_EVS_EventType_ERROR,
+                           "JMSG_TRANS_DecodeJMsg: Rejected topic %.*s payload, %s",
+                           TopicLen, Topic, JMSG_SCAN_StatusStr(ScanStatus));
+      }
+      else if (TmplPayload != NULL)
+      {
+         ShapeStatus = JMSG_SHAPE_Learn(&RxCtx->Shape, Topic, TopicLen, Lookup.Tmpl, Payload,
+                                        PayloadLen, &RxCtx->ScanIndex, TmplPayload);
+      }
+      else if (RouteFound)
+      {
+         ConvLocked = LockConverter();
+         JsonToCfe  = JMSG_TOPIC_TBL_GetJsonToCfe(Route->Converter);    
+         Converted  = JsonToCfe(&CfeMsg, Payload, PayloadLen);
+      }
+   }
+   
+   if (TmplPayload != NULL)
+   {
+      CfeMsg    = (CFE_MSG_Message_t *)RxCtx->RxTmplMsg;
+      Converted = (ShapeStatus == JMSG_SHAPE_OK);
+      JMSG_ROUTE_TBL_Release(&Lookup);
+   }
+   if (RxCtx->StagePerfLog)
+   {
+      CFE_ES_PerfLogExit(JMsgTrans->JsonToSbPerfId);
+   }
+
+   if (ScanStatus == JMSG_SCAN_OK && RouteFound)
+   {
+      MsgFound = true;
       CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_DEBUG,
-                        "Message topic name len %d, text: %s", MsgTopicNameLen, MsgTopicName);
+                       "JMSG_TRANS_DecodeJMsg: Topic=%.*s, TopicLen=%d, Payload=%.*s, PayloadLen=%d", 
+                        TopicLen, Topic, TopicLen, PayloadLen, Payload, PayloadLen);
+   }
 
-      while (!MsgFound && TopicPluginId <= JMSG_PLATFORM_TopicPlugin_Enum_t_MAX)
+   if (MsgFound)
+   {
+         
+      CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_DEBUG,
+                        "JMSG_TRANS_DecodeJMsg: Found route %d, converter %d", RouteIdx, Route->Converter); 
+    
+      if (Converted && HdrAttr->TestValid)
       {
-         TopicTblEntry = JMSG_TOPIC_TBL_GetTopic(TopicPluginId);
-         if (TopicTblEntry != NULL)
+         CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_DEBUG,
+                           "JMSG_TRANS_DecodeJMsg: Received self-test message %u", (unsigned int)HdrAttr->Test);
+      }
+      else if (Converted)
+      {         
+   
+         if (Route->MsgId != 0)
          {
-            TblTopicNameLen = strlen(TopicTblEntry->Name);
-            
-            if (TblTopicNameLen < JMSG_PLATFORM_TOPIC_NAME_MAX_LEN)
-            {
-               
-               CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_DEBUG,
-                                 "Table topic name=%s, length=%d", TopicTblEntry->Name, TblTopicNameLen);
-               
-               if (strncmp(TopicTblEntry->Name, MsgTopicName, TblTopicNameLen) == 0)
-               {
-                  
-                  MsgFound = true;
-                  CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_DEBUG,
-                                   "JMSG_TRANS_ProcessJMsg: Topic=%s, TopicLen=%d, Payload=%s, PayloadLen=%d", 
-                                    MsgTopicName, MsgTopicNameLen, MsgPayload, MsgPayloadLen);
-               }
-            } /* End if valid length */
-            else
-            {
-               CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR,
-                                 "Table topic name %s with length %d exceeds maximum length %d", 
-                                 TopicTblEntry->Name, TblTopicNameLen, JMSG_PLATFORM_TOPIC_NAME_MAX_LEN);               
-            }
-         } /* End while loop */
+            CFE_MSG_SetMsgId(CfeMsg, CFE_SB_ValueToMsgId(Route->MsgId));
+         }
+         CFE_MSG_GetMsgId(CfeMsg, &MsgId);
+         CFE_MSG_GetSize(CfeMsg, &MsgSize);
          
-         if (!MsgFound)
+         CFE_MSG_GetType(CfeMsg,&MsgType);
+         CFE_MSG_GetTypeFromMsgId(MsgId, &MsgType);
+         if (MsgType == CFE_MSG_Type_Cmd)
          {
-            TopicPluginId++;
+            CFE_MSG_GenerateChecksum(CFE_MSG_PTR(*CfeMsg));
          }
-      } /* End while loop */
-
-      if (MsgFound)
-      {
-            
+         else
+         {
+            CFE_MSG_SetMsgTime(CFE_MSG_PTR(*CfeMsg), RxInfo->Time);
+         }
+         
          CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_DEBUG,
-                           "JMSG_TRANS_ProcessJMsg: Found message at index %d", TopicPluginId); 
-                              
-         JsonToCfe = JMSG_TOPIC_TBL_GetJsonToCfe(TopicPluginId);    
-       
-         if (JsonToCfe(&CfeMsg, MsgPayload, MsgPayloadLen))
-         {         
-      
-            CFE_MSG_GetMsgId(CfeMsg, &MsgId);
-            CFE_MSG_GetSize(CfeMsg, &MsgSize);
-            
-            CFE_MSG_GetType(CfeMsg,&MsgType);
-            CFE_MSG_GetTypeFromMsgId(MsgId, &MsgType);
-            if (MsgType == CFE_MSG_Type_Cmd)
-            {
-               CFE_MSG_GenerateChecksum(CFE_MSG_PTR(*CfeMsg));
-            }
-            else
-            {
-               CFE_SB_TimeStampMsg(CFE_MSG_PTR(*CfeMsg));
-            }
-            
-            CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_DEBUG,
-                              "MSG_TRANS_ProcessJMsg: Sending SB message 0x%04X(%d), len %d, type %d", 
-                              CFE_SB_MsgIdToValue(MsgId), CFE_SB_MsgIdToValue(MsgId), (int)MsgSize, (int)MsgType); 
-            CFE_SB_TransmitMsg(CFE_MSG_PTR(*CfeMsg), true);               
-            JMsgTrans->ValidJMsgCnt++;
-            
+                           "JMSG_TRANS_DecodeJMsg: Sending SB message 0x%04X(%d), len %d, type %d", 
+                           CFE_SB_MsgIdToValue(MsgId), CFE_SB_MsgIdToValue(MsgId), (int)MsgSize, (int)MsgType); 
+         if (RxCtx->StagePerfLog)
+         {
+            CFE_ES_PerfLogEntry(JMsgTrans->SbSendPerfId);
          }
-         else
+         CFE_SB_TransmitMsg(CFE_MSG_PTR(*CfeMsg), true);               
+         if (RxCtx->StagePerfLog)
          {
-            CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR,
-                              "MSG_TRANS_ProcessJMsg: Error creating SB message from JSON topic %s, Id %d",
-                              MsgTopicName, TopicPluginId); 
+            CFE_ES_PerfLogExit(JMsgTrans->SbSendPerfId);
          }
+         RxCtx->ValidJMsgCnt++;
+         RxCtx->RxMsgId = CFE_SB_MsgIdToValue(MsgId);
          
-      } /* End if message found */
-      else 
-      {      
-         CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR, 
-                           "JMSG_TRANS_ProcessJMsg: Could not find a topic match for %s", 
-                           MsgTopicName);      
       }
-   
-   } /* End null message len */
-   else 
-   {
+      else if (TmplPayload != NULL)
+      {
+         CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR,
+                           "JMSG_TRANS_DecodeJMsg: Error creating SB message from JSON topic %.*s with route %d's template, %s",
+                           TopicLen, Topic, RouteIdx, JMSG_SHAPE_StatusStr(ShapeStatus)); 
+      }
+      else
+      {
+         CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR,
+                           "JMSG_TRANS_DecodeJMsg: Error creating SB message from JSON topic %.*s, route %d",
+                           TopicLen, Topic, RouteIdx); 
+      }
       
-      CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR,
-                        "Null JSON message data length for %s", MsgData);
+   } /* End if message found */
+   else if (ScanStatus == JMSG_SCAN_OK)
+   {      
+      CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR, 
+                        "JMSG_TRANS_DecodeJMsg: Could not find a topic match for %.*s", 
+                        TopicLen, Topic);      
    }
 
+   if (ConvLocked)
+   {
+      OS_MutSemGive(JMsgTrans->ConvMutex);
+   }
+   
    if (!MsgFound)
    {
-      JMsgTrans->InvalidJMsgCnt++;
+      RxCtx->InvalidJMsgCnt++;
    }   
    
+   if (HdrAttr->TestValid)
+   {
+      JMSG_SELFTEST_RecvRxMsg(HdrAttr->Test, MsgFound && Converted);
+   }
+   
    return MsgFound;
 
+} /* End JMSG_TRANS_DecodeJMsg() */
+
+
+/******************************************************************************
+** Function: JMSG_TRANS_InitRxCtx
+**
+*/
+void JMSG_TRANS_InitRxCtx(JMSG_TRANS_RxCtx_t *RxCtx)
+{
+
+   CFE_PSP_MemSet((void*)RxCtx, 0, sizeof(JMSG_TRANS_RxCtx_t));
+
+   JMSG_SHAPE_Constructor(&RxCtx->Shape);
+
+} /* End JMSG_TRANS_InitRxCtx() */
+
+
+/******************************************************************************
+** Function: JMSG_TRANS_ProcessJMsg
+**
+** Notes:
+**   1. MsgData is not required to be null terminated. All processing uses 
+**      explicit lengths and the topic name is never copied.
+**   2. Topic string uses MQTT path style topics with a colon appended to the end 
+**   3. Test strings that can be pasted in console:
+**      echo -n 'hello' >  /dev/udp/localhost/8888   # Error: Null message length since no colon
+**      echo -n 'hello:' >  /dev/udp/localhost/8888  # Error: Can't find topic in table
+**      echo -n 'basecamp/test:' >  /dev/udp/localhost/8888  # Error: JSON query error since no JSON text
+**      echo -n 'basecamp/test:{"int32": 1,"float": 2.3}' >  /dev/udp/localhost/8888  # Successfully send SB test message
+**      echo -n 'basecamp/rpi/demo:{"rpi-demo":{"rate-x": 1.0, "rate-y": 2.0, "rate-z": 3.0, "lux": 456}}' >  /dev/udp/localhost/8888
+**   4. Header attributes follow the topic name. A duplicate sequence number
+**      is dropped before the payload is decoded so redundantly sent commands
+**      are only executed once.
+**   5. A reliable message is acknowledged before the duplicate check so a
+**      retransmission caused by a lost ack is acknowledged again. An ack
+**      has no payload and is consumed here.
+**   6. A fragment is added to its reassembly buffer. The fragment that
+**      completes a message causes the whole message to be processed. A
+**      reassembled message can't be a fragment.
+**   7. A compressed payload is decompressed after the duplicate check so
+**      duplicates aren't decompressed.
+**   8. The payload is decoded by JMSG_TRANS_DecodeJMsg() with the Rx task's
+**      context unless a decode worker queue takes it. A message dropped
+**      because its worker's queue is full is counted by the worker and
+**      isn't counted as invalid.
+**   9. While capturing, a queued payload carries its datagram so the
+**      worker records it with the SB message ID once it's decoded. Other
+**      datagrams, including fragments that don't complete a message and
+**      dropped payloads, are recorded here after translation. Translation
+**      doesn't modify MsgData.
+**  10. A self-test "t" attribute is cleared before the payload is decoded
+**      unless the message belongs to the running self-test, so it's sent
+**      on the SB like any other JMSG.
+*/
+bool JMSG_TRANS_ProcessJMsg(const char *MsgData, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *RxInfo)
+{
+
+   bool RetStatus;
+   
+   JMsgTrans->RxDatagram    = MsgData;
+   JMsgTrans->RxDatagramLen = MsgLen;
+   JMsgTrans->RxCapQueued   = false;
+   
+   RetStatus = ProcessMsg(MsgData, MsgLen, RxInfo, false);
+   
+   if (!JMsgTrans->RxCapQueued)
+   {
+      JMSG_CAP_Rx(MsgData, MsgLen, RxInfo, JMsgTrans->RxCtx.RxMsgId);
+   }
+   
+   return RetStatus;
+
 } /* End JMSG_TRANS_ProcessJMsg() */
 
 
@@ -215,22 +383,37 @@ bool JMSG_TRANS_ProcessJMsg(const char *MsgData)
 ** Notes:
 **   1. Linux command to receive messages on UDP port
 **      nc -u -l -p <port_number>
+**   2. A route with a JSON template is formatted from the template instead
+**      of calling the topic plugin's converter. The template and filter
+**      are used in the pinned route bank without copying them and the
+**      template is filled directly into JsonBuf.
+**   3. The SB to JSON performance log marker brackets the conversion but
+**      not the route lookup, which is a hash probe.
+**   4. A message rejected by its route's filter isn't converted and
+**      returns false without an error.
 **
 */
-bool JMSG_TRANS_ProcessSbMsg(const CFE_MSG_Message_t *CfeMsgPtr,
-                             const char **Topic, const char **Payload)
+bool JMSG_TRANS_ProcessSbMsg(const CFE_MSG_Message_t *CfeMsgPtr, char *JsonBuf, uint32 JsonBufLen,
+                             const char **Topic, uint32 *PayloadLen)
 {
    
    bool RetStatus = false;
-   int32 TopicIndex;
    int32 SbStatus;
    CFE_SB_MsgId_t  MsgId = CFE_SB_INVALID_MSG_ID;
+   JMSG_ROUTE_TBL_Lookup_t Lookup;
+   JMSG_ROUTE_TBL_Route_t *Route = &JMsgTrans->TxRoute;
    JMSG_TOPIC_TBL_CfeToJson_t CfeToJson;
    const char *JsonMsgTopic;
    const char *JsonMsgPayload;
+   CFE_MSG_Size_t MsgSize = 0;
+   CFE_MSG_Type_t MsgType = CFE_MSG_Type_Tlm;
+   size_t HdrLen = 0;
+   size_t JsonLen = 0;
+   int32  FillLen;
+   bool Converted;
 
-   *Topic   = NULL; 
-   *Payload = NULL;
+   *Topic      = NULL; 
+   *PayloadLen = 0;
    
    SbStatus = CFE_MSG_GetMsgId(CfeMsgPtr, &MsgId);
    if (SbStatus == CFE_SUCCESS)
@@ -240,33 +423,95 @@ bool JMSG_TRANS_ProcessSbMsg(const CFE_MSG_Message_t *CfeMsgPtr,
                         "JMSG_TRANS_ProcessSbMsg: Received SB message ID 0x%04X(%d)", 
                         CFE_SB_MsgIdToValue(MsgId), CFE_SB_MsgIdToValue(MsgId)); 
       
-      if ((TopicIndex = JMSG_TOPIC_TBL_MsgIdToTopicPlugin(MsgId)) != JMSG_PLATFORM_TOPIC_PLUGIN_UNDEF)
+      if (JMSG_ROUTE_TBL_TxLookup(MsgId, &Lookup))
       {
          
-         CfeToJson = JMSG_TOPIC_TBL_GetCfeToJson(TopicIndex, &JsonMsgTopic);    
+         *Route = Lookup.Route;
+         if (Lookup.Tmpl != NULL || Lookup.Filter != NULL)
+         {
+            CFE_MSG_GetSize(CfeMsgPtr, &MsgSize);
+            CFE_MSG_GetType(CfeMsgPtr, &MsgType);
+            HdrLen = (MsgType == CFE_MSG_Type_Cmd) ? sizeof(CFE_MSG_CommandHeader_t) : sizeof(CFE_MSG_TelemetryHeader_t);
+         }
+         
+         if (Lookup.Filter != NULL && MsgSize >= HdrLen &&
+             !JMSG_FILTER_Eval(Lookup.Filter, &JMsgTrans->TxFilterPrev[Route->FilterIdx],
+                               (const uint8 *)CfeMsgPtr + HdrLen, MsgSize - HdrLen))
+         {
+            JMSG_ROUTE_TBL_Release(&Lookup);
+            JMsgTrans->FilterSbMsgCnt++;
+            return false;
+         }
+         
+         CFE_ES_PerfLogEntry(JMsgTrans->SbToJsonPerfId);
+         if (Lookup.Tmpl != NULL)
+         {
+            JsonMsgTopic = Route->Name;
+            Converted = false;
+            if (MsgSize >= HdrLen && JsonBufLen > (uint32)Lookup.Tmpl->TextLen + 
+                                     Lookup.Tmpl->FieldCnt*JMSG_TMPL_VALUE_MAX_LEN)
+            {
+               FillLen = JMSG_TMPL_Fill(Lookup.Tmpl, (const uint8 *)CfeMsgPtr + HdrLen,
+                                        MsgSize - HdrLen, JsonBuf);
+               if (FillLen >= 0)
+               {
+                  JsonLen   = FillLen;
+                  Converted = true;
+                  JMsgTrans->TmplSbMsgCnt++;
+               }
+            }
+         }
+         else
+         {
+            CfeToJson = JMSG_TOPIC_TBL_GetCfeToJson(Route->Converter, &JsonMsgTopic);    
+            Converted = CfeToJson(&JsonMsgPayload, CfeMsgPtr);
+            if (Converted)
+            {
+               JsonLen = strlen(JsonMsgPayload);
+               Converted = (JsonLen < JsonBufLen);
+               if (Converted)
+               {
+                  memcpy(JsonBuf, JsonMsgPayload, JsonLen + 1);
+               }
+            }
+         }
+         CFE_ES_PerfLogExit(JMsgTrans->SbToJsonPerfId);
          
-         if (CfeToJson(&JsonMsgPayload, CfeMsgPtr))
+         if (Converted)
          {
-            *Topic   = JsonMsgTopic; 
-            *Payload = JsonMsgPayload;
+            /* Table routes publish with the route name */
+            *Topic      = Route->FromTbl ? Route->Name : JsonMsgTopic; 
+            *PayloadLen = JsonLen;
             RetStatus = true;
             CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_SB_MSG_EID, CFE_EVS_EventType_INFORMATION,
-                              "Created JMSG plugin topic %s message %s",
-                              JsonMsgTopic, JsonMsgPayload);             
+                              "Created JMSG route %d topic %s message %s",
+                              Lookup.RouteIdx, *Topic, JsonBuf);             
             JMsgTrans->ValidSbMsgCnt++;
 
          }
          else
          {
-            CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_SB_MSG_EID, CFE_EVS_EventType_ERROR,
-                              "Error creating JSON message from SB for plugin topic %d", TopicIndex); 
+            if (Lookup.Tmpl != NULL)
+            {
+               CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_SB_MSG_EID, CFE_EVS_EventType_ERROR,
+                                 "SB message length %u is shorter than the %u byte header and payload route %d's template reads or its JSON exceeds %u characters", 
+                                 (unsigned int)MsgSize, (unsigned int)(HdrLen + Lookup.Tmpl->MinPayloadLen), 
+                                 Lookup.RouteIdx, (unsigned int)(JsonBufLen - 1));
+            }
+            else
+            {
+               CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_SB_MSG_EID, CFE_EVS_EventType_ERROR,
+                                 "Error creating JSON message from SB for route %d, converter %d", 
+                                 Lookup.RouteIdx, Route->Converter); 
+            }
          
-         }        
+         }
+         JMSG_ROUTE_TBL_Release(&Lookup);
       }
       else
       {
          CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_SB_MSG_EID, CFE_EVS_EventType_ERROR, 
-                           "Unable to locate SB message 0x%04X(%d) in JMSG plugin topic table", 
+                           "Unable to locate SB message 0x%04X(%d) in JMSG route table", 
                            CFE_SB_MsgIdToValue(MsgId), CFE_SB_MsgIdToValue(MsgId));
       }
 
@@ -282,6 +527,21 @@ bool JMSG_TRANS_ProcessSbMsg(const CFE_MSG_Message_t *CfeMsgPtr,
 } /* End JMSG_TRANS_ProcessSbMsg() */
 
 
+/******************************************************************************
+** Function: JMSG_TRANS_ResetRxCtx
+**
+*/
+void JMSG_TRANS_ResetRxCtx(JMSG_TRANS_RxCtx_t *RxCtx)
+{
+
+   RxCtx->ValidJMsgCnt   = 0;
+   RxCtx->InvalidJMsgCnt = 0;
+
+   JMSG_SHAPE_ResetStatus(&RxCtx->Shape);
+
+} /* End JMSG_TRANS_ResetRxCtx() */
+
+
 /******************************************************************************
 ** Function: JMSG_TRANS_ResetStatus
 **
@@ -291,10 +551,230 @@ bool JMSG_TRANS_ProcessSbMsg(const CFE_MSG_Message_t *CfeMsgPtr,
 void JMSG_TRANS_ResetStatus(void)
 {
 
-   JMsgTrans->ValidJMsgCnt    = 0;
-   JMsgTrans->InvalidJMsgCnt  = 0;
    JMsgTrans->ValidSbMsgCnt   = 0;
+   JMsgTrans->TmplSbMsgCnt    = 0;
+   JMsgTrans->FilterSbMsgCnt  = 0;
    JMsgTrans->InvalidSbMsgCnt = 0;
+   JMsgTrans->DupJMsgCnt      = 0;
+
+   JMSG_SEQ_ResetStatus();
+   JMSG_TRANS_ResetRxCtx(&JMsgTrans->RxCtx);
 
 } /* JMSG_TRANS_ResetStatus() */
 
+
+/******************************************************************************
+** Function: InitTmplMsg
+**
+** Initialize the Rx template SB message for a route and return its payload.
+**
+** Notes:
+**   1. The message type follows the route's message ID so the template's
+**      field offsets are relative to the payload after either header.
+**
+*/
+static uint8 *InitTmplMsg(JMSG_TRANS_RxCtx_t *RxCtx, const JMSG_ROUTE_TBL_Route_t *Route,
+                          const JMSG_TMPL_Tmpl_t *Tmpl)
+{
+
+   CFE_MSG_Message_t *MsgPtr = (CFE_MSG_Message_t *)RxCtx->RxTmplMsg;
+   CFE_SB_MsgId_t MsgId = CFE_SB_ValueToMsgId(Route->TxMsgId);
+   CFE_MSG_Type_t MsgType = CFE_MSG_Type_Tlm;
+   size_t HdrLen;
+
+   CFE_MSG_GetTypeFromMsgId(MsgId, &MsgType);
+   HdrLen = (MsgType == CFE_MSG_Type_Cmd) ? sizeof(CFE_MSG_CommandHeader_t) : sizeof(CFE_MSG_TelemetryHeader_t);
+
+   CFE_MSG_Init(MsgPtr, MsgId, HdrLen + Tmpl->PayloadLen);
+   if (MsgType == CFE_MSG_Type_Cmd)
+   {
+      CFE_MSG_SetFcnCode(MsgPtr, Tmpl->FcnCode);
+   }
+
+   return (uint8 *)RxCtx->RxTmplMsg + HdrLen;
+
+} /* End InitTmplMsg() */
+
+
+/******************************************************************************
+** Function: IsDuplicate
+**
+** Acknowledge a reliable message and check whether its sequence number has
+** already been received.
+**
+*/
+static bool IsDuplicate(const JMSG_SOCK_RxInfo_t *RxInfo, const char *Topic,
+                        const JMSG_HDR_Attr_t *HdrAttr)
+{
+
+   if (HdrAttr->Reliable)
+   {
+      JMSG_REL_SendAck(RxInfo, Topic, HdrAttr->TopicLen, HdrAttr->Seq);
+   }
+
+   return (JMSG_SEQ_CheckRx(RxInfo, Topic, HdrAttr->TopicLen, HdrAttr->Seq) == JMSG_SEQ_DUPLICATE);
+
+} /* End IsDuplicate() */
+
+
+/******************************************************************************
+** Function: LockConverter
+**
+** Take the plugin converter lock if decode workers run and return whether
+** it was taken.
+**
+*/
+static bool LockConverter(void)
+{
+
+   if (!JMsgTrans->ConvLockCreated)
+   {
+      return false;
+   }
+
+   OS_MutSemTake(JMsgTrans->ConvMutex);
+
+   return true;
+
+} /* End LockConverter() */
+
+
+/******************************************************************************
+** Function: ProcessFrag
+**
+** Notes:
+**   1. Returns true while the message is incomplete.
+**
+*/
+static bool ProcessFrag(const JMSG_SOCK_RxInfo_t *RxInfo, const JMSG_HDR_Attr_t *HdrAttr,
+                        const char *Slice, uint16 SliceLen)
+{
+
+   bool   RetStatus = true;
+   const char *Msg;
+   uint16 MsgLen;
+   uint16 RxMsgIdx;
+
+   Msg = JMSG_FRAG_AddRx(RxInfo, HdrAttr, Slice, SliceLen, &MsgLen, &RxMsgIdx);
+   if (Msg != NULL)
+   {
+      RetStatus = ProcessMsg(Msg, MsgLen, RxInfo, true);
+      JMSG_FRAG_ReleaseRx(RxMsgIdx);
+   }
+
+   return RetStatus;
+
+} /* End ProcessFrag() */
+
+/******************************************************************************
+** Function: ProcessMsg
+**
+** Process a received or reassembled JMSG, see JMSG_TRANS_ProcessJMsg().
+**
+** Notes:
+**   1. A reassembled message that is itself a fragment is rejected so
+**      reassembly never nests and ProcessFrag() re-enters this function at
+**      most once per datagram.
+**
+*/
+static bool ProcessMsg(const char *MsgData, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *RxInfo,
+                       bool Reassembled)
+{
+   const char *MsgPayload;
+   const char *Colon;
+   uint16  MsgHdrLen;
+   uint16  MsgTopicNameLen;
+   uint16  MsgPayloadLen;
+   JMSG_HDR_Attr_t HdrAttr;
+   JMSG_DECODE_Submit_t Submit;
+   uint16  CapLen;
+   
+   
+   JMsgTrans->RxCtx.RxMsgId = 0;
+   CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_DEBUG,
+                     "JMSG_TRANS_ProcessJMsg: Received JMSG %.*s", MsgLen, MsgData);
+                    
+   Colon = memchr(MsgData, ':', MsgLen);
+                    
+   if (Colon == NULL)
+   {
+      CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR,
+                        "Null JSON message data length for %.*s", 
+                        (MsgLen < JMSG_PLATFORM_TOPIC_NAME_MAX_LEN ? MsgLen : JMSG_PLATFORM_TOPIC_NAME_MAX_LEN), MsgData);
+   }
+   else if (!JMSG_HDR_Parse(&HdrAttr, MsgData, (MsgHdrLen = Colon - MsgData)))
+   {
+      CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR,
+                        "Invalid message header attribute in %.*s", MsgHdrLen, MsgData);               
+   }
+   else if ((MsgTopicNameLen = HdrAttr.TopicLen) >= JMSG_PLATFORM_TOPIC_NAME_MAX_LEN)
+   {
+      CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR,
+                        "Message topic name length %d exceeds maximum length %d", 
+                        MsgTopicNameLen, JMSG_PLATFORM_TOPIC_NAME_MAX_LEN);               
+   }
+   else if (HdrAttr.FragValid && Reassembled)
+   {
+      CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_ERROR,
+                        "Reassembled message %.*s is a fragment", MsgHdrLen, MsgData);               
+   }
+   else if (HdrAttr.FragValid)
+   {
+      return ProcessFrag(RxInfo, &HdrAttr, Colon + 1, MsgLen - MsgHdrLen - 1);
+   }
+   else if (HdrAttr.AckValid)
+   {
+      JMSG_REL_RecvAck(MsgData, MsgTopicNameLen, HdrAttr.Ack);
+      return true;
+   }
+   else if (HdrAttr.SeqValid && IsDuplicate(RxInfo, MsgData, &HdrAttr))
+   {
+      CFE_EVS_SendEvent(JMSG_TRANS_PROCESS_JMSG_EID, CFE_EVS_EventType_DEBUG,
+                        "JMSG_TRANS_ProcessJMsg: Dropped duplicate topic %.*s sequence %u", 
+                        MsgTopicNameLen, MsgData, (unsigned int)HdrAttr.Seq);
+      JMsgTrans->DupJMsgCnt++;
+      return false;
+   }
+   else
+   {
+      if (HdrAttr.TestValid && !JMSG_SELFTEST_IsTestMsg(RxInfo, HdrAttr.Test))
+      {
+         HdrAttr.TestValid = false;
+      }
+      
+      MsgPayload    = Colon + 1;
+      MsgPayloadLen = MsgLen - MsgHdrLen - 1;
+      
+      if (HdrAttr.ZipValid)
+      {
+         /* Decompression sends its own error events */
+         MsgPayload    = JMSG_LZ_Decompress(MsgPayload, MsgPayloadLen, HdrAttr.ZipLen);
+         MsgPayloadLen = (uint16)HdrAttr.ZipLen;
+      }
+      
+      if (MsgPayload != NULL)
+      {
+         CapLen = JMSG_CAP_IsActive() ? JMsgTrans->RxDatagramLen : 0;
+         Submit = JMSG_DECODE_Submit(RxInfo, &HdrAttr, MsgData, MsgPayload, MsgPayloadLen,
+                                     JMsgTrans->RxDatagram, CapLen);
+         if (Submit == JMSG_DECODE_INLINE)
+         {
+            return JMSG_TRANS_DecodeJMsg(&JMsgTrans->RxCtx, RxInfo, &HdrAttr, MsgData, MsgPayload, MsgPayloadLen);
+         }
+         JMsgTrans->RxCapQueued = (Submit == JMSG_DECODE_QUEUED && CapLen > 0);
+         return (Submit == JMSG_DECODE_QUEUED);
+      }
+      
+      if (HdrAttr.TestValid)
+      {
+         JMSG_SELFTEST_RecvRxMsg(HdrAttr.Test, false);
+      }
+   
+   } /* End if valid topic */
+
+   JMsgTrans->RxCtx.InvalidJMsgCnt++;
+   
+   return false;
+
+} /* End ProcessMsg() */
+
@@ -32,6 +32,11 @@
 */
 
 #include "app_cfg.h"
+#include "jmsg_hdr.h"
+#include "jmsg_route_tbl.h"
+#include "jmsg_scan.h"
+#include "jmsg_seq.h"
+#include "jmsg_shape.h"
 
 
 /***********************/
@@ -46,29 +51,40 @@
 // TODO: Decide if need separate debug message EIDs that can be filtered
 #define JMSG_TRANS_PROCESS_JMSG_EID       (JMSG_TRANS_BASE_EID + 0)
 #define JMSG_TRANS_PROCESS_SB_MSG_EID     (JMSG_TRANS_BASE_EID + 1)
+#define JMSG_TRANS_INVALID_JSON_EID       (JMSG_TRANS_BASE_EID + 2)
+
+/* SB message built from an Rx route template, either header type */
+#define JMSG_TRANS_RX_TMPL_MSG_LEN  (sizeof(CFE_MSG_CommandHeader_t) + sizeof(CFE_MSG_TelemetryHeader_t) + \
+                                     JMSG_UDP_PLATFORM_TMPL_PAYLOAD_MAX)
 
 /**********************/
 /** Type Definitions **/
 /**********************/
 
 /*
-** JSON Message
+** JSON decoder context. The Rx task and each decode worker own one and
+** only the owning task accesses it.
 */
 
 typedef struct
 {
-   
-   char   Data[JMSG_UDP_BUF_LEN];
 
-}  JMSG_Payload_t;
+   uint32  ValidJMsgCnt;
+   uint32  InvalidJMsgCnt;
+   uint32  RxMsgId;          /* SB message ID sent for the last JMSG decoded, zero if none */
+   bool    StagePerfLog;     /* Log the stage performance markers, only set for the Rx task */
 
-typedef struct
-{
-   
-   CFE_MSG_TelemetryHeader_t TelemetryHeader;
-   JMSG_Payload_t            Payload;
+   /*
+   ** Structural index of the most recent JSON payload and the SB message
+   ** built from an Rx route template
+   */
+
+   JMSG_SCAN_Index_t  ScanIndex;
+   uint64             RxTmplMsg[(JMSG_TRANS_RX_TMPL_MSG_LEN + sizeof(uint64) - 1) / sizeof(uint64)];
+
+   JMSG_SHAPE_Class_t  Shape;
 
-}  JMSG_Pkt_t;
+} JMSG_TRANS_RxCtx_t;
 
 
 /*
@@ -78,21 +94,59 @@ typedef struct
 typedef struct 
 {
 
-   uint32  ValidJMsgCnt;
-   uint32  InvalidJMsgCnt;
+   uint16  JsonMaxDepth;
+   
+   /*
+   ** Performance log IDs of the translation stages
+   */
+   
+   uint32  LookupPerfId;     /* Rx topic route lookup */
+   uint32  JsonToSbPerfId;   /* Rx payload scan and conversion */
+   uint32  SbSendPerfId;     /* Rx SB message transmit */
+   uint32  SbToJsonPerfId;   /* Tx SB message conversion */
+   
    uint32  ValidSbMsgCnt;
    uint32  InvalidSbMsgCnt;
+   uint32  TmplSbMsgCnt;     /* SB messages formatted with a route template */
+   uint32  FilterSbMsgCnt;   /* SB messages dropped by a route filter */
+   uint32  DupJMsgCnt;
+   
+   /*
+   ** Topic plugin converters return a message in a plugin buffer and may
+   ** share state with other plugins so all plugin conversions by different
+   ** tasks are serialized by one lock. ConvMutex is only created when
+   ** decode workers run.
+   */
+   
+   bool       ConvLockCreated;
+   osal_id_t  ConvMutex;
    
    /*
-   ** Telemetry Messages
+   ** Route of the SB message being translated. Only accessed by the Tx 
+   ** task and holds the topic name returned by JMSG_TRANS_ProcessSbMsg().
+   ** Filter previous values are indexed by the route's filter index and
+   ** identify their filter so a table reload doesn't mix them up.
    */
    
-   JMSG_Pkt_t  JMsgPkt;
+   JMSG_ROUTE_TBL_Route_t  TxRoute;
+   JMSG_FILTER_Prev_t      TxFilterPrev[JMSG_UDP_PLATFORM_FILTER_MAX];
+   
+   /*
+   ** Rx datagram being translated. Only accessed by the Rx task so the
+   ** datagram can be queued with its payload and captured by a decode
+   ** worker.
+   */
+   
+   const char *RxDatagram;
+   uint16      RxDatagramLen;
+   bool        RxCapQueued;   /* A decode worker captures the datagram */
    
    /*
    ** Contained Objects
    */
 
+   JMSG_SEQ_Class_t    Seq;
+   JMSG_TRANS_RxCtx_t  RxCtx;     /* Rx task decoder context */
 
 } JMSG_TRANS_Class_t;
 
@@ -108,28 +162,85 @@ typedef struct
 ** Notes:
 **    1. This function must be called prior to any other functions
 */
-void JMSG_TRANS_Constructor(JMSG_TRANS_Class_t *JMsgTransPtr);
+void JMSG_TRANS_Constructor(JMSG_TRANS_Class_t *JMsgTransPtr, const INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: JMSG_TRANS_CreateConvLock
+**
+** Create the plugin converter lock needed when more than one task decodes
+** JSON payloads.
+**
+** Notes:
+**   1. Must be called before a second decoding task starts.
+**
+*/
+void JMSG_TRANS_CreateConvLock(void);
+
+
+/******************************************************************************
+** Function: JMSG_TRANS_DecodeJMsg
+**
+** Route a JMSG payload, convert it to a SB message and send the message.
+**
+** Notes:
+**   1. Topic is the message's header text. Only HdrAttr->TopicLen bytes
+**      are read.
+**   2. RxCtx is the calling task's decoder context.
+**   3. Returns true if the topic has a route and the payload is valid JSON.
+**
+*/
+bool JMSG_TRANS_DecodeJMsg(JMSG_TRANS_RxCtx_t *RxCtx, const JMSG_SOCK_RxInfo_t *RxInfo,
+                           const JMSG_HDR_Attr_t *HdrAttr, const char *Topic,
+                           const char *Payload, uint16 PayloadLen);
+
+
+/******************************************************************************
+** Function: JMSG_TRANS_InitRxCtx
+**
+** Initialize a decoder context.
+**
+*/
+void JMSG_TRANS_InitRxCtx(JMSG_TRANS_RxCtx_t *RxCtx);
 
 
 /******************************************************************************
 ** Function: JMSG_TRANS_ProcessJMsg
 **
+** Translate a "header:payload" JSON message into a SB message.
+**
 ** Notes:
-**   1. Assumes caller has ensured a null terminated string
+**   1. MsgData does not need to be null terminated, only MsgLen bytes are
+**      read.
+**   2. Telemetry messages are time stamped with the message's arrival 
+**      time rather than the time translation completes.
+**   3. Duplicate sequence numbers are dropped before the payload is parsed
+**      and are not counted as invalid.
+**   4. A route with a JSON template builds the SB message from the template
+**      instead of calling the topic plugin's converter.
+**   5. The header is processed by the calling task. The payload is decoded
+**      by the calling task or queued to a decode worker, see jmsg_decode.h.
+**      A queued message returns true before it's decoded.
+**   6. The datagram is captured with the SB message ID it was translated
+**      to, by the decode worker if its payload is queued.
 **
 */
-bool JMSG_TRANS_ProcessJMsg(const char *MsgData);
+bool JMSG_TRANS_ProcessJMsg(const char *MsgData, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *RxInfo);
 
 
 /******************************************************************************
 ** Function: JMSG_TRANS_ProcessSbMsg
 **
+** Translate a SB message into a JSON payload.
+**
 ** Notes:
-**   None
+**   1. The payload is written to JsonBuf, null terminated, and its length
+**      is returned in PayloadLen. Returns false if the message isn't
+**      translated or its payload doesn't fit in JsonBufLen characters.
 **
 */
-bool JMSG_TRANS_ProcessSbMsg(const CFE_MSG_Message_t *CfeMsgPtr,
-                             const char **Topic, const char **Payload);
+bool JMSG_TRANS_ProcessSbMsg(const CFE_MSG_Message_t *CfeMsgPtr, char *JsonBuf, uint32 JsonBufLen,
+                             const char **Topic, uint32 *PayloadLen);
 
 
 /******************************************************************************
@@ -140,4 +251,13 @@ bool JMSG_TRANS_ProcessSbMsg(const CFE_MSG_Message_t *CfeMsgPtr,
 */
 void JMSG_TRANS_ResetStatus(void);
 
+
+/******************************************************************************
+** Function: JMSG_TRANS_ResetRxCtx
+**
+** Reset a decoder context's counters without forgetting its cached shapes.
+**
+*/
+void JMSG_TRANS_ResetRxCtx(JMSG_TRANS_RxCtx_t *RxCtx);
+
 #endif /* _msg_trans_ */
@@ -24,6 +24,11 @@
 ** Includes
 */
 
+#include <stdio.h>
+#include <string.h>
+
+#include "jmsg_hdr.h"
+#include "jmsg_rel.h"
 #include "jmsg_udp.h"
 
 /***********************/
@@ -44,6 +49,21 @@
 
 static bool ConfigSubscription(const JMSG_TOPIC_TBL_Topic_t *Topic, 
                                JMSG_TOPIC_TBL_SubscriptionOptEnum_t ConfigOpt);
+static bool ConfigTxMsg(const JMSG_ROUTE_TBL_TxSub_t *TxSub, bool Subscribe);
+static int32 OpenRxSocket(JMSG_SOCK_Class_t *Sock, const JMSG_SOCK_Class_t *Current,
+                          uint16 Port, bool KernelTime);
+static void ProcessRxMsg(int32 MsgLen, const JMSG_SOCK_RxInfo_t *RxInfo);
+static void ProcessTxMsg(CFE_SB_Buffer_t *SbBufPtr);
+static int32 RecvRxMsg(JMSG_SOCK_Class_t *Sock, int32 Timeout, JMSG_SOCK_RxInfo_t *RxInfo);
+static int32 RecvTxMsg(CFE_SB_Buffer_t **SbBufPtr, CFE_SB_PipeId_t Pipe, int32 Timeout);
+static uint32 CompressTxMsg(const char *Topic, char *Payload, uint32 PayloadLen, char *Attr, size_t AttrSize);
+static uint16 GetIoUringDepth(void);
+static bool IsJsonWs(char Char);
+static char *PutTxHdr(const char *Topic, const char *Attr, char *Payload);
+static void SendSelfTestMsgs(void);
+static bool SendTxMsg(const char *Msg, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *Peer);
+static bool SetTxAddr(OS_SockAddr_t *SocketAddr, const char *Addr, uint16 Port);
+static int32 SubscribeTxMsg(const JMSG_ROUTE_TBL_TxSub_t *TxSub, CFE_SB_PipeId_t Pipe);
 
 
 /*****************/
@@ -72,39 +92,54 @@ void JMSG_UDP_Constructor(JMSG_UDP_Class_t *JMsgUdpPtr, const INITBL_Class_t *In
    
    JMsgUdp->IniTbl = IniTbl;
 
-   /* Construct contained objects */
+   /* Construct contained objects, the arena users in allocation order */
+   
+   JMSG_MEM_Constructor(&JMsgUdp->Mem, IniTbl);
    
-   JMSG_TRANS_Constructor(&JMsgUdp->JMsgTrans);
+   JMsgUdp->Rx.BufferLen = JMSG_MEM_GetDatagramLen();
+   JMsgUdp->Rx.Buffer    = JMSG_MEM_Alloc(JMSG_MEM_USER_RX, JMsgUdp->Rx.BufferLen + 1);
+   JMsgUdp->Tx.BufferLen = JMSG_MEM_GetMsgMaxLen() + 1;
+   JMsgUdp->Tx.Buffer    = JMSG_MEM_Alloc(JMSG_MEM_USER_TX, JMSG_UDP_TX_HDR_RESERVE + JMsgUdp->Tx.BufferLen);
+   JMSG_RATE_Constructor(&JMsgUdp->Rx.Rate);
+   JMSG_RATE_Constructor(&JMsgUdp->Tx.Rate);
+   
+   JMSG_ROUTE_TBL_Constructor(&JMsgUdp->RouteTbl, ConfigTxMsg);
+   JMSG_TRANS_Constructor(&JMsgUdp->JMsgTrans, IniTbl);
+   JMSG_FRAG_Constructor(&JMsgUdp->Frag, IniTbl, SendTxMsg);
+   JMSG_REL_Constructor(&JMsgUdp->Rel, IniTbl, SendTxMsg);
+   JMSG_LZ_Constructor(&JMsgUdp->Lz, IniTbl);
+   JMSG_CAP_Constructor(&JMsgUdp->Cap, IniTbl);
+   JMSG_LVC_Constructor(&JMsgUdp->Lvc, IniTbl, SendTxMsg);
+   JMSG_LOCAL_Constructor(&JMsgUdp->Local, IniTbl);
+   JMSG_SBQ_Constructor(&JMsgUdp->Sbq);
+   JMSG_SELFTEST_Constructor(&JMsgUdp->SelfTest, SendTxMsg);
+   JMSG_DECODE_Constructor(&JMsgUdp->Decode, IniTbl);
  
+   OS_MutSemCreate(&JMsgUdp->ReconfigMutex, "JMSG_UDP_RECONFIG", 0);
+
+   JMsgUdp->Config.RxPort = INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_UDP_PORT);
+   JMsgUdp->Config.TxPort = INITBL_GetIntConfig(INITBL_OBJ, CFG_TX_UDP_PORT);
+   strncpy(JMsgUdp->Config.TxAddr, INITBL_GetStrConfig(INITBL_OBJ, CFG_TX_UDP_ADDR), JMSG_UDP_IP_ADDR_STR_LEN - 1);
+   JMsgUdp->Config.JMsgPipeDepth = INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_PIPE_DEPTH);
+   JMsgUdp->Config.JMsgPipeMsgLim = INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_PIPE_MSG_LIM);
+   JMsgUdp->Config.RxKernelTime  = (INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_KERNEL_TIME) != 0);
+   JMsgUdp->Config.IoUringDepth  = GetIoUringDepth();
+   strncpy(JMsgUdp->Config.TxTimeField, INITBL_GetStrConfig(INITBL_OBJ, CFG_TX_TIME_FIELD), JMSG_UDP_TX_TIME_FIELD_LEN - 1);
+   strncpy(JMsgUdp->Config.LocalRxPath, INITBL_GetStrConfig(INITBL_OBJ, CFG_LOCAL_RX_PATH), JMSG_SOCK_LOCAL_PATH_LEN - 1);
+   
+   JMsgUdp->Rx.PerfId      = INITBL_GetIntConfig(INITBL_OBJ, CFG_SOCK_RECV_PERF_ID);
+   JMsgUdp->Tx.PerfId      = INITBL_GetIntConfig(INITBL_OBJ, CFG_SOCK_SEND_PERF_ID);
+   JMsgUdp->JMsgPipePerfId = INITBL_GetIntConfig(INITBL_OBJ, CFG_SB_RECV_PERF_ID);
+   JMsgUdp->Rx.ProcTimeLim = INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_PROC_TIME_LIM_US);
+   
    /* Create Rx socket */
 
-   Status = OS_SocketOpen(&JMsgUdp->Rx.SocketId, OS_SocketDomain_INET, OS_SocketType_DATAGRAM);
+   Status = OpenRxSocket(&JMsgUdp->Rx.Sock, NULL, JMsgUdp->Config.RxPort, JMsgUdp->Config.RxKernelTime);
    if (Status == OS_SUCCESS)
    {
-
-      uint32 RxPort = INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_UDP_PORT);
-      OS_SocketAddrInit(&JMsgUdp->Rx.SocketAddr, OS_SocketDomain_INET);
-      OS_SocketAddrSetPort(&JMsgUdp->Rx.SocketAddr, RxPort);
-
-      Status = OS_SocketBind(JMsgUdp->Rx.SocketId, &JMsgUdp->Rx.SocketAddr);
-
-      if (Status == OS_SUCCESS)
-      {
-         JMsgUdp->Rx.Connected = true;
-         CFE_EVS_SendEvent(JMSG_UDP_CONSTRUCTOR_EID, CFE_EVS_EventType_DEBUG, 
-                           "JMSG UDP Gateway listening on UDP port %u", (unsigned int)RxPort);
-      }
-      else
-      {
-         CFE_EVS_SendEvent(JMSG_UDP_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR, 
-                           "Error binding JMSG UDP Gateway Rx socket, status = %d", (int)Status);
-      }
-        
-   } /* Socket opened */
-   else
-   {
-      CFE_EVS_SendEvent(JMSG_UDP_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR, 
-                        "Error creating JMSG UDP Gateway Rx socket, status = %d", (int)Status);
+      JMsgUdp->Rx.Connected = true;
+      CFE_EVS_SendEvent(JMSG_UDP_CONSTRUCTOR_EID, CFE_EVS_EventType_DEBUG, 
+                        "JMSG UDP Gateway listening on UDP port %u", (unsigned int)JMsgUdp->Config.RxPort);
    }
 
    /* Create Tx socket */
@@ -112,14 +147,23 @@ void JMSG_UDP_Constructor(JMSG_UDP_Class_t *JMsgUdpPtr, const INITBL_Class_t *In
    Status = OS_SocketOpen(&JMsgUdp->Tx.SocketId, OS_SocketDomain_INET, OS_SocketType_DATAGRAM);
    if (Status == OS_SUCCESS)
    {
-      uint32 TxPort = INITBL_GetIntConfig(INITBL_OBJ, CFG_TX_UDP_PORT);
-      OS_SocketAddrInit(&JMsgUdp->Tx.SocketAddr, OS_SocketDomain_INET);
-      OS_SocketAddrFromString(&JMsgUdp->Tx.SocketAddr,INITBL_GetStrConfig(INITBL_OBJ, CFG_TX_UDP_ADDR));
-      OS_SocketAddrSetPort(&JMsgUdp->Tx.SocketAddr,TxPort);
-
-      JMsgUdp->Tx.Connected = true;
+      
+      JMsgUdp->Tx.Connected = SetTxAddr(&JMsgUdp->Tx.SocketAddr, JMsgUdp->Config.TxAddr, JMsgUdp->Config.TxPort);
+      JMSG_SOCK_GetPeer(&JMsgUdp->Tx.SocketAddr, &JMsgUdp->Tx.Peer);
+      JMSG_CAP_SetTxPeer(&JMsgUdp->Tx.SocketAddr);
+      JMSG_LVC_SetTxPeer(&JMsgUdp->Tx.Peer);
       CFE_EVS_SendEvent(JMSG_UDP_CONSTRUCTOR_EID, CFE_EVS_EventType_INFORMATION, 
-                           "Initialized UDP Tx port %u", (unsigned int)TxPort);
+                        "Initialized UDP Tx port %u", (unsigned int)JMsgUdp->Config.TxPort);
+      
+      if (JMsgUdp->Config.IoUringDepth > 0)
+      {
+         JMsgUdp->Tx.Uring = JMSG_URING_OpenTx(JMsgUdp->Config.IoUringDepth, JMSG_MEM_GetDatagramLen());
+         if (JMsgUdp->Tx.Uring == NULL)
+         {
+            CFE_EVS_SendEvent(JMSG_UDP_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR, 
+                              "io_uring isn't supported, Tx messages are sent with the OSAL socket");
+         }
+      }
 
    } /* Socket opened */
    else
@@ -128,11 +172,242 @@ void JMSG_UDP_Constructor(JMSG_UDP_Class_t *JMsgUdpPtr, const INITBL_Class_t *In
                         "Error creating JMSG UDP Gateway Tx socket, status = %d", (int)Status);
    }
 
-   CFE_SB_CreatePipe(&JMsgUdp->JMsgPipe, INITBL_GetIntConfig(IniTbl, CFG_JMSG_PIPE_DEPTH), INITBL_GetStrConfig(IniTbl, CFG_JMSG_PIPE_NAME));  
+   CFE_SB_CreatePipe(&JMsgUdp->JMsgPipe, JMsgUdp->Config.JMsgPipeDepth, INITBL_GetStrConfig(IniTbl, CFG_JMSG_PIPE_NAME));  
 
 } /* End JMSG_UDP_Constructor() */
 
 
+/******************************************************************************
+** Function: JMSG_UDP_GetMemReport
+**
+*/
+void JMSG_UDP_GetMemReport(JMSG_UDP_MemReport_t *Report)
+{
+
+   const JMSG_MEM_Class_t *Mem = &JMsgUdp->Mem;
+   
+   memset(Report, 0, sizeof(JMSG_UDP_MemReport_t));
+   
+   Report->RouteTbl  = sizeof(JMSG_ROUTE_TBL_Class_t);
+   Report->Trans     = sizeof(JMSG_TRANS_Class_t);
+   Report->Rel       = sizeof(JMSG_REL_Class_t)  + Mem->UserLen[JMSG_MEM_USER_REL];
+   Report->Frag      = sizeof(JMSG_FRAG_Class_t) + Mem->UserLen[JMSG_MEM_USER_FRAG];
+   Report->Lz        = sizeof(JMSG_LZ_Class_t)   + Mem->UserLen[JMSG_MEM_USER_LZ];
+   Report->Lvc       = sizeof(JMSG_LVC_Class_t)  + Mem->UserLen[JMSG_MEM_USER_LVC];
+   Report->SelfTest  = sizeof(JMSG_SELFTEST_Class_t);
+   Report->Decode    = sizeof(JMSG_DECODE_Class_t) + Mem->UserLen[JMSG_MEM_USER_DECODE];
+   Report->RxBuf     = Mem->UserLen[JMSG_MEM_USER_RX];
+   Report->TxBuf     = Mem->UserLen[JMSG_MEM_USER_TX];
+   Report->ArenaUsed = Mem->Used;
+   Report->ArenaLen  = sizeof(Mem->Arena);
+
+} /* End JMSG_UDP_GetMemReport() */
+
+
+/******************************************************************************
+** Function: JMSG_UDP_ReconfigCmd
+**
+** Notes:
+**   1. Changes are prepared in the order route table, Rx socket, Tx address
+**      and JMSG pipe. A failure releases what was prepared and nothing is
+**      applied.
+**   2. A new pipe is subscribed to the Tx routes that will be active while
+**      preparing, a failed subscription deletes the new pipe. The routes
+**      active before the reconfiguration are unsubscribed from the old pipe
+**      after they're subscribed to the new one so no messages are dropped.
+**      A message published between the two calls may be sent twice. New
+**      routes are then activated without changing subscriptions so the old
+**      pipe isn't subscribed to them.
+**   3. A reconfiguration is rejected until the child tasks have released
+**      the socket and pipe replaced by the previous one.
+**   4. A new Rx socket keeps the current local Rx socket when its path is
+**      unchanged so only the UDP socket is replaced. Otherwise the local
+**      socket is bound to a temporary name while preparing and renamed to
+**      its path when applied so a rejected reconfiguration leaves the
+**      current socket's path alone.
+**
+*/
+bool JMSG_UDP_ReconfigCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   const JMSG_UDP_Reconfig_CmdPayload_t *Cmd = CMDMGR_PAYLOAD_PTR(MsgPtr, JMSG_UDP_Reconfig_t);
+   static JMSG_ROUTE_TBL_TxSub_t TxSub[JMSG_ROUTE_TBL_BANK_MAX];
+   JMSG_UDP_Config_t NewConfig = JMsgUdp->Config;
+   bool           RetStatus = true;
+   bool           NewRoutes = false;
+   bool           NewRxSocket = false;
+   bool           NewTxAddr = false;
+   bool           NewPipe = false;
+   JMSG_SOCK_Class_t RxSock;
+   OS_SockAddr_t  TxSocketAddr;
+   JMSG_SOCK_RxInfo_t TxPeer;
+   CFE_SB_PipeId_t JMsgPipe;
+   uint16         TxSubCnt;
+   uint16         i;
+   int32          Status;
+   
+   if (JMsgUdp->Rx.OldSockPending || JMsgUdp->OldJMsgPipePending)
+   {
+      CFE_EVS_SendEvent(JMSG_UDP_RECONFIG_EID, CFE_EVS_EventType_ERROR, 
+                        "Reconfiguration rejected, the previous reconfiguration is still draining");
+      return false;
+   }
+   
+   if (Cmd->RxPort != 0)
+   {
+      NewConfig.RxPort = Cmd->RxPort;
+   }
+   if (Cmd->TxAddr[0] != '\0')
+   {
+      strncpy(NewConfig.TxAddr, Cmd->TxAddr, JMSG_UDP_IP_ADDR_STR_LEN - 1);
+      NewConfig.TxAddr[JMSG_UDP_IP_ADDR_STR_LEN - 1] = '\0';
+   }
+   if (Cmd->TxPort != 0)
+   {
+      NewConfig.TxPort = Cmd->TxPort;
+   }
+   if (Cmd->JMsgPipeDepth != 0)
+   {
+      NewConfig.JMsgPipeDepth = Cmd->JMsgPipeDepth;
+   }
+   
+   /* Prepare */
+   
+   if (Cmd->RouteTblFile[0] != '\0')
+   {
+      RetStatus = NewRoutes = JMSG_ROUTE_TBL_StageTbl(Cmd->RouteTblFile);
+   }
+
+   if (RetStatus && (NewConfig.RxPort != JMsgUdp->Config.RxPort || !JMsgUdp->Rx.Connected))
+   {
+      Status = OpenRxSocket(&RxSock, &JMsgUdp->Rx.Sock, NewConfig.RxPort, NewConfig.RxKernelTime);
+      RetStatus = NewRxSocket = (Status == OS_SUCCESS);
+   }
+
+   if (RetStatus && (NewConfig.TxPort != JMsgUdp->Config.TxPort ||
+                     strcmp(NewConfig.TxAddr, JMsgUdp->Config.TxAddr) != 0))
+   {
+      RetStatus = NewTxAddr = SetTxAddr(&TxSocketAddr, NewConfig.TxAddr, NewConfig.TxPort);
+      if (NewTxAddr)
+      {
+         JMSG_SOCK_GetPeer(&TxSocketAddr, &TxPeer);
+      }
+   }
+
+   if (RetStatus && NewConfig.JMsgPipeDepth != JMsgUdp->Config.JMsgPipeDepth)
+   {
+      /* The old pipe exists until it's drained so alternate pipe names */
+      NewConfig.JMsgPipeAltName = !JMsgUdp->Config.JMsgPipeAltName;
+      Status = CFE_SB_CreatePipe(&JMsgPipe, NewConfig.JMsgPipeDepth,
+                                 INITBL_GetStrConfig(INITBL_OBJ, NewConfig.JMsgPipeAltName ? CFG_JMSG_PIPE_ALT_NAME : CFG_JMSG_PIPE_NAME));
+      RetStatus = NewPipe = (Status == CFE_SUCCESS);
+      if (RetStatus)
+      {
+         TxSubCnt = JMSG_ROUTE_TBL_GetTxSubs(TxSub, JMSG_ROUTE_TBL_BANK_MAX, NewRoutes);
+         for (i=0; i < TxSubCnt && RetStatus; i++)
+         {
+            Status = SubscribeTxMsg(&TxSub[i], JMsgPipe);
+            if (Status != CFE_SUCCESS)
+            {
+               RetStatus = false;
+               CFE_EVS_SendEvent(JMSG_UDP_RECONFIG_EID, CFE_EVS_EventType_ERROR, 
+                                 "Error subscribing new JMSG pipe to MID 0x%04X, status = 0x%08X", 
+                                 CFE_SB_MsgIdToValue(TxSub[i].MsgId), (unsigned int)Status);
+            }
+         }
+      }
+      else
+      {
+         CFE_EVS_SendEvent(JMSG_UDP_RECONFIG_EID, CFE_EVS_EventType_ERROR, 
+                           "Error creating JMSG pipe with depth %d, status = 0x%08X", 
+                           NewConfig.JMsgPipeDepth, (unsigned int)Status);
+      }
+   }
+   
+   if (!RetStatus)
+   {
+      if (NewPipe)
+      {
+         CFE_SB_DeletePipe(JMsgPipe);
+      }
+      if (NewRxSocket)
+      {
+         JMSG_SOCK_Close(&RxSock);
+      }
+      CFE_EVS_SendEvent(JMSG_UDP_RECONFIG_EID, CFE_EVS_EventType_ERROR, 
+                        "Reconfiguration rejected, current configuration unchanged");
+      return false;
+   }
+   
+   /* Apply */
+   
+   if (NewPipe)
+   {
+      TxSubCnt = JMSG_ROUTE_TBL_GetTxSubs(TxSub, JMSG_ROUTE_TBL_BANK_MAX, false);
+      for (i=0; i < TxSubCnt; i++)
+      {
+         CFE_SB_Unsubscribe(TxSub[i].MsgId, JMsgUdp->JMsgPipe);
+      }
+   }
+   
+   if (NewRoutes)
+   {
+      /* A new pipe is already subscribed to the staged routes */
+      JMSG_ROUTE_TBL_ActivateStaged(!NewPipe);
+   }
+   
+   OS_MutSemTake(JMsgUdp->ReconfigMutex);
+   if (NewRxSocket)
+   {
+      Status = JMSG_SOCK_CommitRx(&RxSock, &JMsgUdp->Rx.Sock);
+      if (JMsgUdp->Rx.Sock.Open)
+      {
+         JMsgUdp->Rx.OldSock        = JMsgUdp->Rx.Sock;
+         JMsgUdp->Rx.OldSockPending = true;
+      }
+      JMsgUdp->Rx.Sock      = RxSock;
+      JMsgUdp->Rx.Connected = true;
+   }
+   if (NewTxAddr)
+   {
+      JMsgUdp->Tx.SocketAddr = TxSocketAddr;
+      JMsgUdp->Tx.Peer       = TxPeer;
+      JMsgUdp->Tx.Connected  = OS_ObjectIdDefined(JMsgUdp->Tx.SocketId);
+   }
+   if (NewPipe)
+   {
+      JMsgUdp->OldJMsgPipe        = JMsgUdp->JMsgPipe;
+      JMsgUdp->OldJMsgPipePending = true;
+      JMsgUdp->JMsgPipe = JMsgPipe;
+      JMSG_SBQ_ResetHighWater();
+   }
+   JMsgUdp->Config = NewConfig;
+   OS_MutSemGive(JMsgUdp->ReconfigMutex);
+
+   if (NewRxSocket && Status != OS_SUCCESS)
+   {
+      CFE_EVS_SendEvent(JMSG_UDP_RECONFIG_EID, CFE_EVS_EventType_ERROR, 
+                        "Error renaming local Rx socket to %s, it's receiving on %s%s",
+                        JMsgUdp->Config.LocalRxPath, JMsgUdp->Config.LocalRxPath, JMSG_SOCK_LOCAL_TMP_EXT);
+   }
+   if (NewTxAddr)
+   {
+      JMSG_CAP_SetTxPeer(&TxSocketAddr);
+      JMSG_LVC_SetTxPeer(&TxPeer);
+   }
+
+   JMsgUdp->ReconfigCnt++;
+   
+   CFE_EVS_SendEvent(JMSG_UDP_RECONFIG_EID, CFE_EVS_EventType_INFORMATION, 
+                     "Reconfigured Rx port %d, Tx %s:%d, JMSG pipe depth %d, %d routes",
+                     NewConfig.RxPort, NewConfig.TxAddr, NewConfig.TxPort, 
+                     NewConfig.JMsgPipeDepth, JMSG_ROUTE_TBL_GetRouteCnt());
+
+   return true;
+   
+} /* End JMSG_UDP_ReconfigCmd() */
+
+
 /******************************************************************************
 ** Function: JMSG_UDP_ResetStatus
 **
@@ -142,10 +417,32 @@ void JMSG_UDP_Constructor(JMSG_UDP_Class_t *JMsgUdpPtr, const INITBL_Class_t *In
 void JMSG_UDP_ResetStatus(void)
 {
 
-   JMsgUdp->Rx.MsgCnt    = 0;
-   JMsgUdp->Rx.MsgErrCnt = 0;
+   JMsgUdp->Rx.MsgCnt      = 0;
+   JMsgUdp->Rx.MsgErrCnt   = 0;
+   JMsgUdp->Rx.MaxProcTime = 0;
+   JMsgUdp->Rx.SlowMsgCnt  = 0;
    JMsgUdp->Tx.MsgCnt    = 0;
    JMsgUdp->Tx.MsgErrCnt = 0;
+   JMSG_RATE_ResetStatus(&JMsgUdp->Rx.Rate);
+   JMSG_RATE_ResetStatus(&JMsgUdp->Tx.Rate);
+   if (JMsgUdp->Tx.Uring != NULL)
+   {
+      JMsgUdp->Tx.Uring->Ring.EnterCnt = 0;
+      JMsgUdp->Tx.Uring->ErrCnt        = 0;
+   }
+   if (JMsgUdp->Rx.Sock.Uring != NULL)
+   {
+      JMsgUdp->Rx.Sock.Uring->Ring.EnterCnt = 0;
+   }
+
+   JMSG_TRANS_ResetStatus();
+   JMSG_REL_ResetStatus();
+   JMSG_FRAG_ResetStatus();
+   JMSG_LZ_ResetStatus();
+   JMSG_LOCAL_ResetStatus();
+   JMSG_SBQ_ResetStatus();
+   JMSG_LVC_ResetStatus();
+   JMSG_DECODE_ResetStatus();
 
 } /* End JMSG_UDP_ResetStatus() */
 
@@ -157,37 +454,195 @@ void JMSG_UDP_ResetStatus(void)
 bool JMSG_UDP_RxChildTask(CHILDMGR_Class_t *ChildMgr)
 {
 
-   int32 Status;
-   
    if (JMsgUdp->Rx.Connected)
    {
+      /* Time out so a reconfigured socket is adopted */
+      JMSG_UDP_ServiceRx(JMSG_UDP_RECONFIG_POLL_MS, 1);
+   }
+   else
+   {
+      OS_TaskDelay(JMSG_UDP_RECONFIG_POLL_MS);
+   }
+      
+   return true;
+   
+} /* End JMSG_UDP_RxChildTask() */
+
+
+/******************************************************************************
+** Function: JMSG_UDP_SelfTestCmd
+**
+*/
+bool JMSG_UDP_SelfTestCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   const JMSG_UDP_SelfTest_CmdPayload_t *Cmd = CMDMGR_PAYLOAD_PTR(MsgPtr, JMSG_UDP_SelfTest_t);
+   uint16 RxPort;
+   
+   OS_MutSemTake(JMsgUdp->ReconfigMutex);
+   RxPort = JMsgUdp->Config.RxPort;
+   OS_MutSemGive(JMsgUdp->ReconfigMutex);
+   
+   return JMSG_SELFTEST_Start(Cmd->MsgId, Cmd->MsgCnt, Cmd->PayloadLen, RxPort);
+
+} /* End JMSG_UDP_SelfTestCmd() */
+
+
+/******************************************************************************
+** Function: JMSG_UDP_ServiceRx
+**
+*/
+uint16 JMSG_UDP_ServiceRx(int32 Timeout, uint16 MsgLim)
+{
 
-      Status = OS_SocketRecvFrom(JMsgUdp->Rx.SocketId, JMsgUdp->Rx.Buffer,
-                                 sizeof(JMsgUdp->Rx.Buffer), &JMsgUdp->Rx.SocketAddr, OS_PEND);
-              
-      if (Status >= 0)
+   int32      Status;
+   uint16     MsgCnt = 0;
+   bool       OldSockPending;
+   JMSG_SOCK_Class_t  Sock;
+   JMSG_SOCK_Class_t  OldSock;
+   JMSG_SOCK_RxInfo_t RxInfo;
+   
+   OS_MutSemTake(JMsgUdp->ReconfigMutex);
+   Sock           = JMsgUdp->Rx.Sock;
+   OldSock        = JMsgUdp->Rx.OldSock;
+   OldSockPending = JMsgUdp->Rx.OldSockPending;
+   OS_MutSemGive(JMsgUdp->ReconfigMutex);
+   
+   if (OldSockPending)
+   {
+      while ((Status = RecvRxMsg(&OldSock, OS_CHECK, &RxInfo)) >= 0)
       {
-         JMsgUdp->Rx.MsgCnt++;
-         CFE_EVS_SendEvent(JMSG_UDP_RX_CHILD_TASK_EID, CFE_EVS_EventType_INFORMATION, 
-                           "JMSG UDP Gateway Rx received message: %s", JMsgUdp->Rx.Buffer);
-         JMSG_TRANS_ProcessJMsg(JMsgUdp->Rx.Buffer);
+         ProcessRxMsg(Status, &RxInfo);
       }
-      else
+      JMSG_SOCK_Close(&OldSock);
+      OS_MutSemTake(JMsgUdp->ReconfigMutex);
+      JMsgUdp->Rx.OldSockPending = false;
+      OS_MutSemGive(JMsgUdp->ReconfigMutex);
+   }
+   
+   if (JMsgUdp->Rx.Connected)
+   {
+
+      /* Only the first receive waits */
+      while (MsgCnt < MsgLim)
       {
-         JMsgUdp->Rx.MsgErrCnt++;
-         CFE_EVS_SendEvent(JMSG_UDP_RX_CHILD_TASK_EID, CFE_EVS_EventType_ERROR, 
-                           "JMSG UDP Gateway Rx socket receive error, Status = %u", (unsigned int)Status);
+         Status = RecvRxMsg(&Sock, (MsgCnt == 0 ? Timeout : OS_CHECK), &RxInfo);
+         if (Status >= 0)
+         {
+            ProcessRxMsg(Status, &RxInfo);
+            MsgCnt++;
+         }
+         else
+         {
+            if (Status != OS_ERROR_TIMEOUT)
+            {
+               JMsgUdp->Rx.MsgErrCnt++;
+               CFE_EVS_SendEvent(JMSG_UDP_RX_CHILD_TASK_EID, CFE_EVS_EventType_ERROR, 
+                                 "JMSG UDP Gateway Rx socket receive error, Status = %u", (unsigned int)Status);
+            }
+            break;
+         }
       }
       
+      /* Keep the local/UDP alternation unless the socket was replaced */
+      OS_MutSemTake(JMsgUdp->ReconfigMutex);
+      if (JMsgUdp->Rx.Sock.Fd == Sock.Fd && JMsgUdp->Rx.Sock.LocalFd == Sock.LocalFd)
+      {
+         JMsgUdp->Rx.Sock.LocalFirst = Sock.LocalFirst;
+      }
+      OS_MutSemGive(JMsgUdp->ReconfigMutex);
+
    } /* End if connected */
-   else
+      
+   return MsgCnt;
+   
+} /* End JMSG_UDP_ServiceRx() */
+
+
+/******************************************************************************
+** Function: JMSG_UDP_ServiceTx
+**
+*/
+uint16 JMSG_UDP_ServiceTx(int32 Timeout, uint16 MsgLim)
+{
+
+   int32  Status;
+   int32  RelTimeout;
+   uint16 MsgCnt = 0;
+   CFE_SB_Buffer_t  *SbBufPtr;
+   CFE_SB_PipeId_t  JMsgPipe;
+   CFE_SB_PipeId_t  OldJMsgPipe;
+   bool             OldJMsgPipePending;
+      
+   OS_MutSemTake(JMsgUdp->ReconfigMutex);
+   JMsgPipe           = JMsgUdp->JMsgPipe;
+   OldJMsgPipe        = JMsgUdp->OldJMsgPipe;
+   OldJMsgPipePending = JMsgUdp->OldJMsgPipePending;
+   OS_MutSemGive(JMsgUdp->ReconfigMutex);
+      
+   if (OldJMsgPipePending)
    {
-      OS_TaskDelay(2000);
+      while (RecvTxMsg(&SbBufPtr, OldJMsgPipe, CFE_SB_POLL) == CFE_SUCCESS)
+      {
+         ProcessTxMsg(SbBufPtr);
+      }
+      Status = CFE_SB_DeletePipe(OldJMsgPipe);
+      if (Status != CFE_SUCCESS)
+      {
+         CFE_EVS_SendEvent(JMSG_UDP_TX_CHILD_TASK_EID, CFE_EVS_EventType_ERROR, 
+                           "Error deleting replaced JMSG pipe, status = 0x%08X", (unsigned int)Status);
+      }
+      OS_MutSemTake(JMsgUdp->ReconfigMutex);
+      JMsgUdp->OldJMsgPipePending = false;
+      OS_MutSemGive(JMsgUdp->ReconfigMutex);
+   }
+
+   /* Wake for the next retransmission */
+   RelTimeout = JMSG_REL_ServiceTx();
+   if (RelTimeout != OS_PEND && (Timeout == CFE_SB_PEND_FOREVER || RelTimeout < Timeout))
+   {
+      Timeout = RelTimeout;
    }
-      
-   return true;
    
-} /* End JMSG_UDP_RxChildTask() */
+   if (JMSG_SELFTEST_TxPending())
+   {
+      Timeout = CFE_SB_POLL;
+   }
+
+   /* The first service call claims the send ring, queued sends go out before waiting */
+   if (JMsgUdp->Tx.Uring != NULL)
+   {
+      if (!OS_ObjectIdDefined(JMsgUdp->Tx.UringTaskId))
+      {
+         JMsgUdp->Tx.UringTaskId = OS_TaskGetId();
+      }
+      JMSG_URING_Flush(JMsgUdp->Tx.Uring);
+   }
+
+   /* Only the first receive waits */
+   while (MsgCnt < MsgLim)
+   {
+      Status = RecvTxMsg(&SbBufPtr, JMsgPipe, (MsgCnt == 0 ? Timeout : CFE_SB_POLL));
+      if (Status != CFE_SUCCESS)
+      {
+         break;
+      }
+      ProcessTxMsg(SbBufPtr);
+      MsgCnt++;
+   }
+   
+   SendSelfTestMsgs();
+   
+   if (JMsgUdp->Tx.Uring != NULL)
+   {
+      JMSG_URING_Flush(JMsgUdp->Tx.Uring);
+   }
+   
+   JMSG_SBQ_EndPass(MsgCnt);
+   
+   return MsgCnt;
+   
+} /* End JMSG_UDP_ServiceTx() */
 
 
 /******************************************************************************
@@ -245,29 +700,22 @@ bool JMSG_UDP_TxChildTask(CHILDMGR_Class_t *ChildMgr)
 {
 
    int32  RetStatus = true;
-   int32  Status;
-   CFE_SB_Buffer_t  *SbBufPtr;
-   const char *Topic;
-   const char *Payload;
+   uint16 MsgLim;
    
    while (true)
    {
-      memset(JMsgUdp->Tx.Buffer, 0, JMSG_UDP_BUF_LEN);
-      Status = CFE_SB_ReceiveBuffer(&SbBufPtr, JMsgUdp->JMsgPipe, CFE_SB_PEND_FOREVER);
-
-      if (Status == CFE_SUCCESS)
+      /* Drain the pipe so each call measures its queued messages */
+      OS_MutSemTake(JMsgUdp->ReconfigMutex);
+      MsgLim = JMsgUdp->Config.JMsgPipeDepth;
+      OS_MutSemGive(JMsgUdp->ReconfigMutex);
+      if (JMsgUdp->Tx.Uring != NULL && JMsgUdp->Config.IoUringDepth > MsgLim)
       {
-         if (JMSG_TRANS_ProcessSbMsg(&SbBufPtr->Msg, &Topic, &Payload))
-         {
-            //TODO: Create buffer & compute message size
-            strcpy(JMsgUdp->Tx.Buffer,Topic);
-            strcat(JMsgUdp->Tx.Buffer,":");
-            strcat(JMsgUdp->Tx.Buffer,Payload);            
-            Status = OS_SocketSendTo(JMsgUdp->Tx.SocketId, JMsgUdp->Tx.Buffer, sizeof(JMsgUdp->Tx.Buffer), &JMsgUdp->Tx.SocketAddr);
-            JMsgUdp->Tx.MsgCnt++;         
-         }
+         MsgLim = JMsgUdp->Config.IoUringDepth;
       }
       
+      /* Time out so a reconfigured pipe is adopted */
+      JMSG_UDP_ServiceTx(JMSG_UDP_RECONFIG_POLL_MS, MsgLim);
+      
    } /* End while loop */
    
    return RetStatus;
@@ -293,15 +741,16 @@ static bool ConfigSubscription(const JMSG_TOPIC_TBL_Topic_t *Topic,
 
    bool RetStatus = true;
    int32 SbStatus;
-   CFE_SB_Qos_t Qos;
+   JMSG_ROUTE_TBL_TxSub_t TxSub;
    
    switch (ConfigOpt)
    {
 
       case JMSG_TOPIC_TBL_SUB_SB:
-         Qos.Priority    = 0;
-         Qos.Reliability = 0;
-         SbStatus = CFE_SB_SubscribeEx(CFE_SB_ValueToMsgId(Topic->Cfe), JMsgUdp->JMsgPipe, Qos, 20);
+         TxSub.MsgId    = CFE_SB_ValueToMsgId(Topic->Cfe);
+         TxSub.MsgLim   = 0;
+         TxSub.Priority = 0;
+         SbStatus = SubscribeTxMsg(&TxSub, JMsgUdp->JMsgPipe);
          if (SbStatus == CFE_SUCCESS)
          {
             CFE_EVS_SendEvent(JMSG_UDP_CONFIG_SUBSCRIPTIONS_EID, CFE_EVS_EventType_INFORMATION, 
@@ -313,14 +762,17 @@ static bool ConfigSubscription(const JMSG_TOPIC_TBL_Topic_t *Topic,
             CFE_EVS_SendEvent(JMSG_UDP_CONFIG_SUBSCRIPTIONS_EID, CFE_EVS_EventType_ERROR, 
                               "Error subscribing to SB for topic 0x%04X(%d)", Topic->Cfe, Topic->Cfe);
          }
+         JMSG_ROUTE_TBL_ConfigPlugin(Topic, JMSG_ROUTE_TBL_DIR_TX, RetStatus);
          break;
          
       case JMSG_TOPIC_TBL_SUB_JMSG:
+         RetStatus = JMSG_ROUTE_TBL_ConfigPlugin(Topic, JMSG_ROUTE_TBL_DIR_RX, true);
          CFE_EVS_SendEvent(JMSG_UDP_CONFIG_SUBSCRIPTIONS_EID, CFE_EVS_EventType_INFORMATION, 
                            "Listening for topic %s", Topic->Name);
          break;
          
       case JMSG_TOPIC_TBL_UNSUB_SB:
+         JMSG_ROUTE_TBL_ConfigPlugin(Topic, JMSG_ROUTE_TBL_DIR_TX, false);
          SbStatus = CFE_SB_Unsubscribe(CFE_SB_ValueToMsgId(Topic->Cfe), JMsgUdp->JMsgPipe);
          if(SbStatus == CFE_SUCCESS)
          {
@@ -336,6 +788,7 @@ static bool ConfigSubscription(const JMSG_TOPIC_TBL_Topic_t *Topic,
          break;
       
       case JMSG_TOPIC_TBL_UNSUB_JMSG:
+         JMSG_ROUTE_TBL_ConfigPlugin(Topic, JMSG_ROUTE_TBL_DIR_RX, false);
          CFE_EVS_SendEvent(JMSG_UDP_CONFIG_SUBSCRIPTIONS_EID, CFE_EVS_EventType_INFORMATION, 
                            "Nolonger expecting topic %s", Topic->Name);
          break;
@@ -351,3 +804,622 @@ static bool ConfigSubscription(const JMSG_TOPIC_TBL_Topic_t *Topic,
    return RetStatus;
    
 } /* End ConfigSubscription() */
+
+
+/******************************************************************************
+** Function: ConfigTxMsg
+**
+** Callback function that is called when a route table load adds or removes
+** a Tx route's SB message.
+**
+*/
+static bool ConfigTxMsg(const JMSG_ROUTE_TBL_TxSub_t *TxSub, bool Subscribe)
+{
+
+   int32 SbStatus;
+   
+   if (Subscribe)
+   {
+      SbStatus = SubscribeTxMsg(TxSub, JMsgUdp->JMsgPipe);
+   }
+   else
+   {
+      SbStatus = CFE_SB_Unsubscribe(TxSub->MsgId, JMsgUdp->JMsgPipe);
+   }
+   
+   if (SbStatus != CFE_SUCCESS)
+   {
+      CFE_EVS_SendEvent(JMSG_UDP_CONFIG_SUBSCRIPTIONS_EID, CFE_EVS_EventType_ERROR, 
+                        "Error %s SB for route message 0x%04X, status = %d", 
+                        (Subscribe ? "subscribing to" : "unsubscribing from"),
+                        CFE_SB_MsgIdToValue(TxSub->MsgId), (int)SbStatus);
+   }
+
+   return (SbStatus == CFE_SUCCESS);
+   
+} /* End ConfigTxMsg() */
+
+
+/******************************************************************************
+** Function: CompressTxMsg
+**
+** Compress a Tx payload in place, append its z attribute to Attr and
+** return the new payload length.
+**
+** Notes:
+**   1. The payload and Attr are unchanged if the payload isn't compressed.
+**      The compressed payload and its attribute are always shorter than the
+**      original payload.
+**
+*/
+static uint32 CompressTxMsg(const char *Topic, char *Payload, uint32 PayloadLen, char *Attr, size_t AttrSize)
+{
+
+   size_t AttrLen = strlen(Attr);
+   char   ZipAttr[16];
+   int    ZipAttrLen;
+   uint32 ZipLen;
+   const uint8 *Zip;
+
+   ZipAttrLen = snprintf(ZipAttr, sizeof(ZipAttr), "%cz=%u", JMSG_HDR_ATTR_SEP, (unsigned int)PayloadLen);
+   if (AttrLen + ZipAttrLen < AttrSize)
+   {
+      Zip = JMSG_LZ_Compress(Topic, Payload, PayloadLen, ZipAttrLen, &ZipLen);
+      if (Zip != NULL)
+      {
+         memcpy(&Attr[AttrLen], ZipAttr, ZipAttrLen + 1);
+         memcpy(Payload, Zip, ZipLen);
+         PayloadLen = ZipLen;
+      }
+   }
+
+   return PayloadLen;
+
+} /* End CompressTxMsg() */
+
+
+/******************************************************************************
+** Function: GetIoUringDepth
+**
+** Return the io_uring depth selected by the INI file or zero for the
+** socket engine.
+**
+*/
+static uint16 GetIoUringDepth(void)
+{
+
+   const char *IoEngine = INITBL_GetStrConfig(INITBL_OBJ, CFG_IO_ENGINE);
+   uint32 Depth = INITBL_GetIntConfig(INITBL_OBJ, CFG_IO_URING_DEPTH);
+   
+   if (strcmp(IoEngine, "io_uring") == 0)
+   {
+      if (Depth >= JMSG_URING_DEPTH_MIN && Depth <= JMSG_UDP_PLATFORM_IO_URING_DEPTH_MAX &&
+          (Depth & (Depth - 1)) == 0)
+      {
+         return (uint16)Depth;
+      }
+      CFE_EVS_SendEvent(JMSG_UDP_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR, 
+                        "IO_URING_DEPTH %u must be a power of 2 from %u to %u, using the socket engine",
+                        (unsigned int)Depth, (unsigned int)JMSG_URING_DEPTH_MIN,
+                        (unsigned int)JMSG_UDP_PLATFORM_IO_URING_DEPTH_MAX);
+   }
+   else if (strcmp(IoEngine, "socket") != 0)
+   {
+      CFE_EVS_SendEvent(JMSG_UDP_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR, 
+                        "Invalid IO_ENGINE %s, using the socket engine", IoEngine);
+   }
+   
+   return 0;
+   
+} /* End GetIoUringDepth() */
+
+
+/******************************************************************************
+** Function: IsJsonWs
+**
+*/
+static bool IsJsonWs(char Char)
+{
+
+   return (Char == ' ' || Char == '\t' || Char == '\r' || Char == '\n');
+
+} /* End IsJsonWs() */
+
+
+/******************************************************************************
+** Function: PutTxHdr
+**
+** Write a Tx message header in the Tx buffer's header reserve so it ends
+** at Payload and return the start of the message.
+**
+** Notes:
+**   1. Returns NULL if the topic and attributes don't fit in the reserve.
+**
+*/
+static char *PutTxHdr(const char *Topic, const char *Attr, char *Payload)
+{
+
+   size_t TopicLen = strlen(Topic);
+   size_t AttrLen  = strlen(Attr);
+   char   *Msg;
+
+   if (TopicLen + AttrLen + 1 > JMSG_UDP_TX_HDR_RESERVE)
+   {
+      return NULL;
+   }
+
+   Msg = Payload - (TopicLen + AttrLen + 1);
+   memcpy(Msg, Topic, TopicLen);
+   memcpy(&Msg[TopicLen], Attr, AttrLen);
+   Payload[-1] = ':';
+
+   return Msg;
+
+} /* End PutTxHdr() */
+
+
+/******************************************************************************
+** Function: OpenRxSocket
+**
+** Open a Rx socket bound to a port and report failures.
+**
+** Notes:
+**   1. Current is the Rx socket being replaced or NULL, see
+**      JMSG_SOCK_OpenRx().
+**
+*/
+static int32 OpenRxSocket(JMSG_SOCK_Class_t *Sock, const JMSG_SOCK_Class_t *Current,
+                          uint16 Port, bool KernelTime)
+{
+
+   int32 Status = OS_ERROR;
+   
+   /* The Rx buffer is only missing if the memory arena is too small */
+   if (JMsgUdp->Rx.Buffer != NULL)
+   {
+      Status = JMSG_SOCK_OpenRx(Sock, Current, Port, KernelTime, JMsgUdp->Config.LocalRxPath,
+                                JMsgUdp->Config.IoUringDepth, JMsgUdp->Rx.BufferLen);
+   }
+   if (Status != OS_SUCCESS)
+   {
+      CFE_EVS_SendEvent(JMSG_UDP_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR, 
+                        "Error creating JMSG UDP Gateway Rx socket on port %u%s%s, status = %d", 
+                        (unsigned int)Port, (JMsgUdp->Config.LocalRxPath[0] == '\0' ? "" : " and "),
+                        JMsgUdp->Config.LocalRxPath, (int)Status);
+   }
+   else if (JMsgUdp->Config.IoUringDepth > 0 && Sock->Uring == NULL)
+   {
+      CFE_EVS_SendEvent(JMSG_UDP_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR, 
+                        "io_uring isn't supported, Rx port %u is received with the socket engine",
+                        (unsigned int)Port);
+   }
+   
+   return Status;
+   
+} /* End OpenRxSocket() */
+
+
+/******************************************************************************
+** Function: ProcessRxMsg
+**
+** Translate a message received in the Rx buffer.
+**
+** Notes:
+**   1. The Rx path's work is bounded by the message length so a malformed
+**      message can't stall the Rx task. The topic matcher walks the trie
+**      with a fixed size stack instead of recursing and a reassembled
+**      fragment is translated once more but never reassembled again, see
+**      jmsg_rx_bound_test.c for the host bounds. The processing time is
+**      measured from after the debug event so the target's bound can be
+**      verified, it includes any error events sent during translation. An
+**      event is only sent for a new longest time so a flood of slow
+**      messages doesn't flood events.
+**   2. Translation captures the datagram with its SB message ID, see
+**      JMSG_TRANS_ProcessJMsg().
+**   3. Last value cache queries are answered from the Rx task and aren't
+**      translated or captured.
+**
+*/
+static void ProcessRxMsg(int32 MsgLen, const JMSG_SOCK_RxInfo_t *RxInfo)
+{
+
+   OS_time_t StartTime;
+   OS_time_t EndTime;
+   uint32    ProcTime;
+
+   /* Terminate for debug output only, translation uses the received length */
+   JMsgUdp->Rx.Buffer[MsgLen] = '\0';
+   JMsgUdp->Rx.MsgCnt++;
+   JMSG_RATE_Count(&JMsgUdp->Rx.Rate, (uint32)MsgLen);
+   CFE_EVS_SendEvent(JMSG_UDP_RX_CHILD_TASK_EID, CFE_EVS_EventType_INFORMATION, 
+                     "JMSG UDP Gateway Rx received message: %.*s", (int)MsgLen, JMsgUdp->Rx.Buffer);
+
+   OS_GetLocalTime(&StartTime);
+   if (MsgLen > 0 && JMsgUdp->Rx.Buffer[0] == JMSG_LVC_QUERY_CHAR)
+   {
+      JMSG_LVC_Query(&JMsgUdp->Rx.Buffer[1], (uint16)(MsgLen - 1), RxInfo);
+   }
+   else
+   {
+      JMSG_TRANS_ProcessJMsg(JMsgUdp->Rx.Buffer, (uint16)MsgLen, RxInfo);
+   }
+
+   OS_GetLocalTime(&EndTime);
+   ProcTime = (uint32)OS_TimeGetTotalMicroseconds(OS_TimeSubtract(EndTime, StartTime));
+
+   if (JMsgUdp->Rx.ProcTimeLim > 0 && ProcTime > JMsgUdp->Rx.ProcTimeLim)
+   {
+      JMsgUdp->Rx.SlowMsgCnt++;
+      if (ProcTime > JMsgUdp->Rx.MaxProcTime)
+      {
+         CFE_EVS_SendEvent(JMSG_UDP_RX_SLOW_MSG_EID, CFE_EVS_EventType_ERROR, 
+                           "Rx message took %u us, limit %u us, length %d: %.*s", 
+                           (unsigned int)ProcTime, (unsigned int)JMsgUdp->Rx.ProcTimeLim, (int)MsgLen,
+                           (int)(MsgLen < JMSG_PLATFORM_TOPIC_NAME_MAX_LEN ? MsgLen : JMSG_PLATFORM_TOPIC_NAME_MAX_LEN),
+                           JMsgUdp->Rx.Buffer);
+      }
+   }
+   if (ProcTime > JMsgUdp->Rx.MaxProcTime)
+   {
+      JMsgUdp->Rx.MaxProcTime = ProcTime;
+   }
+
+} /* End ProcessRxMsg() */
+
+
+/******************************************************************************
+** Function: ProcessTxMsg
+**
+** Translate a SB message and send it to the current Tx address.
+**
+** Notes:
+**   1. The payload is translated directly into the Tx buffer after the
+**      header reserve and the header is written in front of it once its
+**      attributes are known so the payload is never copied.
+**
+*/
+static void ProcessTxMsg(CFE_SB_Buffer_t *SbBufPtr)
+{
+
+   const char *Topic;
+   char       *Payload;
+   char       *Msg = NULL;
+   char        Attr[32] = "";
+   uint32      PayloadLen;
+   uint32      SeqNum;
+   uint16      RelSlot = JMSG_REL_UNDEF_SLOT;
+   size_t      ObjEnd;
+   size_t      Prev;
+   int         TimeLen;
+   uint32      MsgLen = 0;
+   bool        Sent;
+   CFE_TIME_SysTime_t TxTime;
+
+   if (JMsgUdp->Tx.Buffer == NULL)
+   {
+      JMsgUdp->Tx.MsgErrCnt++;
+      return;
+   }
+
+   Payload = &JMsgUdp->Tx.Buffer[JMSG_UDP_TX_HDR_RESERVE];
+   if (JMSG_TRANS_ProcessSbMsg(&SbBufPtr->Msg, Payload, JMsgUdp->Tx.BufferLen, &Topic, &PayloadLen))
+   {
+      
+      if (JMsgUdp->JMsgTrans.TxRoute.Reliable)
+      {
+         if (!JMSG_REL_Reserve(Topic, &SeqNum, &RelSlot))
+         {
+            JMsgUdp->Tx.MsgErrCnt++;
+            return;
+         }
+         snprintf(Attr, sizeof(Attr), "%cr=%u", JMSG_HDR_ATTR_SEP, (unsigned int)SeqNum);
+      }
+      else if (JMSG_SEQ_NextTx(Topic, &SeqNum))
+      {
+         snprintf(Attr, sizeof(Attr), "%cs=%u", JMSG_HDR_ATTR_SEP, (unsigned int)SeqNum);
+      }
+      
+      /* ObjEnd is one past the payload's closing brace when it ends with an object */
+      ObjEnd = PayloadLen;
+      while (ObjEnd > 0 && IsJsonWs(Payload[ObjEnd-1]))
+      {
+         ObjEnd--;
+      }
+      
+      if (JMsgUdp->Config.TxTimeField[0] != '\0' && ObjEnd > 0 && Payload[ObjEnd-1] == '}')
+      {
+         /* Replace the closing brace with the time member and the brace */
+         Prev = ObjEnd - 1;
+         while (Prev > 0 && IsJsonWs(Payload[Prev-1]))
+         {
+            Prev--;
+         }
+         TxTime = CFE_TIME_GetTime();
+         TimeLen = snprintf(&Payload[ObjEnd-1], JMsgUdp->Tx.BufferLen - (ObjEnd-1), "%s\"%s\":%u.%06u}", 
+                            ((Prev > 0 && Payload[Prev-1] == '{') ? "" : ","), JMsgUdp->Config.TxTimeField,
+                            (unsigned int)TxTime.Seconds, (unsigned int)CFE_TIME_Sub2MicroSecs(TxTime.Subseconds));
+         PayloadLen = (TimeLen > 0) ? (ObjEnd - 1 + TimeLen) : JMsgUdp->Tx.BufferLen;
+      }
+      
+      /* Cache the serialized payload before it's compressed */
+      if (PayloadLen < JMsgUdp->Tx.BufferLen)
+      {
+         JMSG_LVC_Update(Topic, Payload, PayloadLen);
+         
+         if (JMsgUdp->JMsgTrans.TxRoute.Compress)
+         {
+            PayloadLen = CompressTxMsg(Topic, Payload, PayloadLen, Attr, sizeof(Attr));
+         }
+         
+         Msg = PutTxHdr(Topic, Attr, Payload);
+         if (Msg != NULL)
+         {
+            MsgLen = (Payload - Msg) + PayloadLen;
+         }
+      }
+      
+      if (Msg != NULL && MsgLen < JMsgUdp->Tx.BufferLen)
+      {
+         JMSG_LOCAL_Send(Msg, MsgLen);
+      }
+      
+      if (Msg != NULL && (MsgLen <= JMSG_MEM_GetDatagramLen() || 
+                          (MsgLen < JMsgUdp->Tx.BufferLen && RelSlot == JMSG_REL_UNDEF_SLOT)))
+      {
+         CFE_ES_PerfLogEntry(JMsgUdp->Tx.PerfId);
+         if (RelSlot != JMSG_REL_UNDEF_SLOT)
+         {
+            Sent = JMSG_REL_Send(RelSlot, Msg, MsgLen);
+         }
+         else if (MsgLen > JMSG_MEM_GetDatagramLen())
+         {
+            Sent = JMSG_FRAG_Send(Topic, Msg, MsgLen);
+         }
+         else
+         {
+            Sent = SendTxMsg(Msg, MsgLen, NULL);
+         }
+         CFE_ES_PerfLogExit(JMsgUdp->Tx.PerfId);
+         if (Sent)
+         {
+            JMsgUdp->Tx.MsgCnt++;
+            JMSG_RATE_Count(&JMsgUdp->Tx.Rate, MsgLen);
+            JMSG_CAP_Tx(Msg, (uint16)MsgLen, JMsgUdp->JMsgTrans.TxRoute.TxMsgId);
+         }
+         else
+         {
+            JMsgUdp->Tx.MsgErrCnt++;
+         }
+      }
+      else
+      {
+         if (RelSlot != JMSG_REL_UNDEF_SLOT)
+         {
+            JMSG_REL_Cancel(RelSlot);
+         }
+         JMsgUdp->Tx.MsgErrCnt++;
+         CFE_EVS_SendEvent(JMSG_UDP_TX_CHILD_TASK_EID, CFE_EVS_EventType_ERROR, 
+                           "Tx message for topic %s exceeds the %u byte %s limit", Topic,
+                           (unsigned int)(RelSlot == JMSG_REL_UNDEF_SLOT ? JMsgUdp->Tx.BufferLen - 1 : JMSG_MEM_GetDatagramLen()),
+                           (RelSlot == JMSG_REL_UNDEF_SLOT ? "fragmented message" : "reliable message"));
+      }
+   }
+
+} /* End ProcessTxMsg() */
+
+
+/******************************************************************************
+** Function: RecvRxMsg
+**
+** Receive a datagram in the Rx buffer.
+**
+** Notes:
+**   1. The socket receive performance log marker includes the time spent
+**      waiting for a datagram.
+**
+*/
+static int32 RecvRxMsg(JMSG_SOCK_Class_t *Sock, int32 Timeout, JMSG_SOCK_RxInfo_t *RxInfo)
+{
+
+   int32 Status;
+
+   CFE_ES_PerfLogEntry(JMsgUdp->Rx.PerfId);
+   Status = JMSG_SOCK_Recv(Sock, JMsgUdp->Rx.Buffer, JMsgUdp->Rx.BufferLen, Timeout, RxInfo);
+   CFE_ES_PerfLogExit(JMsgUdp->Rx.PerfId);
+
+   return Status;
+
+} /* End RecvRxMsg() */
+
+
+/******************************************************************************
+** Function: RecvTxMsg
+**
+** Receive a SB message to be sent.
+**
+** Notes:
+**   1. The SB receive performance log marker includes the time spent
+**      waiting for a message.
+**
+*/
+static int32 RecvTxMsg(CFE_SB_Buffer_t **SbBufPtr, CFE_SB_PipeId_t Pipe, int32 Timeout)
+{
+
+   int32 Status;
+
+   CFE_ES_PerfLogEntry(JMsgUdp->JMsgPipePerfId);
+   Status = CFE_SB_ReceiveBuffer(SbBufPtr, Pipe, Timeout);
+   CFE_ES_PerfLogExit(JMsgUdp->JMsgPipePerfId);
+
+   if (Status == CFE_SUCCESS)
+   {
+      JMSG_SBQ_RecvMsg(&(*SbBufPtr)->Msg);
+   }
+
+   return Status;
+
+} /* End RecvTxMsg() */
+
+
+/******************************************************************************
+** Function: SendSelfTestMsgs
+**
+** Translate and send a burst of self-test messages.
+**
+** Notes:
+**   1. Test messages use the Tx route's translation but not its sequence,
+**      reliable, compression or fragmentation options. A message that
+**      doesn't fit in a datagram is reported to the self-test as not
+**      converted.
+**
+*/
+static void SendSelfTestMsgs(void)
+{
+
+   const CFE_MSG_Message_t *SbMsg;
+   const char *Topic;
+   char   *Payload;
+   char   *Msg;
+   char   Attr[16];
+   uint32 PayloadLen;
+   uint16 Index;
+   uint16 i;
+
+   for (i=0; i < JMSG_SELFTEST_BURST && JMsgUdp->Tx.Buffer != NULL; i++)
+   {
+      SbMsg = JMSG_SELFTEST_NextTxMsg(&Index);
+      if (SbMsg == NULL)
+      {
+         break;
+      }
+      
+      Msg = NULL;
+      Payload = &JMsgUdp->Tx.Buffer[JMSG_UDP_TX_HDR_RESERVE];
+      if (JMSG_TRANS_ProcessSbMsg(SbMsg, Payload, JMsgUdp->Tx.BufferLen, &Topic, &PayloadLen))
+      {
+         snprintf(Attr, sizeof(Attr), "%ct=%u", JMSG_HDR_ATTR_SEP, (unsigned int)Index);
+         Msg = PutTxHdr(Topic, Attr, Payload);
+      }
+      
+      if (Msg != NULL && (uint32)(Payload - Msg) + PayloadLen <= JMSG_MEM_GetDatagramLen())
+      {
+         CFE_ES_PerfLogEntry(JMsgUdp->Tx.PerfId);
+         JMSG_SELFTEST_SendTxMsg(Index, Msg, (uint16)((Payload - Msg) + PayloadLen));
+         CFE_ES_PerfLogExit(JMsgUdp->Tx.PerfId);
+      }
+      else
+      {
+         JMSG_SELFTEST_SendTxMsg(Index, NULL, 0);
+      }
+   }
+
+} /* End SendSelfTestMsgs() */
+
+
+/******************************************************************************
+** Function: SendTxMsg
+**
+** Send a datagram from the Tx socket to the Tx address or a peer.
+**
+** Notes:
+**   1. Called by the Tx task and, for acks, by the Rx task. The socket ID is
+**      read under the reconfiguration mutex and OSAL socket sends are thread
+**      safe.
+**   2. Only IPv4 peers can be addressed. A peer with port zero sent its
+**      message over a local transport so it's answered at the Tx address.
+**   3. Sends from the task that owns the io_uring send ring are queued on
+**      it and submitted when the Tx service function returns.
+**
+*/
+static bool SendTxMsg(const char *Msg, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *Peer)
+{
+
+   char          PeerAddrStr[JMSG_UDP_IP_ADDR_STR_LEN];
+   osal_id_t     SocketId;
+   OS_SockAddr_t SocketAddr;
+   JMSG_SOCK_RxInfo_t TxPeer;
+   
+   OS_MutSemTake(JMsgUdp->ReconfigMutex);
+   SocketId   = JMsgUdp->Tx.SocketId;
+   SocketAddr = JMsgUdp->Tx.SocketAddr;
+   TxPeer     = JMsgUdp->Tx.Peer;
+   OS_MutSemGive(JMsgUdp->ReconfigMutex);
+
+   if (JMsgUdp->Tx.Uring != NULL && OS_ObjectIdEqual(OS_TaskGetId(), JMsgUdp->Tx.UringTaskId))
+   {
+      if (Peer != NULL && Peer->PeerPort != 0)
+      {
+         TxPeer = *Peer;
+      }
+      return JMSG_URING_Send(JMsgUdp->Tx.Uring, Msg, MsgLen, TxPeer.PeerAddr, TxPeer.PeerPort);
+   }
+
+   if (Peer != NULL && Peer->PeerPort != 0)
+   {
+      snprintf(PeerAddrStr, sizeof(PeerAddrStr), "%u.%u.%u.%u", 
+               (unsigned int)((Peer->PeerAddr >> 24) & 0xFF), (unsigned int)((Peer->PeerAddr >> 16) & 0xFF),
+               (unsigned int)((Peer->PeerAddr >>  8) & 0xFF), (unsigned int)(Peer->PeerAddr & 0xFF));
+      OS_SocketAddrInit(&SocketAddr, OS_SocketDomain_INET);
+      if (OS_SocketAddrFromString(&SocketAddr, PeerAddrStr) != OS_SUCCESS)
+      {
+         return false;
+      }
+      OS_SocketAddrSetPort(&SocketAddr, Peer->PeerPort);
+   }
+
+   return (OS_SocketSendTo(SocketId, Msg, MsgLen, &SocketAddr) >= 0);
+
+} /* End SendTxMsg() */
+
+
+/******************************************************************************
+** Function: SetTxAddr
+**
+** Load a Tx socket address from a dotted IP address string and port.
+**
+*/
+static bool SetTxAddr(OS_SockAddr_t *SocketAddr, const char *Addr, uint16 Port)
+{
+
+   int32 Status;
+   
+   OS_SocketAddrInit(SocketAddr, OS_SocketDomain_INET);
+   Status = OS_SocketAddrFromString(SocketAddr, Addr);
+   if (Status == OS_SUCCESS)
+   {
+      OS_SocketAddrSetPort(SocketAddr, Port);
+   }
+   else
+   {
+      CFE_EVS_SendEvent(JMSG_UDP_RECONFIG_EID, CFE_EVS_EventType_ERROR, 
+                        "Invalid Tx UDP address %s, status = %d", Addr, (int)Status);
+   }
+   
+   return (Status == OS_SUCCESS);
+   
+} /* End SetTxAddr() */
+
+
+/******************************************************************************
+** Function: SubscribeTxMsg
+**
+** Subscribe a pipe to a Tx message with its route's message limit and
+** priority.
+**
+** Notes:
+**   1. A zero message limit uses JMSG_PIPE_MSG_LIM.
+**
+*/
+static int32 SubscribeTxMsg(const JMSG_ROUTE_TBL_TxSub_t *TxSub, CFE_SB_PipeId_t Pipe)
+{
+
+   CFE_SB_Qos_t Qos;
+
+   Qos.Priority    = TxSub->Priority;
+   Qos.Reliability = 0;
+
+   return CFE_SB_SubscribeEx(TxSub->MsgId, Pipe, Qos,
+                             (TxSub->MsgLim != 0 ? TxSub->MsgLim : JMsgUdp->Config.JMsgPipeMsgLim));
+
+} /* End SubscribeTxMsg() */
+
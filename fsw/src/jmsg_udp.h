@@ -16,7 +16,56 @@
 **   Manage UDP communications and JSON-SB message translations 
 **
 ** Notes:
-**   TODO: Resolve MQTT_GW topic translation dependency
+**   1. TODO: Resolve MQTT_GW topic translation dependency
+**   2. The reconfigure command prepares new sockets and pipes before it
+**      changes anything. The child tasks adopt them within
+**      JMSG_UDP_RECONFIG_POLL_MS and drain the old socket and pipe before
+**      closing them so in-flight messages are not lost.
+**   3. The Rx and Tx service functions are called by the child tasks or,
+**      in single task mode, by the app's main loop.
+**   4. Translated Rx telemetry is time stamped with the datagram's arrival
+**      time. When TX_TIME_FIELD is defined each Tx JSON object gets a member
+**      with that name holding the cFE time, in seconds, when it was sent.
+**   5. Reliable Tx routes are retransmitted by the Tx service function so
+**      its wait is shortened to the next retransmit timer.
+**   6. Tx JMSGs longer than DATAGRAM_LEN are fragmented. Reliable
+**      messages must fit in one datagram.
+**   7. The Rx and Tx buffers, the reassembly pool, the reliable slots and
+**      the compression buffers are sized by the INI table and allocated from the memory arena. The
+**      Rx and Tx buffers are allocated first so the other subsystems run
+**      with reduced capacity if the arena is too small.
+**   8. Payloads of Tx routes with the "compress" option are compressed
+**      after they're serialized, before fragmentation or reliable delivery.
+**   9. When capture is enabled each Rx datagram and each Tx JMSG that was
+**      sent is recorded in the capture file, see jmsg_cap.h.
+**  10. The Rx socket can also receive from a Unix domain socket and Tx
+**      JMSGs are also sent to the enabled local transports, see
+**      jmsg_local.h. Local transports aren't changed by reconfiguration.
+**  11. The io_uring engine receives with the Rx socket's ring and sends
+**      with a Tx ring owned by the first task that services Tx messages.
+**      Sends from other tasks, i.e. acks sent by the Rx task, use the OSAL
+**      Tx socket. Tx sends are submitted once per ServiceTx() call.
+**  12. The Tx child task drains up to the JMSG pipe depth, or
+**      IO_URING_DEPTH if it's larger, per ServiceTx() call so each call
+**      measures the pipe's queued messages, see jmsg_sbq.h. Tx routes
+**      subscribe with their route's msg-lim and priority options or
+**      JMSG_PIPE_MSG_LIM. The cFE SB accepts a QoS priority but doesn't
+**      currently act on it.
+**  13. Each Tx JMSG is cached by topic and Rx datagrams starting with '?'
+**      query the cache, see jmsg_lvc.h. The cache is allocated after the
+**      compression buffers.
+**  14. The self-test command sends synthetic SB messages through the Tx
+**      translation to the Rx port and measures their round trip, see
+**      jmsg_selftest.h. The Tx service function sends them in bursts after
+**      the JMSG pipe's messages and polls the pipe while they're pending.
+**  15. Rx datagrams and Tx JMSGs are counted with their lengths for the
+**      rates in the extended status telemetry, see jmsg_rate.h. A Tx JMSG
+**      is counted once with its length before fragmentation. Acks, query
+**      replies and self-test messages aren't counted.
+**  16. Rx payloads can be decoded by topic-sharded worker tasks, see
+**      jmsg_decode.h. The Rx processing time then covers the header
+**      processing and queueing but not the decoding, and a captured
+**      datagram whose payload was queued has a zero SB message ID.
 **
 */
 
@@ -28,13 +77,29 @@
 */
 
 #include "app_cfg.h"
+#include "jmsg_cap.h"
+#include "jmsg_decode.h"
+#include "jmsg_frag.h"
+#include "jmsg_local.h"
+#include "jmsg_lvc.h"
+#include "jmsg_lz.h"
+#include "jmsg_mem.h"
+#include "jmsg_rate.h"
+#include "jmsg_rel.h"
+#include "jmsg_sbq.h"
+#include "jmsg_selftest.h"
+#include "jmsg_sock.h"
 #include "jmsg_trans.h"
 #include "jmsg_topic_tbl.h"
+#include "jmsg_uring.h"
 
 /***********************/
 /** Macro Definitions **/
 /***********************/
 
+#define JMSG_UDP_IP_ADDR_STR_LEN   16  /* Must match EDS IpAddrStr length */
+#define JMSG_UDP_TX_TIME_FIELD_LEN 32
+#define JMSG_UDP_TX_HDR_RESERVE    (JMSG_PLATFORM_TOPIC_NAME_MAX_LEN + 32)  /* Tx topic and attributes */
 
 /*
 ** Event Message IDs
@@ -44,6 +109,9 @@
 #define JMSG_UDP_CONFIG_SUBSCRIPTIONS_EID    (JMSG_UDP_BASE_EID + 1)
 #define JMSG_UDP_RX_CHILD_TASK_EID           (JMSG_UDP_BASE_EID + 2)
 #define JMSG_UDP_SUBSCRIBE_TOPIC_PLUGIN_EID  (JMSG_UDP_BASE_EID + 3)
+#define JMSG_UDP_RECONFIG_EID                (JMSG_UDP_BASE_EID + 4)
+#define JMSG_UDP_TX_CHILD_TASK_EID           (JMSG_UDP_BASE_EID + 5)
+#define JMSG_UDP_RX_SLOW_MSG_EID             (JMSG_UDP_BASE_EID + 6)
 
 
 /**********************/
@@ -51,17 +119,65 @@
 /**********************/
 
 
+typedef struct
+{
+
+   bool               Connected;   
+   JMSG_SOCK_Class_t  Sock;
+   bool               OldSockPending;  /* Replaced socket waiting to be drained and closed */
+   JMSG_SOCK_Class_t  OldSock;
+   char               *Buffer;     /* Room for a terminator after a full datagram */
+   uint32             BufferLen;   /* Datagram length, excludes the terminator */
+   uint32             MsgCnt;
+   uint32             MsgErrCnt;
+   uint32             PerfId;      /* Socket receive performance log ID */
+   uint32             ProcTimeLim; /* Microseconds, zero disables the check */
+   uint32             MaxProcTime; /* Longest message processing time in microseconds */
+   uint32             SlowMsgCnt;  /* Messages that exceeded ProcTimeLim */
+   JMSG_RATE_Class_t  Rate;        /* Datagrams received */
+   
+} JMSG_UDP_RxSocket_t;
+
+
 typedef struct
 {
 
    bool            Connected;   
    osal_id_t       SocketId;
    OS_SockAddr_t   SocketAddr;
-   char            Buffer[JMSG_UDP_BUF_LEN];  
+   JMSG_SOCK_RxInfo_t Peer;     /* SocketAddr as an IPv4 address and port */
+   JMSG_URING_Tx_t *Uring;      /* io_uring send ring or NULL */
+   osal_id_t       UringTaskId; /* Task that owns the send ring */
+   char            *Buffer;     /* Header reserve followed by the payload */
+   uint32          BufferLen;   /* Payload and whole JMSG limit, includes the terminator */
    uint32          MsgCnt;
    uint32          MsgErrCnt;
+   uint32          PerfId;      /* Socket send performance log ID */
+   JMSG_RATE_Class_t Rate;      /* JMSGs sent, before fragmentation */
    
-} JMSG_UDP_Socket_t;
+} JMSG_UDP_TxSocket_t;
+
+
+/*
+** Current network configuration. Initialized from the INI table and changed
+** by the reconfigure command.
+*/
+
+typedef struct
+{
+
+   uint16  RxPort;
+   char    TxAddr[JMSG_UDP_IP_ADDR_STR_LEN];
+   uint16  TxPort;
+   uint16  JMsgPipeDepth;
+   uint16  JMsgPipeMsgLim;  /* Default SB message limit of Tx subscriptions */
+   bool    JMsgPipeAltName;
+   bool    RxKernelTime;
+   uint16  IoUringDepth;   /* Zero uses the socket engine */
+   char    TxTimeField[JMSG_UDP_TX_TIME_FIELD_LEN];  /* Empty if disabled */
+   char    LocalRxPath[JMSG_SOCK_LOCAL_PATH_LEN];    /* Empty if disabled */
+
+} JMSG_UDP_Config_t;
 
 
 typedef struct
@@ -69,12 +185,36 @@ typedef struct
 
    const INITBL_Class_t  *IniTbl; 
 
-   JMSG_UDP_Socket_t Rx;
-   JMSG_UDP_Socket_t Tx;
+   JMSG_MEM_Class_t  Mem;
+   
+   JMSG_UDP_Config_t Config;
+   
+   /*
+   ** The reconfiguration mutex protects the socket IDs, the Tx address and 
+   ** the JMSG pipe IDs that the child tasks read.
+   */
+   osal_id_t         ReconfigMutex;
+   uint32            ReconfigCnt;
+   
+   JMSG_UDP_RxSocket_t Rx;
+   JMSG_UDP_TxSocket_t Tx;
    
    CFE_SB_PipeId_t   JMsgPipe;
+   bool              OldJMsgPipePending;
+   CFE_SB_PipeId_t   OldJMsgPipe;
+   uint32            JMsgPipePerfId;   /* SB receive performance log ID */
       
-   JMSG_TRANS_Class_t JMsgTrans;
+   JMSG_ROUTE_TBL_Class_t RouteTbl;
+   JMSG_TRANS_Class_t     JMsgTrans;
+   JMSG_REL_Class_t       Rel;
+   JMSG_FRAG_Class_t      Frag;
+   JMSG_LZ_Class_t        Lz;
+   JMSG_CAP_Class_t       Cap;
+   JMSG_LOCAL_Class_t     Local;
+   JMSG_SBQ_Class_t       Sbq;
+   JMSG_LVC_Class_t       Lvc;
+   JMSG_SELFTEST_Class_t  SelfTest;
+   JMSG_DECODE_Class_t    Decode;
    
 } JMSG_UDP_Class_t;
 
@@ -96,6 +236,34 @@ typedef struct
 void JMSG_UDP_Constructor(JMSG_UDP_Class_t *UdpMgrPtr, const INITBL_Class_t *IniTbl);
 
 
+/******************************************************************************
+** Function: JMSG_UDP_GetMemReport
+**
+** Load the bytes used by each subsystem. Object sizes include their fixed
+** arrays and arena buffers are reported with their user.
+**
+** Notes:
+**   1. The child task stacks are created by the app and not included.
+**
+*/
+void JMSG_UDP_GetMemReport(JMSG_UDP_MemReport_t *Report);
+
+
+/******************************************************************************
+** Function: JMSG_UDP_ReconfigCmd
+**
+** Change the Rx port, Tx address and port, JMSG pipe depth and route table
+** while the child tasks are running.
+**
+** Notes:
+**   1. Zero and empty payload parameters keep their current values.
+**   2. Every change is validated before any is applied so a rejected
+**      command leaves the current configuration unchanged.
+**
+*/
+bool JMSG_UDP_ReconfigCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr);
+
+
 /******************************************************************************
 ** Function: JMSG_UDP_ResetStatus
 **
@@ -112,6 +280,48 @@ void JMSG_UDP_ResetStatus(void);
 bool JMSG_UDP_RxChildTask(CHILDMGR_Class_t *ChildMgr);
 
 
+/******************************************************************************
+** Function: JMSG_UDP_SelfTestCmd
+**
+** Start a loopback self-test of a Tx route's message ID.
+**
+** Notes:
+**   1. The messages are sent to the current Rx port. A reconfiguration
+**      during a test causes the remaining messages to be lost.
+**
+*/
+bool JMSG_UDP_SelfTestCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr);
+
+
+/******************************************************************************
+** Function: JMSG_UDP_ServiceRx
+**
+** Receive and translate up to MsgLim UDP messages and return the number
+** processed.
+**
+** Notes:
+**   1. Only the first receive waits, for up to Timeout milliseconds.
+**   2. A socket replaced by a reconfiguration is drained and closed first.
+**
+*/
+uint16 JMSG_UDP_ServiceRx(int32 Timeout, uint16 MsgLim);
+
+
+/******************************************************************************
+** Function: JMSG_UDP_ServiceTx
+**
+** Receive, translate and send up to MsgLim SB messages and return the 
+** number processed.
+**
+** Notes:
+**   1. Only the first receive waits, for up to Timeout milliseconds.
+**   2. A pipe replaced by a reconfiguration is drained and deleted first.
+**   3. With io_uring the sends are submitted together before returning.
+**
+*/
+uint16 JMSG_UDP_ServiceTx(int32 Timeout, uint16 MsgLim);
+
+
 /******************************************************************************
 ** Function: JMSG_UDP_SubscribeToTopicPlugin
 **
@@ -35,6 +35,7 @@
 /* Convenience macros */
 #define  INITBL_OBJ      (&(JMsgUdpApp.IniTbl))
 #define  CMDMGR_OBJ      (&(JMsgUdpApp.CmdMgr))
+#define  TBLMGR_OBJ      (&(JMsgUdpApp.TblMgr))
 #define  RX_CHILDMGR_OBJ (&(JMsgUdpApp.RxChildMgr))
 #define  TX_CHILDMGR_OBJ (&(JMsgUdpApp.TxChildMgr))
 #define  JMSG_UDP_OBJ    (&(JMsgUdpApp.JMsgUdp))
@@ -44,7 +45,15 @@
 /*******************************/
 
 static int32 InitApp(void);
-static int32 ProcessCommands(void);
+static int32 ProcessCommands(int32 Timeout, bool *Received);
+static int32 ServiceSingleTask(void);
+static void LoadRateStats(JMSG_UDP_RateStats_t *Stats, JMSG_RATE_Class_t *Rate);
+static void SendDecodeStatsPkt(void);
+static void SendExtStatusPkt(void);
+static void SendPeerStatsPkt(void);
+static void SendLzStatsPkt(void);
+static void SendSbStatsPkt(void);
+static void SendSelfTestPkt(void);
 static void SendStatusPkt(void);
 
 
@@ -61,7 +70,9 @@ DEFINE_ENUM(Config,APP_CONFIG)
 static CFE_EVS_BinFilter_t  EventFilters[] =
 {  
    /* Event ID                           Mask */
-   {JMSG_UDP_RX_CHILD_TASK_EID, CFE_EVS_FIRST_4_STOP} // CFE_EVS_NO_FILTER
+   {JMSG_UDP_RX_CHILD_TASK_EID,  CFE_EVS_FIRST_4_STOP}, // CFE_EVS_NO_FILTER
+   {JMSG_TRANS_INVALID_JSON_EID, CFE_EVS_FIRST_4_STOP},
+   {JMSG_DECODE_DROP_EID,        CFE_EVS_FIRST_4_STOP}
 };
 
 /*****************/
@@ -96,10 +107,18 @@ void JMSG_UDP_AppMain(void)
       
       /*
       ** The Rx and Tx child tasks manage translating and transferring the JSON
-      ** messages. This loop only needs to service commands.
+      ** messages so this loop only needs to service commands unless the app
+      ** is configured to run as a single task.
       */ 
       
-      RunStatus = ProcessCommands();
+      if (JMsgUdpApp.SingleTaskMode)
+      {
+         RunStatus = ServiceSingleTask();
+      }
+      else
+      {
+         RunStatus = ProcessCommands(CFE_SB_PEND_FOREVER, NULL);
+      }
       
    } /* End CFE_ES_RunLoop */
 
@@ -143,8 +162,12 @@ bool JMSG_UDP_APP_ResetAppCmd(void* ObjDataPtr, const CFE_MSG_Message_t *MsgPtr)
    CFE_EVS_ResetAllFilters();
 
    CMDMGR_ResetStatus(CMDMGR_OBJ);
-   CHILDMGR_ResetStatus(RX_CHILDMGR_OBJ);
-   CHILDMGR_ResetStatus(TX_CHILDMGR_OBJ);
+   TBLMGR_ResetStatus(TBLMGR_OBJ);
+   if (!JMsgUdpApp.SingleTaskMode)
+   {
+      CHILDMGR_ResetStatus(RX_CHILDMGR_OBJ);
+      CHILDMGR_ResetStatus(TX_CHILDMGR_OBJ);
+   }
    
    JMSG_UDP_ResetStatus();
 	  
@@ -182,21 +205,53 @@ static int32 InitApp(void)
       JMsgUdpApp.SendStatusMid  = CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_SEND_STATUS_TLM_TOPICID));
       JMsgUdpApp.TopicSubTlmMid = CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_LIB_TOPIC_SUBSCRIBE_TLM_TOPICID));
    
-      /* Child Manager constructor sends error events */
-
-      ChildTaskInit.TaskName  = INITBL_GetStrConfig(INITBL_OBJ, CFG_RX_CHILD_NAME);
-      ChildTaskInit.StackSize = INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_CHILD_STACK_SIZE);
-      ChildTaskInit.Priority  = INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_CHILD_PRIORITY);
-      ChildTaskInit.PerfId    = INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_CHILD_PERF_ID);
-      RetStatus = CHILDMGR_Constructor(RX_CHILDMGR_OBJ, ChildMgr_TaskMainCallback,
-                                       JMSG_UDP_RxChildTask, &ChildTaskInit); 
-
-      ChildTaskInit.TaskName  = INITBL_GetStrConfig(INITBL_OBJ, CFG_TX_CHILD_NAME);
-      ChildTaskInit.StackSize = INITBL_GetIntConfig(INITBL_OBJ, CFG_TX_CHILD_STACK_SIZE);
-      ChildTaskInit.Priority  = INITBL_GetIntConfig(INITBL_OBJ, CFG_TX_CHILD_PRIORITY);
-      ChildTaskInit.PerfId    = INITBL_GetIntConfig(INITBL_OBJ, CFG_TX_CHILD_PERF_ID);
-      RetStatus = CHILDMGR_Constructor(TX_CHILDMGR_OBJ, ChildMgr_TaskMainCallback,
-                                       JMSG_UDP_TxChildTask, &ChildTaskInit); 
+      JMsgUdpApp.SingleTaskMode   = (INITBL_GetIntConfig(INITBL_OBJ, CFG_SINGLE_TASK_MODE) != 0);
+      JMsgUdpApp.SingleTaskWaitMs = INITBL_GetIntConfig(INITBL_OBJ, CFG_SINGLE_TASK_WAIT_MS);
+      JMsgUdpApp.SingleTaskMsgLim = INITBL_GetIntConfig(INITBL_OBJ, CFG_SINGLE_TASK_MSG_LIM);
+      if (JMsgUdpApp.SingleTaskMsgLim < 1)
+      {
+         JMsgUdpApp.SingleTaskMsgLim = 1;
+      }
+      
+      if (!JMsgUdpApp.SingleTaskMode)
+      {
+         
+         /* Child Manager constructor sends error events */
+
+         ChildTaskInit.TaskName  = INITBL_GetStrConfig(INITBL_OBJ, CFG_RX_CHILD_NAME);
+         ChildTaskInit.StackSize = INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_CHILD_STACK_SIZE);
+         ChildTaskInit.Priority  = INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_CHILD_PRIORITY);
+         ChildTaskInit.PerfId    = INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_CHILD_PERF_ID);
+         RetStatus = CHILDMGR_Constructor(RX_CHILDMGR_OBJ, ChildMgr_TaskMainCallback,
+                                          JMSG_UDP_RxChildTask, &ChildTaskInit); 
+
+         ChildTaskInit.TaskName  = INITBL_GetStrConfig(INITBL_OBJ, CFG_TX_CHILD_NAME);
+         ChildTaskInit.StackSize = INITBL_GetIntConfig(INITBL_OBJ, CFG_TX_CHILD_STACK_SIZE);
+         ChildTaskInit.Priority  = INITBL_GetIntConfig(INITBL_OBJ, CFG_TX_CHILD_PRIORITY);
+         ChildTaskInit.PerfId    = INITBL_GetIntConfig(INITBL_OBJ, CFG_TX_CHILD_PERF_ID);
+         RetStatus = CHILDMGR_Constructor(TX_CHILDMGR_OBJ, ChildMgr_TaskMainCallback,
+                                          JMSG_UDP_TxChildTask, &ChildTaskInit); 
+
+         /* Decode workers fall back to the Rx task so a failure isn't fatal */
+         JMSG_DECODE_StartWorkers(INITBL_OBJ);
+      }
+      
+      JMSG_UDP_GetMemReport(&JMsgUdpApp.MemReport);
+      if (!JMsgUdpApp.SingleTaskMode)
+      {
+         JMsgUdpApp.MemReport.RxStack = INITBL_GetIntConfig(INITBL_OBJ, CFG_RX_CHILD_STACK_SIZE);
+         JMsgUdpApp.MemReport.TxStack = INITBL_GetIntConfig(INITBL_OBJ, CFG_TX_CHILD_STACK_SIZE);
+      }
+      CFE_EVS_SendEvent(JMSG_UDP_APP_MEM_REPORT_EID, CFE_EVS_EventType_INFORMATION,
+                        "Memory: Routes %u, Trans %u, Rel %u, Frag %u, Lz %u, Lvc %u, Self-test %u, Decode %u, Rx buf %u, Tx buf %u, "
+                        "arena %u of %u, stacks Rx %u Tx %u",
+                        (unsigned int)JMsgUdpApp.MemReport.RouteTbl, (unsigned int)JMsgUdpApp.MemReport.Trans,
+                        (unsigned int)JMsgUdpApp.MemReport.Rel,      (unsigned int)JMsgUdpApp.MemReport.Frag,
+                        (unsigned int)JMsgUdpApp.MemReport.Lz,       (unsigned int)JMsgUdpApp.MemReport.Lvc,
+                        (unsigned int)JMsgUdpApp.MemReport.SelfTest, (unsigned int)JMsgUdpApp.MemReport.Decode,
+                        (unsigned int)JMsgUdpApp.MemReport.RxBuf,    (unsigned int)JMsgUdpApp.MemReport.TxBuf,
+                        (unsigned int)JMsgUdpApp.MemReport.ArenaUsed, (unsigned int)JMsgUdpApp.MemReport.ArenaLen,
+                        (unsigned int)JMsgUdpApp.MemReport.RxStack,  (unsigned int)JMsgUdpApp.MemReport.TxStack);
       
       /*
       ** Initialize app level interfaces
@@ -213,8 +268,24 @@ static int32 InitApp(void)
       CMDMGR_Constructor(CMDMGR_OBJ);
       CMDMGR_RegisterFunc(CMDMGR_OBJ, JMSG_UDP_NOOP_CC,  NULL, JMSG_UDP_APP_NoOpCmd,     0);
       CMDMGR_RegisterFunc(CMDMGR_OBJ, JMSG_UDP_RESET_CC, NULL, JMSG_UDP_APP_ResetAppCmd, 0);
+      CMDMGR_RegisterFunc(CMDMGR_OBJ, JMSG_UDP_LOAD_TBL_CC, TBLMGR_OBJ, TBLMGR_LoadTblCmd, sizeof(APP_C_FW_LoadTbl_CmdPayload_t));
+      CMDMGR_RegisterFunc(CMDMGR_OBJ, JMSG_UDP_DUMP_TBL_CC, TBLMGR_OBJ, TBLMGR_DumpTblCmd, sizeof(APP_C_FW_DumpTbl_CmdPayload_t));
+      CMDMGR_RegisterFunc(CMDMGR_OBJ, JMSG_UDP_RECONFIG_CC, JMSG_UDP_OBJ, JMSG_UDP_ReconfigCmd, sizeof(JMSG_UDP_Reconfig_CmdPayload_t));
+      CMDMGR_RegisterFunc(CMDMGR_OBJ, JMSG_UDP_CAPTURE_CC, &JMsgUdpApp.JMsgUdp.Cap, JMSG_CAP_CaptureCmd, sizeof(JMSG_UDP_Capture_CmdPayload_t));
+      CMDMGR_RegisterFunc(CMDMGR_OBJ, JMSG_UDP_SELF_TEST_CC, JMSG_UDP_OBJ, JMSG_UDP_SelfTestCmd, sizeof(JMSG_UDP_SelfTest_CmdPayload_t));
+
+      /* Route table Tx subscriptions use the JMSG pipe created by JMSG_UDP */
+      TBLMGR_Constructor(TBLMGR_OBJ, INITBL_GetStrConfig(INITBL_OBJ, CFG_APP_CFE_NAME));
+      TBLMGR_RegisterTblWithDef(TBLMGR_OBJ, JMSG_ROUTE_TBL_NAME, JMSG_ROUTE_TBL_LoadCmd, 
+                                JMSG_ROUTE_TBL_DumpCmd, INITBL_GetStrConfig(INITBL_OBJ, CFG_ROUTE_TBL_FILE));
          
       CFE_MSG_Init(CFE_MSG_PTR(JMsgUdpApp.StatusTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_UDP_STATUS_TLM_TOPICID)), sizeof(JMSG_UDP_StatusTlm_t));
+      CFE_MSG_Init(CFE_MSG_PTR(JMsgUdpApp.ExtStatusTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_UDP_EXT_STATUS_TLM_TOPICID)), sizeof(JMSG_UDP_ExtStatusTlm_t));
+      CFE_MSG_Init(CFE_MSG_PTR(JMsgUdpApp.PeerStatsTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_UDP_PEER_STATS_TLM_TOPICID)), sizeof(JMSG_UDP_PeerStatsTlm_t));
+      CFE_MSG_Init(CFE_MSG_PTR(JMsgUdpApp.LzStatsTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_UDP_LZ_STATS_TLM_TOPICID)), sizeof(JMSG_UDP_LzStatsTlm_t));
+      CFE_MSG_Init(CFE_MSG_PTR(JMsgUdpApp.SbStatsTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_UDP_SB_STATS_TLM_TOPICID)), sizeof(JMSG_UDP_SbStatsTlm_t));
+      CFE_MSG_Init(CFE_MSG_PTR(JMsgUdpApp.SelfTestTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_UDP_SELF_TEST_TLM_TOPICID)), sizeof(JMSG_UDP_SelfTestTlm_t));
+      CFE_MSG_Init(CFE_MSG_PTR(JMsgUdpApp.DecodeStatsTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_UDP_DECODE_STATS_TLM_TOPICID)), sizeof(JMSG_UDP_DecodeStatsTlm_t));
 
       /*
       ** Application startup event message
@@ -233,9 +304,11 @@ static int32 InitApp(void)
 /******************************************************************************
 ** Function: ProcessCommands
 **
-** 
+** Notes:
+**   1. Received is set to whether a message was received unless it's NULL.
+**
 */
-static int32 ProcessCommands(void)
+static int32 ProcessCommands(int32 Timeout, bool *Received)
 {
    
    int32  RetStatus = CFE_ES_RunStatus_APP_RUN;
@@ -246,9 +319,14 @@ static int32 ProcessCommands(void)
 
 
    CFE_ES_PerfLogExit(JMsgUdpApp.PerfId);
-   SysStatus = CFE_SB_ReceiveBuffer(&SbBufPtr, JMsgUdpApp.CmdPipe, CFE_SB_PEND_FOREVER);
+   SysStatus = CFE_SB_ReceiveBuffer(&SbBufPtr, JMsgUdpApp.CmdPipe, Timeout);
    CFE_ES_PerfLogEntry(JMsgUdpApp.PerfId);
 
+   if (Received != NULL)
+   {
+      *Received = (SysStatus == CFE_SUCCESS);
+   }
+
    if (SysStatus == CFE_SUCCESS)
    {
       SysStatus = CFE_MSG_GetMsgId(&SbBufPtr->Msg, &MsgId);
@@ -263,6 +341,15 @@ static int32 ProcessCommands(void)
          else if (CFE_SB_MsgId_Equal(MsgId, JMsgUdpApp.SendStatusMid))
          {   
             SendStatusPkt();
+            SendExtStatusPkt();
+            SendPeerStatsPkt();
+            SendLzStatsPkt();
+            SendSbStatsPkt();
+            SendDecodeStatsPkt();
+            if (JMSG_SELFTEST_Poll())
+            {
+               SendSelfTestPkt();
+            }
          }
          else if (CFE_SB_MsgId_Equal(MsgId, JMsgUdpApp.TopicSubTlmMid))
          {   
@@ -279,7 +366,7 @@ static int32 ProcessCommands(void)
    } /* End if received buffer */
    else
    {
-      if (SysStatus != CFE_SB_NO_MESSAGE)
+      if (SysStatus != CFE_SB_NO_MESSAGE && SysStatus != CFE_SB_TIME_OUT)
       {
          RetStatus = CFE_ES_RunStatus_APP_ERROR;
       }
@@ -290,6 +377,290 @@ static int32 ProcessCommands(void)
 } /* End ProcessCommands() */
 
 
+/******************************************************************************
+** Function: ServiceSingleTask
+**
+** Perform one pass of the single task event loop.
+**
+** Notes:
+**   1. The loop waits on the Rx socket, or on the JMSG pipe when the Rx 
+**      socket isn't connected, for up to SINGLE_TASK_WAIT_MS. The other
+**      sources are polled. 
+**   2. Rx, Tx and commands are each serviced for at most 
+**      SINGLE_TASK_MSG_LIM messages per pass so a burst on one can't
+**      starve the others.
+**   3. If a source hit its limit there may be more messages waiting so the
+**      next pass doesn't wait. Only a pass after an idle pass waits, so a
+**      Tx message or command reaching an idle gateway is delayed by at most
+**      SINGLE_TASK_WAIT_MS.
+**
+*/
+static int32 ServiceSingleTask(void)
+{
+
+   int32  RetStatus = CFE_ES_RunStatus_APP_RUN;
+   int32  WaitMs    = JMsgUdpApp.SingleTaskBusy ? 0 : JMsgUdpApp.SingleTaskWaitMs;
+   int32  TxTimeout = CFE_SB_POLL;
+   uint16 MsgLim    = JMsgUdpApp.SingleTaskMsgLim;
+   uint16 RxCnt     = 0;
+   uint16 TxCnt;
+   uint16 CmdCnt    = 0;
+   bool   CmdReceived = true;
+   
+   CFE_ES_PerfLogExit(JMsgUdpApp.PerfId);
+   if (JMsgUdpApp.JMsgUdp.Rx.Connected)
+   {
+      RxCnt = JMSG_UDP_ServiceRx(WaitMs, MsgLim);
+   }
+   else
+   {
+      TxTimeout = WaitMs;
+   }
+   TxCnt = JMSG_UDP_ServiceTx(TxTimeout, MsgLim);
+   CFE_ES_PerfLogEntry(JMsgUdpApp.PerfId);
+
+   while (CmdReceived && CmdCnt < MsgLim && RetStatus == CFE_ES_RunStatus_APP_RUN)
+   {
+      RetStatus = ProcessCommands(CFE_SB_POLL, &CmdReceived);
+      CmdCnt += CmdReceived;
+   }
+
+   JMsgUdpApp.SingleTaskBusy = (RxCnt >= MsgLim || TxCnt >= MsgLim || CmdCnt >= MsgLim);
+
+   return RetStatus;
+   
+} /* End ServiceSingleTask() */
+
+
+/******************************************************************************
+** Function: LoadRateStats
+**
+** Compute a direction's rates and load them into telemetry.
+**
+*/
+static void LoadRateStats(JMSG_UDP_RateStats_t *Stats, JMSG_RATE_Class_t *Rate)
+{
+
+   uint16 i;
+
+   JMSG_RATE_Update(Rate);
+
+   Stats->MsgCnt         = Rate->MsgCnt;
+   Stats->ByteCnt        = Rate->ByteCnt;
+   Stats->MsgPerSec      = Rate->MsgPerSec;
+   Stats->BytePerSec     = Rate->BytePerSec;
+   Stats->PeakMsgPerSec  = Rate->PeakMsgPerSec;
+   Stats->PeakBytePerSec = Rate->PeakBytePerSec;
+   Stats->MaxLen         = Rate->MaxLen;
+   for (i=0; i < JMSG_UDP_PLATFORM_RATE_SIZE_BIN_CNT; i++)
+   {
+      Stats->SizeBin[i] = Rate->SizeBin[i];
+   }
+
+} /* End LoadRateStats() */
+
+
+/******************************************************************************
+** Function: SendDecodeStatsPkt
+**
+** Notes:
+**   1. Worker utilization is computed over the period since the previous
+**      packet.
+**
+*/
+static void SendDecodeStatsPkt(void)
+{
+   
+   JMSG_UDP_DecodeStatsTlm_Payload_t *Payload = &JMsgUdpApp.DecodeStatsTlm.Payload;
+   const JMSG_DECODE_Class_t  *Decode = &JMsgUdpApp.JMsgUdp.Decode;
+   const JMSG_DECODE_Worker_t *Worker;
+   uint16 i;
+
+   JMSG_DECODE_Update();
+   
+   memset(Payload, 0, sizeof(JMSG_UDP_DecodeStatsTlm_Payload_t));
+   
+   for (i=0; i < Decode->WorkerCnt; i++)
+   {
+      Worker = &Decode->Worker[i];
+      Payload->Worker[i].MsgCnt       = Worker->MsgCnt;
+      Payload->Worker[i].DropCnt      = Worker->DropCnt;
+      Payload->Worker[i].Queued       = Worker->Queued;
+      Payload->Worker[i].HighWater    = Worker->HighWater;
+      Payload->Worker[i].BusyPerMille = Worker->BusyPerMille;
+   }
+   Payload->WorkerCnt  = Decode->Started ? Decode->WorkerCnt : 0;
+   Payload->QueueDepth = Decode->QueueDepth;
+   Payload->QueueLen   = Decode->QueueLen;
+      
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(JMsgUdpApp.DecodeStatsTlm.TelemetryHeader));
+   CFE_SB_TransmitMsg(CFE_MSG_PTR(JMsgUdpApp.DecodeStatsTlm.TelemetryHeader), true);
+
+} /* End SendDecodeStatsPkt() */
+
+
+/******************************************************************************
+** Function: SendExtStatusPkt
+**
+** Notes:
+**   1. The rates are computed when the packet is sent so they're averaged
+**      over the status period.
+**
+*/
+static void SendExtStatusPkt(void)
+{
+   
+   JMSG_UDP_ExtStatusTlm_Payload_t *Payload = &JMsgUdpApp.ExtStatusTlm.Payload;
+
+   LoadRateStats(&Payload->Rx, &JMsgUdpApp.JMsgUdp.Rx.Rate);
+   LoadRateStats(&Payload->Tx, &JMsgUdpApp.JMsgUdp.Tx.Rate);
+   Payload->IntervalMs = JMsgUdpApp.JMsgUdp.Rx.Rate.IntervalMs;
+      
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(JMsgUdpApp.ExtStatusTlm.TelemetryHeader));
+   CFE_SB_TransmitMsg(CFE_MSG_PTR(JMsgUdpApp.ExtStatusTlm.TelemetryHeader), true);
+
+} /* End SendExtStatusPkt() */
+
+
+/******************************************************************************
+** Function: SendPeerStatsPkt
+**
+*/
+static void SendPeerStatsPkt(void)
+{
+   
+   JMSG_UDP_PeerStatsTlm_Payload_t *Payload = &JMsgUdpApp.PeerStatsTlm.Payload;
+   const JMSG_SEQ_Class_t *Seq = &JMsgUdpApp.JMsgUdp.JMsgTrans.Seq;
+   const JMSG_SEQ_Peer_t  *Peer;
+   uint16 i;
+
+   memset(Payload, 0, sizeof(JMSG_UDP_PeerStatsTlm_Payload_t));
+   
+   for (i=0; i < JMSG_UDP_PLATFORM_SEQ_PEER_MAX && Seq->Peer[i].InUse; i++)
+   {
+      Peer = &Seq->Peer[i];
+      Payload->Peer[i].PeerAddr     = Peer->PeerAddr;
+      Payload->Peer[i].PeerPort     = Peer->PeerPort;
+      Payload->Peer[i].LossPerMille = JMSG_SEQ_LossPerMille(&Peer->Stats);
+      Payload->Peer[i].RxCnt        = Peer->Stats.RxCnt;
+      Payload->Peer[i].LostCnt      = Peer->Stats.LostCnt;
+      Payload->Peer[i].ReorderCnt   = Peer->Stats.ReorderCnt;
+      Payload->Peer[i].DupCnt       = Peer->Stats.DupCnt;
+      Payload->Peer[i].RestartCnt   = Peer->Stats.RestartCnt;
+   }
+   Payload->PeerCnt      = i;
+   Payload->StreamCnt    = Seq->RxStreamCnt;
+   Payload->UntrackedCnt = Seq->UntrackedCnt;
+      
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(JMsgUdpApp.PeerStatsTlm.TelemetryHeader));
+   CFE_SB_TransmitMsg(CFE_MSG_PTR(JMsgUdpApp.PeerStatsTlm.TelemetryHeader), true);
+
+} /* End SendPeerStatsPkt() */
+
+
+/******************************************************************************
+** Function: SendLzStatsPkt
+**
+*/
+static void SendLzStatsPkt(void)
+{
+   
+   JMSG_UDP_LzStatsTlm_Payload_t *Payload = &JMsgUdpApp.LzStatsTlm.Payload;
+   const JMSG_LZ_Class_t *Lz = &JMsgUdpApp.JMsgUdp.Lz;
+   const JMSG_LZ_Topic_t *Topic;
+   uint16 i;
+
+   memset(Payload, 0, sizeof(JMSG_UDP_LzStatsTlm_Payload_t));
+   
+   for (i=0; i < Lz->TopicCnt; i++)
+   {
+      Topic = &Lz->Topic[i];
+      strncpy(Payload->Topic[i].Topic, Topic->Name, sizeof(Payload->Topic[i].Topic) - 1);
+      Payload->Topic[i].MsgCnt        = Topic->Stats.MsgCnt;
+      Payload->Topic[i].SkipCnt       = Topic->Stats.SkipCnt;
+      Payload->Topic[i].RawBytes      = Topic->Stats.RawBytes;
+      Payload->Topic[i].ZipBytes      = Topic->Stats.ZipBytes;
+      Payload->Topic[i].RatioPerMille = JMSG_LZ_RatioPerMille(&Topic->Stats);
+   }
+   Payload->TopicCnt = i;
+      
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(JMsgUdpApp.LzStatsTlm.TelemetryHeader));
+   CFE_SB_TransmitMsg(CFE_MSG_PTR(JMsgUdpApp.LzStatsTlm.TelemetryHeader), true);
+
+} /* End SendLzStatsPkt() */
+
+
+/******************************************************************************
+** Function: SendSbStatsPkt
+**
+*/
+static void SendSbStatsPkt(void)
+{
+   
+   JMSG_UDP_SbStatsTlm_Payload_t *Payload = &JMsgUdpApp.SbStatsTlm.Payload;
+   const JMSG_SBQ_Class_t *Sbq = &JMsgUdpApp.JMsgUdp.Sbq;
+   const JMSG_SBQ_Topic_t *Topic;
+   uint16 i;
+
+   memset(Payload, 0, sizeof(JMSG_UDP_SbStatsTlm_Payload_t));
+   
+   for (i=0; i < Sbq->TopicCnt; i++)
+   {
+      Topic = &Sbq->Topic[i];
+      Payload->Topic[i].MsgId       = Topic->MsgId;
+      Payload->Topic[i].MsgCnt      = Topic->MsgCnt;
+      Payload->Topic[i].OverflowCnt = Topic->OverflowCnt;
+      Payload->Topic[i].HighWater   = Topic->HighWater;
+   }
+   Payload->TopicCnt      = i;
+   Payload->PipeDepth     = JMsgUdpApp.JMsgUdp.Config.JMsgPipeDepth;
+   Payload->PipeQueued    = Sbq->PipeQueued;
+   Payload->PipeHighWater = Sbq->PipeHighWater;
+   Payload->DefMsgLim     = JMsgUdpApp.JMsgUdp.Config.JMsgPipeMsgLim;
+   Payload->OverflowCnt   = Sbq->OverflowCnt;
+   Payload->UntrackedCnt  = Sbq->UntrackedCnt;
+      
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(JMsgUdpApp.SbStatsTlm.TelemetryHeader));
+   CFE_SB_TransmitMsg(CFE_MSG_PTR(JMsgUdpApp.SbStatsTlm.TelemetryHeader), true);
+
+} /* End SendSbStatsPkt() */
+
+
+/******************************************************************************
+** Function: SendSelfTestPkt
+**
+** Notes:
+**   1. Sent once when a self-test ends.
+**
+*/
+static void SendSelfTestPkt(void)
+{
+   
+   JMSG_UDP_SelfTestTlm_Payload_t *Payload = &JMsgUdpApp.SelfTestTlm.Payload;
+   const JMSG_SELFTEST_Result_t *Result = &JMsgUdpApp.JMsgUdp.SelfTest.Result;
+
+   Payload->MsgId        = Result->MsgId;
+   Payload->MsgCnt       = Result->MsgCnt;
+   Payload->PayloadLen   = Result->PayloadLen;
+   Payload->SentCnt      = Result->SentCnt;
+   Payload->RecvCnt      = Result->RecvCnt;
+   Payload->LostCnt      = Result->LostCnt;
+   Payload->TxErrCnt     = Result->TxErrCnt;
+   Payload->RxErrCnt     = Result->RxErrCnt;
+   Payload->ElapsedUs    = Result->ElapsedUs;
+   Payload->MsgPerSec    = Result->MsgPerSec;
+   Payload->LatencyMinUs = Result->LatencyMinUs;
+   Payload->LatencyP50Us = Result->LatencyP50Us;
+   Payload->LatencyP90Us = Result->LatencyP90Us;
+   Payload->LatencyP99Us = Result->LatencyP99Us;
+   Payload->LatencyMaxUs = Result->LatencyMaxUs;
+      
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(JMsgUdpApp.SelfTestTlm.TelemetryHeader));
+   CFE_SB_TransmitMsg(CFE_MSG_PTR(JMsgUdpApp.SelfTestTlm.TelemetryHeader), true);
+
+} /* End SendSelfTestPkt() */
+
+
 /******************************************************************************
 ** Function: SendStatusPkt
 **
@@ -311,16 +682,86 @@ void SendStatusPkt(void)
    */
 
    Payload->RxUdpConnected  = JMsgUdpApp.JMsgUdp.Rx.Connected;
+   Payload->RxKernelTime    = JMsgUdpApp.JMsgUdp.Rx.Sock.KernelTime;
    Payload->RxUdpMsgCnt     = JMsgUdpApp.JMsgUdp.Rx.MsgCnt;
    Payload->RxUdpMsgErrCnt  = JMsgUdpApp.JMsgUdp.Rx.MsgErrCnt;
-   Payload->ValidJMsgCnt    = JMsgUdpApp.JMsgUdp.JMsgTrans.ValidJMsgCnt;
-   Payload->InvalidJMsgCnt  = JMsgUdpApp.JMsgUdp.JMsgTrans.InvalidJMsgCnt;
+   Payload->RxMaxProcTime   = JMsgUdpApp.JMsgUdp.Rx.MaxProcTime;
+   Payload->RxSlowMsgCnt    = JMsgUdpApp.JMsgUdp.Rx.SlowMsgCnt;
+   Payload->ValidJMsgCnt    = JMsgUdpApp.JMsgUdp.JMsgTrans.RxCtx.ValidJMsgCnt;
+   Payload->InvalidJMsgCnt  = JMsgUdpApp.JMsgUdp.JMsgTrans.RxCtx.InvalidJMsgCnt;
+   Payload->ShapeHitCnt     = JMsgUdpApp.JMsgUdp.JMsgTrans.RxCtx.Shape.HitCnt;
+   Payload->ShapeMissCnt    = JMsgUdpApp.JMsgUdp.JMsgTrans.RxCtx.Shape.MissCnt;
+   JMSG_DECODE_AddRxCnt(&Payload->ValidJMsgCnt, &Payload->InvalidJMsgCnt,
+                        &Payload->ShapeHitCnt, &Payload->ShapeMissCnt);
    
    Payload->TxUdpConnected  = JMsgUdpApp.JMsgUdp.Tx.Connected;
    Payload->TxUdpMsgCnt     = JMsgUdpApp.JMsgUdp.Tx.MsgCnt;
    Payload->TxUdpMsgErrCnt  = JMsgUdpApp.JMsgUdp.Tx.MsgErrCnt;
    Payload->ValidSbMsgCnt   = JMsgUdpApp.JMsgUdp.JMsgTrans.ValidSbMsgCnt;
    Payload->InvalidSbMsgCnt = JMsgUdpApp.JMsgUdp.JMsgTrans.InvalidSbMsgCnt;
+   Payload->TmplSbMsgCnt    = JMsgUdpApp.JMsgUdp.JMsgTrans.TmplSbMsgCnt;
+   Payload->FilterSbMsgCnt  = JMsgUdpApp.JMsgUdp.JMsgTrans.FilterSbMsgCnt;
+   Payload->RouteCnt        = JMSG_ROUTE_TBL_GetRouteCnt();
+   Payload->ReconfigCnt     = JMsgUdpApp.JMsgUdp.ReconfigCnt;
+
+   Payload->DupJMsgCnt      = JMsgUdpApp.JMsgUdp.JMsgTrans.DupJMsgCnt;
+   Payload->SeqLostCnt      = JMsgUdpApp.JMsgUdp.JMsgTrans.Seq.Total.LostCnt;
+   Payload->SeqReorderCnt   = JMsgUdpApp.JMsgUdp.JMsgTrans.Seq.Total.ReorderCnt;
+   Payload->SeqLossPerMille = JMSG_SEQ_LossPerMille(&JMsgUdpApp.JMsgUdp.JMsgTrans.Seq.Total);
+
+   Payload->RelPendingCnt   = JMsgUdpApp.JMsgUdp.Rel.PendingCnt;
+   Payload->RelRetryCnt     = JMsgUdpApp.JMsgUdp.Rel.RetryCnt;
+   Payload->RelFailCnt      = JMsgUdpApp.JMsgUdp.Rel.FailCnt + JMsgUdpApp.JMsgUdp.Rel.WindowFullCnt;
+   Payload->RelAckRxCnt     = JMsgUdpApp.JMsgUdp.Rel.AckRxCnt;
+   Payload->RelAckTxCnt     = JMsgUdpApp.JMsgUdp.Rel.AckTxCnt;
+
+   Payload->FragTxMsgCnt     = JMsgUdpApp.JMsgUdp.Frag.TxMsgCnt;
+   Payload->FragTxErrCnt     = JMsgUdpApp.JMsgUdp.Frag.TxErrCnt;
+   Payload->FragRxMsgCnt     = JMsgUdpApp.JMsgUdp.Frag.RxMsgCnt;
+   Payload->FragRxDropCnt    = JMsgUdpApp.JMsgUdp.Frag.RxDropCnt + JMsgUdpApp.JMsgUdp.Frag.RxTimeoutCnt;
+   Payload->FragRxPendingCnt = JMsgUdpApp.JMsgUdp.Frag.RxPendingCnt;
+
+   Payload->LzTxMsgCnt      = JMsgUdpApp.JMsgUdp.Lz.Total.MsgCnt;
+   Payload->LzTxSkipCnt     = JMsgUdpApp.JMsgUdp.Lz.Total.SkipCnt;
+   Payload->LzRatioPerMille = JMSG_LZ_RatioPerMille(&JMsgUdpApp.JMsgUdp.Lz.Total);
+   Payload->LzRxMsgCnt      = JMsgUdpApp.JMsgUdp.Lz.RxMsgCnt;
+   Payload->LzRxErrCnt      = JMsgUdpApp.JMsgUdp.Lz.RxErrCnt;
+   
+   Payload->CapActive   = JMsgUdpApp.JMsgUdp.Cap.Active;
+   Payload->CapRxRecCnt = JMsgUdpApp.JMsgUdp.Cap.Stream[JMSG_CAP_DIR_RX].RecCnt;
+   Payload->CapTxRecCnt = JMsgUdpApp.JMsgUdp.Cap.Stream[JMSG_CAP_DIR_TX].RecCnt;
+   Payload->CapLostCnt  = JMsgUdpApp.JMsgUdp.Cap.Stream[JMSG_CAP_DIR_RX].LostCnt +
+                          JMsgUdpApp.JMsgUdp.Cap.Stream[JMSG_CAP_DIR_TX].LostCnt;
+   
+   Payload->LocalUnixTxCnt = JMsgUdpApp.JMsgUdp.Local.UnixTxCnt;
+   Payload->LocalShmTxCnt  = JMsgUdpApp.JMsgUdp.Local.ShmTxCnt;
+   Payload->LocalDropCnt   = JMsgUdpApp.JMsgUdp.Local.DropCnt;
+   
+   Payload->IoUring         = (JMsgUdpApp.JMsgUdp.Rx.Sock.Uring != NULL || JMsgUdpApp.JMsgUdp.Tx.Uring != NULL);
+   Payload->IoUringEnterCnt = 0;
+   Payload->IoUringTxErrCnt = 0;
+   if (JMsgUdpApp.JMsgUdp.Rx.Sock.Uring != NULL)
+   {
+      Payload->IoUringEnterCnt = JMsgUdpApp.JMsgUdp.Rx.Sock.Uring->Ring.EnterCnt;
+   }
+   if (JMsgUdpApp.JMsgUdp.Tx.Uring != NULL)
+   {
+      Payload->IoUringEnterCnt += JMsgUdpApp.JMsgUdp.Tx.Uring->Ring.EnterCnt;
+      Payload->IoUringTxErrCnt  = JMsgUdpApp.JMsgUdp.Tx.Uring->ErrCnt;
+   }
+   
+   Payload->JMsgPipeQueued    = JMsgUdpApp.JMsgUdp.Sbq.PipeQueued;
+   Payload->JMsgPipeHighWater = JMsgUdpApp.JMsgUdp.Sbq.PipeHighWater;
+   Payload->SbOverflowCnt     = JMsgUdpApp.JMsgUdp.Sbq.OverflowCnt;
+   
+   Payload->LvcTopicCnt = JMsgUdpApp.JMsgUdp.Lvc.SlotCnt;
+   Payload->LvcQueryCnt = JMsgUdpApp.JMsgUdp.Lvc.QueryCnt;
+   Payload->LvcReplyCnt = JMsgUdpApp.JMsgUdp.Lvc.ReplyCnt;
+   Payload->LvcMissCnt  = JMsgUdpApp.JMsgUdp.Lvc.MissCnt;
+   Payload->LvcSkipCnt  = JMsgUdpApp.JMsgUdp.Lvc.TooLongCnt + JMsgUdpApp.JMsgUdp.Lvc.FullCnt;
+   Payload->LvcRejectCnt = JMsgUdpApp.JMsgUdp.Lvc.RejectCnt;
+   
+   Payload->Mem = JMsgUdpApp.MemReport;
       
    CFE_SB_TimeStampMsg(CFE_MSG_PTR(JMsgUdpApp.StatusTlm.TelemetryHeader));
    CFE_SB_TransmitMsg(CFE_MSG_PTR(JMsgUdpApp.StatusTlm.TelemetryHeader), true);
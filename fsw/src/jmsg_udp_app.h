@@ -46,6 +46,7 @@
 #define JMSG_UDP_APP_NOOP_EID          (JMSG_UDP_APP_BASE_EID + 1)
 #define JMSG_UDP_APP_EXIT_EID          (JMSG_UDP_APP_BASE_EID + 2)
 #define JMSG_UDP_APP_INVALID_MID_EID   (JMSG_UDP_APP_BASE_EID + 3)
+#define JMSG_UDP_APP_MEM_REPORT_EID    (JMSG_UDP_APP_BASE_EID + 4)
 
 
 /**********************/
@@ -76,6 +77,7 @@ typedef struct
    INITBL_Class_t    IniTbl; 
    CFE_SB_PipeId_t   CmdPipe;
    CMDMGR_Class_t    CmdMgr;
+   TBLMGR_Class_t    TblMgr;
    CHILDMGR_Class_t  RxChildMgr;
    CHILDMGR_Class_t  TxChildMgr;
       
@@ -83,7 +85,13 @@ typedef struct
    ** Telemetry Packets
    */
    
-   JMSG_UDP_StatusTlm_t   StatusTlm;
+   JMSG_UDP_StatusTlm_t     StatusTlm;
+   JMSG_UDP_ExtStatusTlm_t  ExtStatusTlm;
+   JMSG_UDP_PeerStatsTlm_t  PeerStatsTlm;
+   JMSG_UDP_LzStatsTlm_t    LzStatsTlm;
+   JMSG_UDP_SbStatsTlm_t    SbStatsTlm;
+   JMSG_UDP_SelfTestTlm_t   SelfTestTlm;
+   JMSG_UDP_DecodeStatsTlm_t  DecodeStatsTlm;
 
    
    /*
@@ -92,6 +100,13 @@ typedef struct
    
    uint32 PerfId;
    
+   bool   SingleTaskMode;
+   int32  SingleTaskWaitMs;
+   uint16 SingleTaskMsgLim;
+   bool   SingleTaskBusy;     /* The previous pass hit a message limit */
+   
+   JMSG_UDP_MemReport_t MemReport;  /* Loaded at initialization */
+   
    CFE_SB_MsgId_t  CmdMid;
    CFE_SB_MsgId_t  SendStatusMid;
    CFE_SB_MsgId_t  TopicSubTlmMid;
@@ -0,0 +1,935 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Receive and send datagrams with io_uring
+**
+** Notes:
+**   1. See jmsg_uring.h
+**   2. The queue indices are shared with the kernel. A submission is
+**      published with a release store of the SQ tail and a completion is
+**      read after an acquire load of the CQ tail.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <string.h>
+
+#include "jmsg_uring.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(IORING_RECV_MULTISHOT) && defined(__NR_io_uring_setup)
+#define JMSG_URING_NATIVE
+#endif
+#endif
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define ALIGN_UP(Len, Align)  (((Len) + (Align) - 1) & ~((size_t)(Align) - 1))
+
+#define RX_BUF_GROUP     0
+#define RX_CANCEL_DATA   0xFFFF   /* user_data of cancel requests */
+#define CLOSE_WAIT_MS    100
+#define CLOSE_WAIT_LIM   10
+#define TX_SLOT_WAIT_MS  100
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+#ifdef JMSG_URING_NATIVE
+
+/* A Tx slot's header is followed by its datagram */
+typedef struct
+{
+
+   struct msghdr       Hdr;
+   struct iovec        Iov;
+   struct sockaddr_in  Addr;
+
+} TxSlotHdr_t;
+
+#endif
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+#ifdef JMSG_URING_NATIVE
+static void ArmRx(JMSG_URING_Rx_t *Rx, uint16 Sock);
+static int Enter(JMSG_URING_Ring_t *Ring, uint32 WaitCnt, int32 Timeout);
+static struct io_uring_sqe *GetSqe(JMSG_URING_Ring_t *Ring);
+static bool IsQueued(const JMSG_URING_Ring_t *Ring);
+static struct io_uring_cqe *PeekCqe(JMSG_URING_Ring_t *Ring);
+static void PutRxBuf(JMSG_URING_Rx_t *Rx, uint16 BufId);
+static void ReapTx(JMSG_URING_Tx_t *Tx);
+static void ReleaseRing(JMSG_URING_Ring_t *Ring);
+static void SeenCqe(JMSG_URING_Ring_t *Ring);
+static bool SetupRing(JMSG_URING_Ring_t *Ring, uint32 SqEntries, uint32 CqEntries);
+static int32 TakeRxCqe(JMSG_URING_Rx_t *Rx, void *Buf, size_t BufLen, JMSG_URING_RxMeta_t *Meta);
+#endif
+
+
+/******************************************************************************
+** Function: JMSG_URING_CloseRx
+**
+** Notes:
+**   1. The kernel writes the buffers until the multishot receives end so
+**      they're cancelled and their final completions reaped before the
+**      buffers are unmapped.
+**
+*/
+void JMSG_URING_CloseRx(JMSG_URING_Rx_t *Rx)
+{
+
+#ifdef JMSG_URING_NATIVE
+
+   struct io_uring_sqe *Sqe;
+   struct io_uring_cqe *Cqe;
+   size_t MapLen = Rx->MapLen;
+   uint16 Wait;
+   uint16 i;
+
+   for (i=0; i < JMSG_URING_SOCK_CNT; i++)
+   {
+      if (Rx->Armed[i] && (Sqe = GetSqe(&Rx->Ring)) != NULL)
+      {
+         Sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+         Sqe->addr      = i;
+         Sqe->user_data = RX_CANCEL_DATA;
+      }
+   }
+
+   for (Wait=0; (Rx->Armed[0] || Rx->Armed[1]) && Wait < CLOSE_WAIT_LIM; Wait++)
+   {
+      Enter(&Rx->Ring, 1, CLOSE_WAIT_MS);
+      while ((Cqe = PeekCqe(&Rx->Ring)) != NULL)
+      {
+         if (Cqe->user_data < JMSG_URING_SOCK_CNT && (Cqe->flags & IORING_CQE_F_MORE) == 0)
+         {
+            Rx->Armed[Cqe->user_data] = false;
+         }
+         SeenCqe(&Rx->Ring);
+      }
+   }
+
+   ReleaseRing(&Rx->Ring);
+   munmap(Rx, MapLen);
+
+#endif
+
+} /* End JMSG_URING_CloseRx() */
+
+
+/******************************************************************************
+** Function: JMSG_URING_CloseTx
+**
+*/
+void JMSG_URING_CloseTx(JMSG_URING_Tx_t *Tx)
+{
+
+#ifdef JMSG_URING_NATIVE
+
+   size_t MapLen = Tx->MapLen;
+   uint16 Wait;
+
+   JMSG_URING_Flush(Tx);
+   for (Wait=0; Tx->FreeCnt < Tx->SlotCnt && Wait < CLOSE_WAIT_LIM; Wait++)
+   {
+      Enter(&Tx->Ring, 1, CLOSE_WAIT_MS);
+      ReapTx(Tx);
+   }
+
+   ReleaseRing(&Tx->Ring);
+   close(Tx->SockFd);
+   munmap(Tx, MapLen);
+
+#endif
+
+} /* End JMSG_URING_CloseTx() */
+
+
+/******************************************************************************
+** Function: JMSG_URING_Flush
+**
+*/
+void JMSG_URING_Flush(JMSG_URING_Tx_t *Tx)
+{
+
+#ifdef JMSG_URING_NATIVE
+
+   if (IsQueued(&Tx->Ring))
+   {
+      Enter(&Tx->Ring, 0, 0);
+   }
+   ReapTx(Tx);
+
+#endif
+
+} /* End JMSG_URING_Flush() */
+
+
+/******************************************************************************
+** Function: JMSG_URING_OpenRx
+**
+** Notes:
+**   1. The mapping holds the object, a receive template for each socket,
+**      the page aligned buffer ring and the buffers. A buffer holds the
+**      kernel's io_uring_recvmsg_out header, the sender address, the
+**      timestamp control message and the datagram.
+**   2. Unix domain sender addresses aren't used so their template has no
+**      name or control space.
+**
+*/
+JMSG_URING_Rx_t *JMSG_URING_OpenRx(int UdpFd, int LocalFd, uint16 Depth,
+                                   uint32 DatagramLen, bool KernelTime)
+{
+
+#ifdef JMSG_URING_NATIVE
+
+   JMSG_URING_Rx_t *Rx;
+   struct io_uring_buf_reg Reg;
+   struct msghdr *MsgHdr;
+   uint8  *Map;
+   size_t PageLen = (size_t)sysconf(_SC_PAGESIZE);
+   size_t BufLen;
+   size_t HdrLen;
+   size_t RingOffset;
+   size_t BufOffset;
+   size_t MapLen;
+   uint16 i;
+
+   if (Depth < JMSG_URING_DEPTH_MIN || (Depth & (Depth - 1)) != 0)
+   {
+      return NULL;
+   }
+
+   BufLen     = ALIGN_UP(sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in) +
+                         CMSG_SPACE(sizeof(struct timespec)) + DatagramLen, 64);
+   HdrLen     = ALIGN_UP(sizeof(JMSG_URING_Rx_t), 64);
+   RingOffset = ALIGN_UP(HdrLen + JMSG_URING_SOCK_CNT*sizeof(struct msghdr), PageLen);
+   BufOffset  = RingOffset + ALIGN_UP(Depth*sizeof(struct io_uring_buf), PageLen);
+   MapLen     = BufOffset + Depth*BufLen;
+
+   Map = mmap(NULL, MapLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (Map == MAP_FAILED)
+   {
+      return NULL;
+   }
+
+   /* The anonymous mapping is zero filled */
+   Rx = (JMSG_URING_Rx_t *)Map;
+   Rx->SockFd[0] = UdpFd;
+   Rx->SockFd[1] = LocalFd;
+   Rx->MsgHdr    = &Map[HdrLen];
+   Rx->BufRing   = &Map[RingOffset];
+   Rx->Buf       = &Map[BufOffset];
+   Rx->BufLen    = BufLen;
+   Rx->BufCnt    = Depth;
+   Rx->MapLen    = MapLen;
+
+   /* Each buffer in use can have a completion posted */
+   if (!SetupRing(&Rx->Ring, 2*JMSG_URING_SOCK_CNT, 2*Depth))
+   {
+      munmap(Map, MapLen);
+      return NULL;
+   }
+
+   memset(&Reg, 0, sizeof(Reg));
+   Reg.ring_addr    = (uint64)(uintptr_t)Rx->BufRing;
+   Reg.ring_entries = Depth;
+   Reg.bgid         = RX_BUF_GROUP;
+   if (syscall(__NR_io_uring_register, Rx->Ring.Fd, IORING_REGISTER_PBUF_RING, &Reg, 1) != 0)
+   {
+      ReleaseRing(&Rx->Ring);
+      munmap(Map, MapLen);
+      return NULL;
+   }
+   for (i=0; i < Depth; i++)
+   {
+      PutRxBuf(Rx, i);
+   }
+
+   MsgHdr = Rx->MsgHdr;
+   MsgHdr[0].msg_namelen    = sizeof(struct sockaddr_in);
+   MsgHdr[0].msg_controllen = (KernelTime ? CMSG_SPACE(sizeof(struct timespec)) : 0);
+
+   for (i=0; i < JMSG_URING_SOCK_CNT; i++)
+   {
+      if (Rx->SockFd[i] >= 0)
+      {
+         ArmRx(Rx, i);
+      }
+   }
+   if (Enter(&Rx->Ring, 0, 0) < 0)
+   {
+      ReleaseRing(&Rx->Ring);
+      munmap(Map, MapLen);
+      return NULL;
+   }
+
+   return Rx;
+
+#else
+
+   return NULL;
+
+#endif
+
+} /* End JMSG_URING_OpenRx() */
+
+
+/******************************************************************************
+** Function: JMSG_URING_OpenTx
+**
+** Notes:
+**   1. Each slot's message header is built once and a send only fills in
+**      the datagram, its length and the destination.
+**
+*/
+JMSG_URING_Tx_t *JMSG_URING_OpenTx(uint16 Depth, uint32 DatagramLen)
+{
+
+#ifdef JMSG_URING_NATIVE
+
+   JMSG_URING_Tx_t *Tx;
+   TxSlotHdr_t *Slot;
+   uint8  *Map;
+   size_t SlotLen;
+   size_t HdrLen;
+   size_t MapLen;
+   uint16 i;
+
+   if (Depth < JMSG_URING_DEPTH_MIN || (Depth & (Depth - 1)) != 0)
+   {
+      return NULL;
+   }
+
+   SlotLen = ALIGN_UP(sizeof(TxSlotHdr_t) + DatagramLen, 64);
+   HdrLen  = ALIGN_UP(sizeof(JMSG_URING_Tx_t) + Depth*sizeof(uint16), 64);
+   MapLen  = HdrLen + Depth*SlotLen;
+
+   Map = mmap(NULL, MapLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (Map == MAP_FAILED)
+   {
+      return NULL;
+   }
+
+   Tx = (JMSG_URING_Tx_t *)Map;
+   Tx->FreeSlot = (uint16 *)&Map[sizeof(JMSG_URING_Tx_t)];
+   Tx->Slot     = &Map[HdrLen];
+   Tx->SlotLen  = SlotLen;
+   Tx->SlotCnt  = Depth;
+   Tx->MapLen   = MapLen;
+
+   Tx->SockFd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+   if (Tx->SockFd < 0)
+   {
+      munmap(Map, MapLen);
+      return NULL;
+   }
+   if (!SetupRing(&Tx->Ring, Depth, 2*Depth))
+   {
+      close(Tx->SockFd);
+      munmap(Map, MapLen);
+      return NULL;
+   }
+
+   for (i=0; i < Depth; i++)
+   {
+      Slot = (TxSlotHdr_t *)&Tx->Slot[i*SlotLen];
+      Slot->Addr.sin_family = AF_INET;
+      Slot->Iov.iov_base    = &Slot[1];
+      Slot->Hdr.msg_name    = &Slot->Addr;
+      Slot->Hdr.msg_namelen = sizeof(Slot->Addr);
+      Slot->Hdr.msg_iov     = &Slot->Iov;
+      Slot->Hdr.msg_iovlen  = 1;
+      Tx->FreeSlot[Tx->FreeCnt++] = Depth - 1 - i;
+   }
+
+   return Tx;
+
+#else
+
+   return NULL;
+
+#endif
+
+} /* End JMSG_URING_OpenTx() */
+
+
+/******************************************************************************
+** Function: JMSG_URING_Recv
+**
+** Notes:
+**   1. A completion that doesn't carry a datagram, e.g. the end of a
+**      multishot receive, is consumed and the receive continues. The wait
+**      isn't repeated so a timed receive can return OS_ERROR_TIMEOUT early.
+**
+*/
+int32 JMSG_URING_Recv(JMSG_URING_Rx_t *Rx, void *Buf, size_t BufLen, int32 Timeout,
+                      JMSG_URING_RxMeta_t *Meta)
+{
+
+#ifdef JMSG_URING_NATIVE
+
+   int32  Status;
+   int    Ret;
+   bool   Waited = false;
+   uint16 i;
+
+   while (true)
+   {
+      for (i=0; i < JMSG_URING_SOCK_CNT; i++)
+      {
+         if (Rx->SockFd[i] >= 0 && !Rx->Armed[i])
+         {
+            ArmRx(Rx, i);
+            Rx->RearmCnt++;
+         }
+      }
+
+      if (PeekCqe(&Rx->Ring) != NULL)
+      {
+         Status = TakeRxCqe(Rx, Buf, BufLen, Meta);
+         if (Status != OS_ERROR_TIMEOUT)
+         {
+            return Status;
+         }
+      }
+      else if (Waited || (Timeout == OS_CHECK && !IsQueued(&Rx->Ring)))
+      {
+         return OS_ERROR_TIMEOUT;
+      }
+      else
+      {
+         Ret = Enter(&Rx->Ring, (Timeout == OS_CHECK ? 0 : 1), Timeout);
+         if (Ret < 0 && Ret != -ETIME && Ret != -EINTR)
+         {
+            return OS_ERROR;
+         }
+         Waited = true;
+      }
+   }
+
+#else
+
+   return OS_ERROR;
+
+#endif
+
+} /* End JMSG_URING_Recv() */
+
+
+/******************************************************************************
+** Function: JMSG_URING_Send
+**
+*/
+bool JMSG_URING_Send(JMSG_URING_Tx_t *Tx, const char *Msg, uint16 MsgLen,
+                     uint32 PeerAddr, uint16 PeerPort)
+{
+
+#ifdef JMSG_URING_NATIVE
+
+   TxSlotHdr_t *Slot;
+   struct io_uring_sqe *Sqe;
+   uint16 SlotIdx;
+
+   if (sizeof(TxSlotHdr_t) + MsgLen > Tx->SlotLen)
+   {
+      return false;
+   }
+
+   ReapTx(Tx);
+   if (Tx->FreeCnt == 0)
+   {
+      /* Submit the queue and wait for a send to complete */
+      Enter(&Tx->Ring, 1, TX_SLOT_WAIT_MS);
+      ReapTx(Tx);
+      if (Tx->FreeCnt == 0)
+      {
+         return false;
+      }
+   }
+
+   /* Every slot in use has at most one entry so the queue can't be full */
+   Sqe = GetSqe(&Tx->Ring);
+   if (Sqe == NULL)
+   {
+      return false;
+   }
+
+   SlotIdx = Tx->FreeSlot[--Tx->FreeCnt];
+   Slot    = (TxSlotHdr_t *)&Tx->Slot[SlotIdx*Tx->SlotLen];
+   memcpy(&Slot[1], Msg, MsgLen);
+   Slot->Iov.iov_len          = MsgLen;
+   Slot->Addr.sin_addr.s_addr = htonl(PeerAddr);
+   Slot->Addr.sin_port        = htons(PeerPort);
+
+   Sqe->opcode    = IORING_OP_SENDMSG;
+   Sqe->fd        = Tx->SockFd;
+   Sqe->addr      = (uint64)(uintptr_t)&Slot->Hdr;
+   Sqe->len       = 1;
+   Sqe->user_data = SlotIdx;
+
+   return true;
+
+#else
+
+   return false;
+
+#endif
+
+} /* End JMSG_URING_Send() */
+
+
+#ifdef JMSG_URING_NATIVE
+/******************************************************************************
+** Function: ArmRx
+**
+** Queue a multishot receive that selects buffers from the buffer ring.
+**
+*/
+static void ArmRx(JMSG_URING_Rx_t *Rx, uint16 Sock)
+{
+
+   struct io_uring_sqe *Sqe = GetSqe(&Rx->Ring);
+
+   if (Sqe != NULL)
+   {
+      Sqe->opcode    = IORING_OP_RECVMSG;
+      Sqe->fd        = Rx->SockFd[Sock];
+      Sqe->addr      = (uint64)(uintptr_t)&((struct msghdr *)Rx->MsgHdr)[Sock];
+      Sqe->len       = 1;
+      Sqe->ioprio    = IORING_RECV_MULTISHOT;
+      Sqe->flags     = IOSQE_BUFFER_SELECT;
+      Sqe->buf_group = RX_BUF_GROUP;
+      Sqe->user_data = Sock;
+      Rx->Armed[Sock] = true;
+   }
+
+} /* End ArmRx() */
+
+
+/******************************************************************************
+** Function: Enter
+**
+** Submit the queued entries and optionally wait for WaitCnt completions.
+**
+** Notes:
+**   1. Timeout is in milliseconds, a negative timeout waits forever.
+**   2. Returns the number of entries submitted or a negative errno.
+**
+*/
+static int Enter(JMSG_URING_Ring_t *Ring, uint32 WaitCnt, int32 Timeout)
+{
+
+   struct io_uring_getevents_arg Arg;
+   struct __kernel_timespec      Ts;
+   uint32 SubmitCnt;
+   uint32 Flags  = 0;
+   void   *ArgPtr = NULL;
+   size_t ArgLen = 0;
+   long   Ret;
+
+   __atomic_store_n(Ring->SqTail, Ring->SqLocalTail, __ATOMIC_RELEASE);
+   SubmitCnt = Ring->SqLocalTail - __atomic_load_n(Ring->SqHead, __ATOMIC_ACQUIRE);
+
+   if (WaitCnt > 0)
+   {
+      Flags |= IORING_ENTER_GETEVENTS;
+      if (Timeout >= 0)
+      {
+         Ts.tv_sec  = Timeout / 1000;
+         Ts.tv_nsec = (Timeout % 1000) * 1000000LL;
+         memset(&Arg, 0, sizeof(Arg));
+         Arg.ts  = (uint64)(uintptr_t)&Ts;
+         Flags  |= IORING_ENTER_EXT_ARG;
+         ArgPtr  = &Arg;
+         ArgLen  = sizeof(Arg);
+      }
+   }
+
+   Ring->EnterCnt++;
+   Ret = syscall(__NR_io_uring_enter, Ring->Fd, SubmitCnt, WaitCnt, Flags, ArgPtr, ArgLen);
+
+   return (Ret < 0 ? -errno : (int)Ret);
+
+} /* End Enter() */
+
+
+/******************************************************************************
+** Function: GetSqe
+**
+** Return the next submission queue entry cleared or NULL if the queue is
+** full.
+**
+*/
+static struct io_uring_sqe *GetSqe(JMSG_URING_Ring_t *Ring)
+{
+
+   struct io_uring_sqe *Sqe;
+
+   if (Ring->SqLocalTail - __atomic_load_n(Ring->SqHead, __ATOMIC_ACQUIRE) >= Ring->SqEntries)
+   {
+      return NULL;
+   }
+
+   Sqe = &((struct io_uring_sqe *)Ring->Sqes)[Ring->SqLocalTail & Ring->SqMask];
+   memset(Sqe, 0, sizeof(struct io_uring_sqe));
+   Ring->SqLocalTail++;
+
+   return Sqe;
+
+} /* End GetSqe() */
+
+
+/******************************************************************************
+** Function: IsQueued
+**
+** Return true if entries are waiting to be submitted.
+**
+*/
+static bool IsQueued(const JMSG_URING_Ring_t *Ring)
+{
+
+   return (Ring->SqLocalTail != __atomic_load_n(Ring->SqHead, __ATOMIC_ACQUIRE));
+
+} /* End IsQueued() */
+
+
+/******************************************************************************
+** Function: PeekCqe
+**
+** Return the oldest posted completion or NULL.
+**
+*/
+static struct io_uring_cqe *PeekCqe(JMSG_URING_Ring_t *Ring)
+{
+
+   uint32 Head = *Ring->CqHead;
+
+   if (Head == __atomic_load_n(Ring->CqTail, __ATOMIC_ACQUIRE))
+   {
+      return NULL;
+   }
+
+   return &((struct io_uring_cqe *)Ring->Cqes)[Head & Ring->CqMask];
+
+} /* End PeekCqe() */
+
+
+/******************************************************************************
+** Function: PutRxBuf
+**
+** Give a receive buffer to the kernel.
+**
+*/
+static void PutRxBuf(JMSG_URING_Rx_t *Rx, uint16 BufId)
+{
+
+   struct io_uring_buf_ring *BufRing = Rx->BufRing;
+   struct io_uring_buf      *RingBuf = &BufRing->bufs[Rx->BufTail & (Rx->BufCnt - 1)];
+
+   RingBuf->addr = (uint64)(uintptr_t)&Rx->Buf[BufId*Rx->BufLen];
+   RingBuf->len  = Rx->BufLen;
+   RingBuf->bid  = BufId;
+
+   Rx->BufTail++;
+   __atomic_store_n(&BufRing->tail, Rx->BufTail, __ATOMIC_RELEASE);
+
+} /* End PutRxBuf() */
+
+
+/******************************************************************************
+** Function: ReapTx
+**
+** Free the slots of completed sends.
+**
+*/
+static void ReapTx(JMSG_URING_Tx_t *Tx)
+{
+
+   struct io_uring_cqe *Cqe;
+
+   while ((Cqe = PeekCqe(&Tx->Ring)) != NULL)
+   {
+      if (Cqe->res < 0)
+      {
+         Tx->ErrCnt++;
+      }
+      else
+      {
+         Tx->SendCnt++;
+      }
+      Tx->FreeSlot[Tx->FreeCnt++] = (uint16)Cqe->user_data;
+      SeenCqe(&Tx->Ring);
+   }
+
+} /* End ReapTx() */
+
+
+/******************************************************************************
+** Function: ReleaseRing
+**
+** Unmap the queues and close the ring. Handles a partially set up ring.
+**
+*/
+static void ReleaseRing(JMSG_URING_Ring_t *Ring)
+{
+
+   if (Ring->Sqes != NULL)
+   {
+      munmap(Ring->Sqes, Ring->SqesLen);
+   }
+   if (Ring->CqMap != NULL && Ring->CqMap != Ring->SqMap)
+   {
+      munmap(Ring->CqMap, Ring->CqMapLen);
+   }
+   if (Ring->SqMap != NULL)
+   {
+      munmap(Ring->SqMap, Ring->SqMapLen);
+   }
+   close(Ring->Fd);
+
+   Ring->Sqes  = NULL;
+   Ring->CqMap = NULL;
+   Ring->SqMap = NULL;
+   Ring->Fd    = -1;
+
+} /* End ReleaseRing() */
+
+
+/******************************************************************************
+** Function: SeenCqe
+**
+** Return the oldest completion's entry to the kernel.
+**
+*/
+static void SeenCqe(JMSG_URING_Ring_t *Ring)
+{
+
+   __atomic_store_n(Ring->CqHead, *Ring->CqHead + 1, __ATOMIC_RELEASE);
+
+} /* End SeenCqe() */
+
+
+/******************************************************************************
+** Function: SetupRing
+**
+** Create an io_uring and map its queues.
+**
+** Notes:
+**   1. Rings without IORING_FEAT_EXT_ARG are rejected because timed waits
+**      need it.
+**   2. The SQ array is loaded once with the identity mapping so entries
+**      are submitted in the order they're filled.
+**
+*/
+static bool SetupRing(JMSG_URING_Ring_t *Ring, uint32 SqEntries, uint32 CqEntries)
+{
+
+   struct io_uring_params Params;
+   uint8  *Sq;
+   uint8  *Cq;
+   void   *Map;
+   uint32 i;
+
+   memset(Ring, 0, sizeof(JMSG_URING_Ring_t));
+   memset(&Params, 0, sizeof(Params));
+   Params.flags      = IORING_SETUP_CQSIZE;
+   Params.cq_entries = CqEntries;
+
+   Ring->Fd = (int)syscall(__NR_io_uring_setup, SqEntries, &Params);
+   if (Ring->Fd < 0)
+   {
+      return false;
+   }
+   if ((Params.features & IORING_FEAT_EXT_ARG) == 0)
+   {
+      ReleaseRing(Ring);
+      return false;
+   }
+
+   Ring->SqMapLen = Params.sq_off.array + Params.sq_entries*sizeof(uint32);
+   Ring->CqMapLen = Params.cq_off.cqes + Params.cq_entries*sizeof(struct io_uring_cqe);
+   Ring->SqesLen  = Params.sq_entries*sizeof(struct io_uring_sqe);
+   if ((Params.features & IORING_FEAT_SINGLE_MMAP) && Ring->CqMapLen > Ring->SqMapLen)
+   {
+      Ring->SqMapLen = Ring->CqMapLen;
+   }
+
+   Map = mmap(NULL, Ring->SqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+              Ring->Fd, IORING_OFF_SQ_RING);
+   if (Map == MAP_FAILED)
+   {
+      ReleaseRing(Ring);
+      return false;
+   }
+   Ring->SqMap = Map;
+
+   if (Params.features & IORING_FEAT_SINGLE_MMAP)
+   {
+      Ring->CqMap = Ring->SqMap;
+   }
+   else
+   {
+      Map = mmap(NULL, Ring->CqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 Ring->Fd, IORING_OFF_CQ_RING);
+      if (Map == MAP_FAILED)
+      {
+         ReleaseRing(Ring);
+         return false;
+      }
+      Ring->CqMap = Map;
+   }
+
+   Map = mmap(NULL, Ring->SqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+              Ring->Fd, IORING_OFF_SQES);
+   if (Map == MAP_FAILED)
+   {
+      ReleaseRing(Ring);
+      return false;
+   }
+   Ring->Sqes = Map;
+
+   Sq = Ring->SqMap;
+   Cq = Ring->CqMap;
+   Ring->SqEntries = Params.sq_entries;
+   Ring->SqMask    = *(uint32 *)&Sq[Params.sq_off.ring_mask];
+   Ring->SqHead    = (uint32 *)&Sq[Params.sq_off.head];
+   Ring->SqTail    = (uint32 *)&Sq[Params.sq_off.tail];
+   Ring->SqArray   = (uint32 *)&Sq[Params.sq_off.array];
+   Ring->CqMask    = *(uint32 *)&Cq[Params.cq_off.ring_mask];
+   Ring->CqHead    = (uint32 *)&Cq[Params.cq_off.head];
+   Ring->CqTail    = (uint32 *)&Cq[Params.cq_off.tail];
+   Ring->Cqes      = &Cq[Params.cq_off.cqes];
+
+   for (i=0; i < Ring->SqEntries; i++)
+   {
+      Ring->SqArray[i] = i;
+   }
+   Ring->SqLocalTail = *Ring->SqTail;
+
+   return true;
+
+} /* End SetupRing() */
+
+
+/******************************************************************************
+** Function: TakeRxCqe
+**
+** Consume the oldest completion and copy its datagram to Buf.
+**
+** Notes:
+**   1. Returns the datagram length, OS_ERROR for a failed receive or
+**      OS_ERROR_TIMEOUT for a completion without a datagram. A receive that
+**      ended because every buffer was in use isn't an error.
+**
+*/
+static int32 TakeRxCqe(JMSG_URING_Rx_t *Rx, void *Buf, size_t BufLen, JMSG_URING_RxMeta_t *Meta)
+{
+
+   struct io_uring_cqe *Cqe = PeekCqe(&Rx->Ring);
+   struct io_uring_recvmsg_out *Out;
+   const struct msghdr *Tmpl;
+   struct msghdr       Control;
+   struct cmsghdr      *Cmsg;
+   struct sockaddr_in  *Name;
+   struct timespec     KernelTime;
+   uint8  *Payload;
+   uint64 Sock   = Cqe->user_data;
+   int32  Res    = Cqe->res;
+   uint32 Flags  = Cqe->flags;
+   int32  Status = OS_ERROR_TIMEOUT;
+   uint16 BufId;
+   size_t Len;
+
+   SeenCqe(&Rx->Ring);
+
+   if (Sock >= JMSG_URING_SOCK_CNT)
+   {
+      return OS_ERROR_TIMEOUT;
+   }
+   if ((Flags & IORING_CQE_F_MORE) == 0)
+   {
+      Rx->Armed[Sock] = false;
+   }
+
+   if (Flags & IORING_CQE_F_BUFFER)
+   {
+      BufId = (uint16)(Flags >> IORING_CQE_BUFFER_SHIFT);
+      if (Res >= 0)
+      {
+         Tmpl = &((const struct msghdr *)Rx->MsgHdr)[Sock];
+         Out  = (struct io_uring_recvmsg_out *)&Rx->Buf[BufId*Rx->BufLen];
+         Name = (struct sockaddr_in *)&Out[1];
+
+         memset(&Control, 0, sizeof(Control));
+         Control.msg_control    = (uint8 *)&Out[1] + Tmpl->msg_namelen;
+         Control.msg_controllen = Out->controllen;
+         Payload = (uint8 *)Control.msg_control + Tmpl->msg_controllen;
+
+         /* A truncated datagram's length is its length before truncation */
+         Len = Rx->BufLen - (Payload - (uint8 *)Out);
+         Len = (Out->payloadlen < Len ? Out->payloadlen : Len);
+         Len = (Len < BufLen ? Len : BufLen);
+         memcpy(Buf, Payload, Len);
+
+         memset(Meta, 0, sizeof(JMSG_URING_RxMeta_t));
+         Meta->Local = (Sock == 1);
+         if (!Meta->Local && Out->namelen >= sizeof(struct sockaddr_in))
+         {
+            Meta->PeerAddr = ntohl(Name->sin_addr.s_addr);
+            Meta->PeerPort = ntohs(Name->sin_port);
+         }
+         for (Cmsg = CMSG_FIRSTHDR(&Control); Cmsg != NULL; Cmsg = CMSG_NXTHDR(&Control, Cmsg))
+         {
+            if (Cmsg->cmsg_level == SOL_SOCKET && Cmsg->cmsg_type == SCM_TIMESTAMPNS)
+            {
+               memcpy(&KernelTime, CMSG_DATA(Cmsg), sizeof(KernelTime));
+               Meta->KernelTimeNs = (int64)KernelTime.tv_sec*1000000000LL + KernelTime.tv_nsec;
+               break;
+            }
+         }
+         Status = (int32)Len;
+      }
+      PutRxBuf(Rx, BufId);
+   }
+   else if (Res < 0 && Res != -ENOBUFS && Res != -ECANCELED)
+   {
+      Status = OS_ERROR;
+   }
+
+   return Status;
+
+} /* End TakeRxCqe() */
+#endif /* JMSG_URING_NATIVE */
@@ -0,0 +1,253 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Receive and send datagrams with io_uring
+**
+** Notes:
+**   1. io_uring is an optional Linux I/O engine selected by IO_ENGINE in
+**      the INI file. The socket paths in jmsg_sock.c and jmsg_udp.c are the
+**      portable engine and are used when io_uring isn't available. The
+**      rings are driven with the raw system calls so there's no library
+**      dependency.
+**   2. Rx: a multishot receive is submitted once for each socket. The
+**      kernel receives each datagram into a buffer it takes from a buffer
+**      ring registered with the io_uring and posts a completion. Posted
+**      completions are consumed without a system call and io_uring_enter()
+**      is only called to wait when none are posted. A multishot receive
+**      that ends, e.g. when every buffer is in use, is resubmitted and the
+**      datagrams wait in the socket's queue meanwhile.
+**   3. Tx: each send is copied to a slot and queued as a sendmsg
+**      submission. Queued sends are submitted with one system call when
+**      the owner flushes them or every slot is in use, so a send's result
+**      is only known when its completion is reaped. Failed sends are
+**      counted.
+**   4. A ring has one submitter. An Rx ring is used by the task receiving
+**      from its socket and a Tx ring by one sending task, see jmsg_udp.c.
+**   5. Multishot recvmsg requires a 6.0 or later kernel. Opening a ring
+**      fails on older kernels and other targets.
+**
+*/
+#ifndef _jmsg_uring_
+#define _jmsg_uring_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define JMSG_URING_DEPTH_MIN  2
+#define JMSG_URING_SOCK_CNT   2   /* Rx UDP and Unix domain sockets */
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Submission and completion queues mapped from the kernel. Linux types are
+** kept in jmsg_uring.c so the pointers are untyped.
+*/
+
+typedef struct
+{
+
+   int     Fd;            /* io_uring file descriptor */
+   uint32  SqEntries;
+   uint32  SqMask;
+   uint32  SqLocalTail;   /* Next entry to fill, published on submit */
+   uint32  *SqHead;
+   uint32  *SqTail;
+   uint32  *SqArray;
+   void    *Sqes;
+   uint32  CqMask;
+   uint32  *CqHead;
+   uint32  *CqTail;
+   void    *Cqes;
+
+   void    *SqMap;
+   size_t  SqMapLen;
+   void    *CqMap;        /* Same as SqMap for a single mapping */
+   size_t  CqMapLen;
+   size_t  SqesLen;
+
+   uint32  EnterCnt;      /* io_uring_enter() calls */
+
+} JMSG_URING_Ring_t;
+
+
+/*
+** Datagram received by JMSG_URING_Recv()
+*/
+
+typedef struct
+{
+
+   bool    Local;          /* Received from the Unix domain socket */
+   uint32  PeerAddr;       /* UDP sender */
+   uint16  PeerPort;
+   int64   KernelTimeNs;   /* CLOCK_REALTIME receive time, zero if not requested */
+
+} JMSG_URING_RxMeta_t;
+
+
+/*
+** The Rx and Tx objects are created at the start of an anonymous mapping
+** that also holds their buffers. The kernel keeps addresses of the
+** buffers so they can't move or be allocated from the arena.
+*/
+
+typedef struct
+{
+
+   JMSG_URING_Ring_t  Ring;
+
+   int     SockFd[JMSG_URING_SOCK_CNT];  /* -1 if unused */
+   bool    Armed[JMSG_URING_SOCK_CNT];   /* Multishot receive active */
+   void    *MsgHdr;                      /* Receive templates, one per socket */
+   void    *BufRing;
+   uint8   *Buf;
+   uint32  BufLen;
+   uint16  BufCnt;
+   uint16  BufTail;
+   size_t  MapLen;
+
+   uint32  RearmCnt;   /* Multishot receives resubmitted */
+
+} JMSG_URING_Rx_t;
+
+
+typedef struct
+{
+
+   JMSG_URING_Ring_t  Ring;
+
+   int     SockFd;
+   uint8   *Slot;
+   uint32  SlotLen;
+   uint16  SlotCnt;
+   uint16  FreeCnt;
+   uint16  *FreeSlot;   /* Stack of free slot indices */
+   size_t  MapLen;
+
+   uint32  SendCnt;     /* Sends that completed */
+   uint32  ErrCnt;      /* Sends that completed with an error */
+
+} JMSG_URING_Tx_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: JMSG_URING_CloseRx
+**
+** Cancel the receives and release the ring. The sockets aren't closed.
+**
+*/
+void JMSG_URING_CloseRx(JMSG_URING_Rx_t *Rx);
+
+
+/******************************************************************************
+** Function: JMSG_URING_CloseTx
+**
+** Submit queued sends, release the ring and close the Tx socket.
+**
+*/
+void JMSG_URING_CloseTx(JMSG_URING_Tx_t *Tx);
+
+
+/******************************************************************************
+** Function: JMSG_URING_Flush
+**
+** Submit the queued sends and reap completed sends without waiting.
+**
+*/
+void JMSG_URING_Flush(JMSG_URING_Tx_t *Tx);
+
+
+/******************************************************************************
+** Function: JMSG_URING_OpenRx
+**
+** Create an Rx ring that receives from a UDP socket and an optional Unix
+** domain socket.
+**
+** Notes:
+**   1. Depth is the number of receive buffers and must be a power of 2.
+**      Each buffer holds a datagram of DatagramLen bytes.
+**   2. KernelTime requests the SO_TIMESTAMPNS control message that must be
+**      enabled on the UDP socket.
+**   3. Returns NULL if io_uring or multishot receives aren't supported.
+**
+*/
+JMSG_URING_Rx_t *JMSG_URING_OpenRx(int UdpFd, int LocalFd, uint16 Depth,
+                                   uint32 DatagramLen, bool KernelTime);
+
+
+/******************************************************************************
+** Function: JMSG_URING_OpenTx
+**
+** Create a Tx ring with Depth slots of DatagramLen bytes and an unbound
+** UDP socket to send from.
+**
+** Notes:
+**   1. Returns NULL if io_uring isn't supported.
+**
+*/
+JMSG_URING_Tx_t *JMSG_URING_OpenTx(uint16 Depth, uint32 DatagramLen);
+
+
+/******************************************************************************
+** Function: JMSG_URING_Recv
+**
+** Receive one datagram.
+**
+** Notes:
+**   1. Timeout follows OSAL conventions: OS_PEND, OS_CHECK or milliseconds.
+**      OS_CHECK never enters the kernel unless a receive must be
+**      resubmitted.
+**   2. Datagrams from the UDP and Unix domain sockets are returned in
+**      arrival order.
+**   3. Returns the datagram length, OS_ERROR_TIMEOUT if no datagram
+**      arrived or OS_ERROR. A datagram longer than BufLen is truncated.
+**
+*/
+int32 JMSG_URING_Recv(JMSG_URING_Rx_t *Rx, void *Buf, size_t BufLen, int32 Timeout,
+                      JMSG_URING_RxMeta_t *Meta);
+
+
+/******************************************************************************
+** Function: JMSG_URING_Send
+**
+** Queue a datagram to an IPv4 address and port.
+**
+** Notes:
+**   1. Returns false if the datagram is longer than a slot or no slot is
+**      free after waiting for a completion.
+**
+*/
+bool JMSG_URING_Send(JMSG_URING_Tx_t *Tx, const char *Msg, uint16 MsgLen,
+                     uint32 PeerAddr, uint16 PeerPort);
+
+
+#endif /* _jmsg_uring_ */
@@ -26,6 +26,12 @@
 **          and subscribe to the message  
 **    3. JMSG_LIB plugins used by JMSG_UDP only need to be subscribed to because
 **       they've already been constructed.
+**    4. With DECODE_WORKER_CNT workers a plugin's JSON to SB converter is
+**       called from the worker tasks instead of the Rx task. Converter calls
+**       are serialized by one lock held until the returned message is sent,
+**       so plugins may share buffers and state with each other but must not
+**       share them with their SB to JSON converters, which run on the Tx task
+**       without the lock.
 */
 
 /*
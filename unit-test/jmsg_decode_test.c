@@ -0,0 +1,606 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for the decode worker queues
+**
+** Notes:
+**   1. The workers aren't run as tasks. The test calls the worker task
+**      callback to decode one queued entry and the decoder and capture
+**      functions are replaced by functions that check what's decoded.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdlib.h>
+
+#include "ut_jmsg.h"
+#include "jmsg_cap.h"
+#include "jmsg_decode.h"
+#include "jmsg_mem.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define TEST_DATAGRAM_LEN  128
+#define TEST_DEPTH         6
+#define TEST_WORKER_CNT    2
+#define TEST_OP_CNT        200000
+#define TEST_EXP_MAX       (TEST_DEPTH*TEST_WORKER_CNT)
+
+#define FIRST_TIME_US      1000000
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+/*
+** Expected decode of a queued payload. The topic and payload bytes are
+** generated from Seed.
+*/
+typedef struct
+{
+
+   uint32  Seed;
+   uint16  TopicLen;
+   uint16  PayloadLen;
+   uint16  CapLen;
+
+} Exp_t;
+
+
+typedef struct
+{
+
+   Exp_t   Exp[TEST_EXP_MAX];
+   uint16  Head;
+   uint16  Cnt;
+
+} ExpQueue_t;
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static INITBL_Class_t       IniTbl;
+static JMSG_MEM_Class_t     Mem;
+static JMSG_DECODE_Class_t  Decode;
+
+static char  Topic[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN];
+static char  Payload[0x10000];
+static char  CapData[TEST_DATAGRAM_LEN];
+
+static ExpQueue_t  ExpQueue[TEST_WORKER_CNT];
+static uint16      DecodeWorker;   /* Worker being run by RunWorker() */
+static uint32      DecodeErrCnt;
+static uint32      CapCnt;
+static uint32      CapMsgId;
+
+static uint16      ChildStartLim;  /* Child tasks started before a start fails */
+static uint16      ChildCnt;       /* Child tasks started and not deleted */
+
+
+/******************************************************************************
+** Function: FillBytes
+**
+*/
+static void FillBytes(char *Buf, uint16 Len, uint32 Seed)
+{
+
+   uint16 i;
+
+   for (i=0; i < Len; i++)
+   {
+      Buf[i] = (char)('a' + (Seed + i*7) % 26);
+   }
+
+} /* End FillBytes() */
+
+
+/******************************************************************************
+** Function: CheckBytes
+**
+*/
+static bool CheckBytes(const char *Buf, uint16 Len, uint32 Seed)
+{
+
+   char Exp[JMSG_UDP_BUF_LEN];
+
+   FillBytes(Exp, Len, Seed);
+
+   return (memcmp(Buf, Exp, Len) == 0);
+
+} /* End CheckBytes() */
+
+
+/******************************************************************************
+** Function: MsgIdOf
+**
+** SB message ID the fake decoder gives a payload.
+**
+*/
+static uint32 MsgIdOf(uint32 Seed)
+{
+
+   return 0x0800 + (Seed & 0xFF);
+
+} /* End MsgIdOf() */
+
+
+/******************************************************************************
+** Fake translator functions
+**
+*/
+void JMSG_TRANS_InitRxCtx(JMSG_TRANS_RxCtx_t *RxCtx)
+{
+   memset(RxCtx, 0, sizeof(JMSG_TRANS_RxCtx_t));
+}
+
+void JMSG_TRANS_ResetRxCtx(JMSG_TRANS_RxCtx_t *RxCtx)
+{
+   RxCtx->ValidJMsgCnt = 0;
+}
+
+void JMSG_TRANS_CreateConvLock(void)
+{
+}
+
+
+/******************************************************************************
+** Function: JMSG_TRANS_DecodeJMsg
+**
+** Check the payload is the oldest one submitted to the running worker.
+**
+*/
+bool JMSG_TRANS_DecodeJMsg(JMSG_TRANS_RxCtx_t *RxCtx, const JMSG_SOCK_RxInfo_t *RxInfo,
+                           const JMSG_HDR_Attr_t *HdrAttr, const char *Topic,
+                           const char *Payload, uint16 PayloadLen)
+{
+
+   ExpQueue_t *Queue = &ExpQueue[DecodeWorker];
+   const Exp_t *Exp  = &Queue->Exp[Queue->Head];
+
+   if (Queue->Cnt == 0 || HdrAttr->TopicLen != Exp->TopicLen || PayloadLen != Exp->PayloadLen ||
+       RxInfo->PeerPort != (uint16)Exp->Seed || !CheckBytes(Topic, Exp->TopicLen, Exp->Seed) ||
+       !CheckBytes(Payload, PayloadLen, Exp->Seed + 1))
+   {
+      DecodeErrCnt++;
+   }
+
+   RxCtx->ValidJMsgCnt++;
+   RxCtx->RxMsgId = MsgIdOf(Exp->Seed);
+
+   return true;
+
+} /* End JMSG_TRANS_DecodeJMsg() */
+
+
+/******************************************************************************
+** Function: JMSG_CAP_Rx
+**
+** Check a worker captures the datagram of the payload it just decoded.
+**
+*/
+void JMSG_CAP_Rx(const char *Data, uint16 DataLen, const JMSG_SOCK_RxInfo_t *RxInfo,
+                 uint32 MsgId)
+{
+
+   const ExpQueue_t *Queue = &ExpQueue[DecodeWorker];
+   const Exp_t *Exp = &Queue->Exp[Queue->Head];
+
+   CapCnt++;
+   CapMsgId = MsgId;
+   if (DataLen != Exp->CapLen || MsgId != MsgIdOf(Exp->Seed) || !CheckBytes(Data, DataLen, Exp->Seed + 2))
+   {
+      DecodeErrCnt++;
+   }
+
+} /* End JMSG_CAP_Rx() */
+
+
+/******************************************************************************
+** Fake child manager and task functions
+**
+** A child task's ID is one more than the number of tasks running when it's
+** started.
+*/
+int32 CHILDMGR_Constructor(CHILDMGR_Class_t *ChildMgr, void (*ChildTaskMainFunc)(void),
+                           CHILDMGR_TaskCallback_t TaskCallback, CHILDMGR_TaskInit_t *TaskInit)
+{
+   if (ChildCnt >= ChildStartLim)
+   {
+      return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+   }
+   ChildMgr->TaskId = ++ChildCnt;
+   return CFE_SUCCESS;
+}
+
+int32 CFE_ES_DeleteChildTask(CFE_ES_TaskId_t TaskId)
+{
+   /* Tasks are deleted newest first */
+   if (TaskId == ChildCnt)
+   {
+      ChildCnt--;
+   }
+   return CFE_SUCCESS;
+}
+
+void ChildMgr_TaskMainCallback(void)
+{
+}
+
+void CHILDMGR_ResetStatus(CHILDMGR_Class_t *ChildMgr)
+{
+}
+
+
+/******************************************************************************
+** Function: Construct
+**
+*/
+static void Construct(uint32 WorkerCnt, uint32 QueueLen)
+{
+
+   UT_SetIniInt(CFG_DATAGRAM_LEN, TEST_DATAGRAM_LEN);
+   UT_SetIniInt(CFG_FRAG_CNT, 2);
+   UT_SetIniInt(CFG_DECODE_WORKER_CNT, WorkerCnt);
+   UT_SetIniInt(CFG_DECODE_QUEUE_DEPTH, TEST_DEPTH);
+   UT_SetIniInt(CFG_DECODE_QUEUE_LEN, QueueLen);
+
+   JMSG_MEM_Constructor(&Mem, &IniTbl);
+   JMSG_DECODE_Constructor(&Decode, &IniTbl);
+
+   memset(ExpQueue, 0, sizeof(ExpQueue));
+   DecodeErrCnt  = 0;
+   CapCnt        = 0;
+   ChildStartLim = TEST_WORKER_CNT;
+   ChildCnt      = 0;
+
+} /* End Construct() */
+
+
+/******************************************************************************
+** Function: Submit
+**
+** Submit a payload generated from Seed and expect it to be decoded if it's
+** queued.
+**
+*/
+static JMSG_DECODE_Submit_t Submit(uint32 Seed, uint16 TopicLen, uint16 PayloadLen, uint16 CapLen)
+{
+
+   JMSG_SOCK_RxInfo_t RxInfo = { .PeerAddr = 1, .PeerPort = (uint16)Seed };
+   JMSG_HDR_Attr_t    HdrAttr;
+   JMSG_DECODE_Submit_t Status;
+   ExpQueue_t *Queue;
+   Exp_t      *Exp;
+   uint16 PrevQueued[TEST_WORKER_CNT];
+   uint16 i;
+
+   memset(&HdrAttr, 0, sizeof(HdrAttr));
+   HdrAttr.TopicLen = TopicLen;
+   FillBytes(Topic, TopicLen, Seed);
+   FillBytes(Payload, PayloadLen, Seed + 1);
+   FillBytes(CapData, CapLen, Seed + 2);
+
+   /* Find the topic's worker from the queue counts */
+   for (i=0; i < Decode.WorkerCnt; i++)
+   {
+      PrevQueued[i] = Decode.Worker[i].Queued;
+   }
+
+   Status = JMSG_DECODE_Submit(&RxInfo, &HdrAttr, Topic, Payload, PayloadLen,
+                               (CapLen > 0 ? CapData : NULL), CapLen);
+
+   for (i=0; i < Decode.WorkerCnt && Status == JMSG_DECODE_QUEUED; i++)
+   {
+      if (Decode.Worker[i].Queued != PrevQueued[i])
+      {
+         Queue = &ExpQueue[i];
+         Exp   = &Queue->Exp[(Queue->Head + Queue->Cnt) % TEST_EXP_MAX];
+         Exp->Seed       = Seed;
+         Exp->TopicLen   = TopicLen;
+         Exp->PayloadLen = PayloadLen;
+         Exp->CapLen     = CapLen;
+         Queue->Cnt++;
+      }
+   }
+
+   return Status;
+
+} /* End Submit() */
+
+
+/******************************************************************************
+** Function: RunWorker
+**
+** Decode one entry of a worker's queue.
+**
+*/
+static void RunWorker(uint16 WorkerIdx)
+{
+
+   ExpQueue_t *Queue = &ExpQueue[WorkerIdx];
+
+   DecodeWorker = WorkerIdx;
+   JMSG_DECODE_WorkerTask(&Decode.Worker[WorkerIdx].ChildMgr);
+
+   Queue->Head = (Queue->Head + 1) % TEST_EXP_MAX;
+   Queue->Cnt--;
+
+} /* End RunWorker() */
+
+
+/******************************************************************************
+** Function: RingValid
+**
+** Check a worker's ring indices are consistent with its queued entries.
+**
+*/
+static bool RingValid(const JMSG_DECODE_Worker_t *Worker)
+{
+
+   bool Valid = (Worker->Queued <= Decode.QueueDepth && Worker->Head <= Decode.QueueLen &&
+                 Worker->Tail <= Decode.QueueLen && Worker->WrapAt <= Decode.QueueLen);
+
+   if (Worker->Queued == 0)
+   {
+      Valid = Valid && Worker->Head == 0 && Worker->Tail == 0;
+   }
+   else if (Worker->Head < Worker->Tail)
+   {
+      Valid = Valid && Worker->Tail < Worker->WrapAt;
+   }
+   else
+   {
+      Valid = Valid && Worker->Head > Worker->Tail && Worker->WrapAt == Decode.QueueLen;
+   }
+
+   return Valid;
+
+} /* End RingValid() */
+
+
+/******************************************************************************
+** Function: TestInline
+**
+** Payloads are decoded by the caller until the workers are started and
+** with no workers.
+**
+*/
+static void TestInline(void)
+{
+
+   Construct(TEST_WORKER_CNT, 0);
+   UT_ASSERT(Decode.WorkerCnt == TEST_WORKER_CNT);
+   UT_ASSERT(Submit(1, 4, 4, 0) == JMSG_DECODE_INLINE);
+
+   Construct(0, 0);
+   UT_ASSERT(JMSG_DECODE_StartWorkers(&IniTbl));
+   UT_ASSERT(Submit(1, 4, 4, 0) == JMSG_DECODE_INLINE);
+
+   /* The ring holds the longest message and datagram */
+   Construct(1, 64);
+   UT_ASSERT(Decode.QueueLen >= sizeof(JMSG_DECODE_Entry_t) + JMSG_PLATFORM_TOPIC_NAME_MAX_LEN +
+                                3*TEST_DATAGRAM_LEN);
+   UT_ASSERT(Decode.QueueLen % sizeof(uint64) == 0);
+
+} /* End TestInline() */
+
+
+/******************************************************************************
+** Function: TestStartFail
+**
+** Workers already started are deleted when a worker fails to start and
+** payloads stay on the caller.
+**
+*/
+static void TestStartFail(void)
+{
+
+   Construct(TEST_WORKER_CNT, 0);
+   ChildStartLim = TEST_WORKER_CNT - 1;
+   UT_ASSERT(!JMSG_DECODE_StartWorkers(&IniTbl));
+   UT_ASSERT(ChildCnt == 0 && UT_EventCnt(JMSG_DECODE_START_EID) == 1);
+   UT_ASSERT(Submit(1, 4, 4, 0) == JMSG_DECODE_INLINE);
+
+   Construct(TEST_WORKER_CNT, 0);
+   UT_ASSERT(JMSG_DECODE_StartWorkers(&IniTbl));
+   UT_ASSERT(ChildCnt == TEST_WORKER_CNT);
+
+} /* End TestStartFail() */
+
+
+/******************************************************************************
+** Function: TestMalformed
+**
+** Empty topics and payloads are queued, entries longer than the ring are
+** dropped and the longest entry fits an empty queue.
+**
+*/
+static void TestMalformed(void)
+{
+
+   Construct(1, 0);
+   UT_ASSERT(JMSG_DECODE_StartWorkers(&IniTbl));
+
+   UT_ASSERT(Submit(1, 0, 0, 0) == JMSG_DECODE_QUEUED);
+   UT_ASSERT(Submit(2, 0, 5, 0) == JMSG_DECODE_QUEUED);
+   UT_ASSERT(Submit(3, 5, 0, 3) == JMSG_DECODE_QUEUED);
+   RunWorker(0);
+   RunWorker(0);
+   RunWorker(0);
+   UT_ASSERT(DecodeErrCnt == 0 && CapCnt == 1 && CapMsgId == MsgIdOf(3));
+   UT_ASSERT(Decode.Worker[0].MsgCnt == 3 && RingValid(&Decode.Worker[0]));
+
+   UT_ASSERT(Submit(4, JMSG_PLATFORM_TOPIC_NAME_MAX_LEN - 1, 2*TEST_DATAGRAM_LEN,
+                    TEST_DATAGRAM_LEN) == JMSG_DECODE_QUEUED);
+   UT_ASSERT(Submit(5, 1, 1, 0) == JMSG_DECODE_FULL);
+   RunWorker(0);
+   UT_ASSERT(DecodeErrCnt == 0 && Decode.Worker[0].Queued == 0);
+
+   UT_ASSERT(Submit(6, 1, 0xFFFF, 0) == JMSG_DECODE_FULL);
+   UT_ASSERT(Decode.Worker[0].DropCnt == 2 && RingValid(&Decode.Worker[0]));
+
+} /* End TestMalformed() */
+
+
+/******************************************************************************
+** Function: TestWrap
+**
+** Random length payloads are decoded in order while the rings wrap. A
+** payload is only dropped when its queue is at its depth or its entry
+** doesn't fit.
+**
+*/
+static void TestWrap(void)
+{
+
+   JMSG_DECODE_Worker_t *Worker;
+   JMSG_DECODE_Submit_t  Status;
+   uint32 Op;
+   uint32 Seed = 0;
+   uint32 WrapCnt = 0;
+   uint32 FullCnt = 0;
+   uint32 ValidCnt = 0;
+   uint32 Valid = 0;
+   uint32 Dummy = 0;
+   uint16 TopicLen;
+   uint16 PayloadLen;
+   uint16 i;
+
+   Construct(TEST_WORKER_CNT, 1500);
+   UT_ASSERT(JMSG_DECODE_StartWorkers(&IniTbl));
+   srand(5);
+
+   for (Op=0; Op < TEST_OP_CNT; Op++)
+   {
+      if (rand() % 2)
+      {
+         TopicLen   = 1 + rand() % 8;
+         PayloadLen = (rand() % 4 == 0) ? rand() % (2*TEST_DATAGRAM_LEN) : rand() % 32;
+         Status     = Submit(++Seed, TopicLen, PayloadLen, (rand() % 2) ? rand() % TEST_DATAGRAM_LEN : 0);
+         FullCnt   += (Status == JMSG_DECODE_FULL);
+      }
+      else
+      {
+         i = rand() % TEST_WORKER_CNT;
+         if (ExpQueue[i].Cnt > 0)
+         {
+            RunWorker(i);
+         }
+      }
+      for (i=0; i < TEST_WORKER_CNT; i++)
+      {
+         Worker   = &Decode.Worker[i];
+         WrapCnt += (Worker->Head < Worker->Tail);
+         Valid   += RingValid(Worker);
+         Valid   += (Worker->Queued == ExpQueue[i].Cnt);
+      }
+   }
+   UT_ASSERT(Valid == 2*TEST_WORKER_CNT*TEST_OP_CNT);
+
+   for (i=0; i < TEST_WORKER_CNT; i++)
+   {
+      while (ExpQueue[i].Cnt > 0)
+      {
+         RunWorker(i);
+      }
+      UT_ASSERT(RingValid(&Decode.Worker[i]));
+   }
+
+   JMSG_DECODE_AddRxCnt(&ValidCnt, &Dummy, &Dummy, &Dummy);
+   UT_ASSERT(DecodeErrCnt == 0);
+   UT_ASSERT(ValidCnt == Decode.Worker[0].MsgCnt + Decode.Worker[1].MsgCnt);
+   UT_ASSERT(ValidCnt + Decode.Worker[0].DropCnt + Decode.Worker[1].DropCnt == Seed);
+   UT_ASSERT(WrapCnt > 0 && FullCnt > 0 && Decode.Worker[0].MsgCnt > 0 && Decode.Worker[1].MsgCnt > 0);
+   UT_ASSERT(Decode.Worker[0].HighWater == TEST_DEPTH);
+
+} /* End TestWrap() */
+
+
+/******************************************************************************
+** Function: TestDropEvents
+**
+** Drops are reported at most once per interval with the number dropped.
+**
+*/
+static void TestDropEvents(void)
+{
+
+   uint32 Seed = 0;
+   uint16 i;
+
+   Construct(1, 4096);
+   UT_ASSERT(JMSG_DECODE_StartWorkers(&IniTbl));
+   UT_SetTimeUs(FIRST_TIME_US);
+
+   for (i=0; i < TEST_DEPTH; i++)
+   {
+      UT_ASSERT(Submit(++Seed, 4, 4, 0) == JMSG_DECODE_QUEUED);
+   }
+   for (i=0; i < 100; i++)
+   {
+      Submit(++Seed, 4, 4, 0);
+   }
+   UT_ASSERT(Decode.Worker[0].DropCnt == 100 && UT_EventCnt(JMSG_DECODE_DROP_EID) == 1);
+
+   UT_SetTimeUs(FIRST_TIME_US + JMSG_DECODE_DROP_EVS_MS*1000 - 1);
+   Submit(++Seed, 4, 4, 0);
+   UT_ASSERT(UT_EventCnt(JMSG_DECODE_DROP_EID) == 1 && Decode.Worker[0].DropEvsCnt == 100);
+
+   UT_SetTimeUs(FIRST_TIME_US + JMSG_DECODE_DROP_EVS_MS*1000);
+   Submit(++Seed, 4, 4, 0);
+   UT_ASSERT(UT_EventCnt(JMSG_DECODE_DROP_EID) == 2 && Decode.Worker[0].DropEvsCnt == 0);
+
+   /* A clock that steps back doesn't silence drops */
+   UT_SetTimeUs(FIRST_TIME_US);
+   Submit(++Seed, 4, 4, 0);
+   UT_ASSERT(UT_EventCnt(JMSG_DECODE_DROP_EID) == 3);
+
+   /* Queued payloads don't send events */
+   RunWorker(0);
+   UT_SetTimeUs(FIRST_TIME_US + 4*JMSG_DECODE_DROP_EVS_MS*1000);
+   UT_ASSERT(Submit(++Seed, 4, 4, 0) == JMSG_DECODE_QUEUED);
+   UT_ASSERT(UT_EventCnt(JMSG_DECODE_DROP_EID) == 3 && Decode.Worker[0].DropCnt == 103);
+
+   JMSG_DECODE_ResetStatus();
+   UT_ASSERT(Decode.Worker[0].DropCnt == 0 && Decode.Worker[0].HighWater == TEST_DEPTH);
+
+} /* End TestDropEvents() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestInline);
+   UT_RUN(TestStartFail);
+   UT_RUN(TestMalformed);
+   UT_RUN(TestWrap);
+   UT_RUN(TestDropEvents);
+
+   return UT_Summary();
+
+} /* End main() */
@@ -0,0 +1,349 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for the Tx route filters
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "ut_jmsg.h"
+#include "jmsg_filter.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define TEST_MSG_ID   0x0801
+#define PAYLOAD_LEN   32
+#define FUZZ_CNT      100000
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_TMPL_Tmpl_t      Tmpl;
+static JMSG_FILTER_Filter_t  Filter;
+static JMSG_FILTER_Prev_t    Prev;
+
+/*
+** Payload fields: lux uint16 at 0, temp double at 8, delta int32 at 16,
+** mode uint8 at 20, count uint64 at 24
+*/
+static uint8 Payload[PAYLOAD_LEN];
+
+
+/******************************************************************************
+** Function: BuildTmpl
+**
+*/
+static void BuildTmpl(void)
+{
+
+   UT_ASSERT(JMSG_TMPL_Init(&Tmpl, "sensor", 6));
+   UT_ASSERT(JMSG_TMPL_AddField(&Tmpl, "lux", 3, JMSG_TMPL_TYPE_UINT16, 0, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(JMSG_TMPL_AddField(&Tmpl, "temp", 4, JMSG_TMPL_TYPE_DOUBLE, 8, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(JMSG_TMPL_AddField(&Tmpl, "delta", 5, JMSG_TMPL_TYPE_INT32, 16, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(JMSG_TMPL_AddField(&Tmpl, "mode", 4, JMSG_TMPL_TYPE_UINT8, 20, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(JMSG_TMPL_AddField(&Tmpl, "count", 5, JMSG_TMPL_TYPE_UINT64, 24, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(JMSG_TMPL_Finish(&Tmpl, 0, 0));
+
+} /* End BuildTmpl() */
+
+
+/******************************************************************************
+** Function: Compile
+**
+*/
+static bool Compile(const char *Expr)
+{
+
+   const char *ErrStr;
+   bool Valid = JMSG_FILTER_Compile(&Filter, Expr, strlen(Expr), &Tmpl, TEST_MSG_ID, &ErrStr);
+
+   memset(&Prev, 0, sizeof(Prev));
+
+   return Valid && ErrStr == NULL;
+
+} /* End Compile() */
+
+
+/******************************************************************************
+** Function: Eval
+**
+** Set the payload's fields and evaluate the compiled filter.
+**
+*/
+static bool Eval(uint16 Lux, double Temp, int32 Delta, uint8 Mode, uint64 Count)
+{
+
+   memcpy(&Payload[0], &Lux, sizeof(Lux));
+   memcpy(&Payload[8], &Temp, sizeof(Temp));
+   memcpy(&Payload[16], &Delta, sizeof(Delta));
+   memcpy(&Payload[20], &Mode, sizeof(Mode));
+   memcpy(&Payload[24], &Count, sizeof(Count));
+
+   return JMSG_FILTER_Eval(&Filter, &Prev, Payload, sizeof(Payload));
+
+} /* End Eval() */
+
+
+/******************************************************************************
+** Function: TestCompile
+**
+** Malformed expressions must be rejected with a reason.
+**
+*/
+static void TestCompile(void)
+{
+
+   static const char *Invalid[] =
+   {
+      "", " ", "lux", "lux >", "> 1", "lux 1", "lux => 1", "lux = 1", "lux ! 1",
+      "lux > 1 &", "lux > 1 & mode > 1", "lux > 1 && ", "lux > 1 && mode > 1 || temp > 1",
+      "lux > 1 mode > 1", "lux > 1 && mode > 1 && temp > 1 && delta > 1 && count > 1",
+      "bright > 1", "lux > abc", "lux > 1x", "lux > --1", "lux > 1e", "lux > nan",
+      "uint16@ > 1", "@4 > 1", "word@4 > 1", "uint16@65534 > 1", "uint8@-1 > 1",
+      "uint8@1234567 > 1", "uint8@4x > 1", "uint8@0x > 1", "lux > prevx", "lux > PREV"
+   };
+   const char *ErrStr;
+   char   Expr[JMSG_UDP_PLATFORM_FILTER_EXPR_MAX + 1];
+   uint32 Id;
+   uint16 i;
+
+   BuildTmpl();
+
+   for (i=0; i < sizeof(Invalid)/sizeof(Invalid[0]); i++)
+   {
+      if (!UT_ASSERT(!JMSG_FILTER_Compile(&Filter, Invalid[i], strlen(Invalid[i]), &Tmpl, TEST_MSG_ID, &ErrStr) &&
+                     ErrStr != NULL))
+      {
+         printf("Filter \"%s\" compiled\n", Invalid[i]);
+      }
+   }
+
+   /* Too long, and template keys need a template */
+   memset(Expr, ' ', sizeof(Expr));
+   memcpy(Expr, "lux > 1", 7);
+   UT_ASSERT(!JMSG_FILTER_Compile(&Filter, Expr, sizeof(Expr) - 1, &Tmpl, TEST_MSG_ID, &ErrStr));
+   UT_ASSERT(JMSG_FILTER_Compile(&Filter, Expr, sizeof(Expr) - 2, &Tmpl, TEST_MSG_ID, &ErrStr));
+   UT_ASSERT(!JMSG_FILTER_Compile(&Filter, "lux > 1", 7, NULL, TEST_MSG_ID, &ErrStr));
+
+   UT_ASSERT(Compile("lux>1&&mode<=2&&temp>=-1.5e3&&delta!=prev"));
+   UT_ASSERT(Filter.TermCnt == 4 && !Filter.Any && Filter.MinPayloadLen == 21);
+   UT_ASSERT(Compile("\tuint16@0x10 == 7 || double@0 < 1 || count >= 18446744073709551615"));
+   UT_ASSERT(Filter.Any && Filter.Term[0].Offset == 16 && Filter.MinPayloadLen == 32);
+   UT_ASSERT(Compile("uint8@65534 > 1"));
+
+   /* The same expression on another route has another ID */
+   UT_ASSERT(Compile("lux > 1"));
+   Id = Filter.Id;
+   UT_ASSERT(JMSG_FILTER_Compile(&Filter, "lux > 1", 7, &Tmpl, TEST_MSG_ID + 1, &ErrStr));
+   UT_ASSERT(Filter.Id != Id);
+
+} /* End TestCompile() */
+
+
+/******************************************************************************
+** Function: TestEval
+**
+** Fields are compared in their class unless the operand doesn't fit it.
+**
+*/
+static void TestEval(void)
+{
+
+   BuildTmpl();
+
+   UT_ASSERT(Compile("lux > 400 && mode == 2"));
+   UT_ASSERT(Eval(401, 0, 0, 2, 0) && !Eval(400, 0, 0, 2, 0) && !Eval(401, 0, 0, 3, 0));
+   UT_ASSERT(Compile("lux > 400 || mode == 2"));
+   UT_ASSERT(Eval(0, 0, 0, 2, 0) && Eval(500, 0, 0, 0, 0) && !Eval(0, 0, 0, 0, 0));
+
+   /* Operands outside the field class are compared as doubles */
+   UT_ASSERT(Compile("lux > -1"));
+   UT_ASSERT(Filter.Term[0].Class == JMSG_FILTER_CLASS_REAL && Eval(0, 0, 0, 0, 0));
+   UT_ASSERT(Compile("lux < 400.5"));
+   UT_ASSERT(Eval(400, 0, 0, 0, 0) && !Eval(401, 0, 0, 0, 0));
+   UT_ASSERT(Compile("lux >= -0"));
+   UT_ASSERT(Filter.Term[0].Class == JMSG_FILTER_CLASS_UINT && Eval(0, 0, 0, 0, 0));
+
+   /* Integer extremes compare exactly */
+   UT_ASSERT(Compile("count == 18446744073709551615"));
+   UT_ASSERT(Eval(0, 0, 0, 0, UINT64_MAX) && !Eval(0, 0, 0, 0, UINT64_MAX - 1));
+   UT_ASSERT(Compile("int64@24 == -9223372036854775808"));
+   UT_ASSERT(Filter.Term[0].Class == JMSG_FILTER_CLASS_INT);
+   UT_ASSERT(Eval(0, 0, 0, 0, (uint64)1 << 63) && !Eval(0, 0, 0, 0, ((uint64)1 << 63) + 1));
+   UT_ASSERT(Compile("delta < -2147483648"));
+   UT_ASSERT(!Eval(0, 0, INT32_MIN, 0, 0));
+   UT_ASSERT(Compile("int8@16 < 0"));
+   UT_ASSERT(Eval(0, 0, 0xFF, 0, 0));
+
+   /* A NaN is unequal to everything */
+   UT_ASSERT(Compile("temp == 0 || temp < 0 || temp > 0"));
+   UT_ASSERT(!Eval(0, NAN, 0, 0, 0) && Eval(0, -INFINITY, 0, 0, 0));
+   UT_ASSERT(Compile("temp != 1"));
+   UT_ASSERT(Eval(0, NAN, 0, 0, 0));
+
+   /* A payload too short for the fields passes */
+   UT_ASSERT(Compile("count == 1"));
+   UT_ASSERT(!JMSG_FILTER_Eval(&Filter, &Prev, Payload, sizeof(Payload)));
+   UT_ASSERT(JMSG_FILTER_Eval(&Filter, &Prev, Payload, sizeof(Payload) - 1));
+   UT_ASSERT(JMSG_FILTER_Eval(&Filter, &Prev, NULL, 0));
+
+} /* End TestEval() */
+
+
+/******************************************************************************
+** Function: TestPrev
+**
+** "prev" terms pass the first message and changes, including when a
+** counter wraps.
+**
+*/
+static void TestPrev(void)
+{
+
+   JMSG_FILTER_Prev_t OtherPrev;
+
+   BuildTmpl();
+
+   UT_ASSERT(Compile("lux != prev"));
+   UT_ASSERT(Eval(0xFFFE, 0, 0, 0, 0));
+   UT_ASSERT(!Eval(0xFFFE, 0, 0, 0, 0));
+   UT_ASSERT(Eval(0xFFFF, 0, 0, 0, 0));
+   UT_ASSERT(Eval(0, 0, 0, 0, 0));
+   UT_ASSERT(!Eval(0, 0, 0, 0, 0));
+
+   /* Values are saved whether or not the message passed */
+   UT_ASSERT(Compile("lux > prev && mode == 1"));
+   UT_ASSERT(!Eval(10, 0, 0, 0, 0));
+   UT_ASSERT(Eval(11, 0, 0, 1, 0));
+   UT_ASSERT(!Eval(5, 0, 0, 1, 0));
+   UT_ASSERT(Eval(6, 0, 0, 1, 0));
+
+   UT_ASSERT(Compile("delta < prev"));
+   UT_ASSERT(Eval(0, 0, INT32_MIN + 1, 0, 0));
+   UT_ASSERT(Eval(0, 0, INT32_MIN, 0, 0));
+   UT_ASSERT(!Eval(0, 0, INT32_MAX, 0, 0));
+
+   UT_ASSERT(Compile("temp != prev"));
+   UT_ASSERT(Eval(0, NAN, 0, 0, 0));
+   UT_ASSERT(Eval(0, NAN, 0, 0, 0));
+
+   /* A changed filter starts over */
+   UT_ASSERT(Compile("lux == prev"));
+   UT_ASSERT(Eval(1, 0, 0, 0, 0));
+   UT_ASSERT(!Eval(2, 0, 0, 0, 0));
+   OtherPrev = Prev;
+   UT_ASSERT(Compile("lux == prev || mode == 9"));
+   Prev = OtherPrev;
+   UT_ASSERT(Eval(3, 0, 0, 0, 0));
+   UT_ASSERT(Eval(3, 0, 0, 0, 0) && !Eval(4, 0, 0, 0, 0));
+
+} /* End TestPrev() */
+
+
+/******************************************************************************
+** Function: TestFuzz
+**
+** Random expressions must compile or fail with a reason and compiled
+** filters must only read their fields.
+**
+*/
+static void TestFuzz(void)
+{
+
+   static const char *Part[] =
+   {
+      "lux", "temp", "delta", "mode", "count", "uint8@", "int64@", "float@", "@", "0x", "31", "24",
+      "65535", " ", "\t", "==", "!=", "<", "<=", ">", ">=", "=", "!", "&&", "||", "&", "|",
+      "prev", "-", "1", "0.5", "1e308", "-1e-308", "18446744073709551616", "x", "\xFF"
+   };
+   const char *ErrStr;
+   char   Expr[JMSG_UDP_PLATFORM_FILTER_EXPR_MAX];
+   uint8  *Data;
+   uint16 ExprLen;
+   uint16 PartIdx;
+   uint16 PartLen;
+   uint16 DataLen;
+   uint32 CompileCnt = 0;
+   uint32 i;
+   uint16 j;
+
+   BuildTmpl();
+   memset(&Prev, 0, sizeof(Prev));
+
+   srand(47);
+   for (i=0; i < FUZZ_CNT; i++)
+   {
+      ExprLen = 0;
+      for (j = 1 + rand() % 12; j > 0; j--)
+      {
+         PartIdx = rand() % (sizeof(Part)/sizeof(Part[0]));
+         PartLen = strlen(Part[PartIdx]);
+         if (ExprLen + PartLen > sizeof(Expr))
+         {
+            break;
+         }
+         memcpy(&Expr[ExprLen], Part[PartIdx], PartLen);
+         ExprLen += PartLen;
+      }
+      if (!JMSG_FILTER_Compile(&Filter, Expr, ExprLen, &Tmpl, TEST_MSG_ID, &ErrStr))
+      {
+         if (!UT_ASSERT(ErrStr != NULL))
+         {
+            break;
+         }
+         continue;
+      }
+
+      CompileCnt++;
+      DataLen = Filter.MinPayloadLen;
+      Data = malloc(DataLen > 0 ? DataLen : 1);
+      for (j=0; j < DataLen; j++)
+      {
+         Data[j] = rand();
+      }
+      JMSG_FILTER_Eval(&Filter, &Prev, Data, DataLen);
+      free(Data);
+   }
+   UT_ASSERT(CompileCnt > 0);
+
+} /* End TestFuzz() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestCompile);
+   UT_RUN(TestEval);
+   UT_RUN(TestPrev);
+   UT_RUN(TestFuzz);
+
+   return UT_Summary();
+
+} /* End main() */
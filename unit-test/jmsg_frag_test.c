@@ -0,0 +1,367 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for JMSG fragmentation and reassembly
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include "ut_jmsg.h"
+#include "jmsg_frag.h"
+#include "jmsg_mem.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define TEST_DATAGRAM_LEN  64
+#define TEST_FRAG_CNT      8
+#define TEST_POOL_CNT      2
+#define TEST_TIMEOUT_MS    500
+
+#define SENT_MAX      16
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static INITBL_Class_t     IniTbl;
+static JMSG_MEM_Class_t   Mem;
+static JMSG_FRAG_Class_t  Frag;
+
+static JMSG_SOCK_RxInfo_t Peer;
+
+static uint16 SentCnt;
+static uint16 SentLen[SENT_MAX];
+static char   Sent[SENT_MAX][TEST_DATAGRAM_LEN];
+static bool   SendStatus;
+
+
+/******************************************************************************
+** Function: SendMsg
+**
+*/
+static bool SendMsg(const char *Msg, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *PeerPtr)
+{
+
+   UT_ASSERT(MsgLen <= TEST_DATAGRAM_LEN);
+   if (SentCnt < SENT_MAX && MsgLen <= TEST_DATAGRAM_LEN)
+   {
+      memcpy(Sent[SentCnt], Msg, MsgLen);
+      SentLen[SentCnt++] = MsgLen;
+   }
+
+   return SendStatus;
+
+} /* End SendMsg() */
+
+
+/******************************************************************************
+** Function: Construct
+**
+*/
+static void Construct(uint32 FragCnt)
+{
+
+   UT_SetIniInt(CFG_DATAGRAM_LEN, TEST_DATAGRAM_LEN);
+   UT_SetIniInt(CFG_FRAG_CNT, FragCnt);
+   UT_SetIniInt(CFG_FRAG_POOL_CNT, TEST_POOL_CNT);
+   UT_SetIniInt(CFG_FRAG_TIMEOUT_MS, TEST_TIMEOUT_MS);
+
+   JMSG_MEM_Constructor(&Mem, &IniTbl);
+   JMSG_FRAG_Constructor(&Frag, &IniTbl, SendMsg);
+
+   memset(&Peer, 0, sizeof(Peer));
+   Peer.PeerAddr = 0x0A000001;
+   Peer.PeerPort = 5000;
+
+   SentCnt    = 0;
+   SendStatus = true;
+   UT_SetTimeUs(0);
+
+} /* End Construct() */
+
+
+/******************************************************************************
+** Function: AddSent
+**
+** Parse a sent fragment's header and add its slice to the reassembly pool.
+**
+*/
+static const char *AddSent(uint16 SentIdx, const JMSG_SOCK_RxInfo_t *RxInfo,
+                           uint16 *MsgLen, uint16 *RxMsgIdx)
+{
+
+   JMSG_HDR_Attr_t Attr;
+   const char *Colon = memchr(Sent[SentIdx], ':', SentLen[SentIdx]);
+   uint16 HdrLen = (uint16)(Colon - Sent[SentIdx]);
+
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, Sent[SentIdx], HdrLen) && Attr.FragValid);
+
+   return JMSG_FRAG_AddRx(RxInfo, &Attr, Colon + 1, SentLen[SentIdx] - HdrLen - 1, MsgLen, RxMsgIdx);
+
+} /* End AddSent() */
+
+
+/******************************************************************************
+** Function: MakeMsg
+**
+*/
+static uint32 MakeMsg(char *Msg, uint32 MsgLen)
+{
+
+   uint32 i;
+   uint32 Len = (uint32)snprintf(Msg, MsgLen, "big/topic:{\"v\":\"");
+
+   for (i=Len; i < MsgLen - 2; i++)
+   {
+      Msg[i] = 'a' + (i % 26);
+   }
+   Msg[MsgLen-2] = '"';
+   Msg[MsgLen-1] = '}';
+
+   return MsgLen;
+
+} /* End MakeMsg() */
+
+
+/******************************************************************************
+** Function: TestRoundTrip
+**
+** Fragments added out of order and duplicated reassemble the original.
+**
+*/
+static void TestRoundTrip(void)
+{
+
+   char   Msg[300];
+   uint32 Len = MakeMsg(Msg, sizeof(Msg));
+   const char *RxMsg = NULL;
+   uint16 RxLen;
+   uint16 RxMsgIdx;
+   int16  i;
+
+   Construct(TEST_FRAG_CNT);
+   UT_ASSERT(Frag.PoolCnt == TEST_POOL_CNT && Frag.FragCntMax == TEST_FRAG_CNT);
+
+   UT_ASSERT(JMSG_FRAG_Send("big/topic", Msg, Len));
+   UT_ASSERT(SentCnt > 1 && SentCnt <= TEST_FRAG_CNT && Frag.TxFragCnt == SentCnt);
+
+   UT_ASSERT(AddSent(0, &Peer, &RxLen, &RxMsgIdx) == NULL);
+   UT_ASSERT(AddSent(0, &Peer, &RxLen, &RxMsgIdx) == NULL);
+   for (i=SentCnt-1; i > 0; i--)
+   {
+      RxMsg = AddSent(i, &Peer, &RxLen, &RxMsgIdx);
+      UT_ASSERT((RxMsg != NULL) == (i == 1));
+   }
+   UT_ASSERT(RxMsg != NULL && RxLen == Len && memcmp(RxMsg, Msg, Len) == 0);
+   UT_ASSERT(Frag.RxMsgCnt == 1 && Frag.RxPendingCnt == 1);
+
+   JMSG_FRAG_ReleaseRx(RxMsgIdx);
+   JMSG_FRAG_ReleaseRx(RxMsgIdx);
+   UT_ASSERT(Frag.RxPendingCnt == 0);
+
+   /* Every slice but the last fills the datagram */
+   for (i=0; i < SentCnt - 1; i++)
+   {
+      UT_ASSERT(SentLen[i] >= TEST_DATAGRAM_LEN - 1);
+   }
+
+} /* End TestRoundTrip() */
+
+
+/******************************************************************************
+** Function: TestPeers
+**
+** The same fragment ID from two senders is two messages.
+**
+*/
+static void TestPeers(void)
+{
+
+   char   Msg[200];
+   uint32 Len = MakeMsg(Msg, sizeof(Msg));
+   JMSG_SOCK_RxInfo_t Peer2;
+   const char *RxMsg;
+   uint16 RxLen;
+   uint16 RxMsgIdx[2];
+   uint16 i;
+
+   Construct(TEST_FRAG_CNT);
+   Peer2 = Peer;
+   Peer2.PeerPort++;
+
+   UT_ASSERT(JMSG_FRAG_Send("big/topic", Msg, Len));
+   for (i=0; i < SentCnt - 1; i++)
+   {
+      UT_ASSERT(AddSent(i, &Peer, &RxLen, &RxMsgIdx[0]) == NULL);
+      UT_ASSERT(AddSent(i, &Peer2, &RxLen, &RxMsgIdx[1]) == NULL);
+   }
+   UT_ASSERT(Frag.RxPendingCnt == 2);
+
+   RxMsg = AddSent(SentCnt - 1, &Peer2, &RxLen, &RxMsgIdx[1]);
+   UT_ASSERT(RxMsg != NULL && RxLen == Len && memcmp(RxMsg, Msg, Len) == 0);
+   RxMsg = AddSent(SentCnt - 1, &Peer, &RxLen, &RxMsgIdx[0]);
+   UT_ASSERT(RxMsg != NULL && RxLen == Len && RxMsgIdx[0] != RxMsgIdx[1]);
+
+} /* End TestPeers() */
+
+
+/******************************************************************************
+** Function: TestMalformed
+**
+*/
+static void TestMalformed(void)
+{
+
+   JMSG_HDR_Attr_t Attr;
+   char   Slice[TEST_DATAGRAM_LEN + 1];
+   uint16 RxLen;
+   uint16 RxMsgIdx;
+
+   Construct(TEST_FRAG_CNT);
+   memset(Slice, 'x', sizeof(Slice));
+
+   /* Too many fragments or a slice longer than a datagram */
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "t;f=1.0.9", 9));
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, Slice, 1, &RxLen, &RxMsgIdx) == NULL);
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "t;f=1.0.2", 9));
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, Slice, TEST_DATAGRAM_LEN + 1, &RxLen, &RxMsgIdx) == NULL);
+   UT_ASSERT(Frag.RxDropCnt == 2 && Frag.RxPendingCnt == 0);
+
+   /* A fragment count that changes within a message */
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, Slice, 4, &RxLen, &RxMsgIdx) == NULL);
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "t;f=1.2.3", 9));
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, Slice, 4, &RxLen, &RxMsgIdx) == NULL);
+   UT_ASSERT(Frag.RxDropCnt == 3 && Frag.RxPendingCnt == 1);
+
+   /* A full pool drops new messages but lets the pending ones complete */
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "t;f=2.0.2", 9));
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, Slice, 4, &RxLen, &RxMsgIdx) == NULL);
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "t;f=3.0.2", 9));
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, Slice, 4, &RxLen, &RxMsgIdx) == NULL);
+   UT_ASSERT(Frag.RxDropCnt == 4 && Frag.RxPendingCnt == TEST_POOL_CNT);
+
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "t;f=1.1.2", 9));
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, "yy", 2, &RxLen, &RxMsgIdx) != NULL);
+   UT_ASSERT(RxLen == 6 && UT_EventCnt(JMSG_FRAG_RX_EID) == 4);
+
+} /* End TestMalformed() */
+
+
+/******************************************************************************
+** Function: TestTimeout
+**
+*/
+static void TestTimeout(void)
+{
+
+   JMSG_HDR_Attr_t Attr;
+   uint16 RxLen;
+   uint16 RxMsgIdx;
+
+   Construct(TEST_FRAG_CNT);
+
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "t;f=7.0.2", 9));
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, "ab", 2, &RxLen, &RxMsgIdx) == NULL);
+
+   /* A fragment on the deadline still completes its message */
+   UT_SetTimeUs(TEST_TIMEOUT_MS * 1000);
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "t;f=7.1.2", 9));
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, "cd", 2, &RxLen, &RxMsgIdx) != NULL);
+   JMSG_FRAG_ReleaseRx(RxMsgIdx);
+
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "t;f=8.0.2", 9));
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, "ab", 2, &RxLen, &RxMsgIdx) == NULL);
+
+   /* Past the deadline the first fragment is discarded and the second
+   ** starts a new message */
+   UT_SetTimeUs((2*TEST_TIMEOUT_MS + 1) * 1000);
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "t;f=8.1.2", 9));
+   UT_ASSERT(JMSG_FRAG_AddRx(&Peer, &Attr, "cd", 2, &RxLen, &RxMsgIdx) == NULL);
+   UT_ASSERT(Frag.RxTimeoutCnt == 1 && Frag.RxPendingCnt == 1);
+
+} /* End TestTimeout() */
+
+
+/******************************************************************************
+** Function: TestTx
+**
+*/
+static void TestTx(void)
+{
+
+   char   Msg[TEST_DATAGRAM_LEN * (TEST_FRAG_CNT + 1)];
+   uint32 Len;
+   const char *RxMsg = NULL;
+   uint16 RxLen;
+   uint16 RxMsgIdx;
+   uint16 i;
+
+   /* Fragmentation disabled */
+   Construct(1);
+   Len = MakeMsg(Msg, 100);
+   UT_ASSERT(!JMSG_FRAG_Send("big/topic", Msg, Len));
+   UT_ASSERT(SentCnt == 0 && Frag.TxErrCnt == 1);
+
+   /* Too many fragments */
+   Construct(TEST_FRAG_CNT);
+   Len = MakeMsg(Msg, sizeof(Msg));
+   UT_ASSERT(!JMSG_FRAG_Send("big/topic", Msg, Len));
+   UT_ASSERT(SentCnt == 0 && Frag.TxErrCnt == 1);
+
+   /* The fragment ID wraps and the longest ID still fits the slices */
+   Frag.TxId = 0xFFFFFFFE;
+   Len = MakeMsg(Msg, 200);
+   UT_ASSERT(JMSG_FRAG_Send("big/topic", Msg, Len));
+   UT_ASSERT(strncmp(Sent[0], "big/topic;f=4294967295.0.", 25) == 0);
+   SentCnt = 0;
+   UT_ASSERT(JMSG_FRAG_Send("big/topic", Msg, Len));
+   UT_ASSERT(strncmp(Sent[0], "big/topic;f=0.0.", 16) == 0);
+   for (i=0; i < SentCnt; i++)
+   {
+      RxMsg = AddSent(i, &Peer, &RxLen, &RxMsgIdx);
+   }
+   UT_ASSERT(RxMsg != NULL && RxLen == Len && memcmp(RxMsg, Msg, Len) == 0);
+
+   /* A failed send is counted once per message */
+   SendStatus = false;
+   UT_ASSERT(!JMSG_FRAG_Send("big/topic", Msg, Len));
+   UT_ASSERT(Frag.TxErrCnt == 2);
+
+} /* End TestTx() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestRoundTrip);
+   UT_RUN(TestPeers);
+   UT_RUN(TestMalformed);
+   UT_RUN(TestTimeout);
+   UT_RUN(TestTx);
+
+   return UT_Summary();
+
+} /* End main() */
@@ -0,0 +1,193 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for the JMSG header attribute parser
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdlib.h>
+
+#include "ut_jmsg.h"
+#include "jmsg_hdr.h"
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_HDR_Attr_t Attr;
+
+
+/******************************************************************************
+** Function: Parse
+**
+*/
+static bool Parse(const char *Hdr)
+{
+
+   return JMSG_HDR_Parse(&Attr, Hdr, (uint16)strlen(Hdr));
+
+} /* End Parse() */
+
+
+/******************************************************************************
+** Function: TestTopic
+**
+*/
+static void TestTopic(void)
+{
+
+   UT_ASSERT(Parse("basecamp/demo"));
+   UT_ASSERT(Attr.TopicLen == 13);
+   UT_ASSERT(!Attr.SeqValid && !Attr.AckValid && !Attr.FragValid && !Attr.ZipValid);
+
+   UT_ASSERT(Parse(""));
+   UT_ASSERT(Attr.TopicLen == 0);
+
+   UT_ASSERT(Parse(";s=1"));
+   UT_ASSERT(Attr.TopicLen == 0 && Attr.SeqValid && Attr.Seq == 1);
+
+   /* Only HdrLen bytes are read */
+   UT_ASSERT(JMSG_HDR_Parse(&Attr, "abc;s=x", 3));
+   UT_ASSERT(Attr.TopicLen == 3 && !Attr.SeqValid);
+
+} /* End TestTopic() */
+
+
+/******************************************************************************
+** Function: TestAttributes
+**
+*/
+static void TestAttributes(void)
+{
+
+   UT_ASSERT(Parse("t;s=42"));
+   UT_ASSERT(Attr.TopicLen == 1 && Attr.SeqValid && !Attr.Reliable && Attr.Seq == 42);
+
+   UT_ASSERT(Parse("t;r=4294967295"));
+   UT_ASSERT(Attr.SeqValid && Attr.Reliable && Attr.Seq == 0xFFFFFFFF);
+
+   UT_ASSERT(Parse("t;a=7"));
+   UT_ASSERT(Attr.AckValid && Attr.Ack == 7 && !Attr.SeqValid);
+
+   UT_ASSERT(Parse("t;f=9.2.3"));
+   UT_ASSERT(Attr.FragValid && Attr.FragId == 9 && Attr.FragIdx == 2 && Attr.FragCnt == 3);
+
+   UT_ASSERT(Parse("t;z=1000"));
+   UT_ASSERT(Attr.ZipValid && Attr.ZipLen == 1000);
+
+   UT_ASSERT(Parse("t;t=5"));
+   UT_ASSERT(Attr.TestValid && Attr.Test == 5);
+
+   UT_ASSERT(Parse("a/b;r=1;f=1.0.2;z=64;c=250"));
+   UT_ASSERT(Attr.TopicLen == 3 && Attr.Reliable && Attr.Seq == 1);
+   UT_ASSERT(Attr.FragValid && Attr.FragCnt == 2 && Attr.ZipValid && Attr.ZipLen == 64);
+
+   /* Unknown keys and attributes without a value are ignored */
+   UT_ASSERT(Parse("t;q=abc;x;;s=3;"));
+   UT_ASSERT(Attr.SeqValid && Attr.Seq == 3);
+
+} /* End TestAttributes() */
+
+
+/******************************************************************************
+** Function: TestInvalid
+**
+*/
+static void TestInvalid(void)
+{
+
+   UT_ASSERT(!Parse("t;s="));
+   UT_ASSERT(!Parse("t;s=-1"));
+   UT_ASSERT(!Parse("t;s=1x"));
+   UT_ASSERT(!Parse("t;s=4294967296"));
+   UT_ASSERT(!Parse("t;s=00000000001"));
+   UT_ASSERT(!Parse("t;a= 1"));
+   UT_ASSERT(!Parse("t;z=99999999999"));
+
+   UT_ASSERT(!Parse("t;f=1"));
+   UT_ASSERT(!Parse("t;f=1.2"));
+   UT_ASSERT(!Parse("t;f=1.2.2"));
+   UT_ASSERT(!Parse("t;f=1.0.0"));
+   UT_ASSERT(!Parse("t;f=1..2"));
+   UT_ASSERT(!Parse("t;f=1.0.2.3"));
+   UT_ASSERT(Parse("t;f=1.1.2"));
+
+} /* End TestInvalid() */
+
+
+/******************************************************************************
+** Function: TestFuzz
+**
+** Parse random headers from an alphabet of the attribute syntax. Each header
+** is copied to a buffer of exactly its length so an overread reads past the
+** allocation, and the results must be self consistent.
+**
+*/
+static void TestFuzz(void)
+{
+
+   static const char Alphabet[] = "srafzt=;.0123456789x/";
+   char   *Hdr;
+   uint16 Len;
+   uint32 i, j;
+   bool   Consistent = true;
+
+   srand(33);
+   for (i=0; i < 200000 && Consistent; i++)
+   {
+      Len = (uint16)(rand() % 24);
+      Hdr = malloc(Len + 1);
+      for (j=0; j < Len; j++)
+      {
+         Hdr[j] = Alphabet[rand() % (sizeof(Alphabet) - 1)];
+      }
+      if (JMSG_HDR_Parse(&Attr, Hdr, Len))
+      {
+         Consistent = (Attr.TopicLen <= Len) &&
+                      (!Attr.FragValid || Attr.FragIdx < Attr.FragCnt) &&
+                      (!Attr.Reliable || Attr.SeqValid);
+      }
+      else
+      {
+         Consistent = (memchr(Hdr, '=', Len) != NULL);
+      }
+      free(Hdr);
+   }
+
+   UT_ASSERT(Consistent);
+
+} /* End TestFuzz() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestTopic);
+   UT_RUN(TestAttributes);
+   UT_RUN(TestInvalid);
+   UT_RUN(TestFuzz);
+
+   return UT_Summary();
+
+} /* End main() */
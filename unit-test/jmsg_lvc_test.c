@@ -0,0 +1,265 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for the last value cache
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include "ut_jmsg.h"
+#include "jmsg_lvc.h"
+#include "jmsg_mem.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define TEST_DATAGRAM_LEN  256
+#define TEST_VALUE_LEN     128
+#define TEST_TOPIC_CNT     4
+#define TEST_REPLY_LIM     6
+
+#define TX_PEER_ADDR     0x0A000001   /* 10.0.0.1 */
+#define LISTED_ADDR      0x0A000009   /* 10.0.0.9 */
+#define OTHER_ADDR       0x0A000002
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static INITBL_Class_t    IniTbl;
+static JMSG_MEM_Class_t  Mem;
+static JMSG_LVC_Class_t  Lvc;
+
+static uint32 SendCnt;
+static char   SentMsg[TEST_DATAGRAM_LEN + 1];
+
+
+/******************************************************************************
+** Function: SendMsg
+**
+*/
+static bool SendMsg(const char *Msg, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *Peer)
+{
+
+   SendCnt++;
+   if (MsgLen < sizeof(SentMsg))
+   {
+      memcpy(SentMsg, Msg, MsgLen);
+      SentMsg[MsgLen] = '\0';
+   }
+
+   return true;
+
+} /* End SendMsg() */
+
+
+/******************************************************************************
+** Function: Construct
+**
+*/
+static void Construct(const char *QueryAddr)
+{
+
+   JMSG_SOCK_RxInfo_t TxPeer = { .PeerAddr = TX_PEER_ADDR, .PeerPort = 8888 };
+
+   UT_SetIniInt(CFG_DATAGRAM_LEN, TEST_DATAGRAM_LEN);
+   UT_SetIniInt(CFG_FRAG_CNT, 1);
+   UT_SetIniInt(CFG_LVC_TOPIC_CNT, TEST_TOPIC_CNT);
+   UT_SetIniInt(CFG_LVC_VALUE_LEN, TEST_VALUE_LEN);
+   UT_SetIniInt(CFG_LVC_ALL_REPLY_LIM, TEST_REPLY_LIM);
+   UT_SetIniStr(CFG_LVC_QUERY_ADDR, QueryAddr);
+
+   JMSG_MEM_Constructor(&Mem, &IniTbl);
+   JMSG_LVC_Constructor(&Lvc, &IniTbl, SendMsg);
+   JMSG_LVC_SetTxPeer(&TxPeer);
+
+   SendCnt = 0;
+   UT_SetTimeUs(1000000);
+
+} /* End Construct() */
+
+
+/******************************************************************************
+** Function: Query
+**
+** Send a query from a peer and return the number of replies.
+**
+*/
+static uint32 Query(const char *Text, uint32 PeerAddr)
+{
+
+   JMSG_SOCK_RxInfo_t Peer = { .PeerAddr = PeerAddr, .PeerPort = 5555 };
+   uint32 StartCnt = SendCnt;
+
+   JMSG_LVC_Query(Text, strlen(Text), &Peer);
+
+   return SendCnt - StartCnt;
+
+} /* End Query() */
+
+
+/******************************************************************************
+** Function: TestQuery
+**
+** A topic query returns the last value with its age.
+**
+*/
+static void TestQuery(void)
+{
+
+   char Topic[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN + 1];
+   char Payload[TEST_VALUE_LEN];
+
+   Construct("");
+
+   JMSG_LVC_Update("basecamp/a", "{\"x\":1}", 7);
+   JMSG_LVC_Update("basecamp/a", "{\"x\":2}", 7);
+   UT_SetTimeUs(1250000);
+   UT_ASSERT(Query("basecamp/a", TX_PEER_ADDR) == 1);
+   UT_ASSERT(strcmp(SentMsg, "basecamp/a;c=250:{\"x\":2}") == 0);
+   UT_ASSERT(Query("basecamp/a \r\n", TX_PEER_ADDR) == 1);
+   UT_ASSERT(Lvc.SlotCnt == 1 && Lvc.ReplyCnt == 2);
+
+   /* A clock that steps back gives a zero age */
+   UT_SetTimeUs(0);
+   UT_ASSERT(Query("basecamp/a", TX_PEER_ADDR) == 1);
+   UT_ASSERT(strcmp(SentMsg, "basecamp/a;c=0:{\"x\":2}") == 0);
+
+   /* A value too long for its slot clears the topic */
+   memset(Payload, '1', sizeof(Payload));
+   JMSG_LVC_Update("basecamp/a", Payload, sizeof(Payload));
+   UT_ASSERT(Query("basecamp/a", TX_PEER_ADDR) == 0);
+   UT_ASSERT(Lvc.TooLongCnt == 1 && Lvc.MissCnt == 1);
+
+   /* Unknown, empty, binary and overlong topics miss */
+   memset(Topic, 'a', sizeof(Topic) - 1);
+   Topic[sizeof(Topic) - 1] = '\0';
+   UT_ASSERT(Query("basecamp/b", TX_PEER_ADDR) == 0);
+   UT_ASSERT(Query("", TX_PEER_ADDR) == 0);
+   UT_ASSERT(Query(" \t", TX_PEER_ADDR) == 0);
+   UT_ASSERT(Query("\x01\xFF*", TX_PEER_ADDR) == 0);
+   UT_ASSERT(Query(Topic, TX_PEER_ADDR) == 0);
+   UT_ASSERT(Lvc.MissCnt == 6 && Lvc.QueryCnt == 9 && Lvc.RejectCnt == 0);
+
+   /* Topics past the slots aren't cached */
+   JMSG_LVC_Update("basecamp/b", "1", 1);
+   JMSG_LVC_Update("basecamp/c", "1", 1);
+   JMSG_LVC_Update("basecamp/d", "1", 1);
+   JMSG_LVC_Update("basecamp/e", "1", 1);
+   UT_ASSERT(Lvc.SlotCnt == TEST_TOPIC_CNT && Lvc.FullCnt == 1);
+   UT_ASSERT(Query("basecamp/d", TX_PEER_ADDR) == 1 && Query("basecamp/e", TX_PEER_ADDR) == 0);
+
+} /* End TestQuery() */
+
+
+/******************************************************************************
+** Function: TestPeer
+**
+** Only the Tx peer, listed addresses and the local socket are answered.
+**
+*/
+static void TestPeer(void)
+{
+
+   JMSG_SOCK_RxInfo_t Peer = { .PeerAddr = 0, .PeerPort = 0 };
+
+   Construct("10.0.0.9, 192.168.1.2,bad,1.2.3.256,1.2.3.4x");
+   UT_ASSERT(Lvc.QueryAddrCnt == 2 && Lvc.QueryAddr[1] == 0xC0A80102);
+   UT_ASSERT(UT_EventCnt(JMSG_LVC_CONSTRUCTOR_EID) == 3);
+
+   JMSG_LVC_Update("basecamp/a", "1", 1);
+   UT_ASSERT(Query("basecamp/a", OTHER_ADDR) == 0);
+   UT_ASSERT(Query("*", OTHER_ADDR) == 0);
+   UT_ASSERT(Lvc.RejectCnt == 2 && Lvc.MissCnt == 0);
+
+   UT_ASSERT(Query("basecamp/a", LISTED_ADDR) == 1);
+   UT_ASSERT(Query("basecamp/a", 0xC0A80102) == 1);
+   UT_ASSERT(Query("basecamp/a", TX_PEER_ADDR) == 1);
+   JMSG_LVC_Query("basecamp/a", 10, &Peer);
+   UT_ASSERT(SendCnt == 4);
+
+   /* A new Tx peer replaces the old one */
+   Peer.PeerAddr = OTHER_ADDR;
+   Peer.PeerPort = 1;
+   JMSG_LVC_SetTxPeer(&Peer);
+   UT_ASSERT(Query("basecamp/a", TX_PEER_ADDR) == 0);
+   UT_ASSERT(Query("basecamp/a", OTHER_ADDR) == 1);
+   UT_ASSERT(Lvc.RejectCnt == 3);
+
+   /* Too many addresses */
+   Construct("1.1.1.1,1.1.1.2,1.1.1.3,1.1.1.4,1.1.1.5,1.1.1.6,1.1.1.7,1.1.1.8,1.1.1.9");
+   UT_ASSERT(Lvc.QueryAddrCnt == JMSG_LVC_QUERY_ADDR_MAX);
+
+} /* End TestPeer() */
+
+
+/******************************************************************************
+** Function: TestAllLimit
+**
+** "?*" replies are limited per interval, including when the clock steps
+** back.
+**
+*/
+static void TestAllLimit(void)
+{
+
+   Construct("");
+
+   JMSG_LVC_Update("basecamp/a", "1", 1);
+   JMSG_LVC_Update("basecamp/b", "2", 1);
+   JMSG_LVC_Update("basecamp/c", "3", 1);
+   JMSG_LVC_Update("basecamp/d", "4", 1);
+
+   UT_ASSERT(Query("*", TX_PEER_ADDR) == 4);
+   UT_ASSERT(Query("*\n", TX_PEER_ADDR) == 2);
+   UT_ASSERT(Lvc.RejectCnt == 1);
+   UT_ASSERT(Query("*", TX_PEER_ADDR) == 0);
+   UT_ASSERT(Lvc.RejectCnt == 2);
+
+   /* Topic queries aren't limited */
+   UT_ASSERT(Query("basecamp/a", TX_PEER_ADDR) == 1);
+
+   UT_SetTimeUs(1000000 + JMSG_LVC_ALL_WINDOW_MS*1000 - 1000);
+   UT_ASSERT(Query("*", TX_PEER_ADDR) == 0);
+   UT_SetTimeUs(1000000 + JMSG_LVC_ALL_WINDOW_MS*1000);
+   UT_ASSERT(Query("*", TX_PEER_ADDR) == 4);
+
+   UT_SetTimeUs(0);
+   UT_ASSERT(Query("*", TX_PEER_ADDR) == 4);
+   UT_ASSERT(Lvc.RejectCnt == 3 && Lvc.ReplyCnt == 15);
+
+} /* End TestAllLimit() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestQuery);
+   UT_RUN(TestPeer);
+   UT_RUN(TestAllLimit);
+
+   return UT_Summary();
+
+} /* End main() */
@@ -0,0 +1,345 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for LZ4 payload compression and decompression
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ut_jmsg.h"
+#include "jmsg_lz.h"
+#include "jmsg_mem.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define TEST_DATAGRAM_LEN  1024
+#define TEST_FRAG_CNT      4
+#define TEST_MSG_MAX_LEN   (TEST_DATAGRAM_LEN*TEST_FRAG_CNT)
+
+#define DICT_FILE  "ut_lz_dict.txt"
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static INITBL_Class_t    IniTbl;
+static JMSG_MEM_Class_t  Mem;
+static JMSG_LZ_Class_t   Lz;
+
+static char Payload[TEST_MSG_MAX_LEN];
+static char Zip[TEST_MSG_MAX_LEN];
+
+
+/******************************************************************************
+** Function: Construct
+**
+*/
+static void Construct(uint32 MinLen, const char *DictFile)
+{
+
+   UT_SetIniInt(CFG_DATAGRAM_LEN, TEST_DATAGRAM_LEN);
+   UT_SetIniInt(CFG_FRAG_CNT, TEST_FRAG_CNT);
+   UT_SetIniInt(CFG_LZ_MIN_LEN, MinLen);
+   UT_SetIniStr(CFG_LZ_DICT_FILE, DictFile);
+
+   JMSG_MEM_Constructor(&Mem, &IniTbl);
+   JMSG_LZ_Constructor(&Lz, &IniTbl);
+
+} /* End Construct() */
+
+
+/******************************************************************************
+** Function: RoundTrip
+**
+** Compress and decompress a payload. Returns the compressed length or 0 if
+** the payload wasn't compressed.
+**
+*/
+static uint32 RoundTrip(const char *Data, uint32 Len)
+{
+
+   const uint8 *Block;
+   const char  *Raw;
+   uint32 ZipLen;
+
+   Block = JMSG_LZ_Compress("t", Data, Len, 0, &ZipLen);
+   if (Block == NULL)
+   {
+      UT_ASSERT(ZipLen == 0);
+      return 0;
+   }
+
+   UT_ASSERT(ZipLen > 0 && ZipLen < Len);
+   memcpy(Zip, Block, ZipLen);
+   Raw = JMSG_LZ_Decompress(Zip, ZipLen, Len);
+   UT_ASSERT(Raw != NULL && memcmp(Raw, Data, Len) == 0 && Raw[Len] == '\0');
+
+   return ZipLen;
+
+} /* End RoundTrip() */
+
+
+/******************************************************************************
+** Function: MakeJson
+**
+*/
+static uint32 MakeJson(char *Buf, uint32 BufLen, uint32 Seed)
+{
+
+   uint32 Len = 0;
+   uint32 i = 0;
+
+   Len += snprintf(&Buf[Len], BufLen - Len, "{\"samples\":[");
+   while (Len + 64 < BufLen)
+   {
+      Len += snprintf(&Buf[Len], BufLen - Len, "%s{\"id\":%u,\"lux\":%u,\"state\":\"nominal\"}",
+                      (i == 0 ? "" : ","), (unsigned int)i, (unsigned int)((Seed + i*7919) % 1000));
+      i++;
+   }
+   Len += snprintf(&Buf[Len], BufLen - Len, "]}");
+
+   return Len;
+
+} /* End MakeJson() */
+
+
+/******************************************************************************
+** Function: TestRoundTrip
+**
+*/
+static void TestRoundTrip(void)
+{
+
+   uint32 Len;
+   uint32 ZipLen;
+   uint32 i;
+
+   Construct(32, NULL);
+
+   /* Structured text */
+   Len = MakeJson(Payload, sizeof(Payload), 1);
+   ZipLen = RoundTrip(Payload, Len);
+   UT_ASSERT(ZipLen > 0 && ZipLen < Len/2);
+
+   /* A single byte run decodes with overlapping copies */
+   memset(Payload, 'x', sizeof(Payload));
+   UT_ASSERT(RoundTrip(Payload, sizeof(Payload)) > 0);
+
+   /* Short period runs and lengths around the 15 and 255 extension bytes */
+   for (Len = 32; Len < 600; Len += 37)
+   {
+      for (i=0; i < Len; i++)
+      {
+         Payload[i] = "abc"[i % 3];
+      }
+      UT_ASSERT(RoundTrip(Payload, Len) > 0);
+   }
+
+   /* A long literal run before a match */
+   srand(37);
+   for (i=0; i < 700; i++)
+   {
+      Payload[i] = 'A' + rand() % 26;
+   }
+   memcpy(&Payload[700], Payload, 300);
+   UT_ASSERT(RoundTrip(Payload, 1000) > 0);
+
+   UT_ASSERT(Lz.Total.MsgCnt > 0 && Lz.Total.ZipBytes < Lz.Total.RawBytes);
+   UT_ASSERT(JMSG_LZ_RatioPerMille(&Lz.Total) > 0 && JMSG_LZ_RatioPerMille(&Lz.Total) < 1000);
+
+} /* End TestRoundTrip() */
+
+
+/******************************************************************************
+** Function: TestSkip
+**
+*/
+static void TestSkip(void)
+{
+
+   uint32 ZipLen;
+   uint32 Len;
+   uint32 i;
+
+   Construct(32, NULL);
+
+   /* Too short */
+   memset(Payload, 'x', 31);
+   UT_ASSERT(JMSG_LZ_Compress("t", Payload, 31, 0, &ZipLen) == NULL && ZipLen == 0);
+
+   /* Incompressible */
+   srand(1);
+   for (i=0; i < 512; i++)
+   {
+      Payload[i] = (char)rand();
+   }
+   UT_ASSERT(JMSG_LZ_Compress("t", Payload, 512, 0, &ZipLen) == NULL);
+
+   /* The result must leave room for the caller's header bytes */
+   Len = MakeJson(Payload, 400, 2);
+   UT_ASSERT(JMSG_LZ_Compress("t", Payload, Len, 0, &ZipLen) != NULL);
+   UT_ASSERT(JMSG_LZ_Compress("t", Payload, Len, Len - ZipLen, &ZipLen) == NULL);
+   UT_ASSERT(JMSG_LZ_Compress("t", Payload, Len, Len, &ZipLen) == NULL);
+   UT_ASSERT(Lz.Total.SkipCnt == 4 && Lz.Topic[0].Stats.SkipCnt == 4);
+
+   /* Disabled */
+   Construct(0, NULL);
+   UT_ASSERT(JMSG_LZ_Compress("t", Payload, Len, 0, &ZipLen) == NULL);
+   UT_ASSERT(JMSG_LZ_Decompress(Payload, 4, 4) == NULL && Lz.RxErrCnt == 1);
+   UT_ASSERT(Mem.Used == 0);
+
+} /* End TestSkip() */
+
+
+/******************************************************************************
+** Function: TestCorrupt
+**
+** Hand built blocks with invalid lengths and offsets, truncations of a valid
+** block and random bit flips must be rejected or decode to exactly RawLen
+** bytes without touching memory outside the buffers.
+**
+*/
+static void TestCorrupt(void)
+{
+
+   static const uint8 Literal[]   = { 0x30, 'a', 'b', 'c' };
+   static const uint8 Overlap[]   = { 0x16, 'a', 0x01, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f' };
+   static const uint8 ZeroOff[]   = { 0x10, 'a', 0x00, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f' };
+   static const uint8 FarOff[]    = { 0x10, 'a', 0x02, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f' };
+   static const uint8 LongLit[]   = { 0xF0, 0xFF };
+   static const uint8 ShortOff[]  = { 0x10, 'a', 0x01 };
+   const uint8 *Block;
+   const char  *Raw;
+   uint32 ZipLen;
+   uint32 Len;
+   uint32 i;
+   uint32 Bit;
+
+   Construct(32, NULL);
+
+   Raw = JMSG_LZ_Decompress((const char *)Literal, sizeof(Literal), 3);
+   UT_ASSERT(Raw != NULL && strcmp(Raw, "abc") == 0);
+   Raw = JMSG_LZ_Decompress((const char *)Overlap, sizeof(Overlap), 16);
+   UT_ASSERT(Raw != NULL && strcmp(Raw, "aaaaaaaaaaabcdef") == 0);
+
+   UT_ASSERT(JMSG_LZ_Decompress((const char *)Literal, sizeof(Literal), 2) == NULL);
+   UT_ASSERT(JMSG_LZ_Decompress((const char *)Literal, sizeof(Literal), 4) == NULL);
+   UT_ASSERT(JMSG_LZ_Decompress((const char *)Overlap, sizeof(Overlap), 15) == NULL);
+   UT_ASSERT(JMSG_LZ_Decompress((const char *)ZeroOff, sizeof(ZeroOff), 10) == NULL);
+   UT_ASSERT(JMSG_LZ_Decompress((const char *)FarOff, sizeof(FarOff), 10) == NULL);
+   UT_ASSERT(JMSG_LZ_Decompress((const char *)LongLit, sizeof(LongLit), 300) == NULL);
+   UT_ASSERT(JMSG_LZ_Decompress((const char *)ShortOff, sizeof(ShortOff), 10) == NULL);
+   UT_ASSERT(JMSG_LZ_Decompress((const char *)Literal, sizeof(Literal), TEST_MSG_MAX_LEN + 1) == NULL);
+   UT_ASSERT(Lz.RxErrCnt == 8);
+
+   Len = MakeJson(Payload, 2000, 3);
+   Block = JMSG_LZ_Compress("t", Payload, Len, 0, &ZipLen);
+   UT_ASSERT(Block != NULL);
+   memcpy(Zip, Block, ZipLen);
+
+   for (i=0; i < ZipLen; i++)
+   {
+      UT_ASSERT(JMSG_LZ_Decompress(Zip, i, Len) == NULL);
+   }
+
+   srand(37);
+   for (i=0; i < 20000; i++)
+   {
+      memcpy(Zip, Block, ZipLen);
+      Bit = rand() % (ZipLen*8);
+      Zip[Bit/8] ^= (char)(1 << (Bit % 8));
+      Raw = JMSG_LZ_Decompress(Zip, ZipLen, Len);
+      if (Raw != NULL && Raw[Len] != '\0')
+      {
+         UT_ASSERT(false);
+      }
+   }
+   UT_ASSERT(Lz.RxErrCnt > 8);
+
+} /* End TestCorrupt() */
+
+
+/******************************************************************************
+** Function: TestDict
+**
+** A dictionary shortens payloads that resemble it and both ends must use
+** the same one.
+**
+*/
+static void TestDict(void)
+{
+
+   FILE  *File;
+   uint32 Len;
+   uint32 PlainLen;
+   uint32 DictZipLen;
+   uint32 EventCnt;
+   const uint8 *Block;
+
+   Len = MakeJson(Payload, 200, 4);
+
+   Construct(32, NULL);
+   PlainLen = RoundTrip(Payload, Len);
+
+   File = fopen(DICT_FILE, "w");
+   fwrite(Payload, 1, Len, File);
+   fclose(File);
+
+   Construct(32, DICT_FILE);
+   UT_ASSERT(Lz.DictLen == Len);
+   DictZipLen = RoundTrip(Payload, Len);
+   UT_ASSERT(DictZipLen > 0 && DictZipLen < PlainLen);
+
+   /* The block references the dictionary so a receiver without it fails */
+   Block = JMSG_LZ_Compress("t", Payload, Len, 0, &DictZipLen);
+   memcpy(Zip, Block, DictZipLen);
+   Construct(32, NULL);
+   UT_ASSERT(JMSG_LZ_Decompress(Zip, DictZipLen, Len) == NULL);
+
+   /* A missing dictionary is reported and compression still works */
+   unlink(DICT_FILE);
+   EventCnt = UT_EventCnt(JMSG_LZ_CONSTRUCTOR_EID);
+   Construct(32, DICT_FILE);
+   UT_ASSERT(Lz.DictLen == 0 && UT_EventCnt(JMSG_LZ_CONSTRUCTOR_EID) == EventCnt + 1);
+   UT_ASSERT(RoundTrip(Payload, Len) == PlainLen);
+
+} /* End TestDict() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestRoundTrip);
+   UT_RUN(TestSkip);
+   UT_RUN(TestCorrupt);
+   UT_RUN(TestDict);
+
+   return UT_Summary();
+
+} /* End main() */
@@ -0,0 +1,266 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for the topic pattern trie matcher
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include "ut_jmsg.h"
+#include "jmsg_match.h"
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_MATCH_Class_t Match;
+
+
+/******************************************************************************
+** Function: Add
+**
+*/
+static bool Add(const char *Pattern, uint16 Value)
+{
+
+   return JMSG_MATCH_AddPattern(&Match, Pattern, (uint16)strlen(Pattern), Value);
+
+} /* End Add() */
+
+
+/******************************************************************************
+** Function: Lookup
+**
+*/
+static uint16 Lookup(const char *Topic)
+{
+
+   return JMSG_MATCH_Lookup(&Match, Topic, (uint16)strlen(Topic));
+
+} /* End Lookup() */
+
+
+/******************************************************************************
+** Function: TestLiteral
+**
+*/
+static void TestLiteral(void)
+{
+
+   JMSG_MATCH_Clear(&Match);
+   UT_ASSERT(Lookup("a") == JMSG_MATCH_NONE);
+
+   UT_ASSERT(Add("a/b/c", 1));
+   UT_ASSERT(Add("a/b", 2));
+   UT_ASSERT(Add("a//c", 3));
+
+   UT_ASSERT(Lookup("a/b/c") == 1);
+   UT_ASSERT(Lookup("a/b") == 2);
+   UT_ASSERT(Lookup("a//c") == 3);
+   UT_ASSERT(Lookup("a") == JMSG_MATCH_NONE);
+   UT_ASSERT(Lookup("a/b/c/d") == JMSG_MATCH_NONE);
+   UT_ASSERT(Lookup("a/b/") == JMSG_MATCH_NONE);
+   UT_ASSERT(Lookup("a/bc") == JMSG_MATCH_NONE);
+   UT_ASSERT(JMSG_MATCH_Lookup(&Match, "a/b/c", 0) == JMSG_MATCH_NONE);
+
+   /* Only TopicLen bytes are read */
+   UT_ASSERT(JMSG_MATCH_Lookup(&Match, "a/b/c", 3) == 2);
+
+   JMSG_MATCH_Clear(&Match);
+   UT_ASSERT(Lookup("a/b/c") == JMSG_MATCH_NONE);
+
+} /* End TestLiteral() */
+
+
+/******************************************************************************
+** Function: TestWildcard
+**
+*/
+static void TestWildcard(void)
+{
+
+   JMSG_MATCH_Clear(&Match);
+
+   UT_ASSERT(Add("a/+/c", 1));
+   UT_ASSERT(Add("a/#", 2));
+   UT_ASSERT(Add("+/x", 3));
+   UT_ASSERT(Add("#", 4));
+
+   UT_ASSERT(Lookup("a/b/c") == 1);
+   UT_ASSERT(Lookup("a/b/d") == 2);
+   UT_ASSERT(Lookup("a") == 2);
+   UT_ASSERT(Lookup("a/x") == 2);
+   UT_ASSERT(Lookup("b/x") == 3);
+   UT_ASSERT(Lookup("b/y") == 4);
+   UT_ASSERT(Lookup("$SYS/x") == JMSG_MATCH_NONE);
+
+   /* A literal level that fails deeper backtracks to the wildcards */
+   JMSG_MATCH_Clear(&Match);
+   UT_ASSERT(Add("a/b/c", 1));
+   UT_ASSERT(Add("a/+/d", 2));
+   UT_ASSERT(Add("$SYS/+", 3));
+   UT_ASSERT(Lookup("a/b/c") == 1);
+   UT_ASSERT(Lookup("a/b/d") == 2);
+   UT_ASSERT(Lookup("a/b/e") == JMSG_MATCH_NONE);
+   UT_ASSERT(Lookup("$SYS/x") == 3);
+
+} /* End TestWildcard() */
+
+
+/******************************************************************************
+** Function: TestMalformed
+**
+*/
+static void TestMalformed(void)
+{
+
+   JMSG_MATCH_Clear(&Match);
+
+   UT_ASSERT(!Add("", 1));
+   UT_ASSERT(!Add("a/#/b", 1));
+   UT_ASSERT(!Add("a/b+", 1));
+   UT_ASSERT(!Add("a#", 1));
+   UT_ASSERT(!Add("a", JMSG_MATCH_NONE));
+
+   UT_ASSERT(Add("a/b", 1));
+   UT_ASSERT(!Add("a/b", 2));
+   UT_ASSERT(Add("a/#", 3));
+   UT_ASSERT(!Add("a/#", 4));
+   UT_ASSERT(Match.PatternCnt == 2);
+
+} /* End TestMalformed() */
+
+
+/******************************************************************************
+** Function: TestCapacity
+**
+** Fill the node table with sibling levels, which also exercises hash
+** probing, and verify every pattern is still found.
+**
+*/
+static void TestCapacity(void)
+{
+
+   char   Pattern[32];
+   uint16 i, Added = 0;
+
+   JMSG_MATCH_Clear(&Match);
+
+   for (i=0; i < JMSG_UDP_PLATFORM_MATCH_NODE_MAX; i++)
+   {
+      snprintf(Pattern, sizeof(Pattern), "t%u", i);
+      if (Add(Pattern, i))
+      {
+         Added++;
+      }
+   }
+
+   /* The root uses one node */
+   UT_ASSERT(Added == JMSG_UDP_PLATFORM_MATCH_NODE_MAX - 1);
+   UT_ASSERT(Match.NodeCnt == JMSG_UDP_PLATFORM_MATCH_NODE_MAX);
+   UT_ASSERT(!Add("+", 1));
+
+   for (i=0; i < Added; i++)
+   {
+      snprintf(Pattern, sizeof(Pattern), "t%u", i);
+      if (!UT_ASSERT(Lookup(Pattern) == i))
+      {
+         break;
+      }
+   }
+   UT_ASSERT(Lookup("t99999") == JMSG_MATCH_NONE);
+
+} /* End TestCapacity() */
+
+
+/******************************************************************************
+** Function: TestDepth
+**
+** Patterns up to JMSG_MATCH_LEVEL_MAX levels must match, including by
+** backtracking from every literal level, and a topic with more levels than
+** the trie must not deepen the lookup.
+**
+*/
+static void TestDepth(void)
+{
+
+   static char Pattern[4*JMSG_MATCH_LEVEL_MAX];
+   static char Topic[0xFFFF];
+   uint16 Len = 0;
+   uint32 i;
+
+   JMSG_MATCH_Clear(&Match);
+
+   /* "a/a/.../a" and "+/+/.../+/#" with the maximum number of levels */
+   for (i=0; i < JMSG_MATCH_LEVEL_MAX; i++)
+   {
+      Len += snprintf(&Pattern[Len], sizeof(Pattern) - Len, "%sa", (i > 0 ? "/" : ""));
+   }
+   UT_ASSERT(Add(Pattern, 1));
+   Len = 0;
+   for (i=0; i < JMSG_MATCH_LEVEL_MAX - 1; i++)
+   {
+      Len += snprintf(&Pattern[Len], sizeof(Pattern) - Len, "+/");
+   }
+   snprintf(&Pattern[Len], sizeof(Pattern) - Len, "#");
+   UT_ASSERT(Add(Pattern, 2));
+   UT_ASSERT(!Add("a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/"
+                  "a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a/a", 3));
+
+   memset(Topic, 0, sizeof(Topic));
+   for (i=0; i < JMSG_MATCH_LEVEL_MAX; i++)
+   {
+      Topic[2*i]   = 'a';
+      Topic[2*i+1] = '/';
+   }
+   UT_ASSERT(JMSG_MATCH_Lookup(&Match, Topic, 2*JMSG_MATCH_LEVEL_MAX - 1) == 1);
+
+   /* The literal path fails at the last level and falls back to "#" */
+   Topic[2*JMSG_MATCH_LEVEL_MAX - 2] = 'b';
+   UT_ASSERT(JMSG_MATCH_Lookup(&Match, Topic, 2*JMSG_MATCH_LEVEL_MAX - 1) == 2);
+
+   /* Tens of thousands of levels, all matched by "#" */
+   memset(Topic, '/', sizeof(Topic));
+   UT_ASSERT(JMSG_MATCH_Lookup(&Match, Topic, sizeof(Topic)) == 2);
+   for (i=0; i < sizeof(Topic); i += 2)
+   {
+      Topic[i] = 'a';
+   }
+   UT_ASSERT(JMSG_MATCH_Lookup(&Match, Topic, sizeof(Topic)) == 2);
+   UT_ASSERT(JMSG_MATCH_Lookup(&Match, Topic, JMSG_MATCH_LEVEL_MAX - 2) == JMSG_MATCH_NONE);
+
+} /* End TestDepth() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestLiteral);
+   UT_RUN(TestWildcard);
+   UT_RUN(TestMalformed);
+   UT_RUN(TestCapacity);
+   UT_RUN(TestDepth);
+
+   return UT_Summary();
+
+} /* End main() */
@@ -0,0 +1,324 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for reliable delivery windows, retransmission and acks
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include "ut_jmsg.h"
+#include "jmsg_mem.h"
+#include "jmsg_rel.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define RTO_MS     100
+#define RETRY_LIM  2
+#define WINDOW     4
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static INITBL_Class_t    IniTbl;
+static JMSG_MEM_Class_t  Mem;
+static JMSG_REL_Class_t  Rel;
+
+static uint32 SendCnt;
+static bool   SendStatus;
+static char   SentMsg[128];
+static const JMSG_SOCK_RxInfo_t *SentPeer;
+
+
+/******************************************************************************
+** Function: SendMsg
+**
+*/
+static bool SendMsg(const char *Msg, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *Peer)
+{
+
+   SendCnt++;
+   SentPeer = Peer;
+   if (MsgLen < sizeof(SentMsg))
+   {
+      memcpy(SentMsg, Msg, MsgLen);
+      SentMsg[MsgLen] = '\0';
+   }
+
+   return SendStatus;
+
+} /* End SendMsg() */
+
+
+/******************************************************************************
+** Function: Construct
+**
+*/
+static void Construct(bool AckToTxAddr)
+{
+
+   UT_SetIniInt(CFG_DATAGRAM_LEN, 256);
+   UT_SetIniInt(CFG_FRAG_CNT, 1);
+   UT_SetIniInt(CFG_REL_WINDOW, WINDOW);
+   UT_SetIniInt(CFG_REL_SLOT_CNT, JMSG_UDP_PLATFORM_REL_SLOT_MAX);
+   UT_SetIniInt(CFG_REL_RTO_MS, RTO_MS);
+   UT_SetIniInt(CFG_REL_RETRY_LIM, RETRY_LIM);
+   UT_SetIniInt(CFG_REL_ACK_TO_TX_ADDR, AckToTxAddr);
+
+   JMSG_MEM_Constructor(&Mem, &IniTbl);
+   JMSG_REL_Constructor(&Rel, &IniTbl, SendMsg);
+
+   SendCnt    = 0;
+   SendStatus = true;
+   SentPeer   = NULL;
+   UT_SetTimeUs(0);
+
+} /* End Construct() */
+
+
+/******************************************************************************
+** Function: SetTimeMs
+**
+*/
+static void SetTimeMs(int64 TimeMs)
+{
+
+   UT_SetTimeUs(TimeMs * 1000);
+
+} /* End SetTimeMs() */
+
+
+/******************************************************************************
+** Function: TestWindow
+**
+*/
+static void TestWindow(void)
+{
+
+   uint32 Seq;
+   uint16 SlotIdx;
+   uint16 i;
+
+   Construct(false);
+   UT_ASSERT(Rel.SlotCnt == JMSG_UDP_PLATFORM_REL_SLOT_MAX && Rel.Window == WINDOW);
+
+   for (i=0; i < WINDOW; i++)
+   {
+      UT_ASSERT(JMSG_REL_Reserve("a", &Seq, &SlotIdx));
+      UT_ASSERT(Seq == i + 1u);
+   }
+   UT_ASSERT(!JMSG_REL_Reserve("a", &Seq, &SlotIdx));
+   UT_ASSERT(SlotIdx == JMSG_REL_UNDEF_SLOT && Rel.WindowFullCnt == 1);
+   UT_ASSERT(UT_EventCnt(JMSG_REL_TX_EID) == 1);
+
+   /* Topics have independent windows and sequence numbers */
+   UT_ASSERT(JMSG_REL_Reserve("b", &Seq, &SlotIdx));
+   UT_ASSERT(Seq == 1 && Rel.PendingCnt == WINDOW + 1);
+
+   /* Cancelling the most recent reservation returns its sequence number */
+   JMSG_REL_Cancel(SlotIdx);
+   UT_ASSERT(JMSG_REL_Reserve("b", &Seq, &SlotIdx));
+   UT_ASSERT(Seq == 1);
+
+   /* Slots aren't sent until JMSG_REL_Send() so there's nothing to service */
+   UT_ASSERT(JMSG_REL_ServiceTx() == OS_PEND);
+   UT_ASSERT(SendCnt == 0);
+
+} /* End TestWindow() */
+
+
+/******************************************************************************
+** Function: TestRetransmit
+**
+** A message is retransmitted with a doubling timeout and abandoned after
+** RETRY_LIM retries, RTO_MS*(2^(RETRY_LIM+1) - 1) after it was sent.
+**
+*/
+static void TestRetransmit(void)
+{
+
+   uint32 Seq;
+   uint16 SlotIdx;
+
+   Construct(false);
+   UT_ASSERT(JMSG_REL_ServiceTx() == OS_PEND);
+
+   UT_ASSERT(JMSG_REL_Reserve("a", &Seq, &SlotIdx));
+   UT_ASSERT(JMSG_REL_Send(SlotIdx, "a;r=1:{}", 8));
+   UT_ASSERT(SendCnt == 1 && SentPeer == NULL && strcmp(SentMsg, "a;r=1:{}") == 0);
+
+   SetTimeMs(RTO_MS - 1);
+   UT_ASSERT(JMSG_REL_ServiceTx() == 1);
+   UT_ASSERT(SendCnt == 1);
+
+   SetTimeMs(RTO_MS);
+   UT_ASSERT(JMSG_REL_ServiceTx() == 2*RTO_MS);
+   UT_ASSERT(SendCnt == 2 && Rel.RetryCnt == 1);
+
+   SetTimeMs(3*RTO_MS);
+   UT_ASSERT(JMSG_REL_ServiceTx() == 4*RTO_MS);
+   UT_ASSERT(SendCnt == 3 && Rel.RetryCnt == 2 && strcmp(SentMsg, "a;r=1:{}") == 0);
+
+   SetTimeMs(7*RTO_MS - 1);
+   UT_ASSERT(JMSG_REL_ServiceTx() == 1);
+
+   SetTimeMs(7*RTO_MS);
+   UT_ASSERT(JMSG_REL_ServiceTx() == OS_PEND);
+   UT_ASSERT(SendCnt == 3 && Rel.FailCnt == 1 && Rel.PendingCnt == 0);
+   UT_ASSERT(Rel.Topic[0].PendingCnt == 0);
+
+   /* A failed first send is retransmitted by the timer */
+   SendStatus = false;
+   UT_ASSERT(JMSG_REL_Reserve("a", &Seq, &SlotIdx));
+   UT_ASSERT(!JMSG_REL_Send(SlotIdx, "a;r=2:{}", 8));
+   SendStatus = true;
+   SetTimeMs(8*RTO_MS);
+   JMSG_REL_ServiceTx();
+   UT_ASSERT(SendCnt == 5 && strcmp(SentMsg, "a;r=2:{}") == 0);
+
+   /* A message longer than a slot is rejected */
+   UT_ASSERT(JMSG_REL_Reserve("a", &Seq, &SlotIdx));
+   UT_ASSERT(!JMSG_REL_Send(SlotIdx, SentMsg, 257));
+   JMSG_REL_Cancel(SlotIdx);
+
+} /* End TestRetransmit() */
+
+
+/******************************************************************************
+** Function: TestAck
+**
+*/
+static void TestAck(void)
+{
+
+   uint32 Seq[3];
+   uint16 SlotIdx;
+   uint16 i;
+
+   Construct(false);
+
+   for (i=0; i < 3; i++)
+   {
+      UT_ASSERT(JMSG_REL_Reserve("topic/x", &Seq[i], &SlotIdx));
+      UT_ASSERT(JMSG_REL_Send(SlotIdx, "m", 1));
+   }
+
+   /* Acks may arrive out of order and the topic isn't null terminated */
+   JMSG_REL_RecvAck("topic/x;a=2", 7, Seq[1]);
+   UT_ASSERT(Rel.AckRxCnt == 1 && Rel.PendingCnt == 2);
+
+   /* Duplicate, unknown sequence, unknown topic and prefix topic acks */
+   JMSG_REL_RecvAck("topic/x", 7, Seq[1]);
+   JMSG_REL_RecvAck("topic/x", 7, 99);
+   JMSG_REL_RecvAck("topic/y", 7, Seq[0]);
+   JMSG_REL_RecvAck("topic/", 6, Seq[0]);
+   UT_ASSERT(Rel.UnknownAckCnt == 4 && Rel.PendingCnt == 2);
+
+   JMSG_REL_RecvAck("topic/x", 7, Seq[2]);
+   JMSG_REL_RecvAck("topic/x", 7, Seq[0]);
+   UT_ASSERT(Rel.AckRxCnt == 3 && Rel.PendingCnt == 0);
+   UT_ASSERT(JMSG_REL_ServiceTx() == OS_PEND);
+
+} /* End TestAck() */
+
+
+/******************************************************************************
+** Function: TestSeqWrap
+**
+** Sequence numbers wrap from 0xFFFFFFFF to 0 and both are acknowledged.
+**
+*/
+static void TestSeqWrap(void)
+{
+
+   uint32 Seq[2];
+   uint16 SlotIdx[2];
+
+   Construct(false);
+
+   UT_ASSERT(JMSG_REL_Reserve("w", &Seq[0], &SlotIdx[0]));
+   JMSG_REL_Cancel(SlotIdx[0]);
+   Rel.Topic[0].NextSeq = 0xFFFFFFFF;
+
+   UT_ASSERT(JMSG_REL_Reserve("w", &Seq[0], &SlotIdx[0]));
+   UT_ASSERT(JMSG_REL_Reserve("w", &Seq[1], &SlotIdx[1]));
+   UT_ASSERT(Seq[0] == 0xFFFFFFFF && Seq[1] == 0);
+   UT_ASSERT(JMSG_REL_Send(SlotIdx[0], "m", 1) && JMSG_REL_Send(SlotIdx[1], "m", 1));
+
+   JMSG_REL_RecvAck("w", 1, 0);
+   JMSG_REL_RecvAck("w", 1, 0xFFFFFFFF);
+   UT_ASSERT(Rel.AckRxCnt == 2 && Rel.PendingCnt == 0);
+
+   /* Cancelling sequence 0 after a wrap returns it */
+   UT_ASSERT(JMSG_REL_Reserve("w", &Seq[0], &SlotIdx[0]));
+   UT_ASSERT(Seq[0] == 1);
+   JMSG_REL_Cancel(SlotIdx[0]);
+   UT_ASSERT(JMSG_REL_Reserve("w", &Seq[0], &SlotIdx[0]));
+   UT_ASSERT(Seq[0] == 1);
+
+} /* End TestSeqWrap() */
+
+
+/******************************************************************************
+** Function: TestSendAck
+**
+*/
+static void TestSendAck(void)
+{
+
+   JMSG_SOCK_RxInfo_t RxInfo;
+   char Topic[JMSG_PLATFORM_TOPIC_NAME_MAX_LEN + 16];
+
+   memset(&RxInfo, 0, sizeof(RxInfo));
+
+   Construct(false);
+   UT_ASSERT(JMSG_REL_SendAck(&RxInfo, "a/b;r=5", 3, 5));
+   UT_ASSERT(strcmp(SentMsg, "a/b;a=5:") == 0 && SentPeer == &RxInfo && Rel.AckTxCnt == 1);
+
+   /* A topic too long for an ack isn't truncated */
+   memset(Topic, 'x', sizeof(Topic));
+   UT_ASSERT(!JMSG_REL_SendAck(&RxInfo, Topic, sizeof(Topic), 5));
+   UT_ASSERT(Rel.AckTxCnt == 1 && UT_EventCnt(JMSG_REL_ACK_EID) == 1);
+
+   Construct(true);
+   UT_ASSERT(JMSG_REL_SendAck(&RxInfo, "a/b", 3, 4294967295u));
+   UT_ASSERT(strcmp(SentMsg, "a/b;a=4294967295:") == 0 && SentPeer == NULL);
+
+} /* End TestSendAck() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestWindow);
+   UT_RUN(TestRetransmit);
+   UT_RUN(TestAck);
+   UT_RUN(TestSeqWrap);
+   UT_RUN(TestSendAck);
+
+   return UT_Summary();
+
+} /* End main() */
@@ -0,0 +1,366 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for the route table loader, lookups and dump
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ut_jmsg.h"
+#include "jmsg_route_tbl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define TBL_FILE   "ut_route_tbl.json"
+#define DUMP_FILE  "ut_route_tbl_dump.json"
+
+#define DEMO_MSG_ID  0x1801
+#define TLM_MSG_ID   0x0882
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_ROUTE_TBL_Class_t RouteTbl;
+
+static JMSG_TOPIC_TBL_Topic_t Topic[] =
+{
+   { "basecamp/rpi/demo", "Demo",     DEMO_MSG_ID, 0, 0 },
+   { "conv/\"quoted\"",   "Escaped",  0x1802,      0, 0 }
+};
+
+static uint32 SubscribeCnt;
+static uint32 UnsubscribeCnt;
+
+static const char *ValidTbl =
+   "{\n"
+   "   \"title\": \"test\",\n"
+   "   \"route\": [\n"
+   "      { \"name\": \"basecamp/rpi/+/demo\", \"msg-id\": 0, \"converter\": \"basecamp/rpi/demo\",\n"
+   "        \"options\": { \"dir\": \"rx\" } },\n"
+   "      { \"name\": \"basecamp/tlm\", \"msg-id\": 2178, \"converter\": \"basecamp/rpi/demo\",\n"
+   "        \"options\": { \"dir\": \"tx\", \"msg-lim\": 8 },\n"
+   "        \"template\": { \"object\": \"tlm\", \"fields\": [ { \"key\": \"lux\", \"type\": \"uint16\", \"offset\": 0 } ] },\n"
+   "        \"filter\": \"lux > 400\" }\n"
+   "   ]\n"
+   "}\n";
+
+
+/*
+** Topic table stub
+*/
+
+const JMSG_TOPIC_TBL_Topic_t *JMSG_TOPIC_TBL_GetTopic(int TopicPluginId)
+{
+   return (TopicPluginId >= 0 && TopicPluginId < (int)(sizeof(Topic)/sizeof(Topic[0]))) ? &Topic[TopicPluginId] : NULL;
+}
+
+
+/******************************************************************************
+** Function: ConfigTxMsg
+**
+*/
+static bool ConfigTxMsg(const JMSG_ROUTE_TBL_TxSub_t *TxSub, bool Subscribe)
+{
+
+   if (Subscribe)
+   {
+      SubscribeCnt++;
+   }
+   else
+   {
+      UnsubscribeCnt++;
+   }
+
+   return true;
+
+} /* End ConfigTxMsg() */
+
+
+/******************************************************************************
+** Function: WriteFile
+**
+*/
+static void WriteFile(const char *Filename, const char *Text)
+{
+
+   FILE *File = fopen(Filename, "w");
+
+   fputs(Text, File);
+   fclose(File);
+
+} /* End WriteFile() */
+
+
+/******************************************************************************
+** Function: ReadFile
+**
+*/
+static size_t ReadFile(const char *Filename, char *Buf, size_t BufLen)
+{
+
+   FILE  *File = fopen(Filename, "r");
+   size_t Len  = fread(Buf, 1, BufLen - 1, File);
+
+   fclose(File);
+   Buf[Len] = '\0';
+
+   return Len;
+
+} /* End ReadFile() */
+
+
+/******************************************************************************
+** Function: Dump
+**
+*/
+static bool Dump(const char *Filename)
+{
+
+   osal_id_t FileHandle;
+   bool      RetStatus;
+
+   OS_OpenCreate(&FileHandle, Filename, OS_FILE_FLAG_CREATE | OS_FILE_FLAG_TRUNCATE, OS_WRITE_ONLY);
+   RetStatus = JMSG_ROUTE_TBL_DumpCmd(FileHandle);
+   OS_close(FileHandle);
+
+   return RetStatus;
+
+} /* End Dump() */
+
+
+/******************************************************************************
+** Function: LoadValid
+**
+*/
+static bool LoadValid(void)
+{
+
+   JMSG_ROUTE_TBL_Constructor(&RouteTbl, ConfigTxMsg);
+   WriteFile(TBL_FILE, ValidTbl);
+
+   return JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_REPLACE, TBL_FILE);
+
+} /* End LoadValid() */
+
+
+/******************************************************************************
+** Function: TestLoad
+**
+*/
+static void TestLoad(void)
+{
+
+   JMSG_ROUTE_TBL_Lookup_t Lookup;
+
+   SubscribeCnt = 0;
+   UT_ASSERT(LoadValid());
+   UT_ASSERT(JMSG_ROUTE_TBL_GetRouteCnt() == 2);
+   UT_ASSERT(SubscribeCnt == 1);
+
+   UT_ASSERT(JMSG_ROUTE_TBL_RxLookup("basecamp/rpi/x/demo", 19, &Lookup));
+   UT_ASSERT(Lookup.RouteIdx == 0 && Lookup.Route.Converter == 0 && Lookup.Route.Dir == JMSG_ROUTE_TBL_DIR_RX);
+   UT_ASSERT(Lookup.Tmpl == NULL && Lookup.BankIdx == JMSG_ROUTE_TBL_UNDEF_IDX);
+   UT_ASSERT(!JMSG_ROUTE_TBL_RxLookup("basecamp/tlm", 12, &Lookup));
+
+   UT_ASSERT(JMSG_ROUTE_TBL_TxLookup(CFE_SB_ValueToMsgId(TLM_MSG_ID), &Lookup));
+   UT_ASSERT(Lookup.RouteIdx == 1 && Lookup.Route.SbMsgLim == 8);
+   UT_ASSERT(Lookup.Tmpl != NULL && Lookup.Tmpl->FieldCnt == 1);
+   UT_ASSERT(Lookup.Filter != NULL && Lookup.Route.FilterIdx != JMSG_ROUTE_TBL_UNDEF_IDX);
+   UT_ASSERT(RouteTbl.PinCnt[RouteTbl.BankActive] == 1);
+   JMSG_ROUTE_TBL_Release(&Lookup);
+   JMSG_ROUTE_TBL_Release(&Lookup);
+   UT_ASSERT(RouteTbl.PinCnt[RouteTbl.BankActive] == 0);
+   UT_ASSERT(!JMSG_ROUTE_TBL_TxLookup(CFE_SB_ValueToMsgId(DEMO_MSG_ID), &Lookup));
+   UT_ASSERT(RouteTbl.PinCnt[0] == 0 && RouteTbl.PinCnt[1] == 0);
+
+} /* End TestLoad() */
+
+
+/******************************************************************************
+** Function: TestPin
+**
+** A bank pinned by a lookup must not be rebuilt until it's released.
+**
+*/
+static void TestPin(void)
+{
+
+   JMSG_ROUTE_TBL_Lookup_t Lookup;
+   uint16 BankActive;
+   uint32 EventCnt;
+
+   UT_ASSERT(LoadValid());
+   BankActive = RouteTbl.BankActive;
+   UT_ASSERT(JMSG_ROUTE_TBL_TxLookup(CFE_SB_ValueToMsgId(TLM_MSG_ID), &Lookup));
+   UT_ASSERT(Lookup.BankIdx == BankActive);
+
+   /* The pinned bank becomes inactive after one load and can't be rebuilt by the next */
+   UT_ASSERT(JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_REPLACE, TBL_FILE));
+   UT_ASSERT(RouteTbl.BankActive != BankActive);
+   EventCnt = UT_EventCnt(JMSG_ROUTE_TBL_LOAD_EID);
+   UT_ASSERT(!JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_REPLACE, TBL_FILE));
+   UT_ASSERT(UT_EventCnt(JMSG_ROUTE_TBL_LOAD_EID) > EventCnt);
+   UT_ASSERT(Lookup.Tmpl->FieldCnt == 1);
+
+   JMSG_ROUTE_TBL_Release(&Lookup);
+   UT_ASSERT(JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_REPLACE, TBL_FILE));
+   UT_ASSERT(RouteTbl.BankActive == BankActive);
+
+} /* End TestPin() */
+
+
+/******************************************************************************
+** Function: TestReject
+**
+** Invalid tables must leave the active routes unchanged.
+**
+*/
+static void TestReject(void)
+{
+
+   static const char *BadTbl[] =
+   {
+      "{\"route\": [ {\"name\": \"a\", \"converter\": \"basecamp/rpi/demo\"} ",
+      "{\"route\": [ {\"name\": \"a\", \"converter\": \"unknown\"} ]}",
+      "{\"route\": [ {\"name\": \"a\\\"b\", \"converter\": \"basecamp/rpi/demo\"} ]}",
+      "{\"route\": [ {\"name\": \"a\tb\", \"converter\": \"basecamp/rpi/demo\"} ]}",
+      "{\"route\": [ {\"name\": \"a/#\", \"converter\": \"basecamp/rpi/demo\", \"options\": {\"dir\": \"tx\"}} ]}",
+      "{\"route\": [ {\"name\": \"a\", \"converter\": \"basecamp/rpi/demo\"}, "
+                    "{\"name\": \"b\", \"converter\": \"basecamp/rpi/demo\"} ]}",
+      "{\"route\": [ {\"name\": \"a\", \"converter\": \"basecamp/rpi/demo\", \"filter\": \"nokey > 1\"} ]}",
+      "{\"route\": [ {\"name\": \"a\", \"converter\": \"basecamp/rpi/demo\", \"options\": {\"dir\": \"up\", \"priority\": 1}} ]}"
+   };
+   JMSG_ROUTE_TBL_Lookup_t Lookup;
+   uint16 i;
+   uint32 EventCnt;
+
+   UT_ASSERT(LoadValid());
+
+   for (i=0; i < sizeof(BadTbl)/sizeof(BadTbl[0]); i++)
+   {
+      WriteFile(TBL_FILE, BadTbl[i]);
+      EventCnt = UT_EventCnt(JMSG_ROUTE_TBL_LOAD_EID) + UT_EventCnt(JMSG_ROUTE_TBL_CONFIG_EID);
+      if (!UT_ASSERT(!JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_REPLACE, TBL_FILE)))
+      {
+         printf("Accepted bad table %u\n", i);
+      }
+      UT_ASSERT(UT_EventCnt(JMSG_ROUTE_TBL_LOAD_EID) + UT_EventCnt(JMSG_ROUTE_TBL_CONFIG_EID) > EventCnt);
+      UT_ASSERT(JMSG_ROUTE_TBL_GetRouteCnt() == 2);
+      UT_ASSERT(JMSG_ROUTE_TBL_RxLookup("basecamp/rpi/x/demo", 19, &Lookup));
+   }
+
+   UT_ASSERT(!JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_UPDATE, TBL_FILE));
+   UT_ASSERT(!JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_REPLACE, "no_such_file.json"));
+
+} /* End TestReject() */
+
+
+/******************************************************************************
+** Function: TestStaged
+**
+** Staged routes are only subscribed when the caller asks for it.
+**
+*/
+static void TestStaged(void)
+{
+
+   static const char *TxTbl =
+      "{\"route\": [ {\"name\": \"a\", \"msg-id\": 2179, \"converter\": \"basecamp/rpi/demo\", "
+                    "\"options\": {\"dir\": \"tx\"}} ]}";
+   JMSG_ROUTE_TBL_Lookup_t Lookup;
+
+   UT_ASSERT(LoadValid());
+   WriteFile(TBL_FILE, TxTbl);
+   SubscribeCnt   = 0;
+   UnsubscribeCnt = 0;
+   UT_ASSERT(JMSG_ROUTE_TBL_StageTbl(TBL_FILE));
+   UT_ASSERT(JMSG_ROUTE_TBL_ActivateStaged(false));
+   UT_ASSERT(SubscribeCnt == 0 && UnsubscribeCnt == 0);
+   UT_ASSERT(JMSG_ROUTE_TBL_TxLookup(CFE_SB_ValueToMsgId(2179), &Lookup));
+   JMSG_ROUTE_TBL_Release(&Lookup);
+
+   UT_ASSERT(LoadValid());
+   WriteFile(TBL_FILE, TxTbl);
+   SubscribeCnt   = 0;
+   UnsubscribeCnt = 0;
+   UT_ASSERT(JMSG_ROUTE_TBL_StageTbl(TBL_FILE));
+   UT_ASSERT(JMSG_ROUTE_TBL_ActivateStaged(true));
+   UT_ASSERT(SubscribeCnt == 1 && UnsubscribeCnt == 1);
+
+} /* End TestStaged() */
+
+
+/******************************************************************************
+** Function: TestDump
+**
+** A dump must load back to the same routes and escape names that aren't
+** valid JSON string content.
+**
+*/
+static void TestDump(void)
+{
+
+   static char DumpText[8192];
+   JMSG_ROUTE_TBL_Lookup_t Lookup;
+
+   UT_ASSERT(LoadValid());
+   UT_ASSERT(Dump(DUMP_FILE));
+   UT_ASSERT(JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_REPLACE, DUMP_FILE));
+   UT_ASSERT(JMSG_ROUTE_TBL_GetRouteCnt() == 2);
+   UT_ASSERT(JMSG_ROUTE_TBL_TxLookup(CFE_SB_ValueToMsgId(TLM_MSG_ID), &Lookup));
+   UT_ASSERT(Lookup.Route.SbMsgLim == 8 && Lookup.Tmpl->FieldCnt == 1 && Lookup.Filter != NULL);
+   JMSG_ROUTE_TBL_Release(&Lookup);
+
+   /* A converter name from the topic table can hold any character */
+   WriteFile(TBL_FILE, "{\"route\": [ {\"name\": \"a\", \"converter\": \"basecamp/rpi/demo\"} ]}");
+   UT_ASSERT(JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_REPLACE, TBL_FILE));
+   RouteTbl.Bank[RouteTbl.BankActive].Route[0].Converter = 1;
+   UT_ASSERT(Dump(DUMP_FILE));
+   ReadFile(DUMP_FILE, DumpText, sizeof(DumpText));
+   UT_ASSERT(strstr(DumpText, "\"converter\": \"conv/\\\"quoted\\\"\"") != NULL);
+
+} /* End TestDump() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestLoad);
+   UT_RUN(TestPin);
+   UT_RUN(TestReject);
+   UT_RUN(TestStaged);
+   UT_RUN(TestDump);
+
+   unlink(TBL_FILE);
+   unlink(DUMP_FILE);
+
+   return UT_Summary();
+
+} /* End main() */
@@ -0,0 +1,822 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Bound the Rx path's time and stack use on worst case and fuzzed input
+**
+** Notes:
+**   1. Each datagram is passed to JMSG_TRANS_ProcessJMsg() with the route
+**      table, fragment reassembly, reliable acks, duplicate detection, LZ
+**      decompression, the decode queue and the translator linked in. The
+**      topic plugin converter, SB, cFE message, child manager and capture
+**      functions are fakes. A message longer than a datagram is split into
+**      fragments by JMSG_FRAG_Send() and each fragment is a case.
+**   2. The cases run once with payloads decoded on the Rx task and once
+**      with a decode worker whose queue is drained after each datagram.
+**   3. A case's time is the thread CPU time of the datagram and any decode
+**      it queued so preemption of the test doesn't count against the
+**      bound. The longest case must be under the default
+**      RX_PROC_TIME_LIM_US.
+**   4. The cases are processed on a thread whose stack is painted with
+**      STACK_PAINT. The deepest overwritten byte, less the stack used by a
+**      thread that returns immediately, must be under STACK_LIM.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ut_jmsg.h"
+#include "jmsg_cap.h"
+#include "jmsg_decode.h"
+#include "jmsg_frag.h"
+#include "jmsg_lz.h"
+#include "jmsg_mem.h"
+#include "jmsg_rel.h"
+#include "jmsg_route_tbl.h"
+#include "jmsg_selftest.h"
+#include "jmsg_trans.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define TEST_DATAGRAM_LEN  JMSG_UDP_BUF_LEN
+#define TEST_FRAG_CNT      JMSG_UDP_PLATFORM_FRAG_CNT_MAX
+#define TEST_FRAG_HDR_LEN  64      /* Room for a fragment's header */
+#define TEST_MSG_LEN       (TEST_FRAG_CNT*(TEST_DATAGRAM_LEN - TEST_FRAG_HDR_LEN))  /* Longest fragmented JMSG */
+#define TEST_QUEUE_LEN     (128*1024)
+#define TEST_MAX_DEPTH     16      /* Default JSON_MAX_DEPTH */
+#define TIME_LIM_US        5000    /* Default RX_PROC_TIME_LIM_US */
+#define STACK_LIM          (16*1024)
+#define STACK_LEN          (256*1024)
+#define STACK_PAINT        0xA5
+#define FUZZ_CNT           20000
+
+#define TBL_FILE  "ut_rx_bound_tbl.json"
+
+#define TOPIC         "basecamp/rate"
+#define PLUGIN_TOPIC  "basecamp/plugin"
+#define JSON          "{\"rate\":{\"x\":1.5, \"n\":7, \"other\":[1,2,{\"deep\":\"text\\n\"}]}}"
+
+#define RATE_MSG_ID    0x0885
+#define PLUGIN_MSG_ID  0x0886
+
+#define PEER_ADDR  0x0A000002
+#define PEER_PORT  5000
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static INITBL_Class_t          IniTbl;
+static JMSG_MEM_Class_t        Mem;
+static JMSG_ROUTE_TBL_Class_t  RouteTbl;
+static JMSG_TRANS_Class_t      Trans;
+static JMSG_FRAG_Class_t       Frag;
+static JMSG_REL_Class_t        Rel;
+static JMSG_LZ_Class_t         Lz;
+static JMSG_SELFTEST_Class_t   SelfTest;
+static JMSG_DECODE_Class_t     Decode;
+
+static JMSG_TOPIC_TBL_Topic_t Topic[] =
+{
+   { TOPIC,        "Rate",   RATE_MSG_ID,   0, 0 },
+   { PLUGIN_TOPIC, "Plugin", PLUGIN_MSG_ID, 0, 0 }
+};
+
+static const char *RouteTblText =
+   "{\n"
+   "   \"route\": [\n"
+   "      { \"name\": \"" TOPIC "\", \"msg-id\": 2181, \"converter\": \"" TOPIC "\",\n"
+   "        \"options\": { \"dir\": \"rx\" },\n"
+   "        \"template\": { \"object\": \"rate\", \"fields\": [\n"
+   "           { \"key\": \"x\", \"type\": \"double\", \"offset\": 0 },\n"
+   "           { \"key\": \"n\", \"type\": \"uint16\", \"offset\": 8 } ] } },\n"
+   "      { \"name\": \"" PLUGIN_TOPIC "\", \"msg-id\": 0, \"converter\": \"" PLUGIN_TOPIC "\",\n"
+   "        \"options\": { \"dir\": \"rx\" } },\n"
+   "      { \"name\": \"+/+/+/+/+/+/+/+/#\", \"msg-id\": 0, \"converter\": \"" PLUGIN_TOPIC "\",\n"
+   "        \"options\": { \"dir\": \"rx\" } },\n"
+   "      { \"name\": \"#\", \"msg-id\": 0, \"converter\": \"" PLUGIN_TOPIC "\",\n"
+   "        \"options\": { \"dir\": \"rx\" } }\n"
+   "   ]\n"
+   "}\n";
+
+static JMSG_SOCK_RxInfo_t Peer;
+
+static CFE_MSG_TelemetryHeader_t PluginMsg;
+
+static char   *Msg;
+static uint32 Seq;
+static uint32 MaxUs;
+static uint32 MaxUsCase;
+static uint32 CaseCnt;
+
+/*
+** Fragments of the message being sent by JMSG_FRAG_Send()
+*/
+
+static char   Datagram[TEST_FRAG_CNT][TEST_DATAGRAM_LEN];
+static uint16 DatagramLen[TEST_FRAG_CNT];
+static uint16 DatagramCnt;
+
+/*
+** Fake call counts
+*/
+
+static uint32 SbSendCnt;
+static uint32 ConvCnt;
+static uint32 AckCnt;
+static uint32 CapCnt;
+
+
+/******************************************************************************
+** Fake topic table functions
+**
+** The plugin converter returns a fixed message for any non-empty payload.
+*/
+static bool JsonToCfe(CFE_MSG_Message_t **CfeMsg, const char *Payload, uint16 PayloadLen)
+{
+   ConvCnt++;
+   CFE_MSG_Init(CFE_MSG_PTR(PluginMsg), CFE_SB_ValueToMsgId(PLUGIN_MSG_ID), sizeof(PluginMsg));
+   *CfeMsg = CFE_MSG_PTR(PluginMsg);
+   return (PayloadLen > 0);
+}
+
+const JMSG_TOPIC_TBL_Topic_t *JMSG_TOPIC_TBL_GetTopic(int TopicPluginId)
+{
+   return (TopicPluginId >= 0 && TopicPluginId < (int)(sizeof(Topic)/sizeof(Topic[0]))) ? &Topic[TopicPluginId] : NULL;
+}
+
+JMSG_TOPIC_TBL_JsonToCfe_t JMSG_TOPIC_TBL_GetJsonToCfe(int TopicPluginId)
+{
+   return JsonToCfe;
+}
+
+JMSG_TOPIC_TBL_CfeToJson_t JMSG_TOPIC_TBL_GetCfeToJson(int TopicPluginId, const char **JsonMsgTopic)
+{
+   return NULL;
+}
+
+
+/******************************************************************************
+** Fake cFE message and SB functions
+**
+** The message ID is in bytes 0-1 and the message size in bytes 4-5. A
+** message ID with bit 0x1000 set is a command.
+*/
+int32 CFE_MSG_Init(CFE_MSG_Message_t *MsgPtr, CFE_SB_MsgId_t MsgId, CFE_MSG_Size_t Size)
+{
+   memset(MsgPtr, 0, sizeof(CFE_MSG_Message_t));
+   CFE_MSG_SetMsgId(MsgPtr, MsgId);
+   MsgPtr->Byte[4] = (uint8)(Size >> 8);
+   MsgPtr->Byte[5] = (uint8)Size;
+   return CFE_SUCCESS;
+}
+
+int32 CFE_MSG_SetMsgId(CFE_MSG_Message_t *MsgPtr, CFE_SB_MsgId_t MsgId)
+{
+   MsgPtr->Byte[0] = (uint8)(CFE_SB_MsgIdToValue(MsgId) >> 8);
+   MsgPtr->Byte[1] = (uint8)CFE_SB_MsgIdToValue(MsgId);
+   return CFE_SUCCESS;
+}
+
+int32 CFE_MSG_GetMsgId(const CFE_MSG_Message_t *MsgPtr, CFE_SB_MsgId_t *MsgId)
+{
+   *MsgId = CFE_SB_ValueToMsgId((MsgPtr->Byte[0] << 8) | MsgPtr->Byte[1]);
+   return CFE_SUCCESS;
+}
+
+int32 CFE_MSG_GetSize(const CFE_MSG_Message_t *MsgPtr, CFE_MSG_Size_t *Size)
+{
+   *Size = (MsgPtr->Byte[4] << 8) | MsgPtr->Byte[5];
+   return CFE_SUCCESS;
+}
+
+int32 CFE_MSG_GetTypeFromMsgId(CFE_SB_MsgId_t MsgId, CFE_MSG_Type_t *Type)
+{
+   *Type = (CFE_SB_MsgIdToValue(MsgId) & 0x1000) ? CFE_MSG_Type_Cmd : CFE_MSG_Type_Tlm;
+   return CFE_SUCCESS;
+}
+
+int32 CFE_MSG_GetType(const CFE_MSG_Message_t *MsgPtr, CFE_MSG_Type_t *Type)
+{
+   CFE_SB_MsgId_t MsgId;
+   CFE_MSG_GetMsgId(MsgPtr, &MsgId);
+   return CFE_MSG_GetTypeFromMsgId(MsgId, Type);
+}
+
+int32 CFE_MSG_SetFcnCode(CFE_MSG_Message_t *MsgPtr, uint16 FcnCode)
+{
+   return CFE_SUCCESS;
+}
+
+int32 CFE_MSG_GenerateChecksum(CFE_MSG_Message_t *MsgPtr)
+{
+   return CFE_SUCCESS;
+}
+
+int32 CFE_MSG_SetMsgTime(CFE_MSG_Message_t *MsgPtr, CFE_TIME_SysTime_t NewTime)
+{
+   return CFE_SUCCESS;
+}
+
+int32 CFE_SB_TransmitMsg(const CFE_MSG_Message_t *MsgPtr, bool IncrementSequenceCount)
+{
+   SbSendCnt++;
+   return CFE_SUCCESS;
+}
+
+
+/******************************************************************************
+** Fake child manager and task functions
+**
+** Decode workers aren't run as tasks, see DrainWorker().
+*/
+int32 CHILDMGR_Constructor(CHILDMGR_Class_t *ChildMgr, void (*ChildTaskMainFunc)(void),
+                           CHILDMGR_TaskCallback_t TaskCallback, CHILDMGR_TaskInit_t *TaskInit)
+{
+   return CFE_SUCCESS;
+}
+
+void ChildMgr_TaskMainCallback(void)
+{
+}
+
+void CHILDMGR_ResetStatus(CHILDMGR_Class_t *ChildMgr)
+{
+}
+
+int32 CFE_ES_DeleteChildTask(CFE_ES_TaskId_t TaskId)
+{
+   return CFE_SUCCESS;
+}
+
+
+/******************************************************************************
+** Fake capture functions
+**
+** Capture is active so queued entries carry their datagram.
+*/
+bool JMSG_CAP_IsActive(void)
+{
+   return true;
+}
+
+void JMSG_CAP_Rx(const char *Data, uint16 DataLen, const JMSG_SOCK_RxInfo_t *RxInfo,
+                 uint32 MsgId)
+{
+   CapCnt++;
+}
+
+
+/******************************************************************************
+** Function: FragSendMsg
+**
+** Keep a fragment sent by JMSG_FRAG_Send().
+**
+*/
+static bool FragSendMsg(const char *MsgData, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *PeerPtr)
+{
+
+   if (DatagramCnt >= TEST_FRAG_CNT || MsgLen > TEST_DATAGRAM_LEN)
+   {
+      return false;
+   }
+
+   memcpy(Datagram[DatagramCnt], MsgData, MsgLen);
+   DatagramLen[DatagramCnt++] = MsgLen;
+
+   return true;
+
+} /* End FragSendMsg() */
+
+
+/******************************************************************************
+** Function: RelSendMsg
+**
+*/
+static bool RelSendMsg(const char *MsgData, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *PeerPtr)
+{
+
+   AckCnt++;
+
+   return true;
+
+} /* End RelSendMsg() */
+
+
+/******************************************************************************
+** Function: SelfTestSendMsg
+**
+*/
+static bool SelfTestSendMsg(const char *MsgData, uint16 MsgLen, const JMSG_SOCK_RxInfo_t *PeerPtr)
+{
+
+   return true;
+
+} /* End SelfTestSendMsg() */
+
+
+/******************************************************************************
+** Function: Construct
+**
+** Construct the Rx path's modules in the gateway's order and load the
+** route table.
+**
+*/
+static bool Construct(uint32 WorkerCnt)
+{
+
+   FILE *File;
+
+   UT_SetIniInt(CFG_DATAGRAM_LEN, TEST_DATAGRAM_LEN);
+   UT_SetIniInt(CFG_FRAG_CNT, TEST_FRAG_CNT);
+   UT_SetIniInt(CFG_FRAG_POOL_CNT, 2);
+   UT_SetIniInt(CFG_FRAG_TIMEOUT_MS, 1000);
+   UT_SetIniInt(CFG_JSON_MAX_DEPTH, TEST_MAX_DEPTH);
+   UT_SetIniInt(CFG_LZ_MIN_LEN, 64);
+   UT_SetIniStr(CFG_LZ_DICT_FILE, "");
+   UT_SetIniInt(CFG_REL_SLOT_CNT, 4);
+   UT_SetIniInt(CFG_REL_WINDOW, 4);
+   UT_SetIniInt(CFG_REL_RTO_MS, 100);
+   UT_SetIniInt(CFG_REL_RETRY_LIM, 3);
+   UT_SetIniInt(CFG_DECODE_WORKER_CNT, WorkerCnt);
+   UT_SetIniInt(CFG_DECODE_QUEUE_DEPTH, 8);
+   UT_SetIniInt(CFG_DECODE_QUEUE_LEN, TEST_QUEUE_LEN);
+
+   JMSG_MEM_Constructor(&Mem, &IniTbl);
+   JMSG_ROUTE_TBL_Constructor(&RouteTbl, NULL);
+   JMSG_TRANS_Constructor(&Trans, &IniTbl);
+   JMSG_FRAG_Constructor(&Frag, &IniTbl, FragSendMsg);
+   JMSG_REL_Constructor(&Rel, &IniTbl, RelSendMsg);
+   JMSG_LZ_Constructor(&Lz, &IniTbl);
+   JMSG_SELFTEST_Constructor(&SelfTest, SelfTestSendMsg);
+   JMSG_DECODE_Constructor(&Decode, &IniTbl);
+
+   File = fopen(TBL_FILE, "w");
+   fputs(RouteTblText, File);
+   fclose(File);
+
+   Peer.PeerAddr = PEER_ADDR;
+   Peer.PeerPort = PEER_PORT;
+
+   MaxUs     = 0;
+   MaxUsCase = 0;
+   CaseCnt   = 0;
+   SbSendCnt = 0;
+   ConvCnt   = 0;
+   AckCnt    = 0;
+   CapCnt    = 0;
+
+   return (JMSG_ROUTE_TBL_LoadCmd(APP_C_FW_TblLoadOptions_REPLACE, TBL_FILE) &&
+           JMSG_DECODE_StartWorkers(&IniTbl));
+
+} /* End Construct() */
+
+
+/******************************************************************************
+** Function: CpuTimeUs
+**
+*/
+static int64 CpuTimeUs(void)
+{
+
+   struct timespec Now;
+
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &Now);
+
+   return (int64)Now.tv_sec*1000000 + Now.tv_nsec/1000;
+
+} /* End CpuTimeUs() */
+
+
+/******************************************************************************
+** Function: Run
+**
+** Process a datagram and decode what it queued, see note 3.
+**
+*/
+static void Run(const char *MsgData, uint16 MsgLen)
+{
+
+   int64  StartUs = CpuTimeUs();
+   uint32 Us;
+   uint16 i;
+
+   JMSG_TRANS_ProcessJMsg(MsgData, MsgLen, &Peer);
+   for (i=0; i < Decode.WorkerCnt; i++)
+   {
+      while (Decode.Worker[i].Queued > 0)
+      {
+         JMSG_DECODE_WorkerTask(&Decode.Worker[i].ChildMgr);
+      }
+   }
+
+   Us = (uint32)(CpuTimeUs() - StartUs);
+   if (Us > MaxUs)
+   {
+      MaxUs     = Us;
+      MaxUsCase = CaseCnt;
+   }
+   CaseCnt++;
+
+} /* End Run() */
+
+
+/******************************************************************************
+** Function: Send
+**
+** Run Msg as one datagram or as fragments of Topic's message if it's
+** longer than a datagram.
+**
+*/
+static void Send(const char *TopicName, uint16 MsgLen)
+{
+
+   uint16 i;
+
+   if (MsgLen <= TEST_DATAGRAM_LEN)
+   {
+      Run(Msg, MsgLen);
+      return;
+   }
+
+   DatagramCnt = 0;
+   if (UT_ASSERT(JMSG_FRAG_Send(TopicName, Msg, MsgLen)))
+   {
+      for (i=0; i < DatagramCnt; i++)
+      {
+         Run(Datagram[i], DatagramLen[i]);
+      }
+   }
+
+} /* End Send() */
+
+
+/******************************************************************************
+** Function: Fill
+**
+** Write Prefix, Repeat until Suffix fits in Len bytes and Suffix to the
+** message and return its length.
+**
+*/
+static uint16 Fill(const char *Prefix, const char *Repeat, const char *Suffix, uint32 Len)
+{
+
+   uint32 MsgLen = strlen(Prefix);
+   uint32 RepeatLen = strlen(Repeat);
+   uint32 SuffixLen = strlen(Suffix);
+
+   memcpy(Msg, Prefix, MsgLen);
+   while (MsgLen + RepeatLen + SuffixLen <= Len)
+   {
+      memcpy(&Msg[MsgLen], Repeat, RepeatLen);
+      MsgLen += RepeatLen;
+   }
+   memcpy(&Msg[MsgLen], Suffix, SuffixLen);
+
+   return (uint16)(MsgLen + SuffixLen);
+
+} /* End Fill() */
+
+
+/******************************************************************************
+** Function: SendZip
+**
+** Compress the payload of a message built by Fill() with header Hdr and
+** send it with a "z" attribute.
+**
+*/
+static void SendZip(const char *Hdr, const char *Repeat, const char *Suffix)
+{
+
+   static char Payload[TEST_MSG_LEN];
+   const uint8 *Zip;
+   uint32 ZipLen;
+   uint16 PayloadLen;
+   int    HdrLen;
+
+   PayloadLen = Fill("", Repeat, Suffix, TEST_MSG_LEN - TEST_FRAG_HDR_LEN);
+   memcpy(Payload, Msg, PayloadLen);
+
+   Zip = JMSG_LZ_Compress(TOPIC, Payload, PayloadLen, 0, &ZipLen);
+   if (UT_ASSERT(Zip != NULL))
+   {
+      HdrLen = snprintf(Msg, TEST_FRAG_HDR_LEN, "%s;z=%u:", Hdr, (unsigned int)PayloadLen);
+      memcpy(&Msg[HdrLen], Zip, ZipLen);
+      Send(TOPIC, HdrLen + ZipLen);
+   }
+
+} /* End SendZip() */
+
+
+/******************************************************************************
+** Function: WorstCases
+**
+** Run messages that make each stage do the most work.
+**
+*/
+static void WorstCases(void)
+{
+
+   char   Hdr[TEST_FRAG_HDR_LEN];
+   uint16 Len;
+   uint16 i;
+
+   /* No colon, an attribute list as long as the message and a topic that's too long */
+   Send(TOPIC, Fill("", "a", "", TEST_MSG_LEN));
+   Send(TOPIC, Fill(TOPIC, ";s=4294967295", ":{}", TEST_MSG_LEN));
+   Send(TOPIC, Fill(TOPIC, ";", ":{}", TEST_MSG_LEN));
+   Send(TOPIC, Fill("", "a/", ":{}", TEST_DATAGRAM_LEN));
+
+   /* Nesting past the depth limit, nesting at the limit and the widest index */
+   Send(TOPIC, Fill(TOPIC ":", "[", "", TEST_MSG_LEN));
+   Send(PLUGIN_TOPIC, Fill(PLUGIN_TOPIC ":[", "[[[[[[[[[[[[[[[]]]]]]]]]]]]]]],", "[]]", TEST_MSG_LEN));
+   Send(PLUGIN_TOPIC, Fill(PLUGIN_TOPIC ":[", "0,", "0]", TEST_MSG_LEN));
+   Send(PLUGIN_TOPIC, Fill(PLUGIN_TOPIC ":{", "\"\":{},", "\"\":{}}", TEST_MSG_LEN));
+
+   /* Strings of escapes, multibyte characters and a bad byte at the end */
+   Send(PLUGIN_TOPIC, Fill(PLUGIN_TOPIC ":[\"", "\\\\\\\"", "\"]", TEST_MSG_LEN));
+   Send(PLUGIN_TOPIC, Fill(PLUGIN_TOPIC ":[\"", "\xF0\x9F\x9A\x80", "\"]", TEST_MSG_LEN));
+   Send(PLUGIN_TOPIC, Fill(PLUGIN_TOPIC ":[\"", "\xE2\x82\xAC", "\xFF\"]", TEST_MSG_LEN));
+   Send(PLUGIN_TOPIC, Fill(PLUGIN_TOPIC ":[\"", " ", "\"]", TEST_MSG_LEN));
+   Send(PLUGIN_TOPIC, Fill(PLUGIN_TOPIC ":", " ", "{}", TEST_MSG_LEN));
+
+   /* Topics matched by the deepest wildcard pattern */
+   Send(TOPIC, Fill("a/b/c/d/e/f/g/h/", "i/", ":{}", JMSG_PLATFORM_TOPIC_NAME_MAX_LEN));
+
+   /* Payloads decompressed to the longest message, a reliable one and a corrupt one */
+   SendZip(PLUGIN_TOPIC, "[0,1,2,3,4,5,6,7,8,9],", "[]");
+   snprintf(Hdr, sizeof(Hdr), "%s;r=%u", PLUGIN_TOPIC, (unsigned int)++Seq);
+   SendZip(Hdr, "{\"a\":\"\\u00e9\"},", "{}");
+   Len = Fill(TOPIC ";z=60000:", "\xFF", "", TEST_DATAGRAM_LEN);
+   Send(TOPIC, Len);
+
+   /* A reliable message, its duplicate and an ack */
+   Len = snprintf(Msg, TEST_DATAGRAM_LEN, "%s;r=%u:%s", PLUGIN_TOPIC, (unsigned int)++Seq, JSON);
+   Send(PLUGIN_TOPIC, Len);
+   Send(PLUGIN_TOPIC, Len);
+   Send(PLUGIN_TOPIC, snprintf(Msg, TEST_DATAGRAM_LEN, "%s;a=%u:", PLUGIN_TOPIC, (unsigned int)Seq));
+
+   /* Long numbers in the learned shape, its mantissa and its exponent */
+   for (i=0; i < 2; i++)
+   {
+      Send(TOPIC, snprintf(Msg, TEST_DATAGRAM_LEN, "%s:%s", TOPIC, JSON));
+      Send(TOPIC, Fill(TOPIC ":{\"rate\":{\"x\":1", "1", ", \"n\":7, \"other\":[1,2,{\"deep\":\"text\\n\"}]}}", TEST_MSG_LEN));
+      Send(TOPIC, Fill(TOPIC ":{\"rate\":{\"x\":0.", "0", "1, \"n\":7, \"other\":[1,2,{\"deep\":\"text\\n\"}]}}", TEST_MSG_LEN));
+      Send(TOPIC, Fill(TOPIC ":{\"rate\":{\"x\":1e", "0", "1, \"n\":7, \"other\":[1,2,{\"deep\":\"text\\n\"}]}}", TEST_MSG_LEN));
+      Send(TOPIC, Fill(TOPIC ":{\"rate\":{\"x\":1.5, \"n\":7, \"other\":[1,2,{\"deep\":\"text\\n\"}]}}", " ", "x", TEST_MSG_LEN));
+
+      /* Second pass with the shape cache full of other topics */
+      for (Len=0; Len < JMSG_UDP_PLATFORM_SHAPE_MAX; Len++)
+      {
+         Send(TOPIC, snprintf(Msg, TEST_DATAGRAM_LEN, "basecamp/%u:{\"rate\":{\"x\":1,\"n\":2}}", Len));
+      }
+   }
+
+} /* End WorstCases() */
+
+
+/******************************************************************************
+** Function: FuzzCases
+**
+** Run random mutations of valid datagrams.
+**
+*/
+static void FuzzCases(void)
+{
+
+   static const char Mutation[] = "{}[]:,\"\\/;=0123456789.eE-+ afrstz\xC3\xA9\xFF";
+   static const char *ValidFmt[] =
+   {
+      TOPIC ";s=%u:" JSON,
+      PLUGIN_TOPIC ";r=%u:" JSON,
+      PLUGIN_TOPIC ";f=%u.0.2:" PLUGIN_TOPIC ":[1,2,"
+   };
+   uint16 MsgLen;
+   uint16 Pos;
+   uint16 MutationCnt;
+   uint32 i;
+   uint16 j;
+
+   srand(41);
+   for (i=0; i < FUZZ_CNT; i++)
+   {
+      MsgLen = snprintf(Msg, TEST_DATAGRAM_LEN, ValidFmt[i % (sizeof(ValidFmt)/sizeof(ValidFmt[0]))],
+                        (unsigned int)++Seq);
+      MutationCnt = 1 + rand() % 8;
+      for (j=0; j < MutationCnt; j++)
+      {
+         Pos = rand() % MsgLen;
+         switch (rand() % 3)
+         {
+            case 0:
+               Msg[Pos] = Mutation[rand() % (sizeof(Mutation) - 1)];
+               break;
+            case 1:
+               if (MsgLen < TEST_DATAGRAM_LEN)
+               {
+                  memmove(&Msg[Pos+1], &Msg[Pos], MsgLen - Pos);
+                  Msg[Pos] = Mutation[rand() % (sizeof(Mutation) - 1)];
+                  MsgLen++;
+               }
+               break;
+            default:
+               if (MsgLen > 1)
+               {
+                  memmove(&Msg[Pos], &Msg[Pos+1], MsgLen - Pos - 1);
+                  MsgLen--;
+               }
+               break;
+         }
+      }
+      Run(Msg, MsgLen);
+   }
+
+} /* End FuzzCases() */
+
+
+/******************************************************************************
+** Function: RunCases
+**
+** Thread entry, see note 4.
+**
+*/
+static void *RunCases(void *Arg)
+{
+
+   if (Arg != NULL)
+   {
+      WorstCases();
+      FuzzCases();
+   }
+
+   return NULL;
+
+} /* End RunCases() */
+
+
+/******************************************************************************
+** Function: StackUsed
+**
+** Run RunCases() on a painted stack and return the bytes it overwrote.
+**
+*/
+static uint32 StackUsed(void *Arg)
+{
+
+   pthread_attr_t Attr;
+   pthread_t Thread;
+   uint8  *Stack = NULL;
+   uint32 Used = 0;
+
+   if (!UT_ASSERT(posix_memalign((void **)&Stack, 4096, STACK_LEN) == 0))
+   {
+      return STACK_LEN;
+   }
+   memset(Stack, STACK_PAINT, STACK_LEN);
+
+   pthread_attr_init(&Attr);
+   pthread_attr_setstack(&Attr, Stack, STACK_LEN);
+   if (UT_ASSERT(pthread_create(&Thread, &Attr, RunCases, Arg) == 0))
+   {
+      pthread_join(Thread, NULL);
+      while (Used < STACK_LEN && Stack[Used] == STACK_PAINT)
+      {
+         Used++;
+      }
+      Used = STACK_LEN - Used;
+   }
+   pthread_attr_destroy(&Attr);
+   free(Stack);
+
+   return Used;
+
+} /* End StackUsed() */
+
+
+/******************************************************************************
+** Function: CheckBound
+**
+** Run the cases and check the time and stack bounds and that each stage
+** of the Rx path was reached.
+**
+*/
+static void CheckBound(void)
+{
+
+   uint32 BaseUsed;
+   uint32 Used;
+
+   BaseUsed = StackUsed(NULL);
+   Used     = StackUsed(Msg);
+
+   UT_ASSERT(CaseCnt > FUZZ_CNT);
+   if (!UT_ASSERT(MaxUs < TIME_LIM_US))
+   {
+      printf("Case %u took %u us\n", (unsigned int)MaxUsCase, (unsigned int)MaxUs);
+   }
+   if (!UT_ASSERT(Used > BaseUsed && Used - BaseUsed < STACK_LIM))
+   {
+      printf("Used %u stack bytes, %u bytes before processing\n", (unsigned int)Used, (unsigned int)BaseUsed);
+   }
+
+   UT_ASSERT(Frag.RxMsgCnt > 0 && Lz.RxMsgCnt > 0 && Lz.RxErrCnt > 0);
+   UT_ASSERT(AckCnt > 0 && Rel.AckRxCnt + Rel.UnknownAckCnt > 0 && Trans.DupJMsgCnt > 0);
+   UT_ASSERT(ConvCnt > 0 && SbSendCnt > 0 && CapCnt > 0);
+
+} /* End CheckBound() */
+
+
+/******************************************************************************
+** Function: TestInline
+**
+** Payloads decoded on the Rx task.
+**
+*/
+static void TestInline(void)
+{
+
+   UT_ASSERT(Construct(0));
+   CheckBound();
+   UT_ASSERT(Trans.RxCtx.ValidJMsgCnt > 0 && Trans.RxCtx.Shape.HitCnt > 0);
+
+} /* End TestInline() */
+
+
+/******************************************************************************
+** Function: TestWorker
+**
+** Payloads queued to a decode worker.
+**
+*/
+static void TestWorker(void)
+{
+
+   UT_ASSERT(Construct(1));
+   CheckBound();
+   UT_ASSERT(Decode.Worker[0].MsgCnt > 0 && Decode.Worker[0].RxCtx->Shape.HitCnt > 0);
+
+} /* End TestWorker() */
+
+
+/******************************************************************************
+** Function: TestSelfTestAttr
+**
+** A "t" attribute of a message that isn't from a running self-test is
+** ignored and the message is sent on the SB.
+**
+*/
+static void TestSelfTestAttr(void)
+{
+
+   uint32 PrevSbSendCnt;
+
+   UT_ASSERT(Construct(0));
+
+   PrevSbSendCnt = SbSendCnt;
+   Run(Msg, snprintf(Msg, TEST_DATAGRAM_LEN, "%s;t=0:%s", PLUGIN_TOPIC, JSON));
+   UT_ASSERT(SbSendCnt == PrevSbSendCnt + 1);
+
+} /* End TestSelfTestAttr() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   Msg = malloc(TEST_MSG_LEN);
+
+   UT_RUN(TestInline);
+   UT_RUN(TestWorker);
+   UT_RUN(TestSelfTestAttr);
+
+   free(Msg);
+   unlink(TBL_FILE);
+
+   return UT_Summary();
+
+} /* End main() */
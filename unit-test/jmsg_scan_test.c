@@ -0,0 +1,248 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for the JSON structural scanner
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include "ut_jmsg.h"
+#include "jmsg_scan.h"
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_SCAN_Index_t Index;
+
+
+/******************************************************************************
+** Function: Scan
+**
+*/
+static JMSG_SCAN_Status_t Scan(const char *Json)
+{
+
+   return JMSG_SCAN_Payload(&Index, Json, (uint16)strlen(Json), 8);
+
+} /* End Scan() */
+
+
+/******************************************************************************
+** Function: TestValid
+**
+*/
+static void TestValid(void)
+{
+
+   UT_ASSERT(Scan("{}") == JMSG_SCAN_OK);
+   UT_ASSERT(Scan("[]") == JMSG_SCAN_OK);
+   UT_ASSERT(Scan(" \t\r\n{\"a\":1} \r\n") == JMSG_SCAN_OK);
+   UT_ASSERT(Scan("{\"a\":[1,2,{\"b\":\"x\\\"}\"}],\"c\":null}") == JMSG_SCAN_OK);
+   UT_ASSERT(Scan("{\"esc\":\"\\\\\"}") == JMSG_SCAN_OK);
+   UT_ASSERT(Scan("{\"utf8\":\"\xC3\xA9\xE2\x82\xAC\xF0\x9F\x9A\x80\"}") == JMSG_SCAN_OK);
+
+} /* End TestValid() */
+
+
+/******************************************************************************
+** Function: TestIndex
+**
+*/
+static void TestIndex(void)
+{
+
+   static const uint16 ExpPos[] = { 0, 1, 4, 5, 7, 8, 11, 12 };
+   uint16 i;
+
+   /*                0123456789012 */
+   UT_ASSERT(Scan("{\"a\":[1,\"b\"]}") == JMSG_SCAN_OK);
+   UT_ASSERT(Index.Cnt == sizeof(ExpPos)/sizeof(ExpPos[0]));
+   UT_ASSERT(Index.Depth == 2);
+   for (i=0; i < Index.Cnt && i < sizeof(ExpPos)/sizeof(ExpPos[0]); i++)
+   {
+      UT_ASSERT(Index.Pos[i] == ExpPos[i]);
+   }
+
+} /* End TestIndex() */
+
+
+/******************************************************************************
+** Function: TestOutside
+**
+** Text before or after the top level container must be rejected in the
+** container's block and in the blocks around it.
+**
+*/
+static void TestOutside(void)
+{
+
+   char Json[200];
+
+   UT_ASSERT(Scan("abc{\"a\":1}xyz") == JMSG_SCAN_ERR_OUTSIDE);
+   UT_ASSERT(Scan("{\"a\":1}x") == JMSG_SCAN_ERR_OUTSIDE);
+   UT_ASSERT(Scan("1{\"a\":1}") == JMSG_SCAN_ERR_OUTSIDE);
+   UT_ASSERT(Scan("{}\\") == JMSG_SCAN_ERR_OUTSIDE);
+   UT_ASSERT(Scan("true") == JMSG_SCAN_ERR_OUTSIDE);
+   UT_ASSERT(Scan("{\"a\":1},") == JMSG_SCAN_ERR_BALANCE);
+   UT_ASSERT(Scan("{\"a\":1}{}") == JMSG_SCAN_ERR_BALANCE);
+   UT_ASSERT(Scan("\"a\"") == JMSG_SCAN_ERR_BALANCE);
+
+   /* Trailing text in the block after the one that closes the container */
+   memset(Json, ' ', sizeof(Json));
+   memcpy(Json, "{\"a\":1}", 7);
+   Json[130] = 'x';
+   Json[140] = '\0';
+   UT_ASSERT(Scan(Json) == JMSG_SCAN_ERR_OUTSIDE);
+   Json[130] = ' ';
+   UT_ASSERT(Scan(Json) == JMSG_SCAN_OK);
+
+   /* Leading text in the block before the one that opens the container */
+   memset(Json, ' ', sizeof(Json));
+   Json[3] = 'x';
+   memcpy(&Json[100], "{\"a\":1}", 7);
+   Json[110] = '\0';
+   UT_ASSERT(Scan(Json) == JMSG_SCAN_ERR_OUTSIDE);
+   Json[3] = ' ';
+   UT_ASSERT(Scan(Json) == JMSG_SCAN_OK);
+
+   /* Container closing on the last bit of a block */
+   memset(Json, ' ', sizeof(Json));
+   Json[0]  = '[';
+   Json[63] = ']';
+   Json[64] = 'x';
+   Json[65] = '\0';
+   UT_ASSERT(Scan(Json) == JMSG_SCAN_ERR_OUTSIDE);
+   Json[64] = '\0';
+   UT_ASSERT(Scan(Json) == JMSG_SCAN_OK);
+
+} /* End TestOutside() */
+
+
+/******************************************************************************
+** Function: TestMalformed
+**
+*/
+static void TestMalformed(void)
+{
+
+   UT_ASSERT(JMSG_SCAN_Payload(&Index, "{}", 0, 8) == JMSG_SCAN_ERR_EMPTY);
+   UT_ASSERT(Scan("   ") == JMSG_SCAN_ERR_BALANCE);
+   UT_ASSERT(Scan("{\"a\":1") == JMSG_SCAN_ERR_BALANCE);
+   UT_ASSERT(Scan("{\"a\":1]") == JMSG_SCAN_ERR_BALANCE);
+   UT_ASSERT(Scan("}") == JMSG_SCAN_ERR_BALANCE);
+   UT_ASSERT(Scan("{\"a\":\"x}") == JMSG_SCAN_ERR_STRING);
+   UT_ASSERT(Scan("{\"a\":\"x\\\"}") == JMSG_SCAN_ERR_STRING);
+   UT_ASSERT(Scan("{\"a\":\"x\ty\"}") == JMSG_SCAN_ERR_CTRL_CHAR);
+   UT_ASSERT(Scan("{\"a\":\x01}") == JMSG_SCAN_ERR_CTRL_CHAR);
+   UT_ASSERT(Scan("[[[[[[[[[]]]]]]]]]") == JMSG_SCAN_ERR_DEPTH);
+   UT_ASSERT(Scan("[[[[[[[[]]]]]]]]") == JMSG_SCAN_OK);
+
+   /* Overlong, surrogate, out of range and truncated UTF-8 */
+   UT_ASSERT(Scan("{\"a\":\"\xC0\x80\"}") == JMSG_SCAN_ERR_UTF8);
+   UT_ASSERT(Scan("{\"a\":\"\xED\xA0\x80\"}") == JMSG_SCAN_ERR_UTF8);
+   UT_ASSERT(Scan("{\"a\":\"\xF4\x90\x80\x80\"}") == JMSG_SCAN_ERR_UTF8);
+   UT_ASSERT(Scan("{\"a\":\"\xE2\x82\"}") == JMSG_SCAN_ERR_UTF8);
+
+} /* End TestMalformed() */
+
+
+/******************************************************************************
+** Function: TestBlockBoundary
+**
+** Backslash runs and strings that cross a 64 byte block boundary.
+**
+*/
+static void TestBlockBoundary(void)
+{
+
+   char   Json[200];
+   uint16 Run;
+
+   for (Run = 1; Run <= 4; Run++)
+   {
+
+      /* A string whose backslash run ends on byte 63, followed by a quote */
+      memset(Json, 'a', sizeof(Json));
+      memcpy(Json, "{\"k\":\"", 6);
+      memset(&Json[64-Run], '\\', Run);
+      Json[64] = '"';
+      memcpy(&Json[65], "\"}", 3);
+
+      /* Even runs escape themselves so byte 64 closes the string */
+      if (Run % 2 == 0)
+      {
+         Json[65] = '}';
+         Json[66] = '\0';
+         UT_ASSERT(Scan(Json) == JMSG_SCAN_OK);
+      }
+      else
+      {
+         UT_ASSERT(Scan(Json) == JMSG_SCAN_OK);
+         Json[65] = '}';
+         Json[66] = '\0';
+         UT_ASSERT(Scan(Json) == JMSG_SCAN_ERR_STRING);
+      }
+   }
+
+} /* End TestBlockBoundary() */
+
+
+/******************************************************************************
+** Function: TestIndexFull
+**
+*/
+static void TestIndexFull(void)
+{
+
+   static char Json[4*JMSG_UDP_PLATFORM_SCAN_INDEX_MAX];
+   uint32 i, Len = 0;
+
+   Json[Len++] = '[';
+   for (i=0; i < JMSG_UDP_PLATFORM_SCAN_INDEX_MAX; i++)
+   {
+      Json[Len++] = '1';
+      Json[Len++] = ',';
+   }
+   Json[Len++] = '1';
+   Json[Len++] = ']';
+
+   UT_ASSERT(JMSG_SCAN_Payload(&Index, Json, (uint16)Len, 8) == JMSG_SCAN_ERR_INDEX_FULL);
+   UT_ASSERT(Index.Cnt == JMSG_UDP_PLATFORM_SCAN_INDEX_MAX);
+
+} /* End TestIndexFull() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestValid);
+   UT_RUN(TestIndex);
+   UT_RUN(TestOutside);
+   UT_RUN(TestMalformed);
+   UT_RUN(TestBlockBoundary);
+   UT_RUN(TestIndexFull);
+
+   return UT_Summary();
+
+} /* End main() */
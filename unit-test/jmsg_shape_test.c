@@ -0,0 +1,277 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for the Rx payload shape cache
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <stdlib.h>
+
+#include "ut_jmsg.h"
+#include "jmsg_shape.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define TOPIC       "basecamp/rate"
+#define TOPIC_LEN   (sizeof(TOPIC) - 1)
+#define JSON        "{\"rate\":{\"x\":1.5, \"n\":7, \"other\":-2}}"
+#define FUZZ_CNT    100000
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static JMSG_SHAPE_Class_t Shape;
+static JMSG_TMPL_Tmpl_t   Tmpl;
+static JMSG_SCAN_Index_t  Index;
+
+
+/******************************************************************************
+** Function: BuildTmpl
+**
+** Build a nested template with a double at offset 0 and a uint16 at 8.
+**
+*/
+static void BuildTmpl(const char *Key)
+{
+
+   UT_ASSERT(JMSG_TMPL_Init(&Tmpl, "rate", 4));
+   UT_ASSERT(JMSG_TMPL_AddField(&Tmpl, "x", 1, JMSG_TMPL_TYPE_DOUBLE, 0, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(JMSG_TMPL_AddField(&Tmpl, Key, strlen(Key), JMSG_TMPL_TYPE_UINT16, 8, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(JMSG_TMPL_Finish(&Tmpl, 0, 0));
+
+} /* End BuildTmpl() */
+
+
+/******************************************************************************
+** Function: Learn
+**
+** Scan and learn a payload.
+**
+*/
+static JMSG_SHAPE_Status_t Learn(const char *Topic, const char *Json, uint8 *Payload)
+{
+
+   UT_ASSERT(JMSG_SCAN_Payload(&Index, Json, strlen(Json), 8) == JMSG_SCAN_OK);
+
+   return JMSG_SHAPE_Learn(&Shape, Topic, strlen(Topic), &Tmpl, Json, strlen(Json), &Index, Payload);
+
+} /* End Learn() */
+
+
+/******************************************************************************
+** Function: Match
+**
+*/
+static JMSG_SHAPE_Status_t Match(const char *Topic, const char *Json, uint8 *Payload)
+{
+
+   return JMSG_SHAPE_Match(&Shape, Topic, strlen(Topic), &Tmpl, Json, strlen(Json), Payload);
+
+} /* End Match() */
+
+
+/******************************************************************************
+** Function: TestLearnMatch
+**
+** A learned shape must convert payloads that differ only in their numbers.
+**
+*/
+static void TestLearnMatch(void)
+{
+
+   uint8  Payload[10];
+   double X;
+   uint16 N;
+
+   JMSG_SHAPE_Constructor(&Shape);
+   BuildTmpl("n");
+
+   UT_ASSERT(Match(TOPIC, JSON, Payload) == JMSG_SHAPE_MISS);
+   UT_ASSERT(Learn(TOPIC, JSON, Payload) == JMSG_SHAPE_OK);
+   memcpy(&X, Payload, 8);
+   memcpy(&N, &Payload[8], 2);
+   UT_ASSERT(X == 1.5 && N == 7);
+
+   UT_ASSERT(Match(TOPIC, "{\"rate\":{\"x\":-2.25e1, \"n\":65535, \"other\":0}}", Payload) == JMSG_SHAPE_OK);
+   memcpy(&X, Payload, 8);
+   memcpy(&N, &Payload[8], 2);
+   UT_ASSERT(X == -22.5 && N == 65535);
+   UT_ASSERT(Shape.HitCnt == 1);
+
+   /* Out of range values are errors, not misses */
+   UT_ASSERT(Match(TOPIC, "{\"rate\":{\"x\":1, \"n\":65536, \"other\":0}}", Payload) == JMSG_SHAPE_ERR_RANGE);
+   UT_ASSERT(Match(TOPIC, "{\"rate\":{\"x\":1, \"n\":1.5, \"other\":0}}", Payload) == JMSG_SHAPE_ERR_RANGE);
+
+   /* Different text, a trailing byte or a truncated payload misses */
+   UT_ASSERT(Match(TOPIC, "{\"rate\":{\"x\":1,\"n\":1, \"other\":0}}", Payload) == JMSG_SHAPE_MISS);
+   UT_ASSERT(Match(TOPIC, "{\"rate\":{\"x\":1, \"n\":1, \"other\":0}} ", Payload) == JMSG_SHAPE_MISS);
+   UT_ASSERT(Match(TOPIC, "{\"rate\":{\"x\":1, \"n\":1, \"other\":0}", Payload) == JMSG_SHAPE_MISS);
+   UT_ASSERT(Match(TOPIC, "{\"rate\":{\"x\":\"1\", \"n\":1, \"other\":0}}", Payload) == JMSG_SHAPE_MISS);
+   UT_ASSERT(Match(TOPIC, "{\"rate\":{\"x\":, \"n\":1, \"other\":0}}", Payload) == JMSG_SHAPE_MISS);
+   UT_ASSERT(Match("basecamp/other", JSON, Payload) == JMSG_SHAPE_MISS);
+
+   /* A changed template invalidates the topic's shape */
+   BuildTmpl("other");
+   UT_ASSERT(Match(TOPIC, JSON, Payload) == JMSG_SHAPE_MISS);
+
+} /* End TestLearnMatch() */
+
+
+/******************************************************************************
+** Function: TestLearnErr
+**
+** Payloads missing a template field aren't converted or cached.
+**
+*/
+static void TestLearnErr(void)
+{
+
+   uint8 Payload[10];
+
+   JMSG_SHAPE_Constructor(&Shape);
+   BuildTmpl("n");
+
+   UT_ASSERT(Learn(TOPIC, "{\"rate\":{\"x\":1}}", Payload) == JMSG_SHAPE_ERR_MISSING);
+   UT_ASSERT(Learn(TOPIC, "{\"rate\":{\"x\":1, \"n\":\"7\"}}", Payload) == JMSG_SHAPE_ERR_MISSING);
+   UT_ASSERT(Learn(TOPIC, "{\"x\":1, \"n\":7}", Payload) == JMSG_SHAPE_ERR_MISSING);
+   UT_ASSERT(Learn(TOPIC, "{\"rate\":{\"x\":1, \"n\":-1}}", Payload) == JMSG_SHAPE_ERR_RANGE);
+   UT_ASSERT(Match(TOPIC, JSON, Payload) == JMSG_SHAPE_MISS);
+
+} /* End TestLearnErr() */
+
+
+/******************************************************************************
+** Function: TestReplace
+**
+** The least recently used topic must be replaced when the cache is full,
+** including after the use counter wraps.
+**
+*/
+static void TestReplace(void)
+{
+
+   static const uint32 StartCnt[] = { 0, 0xFFFFFFF8 };
+   uint8  Payload[10];
+   char   Topic[32];
+   uint16 i;
+   uint16 s;
+
+   BuildTmpl("n");
+
+   for (s=0; s < sizeof(StartCnt)/sizeof(StartCnt[0]); s++)
+   {
+      JMSG_SHAPE_Constructor(&Shape);
+      Shape.UseCnt = StartCnt[s];
+
+      for (i=0; i < JMSG_UDP_PLATFORM_SHAPE_MAX; i++)
+      {
+         snprintf(Topic, sizeof(Topic), "topic/%u", i);
+         UT_ASSERT(Learn(Topic, JSON, Payload) == JMSG_SHAPE_OK);
+      }
+
+      /* Use topic 0 so topic 1 is the oldest */
+      UT_ASSERT(Match("topic/0", JSON, Payload) == JMSG_SHAPE_OK);
+      UT_ASSERT(Learn("topic/new", JSON, Payload) == JMSG_SHAPE_OK);
+
+      UT_ASSERT(Match("topic/new", JSON, Payload) == JMSG_SHAPE_OK);
+      UT_ASSERT(Match("topic/0", JSON, Payload) == JMSG_SHAPE_OK);
+      if (!UT_ASSERT(Match("topic/1", JSON, Payload) == JMSG_SHAPE_MISS))
+      {
+         printf("Wrong entry replaced with use count starting at 0x%08X\n", (unsigned int)StartCnt[s]);
+      }
+      for (i=2; i < JMSG_UDP_PLATFORM_SHAPE_MAX; i++)
+      {
+         snprintf(Topic, sizeof(Topic), "topic/%u", i);
+         UT_ASSERT(Match(Topic, JSON, Payload) == JMSG_SHAPE_OK);
+      }
+   }
+
+} /* End TestReplace() */
+
+
+/******************************************************************************
+** Function: TestFuzz
+**
+** Mutated and truncated payloads must not be read past their length and a
+** hit must only convert payloads the scanner accepts.
+**
+*/
+static void TestFuzz(void)
+{
+
+   static const char Mutation[] = "0123456789-+.eE,:\"{} x";
+   uint8  Payload[10];
+   char   *Json;
+   uint16 JsonLen;
+   uint16 Len;
+   uint32 i;
+   JMSG_SHAPE_Status_t Status;
+
+   JMSG_SHAPE_Constructor(&Shape);
+   BuildTmpl("n");
+   UT_ASSERT(Learn(TOPIC, JSON, Payload) == JMSG_SHAPE_OK);
+
+   srand(39);
+   for (i=0; i < FUZZ_CNT; i++)
+   {
+      JsonLen = sizeof(JSON) - 1;
+      Len = (rand() % 4 == 0) ? rand() % (JsonLen + 1) : JsonLen;
+      Json = malloc(Len > 0 ? Len : 1);
+      memcpy(Json, JSON, Len);
+      if (Len > 0)
+      {
+         Json[rand() % Len] = Mutation[rand() % (sizeof(Mutation) - 1)];
+      }
+
+      Status = JMSG_SHAPE_Match(&Shape, TOPIC, TOPIC_LEN, &Tmpl, Json, Len, Payload);
+      if (Status == JMSG_SHAPE_OK)
+      {
+         if (!UT_ASSERT(JMSG_SCAN_Payload(&Index, Json, Len, 8) == JMSG_SCAN_OK))
+         {
+            printf("Shape hit for invalid payload %.*s\n", Len, Json);
+            free(Json);
+            break;
+         }
+      }
+      free(Json);
+   }
+
+} /* End TestFuzz() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestLearnMatch);
+   UT_RUN(TestLearnErr);
+   UT_RUN(TestReplace);
+   UT_RUN(TestFuzz);
+
+   return UT_Summary();
+
+} /* End main() */
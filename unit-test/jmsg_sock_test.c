@@ -0,0 +1,200 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for replacing the Rx socket's Unix domain socket
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "ut_jmsg.h"
+#include "jmsg_sock.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define TEST_TIMEOUT  1000   /* Milliseconds */
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static char PathA[64];
+static char PathB[64];
+
+
+/******************************************************************************
+** Function: Exists
+**
+*/
+static bool Exists(const char *Path, const char *Ext)
+{
+
+   char FullPath[JMSG_SOCK_LOCAL_PATH_LEN];
+
+   snprintf(FullPath, sizeof(FullPath), "%s%s", Path, Ext);
+
+   return (access(FullPath, F_OK) == 0);
+
+} /* End Exists() */
+
+
+/******************************************************************************
+** Function: Open
+**
+** Open a socket with kernel timestamps so it's always created natively.
+**
+*/
+static bool Open(JMSG_SOCK_Class_t *Sock, const JMSG_SOCK_Class_t *Current, const char *Path)
+{
+
+   return (JMSG_SOCK_OpenRx(Sock, Current, 0, true, Path, 0, 0) == OS_SUCCESS);
+
+} /* End Open() */
+
+
+/******************************************************************************
+** Function: SendRecv
+**
+** Send a datagram to a path and check Sock receives it.
+**
+*/
+static bool SendRecv(const char *Path, JMSG_SOCK_Class_t *Sock)
+{
+
+   struct sockaddr_un Addr;
+   JMSG_SOCK_RxInfo_t RxInfo;
+   char  Buf[16];
+   int   Fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+   bool  Received;
+
+   memset(&Addr, 0, sizeof(Addr));
+   Addr.sun_family = AF_UNIX;
+   strncpy(Addr.sun_path, Path, sizeof(Addr.sun_path) - 1);
+   sendto(Fd, "t:{}", 4, 0, (struct sockaddr *)&Addr, sizeof(Addr));
+   close(Fd);
+
+   Received = (JMSG_SOCK_Recv(Sock, Buf, sizeof(Buf), TEST_TIMEOUT, &RxInfo) == 4);
+
+   return Received && memcmp(Buf, "t:{}", 4) == 0;
+
+} /* End SendRecv() */
+
+
+/******************************************************************************
+** Function: TestSamePath
+**
+** A replacement with the same path shares the Unix domain socket and only
+** the committed owner closes it.
+**
+*/
+static void TestSamePath(void)
+{
+
+   JMSG_SOCK_Class_t Current;
+   JMSG_SOCK_Class_t New;
+
+   UT_ASSERT(Open(&Current, NULL, PathA));
+   UT_ASSERT(!Exists(PathA, JMSG_SOCK_LOCAL_TMP_EXT));
+
+   /* A rejected replacement leaves the current socket receiving */
+   UT_ASSERT(Open(&New, &Current, PathA));
+   UT_ASSERT(New.LocalShared && New.LocalFd == Current.LocalFd);
+   UT_ASSERT(New.Fd != Current.Fd);
+   JMSG_SOCK_Close(&New);
+   UT_ASSERT(SendRecv(PathA, &Current));
+
+   UT_ASSERT(Open(&New, &Current, PathA));
+   UT_ASSERT(JMSG_SOCK_CommitRx(&New, &Current) == OS_SUCCESS);
+   UT_ASSERT(!New.LocalShared && Current.LocalFd == -1);
+   JMSG_SOCK_Close(&Current);
+   UT_ASSERT(SendRecv(PathA, &New));
+   JMSG_SOCK_Close(&New);
+
+   unlink(PathA);
+
+} /* End TestSamePath() */
+
+
+/******************************************************************************
+** Function: TestNewPath
+**
+** A replacement with a new path binds the temporary name until it's
+** committed.
+**
+*/
+static void TestNewPath(void)
+{
+
+   JMSG_SOCK_Class_t Current;
+   JMSG_SOCK_Class_t New;
+   char  LongPath[JMSG_SOCK_LOCAL_PATH_LEN];
+
+   UT_ASSERT(Open(&Current, NULL, PathA));
+
+   /* A rejected replacement removes its temporary name */
+   UT_ASSERT(Open(&New, &Current, PathB));
+   UT_ASSERT(New.LocalTmp && !New.LocalShared);
+   UT_ASSERT(Exists(PathB, JMSG_SOCK_LOCAL_TMP_EXT) && !Exists(PathB, ""));
+   JMSG_SOCK_Close(&New);
+   UT_ASSERT(!Exists(PathB, JMSG_SOCK_LOCAL_TMP_EXT) && !Exists(PathB, ""));
+   UT_ASSERT(SendRecv(PathA, &Current));
+
+   UT_ASSERT(Open(&New, &Current, PathB));
+   UT_ASSERT(JMSG_SOCK_CommitRx(&New, &Current) == OS_SUCCESS);
+   UT_ASSERT(Exists(PathB, "") && !Exists(PathB, JMSG_SOCK_LOCAL_TMP_EXT));
+   UT_ASSERT(SendRecv(PathB, &New));
+   UT_ASSERT(SendRecv(PathA, &Current));
+   JMSG_SOCK_Close(&Current);
+   JMSG_SOCK_Close(&New);
+   UT_ASSERT(Exists(PathB, ""));
+
+   /* The temporary name must fit */
+   memset(LongPath, 'a', sizeof(LongPath) - 1);
+   LongPath[0] = '/';
+   LongPath[sizeof(LongPath) - strlen(JMSG_SOCK_LOCAL_TMP_EXT)] = '\0';
+   UT_ASSERT(JMSG_SOCK_OpenRx(&New, NULL, 0, true, LongPath, 0, 0) == OS_FS_ERR_PATH_TOO_LONG);
+
+   unlink(PathA);
+   unlink(PathB);
+
+} /* End TestNewPath() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   snprintf(PathA, sizeof(PathA), "/tmp/jmsg_sock_test_%d_a", (int)getpid());
+   snprintf(PathB, sizeof(PathB), "/tmp/jmsg_sock_test_%d_b", (int)getpid());
+
+   UT_RUN(TestSamePath);
+   UT_RUN(TestNewPath);
+
+   return UT_Summary();
+
+} /* End main() */
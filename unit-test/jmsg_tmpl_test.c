@@ -0,0 +1,359 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for JSON templates and the number formatter and parser
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "ut_jmsg.h"
+#include "jmsg_tmpl.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define FUZZ_CNT  200000
+
+
+/******************************************************************************
+** Function: Fill
+**
+** Fill a template into a buffer of exactly the length JMSG_TMPL_Fill()
+** requires so an overrun is caught by the address sanitizer.
+**
+*/
+static int32 Fill(const JMSG_TMPL_Tmpl_t *Tmpl, const void *Payload, size_t PayloadLen,
+                  char *Json, size_t JsonSize)
+{
+
+   size_t BufLen = Tmpl->TextLen + Tmpl->FieldCnt*JMSG_TMPL_VALUE_MAX_LEN + 1;
+   char   *Buf = malloc(BufLen);
+   int32  JsonLen = JMSG_TMPL_Fill(Tmpl, Payload, PayloadLen, Buf);
+
+   if (JsonLen >= 0)
+   {
+      UT_ASSERT((size_t)JsonLen < BufLen && Buf[JsonLen] == '\0');
+      snprintf(Json, JsonSize, "%s", Buf);
+   }
+   free(Buf);
+
+   return JsonLen;
+
+} /* End Fill() */
+
+
+/******************************************************************************
+** Function: OneField
+**
+** Build a template with a single field at offset zero.
+**
+*/
+static void OneField(JMSG_TMPL_Tmpl_t *Tmpl, JMSG_TMPL_Type_t Type, uint8 Precision)
+{
+
+   UT_ASSERT(JMSG_TMPL_Init(Tmpl, NULL, 0));
+   UT_ASSERT(JMSG_TMPL_AddField(Tmpl, "v", 1, Type, 0, Precision));
+   UT_ASSERT(JMSG_TMPL_Finish(Tmpl, 0, 0));
+
+} /* End OneField() */
+
+
+/******************************************************************************
+** Function: TestFill
+**
+*/
+static void TestFill(void)
+{
+
+   static JMSG_TMPL_Tmpl_t Tmpl;
+   uint8  Payload[16];
+   char   Json[256];
+   int64  I64 = INT64_MIN;
+   uint64 U64 = UINT64_MAX;
+   int8   I8  = -128;
+   uint16 U16 = 65535;
+   float  F   = 1.5f;
+
+   OneField(&Tmpl, JMSG_TMPL_TYPE_INT64, JMSG_TMPL_PRECISION_SHORTEST);
+   memcpy(Payload, &I64, sizeof(I64));
+   UT_ASSERT(Fill(&Tmpl, Payload, 8, Json, sizeof(Json)) > 0);
+   UT_ASSERT(strcmp(Json, "{\"v\":-9223372036854775808}") == 0);
+   UT_ASSERT(Fill(&Tmpl, Payload, 7, Json, sizeof(Json)) == -1);
+
+   OneField(&Tmpl, JMSG_TMPL_TYPE_UINT64, JMSG_TMPL_PRECISION_SHORTEST);
+   memcpy(Payload, &U64, sizeof(U64));
+   UT_ASSERT(Fill(&Tmpl, Payload, 8, Json, sizeof(Json)) > 0);
+   UT_ASSERT(strcmp(Json, "{\"v\":18446744073709551615}") == 0);
+
+   OneField(&Tmpl, JMSG_TMPL_TYPE_INT8, JMSG_TMPL_PRECISION_SHORTEST);
+   memcpy(Payload, &I8, sizeof(I8));
+   UT_ASSERT(Fill(&Tmpl, Payload, 1, Json, sizeof(Json)) > 0);
+   UT_ASSERT(strcmp(Json, "{\"v\":-128}") == 0);
+
+   /* Nested object with an unaligned field */
+   UT_ASSERT(JMSG_TMPL_Init(&Tmpl, "obj", 3));
+   UT_ASSERT(JMSG_TMPL_AddField(&Tmpl, "a", 1, JMSG_TMPL_TYPE_UINT16, 1, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(JMSG_TMPL_AddField(&Tmpl, "b", 1, JMSG_TMPL_TYPE_FLOAT, 3, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(JMSG_TMPL_Finish(&Tmpl, 0, 0));
+   UT_ASSERT(Tmpl.MinPayloadLen == 7);
+   memcpy(&Payload[1], &U16, sizeof(U16));
+   memcpy(&Payload[3], &F, sizeof(F));
+   UT_ASSERT(Fill(&Tmpl, Payload, 7, Json, sizeof(Json)) > 0);
+   UT_ASSERT(strcmp(Json, "{\"obj\":{\"a\":65535,\"b\":1.5}}") == 0);
+   UT_ASSERT(Fill(&Tmpl, Payload, 6, Json, sizeof(Json)) == -1);
+
+} /* End TestFill() */
+
+
+/******************************************************************************
+** Function: TestFloat
+**
+** Shortest values must read back as the same float or double and fixed
+** precision values must have the requested decimal places.
+**
+*/
+static void TestFloat(void)
+{
+
+   static JMSG_TMPL_Tmpl_t DblTmpl;
+   static JMSG_TMPL_Tmpl_t FltTmpl;
+   static JMSG_TMPL_Tmpl_t FixTmpl;
+   static const double Special[] =
+   {
+      0.0, -0.0, 0.1, 1e22, 1e23, 5e-324, 2.2250738585072014e-308, 1.7976931348623157e308,
+      123456789012345678.0, 0.30000000000000004, -1.0/3.0
+   };
+   uint64 Bits;
+   uint32 FltBits;
+   double Dbl;
+   double Back;
+   float  Flt;
+   char   Json[256];
+   char   *End;
+   uint32 i;
+
+   OneField(&DblTmpl, JMSG_TMPL_TYPE_DOUBLE, JMSG_TMPL_PRECISION_SHORTEST);
+   OneField(&FltTmpl, JMSG_TMPL_TYPE_FLOAT, JMSG_TMPL_PRECISION_SHORTEST);
+   OneField(&FixTmpl, JMSG_TMPL_TYPE_DOUBLE, 3);
+
+   for (i=0; i < sizeof(Special)/sizeof(Special[0]); i++)
+   {
+      UT_ASSERT(Fill(&DblTmpl, &Special[i], 8, Json, sizeof(Json)) > 0);
+      Back = strtod(&Json[5], &End);
+      if (!UT_ASSERT(Back == Special[i] && strcmp(End, "}") == 0))
+      {
+         printf("Special %.17g formatted %s\n", Special[i], Json);
+      }
+   }
+
+   Dbl = NAN;
+   UT_ASSERT(Fill(&DblTmpl, &Dbl, 8, Json, sizeof(Json)) > 0);
+   UT_ASSERT(strcmp(Json, "{\"v\":null}") == 0);
+   Dbl = -INFINITY;
+   UT_ASSERT(Fill(&DblTmpl, &Dbl, 8, Json, sizeof(Json)) > 0);
+   UT_ASSERT(strcmp(Json, "{\"v\":null}") == 0);
+
+   Dbl = 2.5;
+   UT_ASSERT(Fill(&FixTmpl, &Dbl, 8, Json, sizeof(Json)) > 0);
+   UT_ASSERT(strcmp(Json, "{\"v\":2.500}") == 0);
+   Dbl = -0.0005;
+   UT_ASSERT(Fill(&FixTmpl, &Dbl, 8, Json, sizeof(Json)) > 0);
+   UT_ASSERT(fabs(strtod(&Json[5], NULL) + 0.0005) <= 0.0005);
+
+   /* Random bit patterns, including subnormals and the largest exponents */
+   srand(41);
+   for (i=0; i < FUZZ_CNT; i++)
+   {
+      Bits = ((uint64)rand() << 62) ^ ((uint64)rand() << 31) ^ (uint64)rand();
+      memcpy(&Dbl, &Bits, sizeof(Dbl));
+      if (isfinite(Dbl))
+      {
+         UT_ASSERT(Fill(&DblTmpl, &Dbl, 8, Json, sizeof(Json)) > 0);
+         if (!UT_ASSERT(strtod(&Json[5], NULL) == Dbl))
+         {
+            printf("Double %.17g formatted %s\n", Dbl, Json);
+            break;
+         }
+      }
+      FltBits = (uint32)Bits;
+      memcpy(&Flt, &FltBits, sizeof(Flt));
+      if (isfinite(Flt))
+      {
+         UT_ASSERT(Fill(&FltTmpl, &Flt, 4, Json, sizeof(Json)) > 0);
+         if (!UT_ASSERT(strtof(&Json[5], NULL) == Flt))
+         {
+            printf("Float %.9g formatted %s\n", Flt, Json);
+            break;
+         }
+      }
+      if (isfinite(Dbl) && fabs(Dbl) < 1e15)
+      {
+         UT_ASSERT(Fill(&FixTmpl, &Dbl, 8, Json, sizeof(Json)) > 0);
+      }
+   }
+
+} /* End TestFloat() */
+
+
+/******************************************************************************
+** Function: TestParse
+**
+** Invalid JSON numbers must be rejected and values out of a field's range
+** must not be stored.
+**
+*/
+static void TestParse(void)
+{
+
+   static const char *Invalid[] = { "", "-", "+1", ".5", "1.", "1e", "1e+", "-x", "-.5" };
+   JMSG_TMPL_Number_t Number;
+   JMSG_TMPL_Field_t  Field;
+   uint8  Payload[8];
+   uint8  U8;
+   int64  I64;
+   double Dbl;
+   char   Str[64];
+   uint32 i;
+
+   for (i=0; i < sizeof(Invalid)/sizeof(Invalid[0]); i++)
+   {
+      if (!UT_ASSERT(JMSG_TMPL_ParseNumber(Invalid[i], strlen(Invalid[i]), &Number) == 0))
+      {
+         printf("Parsed invalid number %s\n", Invalid[i]);
+      }
+   }
+
+   /* A leading zero ends the number */
+   UT_ASSERT(JMSG_TMPL_ParseNumber("01", 2, &Number) == 1 && Number.IsInt && Number.Mag == 0);
+   UT_ASSERT(JMSG_TMPL_ParseNumber("0x10", 4, &Number) == 1);
+
+   /* Only Len characters are read */
+   UT_ASSERT(JMSG_TMPL_ParseNumber("12345", 3, &Number) == 3 && Number.Mag == 123);
+
+   UT_ASSERT(JMSG_TMPL_ParseNumber("18446744073709551615", 20, &Number) == 20);
+   UT_ASSERT(Number.IsInt && Number.Mag == UINT64_MAX);
+   UT_ASSERT(JMSG_TMPL_ParseNumber("18446744073709551616", 20, &Number) == 20 && !Number.IsInt);
+
+   UT_ASSERT(JMSG_TMPL_ParseNumber("-1.25e-3", 8, &Number) == 8 && Number.Real == -1.25e-3);
+   UT_ASSERT(JMSG_TMPL_ParseNumber("1e400", 5, &Number) == 5 && isinf(Number.Real));
+
+   memset(&Field, 0, sizeof(Field));
+   Field.Type = JMSG_TMPL_TYPE_UINT8;
+   JMSG_TMPL_ParseNumber("255", 3, &Number);
+   UT_ASSERT(JMSG_TMPL_StoreNumber(&Field, &Number, Payload));
+   memcpy(&U8, Payload, 1);
+   UT_ASSERT(U8 == 255);
+   JMSG_TMPL_ParseNumber("256", 3, &Number);
+   UT_ASSERT(!JMSG_TMPL_StoreNumber(&Field, &Number, Payload));
+   JMSG_TMPL_ParseNumber("-1", 2, &Number);
+   UT_ASSERT(!JMSG_TMPL_StoreNumber(&Field, &Number, Payload));
+   JMSG_TMPL_ParseNumber("1.5", 3, &Number);
+   UT_ASSERT(!JMSG_TMPL_StoreNumber(&Field, &Number, Payload));
+
+   Field.Type = JMSG_TMPL_TYPE_INT64;
+   JMSG_TMPL_ParseNumber("-9223372036854775808", 20, &Number);
+   UT_ASSERT(JMSG_TMPL_StoreNumber(&Field, &Number, Payload));
+   memcpy(&I64, Payload, 8);
+   UT_ASSERT(I64 == INT64_MIN);
+   JMSG_TMPL_ParseNumber("9223372036854775808", 19, &Number);
+   UT_ASSERT(!JMSG_TMPL_StoreNumber(&Field, &Number, Payload));
+
+   /* Parsed doubles must match strtod() */
+   Field.Type = JMSG_TMPL_TYPE_DOUBLE;
+   srand(7);
+   for (i=0; i < FUZZ_CNT; i++)
+   {
+      snprintf(Str, sizeof(Str), "%d.%de%d", rand() % 100000 - 50000, rand(), rand() % 80 - 40);
+      if (strncmp(Str, "-0", 2) == 0 || (Str[0] == '0' && Str[1] != '.'))
+      {
+         continue;
+      }
+      UT_ASSERT(JMSG_TMPL_ParseNumber(Str, strlen(Str), &Number) == strlen(Str));
+      UT_ASSERT(JMSG_TMPL_StoreNumber(&Field, &Number, Payload));
+      memcpy(&Dbl, Payload, 8);
+      if (!UT_ASSERT(Dbl == strtod(Str, NULL)))
+      {
+         printf("Parsed %s as %.17g\n", Str, Dbl);
+         break;
+      }
+   }
+
+} /* End TestParse() */
+
+
+/******************************************************************************
+** Function: TestBuild
+**
+** Invalid fields and full templates must be rejected.
+**
+*/
+static void TestBuild(void)
+{
+
+   static JMSG_TMPL_Tmpl_t Tmpl;
+   char   Key[16];
+   uint16 i;
+
+   UT_ASSERT(JMSG_TMPL_Init(&Tmpl, NULL, 0));
+   UT_ASSERT(!JMSG_TMPL_Finish(&Tmpl, 0, 0));
+   UT_ASSERT(!JMSG_TMPL_AddField(&Tmpl, "", 0, JMSG_TMPL_TYPE_UINT8, 0, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(!JMSG_TMPL_AddField(&Tmpl, "a\"", 2, JMSG_TMPL_TYPE_UINT8, 0, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(!JMSG_TMPL_AddField(&Tmpl, "a\n", 2, JMSG_TMPL_TYPE_UINT8, 0, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(!JMSG_TMPL_AddField(&Tmpl, "a", 1, JMSG_TMPL_TYPE_CNT, 0, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(!JMSG_TMPL_AddField(&Tmpl, "a", 1, JMSG_TMPL_TYPE_DOUBLE, 0xFFF8, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(!JMSG_TMPL_AddField(&Tmpl, "a", 1, JMSG_TMPL_TYPE_DOUBLE, 0, JMSG_TMPL_PRECISION_MAX + 1));
+   UT_ASSERT(JMSG_TMPL_AddField(&Tmpl, "a", 1, JMSG_TMPL_TYPE_DOUBLE, 0xFFF7, JMSG_TMPL_PRECISION_MAX));
+   UT_ASSERT(!JMSG_TMPL_Finish(&Tmpl, 8, 0));
+   UT_ASSERT(JMSG_TMPL_Finish(&Tmpl, 0, 0) && Tmpl.PayloadLen == 0xFFFF);
+
+   UT_ASSERT(JMSG_TMPL_Init(&Tmpl, NULL, 0));
+   for (i=0; i < JMSG_UDP_PLATFORM_TMPL_FIELD_MAX; i++)
+   {
+      snprintf(Key, sizeof(Key), "k%u", i);
+      if (!JMSG_TMPL_AddField(&Tmpl, Key, strlen(Key), JMSG_TMPL_TYPE_UINT8, i, JMSG_TMPL_PRECISION_SHORTEST))
+      {
+         break;
+      }
+   }
+   UT_ASSERT(!JMSG_TMPL_AddField(&Tmpl, "x", 1, JMSG_TMPL_TYPE_UINT8, 0, JMSG_TMPL_PRECISION_SHORTEST));
+   UT_ASSERT(JMSG_TMPL_Finish(&Tmpl, 0, 0));
+   UT_ASSERT(Tmpl.TextLen <= JMSG_UDP_PLATFORM_TMPL_TEXT_MAX);
+
+} /* End TestBuild() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   UT_RUN(TestFill);
+   UT_RUN(TestFloat);
+   UT_RUN(TestParse);
+   UT_RUN(TestBuild);
+
+   return UT_Summary();
+
+} /* End main() */
@@ -0,0 +1,364 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Unit tests for the io_uring Rx and Tx rings
+**
+** Notes:
+**   1. The rings are driven over loopback sockets. The tests pass without
+**      running when the kernel doesn't support io_uring multishot receives.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ut_jmsg.h"
+#include "jmsg_uring.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define TEST_DEPTH         4
+#define TEST_DATAGRAM_LEN  256
+#define TEST_TIMEOUT       1000      /* Milliseconds */
+#define WRAP_MSG_CNT       70000     /* Past the 16 bit buffer ring tail */
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static int    RxFd;
+static int    TxFd;
+static uint16 RxPort;
+static uint16 TxPort;
+
+
+/******************************************************************************
+** Function: OpenUdp
+**
+** Open a UDP socket bound to an ephemeral loopback port.
+**
+*/
+static int OpenUdp(uint16 *Port)
+{
+
+   struct sockaddr_in Addr;
+   socklen_t AddrLen = sizeof(Addr);
+   int Fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+   memset(&Addr, 0, sizeof(Addr));
+   Addr.sin_family      = AF_INET;
+   Addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   bind(Fd, (struct sockaddr *)&Addr, sizeof(Addr));
+   getsockname(Fd, (struct sockaddr *)&Addr, &AddrLen);
+   *Port = ntohs(Addr.sin_port);
+
+   return Fd;
+
+} /* End OpenUdp() */
+
+
+/******************************************************************************
+** Function: SendUdp
+**
+** Send a numbered datagram of Len bytes from TxFd to the Rx port.
+**
+*/
+static void SendUdp(uint32 Num, uint16 Len)
+{
+
+   struct sockaddr_in Addr;
+   uint8 Msg[2*TEST_DATAGRAM_LEN];
+
+   memset(Msg, (uint8)Num, Len);
+   memcpy(Msg, &Num, sizeof(Num));
+
+   memset(&Addr, 0, sizeof(Addr));
+   Addr.sin_family      = AF_INET;
+   Addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   Addr.sin_port        = htons(RxPort);
+   sendto(TxFd, Msg, Len, 0, (struct sockaddr *)&Addr, sizeof(Addr));
+
+} /* End SendUdp() */
+
+
+/******************************************************************************
+** Function: RecvNum
+**
+** Receive a datagram and check it's the numbered datagram from TxFd.
+**
+*/
+static bool RecvNum(JMSG_URING_Rx_t *Rx, uint32 Num, uint16 Len)
+{
+
+   JMSG_URING_RxMeta_t Meta;
+   uint8  Buf[2*TEST_DATAGRAM_LEN];
+   uint32 RecvNum = 0;
+   int32  Status  = JMSG_URING_Recv(Rx, Buf, sizeof(Buf), TEST_TIMEOUT, &Meta);
+
+   if (Status >= (int32)sizeof(RecvNum))
+   {
+      memcpy(&RecvNum, Buf, sizeof(RecvNum));
+   }
+
+   return (Status == Len && RecvNum == Num && Buf[Len - 1] == (uint8)Num && !Meta.Local &&
+           Meta.PeerAddr == INADDR_LOOPBACK && Meta.PeerPort == TxPort);
+
+} /* End RecvNum() */
+
+
+/******************************************************************************
+** Function: TestOpenErr
+**
+** Depths that aren't a power of 2 of at least 2 are rejected.
+**
+*/
+static void TestOpenErr(void)
+{
+
+   UT_ASSERT(JMSG_URING_OpenRx(RxFd, -1, 1, TEST_DATAGRAM_LEN, false) == NULL);
+   UT_ASSERT(JMSG_URING_OpenRx(RxFd, -1, 6, TEST_DATAGRAM_LEN, false) == NULL);
+   UT_ASSERT(JMSG_URING_OpenTx(0, TEST_DATAGRAM_LEN) == NULL);
+   UT_ASSERT(JMSG_URING_OpenTx(3, TEST_DATAGRAM_LEN) == NULL);
+
+} /* End TestOpenErr() */
+
+
+/******************************************************************************
+** Function: TestRxWrap
+**
+** Datagrams must be received in order with their sender while the
+** completion queue and buffer ring indices wrap.
+**
+*/
+static void TestRxWrap(void)
+{
+
+   JMSG_URING_Rx_t *Rx = JMSG_URING_OpenRx(RxFd, -1, TEST_DEPTH, TEST_DATAGRAM_LEN, false);
+   uint32 Num;
+   uint32 Batch;
+   bool   Received = true;
+
+   if (!UT_ASSERT(Rx != NULL))
+   {
+      return;
+   }
+
+   for (Num=0; Num < WRAP_MSG_CNT && Received; Num += Batch)
+   {
+      for (Batch=0; Batch < TEST_DEPTH/2; Batch++)
+      {
+         SendUdp(Num + Batch, 8 + (Num + Batch) % 64);
+      }
+      for (Batch=0; Batch < TEST_DEPTH/2 && Received; Batch++)
+      {
+         Received = RecvNum(Rx, Num + Batch, 8 + (Num + Batch) % 64);
+      }
+   }
+   if (!UT_ASSERT(Received))
+   {
+      printf("Datagram %u not received\n", (unsigned int)(Num + Batch - 1));
+   }
+   UT_ASSERT(Rx->BufTail == (uint16)(TEST_DEPTH + WRAP_MSG_CNT));
+
+   UT_ASSERT(JMSG_URING_Recv(Rx, &Num, sizeof(Num), OS_CHECK, NULL) == OS_ERROR_TIMEOUT);
+
+   JMSG_URING_CloseRx(Rx);
+
+} /* End TestRxWrap() */
+
+
+/******************************************************************************
+** Function: TestRxOverrun
+**
+** More datagrams than buffers end the multishot receive. The receive is
+** resubmitted and the waiting datagrams are received in order.
+**
+*/
+static void TestRxOverrun(void)
+{
+
+   JMSG_URING_Rx_t *Rx = JMSG_URING_OpenRx(RxFd, -1, TEST_DEPTH, TEST_DATAGRAM_LEN, false);
+   uint32 Num;
+   bool   Received = true;
+
+   if (!UT_ASSERT(Rx != NULL))
+   {
+      return;
+   }
+
+   for (Num=0; Num < 4*TEST_DEPTH; Num++)
+   {
+      SendUdp(Num, 16);
+   }
+   for (Num=0; Num < 4*TEST_DEPTH && Received; Num++)
+   {
+      Received = RecvNum(Rx, Num, 16);
+   }
+   UT_ASSERT(Received);
+   UT_ASSERT(Rx->RearmCnt > 0);
+
+   JMSG_URING_CloseRx(Rx);
+
+} /* End TestRxOverrun() */
+
+
+/******************************************************************************
+** Function: TestRxMalformed
+**
+** Oversized datagrams are truncated to the buffer and the caller's length,
+** empty datagrams are received and local datagrams have no sender.
+**
+*/
+static void TestRxMalformed(void)
+{
+
+   JMSG_URING_Rx_t *Rx;
+   JMSG_URING_RxMeta_t Meta;
+   int    LocalFd[2];
+   uint8  Buf[2*TEST_DATAGRAM_LEN];
+   int32  Status;
+
+   UT_ASSERT(socketpair(AF_UNIX, SOCK_DGRAM, 0, LocalFd) == 0);
+   Rx = JMSG_URING_OpenRx(RxFd, LocalFd[0], TEST_DEPTH, TEST_DATAGRAM_LEN, false);
+   if (!UT_ASSERT(Rx != NULL))
+   {
+      return;
+   }
+
+   SendUdp(1, 2*TEST_DATAGRAM_LEN);
+   Status = JMSG_URING_Recv(Rx, Buf, sizeof(Buf), TEST_TIMEOUT, &Meta);
+   UT_ASSERT(Status >= TEST_DATAGRAM_LEN && Status < 2*TEST_DATAGRAM_LEN && Buf[Status - 1] == 1);
+
+   SendUdp(2, 64);
+   UT_ASSERT(JMSG_URING_Recv(Rx, Buf, 10, TEST_TIMEOUT, &Meta) == 10 && Buf[0] == 2);
+
+   SendUdp(3, 0);
+   UT_ASSERT(JMSG_URING_Recv(Rx, Buf, sizeof(Buf), TEST_TIMEOUT, &Meta) == 0);
+
+   UT_ASSERT(write(LocalFd[1], "t:{}", 4) == 4);
+   Status = JMSG_URING_Recv(Rx, Buf, sizeof(Buf), TEST_TIMEOUT, &Meta);
+   UT_ASSERT(Status == 4 && memcmp(Buf, "t:{}", 4) == 0);
+   UT_ASSERT(Meta.Local && Meta.PeerAddr == 0 && Meta.PeerPort == 0);
+
+   SendUdp(4, 16);
+   UT_ASSERT(RecvNum(Rx, 4, 16));
+
+   JMSG_URING_CloseRx(Rx);
+   close(LocalFd[0]);
+   close(LocalFd[1]);
+
+} /* End TestRxMalformed() */
+
+
+/******************************************************************************
+** Function: TestTx
+**
+** Sends past the slot count wait for a free slot and every send completes.
+**
+*/
+static void TestTx(void)
+{
+
+   JMSG_URING_Tx_t *Tx = JMSG_URING_OpenTx(TEST_DEPTH, TEST_DATAGRAM_LEN);
+   uint8  Msg[2*TEST_DATAGRAM_LEN];
+   uint8  Buf[TEST_DATAGRAM_LEN];
+   uint32 Num;
+   uint32 RecvNum;
+   uint32 SendCnt = 0;
+   uint32 RecvCnt = 0;
+   uint16 i;
+
+   if (!UT_ASSERT(Tx != NULL))
+   {
+      return;
+   }
+
+   memset(Msg, 0, sizeof(Msg));
+   UT_ASSERT(!JMSG_URING_Send(Tx, (char *)Msg, sizeof(Msg), INADDR_LOOPBACK, RxPort));
+
+   for (Num=0; Num < 8*TEST_DEPTH; Num++)
+   {
+      memcpy(Msg, &Num, sizeof(Num));
+      SendCnt += JMSG_URING_Send(Tx, (char *)Msg, 32, INADDR_LOOPBACK, RxPort);
+   }
+   JMSG_URING_Flush(Tx);
+   UT_ASSERT(SendCnt == 8*TEST_DEPTH);
+
+   for (Num=0; Num < SendCnt; Num++)
+   {
+      if (recv(RxFd, Buf, sizeof(Buf), 0) == 32)
+      {
+         memcpy(&RecvNum, Buf, sizeof(RecvNum));
+         RecvCnt += (RecvNum == Num);
+      }
+   }
+   UT_ASSERT(RecvCnt == SendCnt);
+
+   for (i=0; i < 10 && Tx->FreeCnt < Tx->SlotCnt; i++)
+   {
+      usleep(1000);
+      JMSG_URING_Flush(Tx);
+   }
+   UT_ASSERT(Tx->FreeCnt == Tx->SlotCnt);
+   UT_ASSERT(Tx->SendCnt == SendCnt && Tx->ErrCnt == 0);
+
+   JMSG_URING_CloseTx(Tx);
+
+} /* End TestTx() */
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(void)
+{
+
+   JMSG_URING_Rx_t *Rx;
+
+   RxFd = OpenUdp(&RxPort);
+   TxFd = OpenUdp(&TxPort);
+
+   Rx = JMSG_URING_OpenRx(RxFd, -1, TEST_DEPTH, TEST_DATAGRAM_LEN, false);
+   if (Rx == NULL)
+   {
+      printf("io_uring isn't supported, skipping the ring tests\n");
+   }
+   else
+   {
+      JMSG_URING_CloseRx(Rx);
+      UT_RUN(TestOpenErr);
+      UT_RUN(TestRxWrap);
+      UT_RUN(TestRxOverrun);
+      UT_RUN(TestRxMalformed);
+      UT_RUN(TestTx);
+   }
+
+   close(RxFd);
+   close(TxFd);
+
+   return UT_Summary();
+
+} /* End main() */
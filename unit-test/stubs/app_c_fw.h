@@ -0,0 +1,72 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Host unit test replacement for the app_c_fw framework API
+**
+*/
+#ifndef _app_c_fw_
+#define _app_c_fw_
+
+#include "cfe.h"
+
+#define APP_C_FW_CFS_ERROR      (-1)
+#define APP_C_FW_APP_BASE_EID   100
+
+typedef struct { int Unused; } INITBL_Class_t;
+typedef struct { uint16 ValidCmdCnt, InvalidCmdCnt; } CMDMGR_Class_t;
+typedef struct { CFE_ES_TaskId_t TaskId; } CHILDMGR_Class_t;
+typedef struct { int Unused; } TBLMGR_Class_t;
+typedef struct { const char *TaskName; uint32 StackSize, Priority, PerfId; } CHILDMGR_TaskInit_t;
+typedef bool (*CHILDMGR_TaskCallback_t)(CHILDMGR_Class_t *ChildMgr);
+typedef bool (*CMDMGR_CmdFuncPtr_t)(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr);
+
+typedef int APP_C_FW_TblLoadOptions_Enum_t;
+#define APP_C_FW_TblLoadOptions_REPLACE  1
+#define APP_C_FW_TblLoadOptions_UPDATE   2
+typedef bool (*TBLMGR_LoadTblFuncPtr_t)(APP_C_FW_TblLoadOptions_Enum_t LoadOpt, const char *Filename);
+typedef bool (*TBLMGR_DumpTblFuncPtr_t)(osal_id_t FileHandle);
+typedef struct { char Filename[64]; uint8 Type; } APP_C_FW_LoadTbl_CmdPayload_t;
+typedef struct { char Filename[64]; } APP_C_FW_DumpTbl_CmdPayload_t;
+
+/* The enum ends with a count so the INITBL stub can size its value table */
+#define DECLARE_ENUM(Name,List) typedef enum { List(UT_ENUM_ITEM) Name##_ENUM_CNT } Name##Enum;
+#define UT_ENUM_ITEM(Item,Type) Item,
+#define DEFINE_ENUM(Name,List) static int IniCfgEnum;
+
+bool   INITBL_Constructor(INITBL_Class_t *IniTbl, const char *IniFile, void *IniCfgEnum);
+uint32 INITBL_GetIntConfig(const INITBL_Class_t *IniTbl, int Param);
+const char *INITBL_GetStrConfig(const INITBL_Class_t *IniTbl, int Param);
+
+void CMDMGR_Constructor(CMDMGR_Class_t *CmdMgr);
+bool CMDMGR_RegisterFunc(CMDMGR_Class_t *CmdMgr, uint16 FuncCode, void *ObjDataPtr, CMDMGR_CmdFuncPtr_t ObjFuncPtr, uint16 UserDataLen);
+bool CMDMGR_DispatchFunc(CMDMGR_Class_t *CmdMgr, const CFE_MSG_Message_t *MsgPtr);
+void CMDMGR_ResetStatus(CMDMGR_Class_t *CmdMgr);
+#define CMDMGR_PAYLOAD_PTR(MsgPtr,Type) (&((const Type *)(MsgPtr))->Payload)
+
+int32 CHILDMGR_Constructor(CHILDMGR_Class_t *ChildMgr, void (*ChildTaskMainFunc)(void),
+                           CHILDMGR_TaskCallback_t TaskCallback, CHILDMGR_TaskInit_t *TaskInit);
+void  ChildMgr_TaskMainCallback(void);
+void  CHILDMGR_ResetStatus(CHILDMGR_Class_t *ChildMgr);
+
+void  TBLMGR_Constructor(TBLMGR_Class_t *TblMgr, const char *AppName);
+uint8 TBLMGR_RegisterTblWithDef(TBLMGR_Class_t *TblMgr, const char *TblName, TBLMGR_LoadTblFuncPtr_t LoadFunc,
+                                TBLMGR_DumpTblFuncPtr_t DumpFunc, const char *TblFilename);
+bool  TBLMGR_LoadTblCmd(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr);
+bool  TBLMGR_DumpTblCmd(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr);
+void  TBLMGR_ResetStatus(TBLMGR_Class_t *TblMgr);
+
+bool CJSON_ProcessFile(const char *Filename, char *JsonBuf, size_t MaxJsonFileChar, bool (*LoadJsonData)(size_t JsonFileLen));
+
+#endif /* _app_c_fw_ */
@@ -0,0 +1,189 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Host unit test replacement for the cFE, OSAL and PSP API headers
+**
+** Notes:
+**   1. Only the types, macros and functions used by the app's sources are
+**      declared. The functions the tested modules call are implemented in
+**      ut_stubs.c.
+**
+*/
+#ifndef _cfe_
+#define _cfe_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef int8_t   int8;
+typedef int16_t  int16;
+typedef int32_t  int32;
+typedef int64_t  int64;
+
+typedef uint32 osal_id_t;
+typedef uint32 CFE_SB_PipeId_t;
+typedef uint32 CFE_ES_TaskId_t;
+typedef struct { uint32 Value; } CFE_SB_MsgId_t;
+typedef struct { uint8 Byte[8]; } CFE_MSG_Message_t;
+typedef struct { CFE_MSG_Message_t Msg; uint8 Sec[6]; } CFE_MSG_TelemetryHeader_t;
+typedef struct { CFE_MSG_Message_t Msg; uint8 Sec[2]; } CFE_MSG_CommandHeader_t;
+typedef union  { CFE_MSG_Message_t Msg; } CFE_SB_Buffer_t;
+typedef size_t CFE_MSG_Size_t;
+typedef int    CFE_MSG_Type_t;
+typedef uint16 CFE_MSG_SequenceCount_t;
+typedef struct { uint32 Seconds; uint32 Subseconds; } CFE_TIME_SysTime_t;
+typedef struct { uint8 Priority; uint8 Reliability; } CFE_SB_Qos_t;
+typedef struct { uint16 EventID; uint16 Mask; } CFE_EVS_BinFilter_t;
+typedef struct { char Data[28]; } OS_SockAddr_t;
+typedef struct { uint8 object_ids[16]; } OS_FdSet;
+typedef struct { int64 ticks; } OS_time_t;   /* 100ns ticks */
+
+#define CFE_SUCCESS   0
+#define CFE_STATUS_EXTERNAL_RESOURCE_FAIL  ((int32)0xc6000002)
+#define OS_SUCCESS    0
+#define OS_ERROR      (-1)
+#define OS_ERROR_TIMEOUT        (-30)
+#define OS_ERR_NOT_IMPLEMENTED  (-36)
+#define OS_FS_ERR_PATH_TOO_LONG (-103)
+#define OS_QUEUE_EMPTY    (-12)
+#define OS_QUEUE_TIMEOUT  (-13)
+#define OS_QUEUE_FULL     (-14)
+#define OS_PEND   (-1)
+#define OS_CHECK  0
+#define OS_OBJECT_ID_UNDEFINED     0
+#define OS_STREAM_STATE_READABLE   1
+#define OS_MAX_PATH_LEN        64
+#define OS_MAX_LOCAL_PATH_LEN  128
+#define OS_MAX_API_NAME        20
+
+#define CFE_SB_PEND_FOREVER  (-1)
+#define CFE_SB_POLL          0
+#define CFE_SB_NO_MESSAGE    5
+#define CFE_SB_TIME_OUT      6
+#define CFE_SB_INVALID_MSG_ID ((CFE_SB_MsgId_t){0})
+#define CFE_MSG_Type_Cmd  1
+#define CFE_MSG_Type_Tlm  2
+#define CFE_MSG_PTR(s) ((CFE_MSG_Message_t *)&(s))
+
+#define CFE_EVS_EventType_DEBUG        1
+#define CFE_EVS_EventType_INFORMATION  2
+#define CFE_EVS_EventType_ERROR        3
+#define CFE_EVS_EventType_CRITICAL     4
+#define CFE_EVS_FIRST_4_STOP           0xfffc
+#define CFE_EVS_NO_FILTER              0
+#define CFE_EVS_EventFilter_BINARY     0
+
+#define CFE_ES_RunStatus_APP_RUN    1
+#define CFE_ES_RunStatus_APP_EXIT   2
+#define CFE_ES_RunStatus_APP_ERROR  3
+
+#define OS_FILE_FLAG_NONE      0
+#define OS_FILE_FLAG_CREATE    1
+#define OS_FILE_FLAG_TRUNCATE  2
+#define OS_READ_ONLY   0
+#define OS_WRITE_ONLY  1
+#define OS_READ_WRITE  2
+#define OS_SocketDomain_INET    1
+#define OS_SocketType_DATAGRAM  1
+
+int32 CFE_EVS_SendEvent(uint16 EventID, uint16 EventType, const char *Spec, ...) __attribute__((format(printf,3,4)));
+int32 CFE_EVS_Register(const void *Filters, uint16 NumFilteredEvents, uint16 FilterScheme);
+int32 CFE_EVS_ResetAllFilters(void);
+int32 CFE_ES_WriteToSysLog(const char *Spec, ...);
+void  CFE_ES_ExitApp(uint32 ExitStatus);
+bool  CFE_ES_RunLoop(uint32 *RunStatus);
+void  CFE_ES_PerfLogEntry(uint32 Marker);
+void  CFE_ES_PerfLogExit(uint32 Marker);
+int32 CFE_ES_DeleteChildTask(CFE_ES_TaskId_t TaskId);
+
+int32 CFE_SB_CreatePipe(CFE_SB_PipeId_t *PipeIdPtr, uint16 Depth, const char *PipeName);
+int32 CFE_SB_DeletePipe(CFE_SB_PipeId_t PipeId);
+int32 CFE_SB_Subscribe(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId);
+int32 CFE_SB_SubscribeEx(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId, CFE_SB_Qos_t Quality, uint16 MsgLim);
+int32 CFE_SB_Unsubscribe(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId);
+int32 CFE_SB_ReceiveBuffer(CFE_SB_Buffer_t **BufPtr, CFE_SB_PipeId_t PipeId, int32 TimeOut);
+int32 CFE_SB_TransmitMsg(const CFE_MSG_Message_t *MsgPtr, bool IncrementSequenceCount);
+void  CFE_SB_TimeStampMsg(CFE_MSG_Message_t *MsgPtr);
+CFE_SB_MsgId_t CFE_SB_ValueToMsgId(uint32 MsgIdValue);
+uint32 CFE_SB_MsgIdToValue(CFE_SB_MsgId_t MsgId);
+bool  CFE_SB_MsgId_Equal(CFE_SB_MsgId_t MsgId1, CFE_SB_MsgId_t MsgId2);
+bool  CFE_SB_IsValidMsgId(CFE_SB_MsgId_t MsgId);
+
+int32 CFE_MSG_Init(CFE_MSG_Message_t *MsgPtr, CFE_SB_MsgId_t MsgId, CFE_MSG_Size_t Size);
+int32 CFE_MSG_SetMsgId(CFE_MSG_Message_t *MsgPtr, CFE_SB_MsgId_t MsgId);
+int32 CFE_MSG_SetFcnCode(CFE_MSG_Message_t *MsgPtr, uint16 FcnCode);
+int32 CFE_MSG_GetMsgId(const CFE_MSG_Message_t *MsgPtr, CFE_SB_MsgId_t *MsgId);
+int32 CFE_MSG_GetSize(const CFE_MSG_Message_t *MsgPtr, CFE_MSG_Size_t *Size);
+int32 CFE_MSG_GetType(const CFE_MSG_Message_t *MsgPtr, CFE_MSG_Type_t *Type);
+int32 CFE_MSG_GetTypeFromMsgId(CFE_SB_MsgId_t MsgId, CFE_MSG_Type_t *Type);
+int32 CFE_MSG_GenerateChecksum(CFE_MSG_Message_t *MsgPtr);
+int32 CFE_MSG_SetMsgTime(CFE_MSG_Message_t *MsgPtr, CFE_TIME_SysTime_t NewTime);
+int32 CFE_MSG_GetMsgTime(const CFE_MSG_Message_t *MsgPtr, CFE_TIME_SysTime_t *Time);
+int32 CFE_MSG_GetSequenceCount(const CFE_MSG_Message_t *MsgPtr, CFE_MSG_SequenceCount_t *SeqCnt);
+
+CFE_TIME_SysTime_t CFE_TIME_GetTime(void);
+CFE_TIME_SysTime_t CFE_TIME_Subtract(CFE_TIME_SysTime_t Time1, CFE_TIME_SysTime_t Time2);
+CFE_TIME_SysTime_t CFE_TIME_Add(CFE_TIME_SysTime_t Time1, CFE_TIME_SysTime_t Time2);
+uint32 CFE_TIME_Sub2MicroSecs(uint32 SubSeconds);
+uint32 CFE_TIME_Micro2SubSecs(uint32 MicroSeconds);
+
+int32 CFE_PSP_MemSet(void *Dest, uint8 Value, uint32 Size);
+int32 CFE_PSP_MemCpy(void *Dest, const void *Src, uint32 Size);
+void  CFE_PSP_GetTime(OS_time_t *LocalTime);
+
+int32 OS_TranslatePath(const char *VirtualPath, char *LocalPath);
+int32 OS_SocketOpen(osal_id_t *SockId, int Domain, int Type);
+int32 OS_SocketBind(osal_id_t SockId, const OS_SockAddr_t *Addr);
+int32 OS_SocketAddrInit(OS_SockAddr_t *Addr, int Domain);
+int32 OS_SocketAddrSetPort(OS_SockAddr_t *Addr, uint16 PortNum);
+int32 OS_SocketAddrGetPort(uint16 *PortNum, const OS_SockAddr_t *Addr);
+int32 OS_SocketAddrFromString(OS_SockAddr_t *Addr, const char *String);
+int32 OS_SocketAddrToString(char *Buffer, size_t BufLen, const OS_SockAddr_t *Addr);
+int32 OS_SocketRecvFrom(osal_id_t SockId, void *Buffer, size_t BufLen, OS_SockAddr_t *RemoteAddr, int32 Timeout);
+int32 OS_SocketSendTo(osal_id_t SockId, const void *Buffer, size_t BufLen, const OS_SockAddr_t *RemoteAddr);
+int32 OS_close(osal_id_t FileDes);
+int32 OS_TaskDelay(uint32 Milliseconds);
+int32 OS_SelectSingle(osal_id_t ObjId, uint32 *StateFlags, int32 Msecs);
+int32 OS_SelectMultiple(OS_FdSet *ReadSet, OS_FdSet *WriteSet, int32 Msecs);
+int32 OS_SelectFdZero(OS_FdSet *Set);
+int32 OS_SelectFdAdd(OS_FdSet *Set, osal_id_t ObjId);
+bool  OS_SelectFdIsSet(const OS_FdSet *Set, osal_id_t ObjId);
+int32 OS_MutSemCreate(osal_id_t *SemId, const char *SemName, uint32 Options);
+int32 OS_MutSemTake(osal_id_t SemId);
+int32 OS_MutSemGive(osal_id_t SemId);
+int32 OS_CountSemCreate(osal_id_t *SemId, const char *SemName, uint32 InitialValue, uint32 Options);
+int32 OS_CountSemTake(osal_id_t SemId);
+int32 OS_CountSemGive(osal_id_t SemId);
+int32 OS_CountSemTimedWait(osal_id_t SemId, uint32 Msecs);
+int32 OS_OpenCreate(osal_id_t *FileDes, const char *Path, int32 Flags, int32 Access);
+int32 OS_read(osal_id_t FileDes, void *Buffer, size_t NumBytes);
+int32 OS_write(osal_id_t FileDes, const void *Buffer, size_t NumBytes);
+void  OS_GetLocalTime(OS_time_t *TimeStruct);
+int64 OS_TimeGetTotalMicroseconds(OS_time_t Tm);
+int64 OS_TimeGetTotalMilliseconds(OS_time_t Tm);
+int64 OS_TimeGetTotalNanoseconds(OS_time_t Tm);
+OS_time_t OS_TimeSubtract(OS_time_t Time1, OS_time_t Time2);
+bool  OS_ObjectIdDefined(osal_id_t ObjId);
+bool  OS_ObjectIdEqual(osal_id_t ObjId1, osal_id_t ObjId2);
+osal_id_t OS_TaskGetId(void);
+
+#endif /* _cfe_ */
@@ -0,0 +1,44 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Host unit test replacement for the jmsg_lib topic table API
+**
+*/
+#ifndef _jmsg_topic_tbl_
+#define _jmsg_topic_tbl_
+
+#include "cfe.h"
+#define JMSG_PLATFORM_TOPIC_NAME_MAX_LEN 64
+#define JMSG_PLATFORM_TOPIC_PLUGIN_MAX 16
+#define JMSG_PLATFORM_TOPIC_PLUGIN_UNDEF 99
+typedef int JMSG_PLATFORM_TopicPlugin_Enum_t;
+#define JMSG_PLATFORM_TopicPlugin_Enum_t_MIN 0
+#define JMSG_PLATFORM_TopicPlugin_Enum_t_MAX 15
+typedef struct { char Name[64]; char Descr[64]; uint16 Cfe; uint16 SbRole; uint16 Protocol; } JMSG_TOPIC_TBL_Topic_t;
+typedef enum { JMSG_TOPIC_TBL_SUB_SB, JMSG_TOPIC_TBL_SUB_JMSG, JMSG_TOPIC_TBL_UNSUB_SB, JMSG_TOPIC_TBL_UNSUB_JMSG, JMSG_TOPIC_TBL_SUB_TO_ROLE, JMSG_TOPIC_TBL_SUB_ERR } JMSG_TOPIC_TBL_SubscriptionOptEnum_t;
+typedef bool (*JMSG_TOPIC_TBL_JsonToCfe_t)(CFE_MSG_Message_t **, const char*, uint16);
+typedef bool (*JMSG_TOPIC_TBL_CfeToJson_t)(const char **, const CFE_MSG_Message_t*);
+typedef bool (*JMSG_TOPIC_TBL_ConfigSubscription_t)(const JMSG_TOPIC_TBL_Topic_t*, JMSG_TOPIC_TBL_SubscriptionOptEnum_t);
+const JMSG_TOPIC_TBL_Topic_t *JMSG_TOPIC_TBL_GetTopic(int);
+JMSG_TOPIC_TBL_JsonToCfe_t JMSG_TOPIC_TBL_GetJsonToCfe(int);
+JMSG_TOPIC_TBL_CfeToJson_t JMSG_TOPIC_TBL_GetCfeToJson(int, const char**);
+int JMSG_TOPIC_TBL_MsgIdToTopicPlugin(CFE_SB_MsgId_t);
+bool JMSG_TOPIC_TBL_RegisterConfigSubscriptionCallback(int, JMSG_TOPIC_TBL_ConfigSubscription_t);
+JMSG_TOPIC_TBL_SubscriptionOptEnum_t JMSG_TOPIC_TBL_SubscribeToTopicMsg(int, JMSG_TOPIC_TBL_SubscriptionOptEnum_t);
+typedef struct { uint16 Id; uint8 Protocol; } JMSG_LIB_TopicSubscribeTlm_Payload_t;
+typedef struct { CFE_MSG_TelemetryHeader_t h; JMSG_LIB_TopicSubscribeTlm_Payload_t Payload; } JMSG_LIB_TopicSubscribeTlm_t;
+#define JMSG_LIB_TopicProtocol_UDP 1
+
+#endif /* _jmsg_topic_tbl_ */
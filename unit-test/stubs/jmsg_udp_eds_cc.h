@@ -0,0 +1,30 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Host unit test replacement for the EDS generated command codes
+**
+*/
+#ifndef _jmsg_udp_eds_cc_
+#define _jmsg_udp_eds_cc_
+
+#define JMSG_UDP_NOOP_CC 0
+#define JMSG_UDP_RESET_CC 1
+#define JMSG_UDP_LOAD_TBL_CC 2
+#define JMSG_UDP_DUMP_TBL_CC 3
+#define JMSG_UDP_RECONFIG_CC 10
+#define JMSG_UDP_CAPTURE_CC 11
+#define JMSG_UDP_SELF_TEST_CC 12
+
+#endif /* _jmsg_udp_eds_cc_ */
@@ -0,0 +1,58 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Host unit test replacement for the EDS generated data types
+**
+** Notes:
+**   1. Keep the structures in sync with eds/jmsg_udp.xml. Only the sizes
+**      of the arrays the tested modules index need to match.
+**
+*/
+#ifndef _jmsg_udp_eds_typedefs_
+#define _jmsg_udp_eds_typedefs_
+
+#include "cfe.h"
+typedef struct { uint32 RouteTbl, Trans, Rel, Frag, Lz, Lvc, SelfTest, Decode, RxBuf, TxBuf, ArenaUsed, ArenaLen, RxStack, TxStack; } JMSG_UDP_MemReport_t;
+typedef struct { uint16 ValidCmdCnt, InvalidCmdCnt; uint8 RxUdpConnected; uint8 RxKernelTime; uint32 RxUdpMsgCnt, RxUdpMsgErrCnt, RxMaxProcTime, RxSlowMsgCnt, ValidJMsgCnt, InvalidJMsgCnt, ShapeHitCnt, ShapeMissCnt; uint8 TxUdpConnected; uint32 TxUdpMsgCnt, TxUdpMsgErrCnt, ValidSbMsgCnt, InvalidSbMsgCnt, TmplSbMsgCnt, FilterSbMsgCnt; uint16 RouteCnt; uint32 ReconfigCnt; uint32 DupJMsgCnt, SeqLostCnt, SeqReorderCnt; uint16 SeqLossPerMille; uint16 RelPendingCnt; uint32 RelRetryCnt, RelFailCnt, RelAckRxCnt, RelAckTxCnt; uint32 FragTxMsgCnt, FragTxErrCnt, FragRxMsgCnt, FragRxDropCnt; uint16 FragRxPendingCnt; uint32 LzTxMsgCnt, LzTxSkipCnt; uint16 LzRatioPerMille; uint32 LzRxMsgCnt, LzRxErrCnt; uint8 CapActive; uint32 CapRxRecCnt, CapTxRecCnt, CapLostCnt; uint32 LocalUnixTxCnt, LocalShmTxCnt, LocalDropCnt; uint8 IoUring; uint32 IoUringEnterCnt, IoUringTxErrCnt; uint16 JMsgPipeQueued, JMsgPipeHighWater; uint32 SbOverflowCnt; uint16 LvcTopicCnt; uint32 LvcQueryCnt, LvcReplyCnt, LvcMissCnt, LvcSkipCnt, LvcRejectCnt; JMSG_UDP_MemReport_t Mem; } JMSG_UDP_StatusTlm_Payload_t;
+typedef struct { CFE_MSG_TelemetryHeader_t TelemetryHeader; JMSG_UDP_StatusTlm_Payload_t Payload; } JMSG_UDP_StatusTlm_t;
+typedef struct { uint16 RxPort; char TxAddr[16]; uint16 TxPort; uint16 JMsgPipeDepth; char RouteTblFile[64]; } JMSG_UDP_Reconfig_CmdPayload_t;
+typedef struct { CFE_MSG_CommandHeader_t CommandHeader; JMSG_UDP_Reconfig_CmdPayload_t Payload; } JMSG_UDP_Reconfig_t;
+typedef struct { uint32 PeerAddr; uint16 PeerPort; uint16 LossPerMille; uint32 RxCnt, LostCnt, ReorderCnt, DupCnt, RestartCnt; } JMSG_UDP_PeerStats_t;
+typedef struct { uint16 PeerCnt; uint16 StreamCnt; uint32 UntrackedCnt; JMSG_UDP_PeerStats_t Peer[8]; } JMSG_UDP_PeerStatsTlm_Payload_t;
+typedef struct { CFE_MSG_TelemetryHeader_t TelemetryHeader; JMSG_UDP_PeerStatsTlm_Payload_t Payload; } JMSG_UDP_PeerStatsTlm_t;
+
+typedef struct { char Topic[64]; uint32 MsgCnt, SkipCnt, RawBytes, ZipBytes; uint16 RatioPerMille; } JMSG_UDP_LzTopicStats_t;
+typedef struct { uint16 TopicCnt; JMSG_UDP_LzTopicStats_t Topic[8]; } JMSG_UDP_LzStatsTlm_Payload_t;
+typedef struct { CFE_MSG_TelemetryHeader_t TelemetryHeader; JMSG_UDP_LzStatsTlm_Payload_t Payload; } JMSG_UDP_LzStatsTlm_t;
+typedef struct { uint8 Enable; char File[64]; } JMSG_UDP_Capture_CmdPayload_t;
+typedef struct { CFE_MSG_CommandHeader_t CommandHeader; JMSG_UDP_Capture_CmdPayload_t Payload; } JMSG_UDP_Capture_t;
+typedef struct { uint32 MsgId, MsgCnt, OverflowCnt; uint16 HighWater; } JMSG_UDP_SbTopicStats_t;
+typedef struct { uint16 PipeDepth, PipeQueued, PipeHighWater, DefMsgLim; uint32 OverflowCnt, UntrackedCnt; uint16 TopicCnt; JMSG_UDP_SbTopicStats_t Topic[16]; } JMSG_UDP_SbStatsTlm_Payload_t;
+typedef struct { CFE_MSG_TelemetryHeader_t TelemetryHeader; JMSG_UDP_SbStatsTlm_Payload_t Payload; } JMSG_UDP_SbStatsTlm_t;
+
+typedef struct { uint32 MsgId; uint16 MsgCnt, PayloadLen; } JMSG_UDP_SelfTest_CmdPayload_t;
+typedef struct { CFE_MSG_CommandHeader_t CommandHeader; JMSG_UDP_SelfTest_CmdPayload_t Payload; } JMSG_UDP_SelfTest_t;
+typedef struct { uint32 MsgId; uint16 MsgCnt, PayloadLen, SentCnt, RecvCnt, LostCnt, TxErrCnt, RxErrCnt; uint32 ElapsedUs, MsgPerSec, LatencyMinUs, LatencyP50Us, LatencyP90Us, LatencyP99Us, LatencyMaxUs; } JMSG_UDP_SelfTestTlm_Payload_t;
+typedef struct { CFE_MSG_TelemetryHeader_t TelemetryHeader; JMSG_UDP_SelfTestTlm_Payload_t Payload; } JMSG_UDP_SelfTestTlm_t;
+
+typedef struct { uint32 MsgCnt, ByteCnt, MsgPerSec, BytePerSec, PeakMsgPerSec, PeakBytePerSec, MaxLen; uint32 SizeBin[8]; } JMSG_UDP_RateStats_t;
+typedef struct { uint32 IntervalMs; JMSG_UDP_RateStats_t Rx, Tx; } JMSG_UDP_ExtStatusTlm_Payload_t;
+typedef struct { CFE_MSG_TelemetryHeader_t TelemetryHeader; JMSG_UDP_ExtStatusTlm_Payload_t Payload; } JMSG_UDP_ExtStatusTlm_t;
+
+typedef struct { uint32 MsgCnt, DropCnt; uint16 Queued, HighWater, BusyPerMille; } JMSG_UDP_DecodeWorkerStats_t;
+typedef struct { uint16 WorkerCnt, QueueDepth; uint32 QueueLen; JMSG_UDP_DecodeWorkerStats_t Worker[4]; } JMSG_UDP_DecodeStatsTlm_Payload_t;
+typedef struct { CFE_MSG_TelemetryHeader_t TelemetryHeader; JMSG_UDP_DecodeStatsTlm_Payload_t Payload; } JMSG_UDP_DecodeStatsTlm_t;
+
+#endif /* _jmsg_udp_eds_typedefs_ */
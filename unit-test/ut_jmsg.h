@@ -0,0 +1,112 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Minimal assertion and stub control API for the host unit tests
+**
+** Notes:
+**   1. Each test program registers its test functions with UT_RUN() and
+**      returns UT_Summary() from main() so ctest sees a non-zero exit status
+**      when an assertion fails.
+**   2. UT_RUN() resets the stub state before each test.
+**
+*/
+#ifndef _ut_jmsg_
+#define _ut_jmsg_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define UT_ASSERT(Cond)  UT_Assert((Cond), #Cond, __FILE__, __LINE__)
+#define UT_RUN(Test)     UT_Run(Test, #Test)
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: UT_Assert
+**
+** Count an assertion and report it when it fails. Returns Cond.
+**
+*/
+bool UT_Assert(bool Cond, const char *Text, const char *File, int Line);
+
+
+/******************************************************************************
+** Function: UT_Run
+**
+** Reset the stubs and run a test function.
+**
+*/
+void UT_Run(void (*Test)(void), const char *Name);
+
+
+/******************************************************************************
+** Function: UT_Summary
+**
+** Report the assertion counts and return the program's exit status.
+**
+*/
+int UT_Summary(void);
+
+
+/******************************************************************************
+** Function: UT_EventCnt
+**
+** Return the number of events sent with EventId since the last reset.
+**
+*/
+uint32 UT_EventCnt(uint16 EventId);
+
+
+/******************************************************************************
+** Function: UT_SetIniInt
+**
+** Set the value returned by INITBL_GetIntConfig() for Param.
+**
+*/
+void UT_SetIniInt(int Param, uint32 Value);
+
+
+/******************************************************************************
+** Function: UT_SetIniStr
+**
+** Set the value returned by INITBL_GetStrConfig() for Param.
+**
+*/
+void UT_SetIniStr(int Param, const char *Value);
+
+
+/******************************************************************************
+** Function: UT_SetTimeUs
+**
+** Freeze the time returned by the OSAL and PSP clocks at TimeUs. A negative
+** value lets the clocks run from the host's monotonic clock again.
+**
+*/
+void UT_SetTimeUs(int64 TimeUs);
+
+
+#endif /* _ut_jmsg_ */
@@ -0,0 +1,528 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Host implementations of the cFE, OSAL, PSP and app_c_fw functions
+**
+** Notes:
+**   1. Mutexes and counting semaphores are backed by POSIX objects so
+**      modules with worker tasks can be tested with host threads.
+**   2. Event messages are counted by ID and only printed when the
+**      UT_VERBOSE environment variable is set.
+**
+*/
+
+/*
+** Include Files:
+*/
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ut_jmsg.h"
+
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define UT_EVENT_ID_MAX  512
+#define UT_SEM_MAX       64
+
+
+/**********************/
+/** Global File Data **/
+/**********************/
+
+static uint32 AssertCnt;
+static uint32 FailCnt;
+
+static uint32 EventCnt[UT_EVENT_ID_MAX];
+
+static uint32      IniInt[Config_ENUM_CNT];
+static const char *IniStr[Config_ENUM_CNT];
+
+static int64  FrozenTimeUs = -1;
+
+static pthread_mutex_t MutSem[UT_SEM_MAX];
+static uint32          MutSemCnt;
+static sem_t           CountSem[UT_SEM_MAX];
+static uint32          CountSemCnt;
+
+
+/******************************************************************************
+** Function: UT_Assert
+**
+*/
+bool UT_Assert(bool Cond, const char *Text, const char *File, int Line)
+{
+
+   AssertCnt++;
+   if (!Cond)
+   {
+      FailCnt++;
+      printf("FAIL %s:%d: %s\n", File, Line, Text);
+   }
+
+   return Cond;
+
+} /* End UT_Assert() */
+
+
+/******************************************************************************
+** Function: UT_Run
+**
+*/
+void UT_Run(void (*Test)(void), const char *Name)
+{
+
+   uint32 PrevFailCnt = FailCnt;
+
+   memset(EventCnt, 0, sizeof(EventCnt));
+   FrozenTimeUs = -1;
+
+   Test();
+
+   printf("%s %s\n", (FailCnt == PrevFailCnt) ? "PASS" : "FAIL", Name);
+
+} /* End UT_Run() */
+
+
+/******************************************************************************
+** Function: UT_Summary
+**
+*/
+int UT_Summary(void)
+{
+
+   printf("%u assertions, %u failed\n", AssertCnt, FailCnt);
+
+   return (FailCnt == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+} /* End UT_Summary() */
+
+
+/******************************************************************************
+** Function: UT_EventCnt
+**
+*/
+uint32 UT_EventCnt(uint16 EventId)
+{
+
+   return (EventId < UT_EVENT_ID_MAX) ? EventCnt[EventId] : 0;
+
+} /* End UT_EventCnt() */
+
+
+/******************************************************************************
+** Function: UT_SetIniInt
+**
+*/
+void UT_SetIniInt(int Param, uint32 Value)
+{
+
+   IniInt[Param] = Value;
+
+} /* End UT_SetIniInt() */
+
+
+/******************************************************************************
+** Function: UT_SetIniStr
+**
+*/
+void UT_SetIniStr(int Param, const char *Value)
+{
+
+   IniStr[Param] = Value;
+
+} /* End UT_SetIniStr() */
+
+
+/******************************************************************************
+** Function: UT_SetTimeUs
+**
+*/
+void UT_SetTimeUs(int64 TimeUs)
+{
+
+   FrozenTimeUs = TimeUs;
+
+} /* End UT_SetTimeUs() */
+
+
+/******************************************************************************
+** Function: HostTimeUs
+**
+*/
+static int64 HostTimeUs(void)
+{
+
+   struct timespec Now;
+
+   if (FrozenTimeUs >= 0)
+   {
+      return FrozenTimeUs;
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &Now);
+
+   return (int64)Now.tv_sec * 1000000 + Now.tv_nsec / 1000;
+
+} /* End HostTimeUs() */
+
+
+/*
+** cFE
+*/
+
+int32 CFE_EVS_SendEvent(uint16 EventID, uint16 EventType, const char *Spec, ...)
+{
+
+   va_list Args;
+
+   if (EventID < UT_EVENT_ID_MAX)
+   {
+      EventCnt[EventID]++;
+   }
+   if (getenv("UT_VERBOSE") != NULL)
+   {
+      printf("EVS %u/%u: ", EventID, EventType);
+      va_start(Args, Spec);
+      vprintf(Spec, Args);
+      va_end(Args);
+      printf("\n");
+   }
+
+   return CFE_SUCCESS;
+
+}
+
+void CFE_ES_PerfLogEntry(uint32 Marker) { (void)Marker; }
+void CFE_ES_PerfLogExit(uint32 Marker)  { (void)Marker; }
+
+CFE_SB_MsgId_t CFE_SB_ValueToMsgId(uint32 MsgIdValue)
+{
+   CFE_SB_MsgId_t MsgId = { MsgIdValue };
+   return MsgId;
+}
+
+uint32 CFE_SB_MsgIdToValue(CFE_SB_MsgId_t MsgId)
+{
+   return MsgId.Value;
+}
+
+bool CFE_SB_MsgId_Equal(CFE_SB_MsgId_t MsgId1, CFE_SB_MsgId_t MsgId2)
+{
+   return MsgId1.Value == MsgId2.Value;
+}
+
+bool CFE_SB_IsValidMsgId(CFE_SB_MsgId_t MsgId)
+{
+   return MsgId.Value != 0;
+}
+
+CFE_TIME_SysTime_t CFE_TIME_GetTime(void)
+{
+
+   int64 TimeUs = HostTimeUs();
+   CFE_TIME_SysTime_t Time;
+
+   Time.Seconds    = (uint32)(TimeUs / 1000000);
+   Time.Subseconds = (uint32)(((uint64)(TimeUs % 1000000) << 32) / 1000000);
+
+   return Time;
+
+}
+
+CFE_TIME_SysTime_t CFE_TIME_Subtract(CFE_TIME_SysTime_t Time1, CFE_TIME_SysTime_t Time2)
+{
+
+   CFE_TIME_SysTime_t Result;
+
+   Result.Subseconds = Time1.Subseconds - Time2.Subseconds;
+   Result.Seconds    = Time1.Seconds - Time2.Seconds - (Result.Subseconds > Time1.Subseconds ? 1 : 0);
+
+   return Result;
+
+}
+
+uint32 CFE_TIME_Sub2MicroSecs(uint32 SubSeconds)
+{
+   return (uint32)(((uint64)SubSeconds * 1000000) >> 32);
+}
+
+uint32 CFE_TIME_Micro2SubSecs(uint32 MicroSeconds)
+{
+   return (uint32)(((uint64)MicroSeconds << 32) / 1000000);
+}
+
+
+/*
+** PSP
+*/
+
+int32 CFE_PSP_MemSet(void *Dest, uint8 Value, uint32 Size)
+{
+   memset(Dest, Value, Size);
+   return CFE_SUCCESS;
+}
+
+int32 CFE_PSP_MemCpy(void *Dest, const void *Src, uint32 Size)
+{
+   memcpy(Dest, Src, Size);
+   return CFE_SUCCESS;
+}
+
+void CFE_PSP_GetTime(OS_time_t *LocalTime)
+{
+   LocalTime->ticks = HostTimeUs() * 10;
+}
+
+
+/*
+** OSAL
+*/
+
+void OS_GetLocalTime(OS_time_t *TimeStruct)
+{
+   TimeStruct->ticks = HostTimeUs() * 10;
+}
+
+int64 OS_TimeGetTotalMicroseconds(OS_time_t Tm)  { return Tm.ticks / 10; }
+int64 OS_TimeGetTotalMilliseconds(OS_time_t Tm)  { return Tm.ticks / 10000; }
+int64 OS_TimeGetTotalNanoseconds(OS_time_t Tm)   { return Tm.ticks * 100; }
+
+OS_time_t OS_TimeSubtract(OS_time_t Time1, OS_time_t Time2)
+{
+   OS_time_t Diff = { Time1.ticks - Time2.ticks };
+   return Diff;
+}
+
+int32 OS_TaskDelay(uint32 Milliseconds)
+{
+   usleep(Milliseconds * 1000);
+   return OS_SUCCESS;
+}
+
+bool OS_ObjectIdDefined(osal_id_t ObjId)                  { return ObjId != OS_OBJECT_ID_UNDEFINED; }
+bool OS_ObjectIdEqual(osal_id_t ObjId1, osal_id_t ObjId2) { return ObjId1 == ObjId2; }
+
+int32 OS_MutSemCreate(osal_id_t *SemId, const char *SemName, uint32 Options)
+{
+
+   (void)SemName;
+   (void)Options;
+
+   if (MutSemCnt >= UT_SEM_MAX)
+   {
+      return OS_ERROR;
+   }
+   pthread_mutex_init(&MutSem[MutSemCnt], NULL);
+   *SemId = ++MutSemCnt;
+
+   return OS_SUCCESS;
+
+}
+
+int32 OS_MutSemTake(osal_id_t SemId)
+{
+   return (SemId > 0 && SemId <= MutSemCnt && pthread_mutex_lock(&MutSem[SemId-1]) == 0) ? OS_SUCCESS : OS_ERROR;
+}
+
+int32 OS_MutSemGive(osal_id_t SemId)
+{
+   return (SemId > 0 && SemId <= MutSemCnt && pthread_mutex_unlock(&MutSem[SemId-1]) == 0) ? OS_SUCCESS : OS_ERROR;
+}
+
+int32 OS_CountSemCreate(osal_id_t *SemId, const char *SemName, uint32 InitialValue, uint32 Options)
+{
+
+   (void)SemName;
+   (void)Options;
+
+   if (CountSemCnt >= UT_SEM_MAX)
+   {
+      return OS_ERROR;
+   }
+   sem_init(&CountSem[CountSemCnt], 0, InitialValue);
+   *SemId = ++CountSemCnt;
+
+   return OS_SUCCESS;
+
+}
+
+int32 OS_CountSemTake(osal_id_t SemId)
+{
+   return (SemId > 0 && SemId <= CountSemCnt && sem_wait(&CountSem[SemId-1]) == 0) ? OS_SUCCESS : OS_ERROR;
+}
+
+int32 OS_CountSemGive(osal_id_t SemId)
+{
+   return (SemId > 0 && SemId <= CountSemCnt && sem_post(&CountSem[SemId-1]) == 0) ? OS_SUCCESS : OS_ERROR;
+}
+
+int32 OS_CountSemTimedWait(osal_id_t SemId, uint32 Msecs)
+{
+
+   struct timespec Deadline;
+
+   if (SemId == 0 || SemId > CountSemCnt)
+   {
+      return OS_ERROR;
+   }
+
+   clock_gettime(CLOCK_REALTIME, &Deadline);
+   Deadline.tv_sec  += Msecs / 1000;
+   Deadline.tv_nsec += (long)(Msecs % 1000) * 1000000;
+   if (Deadline.tv_nsec >= 1000000000)
+   {
+      Deadline.tv_sec++;
+      Deadline.tv_nsec -= 1000000000;
+   }
+
+   return (sem_timedwait(&CountSem[SemId-1], &Deadline) == 0) ? OS_SUCCESS : OS_ERROR_TIMEOUT;
+
+}
+
+
+/*
+** OSAL files use the host's file descriptors offset by one so zero stays
+** undefined
+*/
+
+int32 OS_OpenCreate(osal_id_t *FileDes, const char *Path, int32 Flags, int32 Access)
+{
+
+   int PosixFlags = (Access == OS_READ_ONLY) ? O_RDONLY : (Access == OS_WRITE_ONLY) ? O_WRONLY : O_RDWR;
+   int Fd;
+
+   if (Flags & OS_FILE_FLAG_CREATE)
+   {
+      PosixFlags |= O_CREAT;
+   }
+   if (Flags & OS_FILE_FLAG_TRUNCATE)
+   {
+      PosixFlags |= O_TRUNC;
+   }
+
+   Fd = open(Path, PosixFlags, 0644);
+   if (Fd < 0)
+   {
+      return OS_ERROR;
+   }
+   *FileDes = (osal_id_t)Fd + 1;
+
+   return OS_SUCCESS;
+
+}
+
+int32 OS_read(osal_id_t FileDes, void *Buffer, size_t NumBytes)
+{
+   return (int32)read((int)FileDes - 1, Buffer, NumBytes);
+}
+
+int32 OS_write(osal_id_t FileDes, const void *Buffer, size_t NumBytes)
+{
+   return (int32)write((int)FileDes - 1, Buffer, NumBytes);
+}
+
+int32 OS_close(osal_id_t FileDes)
+{
+   return (close((int)FileDes - 1) == 0) ? OS_SUCCESS : OS_ERROR;
+}
+
+/* OSAL sockets aren't simulated, tests use the native Linux sockets */
+
+int32 OS_SocketOpen(osal_id_t *SockId, int Domain, int Type)
+{
+   return OS_ERR_NOT_IMPLEMENTED;
+}
+
+int32 OS_SocketBind(osal_id_t SockId, const OS_SockAddr_t *Addr)
+{
+   return OS_ERR_NOT_IMPLEMENTED;
+}
+
+int32 OS_SocketAddrInit(OS_SockAddr_t *Addr, int Domain)
+{
+   memset(Addr, 0, sizeof(OS_SockAddr_t));
+   return OS_SUCCESS;
+}
+
+int32 OS_SocketAddrSetPort(OS_SockAddr_t *Addr, uint16 PortNum)
+{
+   memcpy(Addr->Data, &PortNum, sizeof(PortNum));
+   return OS_SUCCESS;
+}
+
+int32 OS_SocketAddrGetPort(uint16 *PortNum, const OS_SockAddr_t *Addr)
+{
+   memcpy(PortNum, Addr->Data, sizeof(*PortNum));
+   return OS_SUCCESS;
+}
+
+int32 OS_SocketAddrToString(char *Buffer, size_t BufLen, const OS_SockAddr_t *Addr)
+{
+   return OS_ERR_NOT_IMPLEMENTED;
+}
+
+int32 OS_SocketRecvFrom(osal_id_t SockId, void *Buffer, size_t BufLen, OS_SockAddr_t *RemoteAddr, int32 Timeout)
+{
+   return OS_ERR_NOT_IMPLEMENTED;
+}
+
+
+/*
+** app_c_fw
+*/
+
+bool CJSON_ProcessFile(const char *Filename, char *JsonBuf, size_t MaxJsonFileChar, bool (*LoadJsonData)(size_t JsonFileLen))
+{
+
+   FILE  *File = fopen(Filename, "r");
+   size_t Len;
+
+   if (File == NULL)
+   {
+      return false;
+   }
+   Len = fread(JsonBuf, 1, MaxJsonFileChar, File);
+   fclose(File);
+
+   if (Len == 0 || Len >= MaxJsonFileChar)
+   {
+      return false;
+   }
+   JsonBuf[Len] = '\0';
+
+   return LoadJsonData(Len);
+
+}
+
+uint32 INITBL_GetIntConfig(const INITBL_Class_t *IniTbl, int Param)
+{
+   (void)IniTbl;
+   return IniInt[Param];
+}
+
+const char *INITBL_GetStrConfig(const INITBL_Class_t *IniTbl, int Param)
+{
+   (void)IniTbl;
+   return (IniStr[Param] != NULL) ? IniStr[Param] : "";
+}